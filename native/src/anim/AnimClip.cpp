@@ -0,0 +1,315 @@
+#include "AnimClip.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace anim {
+
+namespace {
+
+constexpr float kQuatScale = 32767.0f;
+
+// ---- compression ----------------------------------------------------------
+
+void canonical(const float* q, float* out) {
+  float len = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  float s = (len > 0.0f ? 1.0f / len : 0.0f) * (q[3] < 0.0f ? -1.0f : 1.0f);
+  for (int k = 0; k < 4; ++k) out[k] = q[k] * s;
+  if (len == 0.0f) out[3] = 1.0f;
+}
+
+void nlerp(const float* a, const float* b, float t, float* out) {
+  float d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+  float sb = d < 0.0f ? -1.0f : 1.0f;
+  float len = 0.0f;
+  for (int k = 0; k < 4; ++k) {
+    out[k] = a[k] + (b[k] * sb - a[k]) * t;
+    len += out[k] * out[k];
+  }
+  len = std::sqrt(len);
+  for (int k = 0; k < 4; ++k) out[k] /= len;
+}
+
+// Angle of the rotation between a and b, from the vector part of
+// conj(a) * b; acos of their dot product is only good to ~1e-3 rad in float.
+float angleBetween(const float* a, const float* b) {
+  double x = (double)a[3] * b[0] - (double)b[3] * a[0] - ((double)a[1] * b[2] - (double)a[2] * b[1]);
+  double y = (double)a[3] * b[1] - (double)b[3] * a[1] - ((double)a[2] * b[0] - (double)a[0] * b[2]);
+  double z = (double)a[3] * b[2] - (double)b[3] * a[2] - ((double)a[0] * b[1] - (double)a[1] * b[0]);
+  return (float)(2.0 * std::asin(std::min(std::sqrt(x * x + y * y + z * z), 1.0)));
+}
+
+// Greedy key reduction: from each kept key, extend the segment as long as
+// every skipped frame stays within tolerance. error(a, b, f) measures frame
+// f against the interpolation of keys a and b.
+template <typename ErrorFn>
+std::vector<uint16_t> reduceKeys(uint32_t frameCount, float tolerance, ErrorFn error) {
+  bool constant = true;
+  for (uint32_t f = 1; f < frameCount && constant; ++f) constant = error(0, 0, f) <= tolerance;
+  if (constant) return { 0 };
+
+  std::vector<uint16_t> keys{ 0 };
+  uint32_t a = 0;
+  while (a < frameCount - 1) {
+    uint32_t b = a + 1;
+    while (b + 1 < frameCount) {
+      bool ok = true;
+      for (uint32_t f = a + 1; f <= b && ok; ++f) ok = error(a, b + 1, f) <= tolerance;
+      if (!ok) break;
+      ++b;
+    }
+    keys.push_back((uint16_t)b);
+    a = b;
+  }
+  return keys;
+}
+
+struct ChannelData {
+  ChannelHeader header;
+  std::vector<uint16_t> frames;
+  std::vector<uint16_t> values; // int16 rotations stored as their bit pattern
+};
+
+ChannelData compressRotation(const RawClip& raw, uint32_t joint, float tolerance) {
+  const uint32_t n = raw.frameCount;
+  std::vector<float> source(n * 4), decoded(n * 4);
+  std::vector<int16_t> quantized(n * 4);
+  for (uint32_t f = 0; f < n; ++f) {
+    canonical(raw.frames[f * raw.jointCount + joint].rotation, &source[f * 4]);
+    for (int k = 0; k < 4; ++k) {
+      quantized[f * 4 + k] = (int16_t)std::lrint(std::clamp(source[f * 4 + k], -1.0f, 1.0f) * kQuatScale);
+      decoded[f * 4 + k] = quantized[f * 4 + k] / kQuatScale;
+    }
+  }
+
+  ChannelData c;
+  c.frames = reduceKeys(n, tolerance, [&](uint32_t a, uint32_t b, uint32_t f) {
+    float q[4];
+    float t = b > a ? (float)(f - a) / (float)(b - a) : 0.0f;
+    nlerp(&decoded[a * 4], &decoded[b * 4], t, q);
+    return angleBetween(q, &source[f * 4]);
+  });
+  for (uint16_t f : c.frames) {
+    for (int k = 0; k < 4; ++k) c.values.push_back((uint16_t)quantized[f * 4 + k]);
+  }
+  return c;
+}
+
+ChannelData compressVector(const RawClip& raw, uint32_t joint, bool scale, float tolerance) {
+  const uint32_t n = raw.frameCount;
+  auto value = [&](uint32_t f) {
+    const Transform& t = raw.frames[f * raw.jointCount + joint];
+    return scale ? t.scale : t.translation;
+  };
+
+  ChannelData c;
+  float lo[3], hi[3];
+  for (int k = 0; k < 3; ++k) lo[k] = hi[k] = value(0)[k];
+  for (uint32_t f = 1; f < n; ++f) {
+    for (int k = 0; k < 3; ++k) {
+      lo[k] = std::min(lo[k], value(f)[k]);
+      hi[k] = std::max(hi[k], value(f)[k]);
+    }
+  }
+  for (int k = 0; k < 3; ++k) {
+    c.header.rangeMin[k] = lo[k];
+    c.header.rangeScale[k] = (hi[k] - lo[k]) / 65535.0f;
+  }
+
+  std::vector<uint16_t> quantized(n * 3);
+  std::vector<float> decoded(n * 3);
+  for (uint32_t f = 0; f < n; ++f) {
+    for (int k = 0; k < 3; ++k) {
+      float s = c.header.rangeScale[k];
+      uint16_t q = s > 0.0f ? (uint16_t)std::lrint(std::clamp((value(f)[k] - lo[k]) / s, 0.0f, 65535.0f)) : 0;
+      quantized[f * 3 + k] = q;
+      decoded[f * 3 + k] = lo[k] + q * s;
+    }
+  }
+
+  c.frames = reduceKeys(n, tolerance, [&](uint32_t a, uint32_t b, uint32_t f) {
+    float t = b > a ? (float)(f - a) / (float)(b - a) : 0.0f;
+    float err = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+      float v = decoded[a * 3 + k] + (decoded[b * 3 + k] - decoded[a * 3 + k]) * t;
+      err = std::max(err, std::fabs(v - value(f)[k]));
+    }
+    return err;
+  });
+  for (uint16_t f : c.frames) {
+    for (int k = 0; k < 3; ++k) c.values.push_back(quantized[f * 3 + k]);
+  }
+  return c;
+}
+
+// ---- sampling -------------------------------------------------------------
+
+// Keys around `frame` and the blend factor between them.
+float findKeys(const uint8_t* data, const ChannelHeader& c, float frame, uint32_t& a, uint32_t& b) {
+  if (c.keyCount == 1) {
+    a = b = 0;
+    return 0.0f;
+  }
+  const uint16_t* frames = reinterpret_cast<const uint16_t*>(data + c.framesOffset);
+  const uint16_t* next = std::upper_bound(frames + 1, frames + c.keyCount, frame,
+                                          [](float f, uint16_t key) { return f < (float)key; });
+  if (next == frames + c.keyCount) {
+    a = b = c.keyCount - 1;
+    return 0.0f;
+  }
+  b = (uint32_t)(next - frames);
+  a = b - 1;
+  return (frame - frames[a]) / (float)(frames[b] - frames[a]);
+}
+
+} // namespace
+
+std::vector<uint8_t> compressClip(const RawClip& raw, const CompressionSettings& settings) {
+  if (raw.frameCount == 0 || raw.frameCount > kMaxClipFrames || raw.jointCount == 0 ||
+      raw.jointCount > Skeleton::kMaxJoints || raw.frames.size() != (size_t)raw.frameCount * raw.jointCount ||
+      !(raw.frameRate > 0.0f)) {
+    return {};
+  }
+
+  std::vector<ChannelData> channels;
+  channels.reserve(raw.jointCount * 3);
+  for (uint32_t j = 0; j < raw.jointCount; ++j) {
+    channels.push_back(compressRotation(raw, j, settings.rotationTolerance));
+    channels.push_back(compressVector(raw, j, false, settings.translationTolerance));
+    channels.push_back(compressVector(raw, j, true, settings.scaleTolerance));
+  }
+
+  size_t offset = sizeof(ClipHeader) + sizeof(ChannelHeader) * channels.size();
+  for (ChannelData& c : channels) {
+    c.header.keyCount = (uint32_t)c.frames.size();
+    c.header.framesOffset = (uint32_t)offset;
+    offset += c.frames.size() * sizeof(uint16_t);
+    c.header.valuesOffset = (uint32_t)offset;
+    offset += c.values.size() * sizeof(uint16_t);
+  }
+
+  std::vector<uint8_t> out(offset);
+  ClipHeader header;
+  header.jointCount = raw.jointCount;
+  header.frameCount = raw.frameCount;
+  header.frameRate = raw.frameRate;
+  header.totalBytes = (uint32_t)offset;
+  std::memcpy(out.data(), &header, sizeof(header));
+  uint8_t* p = out.data() + sizeof(ClipHeader);
+  for (const ChannelData& c : channels) {
+    std::memcpy(p, &c.header, sizeof(ChannelHeader));
+    p += sizeof(ChannelHeader);
+  }
+  for (const ChannelData& c : channels) {
+    std::memcpy(out.data() + c.header.framesOffset, c.frames.data(), c.frames.size() * sizeof(uint16_t));
+    std::memcpy(out.data() + c.header.valuesOffset, c.values.data(), c.values.size() * sizeof(uint16_t));
+  }
+  return out;
+}
+
+bool Clip::init(const void* data, size_t size) {
+  m_header = nullptr;
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  const auto* header = static_cast<const ClipHeader*>(data);
+  if (size < sizeof(ClipHeader) || std::memcmp(header->magic, "BANM", 4) != 0 ||
+      header->version != kClipVersion || header->totalBytes != size || header->jointCount == 0 ||
+      header->jointCount > Skeleton::kMaxJoints || header->frameCount == 0 ||
+      header->frameCount > kMaxClipFrames || !(header->frameRate > 0.0f) ||
+      (reinterpret_cast<uintptr_t>(data) & 3) != 0) {
+    core::logError(core::LogCategory::Anim, "Clip: not a valid .banim");
+    return false;
+  }
+
+  const size_t channelCount = (size_t)header->jointCount * 3;
+  if (size < sizeof(ClipHeader) + sizeof(ChannelHeader) * channelCount) {
+    core::logError(core::LogCategory::Anim, "Clip: truncated channel table");
+    return false;
+  }
+  const auto* channels = reinterpret_cast<const ChannelHeader*>(bytes + sizeof(ClipHeader));
+  for (size_t i = 0; i < channelCount; ++i) {
+    const ChannelHeader& c = channels[i];
+    const size_t valueBytes = (i % 3 == 0 ? 8u : 6u) * (size_t)c.keyCount;
+    const bool ok = c.keyCount > 0 && c.keyCount <= header->frameCount && (c.framesOffset & 1) == 0 &&
+                    (c.valuesOffset & 1) == 0 && c.framesOffset + 2ull * c.keyCount <= size &&
+                    c.valuesOffset + valueBytes <= size;
+    if (!ok) {
+      core::logError(core::LogCategory::Anim, "Clip: channel %zu out of bounds", i);
+      return false;
+    }
+    // sample() interpolates between neighbouring keys: a repeated frame
+    // would divide by zero.
+    const uint16_t* frames = reinterpret_cast<const uint16_t*>(bytes + c.framesOffset);
+    bool ascending = frames[c.keyCount - 1] < header->frameCount;
+    for (uint32_t k = 1; k < c.keyCount && ascending; ++k) ascending = frames[k - 1] < frames[k];
+    if (!ascending) {
+      core::logError(core::LogCategory::Anim, "Clip: channel %zu keys are not strictly ascending", i);
+      return false;
+    }
+  }
+
+  m_data = bytes;
+  m_header = header;
+  m_channels = channels;
+  m_duration = (float)(header->frameCount - 1) / header->frameRate;
+  return true;
+}
+
+void Clip::sample(float time, SoaTransform* out, uint32_t groupCount, const SoaTransform* fallback) const {
+  const float frame = std::clamp(time * m_header->frameRate, 0.0f, (float)(m_header->frameCount - 1));
+  const uint32_t joints = m_header->jointCount;
+
+  for (uint32_t g = 0; g < groupCount; ++g) {
+    // Both ends of every lane's interpolation, SoA; lanes without a channel
+    // keep the fallback with weight 0.
+    alignas(16) float qa[4][4], qb[4][4], ta[3][4], tb[3][4], sa[3][4], sb[3][4];
+    alignas(16) float rt[4] = { 0, 0, 0, 0 }, tt[4] = { 0, 0, 0, 0 }, st[4] = { 0, 0, 0, 0 };
+    const SoaTransform& f = fallback[g];
+    _mm_store_ps(qa[0], f.rotation.x); _mm_store_ps(qa[1], f.rotation.y);
+    _mm_store_ps(qa[2], f.rotation.z); _mm_store_ps(qa[3], f.rotation.w);
+    _mm_store_ps(ta[0], f.translation.x); _mm_store_ps(ta[1], f.translation.y); _mm_store_ps(ta[2], f.translation.z);
+    _mm_store_ps(sa[0], f.scale.x); _mm_store_ps(sa[1], f.scale.y); _mm_store_ps(sa[2], f.scale.z);
+    std::memcpy(qb, qa, sizeof(qa));
+    std::memcpy(tb, ta, sizeof(ta));
+    std::memcpy(sb, sa, sizeof(sa));
+
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+      const uint32_t j = g * 4 + lane;
+      if (j >= joints) break;
+      const ChannelHeader* c = m_channels + j * 3;
+      uint32_t a, b;
+
+      rt[lane] = findKeys(m_data, c[0], frame, a, b);
+      const auto* q = reinterpret_cast<const int16_t*>(m_data + c[0].valuesOffset);
+      for (int k = 0; k < 4; ++k) {
+        qa[k][lane] = q[a * 4 + k] * (1.0f / kQuatScale);
+        qb[k][lane] = q[b * 4 + k] * (1.0f / kQuatScale);
+      }
+
+      float* dstA[2][3] = { { &ta[0][lane], &ta[1][lane], &ta[2][lane] }, { &sa[0][lane], &sa[1][lane], &sa[2][lane] } };
+      float* dstB[2][3] = { { &tb[0][lane], &tb[1][lane], &tb[2][lane] }, { &sb[0][lane], &sb[1][lane], &sb[2][lane] } };
+      float* alpha[2] = { &tt[lane], &st[lane] };
+      for (int v = 0; v < 2; ++v) {
+        const ChannelHeader& ch = c[1 + v];
+        *alpha[v] = findKeys(m_data, ch, frame, a, b);
+        const auto* values = reinterpret_cast<const uint16_t*>(m_data + ch.valuesOffset);
+        for (int k = 0; k < 3; ++k) {
+          *dstA[v][k] = ch.rangeMin[k] + values[a * 3 + k] * ch.rangeScale[k];
+          *dstB[v][k] = ch.rangeMin[k] + values[b * 3 + k] * ch.rangeScale[k];
+        }
+      }
+    }
+
+    SoaTransform& o = out[g];
+    o.rotation = nlerp({ _mm_load_ps(qa[0]), _mm_load_ps(qa[1]), _mm_load_ps(qa[2]), _mm_load_ps(qa[3]) },
+                       { _mm_load_ps(qb[0]), _mm_load_ps(qb[1]), _mm_load_ps(qb[2]), _mm_load_ps(qb[3]) },
+                       _mm_load_ps(rt));
+    o.translation = lerp({ _mm_load_ps(ta[0]), _mm_load_ps(ta[1]), _mm_load_ps(ta[2]) },
+                         { _mm_load_ps(tb[0]), _mm_load_ps(tb[1]), _mm_load_ps(tb[2]) }, _mm_load_ps(tt));
+    o.scale = lerp({ _mm_load_ps(sa[0]), _mm_load_ps(sa[1]), _mm_load_ps(sa[2]) },
+                   { _mm_load_ps(sb[0]), _mm_load_ps(sb[1]), _mm_load_ps(sb[2]) }, _mm_load_ps(st));
+  }
+}
+
+} // namespace anim
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AnimFormat.h"
+#include "Skeleton.h"
+
+namespace anim {
+
+/// Uncompressed clip as an exporter or importer produces it: every joint's
+/// local transform at every source frame.
+struct RawClip {
+  float frameRate = 30.0f;
+  uint32_t frameCount = 0;
+  uint32_t jointCount = 0;
+  std::vector<Transform> frames; // [frame * jointCount + joint]
+};
+
+/// How far the decompressed clip may stray from the source. Keys are
+/// dropped while interpolating their neighbours stays within these.
+struct CompressionSettings {
+  float rotationTolerance = 0.001f;    // radians
+  float translationTolerance = 0.0005f; // world units
+  float scaleTolerance = 0.0005f;
+};
+
+/// Quantizes and key-reduces `raw` into the .banim layout (AnimFormat.h).
+/// Empty if raw is malformed or longer than kMaxClipFrames.
+std::vector<uint8_t> compressClip(const RawClip& raw, const CompressionSettings& settings = CompressionSettings{});
+
+/// Read-only view of a compressed clip; the bytes are used in place and
+/// must outlive the Clip. Sampling is thread safe.
+class Clip {
+public:
+  /// False if the data is not a valid .banim.
+  bool init(const void* data, size_t size);
+
+  uint32_t jointCount() const { return m_header ? m_header->jointCount : 0; }
+  float duration() const { return m_duration; }
+
+  /// Local pose at `time` seconds (clamped to the clip) for `groupCount`
+  /// groups of four joints. Joints the clip has no channels for are copied
+  /// from `fallback` (usually the bind pose).
+  void sample(float time, SoaTransform* out, uint32_t groupCount, const SoaTransform* fallback) const;
+
+private:
+  const uint8_t* m_data = nullptr;
+  const ClipHeader* m_header = nullptr;
+  const ChannelHeader* m_channels = nullptr;
+  float m_duration = 0.0f;
+};
+
+} // namespace anim
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+namespace anim {
+
+/// Compressed animation clip (.banim), written by compressClip() in
+/// AnimClip.h. Little endian, used in place:
+///
+///   ClipHeader
+///   ChannelHeader[jointCount * 3]   rotation, translation, scale per joint
+///   uint16 frames[]                 per channel, at ChannelHeader::framesOffset
+///   key values                      per channel, at ChannelHeader::valuesOffset
+///
+/// Every channel keeps only the frames that linear interpolation cannot
+/// reproduce within the compression tolerance; frames are ascending source
+/// frame numbers, the first is always 0 and the last frameCount - 1 (a
+/// channel with a single key is constant). Values are quantized:
+///
+///   rotation     int16 x, y, z, w  unit quaternion * 32767, w >= 0
+///   translation  uint16 x, y, z    rangeMin + q * rangeScale per axis
+///   scale        uint16 x, y, z    same
+///
+/// Offsets are in bytes from the start of the clip and 2-byte aligned.
+struct ClipHeader {
+  char magic[4] = { 'B', 'A', 'N', 'M' };
+  uint32_t version = 1;
+  uint32_t jointCount = 0;
+  uint32_t frameCount = 0;  // source frames, >= 1
+  float frameRate = 30.0f;  // source frames per second
+  uint32_t totalBytes = 0;  // whole clip, for validation
+  uint32_t reserved[2] = { 0, 0 };
+};
+static_assert(sizeof(ClipHeader) == 32, "ClipHeader is an on-disk layout");
+
+enum class Channel : uint32_t { Rotation = 0, Translation = 1, Scale = 2 };
+
+struct ChannelHeader {
+  uint32_t keyCount = 0;
+  uint32_t framesOffset = 0;
+  uint32_t valuesOffset = 0;
+  float rangeMin[3] = { 0, 0, 0 };   // translation/scale only
+  float rangeScale[3] = { 0, 0, 0 }; // (max - min) / 65535
+  uint32_t pad = 0;
+};
+static_assert(sizeof(ChannelHeader) == 40, "ChannelHeader is an on-disk layout");
+
+constexpr uint32_t kClipVersion = 1;
+constexpr uint32_t kMaxClipFrames = 65536;
+
+} // namespace anim
@@ -0,0 +1,203 @@
+#include "AnimationSystem.h"
+#include "../core/JobSystem.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace anim {
+
+namespace {
+
+Affine fromMat4(const render::Mat4& m) {
+  Affine a;
+  for (int i = 0; i < 3; ++i) a.rows[i] = _mm_setr_ps(m.at(i, 0), m.at(i, 1), m.at(i, 2), m.at(i, 3));
+  return a;
+}
+
+} // namespace
+
+void AnimationSystem::init(const render::GpuContext& gpu, uint32_t framesInFlight, core::JobSystem& jobs,
+                           uint32_t paletteCapacity) {
+  m_gpu = &gpu;
+  m_jobs = &jobs;
+  m_paletteCapacity = paletteCapacity;
+
+  const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  m_frames.resize(framesInFlight);
+  for (Frame& f : m_frames) {
+    f.palette = render::createBuffer(gpu, (VkDeviceSize)kPaletteStride * paletteCapacity,
+                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, host);
+  }
+  core::logInfo(core::LogCategory::Anim, "Animation: %u palette matrices per frame (%u KB)", paletteCapacity,
+                kPaletteStride * paletteCapacity / 1024);
+}
+
+void AnimationSystem::shutdown() {
+  if (!m_gpu) return;
+  for (Frame& f : m_frames) render::destroyBuffer(*m_gpu, f.palette);
+  m_frames.clear();
+  m_characters.clear();
+  m_freeCharacters.clear();
+  m_active.clear();
+  m_characterCount = 0;
+  m_gpu = nullptr;
+  m_jobs = nullptr;
+}
+
+CharacterId AnimationSystem::createCharacter(const Skeleton& skeleton) {
+  CharacterId id;
+  if (!m_freeCharacters.empty()) {
+    id = m_freeCharacters.back();
+    m_freeCharacters.pop_back();
+  } else {
+    id = (CharacterId)m_characters.size();
+    m_characters.emplace_back();
+  }
+  Character& c = m_characters[id];
+  c.skeleton = &skeleton;
+  for (Layer& l : c.layers) l = Layer{};
+  c.world = fromMat4(render::Mat4{});
+  c.paletteOffset = UINT32_MAX;
+  c.alive = true;
+  c.pose.resize(skeleton.groupCount());
+  c.sampled.resize(skeleton.groupCount());
+  c.model.resize(skeleton.jointCount());
+  ++m_characterCount;
+  return id;
+}
+
+void AnimationSystem::destroyCharacter(CharacterId id) {
+  if (id >= m_characters.size() || !m_characters[id].alive) return;
+  m_characters[id].alive = false;
+  m_characters[id].skeleton = nullptr;
+  m_freeCharacters.push_back(id);
+  --m_characterCount;
+}
+
+void AnimationSystem::setTransform(CharacterId id, const render::Mat4& world) {
+  m_characters[id].world = fromMat4(world);
+}
+
+void AnimationSystem::play(CharacterId id, uint32_t layer, const Clip* clip, float weight, float speed, bool loop) {
+  if (layer >= kMaxLayers) return;
+  Layer& l = m_characters[id].layers[layer];
+  l.clip = clip;
+  l.time = 0.0f;
+  l.weight = weight;
+  l.speed = speed;
+  l.loop = loop;
+}
+
+void AnimationSystem::setWeight(CharacterId id, uint32_t layer, float weight) {
+  if (layer < kMaxLayers) m_characters[id].layers[layer].weight = weight;
+}
+
+void AnimationSystem::animate(Character& c, float dt, uint8_t* palette) {
+  const Skeleton& skeleton = *c.skeleton;
+  const uint32_t groups = skeleton.groupCount();
+  const SoaTransform* bind = skeleton.bindPose();
+
+  // ---- sample + blend ----
+  const __m128 zero = _mm_setzero_ps();
+  for (uint32_t g = 0; g < groups; ++g) c.pose[g] = { { zero, zero, zero, zero }, { zero, zero, zero }, { zero, zero, zero } };
+
+  float total = 0.0f;
+  for (Layer& l : c.layers) {
+    if (!l.clip) continue;
+    const float duration = l.clip->duration();
+    l.time += dt * l.speed;
+    if (l.loop && duration > 0.0f) {
+      l.time = std::fmod(l.time, duration);
+      if (l.time < 0.0f) l.time += duration;
+    } else {
+      l.time = std::clamp(l.time, 0.0f, duration);
+    }
+    if (l.weight <= 0.0f) continue;
+
+    l.clip->sample(l.time, c.sampled.data(), groups, bind);
+    const __m128 w = splat(l.weight);
+    for (uint32_t g = 0; g < groups; ++g) {
+      SoaTransform& p = c.pose[g];
+      const SoaTransform& s = c.sampled[g];
+      p.rotation = madd(p.rotation, s.rotation, w);
+      p.translation = madd(p.translation, s.translation, w);
+      p.scale = madd(p.scale, s.scale, w);
+    }
+    total += l.weight;
+  }
+
+  if (total < 1.0f) {
+    const __m128 w = splat(1.0f - total);
+    for (uint32_t g = 0; g < groups; ++g) {
+      SoaTransform& p = c.pose[g];
+      p.rotation = madd(p.rotation, bind[g].rotation, w);
+      p.translation = madd(p.translation, bind[g].translation, w);
+      p.scale = madd(p.scale, bind[g].scale, w);
+    }
+    total = 1.0f;
+  }
+  const __m128 invTotal = splat(1.0f / total);
+  for (uint32_t g = 0; g < groups; ++g) {
+    SoaTransform& p = c.pose[g];
+    p.rotation = normalize(p.rotation);
+    p.translation = scale(p.translation, invTotal);
+    p.scale = scale(p.scale, invTotal);
+  }
+
+  // ---- model space + palette ----
+  const uint32_t joints = skeleton.jointCount();
+  const int16_t* parents = skeleton.parents();
+  const Affine* inverseBind = skeleton.inverseBind();
+  float* out = reinterpret_cast<float*>(palette + (size_t)c.paletteOffset * kPaletteStride);
+  for (uint32_t g = 0; g < groups; ++g) {
+    Affine local[4];
+    toAffine(c.pose[g], local);
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+      const uint32_t j = g * 4 + lane;
+      if (j >= joints) break;
+      c.model[j] = mul(parents[j] < 0 ? c.world : c.model[parents[j]], local[lane]);
+      const Affine skin = mul(c.model[j], inverseBind[j]);
+      _mm_storeu_ps(out + j * 12 + 0, skin.rows[0]);
+      _mm_storeu_ps(out + j * 12 + 4, skin.rows[1]);
+      _mm_storeu_ps(out + j * 12 + 8, skin.rows[2]);
+    }
+  }
+}
+
+void AnimationSystem::update(uint32_t frameIndex, float dt) {
+  if (!m_gpu) return;
+  const auto t0 = std::chrono::steady_clock::now();
+
+  // Palettes back to back in character order; what does not fit is skipped
+  // (and not advanced) this frame.
+  m_active.clear();
+  uint32_t used = 0;
+  for (CharacterId id = 0; id < (CharacterId)m_characters.size(); ++id) {
+    Character& c = m_characters[id];
+    if (!c.alive) continue;
+    const uint32_t joints = c.skeleton->jointCount();
+    if (used + joints > m_paletteCapacity) {
+      c.paletteOffset = UINT32_MAX;
+      if (!m_warnedFull) {
+        core::logWarn(core::LogCategory::Anim, "Animation: palette buffer full (%u matrices), characters skipped",
+                      m_paletteCapacity);
+        m_warnedFull = true;
+      }
+      continue;
+    }
+    c.paletteOffset = used;
+    used += joints;
+    m_active.push_back(id);
+  }
+
+  uint8_t* palette = static_cast<uint8_t*>(m_frames[frameIndex].palette.mapped);
+  m_jobs->parallelFor((uint32_t)m_active.size(), 8, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) animate(m_characters[m_active[i]], dt, palette);
+  });
+
+  m_lastUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace anim
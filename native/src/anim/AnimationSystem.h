@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "../render/RenderMath.h"
+#include "../render/VkUtil.h"
+#include "AnimClip.h"
+#include "Skeleton.h"
+
+namespace core { class JobSystem; }
+
+namespace anim {
+
+using CharacterId = uint32_t;
+constexpr CharacterId kInvalidCharacter = UINT32_MAX;
+
+/// Skeletal animation for every character in the scene.
+///
+/// Each character blends up to kMaxLayers clips. update() runs one job per
+/// batch of characters on the job system; per character it
+///
+///   samples     every playing clip into an SoA pose (four joints per SSE
+///               register), straight from the compressed keys
+///   blends      weighted, hemisphere-aligned quaternion sum plus weighted
+///               translation/scale; weight below 1 is filled with the
+///               bind pose
+///   skins       local -> model in hierarchy order, times the inverse bind
+///               matrix and the character's world transform, stored as
+///               3x4 rows directly into this frame's palette buffer
+///
+/// Palettes are packed back to back every frame; a skinned draw reads
+/// paletteOffset() and jointCount() matrices from paletteBuffer(). The
+/// buffer is host visible and written once per frame, never read back.
+///
+/// Not thread safe: call everything from the main thread.
+class AnimationSystem {
+public:
+  static constexpr uint32_t kMaxLayers = 4;
+  static constexpr uint32_t kDefaultPaletteCapacity = 16384; // matrices per frame
+  static constexpr uint32_t kPaletteStride = 48;              // bytes per matrix
+
+  void init(const render::GpuContext& gpu, uint32_t framesInFlight, core::JobSystem& jobs,
+            uint32_t paletteCapacity = kDefaultPaletteCapacity);
+  void shutdown();
+
+  /// The skeleton must outlive the character.
+  CharacterId createCharacter(const Skeleton& skeleton);
+  void destroyCharacter(CharacterId id);
+  void setTransform(CharacterId id, const render::Mat4& world);
+
+  /// Starts `clip` on `layer` from its beginning, replacing what played
+  /// there. The clip must outlive its use; null stops the layer.
+  void play(CharacterId id, uint32_t layer, const Clip* clip, float weight = 1.0f, float speed = 1.0f,
+            bool loop = true);
+  void setWeight(CharacterId id, uint32_t layer, float weight);
+
+  /// Advances every character by dt and writes its palette into this
+  /// frame's buffer. Call after the frame's fence wait.
+  void update(uint32_t frameIndex, float dt);
+
+  const render::GpuBuffer& paletteBuffer(uint32_t frameIndex) const { return m_frames[frameIndex].palette; }
+  /// First palette matrix of the character in the last update(); UINT32_MAX
+  /// if it did not fit.
+  uint32_t paletteOffset(CharacterId id) const { return m_characters[id].paletteOffset; }
+  uint32_t jointCount(CharacterId id) const { return m_characters[id].skeleton->jointCount(); }
+
+  uint32_t characterCount() const { return m_characterCount; }
+  double lastUpdateMs() const { return m_lastUpdateMs; }
+
+private:
+  struct Layer {
+    const Clip* clip = nullptr;
+    float time = 0.0f;
+    float weight = 0.0f;
+    float speed = 1.0f;
+    bool loop = true;
+  };
+
+  struct Character {
+    const Skeleton* skeleton = nullptr;
+    Layer layers[kMaxLayers];
+    Affine world;
+    uint32_t paletteOffset = UINT32_MAX;
+    bool alive = false;
+    // Scratch owned by the character so jobs never share it.
+    memory::TrackedVector<SoaTransform, memory::MemTag::Animation> pose, sampled;
+    memory::TrackedVector<Affine, memory::MemTag::Animation> model;
+  };
+
+  struct Frame {
+    render::GpuBuffer palette; // kPaletteStride * capacity, host visible
+  };
+
+  void animate(Character& c, float dt, uint8_t* palette);
+
+  const render::GpuContext* m_gpu = nullptr;
+  core::JobSystem* m_jobs = nullptr;
+  std::vector<Frame> m_frames;
+  uint32_t m_paletteCapacity = 0;
+
+  memory::TrackedVector<Character, memory::MemTag::Animation> m_characters;
+  memory::TrackedVector<CharacterId, memory::MemTag::Animation> m_freeCharacters;
+  memory::TrackedVector<CharacterId, memory::MemTag::Animation> m_active; // this update, in palette order
+  uint32_t m_characterCount = 0;
+  bool m_warnedFull = false;
+  double m_lastUpdateMs = 0.0;
+};
+
+} // namespace anim
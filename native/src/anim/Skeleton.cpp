@@ -0,0 +1,91 @@
+#include "Skeleton.h"
+#include "../core/Log.h"
+
+#include <cmath>
+
+namespace anim {
+
+namespace {
+
+// Inverse of a 3x4 affine (rotation, translation and scale, possibly
+// non-uniform); identity if singular.
+Affine inverse(const Affine& a) {
+  float m[3][4];
+  for (int i = 0; i < 3; ++i) _mm_storeu_ps(m[i], a.rows[i]);
+
+  float c[3][3] = {
+    { m[1][1] * m[2][2] - m[1][2] * m[2][1], m[0][2] * m[2][1] - m[0][1] * m[2][2], m[0][1] * m[1][2] - m[0][2] * m[1][1] },
+    { m[1][2] * m[2][0] - m[1][0] * m[2][2], m[0][0] * m[2][2] - m[0][2] * m[2][0], m[0][2] * m[1][0] - m[0][0] * m[1][2] },
+    { m[1][0] * m[2][1] - m[1][1] * m[2][0], m[0][1] * m[2][0] - m[0][0] * m[2][1], m[0][0] * m[1][1] - m[0][1] * m[1][0] },
+  };
+  float det = m[0][0] * c[0][0] + m[0][1] * c[1][0] + m[0][2] * c[2][0];
+  Affine r;
+  if (std::fabs(det) < 1e-20f) {
+    r.rows[0] = _mm_setr_ps(1, 0, 0, 0);
+    r.rows[1] = _mm_setr_ps(0, 1, 0, 0);
+    r.rows[2] = _mm_setr_ps(0, 0, 1, 0);
+    return r;
+  }
+  float inv = 1.0f / det;
+  for (int i = 0; i < 3; ++i) {
+    float r0 = c[i][0] * inv, r1 = c[i][1] * inv, r2 = c[i][2] * inv;
+    float t = -(r0 * m[0][3] + r1 * m[1][3] + r2 * m[2][3]);
+    r.rows[i] = _mm_setr_ps(r0, r1, r2, t);
+  }
+  return r;
+}
+
+} // namespace
+
+void packSoa(const Transform* transforms, uint32_t count, SoaTransform* out) {
+  const Transform identity{};
+  for (uint32_t g = 0; g * 4 < count; ++g) {
+    float v[10][4];
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+      const uint32_t j = g * 4 + lane;
+      const Transform& t = j < count ? transforms[j] : identity;
+      for (int k = 0; k < 4; ++k) v[k][lane] = t.rotation[k];
+      for (int k = 0; k < 3; ++k) v[4 + k][lane] = t.translation[k];
+      for (int k = 0; k < 3; ++k) v[7 + k][lane] = t.scale[k];
+    }
+    SoaTransform& s = out[g];
+    s.rotation = { _mm_loadu_ps(v[0]), _mm_loadu_ps(v[1]), _mm_loadu_ps(v[2]), _mm_loadu_ps(v[3]) };
+    s.translation = { _mm_loadu_ps(v[4]), _mm_loadu_ps(v[5]), _mm_loadu_ps(v[6]) };
+    s.scale = { _mm_loadu_ps(v[7]), _mm_loadu_ps(v[8]), _mm_loadu_ps(v[9]) };
+  }
+}
+
+bool Skeleton::init(const std::vector<int16_t>& parents, const std::vector<Transform>& bindPose) {
+  const uint32_t count = (uint32_t)parents.size();
+  if (count == 0 || count > kMaxJoints || bindPose.size() != count) {
+    core::logError(core::LogCategory::Anim, "Skeleton: %u joints, %zu bind transforms (1..%u joints)", count,
+                   bindPose.size(), kMaxJoints);
+    return false;
+  }
+  for (uint32_t j = 0; j < count; ++j) {
+    if (parents[j] >= (int)j || parents[j] < -1) {
+      core::logError(core::LogCategory::Anim, "Skeleton: joint %u has parent %d, parents must come first", j,
+                     parents[j]);
+      return false;
+    }
+  }
+
+  m_parents.assign(parents.begin(), parents.end());
+  m_bindPose.resize((count + 3) / 4);
+  packSoa(bindPose.data(), count, m_bindPose.data());
+
+  std::vector<Affine> model(count);
+  m_inverseBind.resize(count);
+  for (uint32_t g = 0; g < m_bindPose.size(); ++g) {
+    Affine local[4];
+    toAffine(m_bindPose[g], local);
+    for (uint32_t lane = 0; lane < 4 && g * 4 + lane < count; ++lane) {
+      const uint32_t j = g * 4 + lane;
+      model[j] = parents[j] < 0 ? local[lane] : mul(model[parents[j]], local[lane]);
+      m_inverseBind[j] = inverse(model[j]);
+    }
+  }
+  return true;
+}
+
+} // namespace anim
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "SoaMath.h"
+
+namespace anim {
+
+/// One joint's local transform, AoS; the input side of skeletons and clips.
+struct Transform {
+  float rotation[4] = { 0, 0, 0, 1 }; // unit quaternion x, y, z, w
+  float translation[3] = { 0, 0, 0 };
+  float scale[3] = { 1, 1, 1 };
+};
+
+/// Joint hierarchy plus bind pose. Joints are ordered so that every parent
+/// comes before its children, which lets a pose be turned into model space
+/// in one forward pass.
+class Skeleton {
+public:
+  static constexpr uint32_t kMaxJoints = 256;
+
+  /// parents[i] < i, or -1 for a root. False (nothing kept) if the order or
+  /// the joint count is wrong.
+  bool init(const std::vector<int16_t>& parents, const std::vector<Transform>& bindPose);
+
+  uint32_t jointCount() const { return (uint32_t)m_parents.size(); }
+  uint32_t groupCount() const { return (uint32_t)m_bindPose.size(); }
+  const int16_t* parents() const { return m_parents.data(); }
+  /// groupCount() entries; padding lanes are identity.
+  const SoaTransform* bindPose() const { return m_bindPose.data(); }
+  /// Model space to joint space, per joint.
+  const Affine* inverseBind() const { return m_inverseBind.data(); }
+
+private:
+  memory::TrackedVector<int16_t, memory::MemTag::Animation> m_parents;
+  memory::TrackedVector<SoaTransform, memory::MemTag::Animation> m_bindPose;
+  memory::TrackedVector<Affine, memory::MemTag::Animation> m_inverseBind;
+};
+
+/// Packs AoS transforms into SoA groups of four; lanes past `count` are
+/// identity.
+void packSoa(const Transform* transforms, uint32_t count, SoaTransform* out);
+
+} // namespace anim
@@ -0,0 +1,118 @@
+#pragma once
+#include <emmintrin.h>
+
+namespace anim {
+
+/// Four joints per register: lane i of every member belongs to joint i of
+/// the group. Poses are arrays of these, so sampling, blending and the
+/// quaternion-to-matrix step run four joints per instruction.
+struct SoaFloat3 {
+  __m128 x, y, z;
+};
+
+struct SoaQuat {
+  __m128 x, y, z, w;
+};
+
+struct SoaTransform {
+  SoaQuat rotation;
+  SoaFloat3 translation;
+  SoaFloat3 scale;
+};
+
+/// Affine 3x4, row-major: rows[i] = (m[i][0], m[i][1], m[i][2], t[i]). The
+/// implicit fourth row is (0, 0, 0, 1). Same layout as a skinning matrix in
+/// the palette buffer.
+struct alignas(16) Affine {
+  __m128 rows[3];
+};
+
+inline __m128 splat(float v) { return _mm_set1_ps(v); }
+
+inline SoaFloat3 lerp(const SoaFloat3& a, const SoaFloat3& b, __m128 t) {
+  return { _mm_add_ps(a.x, _mm_mul_ps(_mm_sub_ps(b.x, a.x), t)),
+           _mm_add_ps(a.y, _mm_mul_ps(_mm_sub_ps(b.y, a.y), t)),
+           _mm_add_ps(a.z, _mm_mul_ps(_mm_sub_ps(b.z, a.z), t)) };
+}
+
+inline SoaFloat3 madd(const SoaFloat3& acc, const SoaFloat3& v, __m128 w) {
+  return { _mm_add_ps(acc.x, _mm_mul_ps(v.x, w)), _mm_add_ps(acc.y, _mm_mul_ps(v.y, w)),
+           _mm_add_ps(acc.z, _mm_mul_ps(v.z, w)) };
+}
+
+inline SoaFloat3 scale(const SoaFloat3& v, __m128 s) {
+  return { _mm_mul_ps(v.x, s), _mm_mul_ps(v.y, s), _mm_mul_ps(v.z, s) };
+}
+
+inline __m128 dot(const SoaQuat& a, const SoaQuat& b) {
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)),
+                    _mm_add_ps(_mm_mul_ps(a.z, b.z), _mm_mul_ps(a.w, b.w)));
+}
+
+/// b negated in the lanes where it lies in the other hemisphere from a, so
+/// adding or interpolating takes the short way round.
+inline SoaQuat alignTo(const SoaQuat& a, const SoaQuat& b) {
+  const __m128 sign = _mm_and_ps(dot(a, b), _mm_set1_ps(-0.0f));
+  return { _mm_xor_ps(b.x, sign), _mm_xor_ps(b.y, sign), _mm_xor_ps(b.z, sign), _mm_xor_ps(b.w, sign) };
+}
+
+inline SoaQuat normalize(const SoaQuat& q) {
+  const __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(dot(q, q)));
+  return { _mm_mul_ps(q.x, inv), _mm_mul_ps(q.y, inv), _mm_mul_ps(q.z, inv), _mm_mul_ps(q.w, inv) };
+}
+
+/// Normalized lerp; within the few degrees between neighbouring keys it is
+/// indistinguishable from slerp.
+inline SoaQuat nlerp(const SoaQuat& a, const SoaQuat& b, __m128 t) {
+  const SoaQuat c = alignTo(a, b);
+  return normalize({ _mm_add_ps(a.x, _mm_mul_ps(_mm_sub_ps(c.x, a.x), t)),
+                     _mm_add_ps(a.y, _mm_mul_ps(_mm_sub_ps(c.y, a.y), t)),
+                     _mm_add_ps(a.z, _mm_mul_ps(_mm_sub_ps(c.z, a.z), t)),
+                     _mm_add_ps(a.w, _mm_mul_ps(_mm_sub_ps(c.w, a.w), t)) });
+}
+
+/// acc + b * w with b aligned to acc; normalize once all layers are in.
+inline SoaQuat madd(const SoaQuat& acc, const SoaQuat& b, __m128 w) {
+  const SoaQuat c = alignTo(acc, b);
+  return { _mm_add_ps(acc.x, _mm_mul_ps(c.x, w)), _mm_add_ps(acc.y, _mm_mul_ps(c.y, w)),
+           _mm_add_ps(acc.z, _mm_mul_ps(c.z, w)), _mm_add_ps(acc.w, _mm_mul_ps(c.w, w)) };
+}
+
+/// T * R * S of the four lanes as four affine matrices.
+inline void toAffine(const SoaTransform& t, Affine out[4]) {
+  const SoaQuat& q = t.rotation;
+  const __m128 two = _mm_set1_ps(2.0f), one = _mm_set1_ps(1.0f);
+  const __m128 x2 = _mm_mul_ps(q.x, two), y2 = _mm_mul_ps(q.y, two), z2 = _mm_mul_ps(q.z, two);
+  const __m128 xx = _mm_mul_ps(q.x, x2), yy = _mm_mul_ps(q.y, y2), zz = _mm_mul_ps(q.z, z2);
+  const __m128 xy = _mm_mul_ps(q.x, y2), xz = _mm_mul_ps(q.x, z2), yz = _mm_mul_ps(q.y, z2);
+  const __m128 wx = _mm_mul_ps(q.w, x2), wy = _mm_mul_ps(q.w, y2), wz = _mm_mul_ps(q.w, z2);
+
+  __m128 r0[4] = { _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), t.scale.x),
+                   _mm_mul_ps(_mm_sub_ps(xy, wz), t.scale.y), _mm_mul_ps(_mm_add_ps(xz, wy), t.scale.z),
+                   t.translation.x };
+  __m128 r1[4] = { _mm_mul_ps(_mm_add_ps(xy, wz), t.scale.x),
+                   _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), t.scale.y),
+                   _mm_mul_ps(_mm_sub_ps(yz, wx), t.scale.z), t.translation.y };
+  __m128 r2[4] = { _mm_mul_ps(_mm_sub_ps(xz, wy), t.scale.x), _mm_mul_ps(_mm_add_ps(yz, wx), t.scale.y),
+                   _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), t.scale.z), t.translation.z };
+  _MM_TRANSPOSE4_PS(r0[0], r0[1], r0[2], r0[3]);
+  _MM_TRANSPOSE4_PS(r1[0], r1[1], r1[2], r1[3]);
+  _MM_TRANSPOSE4_PS(r2[0], r2[1], r2[2], r2[3]);
+  for (int i = 0; i < 4; ++i) out[i] = { { r0[i], r1[i], r2[i] } };
+}
+
+/// a * b.
+inline Affine mul(const Affine& a, const Affine& b) {
+  const __m128 wMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+  Affine r;
+  for (int i = 0; i < 3; ++i) {
+    const __m128 row = a.rows[i];
+    __m128 v = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b.rows[0]);
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b.rows[1]));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b.rows[2]));
+    r.rows[i] = _mm_add_ps(v, _mm_and_ps(row, wMask));
+  }
+  return r;
+}
+
+} // namespace anim
@@ -0,0 +1,249 @@
+#include "AudioBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+namespace audio {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void toPcm16(const float* in, int16_t* out, size_t count) {
+  for (size_t i = 0; i < count; ++i) out[i] = (int16_t)std::lrint(std::clamp(in[i], -1.0f, 1.0f) * 32767.0f);
+}
+
+/// Sleeps until each block is due, as a device consuming samples would.
+class Pacer {
+public:
+  void start(uint32_t sampleRate) {
+    m_rate = sampleRate;
+    m_next = Clock::now();
+    m_underruns = 0;
+  }
+
+  void wait(uint32_t frames) {
+    const Clock::duration block = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>((double)frames / (double)m_rate));
+    const Clock::time_point now = Clock::now();
+    if (now > m_next + block) { // would have played silence
+      ++m_underruns;
+      m_next = now;
+    }
+    std::this_thread::sleep_until(m_next);
+    m_next += block;
+  }
+
+  uint32_t underruns() const { return m_underruns; }
+
+private:
+  uint32_t m_rate = 48000;
+  Clock::time_point m_next;
+  uint32_t m_underruns = 0;
+};
+
+class NullBackend final : public AudioBackend {
+public:
+  explicit NullBackend(bool realTime) : m_realTime(realTime) {}
+
+  bool open(uint32_t sampleRate, uint32_t) override {
+    m_pacer.start(sampleRate);
+    return true;
+  }
+  void close() override {}
+  bool submit(const float*, uint32_t frames) override {
+    if (m_realTime) m_pacer.wait(frames);
+    return true;
+  }
+  uint32_t underruns() const override { return m_pacer.underruns(); }
+  const char* name() const override { return m_realTime ? "null" : "null (unpaced)"; }
+
+private:
+  bool m_realTime;
+  Pacer m_pacer;
+};
+
+class WavBackend final : public AudioBackend {
+public:
+  WavBackend(const char* path, bool realTime) : m_path(path), m_realTime(realTime) {}
+  ~WavBackend() override { close(); }
+
+  bool open(uint32_t sampleRate, uint32_t blockFrames) override {
+    m_file = std::fopen(m_path.c_str(), "wb");
+    if (!m_file) return false;
+    m_rate = sampleRate;
+    m_frames = 0;
+    m_pcm.resize((size_t)blockFrames * 2);
+    writeHeader(); // sizes patched in close()
+    m_pacer.start(sampleRate);
+    return true;
+  }
+
+  void close() override {
+    if (!m_file) return;
+    std::fseek(m_file, 0, SEEK_SET);
+    writeHeader();
+    std::fclose(m_file);
+    m_file = nullptr;
+  }
+
+  bool submit(const float* samples, uint32_t frames) override {
+    if (m_realTime) m_pacer.wait(frames);
+    if (m_pcm.size() < (size_t)frames * 2) m_pcm.resize((size_t)frames * 2);
+    toPcm16(samples, m_pcm.data(), (size_t)frames * 2);
+    if (std::fwrite(m_pcm.data(), sizeof(int16_t) * 2, frames, m_file) != frames) return false;
+    m_frames += frames;
+    return true;
+  }
+
+  uint32_t underruns() const override { return m_pacer.underruns(); }
+  const char* name() const override { return "wav"; }
+
+private:
+  void writeHeader() {
+    const uint32_t dataBytes = (uint32_t)std::min<uint64_t>(m_frames * 4, 0xFFFFFFFFull - 36);
+    uint8_t h[44];
+    auto put16 = [&](int at, uint32_t v) { h[at] = (uint8_t)v; h[at + 1] = (uint8_t)(v >> 8); };
+    auto put32 = [&](int at, uint32_t v) { put16(at, v & 0xFFFF); put16(at + 2, v >> 16); };
+    std::memcpy(h, "RIFF", 4);
+    put32(4, 36 + dataBytes);
+    std::memcpy(h + 8, "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 1); // PCM
+    put16(22, 2);
+    put32(24, m_rate);
+    put32(28, m_rate * 4);
+    put16(32, 4);
+    put16(34, 16);
+    std::memcpy(h + 36, "data", 4);
+    put32(40, dataBytes);
+    std::fwrite(h, 1, sizeof(h), m_file);
+  }
+
+  std::string m_path;
+  bool m_realTime;
+  std::FILE* m_file = nullptr;
+  uint32_t m_rate = 48000;
+  uint64_t m_frames = 0;
+  std::vector<int16_t> m_pcm;
+  Pacer m_pacer;
+};
+
+#if defined(_WIN32)
+
+/// waveOut with a ring of kBuffers blocks: submit() waits on the driver's
+/// event for the oldest block to come back, refills and requeues it.
+class WinMmBackend final : public AudioBackend {
+public:
+  static constexpr uint32_t kBuffers = 8;
+
+  ~WinMmBackend() override { close(); }
+
+  bool open(uint32_t sampleRate, uint32_t blockFrames) override {
+    m_event = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    WAVEFORMATEX fmt{};
+    fmt.wFormatTag = WAVE_FORMAT_PCM;
+    fmt.nChannels = 2;
+    fmt.nSamplesPerSec = sampleRate;
+    fmt.wBitsPerSample = 16;
+    fmt.nBlockAlign = 4;
+    fmt.nAvgBytesPerSec = sampleRate * 4;
+    if (!m_event || waveOutOpen(&m_device, WAVE_MAPPER, &fmt, (DWORD_PTR)m_event, 0, CALLBACK_EVENT) !=
+                      MMSYSERR_NOERROR) {
+      m_device = nullptr;
+      close();
+      return false;
+    }
+    for (uint32_t i = 0; i < kBuffers; ++i) {
+      m_pcm[i].assign((size_t)blockFrames * 2, 0);
+      WAVEHDR& h = m_headers[i];
+      h = WAVEHDR{};
+      h.lpData = reinterpret_cast<LPSTR>(m_pcm[i].data());
+      h.dwBufferLength = blockFrames * 4;
+      waveOutPrepareHeader(m_device, &h, sizeof(h));
+      h.dwFlags |= WHDR_DONE; // free to fill
+    }
+    m_nextBuffer = 0;
+    m_underruns = 0;
+    return true;
+  }
+
+  void close() override {
+    if (m_device) {
+      waveOutReset(m_device); // returns every queued block
+      for (WAVEHDR& h : m_headers) waveOutUnprepareHeader(m_device, &h, sizeof(h));
+      waveOutClose(m_device);
+      m_device = nullptr;
+    }
+    if (m_event) CloseHandle(m_event);
+    m_event = nullptr;
+  }
+
+  bool submit(const float* samples, uint32_t frames) override {
+    WAVEHDR& h = m_headers[m_nextBuffer];
+    while (!done(h)) {
+      if (WaitForSingleObject(m_event, 200) == WAIT_TIMEOUT && !done(h)) return false;
+    }
+    // Every block back means the device ran dry before this one.
+    bool allDone = true;
+    for (const WAVEHDR& o : m_headers) allDone = allDone && done(o);
+    if (allDone && m_started) ++m_underruns;
+
+    const uint32_t n = std::min<uint32_t>(frames, (uint32_t)(m_pcm[m_nextBuffer].size() / 2));
+    toPcm16(samples, m_pcm[m_nextBuffer].data(), (size_t)n * 2);
+    h.dwBufferLength = n * 4;
+    h.dwFlags &= ~WHDR_DONE;
+    if (waveOutWrite(m_device, &h, sizeof(h)) != MMSYSERR_NOERROR) return false;
+    m_started = true;
+    m_nextBuffer = (m_nextBuffer + 1) % kBuffers;
+    return true;
+  }
+
+  uint32_t underruns() const override { return m_underruns; }
+  const char* name() const override { return "winmm"; }
+
+private:
+  // The driver sets WHDR_DONE from its own thread.
+  static bool done(const WAVEHDR& h) { return (static_cast<const volatile DWORD&>(h.dwFlags) & WHDR_DONE) != 0; }
+
+  HWAVEOUT m_device = nullptr;
+  HANDLE m_event = nullptr;
+  WAVEHDR m_headers[kBuffers]{};
+  std::vector<int16_t> m_pcm[kBuffers];
+  uint32_t m_nextBuffer = 0;
+  uint32_t m_underruns = 0;
+  bool m_started = false;
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<AudioBackend> createNullBackend(bool realTime) { return std::make_unique<NullBackend>(realTime); }
+
+std::unique_ptr<AudioBackend> createWavBackend(const char* path, bool realTime) {
+  return std::make_unique<WavBackend>(path, realTime);
+}
+
+std::unique_ptr<AudioBackend> createDeviceBackend() {
+#if defined(_WIN32)
+  return std::make_unique<WinMmBackend>();
+#else
+  return createNullBackend(true);
+#endif
+}
+
+} // namespace audio
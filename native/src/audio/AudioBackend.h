@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+namespace audio {
+
+/// Where the mixer's output goes. Used from the audio thread only.
+class AudioBackend {
+public:
+  virtual ~AudioBackend() = default;
+
+  virtual bool open(uint32_t sampleRate, uint32_t blockFrames) = 0;
+  virtual void close() = 0;
+
+  /// Waits until the output can take `frames` more interleaved stereo
+  /// frames, then queues them. False if the output failed.
+  virtual bool submit(const float* samples, uint32_t frames) = 0;
+
+  /// Blocks that were due before they were submitted (the mixer fell behind).
+  virtual uint32_t underruns() const = 0;
+  virtual const char* name() const = 0;
+};
+
+/// Discards the output. `realTime` paces submit() at the sample rate like a
+/// device would; without it the mixer runs as fast as it can.
+std::unique_ptr<AudioBackend> createNullBackend(bool realTime);
+
+/// Writes 16-bit stereo WAV to `path`, paced like createNullBackend.
+std::unique_ptr<AudioBackend> createWavBackend(const char* path, bool realTime);
+
+/// The platform's output device: WinMM on Windows; elsewhere a real-time
+/// null backend.
+std::unique_ptr<AudioBackend> createDeviceBackend();
+
+} // namespace audio
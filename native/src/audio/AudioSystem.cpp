@@ -0,0 +1,190 @@
+#include "AudioSystem.h"
+#include "SoundFormat.h"
+#include "../core/AssetPak.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace audio {
+
+void AudioSystem::init(const core::AssetPak* pak, std::unique_ptr<AudioBackend> backend) {
+  m_sounds.assign(kMaxSounds, Sound{});
+  m_soundCount = 0;
+  if (pak) {
+    for (uint32_t i = 0; i < pak->entryCount(); ++i) {
+      const core::AssetPak::Asset a = pak->asset(i);
+      if (a.type == core::PakEntryType::Sound) addSound(pak->name(i), a.data, (size_t)a.size);
+    }
+  }
+
+  m_backend = backend ? std::move(backend) : createDeviceBackend();
+  if (!m_backend->open(kSampleRate, kBlockFrames)) {
+    core::logWarn(core::LogCategory::Audio, "Audio: %s output failed to open, running silent", m_backend->name());
+    m_backend = createNullBackend(true);
+    m_backend->open(kSampleRate, kBlockFrames);
+  }
+  m_mixer.init(kSampleRate);
+  m_block.assign((size_t)kBlockFrames * 2, 0.0f);
+  m_endedScratch.reserve(Mixer::kMaxVoices);
+  m_quit.store(false);
+  m_thread = std::thread([this] { threadMain(); });
+  core::logInfo(core::LogCategory::Audio, "Audio: %u sounds, %s output, %u Hz, %u-frame blocks", m_soundCount,
+                m_backend->name(), kSampleRate, kBlockFrames);
+}
+
+void AudioSystem::shutdown() {
+  if (m_thread.joinable()) {
+    m_quit.store(true, std::memory_order_release);
+    m_thread.join();
+  }
+  if (m_backend) m_backend->close();
+  m_backend.reset();
+  m_soundNames.clear();
+  m_soundCount = 0;
+  m_finished.clear();
+}
+
+SoundId AudioSystem::addSound(std::string_view name, const uint8_t* data, size_t size) {
+  if (m_sounds.empty() || m_soundCount == kMaxSounds) return kInvalidSound;
+  SoundHeader h;
+  if (size < sizeof(h)) return kInvalidSound;
+  std::memcpy(&h, data, sizeof(h));
+  if (std::memcmp(h.magic, "BSND", 4) != 0 || h.version != kSoundVersion || (h.channels != 1 && h.channels != 2) ||
+      !h.sampleRate || (size - sizeof(h)) / (h.channels * sizeof(int16_t)) < h.frameCount) {
+    core::logWarn(core::LogCategory::Audio, "Audio: %.*s is not a version %u sound", (int)name.size(), name.data(),
+                  kSoundVersion);
+    return kInvalidSound;
+  }
+  const SoundId id = m_soundCount++;
+  m_sounds[id] = { reinterpret_cast<const int16_t*>(data + sizeof(h)), h.frameCount, h.channels, h.sampleRate };
+  m_soundNames[std::string(name)] = id;
+  return id;
+}
+
+SoundId AudioSystem::findSound(std::string_view name) const {
+  auto it = m_soundNames.find(std::string(name));
+  if (it != m_soundNames.end()) return it->second;
+  if (name.size() > 4 && name.substr(name.size() - 4) == ".wav") {
+    it = m_soundNames.find(std::string(name.substr(0, name.size() - 4)) + ".bsnd");
+    if (it != m_soundNames.end()) return it->second;
+  }
+  return kInvalidSound;
+}
+
+bool AudioSystem::send(const Command& c) {
+  if (!m_thread.joinable()) return false;
+  if (m_commands.push(c)) return true;
+  ++m_droppedCommands;
+  return false;
+}
+
+VoiceId AudioSystem::play(SoundId sound, const VoiceParams& params) {
+  if (sound >= m_soundCount) return kInvalidVoice;
+  Command c;
+  c.type = CommandType::Play;
+  c.voice = m_nextVoice;
+  c.sound = &m_sounds[sound];
+  c.params = params;
+  if (!send(c)) return kInvalidVoice;
+  m_nextVoice = m_nextVoice + 1 == kInvalidVoice ? 0 : m_nextVoice + 1;
+  return c.voice;
+}
+
+void AudioSystem::set(VoiceId voice, float volume, float pan, float pitch) {
+  Command c;
+  c.type = CommandType::Set;
+  c.voice = voice;
+  c.params = { volume, pan, pitch, false };
+  send(c);
+}
+
+void AudioSystem::stop(VoiceId voice, float fadeSeconds) {
+  Command c;
+  c.type = CommandType::Stop;
+  c.voice = voice;
+  c.fade = fadeSeconds;
+  send(c);
+}
+
+void AudioSystem::stopAll(float fadeSeconds) {
+  Command c;
+  c.type = CommandType::StopAll;
+  c.fade = fadeSeconds;
+  send(c);
+}
+
+void AudioSystem::setMasterVolume(float volume) {
+  Command c;
+  c.type = CommandType::Master;
+  c.params.volume = volume;
+  send(c);
+}
+
+void AudioSystem::update() {
+  m_finished.clear();
+  VoiceId id;
+  while (m_ended.pop(id)) m_finished.push_back(id);
+}
+
+AudioStats AudioSystem::stats() {
+  AudioStats s;
+  s.voices = m_voices.load(std::memory_order_relaxed);
+  s.underruns = m_underruns.load(std::memory_order_relaxed);
+  s.droppedCommands = m_droppedCommands;
+  s.droppedVoices = m_droppedVoices.load(std::memory_order_relaxed);
+  s.mixMs = m_mixMicros.load(std::memory_order_relaxed) / 1000.0;
+  s.worstMixMs = m_worstMixMicros.exchange(0, std::memory_order_relaxed) / 1000.0;
+  s.blockMs = 1000.0 * kBlockFrames / kSampleRate;
+  return s;
+}
+
+void AudioSystem::threadMain() {
+#if defined(_WIN32)
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#endif
+  using Clock = std::chrono::steady_clock;
+  while (!m_quit.load(std::memory_order_acquire)) {
+    const Clock::time_point t0 = Clock::now();
+    Command c;
+    while (m_commands.pop(c)) {
+      switch (c.type) {
+        case CommandType::Play:
+          if (!m_mixer.play(c.voice, *c.sound, c.params)) {
+            m_droppedVoices.fetch_add(1, std::memory_order_relaxed);
+            m_endedScratch.push_back(c.voice); // report it ended at once
+          }
+          break;
+        case CommandType::Set: m_mixer.set(c.voice, c.params.volume, c.params.pan, c.params.pitch); break;
+        case CommandType::Stop: m_mixer.stop(c.voice, c.fade); break;
+        case CommandType::StopAll: m_mixer.stopAll(c.fade); break;
+        case CommandType::Master: m_mixer.setMasterVolume(c.params.volume); break;
+      }
+    }
+
+    m_mixer.mix(m_block.data(), kBlockFrames, m_endedScratch);
+    for (VoiceId id : m_endedScratch) m_ended.push(id); // full only if the game stopped calling update()
+    m_endedScratch.clear();
+
+    const uint32_t micros =
+      (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+    m_mixMicros.store(micros, std::memory_order_relaxed);
+    if (micros > m_worstMixMicros.load(std::memory_order_relaxed)) m_worstMixMicros.store(micros, std::memory_order_relaxed);
+    m_voices.store(m_mixer.activeVoices(), std::memory_order_relaxed);
+
+    if (!m_backend->submit(m_block.data(), kBlockFrames)) {
+      core::logError(core::LogCategory::Audio, "Audio: %s output failed, audio stops", m_backend->name());
+      break;
+    }
+    m_underruns.store(m_backend->underruns(), std::memory_order_relaxed);
+  }
+}
+
+} // namespace audio
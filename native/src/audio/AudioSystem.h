@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../core/SpscQueue.h"
+#include "../memory/MemoryTracker.h"
+#include "AudioBackend.h"
+#include "Mixer.h"
+
+namespace core { class AssetPak; }
+
+namespace audio {
+
+using SoundId = uint32_t;
+constexpr SoundId kInvalidSound = UINT32_MAX;
+
+struct AudioStats {
+  uint32_t voices = 0;           // playing at the last block
+  uint32_t underruns = 0;        // blocks the output waited for
+  uint32_t droppedCommands = 0;  // queue full; the game thread never waits
+  uint32_t droppedVoices = 0;    // play() with every voice busy
+  double mixMs = 0;              // last block
+  double worstMixMs = 0;         // since the previous stats()
+  double blockMs = 0;            // audio one block holds
+};
+
+/// Sound playback for the game.
+///
+/// The mixer lives on its own thread (time-critical priority on Windows),
+/// which loops: apply queued commands, mix one block, hand it to the
+/// backend, which blocks until the output wants more. Gameplay talks to it
+/// only through a lock-free single-producer queue, so play() and friends
+/// are a few stores and never wait on audio; voices that ended come back
+/// through a second queue, read by update().
+///
+/// Sounds are the .bsnd entries of assets.pak (audio/SoundFormat.h), 16-bit
+/// PCM decoded at build time and read by the mixer straight from the mapped
+/// pak, so the OS pages them in as they play. addSound() registers other
+/// memory the same way.
+///
+/// Call everything from the main thread.
+class AudioSystem {
+public:
+  static constexpr uint32_t kSampleRate = 48000;
+  static constexpr uint32_t kBlockFrames = 256; // 5.3 ms
+  static constexpr uint32_t kMaxSounds = 4096;
+
+  /// Starts the audio thread on `backend` (the device if null; a silent
+  /// stand-in if that fails to open). `pak` may be null.
+  void init(const core::AssetPak* pak, std::unique_ptr<AudioBackend> backend = nullptr);
+  void shutdown();
+
+  /// A compiled sound (SoundHeader + samples) that outlives the system.
+  /// kInvalidSound if malformed or the table is full.
+  SoundId addSound(std::string_view name, const uint8_t* data, size_t size);
+  /// By pak name; the source name ("sfx/shot.wav") works too.
+  SoundId findSound(std::string_view name) const;
+
+  /// kInvalidVoice if the sound is unknown or the command queue is full.
+  VoiceId play(SoundId sound, const VoiceParams& params = VoiceParams{});
+  void set(VoiceId voice, float volume, float pan, float pitch);
+  void stop(VoiceId voice, float fadeSeconds = 0.0f);
+  void stopAll(float fadeSeconds = 0.0f);
+  void setMasterVolume(float volume);
+
+  /// Collects voices that ended. Once per frame.
+  void update();
+  const std::vector<VoiceId>& finished() const { return m_finished; }
+
+  AudioStats stats();
+  const char* backendName() const { return m_backend ? m_backend->name() : "none"; }
+
+private:
+  enum class CommandType : uint8_t { Play, Set, Stop, StopAll, Master };
+
+  struct Command {
+    CommandType type = CommandType::Play;
+    VoiceId voice = kInvalidVoice;
+    const Sound* sound = nullptr;
+    VoiceParams params;
+    float fade = 0.0f;
+  };
+
+  bool send(const Command& c);
+  void threadMain();
+
+  std::unique_ptr<AudioBackend> m_backend;
+  std::thread m_thread;
+  std::atomic<bool> m_quit{ false };
+
+  // Written by the main thread before the command that uses a slot, so the
+  // queue's release/acquire publishes it to the audio thread.
+  memory::TrackedVector<Sound, memory::MemTag::Audio> m_sounds; // kMaxSounds, never reallocated
+  uint32_t m_soundCount = 0;
+  memory::TrackedMap<std::string, SoundId, memory::MemTag::Audio> m_soundNames;
+
+  core::SpscQueue<Command, 1024> m_commands; // main -> audio
+  core::SpscQueue<VoiceId, 1024> m_ended;    // audio -> main
+  VoiceId m_nextVoice = 0;
+  std::vector<VoiceId> m_finished;
+
+  // Audio thread only.
+  Mixer m_mixer;
+  std::vector<VoiceId> m_endedScratch;
+  memory::TrackedVector<float, memory::MemTag::Audio> m_block;
+
+  // Audio thread -> stats().
+  std::atomic<uint32_t> m_voices{ 0 }, m_underruns{ 0 }, m_droppedVoices{ 0 };
+  std::atomic<uint32_t> m_mixMicros{ 0 }, m_worstMixMicros{ 0 };
+  uint32_t m_droppedCommands = 0;
+};
+
+} // namespace audio
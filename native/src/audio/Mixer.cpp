@@ -0,0 +1,247 @@
+#include "Mixer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace audio {
+
+namespace {
+
+constexpr float kSampleScale = 1.0f / 32768.0f;
+constexpr float kMinPitch = 1.0f / 64.0f;
+constexpr float kMaxPitch = 16.0f;
+constexpr double kOne = 4294967296.0; // 1.0 in 32.32
+
+inline __m128 frac4(uint64_t p0, uint64_t p1, uint64_t p2, uint64_t p3) {
+  const __m128i f = _mm_setr_epi32((int)(uint32_t)p0, (int)(uint32_t)p1, (int)(uint32_t)p2, (int)(uint32_t)p3);
+  // Unsigned 32-bit fraction: convert the top 31 bits, exact enough for interpolation.
+  return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(f, 1)), _mm_set1_ps(1.0f / 2147483648.0f));
+}
+
+inline __m128 lerp(__m128 a, __m128 b, __m128 t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)); }
+
+/// Four consecutive int16 -> float.
+inline __m128 load4(const int16_t* p) {
+  const __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+
+} // namespace
+
+void Mixer::init(uint32_t sampleRate) {
+  m_sampleRate = sampleRate ? sampleRate : 48000;
+  m_rampFrames = std::max(1u, (uint32_t)(kRampSeconds * (float)m_sampleRate));
+  m_master = m_masterTarget = 1.0f;
+  m_count = 0;
+}
+
+Mixer::Voice* Mixer::find(VoiceId id) {
+  for (uint32_t i = 0; i < m_count; ++i) {
+    if (m_voices[i].id == id) return &m_voices[i];
+  }
+  return nullptr;
+}
+
+void Mixer::setGains(Voice& v, float volume, float pan, uint32_t rampFrames) {
+  volume = std::max(volume, 0.0f) * kSampleScale;
+  pan = std::clamp(pan, -1.0f, 1.0f);
+  if (v.sound.channels == 1) {
+    // Constant power, so a sweep keeps its loudness.
+    const float angle = (pan + 1.0f) * 0.78539816f;
+    v.target[0] = volume * std::cos(angle) * 1.41421356f;
+    v.target[1] = volume * std::sin(angle) * 1.41421356f;
+  } else {
+    v.target[0] = volume * std::min(1.0f, 1.0f - pan);
+    v.target[1] = volume * std::min(1.0f, 1.0f + pan);
+  }
+  v.rampLeft = rampFrames;
+  if (!rampFrames) {
+    v.gain[0] = v.target[0];
+    v.gain[1] = v.target[1];
+  }
+}
+
+void Mixer::setPitch(Voice& v, float pitch) {
+  pitch = std::clamp(pitch, kMinPitch, kMaxPitch);
+  const double rate = (double)v.sound.sampleRate / (double)m_sampleRate * pitch;
+  v.step = std::max<uint64_t>(1, (uint64_t)std::llround(rate * kOne));
+}
+
+bool Mixer::play(VoiceId id, const Sound& sound, const VoiceParams& params) {
+  if (m_count == kMaxVoices || !sound.samples || sound.frameCount < 2) return false;
+  Voice& v = m_voices[m_count++];
+  v = Voice{};
+  v.id = id;
+  v.sound = sound;
+  v.end = (uint64_t)(sound.frameCount - 1) << 32;
+  v.loop = params.loop;
+  setPitch(v, params.pitch);
+  setGains(v, params.volume, params.pan, 0);
+  return true;
+}
+
+void Mixer::set(VoiceId id, float volume, float pan, float pitch) {
+  Voice* v = find(id);
+  if (!v || v->stopping) return;
+  setGains(*v, volume, pan, m_rampFrames);
+  setPitch(*v, pitch);
+}
+
+void Mixer::stop(VoiceId id, float fadeSeconds) {
+  Voice* v = find(id);
+  if (!v) return;
+  v->target[0] = v->target[1] = 0.0f;
+  v->rampLeft = std::max(m_rampFrames, (uint32_t)(std::max(fadeSeconds, 0.0f) * (float)m_sampleRate));
+  v->stopping = true;
+}
+
+void Mixer::stopAll(float fadeSeconds) {
+  for (uint32_t i = 0; i < m_count; ++i) stop(m_voices[i].id, fadeSeconds);
+}
+
+void Mixer::mix(float* out, uint32_t frames, std::vector<VoiceId>& ended) {
+  frames = std::min(frames, kMaxBlockFrames);
+  std::memset(m_left, 0, frames * sizeof(float));
+  std::memset(m_right, 0, frames * sizeof(float));
+
+  for (uint32_t i = 0; i < m_count;) {
+    Voice& v = m_voices[i];
+    if (mixVoice(v, frames)) {
+      ++i;
+      continue;
+    }
+    ended.push_back(v.id);
+    v = m_voices[--m_count]; // keep the live ones packed
+  }
+
+  // Master gain glides over the block; interleave and clip.
+  const __m128 m0 = _mm_set1_ps(m_master);
+  const __m128 dm = _mm_set1_ps((m_masterTarget - m_master) / (float)std::max(frames, 1u));
+  const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    const __m128 k = _mm_add_ps(_mm_set1_ps((float)i), _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f));
+    const __m128 g = _mm_add_ps(m0, _mm_mul_ps(dm, k));
+    const __m128 l = _mm_min_ps(hi, _mm_max_ps(lo, _mm_mul_ps(_mm_load_ps(m_left + i), g)));
+    const __m128 r = _mm_min_ps(hi, _mm_max_ps(lo, _mm_mul_ps(_mm_load_ps(m_right + i), g)));
+    _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+    _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+  }
+  const float d = (m_masterTarget - m_master) / (float)std::max(frames, 1u);
+  for (; i < frames; ++i) {
+    const float g = m_master + d * (float)(i + 1);
+    out[2 * i] = std::clamp(m_left[i] * g, -1.0f, 1.0f);
+    out[2 * i + 1] = std::clamp(m_right[i] * g, -1.0f, 1.0f);
+  }
+  m_master = m_masterTarget;
+}
+
+bool Mixer::mixVoice(Voice& v, uint32_t frames) {
+  bool alive = true;
+  uint32_t done = 0;
+  while (done < frames) {
+    if (v.position >= v.end) {
+      if (!v.loop) {
+        alive = false;
+        break;
+      }
+      v.position %= v.end;
+    }
+    const uint64_t avail = (v.end - v.position + v.step - 1) / v.step;
+    const uint32_t run = (uint32_t)std::min<uint64_t>(frames - done, avail);
+    mixRun(v, done, run);
+    v.position += run * v.step;
+    done += run;
+  }
+
+  // Advance the gain ramp by the whole block.
+  if (v.rampLeft <= frames) {
+    v.gain[0] = v.target[0];
+    v.gain[1] = v.target[1];
+    v.rampLeft = 0;
+  } else {
+    for (int c = 0; c < 2; ++c) v.gain[c] += (v.target[c] - v.gain[c]) * ((float)frames / (float)v.rampLeft);
+    v.rampLeft -= frames;
+  }
+  return alive && !(v.stopping && v.rampLeft == 0);
+}
+
+void Mixer::mixRun(const Voice& v, uint32_t first, uint32_t count) {
+  // Frame i of the block (counting from 1) has gain g + d * min(i, rampLeft).
+  float g[2], d[2];
+  for (int c = 0; c < 2; ++c) {
+    g[c] = v.gain[c];
+    d[c] = v.rampLeft ? (v.target[c] - v.gain[c]) / (float)v.rampLeft : 0.0f;
+  }
+  const __m128 gl = _mm_set1_ps(g[0]), gr = _mm_set1_ps(g[1]);
+  const __m128 dl = _mm_set1_ps(d[0]), dr = _mm_set1_ps(d[1]);
+  const __m128 rampEnd = _mm_set1_ps((float)v.rampLeft);
+  const __m128 steps = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+
+  const int16_t* pcm = v.sound.samples;
+  const bool stereo = v.sound.channels == 2;
+  const bool unitStep = v.step == (uint64_t(1) << 32) && (uint32_t)v.position == 0;
+  float* left = m_left + first;
+  float* right = m_right + first;
+
+  uint32_t j = 0;
+  for (; j + 4 <= count; j += 4) {
+    const __m128 k = _mm_min_ps(_mm_add_ps(_mm_set1_ps((float)(first + j)), steps), rampEnd);
+    const __m128 wl = _mm_add_ps(gl, _mm_mul_ps(dl, k));
+    const __m128 wr = _mm_add_ps(gr, _mm_mul_ps(dr, k));
+
+    __m128 sl, sr;
+    if (unitStep) {
+      // Same rate, on sample boundaries: straight conversion, no interpolation.
+      const size_t idx = (size_t)(v.position >> 32) + j;
+      if (stereo) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pcm + 2 * idx));
+        const __m128 a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)); // l0 r0 l1 r1
+        const __m128 b = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)); // l2 r2 l3 r3
+        sl = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        sr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+      } else {
+        sl = sr = load4(pcm + idx);
+      }
+    } else {
+      const uint64_t p0 = v.position + (uint64_t)j * v.step;
+      const uint64_t p1 = p0 + v.step, p2 = p1 + v.step, p3 = p2 + v.step;
+      const size_t i0 = (size_t)(p0 >> 32), i1 = (size_t)(p1 >> 32), i2 = (size_t)(p2 >> 32), i3 = (size_t)(p3 >> 32);
+      const __m128 t = frac4(p0, p1, p2, p3);
+      if (stereo) {
+        const __m128 l0 = _mm_setr_ps(pcm[2 * i0], pcm[2 * i1], pcm[2 * i2], pcm[2 * i3]);
+        const __m128 l1 = _mm_setr_ps(pcm[2 * i0 + 2], pcm[2 * i1 + 2], pcm[2 * i2 + 2], pcm[2 * i3 + 2]);
+        const __m128 r0 = _mm_setr_ps(pcm[2 * i0 + 1], pcm[2 * i1 + 1], pcm[2 * i2 + 1], pcm[2 * i3 + 1]);
+        const __m128 r1 = _mm_setr_ps(pcm[2 * i0 + 3], pcm[2 * i1 + 3], pcm[2 * i2 + 3], pcm[2 * i3 + 3]);
+        sl = lerp(l0, l1, t);
+        sr = lerp(r0, r1, t);
+      } else {
+        const __m128 a = _mm_setr_ps(pcm[i0], pcm[i1], pcm[i2], pcm[i3]);
+        const __m128 b = _mm_setr_ps(pcm[i0 + 1], pcm[i1 + 1], pcm[i2 + 1], pcm[i3 + 1]);
+        sl = sr = lerp(a, b, t);
+      }
+    }
+    _mm_storeu_ps(left + j, _mm_add_ps(_mm_loadu_ps(left + j), _mm_mul_ps(sl, wl)));
+    _mm_storeu_ps(right + j, _mm_add_ps(_mm_loadu_ps(right + j), _mm_mul_ps(sr, wr)));
+  }
+
+  for (; j < count; ++j) {
+    const float k = std::min((float)(first + j + 1), (float)v.rampLeft);
+    const uint64_t p = v.position + (uint64_t)j * v.step;
+    const size_t i = (size_t)(p >> 32);
+    const float t = (float)(uint32_t)p * (1.0f / 4294967296.0f);
+    float l, r;
+    if (stereo) {
+      l = pcm[2 * i] + (pcm[2 * i + 2] - pcm[2 * i]) * t;
+      r = pcm[2 * i + 1] + (pcm[2 * i + 3] - pcm[2 * i + 1]) * t;
+    } else {
+      l = r = pcm[i] + (pcm[i + 1] - pcm[i]) * t;
+    }
+    left[j] += l * (g[0] + d[0] * k);
+    right[j] += r * (g[1] + d[1] * k);
+  }
+}
+
+} // namespace audio
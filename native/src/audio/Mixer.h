@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace audio {
+
+using VoiceId = uint32_t;
+constexpr VoiceId kInvalidVoice = UINT32_MAX;
+
+/// 16-bit PCM the mixer reads in place (from the mapped pak, usually).
+struct Sound {
+  const int16_t* samples = nullptr; // interleaved
+  uint32_t frameCount = 0;
+  uint32_t channels = 1;            // 1 or 2
+  uint32_t sampleRate = 0;
+};
+
+struct VoiceParams {
+  float volume = 1.0f;
+  float pan = 0.0f;   // -1 left .. 1 right; balance for stereo sounds
+  float pitch = 1.0f; // playback rate, 1 = the sound's own rate
+  bool loop = false;
+};
+
+/// Software mixer: up to kMaxVoices sounds into one stereo float stream.
+///
+/// Voices advance in 32.32 fixed point and resample with linear
+/// interpolation, four output frames per SSE register. Every gain change
+/// (volume, pan, stop) glides linearly over a few milliseconds instead of
+/// jumping, so nothing clicks. Voices are packed at the front of the array,
+/// and silent ones cost nothing.
+///
+/// Owned by one thread (the audio thread); nothing here is synchronized.
+class Mixer {
+public:
+  static constexpr uint32_t kMaxVoices = 128;
+  static constexpr uint32_t kMaxBlockFrames = 1024;
+  static constexpr float kRampSeconds = 0.003f; // for set() and a stop without fade
+
+  void init(uint32_t sampleRate);
+
+  /// False if every voice is busy.
+  bool play(VoiceId id, const Sound& sound, const VoiceParams& params);
+  void set(VoiceId id, float volume, float pan, float pitch);
+  void stop(VoiceId id, float fadeSeconds);
+  void stopAll(float fadeSeconds);
+  void setMasterVolume(float volume) { m_masterTarget = volume < 0.0f ? 0.0f : volume; }
+
+  /// Mixes `frames` (at most kMaxBlockFrames) interleaved stereo frames into
+  /// `out`, clipped to [-1, 1]. Voices that ended are appended to `ended`.
+  void mix(float* out, uint32_t frames, std::vector<VoiceId>& ended);
+
+  uint32_t activeVoices() const { return m_count; }
+  uint32_t sampleRate() const { return m_sampleRate; }
+
+private:
+  struct Voice {
+    VoiceId id = kInvalidVoice;
+    Sound sound;
+    uint64_t position = 0; // source frames, 32.32
+    uint64_t step = 0;     // per output frame, 32.32
+    uint64_t end = 0;      // last frame that still has a successor, 32.32
+    float gain[2] = { 0, 0 };   // left, right; includes the 1/32768 sample scale
+    float target[2] = { 0, 0 };
+    uint32_t rampLeft = 0;      // frames until gain reaches target
+    bool loop = false;
+    bool stopping = false;      // ends once the ramp to silence is done
+  };
+
+  Voice* find(VoiceId id);
+  void setGains(Voice& v, float volume, float pan, uint32_t rampFrames);
+  void setPitch(Voice& v, float pitch);
+  bool mixVoice(Voice& v, uint32_t frames);
+  void mixRun(const Voice& v, uint32_t first, uint32_t count);
+
+  uint32_t m_sampleRate = 48000;
+  uint32_t m_rampFrames = 144;
+  float m_master = 1.0f, m_masterTarget = 1.0f;
+  Voice m_voices[kMaxVoices];
+  uint32_t m_count = 0;
+  alignas(16) float m_left[kMaxBlockFrames];
+  alignas(16) float m_right[kMaxBlockFrames];
+};
+
+} // namespace audio
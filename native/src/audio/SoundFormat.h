@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+namespace audio {
+
+/// A sound decoded offline by the AssetCompiler (from .wav) and stored in
+/// assets.pak as <name>.bsnd. Little endian:
+///
+///   SoundHeader
+///   int16_t samples[frameCount][channels]   interleaved, left first
+///
+/// Samples stay at the source rate; voices resample while mixing. Pak
+/// entries are 64-byte aligned, so the samples are read in place.
+struct SoundHeader {
+  char magic[4] = { 'B', 'S', 'N', 'D' };
+  uint32_t version = 1;
+  uint32_t sampleRate = 0;
+  uint32_t channels = 0; // 1 or 2
+  uint32_t frameCount = 0;
+  uint32_t reserved[3] = { 0, 0, 0 };
+};
+static_assert(sizeof(SoundHeader) == 32, "SoundHeader is an on-disk layout");
+
+constexpr uint32_t kSoundVersion = 1;
+
+} // namespace audio
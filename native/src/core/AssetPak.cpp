@@ -0,0 +1,69 @@
+#include "AssetPak.h"
+#include "Log.h"
+#include "../memory/MemoryTracker.h"
+
+#include <cstring>
+
+namespace core {
+
+bool AssetPak::open(const char* path) {
+  close();
+  if (!m_file.open(path)) {
+    logError(LogCategory::Assets, "Pak: cannot open %s", path);
+    return false;
+  }
+  const uint8_t* base = m_file.data();
+  const uint64_t size = m_file.size();
+  PakHeader h;
+  if (size < sizeof(h)) {
+    logError(LogCategory::Assets, "Pak: %s is truncated", path);
+    m_file.close();
+    return false;
+  }
+  std::memcpy(&h, base, sizeof(h));
+  const uint64_t tableEnd = sizeof(h) + (uint64_t)h.entryCount * sizeof(PakEntry) + h.nameBytes;
+  if (std::memcmp(h.magic, "BPAK", 4) != 0 || h.version != kPakVersion || tableEnd > size) {
+    logError(LogCategory::Assets, "Pak: %s is not a version %u pak", path, kPakVersion);
+    m_file.close();
+    return false;
+  }
+  const PakEntry* entries = reinterpret_cast<const PakEntry*>(base + sizeof(h));
+  for (uint32_t i = 0; i < h.entryCount; ++i) {
+    const PakEntry& e = entries[i];
+    if (e.offset > size || e.size > size - e.offset || (uint64_t)e.nameOffset + e.nameLength > h.nameBytes) {
+      logError(LogCategory::Assets, "Pak: %s has a corrupt entry table", path);
+      m_file.close();
+      return false;
+    }
+  }
+  m_entries = entries;
+  m_names = reinterpret_cast<const char*>(base + sizeof(h) + (size_t)h.entryCount * sizeof(PakEntry));
+  m_count = h.entryCount;
+  memory::track(memory::MemTag::Assets, (size_t)size); // mapped, but resident once touched
+  return true;
+}
+
+void AssetPak::close() {
+  if (m_entries) memory::untrack(memory::MemTag::Assets, (size_t)m_file.size());
+  m_file.close();
+  m_entries = nullptr;
+  m_names = nullptr;
+  m_count = 0;
+}
+
+bool AssetPak::find(std::string_view name, Asset& out) const {
+  uint32_t lo = 0, hi = m_count;
+  while (lo < hi) {
+    const uint32_t mid = (lo + hi) / 2;
+    const int c = this->name(mid).compare(name);
+    if (c == 0) {
+      out = asset(mid);
+      return true;
+    }
+    if (c < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return false;
+}
+
+} // namespace core
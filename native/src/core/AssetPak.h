@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+#include "MappedFile.h"
+#include "PakFormat.h"
+
+namespace core {
+
+/// assets.pak (PakFormat.h), mapped read-only. Entries are used in place:
+/// pointers stay valid until close(), from any thread.
+class AssetPak {
+public:
+  struct Asset {
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+    PakEntryType type = PakEntryType::Raw;
+  };
+
+  /// False with a message logged if the file is missing or malformed.
+  bool open(const char* path);
+  void close();
+  bool isOpen() const { return m_entries != nullptr; }
+
+  uint32_t entryCount() const { return m_count; }
+  std::string_view name(uint32_t i) const { return { m_names + m_entries[i].nameOffset, m_entries[i].nameLength }; }
+  Asset asset(uint32_t i) const { return { m_file.data() + m_entries[i].offset, m_entries[i].size, m_entries[i].type }; }
+
+  /// Binary search by name; false if absent.
+  bool find(std::string_view name, Asset& out) const;
+
+private:
+  MappedFile m_file;
+  const PakEntry* m_entries = nullptr;
+  const char* m_names = nullptr;
+  uint32_t m_count = 0;
+};
+
+} // namespace core
@@ -0,0 +1,266 @@
+#include "JobSystem.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <new>
+
+namespace core {
+
+struct Job {
+  std::function<void()> fn;
+  JobCounter* counter = nullptr;
+  int home = -1; // slot whose pool owns the block, -1 = plain heap
+};
+
+static thread_local int t_slot = -1;
+
+int JobSystem::threadIndex() { return t_slot; }
+
+JobSystem::~JobSystem() { shutdown(); }
+
+void JobSystem::init(unsigned workerCount) {
+  if (m_running) return;
+
+  if (workerCount == 0) {
+    unsigned hw = std::thread::hardware_concurrency();
+    workerCount = hw > 1 ? hw - 1 : 1;
+  }
+
+  m_running = true;
+  m_slots.clear();
+  for (unsigned i = 0; i <= workerCount; ++i) {
+    auto slot = std::make_unique<Slot>();
+    slot->rng = 0x9E3779B9u * (i + 1);
+    slot->jobPool.init(memory::MemTag::Core, sizeof(Job));
+    m_slots.push_back(std::move(slot));
+  }
+
+  t_slot = 0; // the initializing thread owns slot 0
+  for (unsigned i = 1; i <= workerCount; ++i) {
+    m_slots[i]->thread = std::thread([this, i] { workerMain(i); });
+  }
+  logInfo(LogCategory::Engine, "Job system: %u workers + main thread", workerCount);
+}
+
+void JobSystem::shutdown() {
+  if (!m_running) return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_running = false;
+    m_epoch++;
+  }
+  m_sleepCv.notify_all();
+
+  // A worker can get here itself, through std::exit() running the static
+  // destructor; it cannot join itself, so it is let go instead.
+  for (auto& s : m_slots) {
+    if (!s->thread.joinable()) continue;
+    if (s->thread.get_id() == std::this_thread::get_id()) s->thread.detach();
+    else s->thread.join();
+  }
+
+  // Anything still queued never had a waiter; drop it.
+  for (auto& s : m_slots) {
+    while (Job* j = s->deque.pop()) freeJob(j);
+  }
+  for (Job* j : m_inject) freeJob(j);
+  m_inject.clear();
+  m_slots.clear();
+  t_slot = -1;
+}
+
+// ------------------- submission -------------------
+void JobSystem::run(std::function<void()> fn, JobCounter* counter) {
+  if (counter) counter->m_value.fetch_add(1, std::memory_order_relaxed);
+  submit(allocJob(std::move(fn), counter));
+}
+
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> fn, JobCounter* counter) {
+  if (counter) counter->m_value.fetch_add(1, std::memory_order_relaxed);
+  Job* job = allocJob(std::move(fn), counter);
+
+  {
+    // The finisher swaps waiters out under this lock after the value hits
+    // zero, so checking the value (not done()) here cannot strand the job.
+    std::lock_guard<std::mutex> lock(dependency.m_mutex);
+    if (dependency.m_value.load(std::memory_order_seq_cst) != 0) {
+      dependency.m_waiters.push_back(job);
+      return;
+    }
+  }
+  submit(job);
+}
+
+Job* JobSystem::allocJob(std::function<void()> fn, JobCounter* counter) {
+  int slot = t_slot;
+  if (m_running && slot >= 0 && slot < (int)m_slots.size()) {
+    return new (m_slots[slot]->jobPool.alloc()) Job{ std::move(fn), counter, slot };
+  }
+  return new Job{ std::move(fn), counter, -1 };
+}
+
+void JobSystem::freeJob(Job* job) {
+  int home = job->home;
+  if (home < 0) {
+    delete job;
+    return;
+  }
+  job->~Job();
+  // Jobs are usually stolen, so most blocks go back to another thread's pool.
+  if (home == t_slot) {
+    m_slots[home]->jobPool.free(job);
+  } else {
+    m_slots[home]->jobPool.freeRemote(job);
+  }
+}
+
+void JobSystem::submit(Job* job) {
+  // Not running (before init / after shutdown): degrade to synchronous.
+  if (!m_running) {
+    execute(job);
+    return;
+  }
+
+  int slot = t_slot;
+  if (slot >= 0 && slot < (int)m_slots.size()) {
+    if (!m_slots[slot]->deque.push(job)) {
+      execute(job); // deque full: run inline rather than grow
+      return;
+    }
+  } else {
+    std::lock_guard<std::mutex> lock(m_injectMutex);
+    m_inject.push_back(job);
+  }
+
+  m_epoch.fetch_add(1, std::memory_order_release);
+  if (m_sleepers.load(std::memory_order_acquire) > 0) {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_sleepCv.notify_one();
+  }
+}
+
+// ------------------- execution -------------------
+Job* JobSystem::findJob() {
+  int self = t_slot;
+  size_t n = m_slots.size();
+
+  if (self >= 0 && self < (int)n) {
+    if (Job* j = m_slots[self]->deque.pop()) return j;
+  }
+
+  if (n > 1) {
+    // xorshift victim pick; start anywhere, then sweep everyone once.
+    uint32_t r = (self >= 0 && self < (int)n) ? m_slots[self]->rng : 0x2545F491u;
+    r ^= r << 13; r ^= r >> 17; r ^= r << 5;
+    if (self >= 0 && self < (int)n) m_slots[self]->rng = r;
+
+    size_t start = r % n;
+    for (size_t k = 0; k < n; ++k) {
+      size_t v = (start + k) % n;
+      if ((int)v == self) continue;
+      if (Job* j = m_slots[v]->deque.steal()) return j;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_injectMutex);
+  if (m_inject.empty()) return nullptr;
+  Job* j = m_inject.front();
+  m_inject.pop_front();
+  return j;
+}
+
+void JobSystem::execute(Job* job) {
+  if (job->fn) job->fn();
+
+  JobCounter* c = job->counter;
+  freeJob(job);
+  if (!c) return;
+
+  std::vector<Job*> released;
+  c->m_completing.fetch_add(1, std::memory_order_seq_cst);
+  if (c->m_value.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+    std::lock_guard<std::mutex> lock(c->m_mutex);
+    released.swap(c->m_waiters);
+  }
+  c->m_completing.fetch_sub(1, std::memory_order_seq_cst); // c may be gone after this
+  for (Job* j : released) submit(j);
+}
+
+void JobSystem::workerMain(unsigned index) {
+  t_slot = (int)index;
+
+  while (m_running.load(std::memory_order_acquire)) {
+    uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+
+    if (Job* j = findJob()) {
+      execute(j);
+      continue;
+    }
+
+    // Brief spin before sleeping: frame work tends to arrive in bursts.
+    bool found = false;
+    for (int spin = 0; spin < 64 && !found; ++spin) {
+      std::this_thread::yield();
+      if (m_epoch.load(std::memory_order_acquire) != epoch) found = true;
+    }
+    if (found) continue;
+
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_sleepers.fetch_add(1, std::memory_order_acq_rel);
+    m_sleepCv.wait(lock, [&] {
+      return !m_running.load(std::memory_order_acquire) ||
+             m_epoch.load(std::memory_order_acquire) != epoch;
+    });
+    m_sleepers.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+  while (!counter.done()) {
+    if (Job* j = findJob()) {
+      execute(j);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// ------------------- parallel-for -------------------
+void JobSystem::splitRange(uint32_t begin, uint32_t end, uint32_t minChunk,
+                           const std::function<void(uint32_t, uint32_t)>& fn, JobCounter& counter) {
+  int self = t_slot;
+  bool ownsDeque = self >= 0 && self < (int)m_slots.size();
+
+  // Only expose more parallelism while nobody has anything queued here to
+  // steal; otherwise keep the rest of the range and run it in one go.
+  while (end - begin > minChunk && ownsDeque && m_slots[self]->deque.sizeHint() == 0) {
+    uint32_t mid = begin + (end - begin) / 2;
+    uint32_t hi = end;
+    run([this, mid, hi, minChunk, &fn, &counter] { splitRange(mid, hi, minChunk, fn, counter); }, &counter);
+    end = mid;
+  }
+  fn(begin, end);
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t minChunk,
+                            const std::function<void(uint32_t, uint32_t)>& fn) {
+  if (count == 0) return;
+  if (minChunk == 0) minChunk = 1;
+
+  if (!m_running || m_slots.size() <= 1 || count <= minChunk) {
+    fn(0, count);
+    return;
+  }
+
+  JobCounter counter;
+  if (t_slot >= 0) {
+    splitRange(0, count, minChunk, fn, counter);
+  } else {
+    // Foreign thread: hand the root range to the pool.
+    run([this, count, minChunk, &fn, &counter] { splitRange(0, count, minChunk, fn, counter); }, &counter);
+  }
+  wait(counter);
+}
+
+} // namespace core
@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "WorkStealingDeque.h"
+#include "../memory/PoolAllocator.h"
+
+namespace core {
+
+struct Job;
+
+/// Counts outstanding jobs. Jobs submitted with a counter increment it and
+/// decrement it on completion; jobs submitted with runAfter(counter, ...) are
+/// parked on it and released once it reaches zero.
+class JobCounter {
+public:
+  JobCounter() = default;
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  /// True once every job finished and the last one let go of this counter,
+  /// so a waiter may destroy it right after.
+  bool done() const {
+    return m_value.load(std::memory_order_seq_cst) == 0 &&
+           m_completing.load(std::memory_order_seq_cst) == 0;
+  }
+  int value() const { return m_value.load(std::memory_order_acquire); }
+
+private:
+  friend class JobSystem;
+  std::atomic<int> m_value{0};
+  std::atomic<int> m_completing{0}; // finishers still touching this counter
+  std::mutex m_mutex;          // guards m_waiters only
+  std::vector<Job*> m_waiters;
+};
+
+/// Shared work-stealing scheduler.
+///
+/// One Chase-Lev deque per thread: slot 0 belongs to the thread that called
+/// init() (the main thread), slots 1..N to workers. Owners push/pop LIFO,
+/// idle threads steal FIFO from a random victim. Threads that are not part
+/// of the pool submit through a locked injection queue.
+///
+/// wait() never blocks while there is work: the waiting thread keeps running
+/// jobs (its own first, then stolen ones) until the counter drains.
+class JobSystem {
+public:
+  JobSystem() = default;
+  ~JobSystem();
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  /// workerCount == 0 -> hardware threads - 1 (at least 1).
+  void init(unsigned workerCount = 0);
+  void shutdown();
+
+  /// Schedules fn; if counter is given it is incremented now and decremented
+  /// when fn returns.
+  void run(std::function<void()> fn, JobCounter* counter = nullptr);
+
+  /// Schedules fn once `dependency` reaches zero (immediately if it already is).
+  void runAfter(JobCounter& dependency, std::function<void()> fn, JobCounter* counter = nullptr);
+
+  /// Runs other jobs until counter reaches zero.
+  void wait(JobCounter& counter);
+
+  /// Calls fn(begin, end) over [0, count) in parallel and waits.
+  ///
+  /// Chunking adapts at run time (lazy binary splitting): a range is halved
+  /// and the upper half exposed for stealing only while this thread's deque is
+  /// empty, i.e. while someone could actually pick it up. Ranges never go below
+  /// minChunk items. Small loops therefore run in one piece, big ones spread
+  /// over every idle thread without a tuned grain size.
+  void parallelFor(uint32_t count, uint32_t minChunk,
+                   const std::function<void(uint32_t begin, uint32_t end)>& fn);
+
+  /// Number of threads that execute jobs (workers + the main thread).
+  unsigned threadCount() const { return (unsigned)m_slots.size(); }
+
+  /// 0 = main thread, 1..N = workers, -1 = not a pool thread.
+  static int threadIndex();
+
+private:
+  static constexpr size_t kDequeCapacity = 4096;
+  using Deque = WorkStealingDeque<Job*, kDequeCapacity>;
+
+  struct Slot {
+    Deque deque;
+    memory::PoolAllocator jobPool; // Job blocks allocated by this thread
+    std::thread thread;
+    uint32_t rng = 0;
+  };
+
+  void workerMain(unsigned index);
+  Job* allocJob(std::function<void()> fn, JobCounter* counter);
+  void freeJob(Job* job);
+  void submit(Job* job);
+  Job* findJob();
+  void execute(Job* job);
+  void splitRange(uint32_t begin, uint32_t end, uint32_t minChunk,
+                  const std::function<void(uint32_t, uint32_t)>& fn, JobCounter& counter);
+
+  std::vector<std::unique_ptr<Slot>> m_slots;
+  std::atomic<bool> m_running{false};
+
+  std::mutex m_injectMutex;
+  std::deque<Job*> m_inject;
+
+  // Sleep/wake for idle workers. The epoch bumps on every submit so a worker
+  // never sleeps through work published while it was deciding to sleep.
+  std::mutex m_sleepMutex;
+  std::condition_variable m_sleepCv;
+  std::atomic<uint64_t> m_epoch{0};
+  std::atomic<int> m_sleepers{0};
+};
+
+} // namespace core
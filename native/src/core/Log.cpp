@@ -0,0 +1,650 @@
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core {
+
+namespace detail {
+std::atomic<uint8_t> g_minLevel{ (uint8_t)LogLevel::Info };
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point g_start = Clock::now();
+
+int64_t nowTicks() { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - g_start).count(); }
+
+struct RecordHeader {
+  uint32_t size = 0; // header + arguments, 8-byte aligned
+  uint8_t level = 0;
+  uint8_t category = 0;
+  uint16_t argCount = 0;
+  const char* fmt = nullptr;
+  int64_t ticks = 0;       // ns since startup
+  uint32_t suppressed = 0; // records this call site skipped before this one
+  uint32_t thread = 0;
+};
+static_assert(sizeof(RecordHeader) == 32, "records stay 8-byte aligned");
+
+constexpr uint8_t kPadding = 0xFF; // level of the filler before a wrap
+
+/// One producing thread's ring. head is written by that thread only, tail
+/// by the log thread only.
+struct ThreadBuffer {
+  std::unique_ptr<uint8_t[]> data;
+  uint64_t capacity = 0; // power of two
+  uint32_t thread = 0;
+  alignas(64) std::atomic<uint64_t> head{ 0 };
+  uint64_t cachedTail = 0; // producer's last look at tail
+  uint64_t open = 0;       // head once the record being written is published
+  alignas(64) std::atomic<uint64_t> tail{ 0 };
+};
+
+/// Rate limit per format string. Races at a window boundary only blur the
+/// count a little.
+struct CallSite {
+  std::atomic<const char*> fmt{ nullptr };
+  std::atomic<uint32_t> window{ 0 };
+  std::atomic<uint32_t> count{ 0 };
+  std::atomic<uint32_t> suppressed{ 0 };
+};
+
+constexpr uint32_t kCallSites = 1024;
+constexpr uint32_t kProbe = 8;
+
+struct Line {
+  int64_t ticks;
+  uint32_t thread;
+  uint32_t suppressed;
+  uint8_t level;
+  uint8_t category;
+  uint32_t begin, end; // in the batch text
+};
+
+struct Logger {
+  LogConfig config;
+  std::atomic<bool> running{ false };
+  std::atomic<uint32_t> generation{ 1 };
+  std::atomic<uint32_t> rate{ LogConfig{}.ratePerSecond };
+  std::atomic<uint8_t> consoleLevel{ (uint8_t)LogLevel::Info };
+  uint8_t fileLevel = (uint8_t)LogLevel::Off;
+
+  std::mutex mutex; // buffers, quit, flush counters
+  std::condition_variable wake, flushed;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  bool quit = false;
+  uint64_t flushRequested = 0, flushDone = 0;
+  std::thread thread;
+
+  CallSite sites[kCallSites];
+
+  // Log thread only.
+  std::FILE* file = nullptr;
+  uint64_t fileBytes = 0;
+  std::vector<ThreadBuffer*> draining;
+  std::vector<Line> lines;
+  std::string text, console, fileText;
+
+  std::atomic<uint64_t> written{ 0 }, dropped{ 0 }, suppressed{ 0 };
+  uint64_t droppedReported = 0;
+
+  ~Logger(); // exit() without logShutdown() still writes the tail
+};
+
+Logger g_log;
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+thread_local uint32_t t_generation = 0;
+thread_local bool t_direct = false;        // the open record is in t_scratch
+thread_local std::vector<uint64_t> t_scratch; // 8-byte aligned
+
+const char* const kCategoryNames[(size_t)LogCategory::Count] = {
+  "engine", "memory", "assets", "render", "physics", "anim", "nav", "audio", "script", "save",
+};
+
+const char* const kLevelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+const char* consoleTag(uint8_t level, uint8_t category) {
+  if (category == (uint8_t)LogCategory::Script) return "[PY] ";
+  static const char* const kTags[] = { "[DBG ] ", "[INFO] ", "[WARN] ", "[ERR ] " };
+  return kTags[level < 4 ? level : 3];
+}
+
+// ------------------- formatting -------------------
+
+struct ArgReader {
+  const uint8_t* p;
+  uint32_t left;
+
+  bool next(uint8_t& tag, uint64_t& bits, std::string_view& str) {
+    if (left == 0) return false;
+    --left;
+    tag = *p++;
+    if (tag == detail::kArgString) {
+      uint32_t n;
+      std::memcpy(&n, p, sizeof(n));
+      str = { reinterpret_cast<const char*>(p + sizeof(n)), n };
+      p += sizeof(n) + n;
+    } else {
+      std::memcpy(&bits, p, sizeof(bits));
+      p += sizeof(bits);
+    }
+    return true;
+  }
+};
+
+struct Arg {
+  uint8_t tag = detail::kArgInt;
+  uint64_t bits = 0;
+  std::string_view str;
+  bool present = false;
+
+  long long asInt() const {
+    if (tag == detail::kArgDouble) return (long long)asDouble();
+    return tag == detail::kArgString ? 0 : (long long)bits;
+  }
+  unsigned long long asUint() const {
+    if (tag == detail::kArgDouble) return (unsigned long long)asDouble();
+    return tag == detail::kArgString ? 0 : (unsigned long long)bits;
+  }
+  double asDouble() const {
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    if (tag == detail::kArgDouble) return d;
+    if (tag == detail::kArgInt) return (double)(int64_t)bits;
+    return tag == detail::kArgString ? 0.0 : (double)bits;
+  }
+};
+
+template <class T>
+void appendf(std::string& out, const char* spec, T value) {
+  char buf[256];
+  const int n = std::snprintf(buf, sizeof(buf), spec, value);
+  if (n < 0) return;
+  if (n < (int)sizeof(buf)) {
+    out.append(buf, (size_t)n);
+    return;
+  }
+  const size_t at = out.size();
+  out.resize(at + (size_t)n + 1);
+  std::snprintf(&out[at], (size_t)n + 1, spec, value);
+  out.resize(at + (size_t)n);
+}
+
+/// printf over the stored arguments: each conversion is re-issued with the
+/// length modifier matching what was stored.
+void formatMessage(const char* fmt, ArgReader args, std::string& out) {
+  auto take = [&args]() {
+    Arg a;
+    a.present = args.next(a.tag, a.bits, a.str);
+    return a;
+  };
+
+  std::string tmp;
+  for (const char* f = fmt; *f;) {
+    if (*f != '%') {
+      const char* s = f;
+      while (*f && *f != '%') ++f;
+      out.append(s, (size_t)(f - s));
+      continue;
+    }
+    if (f[1] == '%') {
+      out += '%';
+      f += 2;
+      continue;
+    }
+
+    char spec[64];
+    size_t n = 0;
+    spec[n++] = '%';
+    ++f;
+    while (*f && std::strchr("-+ #0", *f)) {
+      if (n < 8) spec[n++] = *f;
+      ++f;
+    }
+    auto number = [&]() {
+      if (*f == '*') {
+        ++f;
+        n += (size_t)std::snprintf(spec + n, 16, "%d", (int)take().asInt());
+        return;
+      }
+      for (size_t digits = 0; *f >= '0' && *f <= '9'; ++f)
+        if (digits++ < 8) spec[n++] = *f;
+    };
+    number();
+    if (*f == '.') {
+      spec[n++] = '.';
+      ++f;
+      number();
+    }
+    while (*f && std::strchr("hlLqjzt", *f)) ++f;
+    const char conv = *f;
+    if (!conv) break;
+    ++f;
+
+    const Arg a = take();
+    if (!a.present) {
+      out += "<?>";
+      continue;
+    }
+    switch (conv) {
+      case 'd':
+      case 'i':
+        std::memcpy(spec + n, "lld", 4);
+        appendf(out, spec, a.asInt());
+        break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        spec[n++] = 'l';
+        spec[n++] = 'l';
+        spec[n++] = conv;
+        spec[n] = '\0';
+        appendf(out, spec, a.asUint());
+        break;
+      case 'c':
+        std::memcpy(spec + n, "c", 2);
+        appendf(out, spec, (int)a.asInt());
+        break;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        spec[n++] = conv;
+        spec[n] = '\0';
+        appendf(out, spec, a.asDouble());
+        break;
+      case 'p':
+        std::memcpy(spec + n, "p", 2);
+        appendf(out, spec, (const void*)(uintptr_t)a.bits);
+        break;
+      case 's':
+        if (n == 1 && a.tag == detail::kArgString) {
+          out.append(a.str); // plain %s, the usual case
+          break;
+        }
+        if (a.tag == detail::kArgString) {
+          tmp.assign(a.str);
+        } else {
+          tmp.clear();
+          if (a.tag == detail::kArgDouble) appendf(tmp, "%g", a.asDouble());
+          else appendf(tmp, "%lld", a.asInt());
+        }
+        std::memcpy(spec + n, "s", 2);
+        appendf(out, spec, tmp.c_str());
+        break;
+      default:
+        out += '%';
+        out += conv;
+        break;
+    }
+  }
+}
+
+void appendSuppressed(std::string& out, uint32_t count) {
+  if (!count) return;
+  char buf[64];
+  const int n = std::snprintf(buf, sizeof(buf), " (%u similar skipped)", count);
+  out.append(buf, (size_t)n);
+}
+
+// ------------------- producers -------------------
+
+/// False if the call site is over its rate; otherwise what it skipped.
+/// Warnings and errors are never limited: they are rare, and losing one
+/// to a chatty site sharing its format string costs more than the spam.
+bool admit(LogLevel level, const char* fmt, int64_t ticks, uint32_t& suppressedBefore) {
+  suppressedBefore = 0;
+  const uint32_t rate = g_log.rate.load(std::memory_order_relaxed);
+  if (rate == 0 || level >= LogLevel::Warn) return true;
+
+  const uint32_t h = (uint32_t)(((uintptr_t)fmt >> 3) * 2654435761u) & (kCallSites - 1);
+  CallSite* site = nullptr;
+  for (uint32_t i = 0; i < kProbe && !site; ++i) {
+    CallSite& s = g_log.sites[(h + i) & (kCallSites - 1)];
+    const char* key = s.fmt.load(std::memory_order_acquire);
+    if (key == fmt) site = &s;
+    else if (!key && s.fmt.compare_exchange_strong(key, fmt)) site = &s;
+    else if (key == fmt) site = &s; // another thread claimed it for the same site
+  }
+  if (!site) return true; // table crowded here: unlimited
+
+  const uint32_t window = (uint32_t)(ticks / 1000000000);
+  if (site->window.load(std::memory_order_relaxed) != window &&
+      site->window.exchange(window, std::memory_order_relaxed) != window) {
+    site->count.store(0, std::memory_order_relaxed);
+  }
+  if (site->count.fetch_add(1, std::memory_order_relaxed) >= rate) {
+    site->suppressed.fetch_add(1, std::memory_order_relaxed);
+    g_log.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  suppressedBefore = site->suppressed.exchange(0, std::memory_order_relaxed);
+  return true;
+}
+
+ThreadBuffer* threadBuffer() {
+  const uint32_t generation = g_log.generation.load(std::memory_order_acquire);
+  if (t_buffer && t_generation == generation) return t_buffer;
+
+  auto b = std::make_unique<ThreadBuffer>();
+  uint64_t capacity = 4096;
+  while (capacity < g_log.config.threadBufferBytes) capacity <<= 1;
+  b->data = std::make_unique<uint8_t[]>(capacity);
+  b->capacity = capacity;
+
+  std::lock_guard<std::mutex> lock(g_log.mutex);
+  b->thread = (uint32_t)g_log.buffers.size();
+  t_buffer = b.get();
+  t_generation = generation;
+  g_log.buffers.push_back(std::move(b));
+  return t_buffer;
+}
+
+RecordHeader* reserve(ThreadBuffer& b, uint32_t size) {
+  const uint64_t head = b.head.load(std::memory_order_relaxed);
+  const uint64_t offset = head & (b.capacity - 1);
+  const uint64_t contiguous = b.capacity - offset;
+  const uint64_t need = size <= contiguous ? size : contiguous + size;
+  if (head + need - b.cachedTail > b.capacity) {
+    b.cachedTail = b.tail.load(std::memory_order_acquire);
+    if (head + need - b.cachedTail > b.capacity) return nullptr;
+  }
+
+  uint64_t at = head;
+  if (size > contiguous) {
+    // A tail shorter than a header gets none; drain() skips it by its size.
+    if (contiguous >= sizeof(RecordHeader)) {
+      RecordHeader pad;
+      pad.size = (uint32_t)contiguous;
+      pad.level = kPadding;
+      std::memcpy(b.data.get() + offset, &pad, sizeof(pad));
+    }
+    at += contiguous;
+  }
+  b.open = at + size;
+  return reinterpret_cast<RecordHeader*>(b.data.get() + (at & (b.capacity - 1)));
+}
+
+void writeDirect(const RecordHeader& h) {
+  if (h.level < g_log.consoleLevel.load(std::memory_order_relaxed)) return;
+  std::string line = consoleTag(h.level, h.category);
+  formatMessage(h.fmt, { reinterpret_cast<const uint8_t*>(&h + 1), h.argCount }, line);
+  appendSuppressed(line, h.suppressed);
+  line += '\n';
+  std::fwrite(line.data(), 1, line.size(), stdout);
+}
+
+// ------------------- log thread -------------------
+
+std::string rotatedName(const std::string& path, uint32_t index) {
+  const size_t slash = path.find_last_of("/\\");
+  const size_t dot = path.find_last_of('.');
+  const std::string n = "." + std::to_string(index);
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path + n;
+  return path.substr(0, dot) + n + path.substr(dot);
+}
+
+void rotateFiles() {
+  const LogConfig& c = g_log.config;
+  if (c.fileKeep == 0) return;
+  std::remove(rotatedName(c.filePath, c.fileKeep).c_str());
+  for (uint32_t i = c.fileKeep; i-- > 1;) std::rename(rotatedName(c.filePath, i).c_str(), rotatedName(c.filePath, i + 1).c_str());
+  std::rename(c.filePath.c_str(), rotatedName(c.filePath, 1).c_str());
+}
+
+void openFile(bool rotateOld) {
+  if (rotateOld) {
+    if (std::FILE* old = std::fopen(g_log.config.filePath.c_str(), "rb")) {
+      std::fclose(old);
+      rotateFiles(); // keep the previous run as game.1.log
+    }
+  }
+  g_log.file = std::fopen(g_log.config.filePath.c_str(), "wb");
+  g_log.fileBytes = 0;
+  if (!g_log.file) std::printf("[WARN] Log: cannot open %s, console only\n", g_log.config.filePath.c_str());
+}
+
+void writeFile(const std::string& data) {
+  if (!g_log.file || data.empty()) return;
+  if (g_log.fileBytes > 0 && g_log.fileBytes + data.size() > g_log.config.fileMaxBytes) {
+    std::fclose(g_log.file);
+    rotateFiles();
+    openFile(false);
+    if (!g_log.file) return;
+  }
+  std::fwrite(data.data(), 1, data.size(), g_log.file);
+  g_log.fileBytes += data.size();
+}
+
+/// Formats everything the producers published so far and writes it.
+void drain() {
+  Logger& g = g_log;
+  g.lines.clear();
+  g.text.clear();
+  for (ThreadBuffer* b : g.draining) {
+    uint64_t tail = b->tail.load(std::memory_order_relaxed);
+    const uint64_t head = b->head.load(std::memory_order_acquire);
+    while (tail < head) {
+      // No record fits in less than a header: a tail that short is padding.
+      const uint64_t contiguous = b->capacity - (tail & (b->capacity - 1));
+      if (contiguous < sizeof(RecordHeader)) {
+        tail += contiguous;
+        continue;
+      }
+      RecordHeader h;
+      const uint8_t* at = b->data.get() + (tail & (b->capacity - 1));
+      std::memcpy(&h, at, sizeof(h));
+      tail += h.size;
+      if (h.level == kPadding) continue;
+      Line l{ h.ticks, b->thread, h.suppressed, h.level, h.category, (uint32_t)g.text.size(), 0 };
+      formatMessage(h.fmt, { at + sizeof(h), h.argCount }, g.text);
+      l.end = (uint32_t)g.text.size();
+      g.lines.push_back(l);
+    }
+    b->tail.store(tail, std::memory_order_release);
+  }
+
+  // Said once per batch, after whatever did fit.
+  const uint64_t dropped = g.dropped.load(std::memory_order_relaxed);
+  if (dropped != g.droppedReported) {
+    Line l{ nowTicks(), 0, 0, (uint8_t)LogLevel::Warn, (uint8_t)LogCategory::Engine, (uint32_t)g.text.size(), 0 };
+    appendf(g.text, "Log: %llu records dropped, a thread's buffer was full",
+            (unsigned long long)(dropped - g.droppedReported));
+    l.end = (uint32_t)g.text.size();
+    g.lines.push_back(l);
+    g.droppedReported = dropped;
+  }
+  if (g.lines.empty()) return;
+
+  // Each ring is in order already; this interleaves the threads.
+  std::stable_sort(g.lines.begin(), g.lines.end(), [](const Line& a, const Line& b) { return a.ticks < b.ticks; });
+
+  g.console.clear();
+  g.fileText.clear();
+  const uint8_t consoleLevel = g.consoleLevel.load(std::memory_order_relaxed);
+  char prefix[96];
+  for (const Line& l : g.lines) {
+    const std::string_view msg(g.text.data() + l.begin, l.end - l.begin);
+    if (l.level >= consoleLevel) {
+      g.console += consoleTag(l.level, l.category);
+      g.console += msg;
+      appendSuppressed(g.console, l.suppressed);
+      g.console += '\n';
+    }
+    if (g.file && l.level >= g.fileLevel) {
+      const int n = std::snprintf(prefix, sizeof(prefix), "%10.4f %-5s %-7s T%-2u ", l.ticks / 1e9,
+                                  kLevelNames[l.level < 4 ? l.level : 3], kCategoryNames[l.category], l.thread);
+      g.fileText.append(prefix, (size_t)n);
+      g.fileText += msg;
+      appendSuppressed(g.fileText, l.suppressed);
+      g.fileText += '\n';
+    }
+  }
+  if (!g.console.empty()) {
+    std::fwrite(g.console.data(), 1, g.console.size(), stdout);
+    std::fflush(stdout);
+  }
+  writeFile(g.fileText);
+  if (g.file) std::fflush(g.file);
+  g.written.fetch_add(g.lines.size(), std::memory_order_relaxed);
+}
+
+void threadMain() {
+  Logger& g = g_log;
+  for (;;) {
+    uint64_t flushTarget;
+    bool quit;
+    {
+      std::unique_lock<std::mutex> lock(g.mutex);
+      g.wake.wait_for(lock, std::chrono::milliseconds(10), [&g] { return g.quit || g.flushRequested > g.flushDone; });
+      g.draining.clear();
+      for (const auto& b : g.buffers) g.draining.push_back(b.get());
+      flushTarget = g.flushRequested;
+      quit = g.quit;
+    }
+    drain();
+    {
+      std::lock_guard<std::mutex> lock(g.mutex);
+      g.flushDone = flushTarget;
+    }
+    g.flushed.notify_all();
+    if (quit) return;
+  }
+}
+
+LogLevel parseLevel(const char* v, LogLevel fallback) {
+  static const char* const kNames[] = { "debug", "info", "warn", "error", "off" };
+  for (int i = 0; i < 5; ++i) {
+    if (std::strcmp(v, kNames[i]) == 0) return (LogLevel)i;
+  }
+  return fallback;
+}
+
+Logger::~Logger() { logShutdown(); }
+
+} // namespace
+
+namespace detail {
+
+uint8_t* beginRecord(LogLevel level, LogCategory category, const char* fmt, uint32_t argCount, size_t argBytes) {
+  const int64_t ticks = nowTicks();
+  uint32_t suppressedBefore;
+  if (!admit(level, fmt, ticks, suppressedBefore)) return nullptr;
+
+  RecordHeader h;
+  h.size = (uint32_t)((sizeof(RecordHeader) + argBytes + 7) & ~size_t(7));
+  h.level = (uint8_t)level;
+  h.category = (uint8_t)category;
+  h.argCount = (uint16_t)argCount;
+  h.fmt = fmt;
+  h.ticks = ticks;
+  h.suppressed = suppressedBefore;
+
+  RecordHeader* slot = nullptr;
+  if (g_log.running.load(std::memory_order_acquire)) {
+    ThreadBuffer* b = threadBuffer();
+    h.thread = b->thread;
+    if (h.size <= b->capacity / 4) slot = reserve(*b, h.size);
+    if (!slot) {
+      g_log.dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    t_direct = false;
+  } else {
+    t_scratch.resize(h.size / 8);
+    slot = reinterpret_cast<RecordHeader*>(t_scratch.data());
+    t_direct = true;
+  }
+  std::memcpy(slot, &h, sizeof(h));
+  return reinterpret_cast<uint8_t*>(slot + 1);
+}
+
+void endRecord() {
+  if (t_direct) {
+    writeDirect(*reinterpret_cast<const RecordHeader*>(t_scratch.data()));
+    return;
+  }
+  t_buffer->head.store(t_buffer->open, std::memory_order_release);
+}
+
+} // namespace detail
+
+void logInit(const LogConfig& config) {
+  if (g_log.running.load()) return;
+  Logger& g = g_log;
+  g.config = config;
+  g.rate.store(config.ratePerSecond, std::memory_order_relaxed);
+  g.consoleLevel.store((uint8_t)config.consoleLevel, std::memory_order_relaxed);
+  g.fileLevel = config.filePath.empty() ? (uint8_t)LogLevel::Off : (uint8_t)config.fileLevel;
+  g.quit = false;
+  if (!config.filePath.empty()) openFile(true);
+  detail::g_minLevel.store(std::min((uint8_t)config.consoleLevel, g.fileLevel), std::memory_order_relaxed);
+  g.running.store(true, std::memory_order_release);
+  g.thread = std::thread(threadMain);
+}
+
+void logShutdown() {
+  Logger& g = g_log;
+  if (!g.running.load()) return;
+  {
+    std::lock_guard<std::mutex> lock(g.mutex);
+    g.quit = true;
+  }
+  g.wake.notify_one();
+  g.thread.join();
+  g.running.store(false, std::memory_order_release);
+  g.generation.fetch_add(1, std::memory_order_acq_rel);
+  if (g.file) std::fclose(g.file);
+  g.file = nullptr;
+  g.buffers.clear();
+  g.draining.clear();
+  g.flushRequested = g.flushDone = 0;
+  detail::g_minLevel.store((uint8_t)LogLevel::Info, std::memory_order_relaxed);
+  g.consoleLevel.store((uint8_t)LogLevel::Info, std::memory_order_relaxed);
+}
+
+void logFlush() {
+  Logger& g = g_log;
+  if (!g.running.load(std::memory_order_acquire)) {
+    std::fflush(stdout);
+    return;
+  }
+  std::unique_lock<std::mutex> lock(g.mutex);
+  const uint64_t target = ++g.flushRequested;
+  g.wake.notify_one();
+  g.flushed.wait(lock, [&g, target] { return g.flushDone >= target; });
+}
+
+LogStats logStats() {
+  LogStats s;
+  s.written = g_log.written.load(std::memory_order_relaxed);
+  s.dropped = g_log.dropped.load(std::memory_order_relaxed);
+  s.suppressed = g_log.suppressed.load(std::memory_order_relaxed);
+  return s;
+}
+
+LogConfig logConfigFromEnv() {
+  LogConfig c;
+  if (const char* v = std::getenv("BSP_LOG_LEVEL")) c.consoleLevel = c.fileLevel = parseLevel(v, c.consoleLevel);
+  if (const char* v = std::getenv("BSP_LOG_FILE")) c.filePath = v;
+  if (const char* v = std::getenv("BSP_LOG_RATE")) c.ratePerSecond = (uint32_t)std::atoi(v);
+  return c;
+}
+
+} // namespace core
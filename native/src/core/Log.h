@@ -0,0 +1,175 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace core {
+
+enum class LogLevel : uint8_t { Debug, Info, Warn, Error, Off };
+
+enum class LogCategory : uint8_t { Engine, Memory, Assets, Render, Physics, Anim, Nav, Audio, Script, Save, Count };
+
+struct LogConfig {
+  LogLevel consoleLevel = LogLevel::Info;
+  LogLevel fileLevel = LogLevel::Info;
+  std::string filePath = "game.log";     // empty = no file
+  uint64_t fileMaxBytes = 4ull << 20;    // then game.log -> game.1.log -> ...
+  uint32_t fileKeep = 3;                 // rotated files kept
+  uint32_t ratePerSecond = 100;          // per call site; 0 = unlimited
+  uint32_t threadBufferBytes = 64u << 10; // per producing thread, power of two
+};
+
+struct LogStats {
+  uint64_t written = 0;
+  uint64_t dropped = 0;    // a thread's buffer was full
+  uint64_t suppressed = 0; // over a call site's rate
+};
+
+/// Asynchronous logging.
+///
+/// logInfo() and friends never format or touch a file: they append a binary
+/// record (format string pointer, timestamp, arguments by value) to the
+/// calling thread's own ring, a plain single-producer buffer, and return. A
+/// background thread drains every ring, merges the records by time, formats
+/// them and writes them to the console and a size-rotated file.
+///
+/// The format string must outlive the process (a literal); anything dynamic
+/// goes in as a "%s" argument, which is copied. printf conversions apply to
+/// what the argument is, not what the length modifier says, so "%d" with a
+/// size_t is fine.
+///
+/// Records below both levels cost one load. Each call site (format string)
+/// is limited to ratePerSecond debug/info records; the next one that gets
+/// through says how many were skipped. Warnings and errors always get
+/// through. A full ring drops the record, it never waits.
+///
+/// Before logInit() (tools, benches) records are formatted and printed on
+/// the spot.
+void logInit(const LogConfig& config);
+/// Writes everything still queued and stops the thread.
+void logShutdown();
+/// Blocks until everything logged so far is written.
+void logFlush();
+LogStats logStats();
+
+/// BSP_LOG_LEVEL (debug/info/warn/error/off) sets both levels,
+/// BSP_LOG_FILE names the file (empty = none), BSP_LOG_RATE the per-site
+/// limit.
+LogConfig logConfigFromEnv();
+
+namespace detail {
+
+enum ArgTag : uint8_t { kArgInt, kArgUint, kArgDouble, kArgString, kArgPointer };
+
+constexpr uint32_t kMaxStringArg = 4096; // longer strings are cut
+
+extern std::atomic<uint8_t> g_minLevel;
+
+/// Space for the arguments of one record, or null if it is filtered,
+/// rate limited or dropped. endRecord() publishes it.
+uint8_t* beginRecord(LogLevel level, LogCategory category, const char* fmt, uint32_t argCount, size_t argBytes);
+void endRecord();
+
+template <class T>
+constexpr bool isString() {
+  using D = std::decay_t<T>;
+  return std::is_same_v<D, const char*> || std::is_same_v<D, char*> || std::is_same_v<D, std::string> ||
+         std::is_same_v<D, std::string_view>;
+}
+
+template <class T>
+std::string_view stringArg(const T& v) {
+  std::string_view s;
+  if constexpr (std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>) {
+    const char* c = v;
+    s = c ? std::string_view(c) : std::string_view("(null)");
+  } else {
+    s = std::string_view(v);
+  }
+  return s.substr(0, kMaxStringArg);
+}
+
+template <class T>
+size_t argBytes(const T& v) {
+  if constexpr (isString<T>()) return 1 + sizeof(uint32_t) + stringArg(v).size();
+  else return 1 + 8;
+}
+
+template <class T>
+void writeNumber(uint8_t*& p, const T& v) {
+  using D = std::decay_t<T>;
+  uint64_t bits = 0;
+  if constexpr (std::is_floating_point_v<D>) {
+    const double d = (double)v;
+    *p = kArgDouble;
+    std::memcpy(&bits, &d, sizeof(d));
+  } else if constexpr (std::is_pointer_v<D>) {
+    *p = kArgPointer;
+    bits = (uint64_t)(uintptr_t)v;
+  } else if constexpr (std::is_enum_v<D>) {
+    *p = kArgInt;
+    bits = (uint64_t)(int64_t)v;
+  } else if constexpr (std::is_signed_v<D>) {
+    static_assert(std::is_integral_v<D>, "log arguments are numbers, pointers or strings");
+    *p = kArgInt;
+    bits = (uint64_t)(int64_t)v;
+  } else {
+    static_assert(std::is_integral_v<D>, "log arguments are numbers, pointers or strings");
+    *p = kArgUint;
+    bits = (uint64_t)v;
+  }
+  std::memcpy(p + 1, &bits, sizeof(bits));
+  p += 1 + sizeof(bits);
+}
+
+template <class T>
+void writeArg(uint8_t*& p, const T& v) {
+  if constexpr (isString<T>()) {
+    const std::string_view s = stringArg(v);
+    const uint32_t n = (uint32_t)s.size();
+    *p++ = kArgString;
+    std::memcpy(p, &n, sizeof(n));
+    std::memcpy(p + sizeof(n), s.data(), n);
+    p += sizeof(n) + n;
+  } else {
+    writeNumber(p, v);
+  }
+}
+
+} // namespace detail
+
+inline bool logEnabled(LogLevel level) {
+  return (uint8_t)level >= detail::g_minLevel.load(std::memory_order_relaxed);
+}
+
+template <class... Args>
+void logWrite(LogLevel level, LogCategory category, const char* fmt, const Args&... args) {
+  if (!logEnabled(level)) return;
+  const size_t bytes = (size_t{ 0 } + ... + detail::argBytes(args));
+  uint8_t* p = detail::beginRecord(level, category, fmt, (uint32_t)sizeof...(Args), bytes);
+  if (!p) return;
+  (detail::writeArg(p, args), ...);
+  detail::endRecord();
+}
+
+template <class... Args>
+void logDebug(LogCategory category, const char* fmt, const Args&... args) {
+  logWrite(LogLevel::Debug, category, fmt, args...);
+}
+template <class... Args>
+void logInfo(LogCategory category, const char* fmt, const Args&... args) {
+  logWrite(LogLevel::Info, category, fmt, args...);
+}
+template <class... Args>
+void logWarn(LogCategory category, const char* fmt, const Args&... args) {
+  logWrite(LogLevel::Warn, category, fmt, args...);
+}
+template <class... Args>
+void logError(LogCategory category, const char* fmt, const Args&... args) {
+  logWrite(LogLevel::Error, category, fmt, args...);
+}
+
+} // namespace core
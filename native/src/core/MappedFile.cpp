@@ -0,0 +1,75 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace core {
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const char* path) {
+  close();
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  m_file = file;
+  m_mapping = mapping;
+  m_data = static_cast<const uint8_t*>(view);
+  m_size = (size_t)size.QuadPart;
+  return true;
+}
+
+void MappedFile::close() {
+  if (m_data) UnmapViewOfFile(m_data);
+  if (m_mapping) CloseHandle(m_mapping);
+  if (m_file) CloseHandle(m_file);
+  m_data = nullptr;
+  m_size = 0;
+  m_mapping = m_file = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const char* path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st {};
+  void* view = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps the file
+  if (view == MAP_FAILED) return false;
+  m_data = static_cast<const uint8_t*>(view);
+  m_size = (size_t)st.st_size;
+  return true;
+}
+
+void MappedFile::close() {
+  if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+  m_data = nullptr;
+  m_size = 0;
+}
+
+#endif
+
+} // namespace core
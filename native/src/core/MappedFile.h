@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+
+/// Read-only view of a whole file, mapped rather than read so large files
+/// are paged in only as they are touched.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile() { close(); }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /// False if the file is missing or empty.
+  bool open(const char* path);
+  void close();
+
+  const uint8_t* data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+private:
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+#if defined(_WIN32)
+  void* m_file = nullptr;
+  void* m_mapping = nullptr;
+#endif
+};
+
+} // namespace core
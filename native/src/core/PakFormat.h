@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+
+namespace core {
+
+/// assets.pak, written by the AssetCompiler tool (native/tools/assets).
+/// Little endian:
+///
+///   PakHeader
+///   PakEntry[entryCount]    sorted by name (byte-wise), for binary search
+///   char names[nameBytes]   not NUL terminated, see nameOffset/nameLength
+///   entry data, each at a 64-byte aligned offset
+///
+/// The file is meant to be read (or mapped) whole; entries are used in
+/// place. Names are '/' separated paths relative to the asset root, with
+/// compiled textures renamed to .btex (see render/TextureFormat.h) and
+/// decoded sounds to .bsnd (see audio/SoundFormat.h).
+struct PakHeader {
+  char magic[4] = { 'B', 'P', 'A', 'K' };
+  uint32_t version = 1;
+  uint32_t entryCount = 0;
+  uint32_t nameBytes = 0;
+  uint64_t dataOffset = 0; // first entry's data
+  uint64_t reserved = 0;
+};
+static_assert(sizeof(PakHeader) == 32, "PakHeader is an on-disk layout");
+
+enum class PakEntryType : uint32_t {
+  Raw = 0,     // copied unchanged (e.g. .lmap)
+  Texture = 1, // render::TextureHeader + BCn levels
+  Sound = 2,   // audio::SoundHeader + PCM
+};
+
+struct PakEntry {
+  uint64_t offset = 0; // from the start of the file
+  uint64_t size = 0;
+  uint64_t sourceHash = 0; // content hash of the source + build settings
+  uint32_t nameOffset = 0; // into names[]
+  uint32_t nameLength = 0;
+  PakEntryType type = PakEntryType::Raw;
+  uint32_t pad = 0;
+};
+static_assert(sizeof(PakEntry) == 40, "PakEntry is an on-disk layout");
+
+constexpr uint32_t kPakVersion = 1;
+constexpr uint32_t kPakAlignment = 64;
+
+} // namespace core
@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace core {
+
+/// Bounded lock-free queue for exactly one producer thread and one consumer
+/// thread. Neither side ever blocks: push() fails when full, pop() when
+/// empty. Each index is written by one side only and sits on its own cache
+/// line; the release store that publishes an index also publishes the slot
+/// written before it.
+template <class T, uint32_t Capacity>
+class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  /// Producer side.
+  bool push(const T& item) {
+    const uint32_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == Capacity) return false;
+    m_items[head & (Capacity - 1)] = item;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer side.
+  bool pop(T& out) {
+    const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    if (m_head.load(std::memory_order_acquire) == tail) return false;
+    out = m_items[tail & (Capacity - 1)];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Either side; a snapshot that may be stale by the time it is used.
+  uint32_t size() const {
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+  }
+
+private:
+  alignas(64) std::atomic<uint32_t> m_head{ 0 }; // next slot to write, producer only
+  alignas(64) std::atomic<uint32_t> m_tail{ 0 }; // next slot to read, consumer only
+  alignas(64) T m_items[Capacity];
+};
+
+} // namespace core
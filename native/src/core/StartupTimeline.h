@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Log.h"
+
+namespace core {
+
+/// Collects [start, end) spans for startup phases so cold start can be read
+/// off one report. Thread-safe; spans may be recorded from worker threads.
+class StartupTimeline {
+public:
+  struct Span {
+    std::string name;
+    std::string thread;
+    double startMs = 0.0;
+    double endMs = 0.0;
+  };
+
+  StartupTimeline() : m_t0(std::chrono::steady_clock::now()) {}
+
+  double nowMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_t0).count();
+  }
+
+  void record(const char* name, double startMs, double endMs, const char* thread = "main") {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_spans.push_back(Span{ name ? name : "?", thread ? thread : "?", startMs, endMs });
+  }
+
+  /// RAII span on the calling thread.
+  class Scope {
+  public:
+    Scope(StartupTimeline& tl, const char* name, const char* thread = "main")
+      : m_tl(tl), m_name(name), m_thread(thread), m_start(tl.nowMs()) {}
+    ~Scope() { m_tl.record(m_name, m_start, m_tl.nowMs(), m_thread); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  private:
+    StartupTimeline& m_tl;
+    const char* m_name;
+    const char* m_thread;
+    double m_start;
+  };
+
+  void print() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_spans.empty()) return;
+
+    std::vector<Span> spans = m_spans;
+    std::sort(spans.begin(), spans.end(),
+              [](const Span& a, const Span& b) { return a.startMs < b.startMs; });
+
+    double total = 0.0;
+    for (const auto& s : spans) total = std::max(total, s.endMs);
+
+    const int kBarWidth = 40;
+    logInfo(LogCategory::Engine, "Startup timeline (%.1f ms total):", total);
+    for (const auto& s : spans) {
+      char bar[kBarWidth + 1];
+      int b0 = total > 0.0 ? (int)(s.startMs / total * kBarWidth) : 0;
+      int b1 = total > 0.0 ? (int)(s.endMs / total * kBarWidth + 0.999) : 0;
+      for (int i = 0; i < kBarWidth; ++i) bar[i] = (i >= b0 && i < b1) ? '#' : '.';
+      bar[kBarWidth] = '\0';
+      logInfo(LogCategory::Engine, "  %-18s %-9s %8.1f %8.1f %8.1f ms |%s|", s.name.c_str(), s.thread.c_str(),
+              s.startMs, s.endMs, s.endMs - s.startMs, bar);
+    }
+  }
+
+private:
+  std::chrono::steady_clock::time_point m_t0;
+  mutable std::mutex m_mutex;
+  std::vector<Span> m_spans;
+};
+
+} // namespace core
@@ -0,0 +1,96 @@
+#include "TaskGraph.h"
+#include "JobSystem.h"
+#include "StartupTimeline.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace core {
+
+TaskGraph::TaskId TaskGraph::add(const char* name, std::function<void()> fn,
+                                 std::initializer_list<TaskId> deps, Affinity affinity) {
+  TaskId id = (TaskId)m_tasks.size();
+  Task t{};
+  t.name = name ? name : "?";
+  t.fn = std::move(fn);
+  t.affinity = affinity;
+  for (TaskId d : deps) {
+    if (d >= id) continue; // deps must already exist, keeps the graph acyclic
+    m_tasks[d].dependents.push_back(id);
+    t.pendingDeps++;
+  }
+  m_tasks.push_back(std::move(t));
+  return id;
+}
+
+void TaskGraph::run(JobSystem& jobs, StartupTimeline* timeline) {
+  if (m_tasks.empty()) return;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<TaskId> readyMain;
+  size_t finished = 0;
+
+  // Called outside the mutex: JobSystem::run may execute inline (pool not
+  // started, deque full), which re-enters execute().
+  std::function<void(TaskId)> execute;
+  auto release = [&](const std::vector<TaskId>& ids) {
+    for (TaskId id : ids) {
+      if (m_tasks[id].affinity == Affinity::Main) {
+        std::lock_guard<std::mutex> lock(mutex);
+        readyMain.push_back(id);
+        cv.notify_all();
+      } else {
+        jobs.run([&execute, id] { execute(id); });
+      }
+    }
+  };
+
+  execute = [&](TaskId id) {
+    Task& t = m_tasks[id];
+    double start = timeline ? timeline->nowMs() : 0.0;
+    if (t.fn) t.fn();
+    if (timeline) {
+      int slot = JobSystem::threadIndex();
+      std::string thread = slot <= 0 ? "main" : "worker" + std::to_string(slot);
+      timeline->record(t.name.c_str(), start, timeline->nowMs(), thread.c_str());
+    }
+
+    std::vector<TaskId> ready;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (TaskId d : t.dependents) {
+        if (--m_tasks[d].pendingDeps == 0) ready.push_back(d);
+      }
+    }
+    release(ready);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    finished++;
+    cv.notify_all();
+  };
+
+  std::vector<TaskId> roots;
+  for (TaskId i = 0; i < (TaskId)m_tasks.size(); ++i) {
+    if (m_tasks[i].pendingDeps == 0) roots.push_back(i);
+  }
+  release(roots);
+
+  for (;;) {
+    TaskId id = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] { return !readyMain.empty() || finished == m_tasks.size(); });
+      if (readyMain.empty()) break;
+      id = readyMain.front();
+      readyMain.pop_front();
+    }
+    execute(id);
+  }
+
+  m_tasks.clear();
+}
+
+} // namespace core
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace core {
+
+class JobSystem;
+class StartupTimeline;
+
+/// Tiny one-shot dependency graph for coarse startup work.
+///
+/// Tasks become ready once all their dependencies finished. Affinity::Main
+/// tasks run on the thread that calls run() (things bound to the creating
+/// thread: the Win32 window, the Python interpreter); everything else is
+/// scheduled on the shared JobSystem.
+class TaskGraph {
+public:
+  using TaskId = uint32_t;
+  enum class Affinity { Any, Main };
+
+  TaskId add(const char* name, std::function<void()> fn,
+             std::initializer_list<TaskId> deps = {}, Affinity affinity = Affinity::Any);
+
+  /// Executes the whole graph and returns when every task finished.
+  /// If a timeline is given, each task is recorded as a span.
+  void run(JobSystem& jobs, StartupTimeline* timeline = nullptr);
+
+private:
+  struct Task {
+    std::string name;
+    std::function<void()> fn;
+    Affinity affinity = Affinity::Any;
+    uint32_t pendingDeps = 0;
+    std::vector<TaskId> dependents;
+  };
+
+  std::vector<Task> m_tasks;
+};
+
+} // namespace core
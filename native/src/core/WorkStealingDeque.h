@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+
+/// Fixed-capacity Chase-Lev deque (Le et al., "Correct and Efficient
+/// Work-Stealing for Weak Memory Models", 2013).
+///
+/// The owning thread push()es and pop()s at the bottom (LIFO, cache-warm);
+/// any other thread may steal() from the top (FIFO, oldest = biggest work).
+/// T must be a pointer-like type where nullptr means "nothing".
+template <class T, size_t Capacity>
+class WorkStealingDeque {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  /// Owner only. Returns false when full; the caller should run the item inline.
+  bool push(T item) {
+    int64_t b = m_bottom.load(std::memory_order_relaxed);
+    int64_t t = m_top.load(std::memory_order_acquire);
+    if (b - t >= (int64_t)Capacity) return false;
+
+    m_items[b & kMask].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /// Owner only.
+  T pop() {
+    int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = m_top.load(std::memory_order_relaxed);
+
+    if (t > b) { // empty
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    T item = m_items[b & kMask].load(std::memory_order_relaxed);
+    if (t == b) {
+      // Last item: race thieves for it.
+      if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  /// Any thread.
+  T steal() {
+    int64_t t = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = m_bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+
+    T item = m_items[t & kMask].load(std::memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return nullptr; // lost to the owner or another thief
+    }
+    return item;
+  }
+
+  /// Approximate; only meaningful as a scheduling hint.
+  size_t sizeHint() const {
+    int64_t b = m_bottom.load(std::memory_order_relaxed);
+    int64_t t = m_top.load(std::memory_order_relaxed);
+    return b > t ? (size_t)(b - t) : 0;
+  }
+
+private:
+  static constexpr int64_t kMask = (int64_t)Capacity - 1;
+
+  alignas(64) std::atomic<int64_t> m_top{0};
+  alignas(64) std::atomic<int64_t> m_bottom{0};
+  alignas(64) std::atomic<T> m_items[Capacity]{};
+};
+
+} // namespace core
@@ -6,16 +6,41 @@
 #define VK_USE_PLATFORM_WIN32_KHR
 #include <vulkan/vulkan.h>
 
-#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
 #include <vector>
 #include <algorithm>
-#include <fstream>
+#include <atomic>
+#include <memory>
 
 #include "scripting/PythonHost.h"
 #include "scripting/EngineModule.h"
 #include "input/InputState.h"
+#include "core/JobSystem.h"
+#include "core/TaskGraph.h"
+#include "memory/FrameArenas.h"
+#include "memory/MemoryTracker.h"
+#include "core/StartupTimeline.h"
+#include "render/VkUtil.h"
+#include "render/Camera.h"
+#include "render/Lights.h"
+#include "render/ClusteredLighting.h"
+#include "render/ParticleSystem.h"
+#include "render/Decals.h"
+#include "render/StaticWorld.h"
+#include "render/HiZPyramid.h"
+#include "render/PostProcess.h"
+#include "render/DynamicResolution.h"
+#include "render/ShadowAtlas.h"
+#include "physics/PhysicsWorld.h"
+#include "physics/TriggerSystem.h"
+#include "anim/AnimationSystem.h"
+#include "nav/NavSystem.h"
+#include "save/SaveSystem.h"
+#include "core/AssetPak.h"
+#include "audio/AudioSystem.h"
+#include "core/Log.h"
 
 static const char* kAppName = "BSP Engine Host";
 static bool g_framebufferResized = false;
@@ -24,6 +49,28 @@ static input::InputState g_input{};
 static bool g_requestQuit = false;
 static scripting::PythonHost* g_pyHost = nullptr;
 static scripting::PythonHost g_py{};
+static core::JobSystem g_jobs{};
+static memory::FrameArenas g_frameMem{};
+
+static render::Camera g_camera{};
+static render::LightList g_lights{};
+static render::ClusteredLighting g_lighting{};
+static render::ParticleSystem g_particles{};
+static render::DecalSystem g_decals{};
+static render::StaticWorld g_world{};
+static render::HiZPyramid g_hiz{};
+static render::PostProcess g_post{};
+static render::DynamicResolution g_resolution{};
+static render::ShadowAtlas g_shadows{};
+static physics::PhysicsWorld g_physics{};
+static physics::TriggerSystem g_triggers{};
+static anim::AnimationSystem g_anim{};
+static nav::NavSystem g_nav{};
+static save::SaveSystem g_save{};
+static core::AssetPak g_assets{};
+static audio::AudioSystem g_audio{};
+
+using render::vkcheck;
 
 // --------------------- Working directory fix ---------------------
 static bool file_exists(const std::string& p) {
@@ -53,16 +100,41 @@ static void set_working_dir_to_project_root() {
     std::string shaderProbe = dir + "\\shaders\\triangle.vert.spv";
     if (file_exists(shaderProbe)) {
       SetCurrentDirectoryA(dir.c_str());
-      std::printf("[INFO] CWD set to project root: %s\n", dir.c_str());
+      core::logInfo(core::LogCategory::Engine, "CWD set to project root: %s", dir.c_str());
       return;
     }
     dir = parent_dir(dir);
   }
 }
 
+// assets.pak is copied next to Game.exe by the build; CWD is the fallback.
+static void open_asset_pak() {
+  char exePath[MAX_PATH]{};
+  DWORD n = GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+  if (n > 0 && n < MAX_PATH) {
+    std::string p = parent_dir(std::string(exePath)) + "\\assets.pak";
+    if (file_exists(p) && g_assets.open(p.c_str())) return;
+  }
+  if (file_exists("assets.pak")) g_assets.open("assets.pak");
+}
+
+// BSP_AUDIO=0 mixes into nothing (paced like a device), BSP_AUDIO_WAV=<path>
+// records the mix to a WAV file instead of playing it.
+static std::unique_ptr<audio::AudioBackend> audio_backend_from_env() {
+  if (const char* v = std::getenv("BSP_AUDIO_WAV")) {
+    if (v[0]) return audio::createWavBackend(v, true);
+  }
+  if (const char* v = std::getenv("BSP_AUDIO")) {
+    if (v[0] == '0') return audio::createNullBackend(true);
+  }
+  return audio::createDeviceBackend();
+}
+
 // --------------------- logging ---------------------
-static void logi(const char* msg) { std::printf("[INFO] %s\n", msg); }
-static void loge(const char* msg) { std::printf("[ERR ] %s\n", msg); }
+// The message is the format string, so every call site gets its own rate
+// limit; "" msg only compiles for a literal.
+#define logi(msg) core::logInfo(core::LogCategory::Engine, "" msg)
+#define loge(msg) core::logError(core::LogCategory::Engine, "" msg)
 
 // --------------------- Win32 window ---------------------
 static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -148,11 +220,12 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(
   const VkDebugUtilsMessengerCallbackDataEXT* cb,
   void*
 ) {
-  const char* prefix =
-    (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)   ? "[VULKAN][ERR]" :
-    (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) ? "[VULKAN][WRN]" :
-    "[VULKAN][INF]";
-  std::printf("%s %s\n", prefix, cb->pMessage);
+  // Drivers call this from their own threads too; the logger is fine with that.
+  const core::LogLevel level =
+    (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)   ? core::LogLevel::Error :
+    (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) ? core::LogLevel::Warn :
+    core::LogLevel::Info;
+  core::logWrite(level, core::LogCategory::Render, "Vulkan: %s", cb->pMessage);
   return VK_FALSE;
 }
 
@@ -183,55 +256,65 @@ static bool has_layer(const char* name) {
   return false;
 }
 
-static void vkcheck(VkResult r, const char* where) {
-  if (r != VK_SUCCESS) {
-    std::printf("[VKERR] %s failed (%d)\n", where, (int)r);
-    std::exit(1);
-  }
-}
-
 struct Queues {
   uint32_t graphicsIndex = UINT32_MAX;
   uint32_t presentIndex  = UINT32_MAX;
 };
 
-static std::vector<uint32_t> read_spv(const char* path) {
-  std::ifstream file(path, std::ios::ate | std::ios::binary);
-  if (!file.is_open()) {
-    std::printf("[ERR ] Failed to open %s\n", path);
-    std::exit(1);
-  }
-  size_t size = (size_t)file.tellg();
-  if (size % 4 != 0) {
-    std::printf("[ERR ] %s size not multiple of 4\n", path);
-    std::exit(1);
+static VkSurfaceFormatKHR choose_surface_format(VkPhysicalDevice physical, VkSurfaceKHR surface) {
+  uint32_t fmtCount = 0;
+  vkcheck(vkGetPhysicalDeviceSurfaceFormatsKHR(physical, surface, &fmtCount, nullptr),
+          "vkGetPhysicalDeviceSurfaceFormatsKHR(count)");
+  std::vector<VkSurfaceFormatKHR> formats(fmtCount);
+  vkcheck(vkGetPhysicalDeviceSurfaceFormatsKHR(physical, surface, &fmtCount, formats.data()),
+          "vkGetPhysicalDeviceSurfaceFormatsKHR(list)");
+
+  VkSurfaceFormatKHR chosen = formats[0];
+  for (auto& f : formats) {
+    if (f.format == VK_FORMAT_B8G8R8A8_SRGB &&
+        f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+      chosen = f;
+      break;
+    }
   }
-  std::vector<uint32_t> data(size / 4);
-  file.seekg(0);
-  file.read(reinterpret_cast<char*>(data.data()), size);
-  file.close();
-  return data;
-}
-
-static VkShaderModule create_shader_module(VkDevice device, const char* path) {
-  auto code = read_spv(path);
-  VkShaderModuleCreateInfo smci{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-  smci.codeSize = code.size() * sizeof(uint32_t);
-  smci.pCode = code.data();
-
-  VkShaderModule module = VK_NULL_HANDLE;
-  vkcheck(vkCreateShaderModule(device, &smci, nullptr, &module), "vkCreateShaderModule");
-  return module;
+  return chosen;
 }
 
 int main() {
+  core::StartupTimeline timeline;
   HINSTANCE hInstance = GetModuleHandle(nullptr);
+  // Console and game.log are written from a background thread from here on.
+  core::logInit(core::logConfigFromEnv());
   logi("Starting host...");
 
+  // Subsystem budgets, before anything allocates; like the frame budget
+  // they only warn. Render is CPU side only, GPU memory is not tracked.
+  memory::setBudget(memory::MemTag::Scripting, 64 * 1024 * 1024);
+  memory::setBudget(memory::MemTag::Render, 16 * 1024 * 1024);
+  memory::setBudget(memory::MemTag::Physics, 32 * 1024 * 1024);
+  memory::setBudget(memory::MemTag::Animation, 16 * 1024 * 1024);
+  memory::setBudget(memory::MemTag::Audio, 4 * 1024 * 1024);
+  memory::setBudget(memory::MemTag::Navigation, 16 * 1024 * 1024);
+  memory::setBudget(memory::MemTag::Assets, 512 * 1024 * 1024);
+
   // Ensure relative paths like shaders/* work regardless of where the exe is started from.
   set_working_dir_to_project_root();
 
-  HWND hwnd = create_window(hInstance, 1280, 720);
+  // Shared scheduler for everything that fans out (startup, and later culling,
+  // animation, physics, asset decode, command recording). Main thread = slot 0.
+  g_jobs.init();
+  g_physics.init(g_jobs);
+  g_triggers.init();
+  g_nav.init(g_jobs);
+  g_save.init({ &g_camera, &g_lights, &g_physics, &g_triggers });
+  open_asset_pak();
+  g_audio.init(g_assets.isOpen() ? &g_assets : nullptr, audio_backend_from_env());
+
+  HWND hwnd = nullptr;
+  {
+    core::StartupTimeline::Scope span(timeline, "window");
+    hwnd = create_window(hInstance, 1280, 720);
+  }
   if (!hwnd) return 1;
   logi("Window created.");
 
@@ -241,168 +324,75 @@ int main() {
   ectx.hwnd = hwnd;
   ectx.input = &g_input;
   ectx.requestQuit = &g_requestQuit;
+  ectx.camera = &g_camera;
+  ectx.lights = &g_lights;
+  ectx.particles = &g_particles;
+  ectx.decals = &g_decals;
+  ectx.world = &g_world;
+  ectx.post = &g_post;
+  ectx.resolution = &g_resolution;
+  ectx.shadows = &g_shadows;
+  ectx.nav = &g_nav;
+  ectx.triggers = &g_triggers;
+  ectx.save = &g_save;
+  ectx.audio = &g_audio;
+  ectx.jobs = &g_jobs;
+  ectx.behaviors = &g_py.behaviors();
   scripting::SetEngineContext(ectx);
 
-  // Assumes you set PYTHONPATH to include the project's /python folder.
-  // Example in PowerShell: $env:PYTHONPATH="$PSScriptRoot\python"
-  if (!g_py.init("game")) {
-    loge("Python init failed (module 'game' not found?)");
-  } else {
-    g_py.callEvent("start", 0, 0, 0);
-  }
-
-  // ---- Instance ----
-  bool enableValidation = has_layer("VK_LAYER_KHRONOS_validation");
-  if (enableValidation) logi("Validation layer available -> enabling.");
-  else logi("Validation layer not found -> running without validation.");
-
-  std::vector<const char*> layers;
-  if (enableValidation) layers.push_back("VK_LAYER_KHRONOS_validation");
-
-  std::vector<const char*> exts;
-  exts.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
-  exts.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
-  if (enableValidation) exts.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-
-  VkApplicationInfo appInfo{ VK_STRUCTURE_TYPE_APPLICATION_INFO };
-  appInfo.pApplicationName = kAppName;
-  appInfo.applicationVersion = VK_MAKE_VERSION(0, 1, 0);
-  appInfo.pEngineName = "BSP-Engine";
-  appInfo.engineVersion = VK_MAKE_VERSION(0, 1, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_2;
-
-  VkInstanceCreateInfo ici{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
-  ici.pApplicationInfo = &appInfo;
-  ici.enabledLayerCount = (uint32_t)layers.size();
-  ici.ppEnabledLayerNames = layers.empty() ? nullptr : layers.data();
-  ici.enabledExtensionCount = (uint32_t)exts.size();
-  ici.ppEnabledExtensionNames = exts.data();
-
-  VkDebugUtilsMessengerCreateInfoEXT debugCI{ VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT };
-  if (enableValidation) {
-    debugCI.messageSeverity =
-      VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
-      VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
-      VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
-      VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-    debugCI.messageType =
-      VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
-      VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
-      VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-    debugCI.pfnUserCallback = debug_callback;
-    ici.pNext = &debugCI;
-  }
-
+  // ---- Vulkan core objects (filled in by the startup graph) ----
   VkInstance instance = VK_NULL_HANDLE;
-  vkcheck(vkCreateInstance(&ici, nullptr, &instance), "vkCreateInstance");
-  logi("Vulkan instance created.");
-
   VkDebugUtilsMessengerEXT dbg = VK_NULL_HANDLE;
-  if (enableValidation) {
-    if (create_debug_messenger(instance, &debugCI, &dbg) == VK_SUCCESS) {
-      logi("Debug messenger created.");
-    } else {
-      loge("Debug messenger creation failed (continuing).");
-    }
-  }
-
-  // ---- Surface ----
-  VkWin32SurfaceCreateInfoKHR win32SurfaceCI{ VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR };
-  win32SurfaceCI.hinstance = hInstance;
-  win32SurfaceCI.hwnd = hwnd;
-
   VkSurfaceKHR surface = VK_NULL_HANDLE;
-  vkcheck(vkCreateWin32SurfaceKHR(instance, &win32SurfaceCI, nullptr, &surface),
-          "vkCreateWin32SurfaceKHR");
-  logi("Win32 surface created.");
-
-  // ---- Physical device + queues ----
-  uint32_t physCount = 0;
-  vkcheck(vkEnumeratePhysicalDevices(instance, &physCount, nullptr),
-          "vkEnumeratePhysicalDevices(count)");
-  if (physCount == 0) {
-    loge("No Vulkan devices found.");
-    return 4;
-  }
-
-  std::vector<VkPhysicalDevice> physDevices(physCount);
-  vkcheck(vkEnumeratePhysicalDevices(instance, &physCount, physDevices.data()),
-          "vkEnumeratePhysicalDevices(list)");
-
-  VkPhysicalDevice physical = physDevices[0];
-
-  VkPhysicalDeviceProperties gpuProps{};
-  vkGetPhysicalDeviceProperties(physical, &gpuProps);
-  std::printf("Using GPU: %s\n", gpuProps.deviceName);
-
-  uint32_t qCount = 0;
-  vkGetPhysicalDeviceQueueFamilyProperties(physical, &qCount, nullptr);
-  std::vector<VkQueueFamilyProperties> qProps(qCount);
-  vkGetPhysicalDeviceQueueFamilyProperties(physical, &qCount, qProps.data());
-
+  VkPhysicalDevice physical = VK_NULL_HANDLE;
   Queues queues{};
-  for (uint32_t i = 0; i < qCount; ++i) {
-    if (qProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-      queues.graphicsIndex = i;
-    }
-    VkBool32 present = VK_FALSE;
-    vkcheck(vkGetPhysicalDeviceSurfaceSupportKHR(physical, i, surface, &present),
-            "vkGetPhysicalDeviceSurfaceSupportKHR");
-    if (present) queues.presentIndex = i;
-  }
-
-  if (queues.graphicsIndex == UINT32_MAX || queues.presentIndex == UINT32_MAX) {
-    loge("Required queue families not found.");
-    return 5;
-  }
-
-  // ---- Device ----
-  float priority = 1.0f;
-
-  std::vector<uint32_t> uniqueQueues = { queues.graphicsIndex };
-  if (queues.presentIndex != queues.graphicsIndex)
-    uniqueQueues.push_back(queues.presentIndex);
-
-  std::vector<VkDeviceQueueCreateInfo> queueInfos;
-  for (uint32_t idx : uniqueQueues) {
-    VkDeviceQueueCreateInfo qci{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
-    qci.queueFamilyIndex = idx;
-    qci.queueCount = 1;
-    qci.pQueuePriorities = &priority;
-    queueInfos.push_back(qci);
-  }
-
-  const char* deviceExts[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
-
-  VkDeviceCreateInfo dci{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-  dci.queueCreateInfoCount = (uint32_t)queueInfos.size();
-  dci.pQueueCreateInfos = queueInfos.data();
-  dci.enabledExtensionCount = 1;
-  dci.ppEnabledExtensionNames = deviceExts;
-
   VkDevice device = VK_NULL_HANDLE;
-  vkcheck(vkCreateDevice(physical, &dci, nullptr, &device), "vkCreateDevice");
-  logi("Logical device created.");
-
   VkQueue graphicsQueue = VK_NULL_HANDLE;
   VkQueue presentQueue  = VK_NULL_HANDLE;
-  vkGetDeviceQueue(device, queues.graphicsIndex, 0, &graphicsQueue);
-  vkGetDeviceQueue(device, queues.presentIndex, 0, &presentQueue);
+  render::GpuContext gpu{}; // filled once the device exists
+  VkPhysicalDeviceFeatures deviceFeatures{}; // enabled at device creation
+  bool drawIndirectCount = false;
+
+  // SPIR-V stays resident so format-change pipeline rebuilds skip the disk.
+  std::vector<uint32_t> vertSpv;
+  std::vector<uint32_t> fragSpv;
+
+  // Startup tasks on job workers must not exit the process (the static
+  // JobSystem would join the exiting worker); they log, set this and return.
+  std::atomic<int> startupError{0};
+  auto startupCheck = [&](VkResult res, const char* where) {
+    if (render::vkok(res, where)) return true;
+    startupError = 6;
+    return false;
+  };
 
-  // ---- RenderPass/Pipeline (created once we know swapchain format) ----
+  // ---- RenderPass/Pipeline ----
+  // Two compatible passes over the same HDR framebuffer: the early one
+  // clears and draws the static world's early phase (the Hi-Z pyramid is
+  // built from its depth), the main one loads and draws everything else.
+  // PostProcess resolves the result into the swapchain image; only its
+  // output pass depends on the swapchain format.
+  VkRenderPass earlyPass = VK_NULL_HANDLE;
   VkRenderPass renderPass = VK_NULL_HANDLE;
   VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
   VkPipeline pipeline = VK_NULL_HANDLE;
+  VkFormat currentFormat = VK_FORMAT_UNDEFINED; // swapchain format the post output pass is built for
+  VkFormat depthFormat = VK_FORMAT_UNDEFINED;
 
   // ---- Swapchain dependent resources ----
   VkSwapchainKHR swapchain = VK_NULL_HANDLE;
   VkExtent2D extent{};
+  VkExtent2D renderExtent{}; // top-left part of the scene targets rendered this frame
   VkSurfaceFormatKHR surfaceFormat{};
-  VkFormat currentFormat = VK_FORMAT_UNDEFINED;
 
   uint32_t scImgCount = 0;
   std::vector<VkImageView> swapViews;
-  std::vector<VkFramebuffer> framebuffers;
+  std::vector<VkFramebuffer> framebuffers; // post output, per swapchain image
+  VkFramebuffer sceneFramebuffer = VK_NULL_HANDLE; // HDR color + depth
+  // One depth buffer shared by all frames (the queue serializes them). It
+  // ends the pass read-only so next frame's particle pass can sample it.
+  render::GpuImage depth{};
+  bool depthFresh = false; // still UNDEFINED, cleared on first use
 
   VkCommandPool cmdPool = VK_NULL_HANDLE;
   std::vector<VkCommandBuffer> cmdBufs;
@@ -413,18 +403,11 @@ int main() {
   std::vector<VkFence> inFlight(MAX_FRAMES);
   std::vector<VkSemaphore> renderFinished; // per swapchain image
 
-  {
-    VkSemaphoreCreateInfo semCI{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
-    VkFenceCreateInfo fenceCI{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
-    fenceCI.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for (uint32_t i = 0; i < MAX_FRAMES; ++i) {
-      vkcheck(vkCreateSemaphore(device, &semCI, nullptr, &imageAvailable[i]),
-              "vkCreateSemaphore(imageAvailable)");
-      vkcheck(vkCreateFence(device, &fenceCI, nullptr, &inFlight[i]),
-              "vkCreateFence(inFlight)");
-    }
-  }
+  // Per-frame scratch: one arena per (frame in flight, job thread), reset
+  // once that frame's fence has signalled. Budgets only warn.
+  g_frameMem.init(MAX_FRAMES, g_jobs.threadCount(), 256 * 1024);
+  g_frameMem.setFrameBudget(2 * 1024 * 1024);
+  memory::setBudget(memory::MemTag::Core, 4 * 1024 * 1024);
 
   auto destroy_pipeline = [&]() {
     if (pipeline != VK_NULL_HANDLE) {
@@ -442,49 +425,100 @@ int main() {
       vkDestroyRenderPass(device, renderPass, nullptr);
       renderPass = VK_NULL_HANDLE;
     }
+    if (earlyPass != VK_NULL_HANDLE) {
+      vkDestroyRenderPass(device, earlyPass, nullptr);
+      earlyPass = VK_NULL_HANDLE;
+    }
   };
 
-  auto create_renderpass = [&](VkFormat fmt) {
+  auto make_renderpass = [&](VkFormat fmt, bool early) {
     VkAttachmentDescription color{};
     color.format = fmt;
     color.samples = VK_SAMPLE_COUNT_1_BIT;
-    color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color.loadOp = early ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
     color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    color.initialLayout = early ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color.finalLayout = early ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    // Both passes leave depth read-only: the pyramid build samples the
+    // early pass's, next frame's particles the main pass's.
+    VkAttachmentDescription depthAtt{};
+    depthAtt.format = depthFormat;
+    depthAtt.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAtt.loadOp = early ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+    depthAtt.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    depthAtt.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAtt.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAtt.initialLayout = early ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    depthAtt.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
     VkAttachmentReference colorRef{};
     colorRef.attachment = 0;
     colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+    VkAttachmentReference depthRef{};
+    depthRef.attachment = 1;
+    depthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorRef;
-
-    VkSubpassDependency dep{};
-    dep.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dep.dstSubpass = 0;
-    dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
+    subpass.pDepthStencilAttachment = &depthRef;
+
+    VkSubpassDependency deps[2]{};
+    // In: earlier color/depth writes (previous frame, or the early pass) and
+    // compute/post reads of the color and depth buffers must finish before
+    // this pass.
+    deps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    deps[0].dstSubpass = 0;
+    deps[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    deps[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    deps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                           VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    deps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    // Out: depth becomes readable by compute (pyramid build, particles), and
+    // color and depth by post (bloom in compute, the resolve's fragments).
+    deps[1].srcSubpass = 0;
+    deps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    deps[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    deps[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    deps[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    VkAttachmentDescription attachments[] = { color, depthAtt };
     VkRenderPassCreateInfo rpci{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
-    rpci.attachmentCount = 1;
-    rpci.pAttachments = &color;
+    rpci.attachmentCount = 2;
+    rpci.pAttachments = attachments;
     rpci.subpassCount = 1;
     rpci.pSubpasses = &subpass;
-    rpci.dependencyCount = 1;
-    rpci.pDependencies = &dep;
+    rpci.dependencyCount = 2;
+    rpci.pDependencies = deps;
 
-    vkcheck(vkCreateRenderPass(device, &rpci, nullptr, &renderPass), "vkCreateRenderPass");
+    VkRenderPass pass = VK_NULL_HANDLE;
+    startupCheck(vkCreateRenderPass(device, &rpci, nullptr, &pass),
+                 early ? "vkCreateRenderPass(early)" : "vkCreateRenderPass");
+    return pass;
+  };
+
+  // Startup only (a job worker): failures go to startupError.
+  auto create_renderpass = [&]() {
+    earlyPass = make_renderpass(render::PostProcess::kHdrFormat, true);
+    renderPass = make_renderpass(render::PostProcess::kHdrFormat, false);
+    return earlyPass != VK_NULL_HANDLE && renderPass != VK_NULL_HANDLE;
   };
 
   auto create_pipeline = [&]() {
-    VkShaderModule vert = create_shader_module(device, "shaders/triangle.vert.spv");
-    VkShaderModule frag = create_shader_module(device, "shaders/triangle.frag.spv");
+    if (vertSpv.empty() || fragSpv.empty()) {
+      startupError = 6;
+      return false;
+    }
+    VkShaderModule vert = render::createShaderModule(device, vertSpv);
+    VkShaderModule frag = render::createShaderModule(device, fragSpv);
 
     VkPipelineShaderStageCreateInfo vs{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
     vs.stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -518,6 +552,11 @@ int main() {
     VkPipelineMultisampleStateCreateInfo ms{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
     ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
+    VkPipelineDepthStencilStateCreateInfo dss{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+    dss.depthTestEnable = VK_TRUE;
+    dss.depthWriteEnable = VK_TRUE;
+    dss.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
     VkPipelineColorBlendAttachmentState cba{};
     cba.colorWriteMask =
       VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
@@ -536,8 +575,8 @@ int main() {
     ds.pDynamicStates = dynStates;
 
     VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-    vkcheck(vkCreatePipelineLayout(device, &plci, nullptr, &pipelineLayout),
-            "vkCreatePipelineLayout");
+    bool ok = startupCheck(vkCreatePipelineLayout(device, &plci, nullptr, &pipelineLayout),
+                           "vkCreatePipelineLayout");
 
     VkGraphicsPipelineCreateInfo gpci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
     gpci.stageCount = 2;
@@ -547,17 +586,31 @@ int main() {
     gpci.pViewportState = &vps;
     gpci.pRasterizationState = &rs;
     gpci.pMultisampleState = &ms;
+    gpci.pDepthStencilState = &dss;
     gpci.pColorBlendState = &cbs;
     gpci.pDynamicState = &ds;
     gpci.layout = pipelineLayout;
     gpci.renderPass = renderPass;
     gpci.subpass = 0;
 
-    vkcheck(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gpci, nullptr, &pipeline),
-            "vkCreateGraphicsPipelines");
+    ok = ok && startupCheck(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gpci, nullptr, &pipeline),
+                            "vkCreateGraphicsPipelines");
 
     vkDestroyShaderModule(device, frag, nullptr);
     vkDestroyShaderModule(device, vert, nullptr);
+    return ok;
+  };
+
+  // Dynamic resolution: the scene targets keep the swapchain's size and a
+  // frame renders to their top-left part; everything that covers the screen
+  // is told how much of it.
+  auto apply_render_extent = [&]() {
+    renderExtent = g_resolution.renderExtent(extent);
+    g_lighting.setViewport(renderExtent.width, renderExtent.height);
+    g_world.setViewport(renderExtent.width, renderExtent.height);
+    g_particles.setRenderSize(renderExtent.width, renderExtent.height);
+    g_hiz.setRegion(renderExtent.width, renderExtent.height);
+    g_post.setRenderSize(renderExtent.width, renderExtent.height);
   };
 
   auto cleanup_swapchain_deps = [&]() {
@@ -569,10 +622,16 @@ int main() {
 
     for (auto fb : framebuffers) vkDestroyFramebuffer(device, fb, nullptr);
     framebuffers.clear();
+    if (sceneFramebuffer != VK_NULL_HANDLE) {
+      vkDestroyFramebuffer(device, sceneFramebuffer, nullptr);
+      sceneFramebuffer = VK_NULL_HANDLE;
+    }
 
     for (auto v : swapViews) vkDestroyImageView(device, v, nullptr);
     swapViews.clear();
 
+    render::destroyImage(gpu, depth);
+
     if (!renderFinished.empty()) {
       for (auto s : renderFinished) vkDestroySemaphore(device, s, nullptr);
       renderFinished.clear();
@@ -595,32 +654,22 @@ int main() {
       return false; // minimized
     }
 
-    uint32_t fmtCount = 0;
-    vkcheck(vkGetPhysicalDeviceSurfaceFormatsKHR(physical, surface, &fmtCount, nullptr),
-            "vkGetPhysicalDeviceSurfaceFormatsKHR(count)");
-    std::vector<VkSurfaceFormatKHR> formats(fmtCount);
-    vkcheck(vkGetPhysicalDeviceSurfaceFormatsKHR(physical, surface, &fmtCount, formats.data()),
-            "vkGetPhysicalDeviceSurfaceFormatsKHR(list)");
+    // Query arrays are scratch on the main thread's frame arena; the scope
+    // rewinds it on return.
+    memory::ScratchScope scratch(*g_frameMem.local());
 
     uint32_t pmCount = 0;
     vkcheck(vkGetPhysicalDeviceSurfacePresentModesKHR(physical, surface, &pmCount, nullptr),
             "vkGetPhysicalDeviceSurfacePresentModesKHR(count)");
-    std::vector<VkPresentModeKHR> presentModes(pmCount);
-    vkcheck(vkGetPhysicalDeviceSurfacePresentModesKHR(physical, surface, &pmCount, presentModes.data()),
+    VkPresentModeKHR* presentModes = scratch.allocArray<VkPresentModeKHR>(pmCount);
+    vkcheck(vkGetPhysicalDeviceSurfacePresentModesKHR(physical, surface, &pmCount, presentModes),
             "vkGetPhysicalDeviceSurfacePresentModesKHR(list)");
 
-    surfaceFormat = formats[0];
-    for (auto& f : formats) {
-      if (f.format == VK_FORMAT_B8G8R8A8_SRGB &&
-          f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-        surfaceFormat = f;
-        break;
-      }
-    }
+    surfaceFormat = choose_surface_format(physical, surface);
 
     VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    for (auto pm : presentModes) {
-      if (pm == VK_PRESENT_MODE_MAILBOX_KHR) { presentMode = pm; break; }
+    for (uint32_t i = 0; i < pmCount; ++i) {
+      if (presentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR) { presentMode = presentModes[i]; break; }
     }
 
     extent = caps.currentExtent;
@@ -659,8 +708,8 @@ int main() {
             "vkGetSwapchainImagesKHR(count)");
     scImgCount = imgCount;
 
-    std::vector<VkImage> swapImages(scImgCount);
-    vkcheck(vkGetSwapchainImagesKHR(device, swapchain, &imgCount, swapImages.data()),
+    VkImage* swapImages = scratch.allocArray<VkImage>(scImgCount);
+    vkcheck(vkGetSwapchainImagesKHR(device, swapchain, &imgCount, swapImages),
             "vkGetSwapchainImagesKHR(list)");
 
     // semaphores per swapchain image
@@ -673,17 +722,13 @@ int main() {
       }
     }
 
+    // The scene renders to HDR whatever the swapchain is; only the post
+    // output pass follows its format.
     if (currentFormat != surfaceFormat.format) {
       vkDeviceWaitIdle(device);
-
-      destroy_pipeline();
-      destroy_renderpass();
-
-      create_renderpass(surfaceFormat.format);
-      create_pipeline();
-
+      g_post.createOutputPipeline(surfaceFormat.format);
       currentFormat = surfaceFormat.format;
-      logi("RenderPass + Pipeline created/recreated for new format.");
+      logi("Post output pass recreated for new format.");
     }
 
     swapViews.resize(scImgCount);
@@ -699,13 +744,35 @@ int main() {
               "vkCreateImageView");
     }
 
+    depth = render::createImage(gpu, extent.width, extent.height, depthFormat,
+                                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                                VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                VK_IMAGE_ASPECT_DEPTH_BIT);
+    depthFresh = true;
+    g_particles.setDepth(depth.view, extent.width, extent.height);
+    g_hiz.resize(depth.view, extent.width, extent.height);
+    g_world.setHiZ(g_hiz.view(), g_hiz.sampler(), g_hiz.width(), g_hiz.height(), g_hiz.levels(), g_hiz.enabled());
+    g_post.resize(depth.view, extent.width, extent.height);
+    apply_render_extent();
+
+    {
+      VkImageView attachments[] = { g_post.hdrView(), depth.view };
+      VkFramebufferCreateInfo fbci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+      fbci.renderPass = renderPass;
+      fbci.attachmentCount = 2;
+      fbci.pAttachments = attachments;
+      fbci.width = extent.width;
+      fbci.height = extent.height;
+      fbci.layers = 1;
+      vkcheck(vkCreateFramebuffer(device, &fbci, nullptr, &sceneFramebuffer), "vkCreateFramebuffer(scene)");
+    }
+
     framebuffers.resize(scImgCount);
     for (uint32_t i = 0; i < scImgCount; ++i) {
-      VkImageView attachments[] = { swapViews[i] };
       VkFramebufferCreateInfo fbci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
-      fbci.renderPass = renderPass;
+      fbci.renderPass = g_post.outputPass();
       fbci.attachmentCount = 1;
-      fbci.pAttachments = attachments;
+      fbci.pAttachments = &swapViews[i];
       fbci.width = extent.width;
       fbci.height = extent.height;
       fbci.layers = 1;
@@ -729,59 +796,358 @@ int main() {
     return true;
   };
 
-  while (!create_swapchain_deps()) Sleep(16);
+  // --------------------- Startup graph ---------------------
+  // Python stays on the main thread: CPython ties the GIL and its thread state
+  // to the initializing thread, and every script call later happens here.
+  // Vulkan bring-up and shader loading overlap with it on the job workers.
+  core::TaskGraph startup;
+
+  startup.add("python", [&] {
+    // Prefers scripts.pak next to the exe (isolated interpreter). Without it,
+    // falls back to python/ via PYTHONPATH or exe-relative probing.
+    if (!g_py.init("game")) {
+      loge("Python init failed (module 'game' not found?)");
+    } else {
+      g_py.callEvent("start", 0, 0, 0);
+    }
+  }, {}, core::TaskGraph::Affinity::Main);
+
+  auto tShaders = startup.add("shaders.read", [&] {
+    vertSpv = render::readSpv("shaders/triangle.vert.spv", false);
+    fragSpv = render::readSpv("shaders/triangle.frag.spv", false);
+    if (vertSpv.empty() || fragSpv.empty()) startupError = 6; // readSpv logged which
+  });
+
+  auto tInstance = startup.add("vk.instance", [&] {
+    bool enableValidation = has_layer("VK_LAYER_KHRONOS_validation");
+    if (enableValidation) logi("Validation layer available -> enabling.");
+    else logi("Validation layer not found -> running without validation.");
+
+    std::vector<const char*> layers;
+    if (enableValidation) layers.push_back("VK_LAYER_KHRONOS_validation");
+
+    std::vector<const char*> exts;
+    exts.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+    exts.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+    if (enableValidation) exts.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+
+    VkApplicationInfo appInfo{ VK_STRUCTURE_TYPE_APPLICATION_INFO };
+    appInfo.pApplicationName = kAppName;
+    appInfo.applicationVersion = VK_MAKE_VERSION(0, 1, 0);
+    appInfo.pEngineName = "BSP-Engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(0, 1, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+
+    VkInstanceCreateInfo ici{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+    ici.pApplicationInfo = &appInfo;
+    ici.enabledLayerCount = (uint32_t)layers.size();
+    ici.ppEnabledLayerNames = layers.empty() ? nullptr : layers.data();
+    ici.enabledExtensionCount = (uint32_t)exts.size();
+    ici.ppEnabledExtensionNames = exts.data();
+
+    VkDebugUtilsMessengerCreateInfoEXT debugCI{ VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT };
+    if (enableValidation) {
+      debugCI.messageSeverity =
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+      debugCI.messageType =
+        VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+      debugCI.pfnUserCallback = debug_callback;
+      ici.pNext = &debugCI;
+    }
+
+    if (!startupCheck(vkCreateInstance(&ici, nullptr, &instance), "vkCreateInstance")) return;
+    logi("Vulkan instance created.");
+
+    if (enableValidation) {
+      if (create_debug_messenger(instance, &debugCI, &dbg) == VK_SUCCESS) {
+        logi("Debug messenger created.");
+      } else {
+        loge("Debug messenger creation failed (continuing).");
+      }
+    }
+  });
+
+  auto tSurface = startup.add("vk.surface", [&] {
+    if (startupError != 0) return;
+    VkWin32SurfaceCreateInfoKHR win32SurfaceCI{ VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR };
+    win32SurfaceCI.hinstance = hInstance;
+    win32SurfaceCI.hwnd = hwnd;
+
+    if (!startupCheck(vkCreateWin32SurfaceKHR(instance, &win32SurfaceCI, nullptr, &surface),
+                      "vkCreateWin32SurfaceKHR"))
+      return;
+    logi("Win32 surface created.");
+  }, { tInstance });
+
+  auto tDevice = startup.add("vk.device", [&] {
+    // ---- Physical device + queues ----
+    if (startupError != 0) return;
+    uint32_t physCount = 0;
+    if (!startupCheck(vkEnumeratePhysicalDevices(instance, &physCount, nullptr),
+                      "vkEnumeratePhysicalDevices(count)"))
+      return;
+    if (physCount == 0) {
+      loge("No Vulkan devices found.");
+      startupError = 4;
+      return;
+    }
+
+    std::vector<VkPhysicalDevice> physDevices(physCount);
+    if (!startupCheck(vkEnumeratePhysicalDevices(instance, &physCount, physDevices.data()),
+                      "vkEnumeratePhysicalDevices(list)"))
+      return;
+
+    physical = physDevices[0];
+
+    VkPhysicalDeviceProperties gpuProps{};
+    vkGetPhysicalDeviceProperties(physical, &gpuProps);
+    core::logInfo(core::LogCategory::Render, "Using GPU: %s", gpuProps.deviceName);
+
+    uint32_t qCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical, &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qProps(qCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physical, &qCount, qProps.data());
+
+    for (uint32_t i = 0; i < qCount; ++i) {
+      if (qProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        queues.graphicsIndex = i;
+      }
+      VkBool32 present = VK_FALSE;
+      if (!startupCheck(vkGetPhysicalDeviceSurfaceSupportKHR(physical, i, surface, &present),
+                        "vkGetPhysicalDeviceSurfaceSupportKHR"))
+        return;
+      if (present) queues.presentIndex = i;
+    }
+
+    if (queues.graphicsIndex == UINT32_MAX || queues.presentIndex == UINT32_MAX) {
+      loge("Required queue families not found.");
+      startupError = 5;
+      return;
+    }
+
+    // ---- Device ----
+    float priority = 1.0f;
+
+    std::vector<uint32_t> uniqueQueues = { queues.graphicsIndex };
+    if (queues.presentIndex != queues.graphicsIndex)
+      uniqueQueues.push_back(queues.presentIndex);
+
+    std::vector<VkDeviceQueueCreateInfo> queueInfos;
+    for (uint32_t idx : uniqueQueues) {
+      VkDeviceQueueCreateInfo qci{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+      qci.queueFamilyIndex = idx;
+      qci.queueCount = 1;
+      qci.pQueuePriorities = &priority;
+      queueInfos.push_back(qci);
+    }
+
+    const char* deviceExts[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+    // GPU-driven world draws: multi-draw with the surface index in
+    // firstInstance, and the draw count from the culling pass (core in 1.2
+    // but optional). Enabled when supported; StaticWorld adapts.
+    VkPhysicalDeviceFeatures supported{};
+    vkGetPhysicalDeviceFeatures(physical, &supported);
+    deviceFeatures.multiDrawIndirect = supported.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = supported.drawIndirectFirstInstance;
+
+    VkPhysicalDeviceVulkan12Features features12{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    bool vulkan12 = gpuProps.apiVersion >= VK_API_VERSION_1_2;
+    if (vulkan12) {
+      VkPhysicalDeviceFeatures2 query{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+      query.pNext = &features12;
+      vkGetPhysicalDeviceFeatures2(physical, &query);
+      drawIndirectCount = features12.drawIndirectCount == VK_TRUE;
+      features12 = VkPhysicalDeviceVulkan12Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+      features12.drawIndirectCount = drawIndirectCount ? VK_TRUE : VK_FALSE;
+    }
+
+    VkDeviceCreateInfo dci{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    dci.pNext = vulkan12 ? &features12 : nullptr;
+    dci.queueCreateInfoCount = (uint32_t)queueInfos.size();
+    dci.pQueueCreateInfos = queueInfos.data();
+    dci.enabledExtensionCount = 1;
+    dci.ppEnabledExtensionNames = deviceExts;
+    dci.pEnabledFeatures = &deviceFeatures;
+
+    if (!startupCheck(vkCreateDevice(physical, &dci, nullptr, &device), "vkCreateDevice")) return;
+    logi("Logical device created.");
+
+    vkGetDeviceQueue(device, queues.graphicsIndex, 0, &graphicsQueue);
+    vkGetDeviceQueue(device, queues.presentIndex, 0, &presentQueue);
+  }, { tSurface });
+
+  startup.add("vk.pipeline", [&] {
+    if (startupError != 0) return;
+    depthFormat = render::findDepthFormat(physical);
+    if (depthFormat == VK_FORMAT_UNDEFINED) {
+      startupError = 6;
+      return;
+    }
+    if (!create_renderpass() || !create_pipeline()) return;
+    logi("RenderPass + Pipeline created.");
+  }, { tDevice, tShaders });
+
+  startup.run(g_jobs, &timeline);
+  if (startupError != 0) {
+    core::logFlush();
+    return startupError;
+  }
+  // Note the format the swapchain will pick: the post output pass is built
+  // for it below, so the first create_swapchain_deps() skips the rebuild.
+  currentFormat = choose_surface_format(physical, surface).format;
+
+  gpu = render::makeGpuContext(physical, device, graphicsQueue, queues.graphicsIndex);
+  gpu.features = deviceFeatures;
+  gpu.drawIndirectCount = drawIndirectCount;
+  g_lighting.init(gpu, MAX_FRAMES);
+  g_world.init(gpu, MAX_FRAMES, renderPass, g_lighting);
+  g_hiz.init(gpu);
+  g_particles.init(gpu, MAX_FRAMES, renderPass);
+  g_anim.init(gpu, MAX_FRAMES, g_jobs);
+  g_decals.init(gpu, MAX_FRAMES);
+  g_lighting.setDecalAtlas(g_decals.atlasView(), g_decals.sampler());
+  g_shadows.init(gpu, MAX_FRAMES, g_world);
+  g_lighting.setShadowAtlas(g_shadows);
+  g_post.init(gpu, MAX_FRAMES);
+  g_post.createOutputPipeline(currentFormat);
+  g_resolution.init(gpu, MAX_FRAMES);
+
+  {
+    VkSemaphoreCreateInfo semCI{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    VkFenceCreateInfo fenceCI{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    fenceCI.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-  auto record = [&](uint32_t imageIndex) {
+    for (uint32_t i = 0; i < MAX_FRAMES; ++i) {
+      vkcheck(vkCreateSemaphore(device, &semCI, nullptr, &imageAvailable[i]),
+              "vkCreateSemaphore(imageAvailable)");
+      vkcheck(vkCreateFence(device, &fenceCI, nullptr, &inFlight[i]),
+              "vkCreateFence(inFlight)");
+    }
+  }
+
+  {
+    core::StartupTimeline::Scope span(timeline, "swapchain");
+    while (!create_swapchain_deps()) Sleep(16);
+  }
+
+  auto record = [&](uint32_t imageIndex, uint32_t frameIndex) {
     VkCommandBuffer cmd = cmdBufs[imageIndex];
 
     VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
     vkcheck(vkBeginCommandBuffer(cmd, &bi), "vkBeginCommandBuffer");
+    // Shadow maps do not scale with the render resolution: outside the
+    // timed scene, or a refresh would read as scene load.
+    g_shadows.record(cmd, frameIndex);
+    g_resolution.beginScene(cmd, frameIndex);
+
+    // Atlas uploads, light/decal binning and the world's early culling run
+    // before the passes so lit draws see this frame's lists.
+    g_decals.recordUploads(cmd, frameIndex);
+    g_lighting.cull(cmd, frameIndex);
+    g_world.cull(cmd, frameIndex, render::StaticWorld::Phase::Early);
+
+    // A new depth buffer has no contents yet; give the particle pass a
+    // cleared one (far plane everywhere = nothing to collide with).
+    if (depthFresh) {
+      render::imageBarrier(cmd, depth.image, VK_IMAGE_ASPECT_DEPTH_BIT,
+                           VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+      VkClearDepthStencilValue farPlane{ 1.0f, 0 };
+      VkImageSubresourceRange range{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+      vkCmdClearDepthStencilImage(cmd, depth.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &farPlane, 1, &range);
+      render::imageBarrier(cmd, depth.image, VK_IMAGE_ASPECT_DEPTH_BIT,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+      depthFresh = false;
+    }
+
+    // Emit/simulate/compact; collides against last frame's depth.
+    g_particles.simulate(cmd, frameIndex);
 
-    VkClearValue clear{};
-    clear.color.float32[0] = 0.03f;
-    clear.color.float32[1] = 0.02f;
-    clear.color.float32[2] = 0.05f;
-    clear.color.float32[3] = 1.0f;
+    VkClearValue clears[2]{};
+    clears[0].color.float32[0] = 0.03f;
+    clears[0].color.float32[1] = 0.02f;
+    clears[0].color.float32[2] = 0.05f;
+    clears[0].color.float32[3] = 1.0f;
+    clears[1].depthStencil.depth = 1.0f;
 
     VkRenderPassBeginInfo rpbi{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-    rpbi.renderPass = renderPass;
-    rpbi.framebuffer = framebuffers[imageIndex];
+    rpbi.renderPass = earlyPass;
+    rpbi.framebuffer = sceneFramebuffer;
     rpbi.renderArea.offset = {0, 0};
-    rpbi.renderArea.extent = extent;
-    rpbi.clearValueCount = 1;
-    rpbi.pClearValues = &clear;
-
-    vkCmdBeginRenderPass(cmd, &rpbi, VK_SUBPASS_CONTENTS_INLINE);
+    rpbi.renderArea.extent = renderExtent;
+    rpbi.clearValueCount = 2;
+    rpbi.pClearValues = clears;
 
     VkViewport vp{};
     vp.x = 0.0f; vp.y = 0.0f;
-    vp.width  = (float)extent.width;
-    vp.height = (float)extent.height;
+    vp.width  = (float)renderExtent.width;
+    vp.height = (float)renderExtent.height;
     vp.minDepth = 0.0f;
     vp.maxDepth = 1.0f;
 
     VkRect2D sc{};
     sc.offset = {0, 0};
-    sc.extent = extent;
+    sc.extent = renderExtent;
 
+    // Early pass: the static world that was visible last frame, as the
+    // occluders for this frame's Hi-Z test.
+    vkCmdBeginRenderPass(cmd, &rpbi, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdSetViewport(cmd, 0, 1, &vp);
+    vkCmdSetScissor(cmd, 0, 1, &sc);
+    g_world.draw(cmd, frameIndex, render::StaticWorld::Phase::Early);
+    vkCmdEndRenderPass(cmd);
+
+    g_hiz.build(cmd);
+    g_world.cull(cmd, frameIndex, render::StaticWorld::Phase::Late);
+
+    rpbi.renderPass = renderPass;
+    rpbi.clearValueCount = 0;
+    rpbi.pClearValues = nullptr;
+    vkCmdBeginRenderPass(cmd, &rpbi, VK_SUBPASS_CONTENTS_INLINE);
     vkCmdSetViewport(cmd, 0, 1, &vp);
     vkCmdSetScissor(cmd, 0, 1, &sc);
 
+    // Static world surfaces that became visible: a few indirect draws,
+    // however many surfaces survived.
+    g_world.draw(cmd, frameIndex, render::StaticWorld::Phase::Late);
+
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
     vkCmdDraw(cmd, 3, 1, 0, 0);
 
+    // Transparent, after everything opaque.
+    g_particles.draw(cmd, frameIndex);
+
     vkCmdEndRenderPass(cmd);
+    g_resolution.endScene(cmd, frameIndex);
+
+    // Upscale, bloom, fog, tonemap and grading into the swapchain image.
+    g_post.record(cmd, frameIndex, framebuffers[imageIndex]);
+    // Overlays (UI) go here: still in the output pass, at native resolution.
+    g_post.endOutput(cmd, frameIndex);
     vkcheck(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
   };
 
   uint32_t frameIndex = 0;
   MSG msg{};
   bool running = true;
+  bool firstFramePresented = false;
+  const double firstFrameStartMs = timeline.nowMs();
 
   LARGE_INTEGER qpf{};
   LARGE_INTEGER qpcPrev{};
   QueryPerformanceFrequency(&qpf);
   QueryPerformanceCounter(&qpcPrev);
+  const double kPhysicsStep = 1.0 / 60.0;
+  double physicsAccum = 0.0;
 
   while (running) {
     while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
@@ -800,12 +1166,56 @@ int main() {
     qpcPrev = qpcNow;
 
     if (g_requestQuit) running = false;
-    if (running && g_pyHost) g_pyHost->callUpdate(dt);
     if (!running) break;
 
+    // Wait for this slot's previous frame before touching anything it owns,
+    // including its frame arenas.
     vkcheck(vkWaitForFences(device, 1, &inFlight[frameIndex], VK_TRUE, UINT64_MAX),
             "vkWaitForFences");
-    vkcheck(vkResetFences(device, 1, &inFlight[frameIndex]), "vkResetFences");
+    g_frameMem.beginFrame(frameIndex);
+    g_decals.beginFrame(frameIndex);
+    // Scene resolution from the scene time this slot's last frame took.
+    g_resolution.update(frameIndex);
+    apply_render_extent();
+
+    if (g_pyHost) {
+      g_pyHost->dispatchEvents();
+      g_pyHost->callUpdate(dt);
+      g_pyHost->tickBehaviors(dt, g_camera.position);
+      g_pyHost->endFrame();
+    }
+    // Paths requested this frame start on the job threads; finished ones
+    // reach scripts as events before the next update.
+    g_nav.update();
+    for (const nav::PathEvent& e : g_nav.finished()) {
+      g_py.queueEvent("path_ready", (int)e.id, (int)e.status, (int)e.pointCount);
+    }
+    // Fixed 60 Hz physics after scripts spawned or pushed bodies; at most
+    // four steps per frame so a hitch does not snowball.
+    physicsAccum = std::min(physicsAccum + dt, 4.0 * kPhysicsStep);
+    while (physicsAccum >= kPhysicsStep) {
+      g_physics.step((float)kPhysicsStep);
+      physicsAccum -= kPhysicsStep;
+    }
+    // Only actors scripts moved are rechecked; the transitions reach them as
+    // one event per frame, read with engine.trigger_events().
+    g_triggers.update();
+    if (!g_triggers.events().empty()) {
+      g_py.queueEvent("triggers", (int)g_triggers.events().size(), 0, 0);
+    }
+    g_save.update();
+    for (const save::SaveResult& r : g_save.finished()) {
+      g_py.queueEvent("game_saved", (int)r.id, r.ok ? 1 : 0, 0);
+    }
+    g_audio.update();
+    for (audio::VoiceId id : g_audio.finished()) g_py.queueEvent("sound_done", (int)id, 0, 0);
+    g_decals.update(g_camera, (float)extent.width / (float)std::max(extent.height, 1u));
+    g_shadows.update(frameIndex, g_camera, (float)extent.width / (float)std::max(extent.height, 1u), g_lights);
+    g_lighting.update(frameIndex, g_camera, g_lights, g_decals.visible());
+    g_world.update(frameIndex, g_camera);
+    g_particles.update(frameIndex, g_camera, (float)dt);
+    g_anim.update(frameIndex, (float)dt);
+    g_post.update(frameIndex, g_camera);
 
     uint32_t imageIndex = 0;
     VkResult ar = vkAcquireNextImageKHR(
@@ -822,8 +1232,11 @@ int main() {
     }
     vkcheck(ar, "vkAcquireNextImageKHR");
 
+    // Only reset once a submit is guaranteed; the out-of-date path above
+    // loops back to the wait with the fence still signalled.
+    vkcheck(vkResetFences(device, 1, &inFlight[frameIndex]), "vkResetFences");
     vkcheck(vkResetCommandBuffer(cmdBufs[imageIndex], 0), "vkResetCommandBuffer");
-    record(imageIndex);
+    record(imageIndex, frameIndex);
 
     VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
@@ -855,6 +1268,12 @@ int main() {
       vkcheck(pr, "vkQueuePresentKHR");
     }
 
+    if (!firstFramePresented) {
+      firstFramePresented = true;
+      timeline.record("first frame", firstFrameStartMs, timeline.nowMs());
+      timeline.print();
+    }
+
     frameIndex = (frameIndex + 1) % MAX_FRAMES;
   }
 
@@ -873,12 +1292,31 @@ int main() {
   for (auto f : inFlight) vkDestroyFence(device, f, nullptr);
   for (auto s : imageAvailable) vkDestroySemaphore(device, s, nullptr);
 
+  g_shadows.shutdown();
+  g_world.shutdown();
+  g_hiz.shutdown();
+  g_post.shutdown();
+  g_resolution.shutdown();
+  g_lighting.shutdown();
+  g_particles.shutdown();
+  g_anim.shutdown();
+  g_decals.shutdown();
   vkDestroyDevice(device, nullptr);
 
   vkDestroySurfaceKHR(instance, surface, nullptr);
   if (dbg) destroy_debug_messenger(instance, dbg);
   vkDestroyInstance(instance, nullptr);
 
+  g_save.shutdown(); // finishes a save in flight
+  g_audio.shutdown(); // before the pak its sounds point into
+  g_assets.close();
+  g_physics.shutdown();
+  g_triggers.shutdown();
+  g_nav.shutdown();
+  g_frameMem.shutdown();
+  g_jobs.shutdown();
+  memory::printReport();
   logi("Shutdown clean.");
+  core::logShutdown();
   return 0;
 }
@@ -0,0 +1,56 @@
+#include "FrameArenas.h"
+#include "../core/JobSystem.h"
+#include "../core/Log.h"
+
+
+namespace memory {
+
+void FrameArenas::init(uint32_t framesInFlight, uint32_t threadCount, size_t bytesPerThread) {
+  shutdown();
+  m_frames = framesInFlight ? framesInFlight : 1;
+  m_threads = threadCount ? threadCount : 1;
+
+  m_arenas.reserve((size_t)m_frames * m_threads);
+  for (uint32_t i = 0; i < m_frames * m_threads; ++i) {
+    auto arena = std::make_unique<LinearArena>();
+    arena->init(MemTag::Frame, bytesPerThread);
+    m_arenas.push_back(std::move(arena));
+  }
+  m_current.store(0, std::memory_order_release);
+}
+
+void FrameArenas::shutdown() {
+  m_arenas.clear();
+  m_frames = 0;
+  m_threads = 0;
+}
+
+void FrameArenas::beginFrame(uint32_t frameIndex) {
+  if (m_arenas.empty()) return;
+  frameIndex %= m_frames;
+
+  size_t frameBytes = 0;
+  for (uint32_t t = 0; t < m_threads; ++t) {
+    LinearArena& arena = *m_arenas[(size_t)frameIndex * m_threads + t];
+    frameBytes += arena.used();
+    arena.reset();
+  }
+
+  if (frameBytes > m_peakFrameBytes) m_peakFrameBytes = frameBytes;
+  if (m_frameBudget && frameBytes > m_frameBudget && !m_overBudget) {
+    core::logWarn(core::LogCategory::Memory, "Frame arenas used %zu KiB (budget %zu KiB)", frameBytes / 1024,
+                  m_frameBudget / 1024);
+  }
+  m_overBudget = m_frameBudget && frameBytes > m_frameBudget;
+
+  m_current.store(frameIndex, std::memory_order_release);
+}
+
+LinearArena* FrameArenas::local() {
+  int slot = core::JobSystem::threadIndex();
+  if (slot < 0 || (uint32_t)slot >= m_threads || m_arenas.empty()) return nullptr;
+  uint32_t frame = m_current.load(std::memory_order_acquire);
+  return m_arenas[(size_t)frame * m_threads + (uint32_t)slot].get();
+}
+
+} // namespace memory
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "LinearArena.h"
+
+namespace memory {
+
+/// One linear arena per (frame in flight, job-system thread).
+///
+/// Anything a frame allocates from local() stays valid until that frame's
+/// fence signals, so it can back data the GPU reads (staging copies, draw
+/// lists) as well as CPU scratch. beginFrame() must run after the fence
+/// wait and before any job of the new frame starts.
+class FrameArenas {
+public:
+  void init(uint32_t framesInFlight, uint32_t threadCount, size_t bytesPerThread);
+  void shutdown();
+
+  /// Resets every thread's arena for frameIndex and makes it current.
+  void beginFrame(uint32_t frameIndex);
+
+  /// Arena for the calling job-system thread in the current frame, or
+  /// nullptr on threads outside the pool (callers fall back to the heap).
+  LinearArena* local();
+
+  /// Largest total any single frame used across all threads.
+  size_t peakFrameBytes() const { return m_peakFrameBytes; }
+
+  /// Warns when a frame uses more than this (0 = off).
+  void setFrameBudget(size_t bytes) { m_frameBudget = bytes; }
+
+private:
+  uint32_t m_frames = 0;
+  uint32_t m_threads = 0;
+  std::vector<std::unique_ptr<LinearArena>> m_arenas; // [frame * threads + thread]
+  std::atomic<uint32_t> m_current{0};
+
+  size_t m_peakFrameBytes = 0;
+  size_t m_frameBudget = 0;
+  bool m_overBudget = false;
+};
+
+} // namespace memory
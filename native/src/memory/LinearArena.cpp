@@ -0,0 +1,83 @@
+#include "LinearArena.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+
+namespace memory {
+
+static constexpr size_t kArenaAlign = 64;
+static constexpr size_t kGrowGranularity = 64 * 1024;
+
+static size_t AlignUp(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+
+void LinearArena::init(MemTag tag, size_t capacity) {
+  release();
+  m_tag = tag;
+  m_capacity = AlignUp(capacity, kArenaAlign);
+  m_base = m_capacity ? static_cast<uint8_t*>(allocate(m_tag, m_capacity, kArenaAlign)) : nullptr;
+  m_offset = 0;
+  m_highWater = 0;
+}
+
+void LinearArena::release() {
+  freeSpillsUntil(nullptr);
+  if (m_base) deallocate(m_tag, m_base, m_capacity, kArenaAlign);
+  m_base = nullptr;
+  m_capacity = 0;
+  m_offset = 0;
+}
+
+void* LinearArena::alloc(size_t size, size_t align) {
+  if (align < alignof(void*)) align = alignof(void*);
+
+  size_t start = AlignUp((size_t)(m_base + m_offset), align) - (size_t)m_base;
+  if (m_base && start + size <= m_capacity) {
+    m_offset = start + size;
+    m_highWater = std::max(m_highWater, used());
+    return m_base + start;
+  }
+
+  // Spill: header first, payload aligned after it.
+  size_t header = AlignUp(sizeof(Spill), align);
+  size_t total = header + size;
+  size_t blockAlign = std::max(align, alignof(Spill));
+  auto* spill = static_cast<Spill*>(allocate(m_tag, total, blockAlign));
+  spill->next = m_spill;
+  spill->size = total;
+  spill->align = blockAlign;
+  m_spill = spill;
+  m_spillBytes += total;
+  m_highWater = std::max(m_highWater, used());
+  return reinterpret_cast<uint8_t*>(spill) + header;
+}
+
+void LinearArena::freeSpillsUntil(void* stop) {
+  while (m_spill && m_spill != stop) {
+    Spill* next = m_spill->next;
+    m_spillBytes -= m_spill->size;
+    deallocate(m_tag, m_spill, m_spill->size, m_spill->align);
+    m_spill = next;
+  }
+}
+
+void LinearArena::rewind(Marker marker) {
+  freeSpillsUntil(marker.spill);
+  if (marker.offset <= m_offset) m_offset = marker.offset;
+}
+
+void LinearArena::reset() {
+  bool spilled = m_spill != nullptr;
+  freeSpillsUntil(nullptr);
+  m_offset = 0;
+
+  if (spilled) {
+    size_t grown = AlignUp(m_highWater + m_highWater / 4, kGrowGranularity);
+    core::logInfo(core::LogCategory::Memory, "Arena (%s) spilled; growing %zu -> %zu KiB", tagName(m_tag),
+                  m_capacity / 1024, grown / 1024);
+    size_t highWater = m_highWater;
+    init(m_tag, grown);
+    m_highWater = highWater;
+  }
+}
+
+} // namespace memory
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "MemoryTracker.h"
+
+namespace memory {
+
+/// Bump allocator over one contiguous block. Single-threaded: give each
+/// thread its own arena.
+///
+/// Nothing is freed individually; reset() drops everything, rewind() drops
+/// everything allocated after a mark(). When the block runs out, allocations
+/// spill into individually tracked heap blocks, and the next reset() grows
+/// the main block so the spill does not repeat.
+class LinearArena {
+public:
+  struct Marker {
+    size_t offset = 0;
+    void* spill = nullptr;
+  };
+
+  LinearArena() = default;
+  ~LinearArena() { release(); }
+  LinearArena(const LinearArena&) = delete;
+  LinearArena& operator=(const LinearArena&) = delete;
+
+  void init(MemTag tag, size_t capacity);
+  void release();
+
+  void* alloc(size_t size, size_t align = alignof(std::max_align_t));
+
+  template <class T>
+  T* allocArray(size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destructed");
+    return static_cast<T*>(alloc(sizeof(T) * count, alignof(T)));
+  }
+
+  template <class T, class... Args>
+  T* make(Args&&... args) {
+    static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destructed");
+    return new (alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  Marker mark() const { return Marker{ m_offset, m_spill }; }
+  void rewind(Marker marker);
+  void reset();
+
+  size_t used() const { return m_offset + m_spillBytes; }
+  size_t capacity() const { return m_capacity; }
+  size_t highWater() const { return m_highWater; }
+
+private:
+  struct Spill {
+    Spill* next;
+    size_t size;
+    size_t align;
+  };
+
+  void freeSpillsUntil(void* stop);
+
+  MemTag m_tag = MemTag::Frame;
+  uint8_t* m_base = nullptr;
+  size_t m_capacity = 0;
+  size_t m_offset = 0;
+  size_t m_highWater = 0;
+
+  Spill* m_spill = nullptr;
+  size_t m_spillBytes = 0;
+};
+
+/// Rewinds the arena to where it was when the scope was entered. Meant for
+/// function-local scratch on the current thread's frame arena.
+class ScratchScope {
+public:
+  explicit ScratchScope(LinearArena& arena) : m_arena(arena), m_marker(arena.mark()) {}
+  ~ScratchScope() { m_arena.rewind(m_marker); }
+  ScratchScope(const ScratchScope&) = delete;
+  ScratchScope& operator=(const ScratchScope&) = delete;
+
+  template <class T>
+  T* allocArray(size_t count) { return m_arena.allocArray<T>(count); }
+
+private:
+  LinearArena& m_arena;
+  LinearArena::Marker m_marker;
+};
+
+/// std allocator adaptor so containers can live in an arena. A null arena
+/// falls back to the global heap, which keeps call sites usable from threads
+/// that have no frame arena.
+template <class T>
+class ArenaAllocator {
+public:
+  using value_type = T;
+
+  ArenaAllocator() = default;
+  explicit ArenaAllocator(LinearArena* arena) : m_arena(arena) {}
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if (m_arena) return static_cast<T*>(m_arena->alloc(sizeof(T) * n, alignof(T)));
+    return static_cast<T*>(::operator new(sizeof(T) * n));
+  }
+  void deallocate(T* p, size_t) {
+    if (!m_arena) ::operator delete(p);
+  }
+
+  LinearArena* arena() const { return m_arena; }
+
+  template <class U>
+  bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.arena(); }
+
+private:
+  LinearArena* m_arena = nullptr;
+};
+
+} // namespace memory
@@ -0,0 +1,112 @@
+#include "MemoryTracker.h"
+#include "../core/Log.h"
+
+#include <atomic>
+#include <cstdio>
+#include <new>
+
+namespace memory {
+
+namespace {
+
+struct TagCounters {
+  std::atomic<size_t> bytes{0};
+  std::atomic<size_t> peakBytes{0};
+  std::atomic<size_t> allocations{0};
+  std::atomic<size_t> totalAllocations{0};
+  std::atomic<size_t> budget{0};
+  std::atomic<bool> overBudget{false};
+};
+
+TagCounters g_tags[(size_t)MemTag::Count];
+
+const char* const kTagNames[(size_t)MemTag::Count] = {
+  "core", "frame", "scripting", "render", "physics",
+  "animation", "audio", "navigation", "assets",
+};
+
+double ToMiB(size_t bytes) { return (double)bytes / (1024.0 * 1024.0); }
+
+} // namespace
+
+const char* tagName(MemTag tag) {
+  return (size_t)tag < (size_t)MemTag::Count ? kTagNames[(size_t)tag] : "?";
+}
+
+void track(MemTag tag, size_t bytes) {
+  if ((size_t)tag >= (size_t)MemTag::Count) return;
+  TagCounters& c = g_tags[(size_t)tag];
+
+  size_t now = c.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+  c.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+  size_t peak = c.peakBytes.load(std::memory_order_relaxed);
+  while (now > peak && !c.peakBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+
+  size_t budget = c.budget.load(std::memory_order_relaxed);
+  if (budget && now > budget && !c.overBudget.exchange(true, std::memory_order_relaxed)) {
+    core::logWarn(core::LogCategory::Memory, "Memory budget exceeded: %s %.2f / %.2f MiB", tagName(tag), ToMiB(now),
+                  ToMiB(budget));
+  }
+}
+
+void untrack(MemTag tag, size_t bytes) {
+  if ((size_t)tag >= (size_t)MemTag::Count) return;
+  TagCounters& c = g_tags[(size_t)tag];
+
+  size_t now = c.bytes.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+  c.allocations.fetch_sub(1, std::memory_order_relaxed);
+
+  size_t budget = c.budget.load(std::memory_order_relaxed);
+  if (c.overBudget.load(std::memory_order_relaxed) && now < budget - budget / 10) {
+    c.overBudget.store(false, std::memory_order_relaxed);
+  }
+}
+
+void setBudget(MemTag tag, size_t bytes) {
+  if ((size_t)tag >= (size_t)MemTag::Count) return;
+  g_tags[(size_t)tag].budget.store(bytes, std::memory_order_relaxed);
+  g_tags[(size_t)tag].overBudget.store(false, std::memory_order_relaxed);
+}
+
+TagStats stats(MemTag tag) {
+  TagStats s{};
+  if ((size_t)tag >= (size_t)MemTag::Count) return s;
+  const TagCounters& c = g_tags[(size_t)tag];
+  s.bytes = c.bytes.load(std::memory_order_relaxed);
+  s.peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+  s.allocations = c.allocations.load(std::memory_order_relaxed);
+  s.totalAllocations = c.totalAllocations.load(std::memory_order_relaxed);
+  s.budget = c.budget.load(std::memory_order_relaxed);
+  return s;
+}
+
+void* allocate(MemTag tag, size_t bytes, size_t align) {
+  void* p = ::operator new(bytes, std::align_val_t(align));
+  track(tag, bytes);
+  return p;
+}
+
+void deallocate(MemTag tag, void* ptr, size_t bytes, size_t align) {
+  if (!ptr) return;
+  ::operator delete(ptr, std::align_val_t(align));
+  untrack(tag, bytes);
+}
+
+void printReport() {
+  core::logInfo(core::LogCategory::Memory, "Memory by subsystem:");
+  core::logInfo(core::LogCategory::Memory, "  %-12s %10s %10s %10s %8s %10s", "tag", "live MiB", "peak MiB", "budget",
+                "blocks", "total");
+  for (size_t i = 0; i < (size_t)MemTag::Count; ++i) {
+    TagStats s = stats((MemTag)i);
+    if (s.totalAllocations == 0) continue;
+    char budget[32] = "-";
+    if (s.budget) std::snprintf(budget, sizeof(budget), "%.2f", ToMiB(s.budget));
+    core::logInfo(core::LogCategory::Memory, "  %-12s %10.2f %10.2f %10s %8zu %10zu%s", kTagNames[i], ToMiB(s.bytes),
+                  ToMiB(s.peakBytes), budget, s.allocations, s.totalAllocations,
+                  (s.budget && s.peakBytes > s.budget) ? "  OVER" : "");
+  }
+}
+
+} // namespace memory
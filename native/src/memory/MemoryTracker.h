@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace memory {
+
+/// Subsystem a byte belongs to. Every arena, pool and tracked heap block is
+/// charged to exactly one tag.
+enum class MemTag : uint8_t {
+  Core,
+  Frame,
+  Scripting,
+  Render,
+  Physics,
+  Animation,
+  Audio,
+  Navigation,
+  Assets,
+  Count
+};
+
+struct TagStats {
+  size_t bytes = 0;        // currently live
+  size_t peakBytes = 0;
+  size_t allocations = 0;  // currently live
+  size_t totalAllocations = 0;
+  size_t budget = 0;       // 0 = unlimited
+};
+
+const char* tagName(MemTag tag);
+
+/// Accounting only; thread-safe. Arenas and pools call these for the blocks
+/// they reserve, not for every sub-allocation.
+void track(MemTag tag, size_t bytes);
+void untrack(MemTag tag, size_t bytes);
+
+/// Prints a warning the first time a tag goes over budget, and again only
+/// after it has dropped back below 90% of it.
+void setBudget(MemTag tag, size_t bytes);
+TagStats stats(MemTag tag);
+
+/// Tracked heap. Blocks must be returned with the same tag and size.
+void* allocate(MemTag tag, size_t bytes, size_t align = alignof(std::max_align_t));
+void deallocate(MemTag tag, void* ptr, size_t bytes, size_t align = alignof(std::max_align_t));
+
+void printReport();
+
+/// std allocator adaptor that charges a container's storage to a tag, so a
+/// subsystem's long-lived tables count toward its line in the report and
+/// its budget. Each reallocation is one tracked block.
+template <class T, MemTag Tag>
+class TrackedAllocator {
+public:
+  using value_type = T;
+  template <class U>
+  struct rebind {
+    using other = TrackedAllocator<U, Tag>;
+  };
+
+  TrackedAllocator() = default;
+  template <class U>
+  TrackedAllocator(const TrackedAllocator<U, Tag>&) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(memory::allocate(Tag, sizeof(T) * n, alignof(T))); }
+  void deallocate(T* p, size_t n) { memory::deallocate(Tag, p, sizeof(T) * n, alignof(T)); }
+
+  template <class U>
+  bool operator==(const TrackedAllocator<U, Tag>&) const { return true; }
+};
+
+template <class T, MemTag Tag>
+using TrackedVector = std::vector<T, TrackedAllocator<T, Tag>>;
+
+template <class K, class V, MemTag Tag>
+using TrackedMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, TrackedAllocator<std::pair<const K, V>, Tag>>;
+
+} // namespace memory
@@ -0,0 +1,62 @@
+#include "PoolAllocator.h"
+
+namespace memory {
+
+static constexpr size_t kBlockAlign = 16;
+
+void PoolAllocator::init(MemTag tag, size_t blockSize, size_t blocksPerChunk) {
+  release();
+  m_tag = tag;
+  if (blockSize < sizeof(Node)) blockSize = sizeof(Node);
+  m_blockSize = (blockSize + kBlockAlign - 1) & ~(kBlockAlign - 1);
+  m_blocksPerChunk = blocksPerChunk ? blocksPerChunk : 1;
+  m_chunkBytes = m_blockSize * m_blocksPerChunk;
+}
+
+void PoolAllocator::release() {
+  for (void* chunk : m_chunks) deallocate(m_tag, chunk, m_chunkBytes, kBlockAlign);
+  m_chunks.clear();
+  m_free = nullptr;
+  m_remote.store(nullptr, std::memory_order_relaxed);
+}
+
+void PoolAllocator::grow() {
+  auto* chunk = static_cast<uint8_t*>(allocate(m_tag, m_chunkBytes, kBlockAlign));
+  m_chunks.push_back(chunk);
+
+  // Thread the new blocks in address order so early allocations are adjacent.
+  for (size_t i = m_blocksPerChunk; i-- > 0;) {
+    auto* node = reinterpret_cast<Node*>(chunk + i * m_blockSize);
+    node->next = m_free;
+    m_free = node;
+  }
+}
+
+void* PoolAllocator::alloc() {
+  if (!m_free) {
+    // Only the owner pops, and it takes the whole list at once: no ABA.
+    m_free = m_remote.exchange(nullptr, std::memory_order_acquire);
+    if (!m_free) grow();
+  }
+  Node* node = m_free;
+  m_free = node->next;
+  return node;
+}
+
+void PoolAllocator::free(void* block) {
+  if (!block) return;
+  auto* node = static_cast<Node*>(block);
+  node->next = m_free;
+  m_free = node;
+}
+
+void PoolAllocator::freeRemote(void* block) {
+  if (!block) return;
+  auto* node = static_cast<Node*>(block);
+  Node* head = m_remote.load(std::memory_order_relaxed);
+  do {
+    node->next = head;
+  } while (!m_remote.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+}
+
+} // namespace memory
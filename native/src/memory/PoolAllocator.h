@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+namespace memory {
+
+/// Fixed-size block allocator for small, short-lived objects.
+///
+/// Owned by one thread: alloc() and free() are owner-only and never lock.
+/// Other threads hand blocks back with freeRemote(), which pushes onto a
+/// lock-free list the owner drains in one exchange on its next alloc() that
+/// finds the local list empty. Memory grows in chunks and is only returned
+/// by release().
+class PoolAllocator {
+public:
+  PoolAllocator() = default;
+  ~PoolAllocator() { release(); }
+  PoolAllocator(const PoolAllocator&) = delete;
+  PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+  void init(MemTag tag, size_t blockSize, size_t blocksPerChunk = 256);
+  void release();
+
+  void* alloc();
+  void free(void* block);
+  void freeRemote(void* block);
+
+  size_t blockSize() const { return m_blockSize; }
+  size_t reservedBytes() const { return m_chunks.size() * m_chunkBytes; }
+
+private:
+  struct Node {
+    Node* next;
+  };
+
+  void grow();
+
+  MemTag m_tag = MemTag::Core;
+  size_t m_blockSize = 0;
+  size_t m_blocksPerChunk = 0;
+  size_t m_chunkBytes = 0;
+
+  Node* m_free = nullptr;
+  alignas(64) std::atomic<Node*> m_remote{nullptr};
+  std::vector<void*> m_chunks;
+};
+
+} // namespace memory
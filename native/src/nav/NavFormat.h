@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+
+namespace nav {
+
+/// Navigation mesh for a static map, written by the NavBuilder tool
+/// (native/tools/nav). Little endian, tightly packed, in this order:
+///
+///   NavHeader
+///   float vertices[vertexCount][3]
+///   NavPoly[polyCount]           sorted by cluster
+///   NavCluster[clusterCount]
+///   NavClusterLink[linkCount]    grouped by source cluster
+///
+/// Polygons are convex, wound counter-clockwise seen from above (+y), with
+/// up to kMaxPolyVerts corners. Edge i runs from verts[i] to verts[i + 1];
+/// neighbors[i] is the polygon across it, or kNoNeighbor for a wall. Steps
+/// no higher than maxClimb are linked like shared edges.
+///
+/// Clusters are connected groups of neighbouring polygons, the nodes of the
+/// coarse graph the runtime plans over first. A link's cost is the distance
+/// between the two cluster centers.
+struct NavHeader {
+  char magic[4] = { 'B', 'N', 'A', 'V' };
+  uint32_t version = 1;
+  uint32_t vertexCount = 0, polyCount = 0;
+  uint32_t clusterCount = 0, linkCount = 0;
+  float agentHeight = 0.0f; // build settings, for reference
+  float maxClimb = 0.0f;
+  float maxSlopeDeg = 0.0f;
+  float boundsMin[3] = { 0, 0, 0 };
+  float boundsMax[3] = { 0, 0, 0 };
+  uint32_t reserved = 0;
+};
+static_assert(sizeof(NavHeader) == 64, "NavHeader is an on-disk layout");
+
+constexpr uint32_t kMaxPolyVerts = 6;
+constexpr uint32_t kNoNeighbor = UINT32_MAX;
+
+struct NavPoly {
+  uint32_t verts[kMaxPolyVerts] = {};
+  uint32_t neighbors[kMaxPolyVerts] = { kNoNeighbor, kNoNeighbor, kNoNeighbor,
+                                        kNoNeighbor, kNoNeighbor, kNoNeighbor };
+  uint32_t vertCount = 0;
+  uint32_t cluster = 0;
+  float center[3] = { 0, 0, 0 };
+  uint32_t pad = 0;
+};
+static_assert(sizeof(NavPoly) == 72, "NavPoly is an on-disk layout");
+
+struct NavCluster {
+  uint32_t firstPoly = 0, polyCount = 0;
+  uint32_t firstLink = 0, linkCount = 0;
+  float center[3] = { 0, 0, 0 };
+  uint32_t component = 0; // clusters reachable from each other share it
+};
+static_assert(sizeof(NavCluster) == 32, "NavCluster is an on-disk layout");
+
+struct NavClusterLink {
+  uint32_t cluster = 0;
+  float cost = 0.0f;
+};
+static_assert(sizeof(NavClusterLink) == 8, "NavClusterLink is an on-disk layout");
+
+constexpr uint32_t kNavVersion = 1;
+
+} // namespace nav
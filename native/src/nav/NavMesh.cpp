@@ -0,0 +1,221 @@
+#include "NavMesh.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+
+namespace nav {
+
+namespace {
+
+float area2(const Vec3& a, const Vec3& b, const Vec3& c) {
+  return (b.z - a.z) * (c.x - a.x) - (b.x - a.x) * (c.z - a.z);
+}
+
+template <class Vector> bool readArray(std::ifstream& in, Vector& out, size_t count) {
+  out.resize(count);
+  return count == 0 || (bool)in.read(reinterpret_cast<char*>(out.data()), (std::streamsize)(count * sizeof(out[0])));
+}
+
+} // namespace
+
+void NavMesh::clear() {
+  m_header = NavHeader{};
+  m_vertices.clear();
+  m_polys.clear();
+  m_clusters.clear();
+  m_links.clear();
+  m_cellStart.clear();
+  m_cellPolys.clear();
+  m_gridW = m_gridH = 0;
+}
+
+bool NavMesh::load(const char* path) {
+  clear();
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    core::logError(core::LogCategory::Nav, "Nav: cannot open %s", path);
+    return false;
+  }
+  NavHeader h;
+  if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) || std::string(h.magic, 4) != "BNAV" ||
+      h.version != kNavVersion) {
+    core::logError(core::LogCategory::Nav, "Nav: %s is not a version %u navmesh", path, kNavVersion);
+    return false;
+  }
+  if (!readArray(in, m_vertices, (size_t)h.vertexCount * 3) || !readArray(in, m_polys, h.polyCount) ||
+      !readArray(in, m_clusters, h.clusterCount) || !readArray(in, m_links, h.linkCount)) {
+    core::logError(core::LogCategory::Nav, "Nav: %s is truncated", path);
+    clear();
+    return false;
+  }
+
+  bool valid = true;
+  for (const NavPoly& p : m_polys) {
+    valid = valid && p.vertCount >= 3 && p.vertCount <= kMaxPolyVerts && p.cluster < h.clusterCount;
+    for (uint32_t e = 0; valid && e < p.vertCount; ++e)
+      valid = p.verts[e] < h.vertexCount && (p.neighbors[e] == kNoNeighbor || p.neighbors[e] < h.polyCount);
+  }
+  for (const NavCluster& c : m_clusters) {
+    valid = valid && c.firstPoly + c.polyCount <= h.polyCount && c.firstLink + c.linkCount <= h.linkCount;
+  }
+  for (const NavClusterLink& l : m_links) valid = valid && l.cluster < h.clusterCount;
+  if (!valid) {
+    core::logError(core::LogCategory::Nav, "Nav: %s has out-of-range indices", path);
+    clear();
+    return false;
+  }
+  m_header = h;
+
+  // Lookup grid, about one polygon per cell.
+  const float extentX = std::max(h.boundsMax[0] - h.boundsMin[0], 1e-3f);
+  const float extentZ = std::max(h.boundsMax[2] - h.boundsMin[2], 1e-3f);
+  m_cellSize = std::max(0.5f, std::sqrt(extentX * extentZ / (float)std::max(h.polyCount, 1u)));
+  m_gridMinX = h.boundsMin[0];
+  m_gridMinZ = h.boundsMin[2];
+  m_gridW = std::min(1024u, (uint32_t)(extentX / m_cellSize) + 1);
+  m_gridH = std::min(1024u, (uint32_t)(extentZ / m_cellSize) + 1);
+  m_cellSize = std::max(extentX / (float)m_gridW, extentZ / (float)m_gridH) * 1.0001f;
+
+  auto cellRange = [&](const NavPoly& p, uint32_t& x0, uint32_t& z0, uint32_t& x1, uint32_t& z1) {
+    float minX = m_vertices[p.verts[0] * 3], maxX = minX;
+    float minZ = m_vertices[p.verts[0] * 3 + 2], maxZ = minZ;
+    for (uint32_t e = 1; e < p.vertCount; ++e) {
+      minX = std::min(minX, m_vertices[p.verts[e] * 3]);
+      maxX = std::max(maxX, m_vertices[p.verts[e] * 3]);
+      minZ = std::min(minZ, m_vertices[p.verts[e] * 3 + 2]);
+      maxZ = std::max(maxZ, m_vertices[p.verts[e] * 3 + 2]);
+    }
+    auto cell = [&](float v, float origin, uint32_t count) {
+      return (uint32_t)std::clamp((int)std::floor((v - origin) / m_cellSize), 0, (int)count - 1);
+    };
+    x0 = cell(minX, m_gridMinX, m_gridW);
+    x1 = cell(maxX, m_gridMinX, m_gridW);
+    z0 = cell(minZ, m_gridMinZ, m_gridH);
+    z1 = cell(maxZ, m_gridMinZ, m_gridH);
+  };
+  m_cellStart.assign((size_t)m_gridW * m_gridH + 1, 0);
+  for (const NavPoly& p : m_polys) {
+    uint32_t x0, z0, x1, z1;
+    cellRange(p, x0, z0, x1, z1);
+    for (uint32_t z = z0; z <= z1; ++z)
+      for (uint32_t x = x0; x <= x1; ++x) ++m_cellStart[z * m_gridW + x + 1];
+  }
+  for (size_t i = 1; i < m_cellStart.size(); ++i) m_cellStart[i] += m_cellStart[i - 1];
+  m_cellPolys.resize(m_cellStart.back());
+  std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+  for (uint32_t i = 0; i < (uint32_t)m_polys.size(); ++i) {
+    uint32_t x0, z0, x1, z1;
+    cellRange(m_polys[i], x0, z0, x1, z1);
+    for (uint32_t z = z0; z <= z1; ++z)
+      for (uint32_t x = x0; x <= x1; ++x) m_cellPolys[fill[z * m_gridW + x]++] = i;
+  }
+
+  core::logInfo(core::LogCategory::Nav, "Nav: %s, %u polygons in %u clusters", path, h.polyCount, h.clusterCount);
+  return true;
+}
+
+Vec3 NavMesh::closestPointOnPoly(uint32_t poly, const Vec3& p) const {
+  const NavPoly& np = m_polys[poly];
+  Vec3 v[kMaxPolyVerts];
+  for (uint32_t i = 0; i < np.vertCount; ++i) v[i] = vertex(np.verts[i]);
+
+  bool inside = true;
+  for (uint32_t i = 0; i < np.vertCount && inside; ++i) inside = area2(v[i], v[(i + 1) % np.vertCount], p) >= 0.0f;
+  if (inside) {
+    // Height from the fan triangle under p.
+    for (uint32_t i = 1; i + 1 < np.vertCount; ++i) {
+      const float total = area2(v[0], v[i], v[i + 1]);
+      if (total <= 0.0f) continue;
+      const float u = area2(v[i], v[i + 1], p) / total;
+      const float w = area2(v[0], v[i], p) / total;
+      if (u < -1e-4f || w < -1e-4f || u + w > 1.0f + 1e-4f) continue;
+      return { p.x, v[0].y * u + v[i].y * (1.0f - u - w) + v[i + 1].y * w, p.z };
+    }
+    return { p.x, center(poly).y, p.z };
+  }
+
+  Vec3 best = v[0];
+  float bestDist = INFINITY;
+  for (uint32_t i = 0; i < np.vertCount; ++i) {
+    const Vec3 a = v[i], d = v[(i + 1) % np.vertCount] - a;
+    const float len2 = d.x * d.x + d.z * d.z;
+    float t = len2 > 0.0f ? ((p.x - a.x) * d.x + (p.z - a.z) * d.z) / len2 : 0.0f;
+    t = std::clamp(t, 0.0f, 1.0f);
+    const Vec3 q = a + d * t;
+    const float dist = (q.x - p.x) * (q.x - p.x) + (q.z - p.z) * (q.z - p.z);
+    if (dist < bestDist) {
+      bestDist = dist;
+      best = q;
+    }
+  }
+  return best;
+}
+
+uint32_t NavMesh::findNearestPoly(const Vec3& p, const Vec3& extents, Vec3& nearest) const {
+  if (m_polys.empty()) return UINT32_MAX;
+  auto cell = [&](float v, float origin, uint32_t count) {
+    return std::clamp((int)std::floor((v - origin) / m_cellSize), 0, (int)count - 1);
+  };
+  const int x0 = cell(p.x - extents.x, m_gridMinX, m_gridW), x1 = cell(p.x + extents.x, m_gridMinX, m_gridW);
+  const int z0 = cell(p.z - extents.z, m_gridMinZ, m_gridH), z1 = cell(p.z + extents.z, m_gridMinZ, m_gridH);
+
+  uint32_t best = UINT32_MAX;
+  float bestDist = INFINITY;
+  for (int z = z0; z <= z1; ++z) {
+    for (int x = x0; x <= x1; ++x) {
+      const uint32_t c = (uint32_t)(z * (int)m_gridW + x);
+      for (uint32_t k = m_cellStart[c]; k < m_cellStart[c + 1]; ++k) {
+        const uint32_t poly = m_cellPolys[k];
+        if (poly == best) continue;
+        const Vec3 q = closestPointOnPoly(poly, p);
+        const Vec3 d = q - p;
+        if (std::fabs(d.x) > extents.x || std::fabs(d.y) > extents.y || std::fabs(d.z) > extents.z) continue;
+        const float dist = dot(d, d);
+        if (dist < bestDist) {
+          bestDist = dist;
+          best = poly;
+          nearest = q;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+bool NavMesh::portal(uint32_t from, uint32_t to, Vec3& left, Vec3& right) const {
+  const NavPoly& a = m_polys[from];
+  uint32_t edge = UINT32_MAX;
+  for (uint32_t e = 0; e < a.vertCount && edge == UINT32_MAX; ++e)
+    if (a.neighbors[e] == to) edge = e;
+  if (edge == UINT32_MAX) return false;
+
+  // Interior is to the left of each counter-clockwise edge, so walking out
+  // through it the edge's start is on the right.
+  right = vertex(a.verts[edge]);
+  left = vertex(a.verts[(edge + 1) % a.vertCount]);
+
+  // Steps link edges that only partly overlap: clip to the other side's edge.
+  const NavPoly& b = m_polys[to];
+  for (uint32_t e = 0; e < b.vertCount; ++e) {
+    if (b.neighbors[e] != from) continue;
+    const Vec3 d = left - right;
+    const float len2 = d.x * d.x + d.z * d.z;
+    if (len2 <= 0.0f) break;
+    const Vec3 c0 = vertex(b.verts[e]), c1 = vertex(b.verts[(e + 1) % b.vertCount]);
+    const float t0 = ((c0.x - right.x) * d.x + (c0.z - right.z) * d.z) / len2;
+    const float t1 = ((c1.x - right.x) * d.x + (c1.z - right.z) * d.z) / len2;
+    const float lo = std::clamp(std::min(t0, t1), 0.0f, 1.0f), hi = std::clamp(std::max(t0, t1), 0.0f, 1.0f);
+    if (hi > lo) {
+      const Vec3 r = right;
+      right = r + d * lo;
+      left = r + d * hi;
+    }
+    break;
+  }
+  return true;
+}
+
+} // namespace nav
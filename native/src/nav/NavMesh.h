@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "../render/RenderMath.h"
+#include "NavFormat.h"
+
+namespace nav {
+
+using render::Vec3;
+
+/// A loaded .nav file (NavFormat.h) plus a grid over (x, z) that lists the
+/// polygons touching each cell, for point lookups.
+///
+/// Read-only after load(), so any number of threads can query it at once.
+class NavMesh {
+public:
+  /// False with a message logged if the file is missing or malformed; the
+  /// mesh is then empty.
+  bool load(const char* path);
+  void clear();
+
+  bool empty() const { return m_polys.empty(); }
+  uint32_t polyCount() const { return (uint32_t)m_polys.size(); }
+  uint32_t clusterCount() const { return (uint32_t)m_clusters.size(); }
+
+  const NavPoly& poly(uint32_t i) const { return m_polys[i]; }
+  const NavCluster& cluster(uint32_t i) const { return m_clusters[i]; }
+  const NavClusterLink& link(uint32_t i) const { return m_links[i]; }
+  Vec3 vertex(uint32_t i) const { return { m_vertices[i * 3], m_vertices[i * 3 + 1], m_vertices[i * 3 + 2] }; }
+  Vec3 center(uint32_t poly) const {
+    const float* c = m_polys[poly].center;
+    return { c[0], c[1], c[2] };
+  }
+
+  /// Polygon closest to `p` among those within `extents` (half size of a
+  /// box around p); UINT32_MAX if none. `nearest` is the closest point on it.
+  uint32_t findNearestPoly(const Vec3& p, const Vec3& extents, Vec3& nearest) const;
+
+  /// The opening from polygon `from` into its neighbour `to`: the overlap of
+  /// their shared edge, as the left and right end seen walking through it.
+  /// False if they are not neighbours.
+  bool portal(uint32_t from, uint32_t to, Vec3& left, Vec3& right) const;
+
+  /// Point of the polygon closest to p seen from above, at the polygon's
+  /// height there.
+  Vec3 closestPointOnPoly(uint32_t poly, const Vec3& p) const;
+
+private:
+  NavHeader m_header;
+  memory::TrackedVector<float, memory::MemTag::Navigation> m_vertices;
+  memory::TrackedVector<NavPoly, memory::MemTag::Navigation> m_polys;
+  memory::TrackedVector<NavCluster, memory::MemTag::Navigation> m_clusters;
+  memory::TrackedVector<NavClusterLink, memory::MemTag::Navigation> m_links;
+
+  // Lookup grid: polygons of cell (x, z) are m_cellPolys[m_cellStart[i]..m_cellStart[i + 1]).
+  float m_gridMinX = 0.0f, m_gridMinZ = 0.0f, m_cellSize = 1.0f;
+  uint32_t m_gridW = 0, m_gridH = 0;
+  memory::TrackedVector<uint32_t, memory::MemTag::Navigation> m_cellStart;
+  memory::TrackedVector<uint32_t, memory::MemTag::Navigation> m_cellPolys;
+};
+
+} // namespace nav
@@ -0,0 +1,218 @@
+#include "NavQuery.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace nav {
+
+namespace {
+
+float area2(const Vec3& a, const Vec3& b, const Vec3& c) {
+  return (b.z - a.z) * (c.x - a.x) - (b.x - a.x) * (c.z - a.z);
+}
+
+bool samePoint(const Vec3& a, const Vec3& b) {
+  const Vec3 d = a - b;
+  return dot(d, d) < 1e-6f * 1e-6f;
+}
+
+float distance(const Vec3& a, const Vec3& b) { return length(a - b); }
+
+Vec3 clusterCenter(const NavCluster& c) { return { c.center[0], c.center[1], c.center[2] }; }
+
+} // namespace
+
+void NavQuery::init(const NavMesh& mesh, uint32_t maxNodes) {
+  m_mesh = &mesh;
+  m_maxNodes = maxNodes;
+  m_nodes.assign(mesh.polyCount(), Node{});
+  m_clusterNodes.assign(mesh.clusterCount(), Node{});
+  m_allowed.assign(mesh.clusterCount(), 0);
+  m_open.clear();
+  m_stamp = 0;
+}
+
+PathStatus NavQuery::corridor(uint32_t startPoly, const Vec3& start, uint32_t goalPoly, const Vec3& goal,
+                              std::vector<uint32_t>& out) {
+  out.clear();
+  if (!m_mesh || startPoly >= m_nodes.size() || goalPoly >= m_nodes.size()) return PathStatus::NoPath;
+  if (startPoly == goalPoly) {
+    out.push_back(startPoly);
+    return PathStatus::Found;
+  }
+  const uint32_t startCluster = m_mesh->poly(startPoly).cluster;
+  const uint32_t goalCluster = m_mesh->poly(goalPoly).cluster;
+  if (m_mesh->cluster(startCluster).component != m_mesh->cluster(goalCluster).component) return PathStatus::NoPath;
+
+  // Stamps mark what this search touched, so nothing is cleared per query.
+  auto nextStamp = [&]() {
+    if (++m_stamp == 0) {
+      for (Node& n : m_nodes) n.stamp = 0;
+      for (Node& n : m_clusterNodes) n.stamp = 0;
+      std::fill(m_allowed.begin(), m_allowed.end(), 0u);
+      m_stamp = 1;
+    }
+  };
+  nextStamp();
+  const bool restrict = coarsePath(startCluster, goalCluster);
+  PathStatus status = finePath(startPoly, start, goalPoly, goal, restrict, out);
+  if (restrict && status == PathStatus::NoPath) {
+    nextStamp();
+    status = finePath(startPoly, start, goalPoly, goal, false, out);
+  }
+  if (status == PathStatus::NoPath && !out.empty()) status = PathStatus::Partial;
+  return status;
+}
+
+bool NavQuery::coarsePath(uint32_t startCluster, uint32_t goalCluster) {
+  const NavMesh& mesh = *m_mesh;
+  if (startCluster != goalCluster) {
+    const Vec3 goal = clusterCenter(mesh.cluster(goalCluster));
+    m_open.clear();
+    m_clusterNodes[startCluster] = { 0.0f, UINT32_MAX, m_stamp, false, {} };
+    m_open.push_back({ distance(clusterCenter(mesh.cluster(startCluster)), goal), startCluster });
+    bool reached = false;
+    while (!m_open.empty()) {
+      std::pop_heap(m_open.begin(), m_open.end());
+      const uint32_t c = m_open.back().node;
+      m_open.pop_back();
+      Node& n = m_clusterNodes[c];
+      if (n.closed) continue;
+      n.closed = true;
+      if (c == goalCluster) {
+        reached = true;
+        break;
+      }
+      const NavCluster& cl = mesh.cluster(c);
+      for (uint32_t l = cl.firstLink; l < cl.firstLink + cl.linkCount; ++l) {
+        const NavClusterLink& link = mesh.link(l);
+        Node& m = m_clusterNodes[link.cluster];
+        const float g = n.g + link.cost;
+        if (m.stamp == m_stamp && (m.closed || g >= m.g)) continue;
+        m = { g, c, m_stamp, false, {} };
+        m_open.push_back({ g + distance(clusterCenter(mesh.cluster(link.cluster)), goal), link.cluster });
+        std::push_heap(m_open.begin(), m_open.end());
+      }
+    }
+    if (!reached) return false;
+  }
+
+  for (uint32_t c = goalCluster; c != UINT32_MAX; c = c == startCluster ? UINT32_MAX : m_clusterNodes[c].parent)
+    m_allowed[c] = m_stamp;
+  return true;
+}
+
+PathStatus NavQuery::finePath(uint32_t startPoly, const Vec3& start, uint32_t goalPoly, const Vec3& goal,
+                              bool restrict, std::vector<uint32_t>& out) {
+  const NavMesh& mesh = *m_mesh;
+  m_open.clear();
+  m_nodes[startPoly] = { 0.0f, UINT32_MAX, m_stamp, false, start };
+  m_open.push_back({ distance(start, goal), startPoly });
+
+  uint32_t best = startPoly;
+  float bestH = distance(start, goal);
+  uint32_t expanded = 0;
+  PathStatus status = PathStatus::NoPath;
+  while (!m_open.empty()) {
+    std::pop_heap(m_open.begin(), m_open.end());
+    const uint32_t p = m_open.back().node;
+    m_open.pop_back();
+    Node& n = m_nodes[p];
+    if (n.closed) continue;
+    n.closed = true;
+    if (p == goalPoly) {
+      best = goalPoly;
+      status = PathStatus::Found;
+      break;
+    }
+    if (++expanded > m_maxNodes) {
+      status = PathStatus::Partial;
+      break;
+    }
+
+    const NavPoly& poly = mesh.poly(p);
+    for (uint32_t e = 0; e < poly.vertCount; ++e) {
+      const uint32_t nb = poly.neighbors[e];
+      if (nb == kNoNeighbor) continue;
+      if (restrict && m_allowed[mesh.poly(nb).cluster] != m_stamp) continue;
+      Node& m = m_nodes[nb];
+      if (m.stamp == m_stamp && m.closed) continue;
+
+      const Vec3 mid = (mesh.vertex(poly.verts[e]) + mesh.vertex(poly.verts[(e + 1) % poly.vertCount])) * 0.5f;
+      float g = n.g + distance(n.pos, mid);
+      float h = distance(mid, goal);
+      if (nb == goalPoly) {
+        g += h;
+        h = 0.0f;
+      }
+      if (m.stamp == m_stamp && g >= m.g) continue;
+      m = { g, p, m_stamp, false, mid };
+      m_open.push_back({ g + h, nb });
+      std::push_heap(m_open.begin(), m_open.end());
+      if (h < bestH) {
+        bestH = h;
+        best = nb;
+      }
+    }
+  }
+
+  out.clear();
+  for (uint32_t p = best; p != UINT32_MAX; p = m_nodes[p].parent) out.push_back(p);
+  std::reverse(out.begin(), out.end());
+  return status;
+}
+
+void NavQuery::straighten(const std::vector<uint32_t>& corridor, const Vec3& start, const Vec3& goal,
+                          std::vector<Vec3>& out) const {
+  out.clear();
+  out.push_back(start);
+  if (corridor.empty()) return;
+
+  // Portals along the corridor; the goal closes it as a zero-width one.
+  const size_t count = corridor.size();
+  auto portalAt = [&](size_t i, Vec3& left, Vec3& right) {
+    if (i + 1 < count && m_mesh->portal(corridor[i], corridor[i + 1], left, right)) return;
+    left = right = goal;
+  };
+
+  Vec3 apex = start, left = start, right = start;
+  size_t apexIndex = 0, leftIndex = 0, rightIndex = 0;
+  for (size_t i = 0; i < count; ++i) {
+    Vec3 l, r;
+    portalAt(i, l, r);
+
+    // Narrow the right side while it does not cross the left one.
+    if (area2(apex, right, r) >= 0.0f) {
+      if (samePoint(apex, right) || area2(apex, left, r) < 0.0f) {
+        right = r;
+        rightIndex = i;
+      } else {
+        // Right crossed left: the left point is a corner.
+        apex = left;
+        apexIndex = leftIndex;
+        if (!samePoint(out.back(), apex)) out.push_back(apex);
+        left = right = apex;
+        leftIndex = rightIndex = apexIndex;
+        i = apexIndex;
+        continue;
+      }
+    }
+    if (area2(apex, left, l) <= 0.0f) {
+      if (samePoint(apex, left) || area2(apex, right, l) > 0.0f) {
+        left = l;
+        leftIndex = i;
+      } else {
+        apex = right;
+        apexIndex = rightIndex;
+        if (!samePoint(out.back(), apex)) out.push_back(apex);
+        left = right = apex;
+        leftIndex = rightIndex = apexIndex;
+        i = apexIndex;
+        continue;
+      }
+    }
+  }
+  if (!samePoint(out.back(), goal)) out.push_back(goal);
+}
+
+} // namespace nav
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "NavMesh.h"
+
+namespace nav {
+
+enum class PathStatus : uint32_t {
+  Found = 0,   // reaches the goal
+  Partial = 1, // search budget ran out; ends as close to the goal as it got
+  NoPath = 2,  // start or goal off the mesh, or not connected
+};
+
+/// Path search over one NavMesh, two levels deep:
+///
+///   coarse  A* over the cluster graph from the start's to the goal's
+///           cluster; clusters in different connected areas fail at once
+///   fine    A* over polygons, restricted to the clusters of the coarse
+///           path, moving between edge midpoints; unrestricted if that
+///           corridor turns out blocked
+///
+/// corridor() returns the polygon sequence, straighten() pulls it tight
+/// into corner points (simple stupid funnel).
+///
+/// Owns its scratch, so one query per thread; the mesh is shared.
+class NavQuery {
+public:
+  static constexpr uint32_t kDefaultMaxNodes = 4096;
+
+  void init(const NavMesh& mesh, uint32_t maxNodes = kDefaultMaxNodes);
+
+  PathStatus corridor(uint32_t startPoly, const Vec3& start, uint32_t goalPoly, const Vec3& goal,
+                      std::vector<uint32_t>& out);
+
+  /// Corner points from `start` to `goal` (both included) through the
+  /// polygons of `corridor`.
+  void straighten(const std::vector<uint32_t>& corridor, const Vec3& start, const Vec3& goal,
+                  std::vector<Vec3>& out) const;
+
+private:
+  struct Node {
+    float g = 0.0f;
+    uint32_t parent = UINT32_MAX;
+    uint32_t stamp = 0; // == m_stamp: visited in this search
+    bool closed = false;
+    Vec3 pos;           // where the path enters the polygon
+  };
+  struct Open {
+    float f;
+    uint32_t node;
+    bool operator<(const Open& o) const { return f > o.f; } // min-heap
+  };
+
+  bool coarsePath(uint32_t startCluster, uint32_t goalCluster);
+  PathStatus finePath(uint32_t startPoly, const Vec3& start, uint32_t goalPoly, const Vec3& goal, bool restrict,
+                      std::vector<uint32_t>& out);
+
+  const NavMesh* m_mesh = nullptr;
+  uint32_t m_maxNodes = kDefaultMaxNodes;
+
+  memory::TrackedVector<Node, memory::MemTag::Navigation> m_nodes;        // per polygon
+  memory::TrackedVector<Node, memory::MemTag::Navigation> m_clusterNodes; // per cluster
+  memory::TrackedVector<uint32_t, memory::MemTag::Navigation> m_allowed;  // == m_stamp: cluster open to the fine search
+  memory::TrackedVector<Open, memory::MemTag::Navigation> m_open;
+  uint32_t m_stamp = 0;
+};
+
+} // namespace nav
@@ -0,0 +1,158 @@
+#include "NavSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace nav {
+
+namespace {
+
+constexpr uint32_t kRequestsPerJob = 4;
+const Vec3 kSnapExtents{ 2.0f, 4.0f, 2.0f }; // how far off the mesh an endpoint may be
+
+uint64_t cacheKey(uint32_t startPoly, uint32_t goalPoly) { return ((uint64_t)startPoly << 32) | goalPoly; }
+
+} // namespace
+
+void NavSystem::init(core::JobSystem& jobs, uint32_t batchSize) {
+  m_jobs = &jobs;
+  m_batchSize = std::max(batchSize, 1u);
+  m_queries.clear();
+  for (unsigned i = 0; i < std::max(jobs.threadCount(), 1u); ++i) m_queries.push_back(std::make_unique<NavQuery>());
+}
+
+void NavSystem::shutdown() {
+  unload();
+  m_queries.clear();
+  m_results.clear();
+  m_resultOrder.clear();
+  m_finished.clear();
+  m_completed.clear();
+  m_jobs = nullptr;
+}
+
+bool NavSystem::load(const char* path) {
+  unload();
+  if (!m_mesh.load(path)) return false;
+  for (auto& q : m_queries) q->init(m_mesh);
+  return true;
+}
+
+void NavSystem::unload() {
+  waitForBatch();
+  // Staged for the next update(), like the pending ones: finished() is
+  // what the last one already reported.
+  if (m_batchRunning) collect(m_completed);
+  for (const Request& r : m_pending) m_completed.push_back({ r.id, PathStatus::NoPath, 0 });
+  m_pending.clear();
+  m_cache.clear();
+  m_cacheIndex.clear();
+  m_mesh.clear();
+}
+
+PathId NavSystem::requestPath(const Vec3& from, const Vec3& to) {
+  if (!m_jobs || m_mesh.empty()) return kInvalidPath;
+  Request r;
+  r.id = m_nextId++;
+  if (m_nextId == kInvalidPath) m_nextId = 0;
+  r.from = from;
+  r.to = to;
+  m_pending.push_back(std::move(r));
+  return m_pending.back().id;
+}
+
+void NavSystem::solve(Request& r, NavQuery& query) const {
+  Vec3 start, goal;
+  r.startPoly = m_mesh.findNearestPoly(r.from, kSnapExtents, start);
+  r.goalPoly = m_mesh.findNearestPoly(r.to, kSnapExtents, goal);
+  if (r.startPoly == UINT32_MAX || r.goalPoly == UINT32_MAX) {
+    r.status = PathStatus::NoPath;
+    return;
+  }
+
+  const std::vector<uint32_t>* corridor = &r.corridor;
+  auto it = m_cacheIndex.find(cacheKey(r.startPoly, r.goalPoly));
+  if (it != m_cacheIndex.end()) {
+    r.cacheHit = true;
+    r.status = PathStatus::Found;
+    corridor = &it->second->corridor;
+  } else {
+    r.status = query.corridor(r.startPoly, start, r.goalPoly, goal, r.corridor);
+  }
+  if (r.status == PathStatus::NoPath) return;
+  if (r.status == PathStatus::Partial) goal = m_mesh.closestPointOnPoly(corridor->back(), goal);
+  query.straighten(*corridor, start, goal, r.points);
+}
+
+void NavSystem::waitForBatch() {
+  if (m_batchRunning) m_jobs->wait(m_batchJobs);
+}
+
+void NavSystem::collect(std::vector<PathEvent>& events) {
+  for (Request& r : m_batch) {
+    const uint64_t key = cacheKey(r.startPoly, r.goalPoly);
+    if (r.cacheHit) {
+      // Most recently used first.
+      auto it = m_cacheIndex.find(key);
+      if (it != m_cacheIndex.end()) m_cache.splice(m_cache.begin(), m_cache, it->second);
+    } else if (r.status == PathStatus::Found && r.corridor.size() > 1 && !m_cacheIndex.count(key)) {
+      m_cache.push_front({ key, std::move(r.corridor) });
+      m_cacheIndex[key] = m_cache.begin();
+      if (m_cache.size() > kCacheCapacity) {
+        m_cacheIndex.erase(m_cache.back().key);
+        m_cache.pop_back();
+      }
+    }
+    events.push_back({ r.id, r.status, (uint32_t)r.points.size() });
+    if (!r.points.empty()) {
+      m_results[r.id] = { std::move(r.points), m_updates };
+      m_resultOrder.push_back(r.id);
+    }
+  }
+  m_batch.clear();
+  m_batchRunning = false;
+  m_lastBatchMs =
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_batchStart).count();
+}
+
+void NavSystem::update() {
+  m_finished.swap(m_completed);
+  m_completed.clear();
+  ++m_updates;
+  // Paths a script asked for and never fetched.
+  while (!m_resultOrder.empty()) {
+    auto it = m_results.find(m_resultOrder.front());
+    if (it != m_results.end() && m_updates - it->second.update < kResultUpdates) break;
+    if (it != m_results.end()) m_results.erase(it);
+    m_resultOrder.pop_front();
+  }
+  if (!m_jobs) return;
+  if (m_batchRunning && m_batchJobs.done()) collect(m_finished);
+  if (m_batchRunning || m_pending.empty()) return;
+
+  const size_t count = std::min<size_t>(m_batchSize, m_pending.size());
+  m_batch.clear();
+  for (size_t i = 0; i < count; ++i) {
+    m_batch.push_back(std::move(m_pending.front()));
+    m_pending.pop_front();
+  }
+  m_batchRunning = true;
+  m_batchStart = std::chrono::steady_clock::now();
+  for (uint32_t begin = 0; begin < (uint32_t)count; begin += kRequestsPerJob) {
+    const uint32_t end = std::min(begin + kRequestsPerJob, (uint32_t)count);
+    m_jobs->run([this, begin, end]() {
+      const int thread = core::JobSystem::threadIndex();
+      NavQuery& query = *m_queries[thread < 0 ? 0 : (uint32_t)thread];
+      for (uint32_t i = begin; i < end; ++i) solve(m_batch[i], query);
+    }, &m_batchJobs);
+  }
+}
+
+const std::vector<Vec3>* NavSystem::path(PathId id) const {
+  auto it = m_results.find(id);
+  return it != m_results.end() ? &it->second.points : nullptr;
+}
+
+void NavSystem::release(PathId id) { m_results.erase(id); }
+
+} // namespace nav
@@ -0,0 +1,127 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../core/JobSystem.h"
+#include "NavMesh.h"
+#include "NavQuery.h"
+
+namespace nav {
+
+using PathId = uint32_t;
+constexpr PathId kInvalidPath = UINT32_MAX;
+
+/// A path that finished during the last update().
+struct PathEvent {
+  PathId id = kInvalidPath;
+  PathStatus status = PathStatus::NoPath;
+  uint32_t pointCount = 0;
+};
+
+/// Asynchronous pathfinding for the game's agents.
+///
+/// requestPath() only queues. update() hands up to batchSize queued
+/// requests to the job system, a few per job, and returns right away; the
+/// batch runs while the frame goes on and is collected by a later update()
+/// once every job finished, so a crowd repathing at once spreads over frames
+/// instead of stalling one. Each job thread has its own NavQuery scratch.
+///
+/// Per request the job snaps both ends onto the mesh, takes the polygon
+/// corridor from the cache (keyed by start and goal polygon; agents chasing
+/// the same target tend to repeat them) or searches it, and straightens it.
+/// Only the main thread writes the cache, between batches.
+///
+/// finished() lists what completed in the last update(); the points stay
+/// available through path() until release(), or kResultUpdates updates if
+/// nobody releases them.
+///
+/// Not thread safe: call everything from the main thread.
+class NavSystem {
+public:
+  static constexpr uint32_t kDefaultBatchSize = 64;
+  static constexpr uint32_t kCacheCapacity = 512;
+  static constexpr uint32_t kResultUpdates = 600; // ~10 s at 60 Hz
+
+  void init(core::JobSystem& jobs, uint32_t batchSize = kDefaultBatchSize);
+  void shutdown();
+
+  /// Replaces the mesh (waits for the running batch, drops the cache).
+  /// False with the old mesh gone if the file does not load.
+  bool load(const char* path);
+  void unload();
+  bool loaded() const { return !m_mesh.empty(); }
+  uint32_t polyCount() const { return m_mesh.polyCount(); }
+
+  /// kInvalidPath if no mesh is loaded.
+  PathId requestPath(const Vec3& from, const Vec3& to);
+
+  /// Collects a finished batch and starts the next one. Once per frame.
+  void update();
+
+  const std::vector<PathEvent>& finished() const { return m_finished; }
+
+  /// Corner points of a finished path (start and goal included), null if
+  /// unknown or released.
+  const std::vector<Vec3>* path(PathId id) const;
+  void release(PathId id);
+
+  uint32_t pendingCount() const { return (uint32_t)m_pending.size(); }
+  double lastBatchMs() const { return m_lastBatchMs; }
+
+private:
+  struct Request {
+    PathId id = kInvalidPath;
+    Vec3 from, to;
+
+    // Filled by the job.
+    PathStatus status = PathStatus::NoPath;
+    uint32_t startPoly = UINT32_MAX, goalPoly = UINT32_MAX;
+    bool cacheHit = false;
+    std::vector<uint32_t> corridor; // searched, for the cache
+    std::vector<Vec3> points;
+  };
+
+  struct Result {
+    std::vector<Vec3> points;
+    uint32_t update = 0; // m_updates when it finished
+  };
+
+  struct CacheEntry {
+    uint64_t key;
+    std::vector<uint32_t> corridor;
+  };
+
+  void solve(Request& r, NavQuery& query) const;
+  void collect(std::vector<PathEvent>& events);
+  void waitForBatch();
+
+  core::JobSystem* m_jobs = nullptr;
+  uint32_t m_batchSize = kDefaultBatchSize;
+  NavMesh m_mesh;
+  std::vector<std::unique_ptr<NavQuery>> m_queries; // per job thread
+
+  std::deque<Request> m_pending;
+  std::vector<Request> m_batch;
+  core::JobCounter m_batchJobs;
+  bool m_batchRunning = false;
+  std::chrono::steady_clock::time_point m_batchStart;
+  double m_lastBatchMs = 0.0;
+
+  // LRU of corridors, most recent first. Read by jobs, written between batches.
+  std::list<CacheEntry> m_cache;
+  std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> m_cacheIndex;
+
+  std::unordered_map<PathId, Result> m_results;
+  std::deque<PathId> m_resultOrder; // finishing order, for expiry; may hold released ids
+  uint32_t m_updates = 0;
+  std::vector<PathEvent> m_finished;  // reported by the last update()
+  std::vector<PathEvent> m_completed; // for the next one
+  PathId m_nextId = 0;
+};
+
+} // namespace nav
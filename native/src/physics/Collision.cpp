@@ -0,0 +1,257 @@
+#include "Collision.h"
+
+namespace physics {
+
+Aabb computeAabb(const ShapeInstance& s) {
+  Vec3 e;
+  if (s.shape->type == ShapeType::Sphere) {
+    e = { s.shape->radius, s.shape->radius, s.shape->radius };
+  } else {
+    const Vec3 h = s.shape->halfExtents;
+    const Mat3& r = s.rotation;
+    e = { dot(vabs(r.r[0]), h), dot(vabs(r.r[1]), h), dot(vabs(r.r[2]), h) };
+  }
+  return { s.position - e, s.position + e };
+}
+
+namespace {
+
+bool sphereSphere(const ShapeInstance& a, const ShapeInstance& b, float margin, ContactManifold& out) {
+  Vec3 d = b.position - a.position;
+  float dist = length(d);
+  float ra = a.shape->radius, rb = b.shape->radius;
+  float sep = dist - ra - rb;
+  if (sep > margin) return false;
+
+  Vec3 n = dist > 1e-6f ? d * (1.0f / dist) : Vec3{ 0.0f, 1.0f, 0.0f };
+  Vec3 surfaceA = a.position + n * ra;
+  Vec3 surfaceB = b.position - n * rb;
+  out.normal = n;
+  out.points[0] = { (surfaceA + surfaceB) * 0.5f, -sep };
+  out.count = 1;
+  return true;
+}
+
+// Normal from the box to the sphere.
+bool boxSphere(const ShapeInstance& box, const ShapeInstance& sphere, float margin, ContactManifold& out) {
+  const Vec3 h = box.shape->halfExtents;
+  const float r = sphere.shape->radius;
+  Vec3 c = transpose(box.rotation) * (sphere.position - box.position);
+  Vec3 closest{ std::clamp(c.x, -h.x, h.x), std::clamp(c.y, -h.y, h.y), std::clamp(c.z, -h.z, h.z) };
+  Vec3 d = c - closest;
+  float distSq = lengthSq(d);
+
+  Vec3 nLocal, surface;
+  float sep;
+  if (distSq > 1e-12f) {
+    float dist = std::sqrt(distSq);
+    sep = dist - r;
+    if (sep > margin) return false;
+    nLocal = d * (1.0f / dist);
+    surface = closest;
+  } else {
+    // Center inside the box: push out through the nearest face.
+    int axis = 0;
+    float best = h.x - std::fabs(c.x);
+    for (int i = 1; i < 3; ++i) {
+      float gap = component(h, i) - std::fabs(component(c, i));
+      if (gap < best) { best = gap; axis = i; }
+    }
+    float sign = component(c, axis) < 0.0f ? -1.0f : 1.0f;
+    nLocal = { axis == 0 ? sign : 0.0f, axis == 1 ? sign : 0.0f, axis == 2 ? sign : 0.0f };
+    surface = c + nLocal * best;
+    sep = -best - r;
+  }
+
+  Vec3 n = box.rotation * nLocal;
+  Vec3 surfaceBox = box.position + box.rotation * surface;
+  Vec3 surfaceSphere = sphere.position - n * r;
+  out.normal = n;
+  out.points[0] = { (surfaceBox + surfaceSphere) * 0.5f, -sep };
+  out.count = 1;
+  return true;
+}
+
+struct Box {
+  Vec3 center;
+  Vec3 axis[3];
+  float half[3];
+};
+
+Box makeBox(const ShapeInstance& s) {
+  Box b;
+  b.center = s.position;
+  for (int i = 0; i < 3; ++i) {
+    b.axis[i] = s.rotation.col(i);
+    b.half[i] = component(s.shape->halfExtents, i);
+  }
+  return b;
+}
+
+float projectedRadius(const Box& b, Vec3 l) {
+  return b.half[0] * std::fabs(dot(b.axis[0], l)) + b.half[1] * std::fabs(dot(b.axis[1], l)) +
+         b.half[2] * std::fabs(dot(b.axis[2], l));
+}
+
+// Sutherland-Hodgman against dot(n, x) <= offset.
+uint32_t clipPolygon(const Vec3* in, uint32_t count, Vec3 n, float offset, Vec3* out) {
+  uint32_t outCount = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    Vec3 p = in[i], q = in[(i + 1) % count];
+    float dp = dot(n, p) - offset, dq = dot(n, q) - offset;
+    if (dp <= 0.0f) out[outCount++] = p;
+    if ((dp < 0.0f && dq > 0.0f) || (dp > 0.0f && dq < 0.0f)) out[outCount++] = p + (q - p) * (dp / (dp - dq));
+  }
+  return outCount;
+}
+
+// Keeps the deepest point and the three that span the largest area.
+void reduceManifold(ContactManifold& m, const ContactPoint* points, uint32_t count) {
+  if (count <= ContactManifold::kMaxPoints) {
+    for (uint32_t i = 0; i < count; ++i) m.points[i] = points[i];
+    m.count = count;
+    return;
+  }
+  uint32_t i0 = 0;
+  for (uint32_t i = 1; i < count; ++i) {
+    if (points[i].depth > points[i0].depth) i0 = i;
+  }
+  uint32_t i1 = i0;
+  float best = -1.0f;
+  for (uint32_t i = 0; i < count; ++i) {
+    float d = lengthSq(points[i].position - points[i0].position);
+    if (d > best) { best = d; i1 = i; }
+  }
+  Vec3 p0 = points[i0].position, p1 = points[i1].position;
+  uint32_t i2 = i0, i3 = i0;
+  float maxArea = 0.0f, minArea = 0.0f;
+  for (uint32_t i = 0; i < count; ++i) {
+    float area = dot(cross(p1 - p0, points[i].position - p0), m.normal);
+    if (area > maxArea) { maxArea = area; i2 = i; }
+    if (area < minArea) { minArea = area; i3 = i; }
+  }
+  m.count = 0;
+  for (uint32_t i : { i0, i1, i2, i3 }) {
+    bool dup = false;
+    for (uint32_t k = 0; k < m.count; ++k) dup |= lengthSq(m.points[k].position - points[i].position) < 1e-10f;
+    if (!dup) m.points[m.count++] = points[i];
+  }
+}
+
+bool boxBox(const ShapeInstance& sa, const ShapeInstance& sb, float margin, ContactManifold& out) {
+  const Box a = makeBox(sa), b = makeBox(sb);
+  const Vec3 t = b.center - a.center;
+
+  // Separating axis test; keep the best (least penetrating) face of each
+  // box and edge pair.
+  float faceSep[2] = { -INFINITY, -INFINITY };
+  int faceAxis[2] = { 0, 0 };
+  for (int box = 0; box < 2; ++box) {
+    const Box& ref = box == 0 ? a : b;
+    const Box& other = box == 0 ? b : a;
+    for (int i = 0; i < 3; ++i) {
+      float sep = std::fabs(dot(t, ref.axis[i])) - ref.half[i] - projectedRadius(other, ref.axis[i]);
+      if (sep > margin) return false;
+      if (sep > faceSep[box]) { faceSep[box] = sep; faceAxis[box] = i; }
+    }
+  }
+  float edgeSep = -INFINITY;
+  Vec3 edgeAxis;
+  int edgeA = 0, edgeB = 0;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      Vec3 l = cross(a.axis[i], b.axis[j]);
+      float len = length(l);
+      if (len < 1e-4f) continue; // parallel edges: a face axis covers it
+      l = l * (1.0f / len);
+      float sep = std::fabs(dot(t, l)) - projectedRadius(a, l) - projectedRadius(b, l);
+      if (sep > margin) return false;
+      if (sep > edgeSep) { edgeSep = sep; edgeAxis = l; edgeA = i; edgeB = j; }
+    }
+  }
+
+  // Faces give stable multi-point manifolds; take an edge only when it is
+  // clearly the better axis.
+  const float faceBest = std::max(faceSep[0], faceSep[1]);
+  if (edgeSep > faceBest + 0.02f) {
+    Vec3 n = dot(edgeAxis, t) < 0.0f ? -edgeAxis : edgeAxis;
+    // Supporting edges: A's furthest along n, B's furthest along -n.
+    Vec3 pa = a.center, pb = b.center;
+    for (int k = 0; k < 3; ++k) {
+      if (k != edgeA) pa += a.axis[k] * (dot(a.axis[k], n) > 0.0f ? a.half[k] : -a.half[k]);
+      if (k != edgeB) pb += b.axis[k] * (dot(b.axis[k], n) > 0.0f ? -b.half[k] : b.half[k]);
+    }
+    // Closest points of the two edge lines, clamped to the edges.
+    Vec3 da = a.axis[edgeA], db = b.axis[edgeB];
+    Vec3 r = pa - pb;
+    float e = dot(da, db), f = dot(db, r), c = dot(da, r);
+    float denom = 1.0f - e * e;
+    float s = denom > 1e-6f ? std::clamp((e * f - c) / denom, -a.half[edgeA], a.half[edgeA]) : 0.0f;
+    float u = std::clamp(e * s + f, -b.half[edgeB], b.half[edgeB]);
+    Vec3 ca = pa + da * s, cb = pb + db * u;
+    out.normal = n;
+    out.points[0] = { (ca + cb) * 0.5f, -edgeSep };
+    out.count = 1;
+    return true;
+  }
+
+  // Face contact: clip the incident face against the reference face.
+  const bool refIsA = faceSep[0] + 0.005f >= faceSep[1];
+  const Box& ref = refIsA ? a : b;
+  const Box& inc = refIsA ? b : a;
+  const int ri = faceAxis[refIsA ? 0 : 1];
+  const Vec3 toInc = refIsA ? t : -t;
+  Vec3 n = dot(ref.axis[ri], toInc) < 0.0f ? -ref.axis[ri] : ref.axis[ri];
+
+  int ii = 0;
+  float bestDot = -1.0f;
+  for (int j = 0; j < 3; ++j) {
+    float d = std::fabs(dot(n, inc.axis[j]));
+    if (d > bestDot) { bestDot = d; ii = j; }
+  }
+  Vec3 incNormal = dot(n, inc.axis[ii]) > 0.0f ? -inc.axis[ii] : inc.axis[ii];
+  Vec3 incCenter = inc.center + incNormal * inc.half[ii];
+  int iu = (ii + 1) % 3, iv = (ii + 2) % 3;
+  Vec3 u = inc.axis[iu] * inc.half[iu], v = inc.axis[iv] * inc.half[iv];
+
+  Vec3 polyA[8] = { incCenter + u + v, incCenter - u + v, incCenter - u - v, incCenter + u - v };
+  Vec3 polyB[8];
+  uint32_t count = 4;
+  for (int k = 1; k <= 2 && count > 0; ++k) {
+    int side = (ri + k) % 3;
+    Vec3 s = ref.axis[side];
+    float c = dot(s, ref.center);
+    count = clipPolygon(polyA, count, s, c + ref.half[side], polyB);
+    count = clipPolygon(polyB, count, -s, -c + ref.half[side], polyA);
+  }
+  if (count == 0) return false;
+
+  const float refOffset = dot(n, ref.center) + ref.half[ri];
+  ContactPoint points[8];
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    float sep = dot(n, polyA[i]) - refOffset;
+    if (sep > margin) continue;
+    points[kept++] = { polyA[i] - n * (sep * 0.5f), -sep };
+  }
+  if (kept == 0) return false;
+
+  out.normal = refIsA ? n : -n;
+  reduceManifold(out, points, kept);
+  return true;
+}
+
+} // namespace
+
+bool collide(const ShapeInstance& a, const ShapeInstance& b, float margin, ContactManifold& out) {
+  out.count = 0;
+  const ShapeType ta = a.shape->type, tb = b.shape->type;
+  if (ta == ShapeType::Sphere && tb == ShapeType::Sphere) return sphereSphere(a, b, margin, out);
+  if (ta == ShapeType::Box && tb == ShapeType::Box) return boxBox(a, b, margin, out);
+  if (ta == ShapeType::Box) return boxSphere(a, b, margin, out);
+  if (!boxSphere(b, a, margin, out)) return false;
+  out.normal = -out.normal;
+  return true;
+}
+
+} // namespace physics
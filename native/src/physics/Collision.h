@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+#include "PhysicsMath.h"
+
+namespace physics {
+
+enum class ShapeType : uint8_t { Sphere, Box };
+
+/// Collision shape in body space, centered on the body origin.
+struct Shape {
+  ShapeType type = ShapeType::Box;
+  Vec3 halfExtents{ 0.5f, 0.5f, 0.5f }; // Box
+  float radius = 0.5f;                  // Sphere
+};
+
+/// Shape placed in the world.
+struct ShapeInstance {
+  const Shape* shape = nullptr;
+  Vec3 position;
+  Mat3 rotation; // body to world
+};
+
+Aabb computeAabb(const ShapeInstance& s);
+
+struct ContactPoint {
+  Vec3 position;   // world, halfway between the surfaces
+  float depth = 0; // penetration, > 0 when overlapping
+};
+
+/// Up to four contact points sharing one normal, pointing from A to B.
+struct ContactManifold {
+  static constexpr uint32_t kMaxPoints = 4;
+  Vec3 normal;
+  ContactPoint points[kMaxPoints];
+  uint32_t count = 0;
+};
+
+/// Points closer than `margin` count as touching too (speculative contacts
+/// keep resting stacks from jittering in and out of contact). False if the
+/// shapes are further apart.
+bool collide(const ShapeInstance& a, const ShapeInstance& b, float margin, ContactManifold& out);
+
+} // namespace physics
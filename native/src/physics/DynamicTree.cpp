@@ -0,0 +1,194 @@
+#include "DynamicTree.h"
+
+#include <cassert>
+
+namespace physics {
+
+uint32_t DynamicTree::allocNode() {
+  if (m_free == kNull) {
+    m_nodes.emplace_back();
+    m_nodes.back().height = 0;
+    return (uint32_t)m_nodes.size() - 1;
+  }
+  uint32_t node = m_free;
+  m_free = m_nodes[node].parent;
+  m_nodes[node] = Node{};
+  m_nodes[node].height = 0;
+  return node;
+}
+
+void DynamicTree::freeNode(uint32_t node) {
+  m_nodes[node].parent = m_free;
+  m_nodes[node].height = -1;
+  m_free = node;
+}
+
+uint32_t DynamicTree::createProxy(const Aabb& box, uint32_t userData) {
+  uint32_t proxy = allocNode();
+  Vec3 margin{ kMargin, kMargin, kMargin };
+  m_nodes[proxy].box = { box.min - margin, box.max + margin };
+  m_nodes[proxy].userData = userData;
+  insertLeaf(proxy);
+  ++m_proxyCount;
+  return proxy;
+}
+
+void DynamicTree::destroyProxy(uint32_t proxy) {
+  assert(m_nodes[proxy].isLeaf());
+  removeLeaf(proxy);
+  freeNode(proxy);
+  --m_proxyCount;
+}
+
+bool DynamicTree::moveProxy(uint32_t proxy, const Aabb& box, Vec3 displacement) {
+  Node& n = m_nodes[proxy];
+  if (n.box.contains(box)) return false;
+
+  removeLeaf(proxy);
+  Vec3 margin{ kMargin, kMargin, kMargin };
+  Aabb fat{ box.min - margin, box.max + margin };
+  Vec3 d = displacement * kDisplacementScale;
+  if (d.x < 0.0f) fat.min.x += d.x; else fat.max.x += d.x;
+  if (d.y < 0.0f) fat.min.y += d.y; else fat.max.y += d.y;
+  if (d.z < 0.0f) fat.min.z += d.z; else fat.max.z += d.z;
+  m_nodes[proxy].box = fat;
+  insertLeaf(proxy);
+  return true;
+}
+
+void DynamicTree::insertLeaf(uint32_t leaf) {
+  if (m_root == kNull) {
+    m_root = leaf;
+    m_nodes[leaf].parent = kNull;
+    return;
+  }
+
+  // Descend towards the sibling with the least surface area growth.
+  const Aabb leafBox = m_nodes[leaf].box;
+  uint32_t index = m_root;
+  while (!m_nodes[index].isLeaf()) {
+    const Node& n = m_nodes[index];
+    float area = n.box.surfaceArea();
+    float combinedArea = merge(n.box, leafBox).surfaceArea();
+
+    // Cost of a new parent here, and the growth every ancestor inherits.
+    float cost = 2.0f * combinedArea;
+    float inheritance = 2.0f * (combinedArea - area);
+
+    auto childCost = [&](uint32_t child) {
+      const Node& c = m_nodes[child];
+      float grown = merge(leafBox, c.box).surfaceArea();
+      return c.isLeaf() ? grown + inheritance : grown - c.box.surfaceArea() + inheritance;
+    };
+    float cost1 = childCost(n.child1);
+    float cost2 = childCost(n.child2);
+
+    if (cost < cost1 && cost < cost2) break;
+    index = cost1 < cost2 ? n.child1 : n.child2;
+  }
+
+  uint32_t sibling = index;
+  uint32_t oldParent = m_nodes[sibling].parent;
+  uint32_t newParent = allocNode();
+  Node& p = m_nodes[newParent];
+  p.parent = oldParent;
+  p.box = merge(leafBox, m_nodes[sibling].box);
+  p.height = m_nodes[sibling].height + 1;
+  p.child1 = sibling;
+  p.child2 = leaf;
+  m_nodes[sibling].parent = newParent;
+  m_nodes[leaf].parent = newParent;
+
+  if (oldParent == kNull) {
+    m_root = newParent;
+  } else if (m_nodes[oldParent].child1 == sibling) {
+    m_nodes[oldParent].child1 = newParent;
+  } else {
+    m_nodes[oldParent].child2 = newParent;
+  }
+
+  // Refit and rebalance the ancestors.
+  for (index = m_nodes[leaf].parent; index != kNull; index = m_nodes[index].parent) {
+    index = balance(index);
+    Node& n = m_nodes[index];
+    const Node& c1 = m_nodes[n.child1];
+    const Node& c2 = m_nodes[n.child2];
+    n.height = 1 + std::max(c1.height, c2.height);
+    n.box = merge(c1.box, c2.box);
+  }
+}
+
+void DynamicTree::removeLeaf(uint32_t leaf) {
+  if (leaf == m_root) {
+    m_root = kNull;
+    return;
+  }
+
+  uint32_t parent = m_nodes[leaf].parent;
+  uint32_t grandParent = m_nodes[parent].parent;
+  uint32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+  if (grandParent == kNull) {
+    m_root = sibling;
+    m_nodes[sibling].parent = kNull;
+    freeNode(parent);
+    return;
+  }
+
+  if (m_nodes[grandParent].child1 == parent) m_nodes[grandParent].child1 = sibling;
+  else m_nodes[grandParent].child2 = sibling;
+  m_nodes[sibling].parent = grandParent;
+  freeNode(parent);
+
+  for (uint32_t index = grandParent; index != kNull; index = m_nodes[index].parent) {
+    index = balance(index);
+    Node& n = m_nodes[index];
+    const Node& c1 = m_nodes[n.child1];
+    const Node& c2 = m_nodes[n.child2];
+    n.box = merge(c1.box, c2.box);
+    n.height = 1 + std::max(c1.height, c2.height);
+  }
+}
+
+// If one child of `iA` is more than one level taller than the other, rotate
+// it up. Returns the node now at iA's place.
+uint32_t DynamicTree::balance(uint32_t iA) {
+  Node& A = m_nodes[iA];
+  if (A.isLeaf() || A.height < 2) return iA;
+
+  uint32_t iB = A.child1, iC = A.child2;
+  int diff = m_nodes[iC].height - m_nodes[iB].height;
+  if (diff >= -1 && diff <= 1) return iA;
+
+  // Rotate the taller child (`iUp`) up; A keeps the shorter one.
+  const bool rightHeavy = diff > 1;
+  uint32_t iUp = rightHeavy ? iC : iB;
+  uint32_t iKeep = rightHeavy ? iB : iC;
+  Node& Up = m_nodes[iUp];
+  uint32_t iF = Up.child1, iG = Up.child2;
+
+  Up.child1 = iA;
+  Up.parent = A.parent;
+  A.parent = iUp;
+  if (Up.parent == kNull) m_root = iUp;
+  else if (m_nodes[Up.parent].child1 == iA) m_nodes[Up.parent].child1 = iUp;
+  else m_nodes[Up.parent].child2 = iUp;
+
+  // The taller grandchild stays under Up, the shorter one moves to A.
+  uint32_t iTall = m_nodes[iF].height > m_nodes[iG].height ? iF : iG;
+  uint32_t iShort = iTall == iF ? iG : iF;
+  Up.child2 = iTall;
+  if (rightHeavy) A.child2 = iShort;
+  else A.child1 = iShort;
+  m_nodes[iShort].parent = iA;
+
+  const Node& keep = m_nodes[iKeep];
+  const Node& moved = m_nodes[iShort];
+  A.box = merge(keep.box, moved.box);
+  A.height = 1 + std::max(keep.height, moved.height);
+  Up.box = merge(A.box, m_nodes[iTall].box);
+  Up.height = 1 + std::max(A.height, m_nodes[iTall].height);
+  return iUp;
+}
+
+} // namespace physics
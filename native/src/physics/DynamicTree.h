@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "PhysicsMath.h"
+
+namespace physics {
+
+/// Dynamic AABB tree: the broadphase.
+///
+/// Leaves hold "fat" boxes, the shape's box grown by a margin and stretched
+/// along the last displacement, so a body that moves a little keeps its leaf
+/// untouched (moveProxy() returns false) and only bodies that leave their
+/// fat box are removed and reinserted. Insertion walks down by surface area
+/// cost and rebalances with rotations on the way up, keeping queries
+/// logarithmic however the bodies move.
+///
+/// Not thread safe; queries may run concurrently with each other but not
+/// with updates.
+class DynamicTree {
+public:
+  static constexpr uint32_t kNull = UINT32_MAX;
+  static constexpr float kMargin = 0.1f;          // fat box margin, world units
+  static constexpr float kDisplacementScale = 2.0f; // predicted motion in the fat box
+
+  uint32_t createProxy(const Aabb& box, uint32_t userData);
+  void destroyProxy(uint32_t proxy);
+
+  /// Refits after the shape moved by `displacement` since the last update.
+  /// False if the fat box still contains `box` (nothing changed).
+  bool moveProxy(uint32_t proxy, const Aabb& box, Vec3 displacement);
+
+  const Aabb& fatBox(uint32_t proxy) const { return m_nodes[proxy].box; }
+  uint32_t userData(uint32_t proxy) const { return m_nodes[proxy].userData; }
+
+  /// Calls fn(proxy) for every leaf whose fat box overlaps `box`; fn returns
+  /// false to stop.
+  template <class Fn>
+  void query(const Aabb& box, Fn&& fn) const {
+    if (m_root == kNull) return;
+    uint32_t stack[256];
+    uint32_t top = 0;
+    stack[top++] = m_root;
+    while (top > 0) {
+      const Node& n = m_nodes[stack[--top]];
+      if (!n.box.overlaps(box)) continue;
+      if (n.isLeaf()) {
+        if (!fn((uint32_t)(&n - m_nodes.data()))) return;
+      } else if (top + 2 <= 256) {
+        stack[top++] = n.child1;
+        stack[top++] = n.child2;
+      }
+    }
+  }
+
+  uint32_t proxyCount() const { return m_proxyCount; }
+  int height() const { return m_root == kNull ? 0 : m_nodes[m_root].height; }
+
+private:
+  struct Node {
+    Aabb box;
+    uint32_t userData = 0;
+    uint32_t parent = kNull; // next free node while on the free list
+    uint32_t child1 = kNull, child2 = kNull;
+    int height = -1; // leaf = 0, free = -1
+
+    bool isLeaf() const { return child1 == kNull; }
+  };
+
+  uint32_t allocNode();
+  void freeNode(uint32_t node);
+  void insertLeaf(uint32_t leaf);
+  void removeLeaf(uint32_t leaf);
+  uint32_t balance(uint32_t node);
+
+  memory::TrackedVector<Node, memory::MemTag::Physics> m_nodes;
+  uint32_t m_root = kNull;
+  uint32_t m_free = kNull;
+  uint32_t m_proxyCount = 0;
+};
+
+} // namespace physics
@@ -0,0 +1,126 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#include "../render/RenderMath.h"
+
+namespace physics {
+
+using render::Vec3;
+using render::cross;
+using render::dot;
+using render::length;
+using render::normalize;
+
+inline Vec3 operator-(Vec3 a) { return { -a.x, -a.y, -a.z }; }
+inline Vec3 operator*(float s, Vec3 a) { return a * s; }
+inline Vec3& operator+=(Vec3& a, Vec3 b) { a = a + b; return a; }
+inline Vec3& operator-=(Vec3& a, Vec3 b) { a = a - b; return a; }
+inline Vec3 mul(Vec3 a, Vec3 b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+inline Vec3 vmin(Vec3 a, Vec3 b) { return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) }; }
+inline Vec3 vmax(Vec3 a, Vec3 b) { return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+inline Vec3 vabs(Vec3 a) { return { std::fabs(a.x), std::fabs(a.y), std::fabs(a.z) }; }
+inline float lengthSq(Vec3 a) { return dot(a, a); }
+inline float component(Vec3 a, int i) { return i == 0 ? a.x : (i == 1 ? a.y : a.z); }
+
+/// Two unit vectors orthogonal to unit `n` (friction directions).
+inline void tangentBasis(Vec3 n, Vec3& t1, Vec3& t2) {
+  if (std::fabs(n.x) >= 0.57735f) t1 = normalize(Vec3{ n.y, -n.x, 0.0f });
+  else t1 = normalize(Vec3{ 0.0f, n.z, -n.y });
+  t2 = cross(n, t1);
+}
+
+/// Row-major 3x3; rows are r[0..2].
+struct Mat3 {
+  Vec3 r[3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+
+  Vec3 col(int i) const { return { component(r[0], i), component(r[1], i), component(r[2], i) }; }
+};
+
+inline Vec3 operator*(const Mat3& m, Vec3 v) { return { dot(m.r[0], v), dot(m.r[1], v), dot(m.r[2], v) }; }
+
+inline Mat3 transpose(const Mat3& m) {
+  Mat3 t;
+  for (int i = 0; i < 3; ++i) t.r[i] = m.col(i);
+  return t;
+}
+
+inline Mat3 operator*(const Mat3& a, const Mat3& b) {
+  Mat3 m;
+  for (int i = 0; i < 3; ++i) m.r[i] = { dot(a.r[i], b.col(0)), dot(a.r[i], b.col(1)), dot(a.r[i], b.col(2)) };
+  return m;
+}
+
+inline Mat3 diagonal(Vec3 d) {
+  Mat3 m;
+  m.r[0] = { d.x, 0, 0 };
+  m.r[1] = { 0, d.y, 0 };
+  m.r[2] = { 0, 0, d.z };
+  return m;
+}
+
+/// Unit rotation quaternion, w = cos(angle / 2).
+struct Quat {
+  float x = 0, y = 0, z = 0, w = 1;
+};
+
+inline Quat operator*(Quat a, Quat b) {
+  return {
+    a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+    a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+    a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+  };
+}
+
+inline Quat normalize(Quat q) {
+  float l = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+  if (l <= 0.0f) return Quat{};
+  float s = 1.0f / l;
+  return { q.x * s, q.y * s, q.z * s, q.w * s };
+}
+
+inline Quat axisAngle(Vec3 axis, float radians) {
+  Vec3 a = normalize(axis);
+  float s = std::sin(radians * 0.5f);
+  return { a.x * s, a.y * s, a.z * s, std::cos(radians * 0.5f) };
+}
+
+/// q advanced by angular velocity w over dt (first order, renormalized).
+inline Quat integrate(Quat q, Vec3 w, float dt) {
+  Quat spin{ w.x * dt * 0.5f, w.y * dt * 0.5f, w.z * dt * 0.5f, 0.0f };
+  Quat d = spin * q;
+  return normalize(Quat{ q.x + d.x, q.y + d.y, q.z + d.z, q.w + d.w });
+}
+
+inline Mat3 toMat3(Quat q) {
+  float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  Mat3 m;
+  m.r[0] = { 1 - 2 * (yy + zz), 2 * (xy - wz), 2 * (xz + wy) };
+  m.r[1] = { 2 * (xy + wz), 1 - 2 * (xx + zz), 2 * (yz - wx) };
+  m.r[2] = { 2 * (xz - wy), 2 * (yz + wx), 1 - 2 * (xx + yy) };
+  return m;
+}
+
+struct Aabb {
+  Vec3 min, max;
+
+  bool overlaps(const Aabb& o) const {
+    return min.x <= o.max.x && max.x >= o.min.x && min.y <= o.max.y && max.y >= o.min.y &&
+           min.z <= o.max.z && max.z >= o.min.z;
+  }
+  bool contains(const Aabb& o) const {
+    return min.x <= o.min.x && min.y <= o.min.y && min.z <= o.min.z && max.x >= o.max.x && max.y >= o.max.y &&
+           max.z >= o.max.z;
+  }
+  float surfaceArea() const {
+    Vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+};
+
+inline Aabb merge(const Aabb& a, const Aabb& b) { return { vmin(a.min, b.min), vmax(a.max, b.max) }; }
+
+} // namespace physics
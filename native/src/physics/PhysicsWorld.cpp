@@ -0,0 +1,604 @@
+#include "PhysicsWorld.h"
+#include "../core/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace physics {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+constexpr uint32_t kNone = UINT32_MAX;
+constexpr uint32_t kPairChunk = 64; // moved proxies per broadphase query job
+constexpr float kMatchDistanceSq = 0.05f * 0.05f; // warm-start point matching
+
+} // namespace
+
+void PhysicsWorld::init(core::JobSystem& jobs, const PhysicsSettings& settings) {
+  m_jobs = &jobs;
+  m_settings = settings;
+}
+
+void PhysicsWorld::shutdown() {
+  m_bodies.clear();
+  m_freeBodies.clear();
+  m_bodyCount = 0;
+  m_tree = DynamicTree{};
+  m_moved.clear();
+  m_contacts.clear();
+  m_contactIndex.clear();
+  m_jobs = nullptr;
+}
+
+void PhysicsWorld::updateInertia(Body& b) {
+  b.rotation = toMat3(b.orientation);
+  b.invInertiaWorld = b.rotation * diagonal(b.invInertiaLocal) * transpose(b.rotation);
+}
+
+BodyId PhysicsWorld::createBody(const BodyDesc& desc) {
+  BodyId id;
+  if (!m_freeBodies.empty()) {
+    id = m_freeBodies.back();
+    m_freeBodies.pop_back();
+  } else {
+    id = (BodyId)m_bodies.size();
+    m_bodies.emplace_back();
+  }
+
+  Body& b = m_bodies[id];
+  b = Body{};
+  b.shape = desc.shape;
+  b.position = desc.position;
+  b.orientation = normalize(desc.orientation);
+  b.friction = desc.friction;
+  b.restitution = desc.restitution;
+  if (desc.mass > 0.0f) {
+    b.invMass = 1.0f / desc.mass;
+    Vec3 inertia;
+    if (desc.shape.type == ShapeType::Sphere) {
+      float i = 0.4f * desc.mass * desc.shape.radius * desc.shape.radius;
+      inertia = { i, i, i };
+    } else {
+      Vec3 h = desc.shape.halfExtents;
+      inertia = Vec3{ h.y * h.y + h.z * h.z, h.x * h.x + h.z * h.z, h.x * h.x + h.y * h.y } * (desc.mass / 3.0f);
+    }
+    b.invInertiaLocal = { 1.0f / inertia.x, 1.0f / inertia.y, 1.0f / inertia.z };
+    b.v = desc.linearVelocity;
+    b.w = desc.angularVelocity;
+    b.awake = true;
+  }
+  updateInertia(b);
+  b.alive = true;
+  b.syncedPosition = b.position;
+  b.proxy = m_tree.createProxy(computeAabb(instance(b)), id);
+  b.moved = true;
+  m_moved.push_back(id);
+  ++m_bodyCount;
+  return id;
+}
+
+void PhysicsWorld::destroyBody(BodyId id) {
+  if (!valid(id)) return;
+  for (uint32_t i = (uint32_t)m_contacts.size(); i-- > 0;) {
+    const Contact& c = m_contacts[i];
+    if (c.a != id && c.b != id) continue;
+    wake(c.a == id ? c.b : c.a); // whatever rested on it falls
+    removeContact(i);
+  }
+  Body& b = m_bodies[id];
+  m_tree.destroyProxy(b.proxy);
+  if (b.moved) m_moved.erase(std::find(m_moved.begin(), m_moved.end(), id));
+  b = Body{};
+  m_freeBodies.push_back(id);
+  --m_bodyCount;
+}
+
+void PhysicsWorld::saveState(std::vector<BodyState>& out) const {
+  out.resize(m_bodies.size());
+  for (size_t i = 0; i < m_bodies.size(); ++i) {
+    const Body& b = m_bodies[i];
+    BodyState& s = out[i];
+    s = BodyState{};
+    if (!b.alive) continue;
+    s.position = b.position;
+    s.orientation = b.orientation;
+    s.linearVelocity = b.v;
+    s.angularVelocity = b.w;
+    s.halfExtents = b.shape.halfExtents;
+    s.radius = b.shape.radius;
+    s.invMass = b.invMass;
+    s.invInertia = b.invInertiaLocal;
+    s.friction = b.friction;
+    s.restitution = b.restitution;
+    s.sleepTime = b.sleepTime;
+    s.shape = (uint32_t)b.shape.type;
+    s.flags = kBodyAlive | (b.awake ? kBodyAwake : 0u);
+  }
+}
+
+void PhysicsWorld::loadState(const BodyState* slots, uint32_t count) {
+  m_bodies.clear();
+  m_freeBodies.clear();
+  m_bodyCount = 0;
+  m_tree = DynamicTree{};
+  m_moved.clear();
+  m_contacts.clear();
+  m_contactIndex.clear();
+
+  m_bodies.resize(count);
+  for (uint32_t i = count; i-- > 0;) { // free list hands out low ids first, like a fresh world
+    const BodyState& s = slots[i];
+    if (!(s.flags & kBodyAlive)) {
+      m_freeBodies.push_back(i);
+      continue;
+    }
+    Body& b = m_bodies[i];
+    b.shape.type = s.shape == (uint32_t)ShapeType::Sphere ? ShapeType::Sphere : ShapeType::Box;
+    b.shape.halfExtents = s.halfExtents;
+    b.shape.radius = s.radius;
+    b.position = s.position;
+    b.orientation = s.orientation; // saved normalized; bit-exact keeps replays deterministic
+    b.v = s.linearVelocity;
+    b.w = s.angularVelocity;
+    b.invMass = s.invMass;
+    b.invInertiaLocal = s.invInertia;
+    b.friction = s.friction;
+    b.restitution = s.restitution;
+    b.sleepTime = s.sleepTime;
+    b.awake = b.dynamic() && (s.flags & kBodyAwake);
+    updateInertia(b);
+    b.alive = true;
+    b.syncedPosition = b.position;
+    b.proxy = m_tree.createProxy(computeAabb(instance(b)), i);
+    b.moved = true;
+    m_moved.push_back(i);
+    ++m_bodyCount;
+  }
+}
+
+void PhysicsWorld::wake(BodyId id) {
+  if (!valid(id)) return;
+  Body& b = m_bodies[id];
+  if (!b.dynamic()) return;
+  b.awake = true;
+  b.sleepTime = 0.0f;
+}
+
+void PhysicsWorld::setTransform(BodyId id, Vec3 position, Quat orientation) {
+  if (!valid(id)) return;
+  Body& b = m_bodies[id];
+  b.position = position;
+  b.orientation = normalize(orientation);
+  updateInertia(b);
+  syncProxy(id);
+  b.syncedPosition = position;
+  wake(id);
+  // A static body moving away must not leave sleepers floating.
+  if (!b.dynamic()) {
+    for (const Contact& c : m_contacts) {
+      if (c.a == id || c.b == id) wake(c.a == id ? c.b : c.a);
+    }
+  }
+}
+
+void PhysicsWorld::setVelocity(BodyId id, Vec3 linear, Vec3 angular) {
+  if (!valid(id) || !m_bodies[id].dynamic()) return;
+  m_bodies[id].v = linear;
+  m_bodies[id].w = angular;
+  wake(id);
+}
+
+void PhysicsWorld::applyImpulse(BodyId id, Vec3 impulse, Vec3 point) {
+  if (!valid(id)) return;
+  Body& b = m_bodies[id];
+  if (!b.dynamic()) return;
+  b.v += impulse * b.invMass;
+  b.w += b.invInertiaWorld * cross(point - b.position, impulse);
+  wake(id);
+}
+
+void PhysicsWorld::syncProxy(BodyId id) {
+  Body& b = m_bodies[id];
+  if (m_tree.moveProxy(b.proxy, computeAabb(instance(b)), b.position - b.syncedPosition) && !b.moved) {
+    b.moved = true;
+    m_moved.push_back(id);
+  }
+}
+
+void PhysicsWorld::addPair(BodyId a, BodyId b) {
+  uint64_t key = pairKey(a, b);
+  if (m_contactIndex.count(key)) return;
+  Contact c;
+  c.a = std::min(a, b);
+  c.b = std::max(a, b);
+  const Body& ba = m_bodies[c.a];
+  const Body& bb = m_bodies[c.b];
+  c.friction = std::sqrt(ba.friction * bb.friction);
+  c.restitution = std::max(ba.restitution, bb.restitution);
+  m_contactIndex.emplace(key, (uint32_t)m_contacts.size());
+  m_contacts.push_back(c);
+}
+
+void PhysicsWorld::removeContact(uint32_t index) {
+  m_contactIndex.erase(pairKey(m_contacts[index].a, m_contacts[index].b));
+  if (index + 1 != m_contacts.size()) {
+    m_contacts[index] = m_contacts.back();
+    m_contactIndex[pairKey(m_contacts[index].a, m_contacts[index].b)] = index;
+  }
+  m_contacts.pop_back();
+}
+
+void PhysicsWorld::updateBroadphase() {
+  for (BodyId id = 0; id < (BodyId)m_bodies.size(); ++id) {
+    Body& b = m_bodies[id];
+    if (!b.alive || !b.awake) continue;
+    syncProxy(id);
+    b.syncedPosition = b.position;
+  }
+  m_stats.proxiesMoved = (uint32_t)m_moved.size();
+
+  // New pairs: query the tree with every moved leaf. A pair of two moved
+  // leaves is reported by the lower id only. Each chunk of kPairChunk
+  // leaves writes its own list; they are joined afterwards.
+  const uint32_t movedCount = (uint32_t)m_moved.size();
+  const uint32_t chunkCount = (movedCount + kPairChunk - 1) / kPairChunk;
+  if (m_pairChunks.size() < chunkCount) m_pairChunks.resize(chunkCount);
+  m_jobs->parallelFor(chunkCount, 1, [&](uint32_t firstChunk, uint32_t endChunk) {
+    for (uint32_t chunk = firstChunk; chunk < endChunk; ++chunk) {
+      Array<uint64_t>& pairs = m_pairChunks[chunk];
+      pairs.clear();
+      const uint32_t end = std::min(movedCount, (chunk + 1) * kPairChunk);
+      for (uint32_t i = chunk * kPairChunk; i < end; ++i) {
+        const BodyId self = m_moved[i];
+        const Body& b = m_bodies[self];
+        m_tree.query(m_tree.fatBox(b.proxy), [&](uint32_t proxy) {
+          BodyId other = m_tree.userData(proxy);
+          const Body& o = m_bodies[other];
+          if (other == self || (!b.dynamic() && !o.dynamic())) return true;
+          if (o.moved && other < self) return true;
+          pairs.push_back(pairKey(self, other));
+          return true;
+        });
+      }
+    }
+  });
+
+  // Sorted so contact order (and with it the solver) does not depend on
+  // which thread found a pair first.
+  m_newPairs.clear();
+  for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+    m_newPairs.insert(m_newPairs.end(), m_pairChunks[chunk].begin(), m_pairChunks[chunk].end());
+  }
+  std::sort(m_newPairs.begin(), m_newPairs.end());
+  for (uint64_t key : m_newPairs) addPair((BodyId)(key >> 32), (BodyId)(key & 0xffffffffu));
+
+  for (BodyId id : m_moved) m_bodies[id].moved = false;
+  m_moved.clear();
+}
+
+void PhysicsWorld::updateContacts() {
+  const float margin = m_settings.contactMargin;
+  m_jobs->parallelFor((uint32_t)m_contacts.size(), 128, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      Contact& c = m_contacts[i];
+      const Body& a = m_bodies[c.a];
+      const Body& b = m_bodies[c.b];
+      if (!a.awake && !b.awake) continue; // asleep: keep the last manifold
+      if (!m_tree.fatBox(a.proxy).overlaps(m_tree.fatBox(b.proxy))) {
+        c.stale = true;
+        c.touching = false;
+        continue;
+      }
+
+      ContactManifold m;
+      if (!collide(instance(a), instance(b), margin, m)) {
+        c.count = 0;
+        c.touching = false;
+        continue;
+      }
+
+      SolverPoint old[ContactManifold::kMaxPoints];
+      const uint32_t oldCount = c.count;
+      std::copy(c.points, c.points + oldCount, old);
+
+      const Mat3 toLocalA = transpose(a.rotation);
+      const Mat3 toLocalB = transpose(b.rotation);
+      c.normal = m.normal;
+      tangentBasis(c.normal, c.tangent[0], c.tangent[1]);
+      c.count = m.count;
+      for (uint32_t k = 0; k < m.count; ++k) {
+        SolverPoint& p = c.points[k];
+        p = SolverPoint{};
+        p.rA = m.points[k].position - a.position;
+        p.rB = m.points[k].position - b.position;
+        p.localA = toLocalA * p.rA;
+        p.localB = toLocalB * p.rB;
+        p.depth = m.points[k].depth;
+        // Warm start from the old point at the same spot on A.
+        for (uint32_t j = 0; j < oldCount; ++j) {
+          if (lengthSq(old[j].localA - p.localA) < kMatchDistanceSq) {
+            p.normalImpulse = old[j].normalImpulse;
+            p.tangentImpulse[0] = old[j].tangentImpulse[0];
+            p.tangentImpulse[1] = old[j].tangentImpulse[1];
+            break;
+          }
+        }
+      }
+      c.touching = true;
+    }
+  });
+
+  for (uint32_t i = (uint32_t)m_contacts.size(); i-- > 0;) {
+    if (m_contacts[i].stale) removeContact(i);
+  }
+}
+
+uint32_t PhysicsWorld::findRoot(uint32_t body) {
+  uint32_t root = body;
+  while (m_bodies[root].island != root) root = m_bodies[root].island;
+  while (m_bodies[body].island != root) {
+    uint32_t next = m_bodies[body].island;
+    m_bodies[body].island = root;
+    body = next;
+  }
+  return root;
+}
+
+void PhysicsWorld::buildIslands() {
+  const uint32_t bodyCount = (uint32_t)m_bodies.size();
+  for (uint32_t i = 0; i < bodyCount; ++i) m_bodies[i].island = i;
+
+  for (const Contact& c : m_contacts) {
+    if (!c.touching || !m_bodies[c.a].dynamic() || !m_bodies[c.b].dynamic()) continue;
+    uint32_t ra = findRoot(c.a), rb = findRoot(c.b);
+    if (ra != rb) m_bodies[std::max(ra, rb)].island = std::min(ra, rb);
+  }
+
+  // An island is awake if any member is; then all of them are.
+  m_rootAwake.assign(bodyCount, 0);
+  for (uint32_t i = 0; i < bodyCount; ++i) {
+    const Body& b = m_bodies[i];
+    if (b.alive && b.dynamic() && b.awake) m_rootAwake[findRoot(i)] = 1;
+  }
+
+  m_rootIsland.assign(bodyCount, kNone);
+  m_islandSizes.clear();
+  for (uint32_t i = 0; i < bodyCount; ++i) {
+    Body& b = m_bodies[i];
+    if (!b.alive || !b.dynamic()) continue;
+    uint32_t root = findRoot(i);
+    if (!m_rootAwake[root]) continue;
+    if (!b.awake) {
+      b.awake = true;
+      b.sleepTime = 0.0f;
+    }
+    if (m_rootIsland[root] == kNone) {
+      m_rootIsland[root] = (uint32_t)m_islandSizes.size();
+      m_islandSizes.push_back(0);
+    }
+    ++m_islandSizes[m_rootIsland[root]];
+  }
+
+  // Counting sort of bodies and contacts into their islands.
+  const uint32_t islandCount = (uint32_t)m_islandSizes.size();
+  m_islandBodyStart.assign(islandCount + 1, 0);
+  m_islandContactStart.assign(islandCount + 1, 0);
+  for (uint32_t i = 0; i < islandCount; ++i) m_islandBodyStart[i + 1] = m_islandBodyStart[i] + m_islandSizes[i];
+
+  auto contactIsland = [&](const Contact& c) {
+    if (!c.touching) return kNone;
+    BodyId d = m_bodies[c.a].dynamic() ? c.a : c.b;
+    return m_rootIsland[findRoot(d)];
+  };
+  for (const Contact& c : m_contacts) {
+    uint32_t island = contactIsland(c);
+    if (island != kNone) ++m_islandContactStart[island + 1];
+  }
+  for (uint32_t i = 0; i < islandCount; ++i) m_islandContactStart[i + 1] += m_islandContactStart[i];
+
+  m_islandBodies.resize(m_islandBodyStart[islandCount]);
+  m_islandContacts.resize(m_islandContactStart[islandCount]);
+  m_islandCursor.assign(m_islandBodyStart.begin(), m_islandBodyStart.end() - 1);
+  for (uint32_t i = 0; i < bodyCount; ++i) {
+    const Body& b = m_bodies[i];
+    if (!b.alive || !b.dynamic()) continue;
+    uint32_t island = m_rootIsland[findRoot(i)];
+    if (island != kNone) m_islandBodies[m_islandCursor[island]++] = i;
+  }
+  m_islandCursor.assign(m_islandContactStart.begin(), m_islandContactStart.end() - 1);
+  for (uint32_t i = 0; i < (uint32_t)m_contacts.size(); ++i) {
+    uint32_t island = contactIsland(m_contacts[i]);
+    if (island != kNone) m_islandContacts[m_islandCursor[island]++] = i;
+  }
+
+  // Largest first, so the long jobs do not start last.
+  m_islandOrder.resize(islandCount);
+  for (uint32_t i = 0; i < islandCount; ++i) m_islandOrder[i] = i;
+  std::stable_sort(m_islandOrder.begin(), m_islandOrder.end(),
+                   [&](uint32_t x, uint32_t y) { return m_islandSizes[x] > m_islandSizes[y]; });
+
+  m_stats.islands = islandCount;
+  m_stats.largestIsland = islandCount > 0 ? m_islandSizes[m_islandOrder[0]] : 0;
+  m_stats.awakeBodies = m_islandBodyStart[islandCount];
+}
+
+void PhysicsWorld::solveIsland(uint32_t island, float dt) {
+  const PhysicsSettings& s = m_settings;
+  const BodyId* bodies = m_islandBodies.data() + m_islandBodyStart[island];
+  const uint32_t bodyCount = m_islandBodyStart[island + 1] - m_islandBodyStart[island];
+  const uint32_t* contacts = m_islandContacts.data() + m_islandContactStart[island];
+  const uint32_t contactCount = m_islandContactStart[island + 1] - m_islandContactStart[island];
+
+  const uint32_t substeps = std::max(s.substeps, 1u);
+  const float h = dt / (float)substeps;
+  const float invH = 1.0f / h;
+
+  // Static bodies are shared between islands: read them, never write.
+  auto applyImpulse = [](Body& a, Body& b, const SolverPoint& p, Vec3 impulse) {
+    if (a.dynamic()) {
+      a.v -= impulse * a.invMass;
+      a.w -= a.invInertiaWorld * cross(p.rA, impulse);
+    }
+    if (b.dynamic()) {
+      b.v += impulse * b.invMass;
+      b.w += b.invInertiaWorld * cross(p.rB, impulse);
+    }
+  };
+  auto relativeVelocity = [](const Body& a, const Body& b, const SolverPoint& p) {
+    return (b.v + cross(b.w, p.rB)) - (a.v + cross(a.w, p.rA));
+  };
+  auto effectiveMass = [](const Body& a, const Body& b, const SolverPoint& p, Vec3 dir) {
+    Vec3 ra = cross(p.rA, dir), rb = cross(p.rB, dir);
+    float k = a.invMass + b.invMass + dot(ra, a.invInertiaWorld * ra) + dot(rb, b.invInertiaWorld * rb);
+    return k > 0.0f ? 1.0f / k : 0.0f;
+  };
+
+  // Masses and lever arms stay as the narrowphase left them for the whole
+  // step; only the overlap is tracked per substep, from how far the anchors
+  // moved.
+  for (uint32_t i = 0; i < bodyCount; ++i) m_bodies[bodies[i]].deltaPosition = Vec3{};
+  for (uint32_t i = 0; i < contactCount; ++i) {
+    Contact& c = m_contacts[contacts[i]];
+    const Body& a = m_bodies[c.a];
+    const Body& b = m_bodies[c.b];
+    for (uint32_t k = 0; k < c.count; ++k) {
+      SolverPoint& p = c.points[k];
+      p.normalMass = effectiveMass(a, b, p, c.normal);
+      p.tangentMass[0] = effectiveMass(a, b, p, c.tangent[0]);
+      p.tangentMass[1] = effectiveMass(a, b, p, c.tangent[1]);
+      p.adjustedDepth = p.depth + dot(p.rB - p.rA, c.normal);
+      float vn = dot(relativeVelocity(a, b, p), c.normal);
+      p.bounce = vn < -1.0f && c.restitution > 0.0f ? -c.restitution * vn : 0.0f;
+    }
+  }
+
+  auto warmStart = [&]() {
+    for (uint32_t i = 0; i < contactCount; ++i) {
+      Contact& c = m_contacts[contacts[i]];
+      Body& a = m_bodies[c.a];
+      Body& b = m_bodies[c.b];
+      for (uint32_t k = 0; k < c.count; ++k) {
+        const SolverPoint& p = c.points[k];
+        applyImpulse(a, b, p, c.normal * p.normalImpulse + c.tangent[0] * p.tangentImpulse[0] +
+                                  c.tangent[1] * p.tangentImpulse[1]);
+      }
+    }
+  };
+
+  // Sequential impulses. With useBias overlapping points are pushed apart
+  // (Baumgarte); the relax pass after the position update solves without it
+  // so that push does not carry over as momentum. Points that are still
+  // apart may close their gap this substep, but no further.
+  auto solveContacts = [&](bool useBias) {
+    for (uint32_t i = 0; i < contactCount; ++i) {
+      Contact& c = m_contacts[contacts[i]];
+      Body& a = m_bodies[c.a];
+      Body& b = m_bodies[c.b];
+      const Mat3& ra = a.rotation;
+      const Mat3& rb = b.rotation;
+      const Vec3 dp = b.deltaPosition - a.deltaPosition;
+      for (uint32_t k = 0; k < c.count; ++k) {
+        SolverPoint& p = c.points[k];
+
+        // Friction, bounded by the current normal impulse.
+        const float limit = c.friction * p.normalImpulse;
+        for (int t = 0; t < 2; ++t) {
+          float vt = dot(relativeVelocity(a, b, p), c.tangent[t]);
+          float lambda = -vt * p.tangentMass[t];
+          float total = std::clamp(p.tangentImpulse[t] + lambda, -limit, limit);
+          lambda = total - p.tangentImpulse[t];
+          p.tangentImpulse[t] = total;
+          applyImpulse(a, b, p, c.tangent[t] * lambda);
+        }
+
+        const float depth = p.adjustedDepth - dot(dp + rb * p.localB - ra * p.localA, c.normal);
+        float bias = 0.0f;
+        if (depth < 0.0f) bias = depth * invH;
+        else if (useBias) bias = std::min(s.baumgarte * invH * std::max(depth - s.penetrationSlop, 0.0f), s.maxPushVelocity);
+        bias = std::max(bias, p.bounce);
+
+        float vn = dot(relativeVelocity(a, b, p), c.normal);
+        float lambda = -(vn - bias) * p.normalMass;
+        float total = std::max(p.normalImpulse + lambda, 0.0f);
+        lambda = total - p.normalImpulse;
+        p.normalImpulse = total;
+        applyImpulse(a, b, p, c.normal * lambda);
+      }
+    }
+  };
+
+  const float linearDamping = 1.0f / (1.0f + h * s.linearDamping);
+  const float angularDamping = 1.0f / (1.0f + h * s.angularDamping);
+  for (uint32_t sub = 0; sub < substeps; ++sub) {
+    for (uint32_t i = 0; i < bodyCount; ++i) {
+      Body& b = m_bodies[bodies[i]];
+      b.v = (b.v + s.gravity * h) * linearDamping;
+      b.w = b.w * angularDamping;
+    }
+    warmStart();
+    for (uint32_t it = 0; it < s.velocityIterations; ++it) solveContacts(true);
+    for (uint32_t i = 0; i < bodyCount; ++i) {
+      Body& b = m_bodies[bodies[i]];
+      b.position += b.v * h;
+      b.deltaPosition += b.v * h;
+      b.orientation = integrate(b.orientation, b.w, h);
+      updateInertia(b);
+    }
+    for (uint32_t it = 0; it < s.relaxIterations; ++it) solveContacts(false);
+  }
+
+  // Sleep once the whole island has been slow long enough.
+  const float linSq = s.sleepLinearVelocity * s.sleepLinearVelocity;
+  const float angSq = s.sleepAngularVelocity * s.sleepAngularVelocity;
+  float minSleep = INFINITY;
+  for (uint32_t i = 0; i < bodyCount; ++i) {
+    Body& b = m_bodies[bodies[i]];
+    if (lengthSq(b.v) > linSq || lengthSq(b.w) > angSq) b.sleepTime = 0.0f;
+    else b.sleepTime += dt;
+    minSleep = std::min(minSleep, b.sleepTime);
+  }
+  if (minSleep >= s.timeToSleep) {
+    for (uint32_t i = 0; i < bodyCount; ++i) {
+      Body& b = m_bodies[bodies[i]];
+      b.awake = false;
+      b.v = Vec3{};
+      b.w = Vec3{};
+    }
+  }
+}
+
+void PhysicsWorld::step(float dt) {
+  if (!m_jobs || dt <= 0.0f) return;
+
+  Clock::time_point t0 = Clock::now();
+  updateBroadphase();
+  m_stats.broadphaseMs = msSince(t0);
+
+  t0 = Clock::now();
+  updateContacts();
+  m_stats.narrowphaseMs = msSince(t0);
+
+  t0 = Clock::now();
+  buildIslands();
+  m_stats.islandMs = msSince(t0);
+
+  t0 = Clock::now();
+  m_jobs->parallelFor((uint32_t)m_islandOrder.size(), 1, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) solveIsland(m_islandOrder[i], dt);
+  });
+  m_stats.solveMs = msSince(t0);
+
+  m_stats.bodies = m_bodyCount;
+  m_stats.contacts = (uint32_t)m_contacts.size();
+  m_stats.touchingContacts = 0;
+  for (const Contact& c : m_contacts) m_stats.touchingContacts += c.touching ? 1u : 0u;
+  m_stats.treeHeight = m_tree.height();
+}
+
+} // namespace physics
@@ -0,0 +1,235 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "Collision.h"
+#include "DynamicTree.h"
+
+namespace core { class JobSystem; }
+
+namespace physics {
+
+using BodyId = uint32_t;
+constexpr BodyId kInvalidBody = UINT32_MAX;
+
+struct BodyDesc {
+  Shape shape;
+  Vec3 position;
+  Quat orientation;
+  Vec3 linearVelocity;
+  Vec3 angularVelocity;
+  float mass = 1.0f; // 0 = static
+  float friction = 0.6f;
+  float restitution = 0.0f;
+};
+
+struct PhysicsSettings {
+  Vec3 gravity{ 0.0f, -9.81f, 0.0f };
+  uint32_t substeps = 4;           // solver substeps per step()
+  uint32_t velocityIterations = 2; // per substep
+  uint32_t relaxIterations = 1;    // per substep, after the position update
+  float contactMargin = 0.02f;     // speculative contact distance
+  float penetrationSlop = 0.005f;  // allowed overlap before position correction
+  float baumgarte = 0.2f;          // fraction of the overlap removed per substep
+  float maxPushVelocity = 3.0f;    // cap on the overlap correction, m/s
+  float linearDamping = 0.01f;
+  float angularDamping = 0.05f;
+  float sleepLinearVelocity = 0.08f;
+  float sleepAngularVelocity = 0.08f;
+  float timeToSleep = 0.5f;       // seconds below both thresholds
+};
+
+/// One body slot as saved in a snapshot (save/SaveFormat.h), dead slots
+/// included so ids survive a reload. Contacts are not saved; the first
+/// step() after a load finds them again.
+struct BodyState {
+  Vec3 position;
+  Quat orientation;
+  Vec3 linearVelocity;
+  Vec3 angularVelocity;
+  Vec3 halfExtents;
+  float radius = 0.0f;
+  float invMass = 0.0f;
+  Vec3 invInertia;
+  float friction = 0.0f;
+  float restitution = 0.0f;
+  float sleepTime = 0.0f;
+  uint32_t shape = 0; // ShapeType
+  uint32_t flags = 0; // kBodyAlive | kBodyAwake
+};
+static_assert(sizeof(BodyState) == 104, "BodyState is an on-disk layout");
+
+constexpr uint32_t kBodyAlive = 1u << 0;
+constexpr uint32_t kBodyAwake = 1u << 1;
+
+/// Wall-clock cost of the last step() per stage, plus the population.
+struct PhysicsStats {
+  uint32_t bodies = 0;
+  uint32_t awakeBodies = 0;
+  uint32_t contacts = 0;         // broadphase pairs
+  uint32_t touchingContacts = 0;
+  uint32_t islands = 0;          // awake ones, solved this step
+  uint32_t largestIsland = 0;    // bodies
+  uint32_t proxiesMoved = 0;
+  int treeHeight = 0;
+  double broadphaseMs = 0;
+  double narrowphaseMs = 0;
+  double islandMs = 0;
+  double solveMs = 0;
+};
+
+/// Rigid body simulation for props and debris: boxes and spheres, static or
+/// dynamic.
+///
+/// step() runs
+///
+///   broadphase   awake bodies that left their fat box are refit in the
+///                DynamicTree and queried for new pairs (parallel queries)
+///   narrowphase  every pair with an awake body gets a fresh manifold
+///                (parallel over pairs); pairs whose fat boxes separated are
+///                dropped
+///   islands      union-find over touching contacts; an island wakes as a
+///                whole when any of its bodies is awake
+///   solve        one job per island, largest first, in `substeps` passes
+///                of: integrate velocities, warm-started sequential impulses,
+///                integrate positions, relax (solve again without the
+///                overlap push). Then sleep the island once every body has
+///                been slow for timeToSleep
+///
+/// Islands share no dynamic body, so their jobs never write the same
+/// memory. Sleeping bodies cost nothing but their broadphase leaf until
+/// something touches them or the game moves or pushes them.
+///
+/// Not thread safe: call everything from one thread; step() fans out over
+/// the job system itself.
+class PhysicsWorld {
+public:
+  void init(core::JobSystem& jobs, const PhysicsSettings& settings = PhysicsSettings{});
+  void shutdown();
+
+  BodyId createBody(const BodyDesc& desc);
+  void destroyBody(BodyId id);
+
+  void step(float dt);
+
+  /// Every body slot, for a snapshot.
+  void saveState(std::vector<BodyState>& out) const;
+  /// Replaces all bodies with the saved slots.
+  void loadState(const BodyState* slots, uint32_t count);
+
+  /// Teleports and wakes the body.
+  void setTransform(BodyId id, Vec3 position, Quat orientation);
+  void setVelocity(BodyId id, Vec3 linear, Vec3 angular);
+  /// Impulse at a world point; wakes the body.
+  void applyImpulse(BodyId id, Vec3 impulse, Vec3 point);
+  void wake(BodyId id);
+
+  bool valid(BodyId id) const { return id < m_bodies.size() && m_bodies[id].alive; }
+  Vec3 position(BodyId id) const { return m_bodies[id].position; }
+  Quat orientation(BodyId id) const { return m_bodies[id].orientation; }
+  Vec3 linearVelocity(BodyId id) const { return m_bodies[id].v; }
+  bool awake(BodyId id) const { return m_bodies[id].awake; }
+
+  const PhysicsStats& stats() const { return m_stats; }
+  PhysicsSettings& settings() { return m_settings; }
+
+private:
+  struct Body {
+    Shape shape;
+    Vec3 position;
+    Quat orientation;
+    Mat3 rotation;            // from orientation
+    Vec3 v, w;
+    float invMass = 0.0f;
+    Vec3 invInertiaLocal;     // principal axes = body axes
+    Mat3 invInertiaWorld;
+    float friction = 0.6f;
+    float restitution = 0.0f;
+    float sleepTime = 0.0f;
+    uint32_t proxy = DynamicTree::kNull;
+    Vec3 syncedPosition;      // at the last broadphase update
+    Vec3 deltaPosition;       // moved so far this step, solver only
+    uint32_t island = 0;      // union-find parent during a step
+    bool alive = false;
+    bool awake = false;
+    bool moved = false;       // in m_moved
+
+    bool dynamic() const { return invMass > 0.0f; }
+  };
+
+  struct SolverPoint {
+    Vec3 localA, localB;      // anchors in body space; localA also matches warm starts
+    Vec3 rA, rB;
+    float depth = 0;
+    float adjustedDepth = 0;  // depth + dot(rB - rA, normal), see solveIsland()
+    float normalImpulse = 0, tangentImpulse[2] = { 0, 0 };
+    float normalMass = 0, tangentMass[2] = { 0, 0 };
+    float bounce = 0;         // restitution target for the normal velocity
+  };
+
+  struct Contact {
+    BodyId a = 0, b = 0;
+    Vec3 normal, tangent[2];
+    SolverPoint points[ContactManifold::kMaxPoints];
+    uint32_t count = 0;
+    float friction = 0, restitution = 0;
+    bool touching = false;
+    bool stale = false;       // fat boxes separated, drop after narrowphase
+  };
+
+  template <class T>
+  using Array = memory::TrackedVector<T, memory::MemTag::Physics>;
+
+  static uint64_t pairKey(BodyId a, BodyId b) {
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+  }
+
+  ShapeInstance instance(const Body& b) const { return { &b.shape, b.position, b.rotation }; }
+  void updateInertia(Body& b);
+  void addPair(BodyId a, BodyId b);
+  void removeContact(uint32_t index);
+  void syncProxy(BodyId id);
+
+  void updateContacts();
+  void buildIslands();
+  void solveIsland(uint32_t island, float dt);
+  void updateBroadphase();
+
+  uint32_t findRoot(uint32_t body);
+
+  core::JobSystem* m_jobs = nullptr;
+  PhysicsSettings m_settings;
+
+  Array<Body> m_bodies;
+  Array<BodyId> m_freeBodies;
+  uint32_t m_bodyCount = 0;
+
+  DynamicTree m_tree;
+  Array<BodyId> m_moved;                // proxies to query for new pairs
+
+  Array<Contact> m_contacts;
+  memory::TrackedMap<uint64_t, uint32_t, memory::MemTag::Physics> m_contactIndex;
+
+  // Islands of this step, flattened: island i owns
+  // m_islandBodies[m_islandBodyStart[i] .. m_islandBodyStart[i + 1]) and the
+  // same range of m_islandContacts via m_islandContactStart.
+  Array<uint32_t> m_islandOrder;        // largest first
+  Array<uint32_t> m_islandBodyStart, m_islandContactStart;
+  Array<BodyId> m_islandBodies;
+  Array<uint32_t> m_islandContacts;
+
+  // Step scratch, kept between steps so a step stops allocating once the
+  // scene's counts settle.
+  Array<Array<uint64_t>> m_pairChunks; // new pairs per broadphase query chunk
+  Array<uint64_t> m_newPairs;
+  Array<uint8_t> m_rootAwake;          // per body, by union-find root
+  Array<uint32_t> m_rootIsland;        // per body, by union-find root
+  Array<uint32_t> m_islandSizes;       // bodies per island
+  Array<uint32_t> m_islandCursor;      // counting sort fill position
+
+  PhysicsStats m_stats;
+};
+
+} // namespace physics
@@ -0,0 +1,328 @@
+#include "TriggerSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace physics {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+constexpr int32_t kCellLimit = (1 << 20) - 1; // 21 bits per axis in the key
+constexpr uint64_t kMaxTriggerCells = 512;    // beyond that a trigger goes to the large list
+constexpr uint64_t kMaxSweepCells = 512;      // beyond that a move counts as a teleport
+
+bool sphereOverlaps(Vec3 c, float r, const Aabb& b) {
+  const Vec3 closest = vmin(vmax(c, b.min), b.max);
+  return lengthSq(c - closest) <= r * r;
+}
+
+/// Segment p0 -> p1 against the box grown by r (the swept sphere, with
+/// square corners).
+bool sweepHits(Vec3 p0, Vec3 p1, float r, const Aabb& b) {
+  float t0 = 0.0f, t1 = 1.0f;
+  for (int i = 0; i < 3; ++i) {
+    const float o = component(p0, i), d = component(p1, i) - o;
+    const float lo = component(b.min, i) - r, hi = component(b.max, i) + r;
+    if (std::fabs(d) < 1e-12f) {
+      if (o < lo || o > hi) return false;
+      continue;
+    }
+    float ta = (lo - o) / d, tb = (hi - o) / d;
+    if (ta > tb) std::swap(ta, tb);
+    t0 = std::max(t0, ta);
+    t1 = std::min(t1, tb);
+    if (t0 > t1) return false;
+  }
+  return true;
+}
+
+uint64_t cellCount(const int32_t mn[3], const int32_t mx[3]) {
+  return uint64_t(mx[0] - mn[0] + 1) * uint64_t(mx[1] - mn[1] + 1) * uint64_t(mx[2] - mn[2] + 1);
+}
+
+} // namespace
+
+void TriggerSystem::init(float cellSize) {
+  m_cellSize = cellSize > 0.0f ? cellSize : kDefaultCellSize;
+  m_invCellSize = 1.0f / m_cellSize;
+}
+
+void TriggerSystem::shutdown() {
+  m_triggers.clear();
+  m_freeTriggers.clear();
+  m_cells.clear();
+  m_large.clear();
+  m_actors.clear();
+  m_freeActors.clear();
+  m_moved.clear();
+  m_stamps.clear();
+  m_stamp = 0;
+  m_events.clear();
+  m_pending.clear();
+  m_stats = TriggerStats{};
+}
+
+uint64_t TriggerSystem::cellKey(int32_t x, int32_t y, int32_t z) {
+  const uint64_t mask = (1u << 21) - 1;
+  return (uint64_t(x) & mask) | ((uint64_t(y) & mask) << 21) | ((uint64_t(z) & mask) << 42);
+}
+
+void TriggerSystem::cellRange(const Aabb& box, int32_t mn[3], int32_t mx[3]) const {
+  for (int i = 0; i < 3; ++i) {
+    const float lo = std::floor(component(box.min, i) * m_invCellSize);
+    const float hi = std::floor(component(box.max, i) * m_invCellSize);
+    mn[i] = (int32_t)std::clamp(lo, (float)-kCellLimit, (float)kCellLimit);
+    mx[i] = (int32_t)std::clamp(hi, (float)-kCellLimit, (float)kCellLimit);
+  }
+}
+
+TriggerId TriggerSystem::addTrigger(const Aabb& box) {
+  TriggerId id;
+  if (!m_freeTriggers.empty()) {
+    id = m_freeTriggers.back();
+    m_freeTriggers.pop_back();
+  } else {
+    id = (TriggerId)m_triggers.size();
+    m_triggers.emplace_back();
+    m_stamps.push_back(0);
+  }
+  insert(id, box);
+
+  // Actors already standing in it enter on the next update.
+  const Aabb& placed = m_triggers[id].box;
+  for (ActorId a = 0; a < m_actors.size(); ++a) {
+    const Actor& actor = m_actors[a];
+    if (actor.alive && sphereOverlaps(actor.position, actor.radius, placed)) markMoved(a);
+  }
+  return id;
+}
+
+void TriggerSystem::insert(TriggerId id, const Aabb& box) {
+  Trigger& t = m_triggers[id];
+  t = Trigger{};
+  t.box = { vmin(box.min, box.max), vmax(box.min, box.max) };
+  t.alive = true;
+  cellRange(t.box, t.cellMin, t.cellMax);
+  t.large = cellCount(t.cellMin, t.cellMax) > kMaxTriggerCells;
+  if (t.large) {
+    m_large.push_back(id);
+  } else {
+    for (int32_t z = t.cellMin[2]; z <= t.cellMax[2]; ++z)
+      for (int32_t y = t.cellMin[1]; y <= t.cellMax[1]; ++y)
+        for (int32_t x = t.cellMin[0]; x <= t.cellMax[0]; ++x) m_cells[cellKey(x, y, z)].push_back(id);
+  }
+  ++m_stats.triggers;
+}
+
+void TriggerSystem::removeTrigger(TriggerId id) {
+  if (!validTrigger(id)) return;
+  for (ActorId a = 0; a < m_actors.size(); ++a) {
+    Actor& actor = m_actors[a];
+    if (!actor.alive) continue;
+    auto it = std::lower_bound(actor.inside.begin(), actor.inside.end(), id);
+    if (it == actor.inside.end() || *it != id) continue;
+    actor.inside.erase(it);
+    m_pending.push_back({ id, a, false });
+  }
+
+  Trigger& t = m_triggers[id];
+  if (t.large) {
+    m_large.erase(std::find(m_large.begin(), m_large.end(), id));
+  } else {
+    for (int32_t z = t.cellMin[2]; z <= t.cellMax[2]; ++z)
+      for (int32_t y = t.cellMin[1]; y <= t.cellMax[1]; ++y)
+        for (int32_t x = t.cellMin[0]; x <= t.cellMax[0]; ++x) {
+          auto cell = m_cells.find(cellKey(x, y, z));
+          if (cell == m_cells.end()) continue;
+          std::vector<TriggerId>& list = cell->second;
+          list.erase(std::find(list.begin(), list.end(), id));
+          if (list.empty()) m_cells.erase(cell);
+        }
+  }
+  t.alive = false;
+  m_freeTriggers.push_back(id);
+  --m_stats.triggers;
+}
+
+ActorId TriggerSystem::addActor(Vec3 position, float radius) {
+  ActorId id;
+  if (!m_freeActors.empty()) {
+    id = m_freeActors.back();
+    m_freeActors.pop_back();
+  } else {
+    id = (ActorId)m_actors.size();
+    m_actors.emplace_back();
+  }
+
+  Actor& a = m_actors[id];
+  a.position = a.checked = position;
+  a.radius = std::max(radius, 0.0f);
+  a.inside.clear();
+  a.alive = true;
+  markMoved(id);
+  ++m_stats.actors;
+  return id;
+}
+
+void TriggerSystem::removeActor(ActorId id) {
+  if (!validActor(id)) return;
+  Actor& a = m_actors[id];
+  for (TriggerId t : a.inside) m_pending.push_back({ t, id, false });
+  a.inside.clear();
+  a.alive = false; // update() skips it if still in m_moved
+  m_freeActors.push_back(id);
+  --m_stats.actors;
+}
+
+void TriggerSystem::moveActor(ActorId id, Vec3 position) {
+  if (!validActor(id)) return;
+  m_actors[id].position = position;
+  markMoved(id);
+}
+
+void TriggerSystem::saveState(std::vector<TriggerState>& triggers, std::vector<ActorState>& actors) const {
+  triggers.resize(m_triggers.size());
+  for (size_t i = 0; i < m_triggers.size(); ++i) {
+    triggers[i] = TriggerState{};
+    if (m_triggers[i].alive) triggers[i] = { m_triggers[i].box, 1u, 0u };
+  }
+  actors.resize(m_actors.size());
+  for (size_t i = 0; i < m_actors.size(); ++i) {
+    const Actor& a = m_actors[i];
+    actors[i] = ActorState{};
+    if (a.alive) actors[i] = { a.position, a.radius, 1u, 0u };
+  }
+}
+
+void TriggerSystem::loadState(const TriggerState* triggers, uint32_t triggerCount, const ActorState* actors,
+                              uint32_t actorCount) {
+  const float cellSize = m_cellSize;
+  shutdown();
+  init(cellSize);
+
+  // Free lists end with the lowest id, which is reused first.
+  m_triggers.resize(triggerCount);
+  m_stamps.assign(triggerCount, 0);
+  for (uint32_t i = triggerCount; i-- > 0;) {
+    if (triggers[i].alive) insert(i, triggers[i].box);
+    else m_freeTriggers.push_back(i);
+  }
+  m_actors.resize(actorCount);
+  for (uint32_t i = actorCount; i-- > 0;) {
+    if (!actors[i].alive) {
+      m_freeActors.push_back(i);
+      continue;
+    }
+    Actor& a = m_actors[i];
+    a.position = a.checked = actors[i].position;
+    a.radius = std::max(actors[i].radius, 0.0f);
+    a.alive = true;
+    markMoved(i);
+    ++m_stats.actors;
+  }
+
+  // Settle the overlaps quietly.
+  update();
+  m_events.clear();
+}
+
+void TriggerSystem::markMoved(ActorId id) {
+  Actor& a = m_actors[id];
+  if (a.moved) return;
+  a.moved = true;
+  m_moved.push_back(id);
+}
+
+void TriggerSystem::update() {
+  const Clock::time_point t0 = Clock::now();
+  m_events.swap(m_pending);
+  m_pending.clear();
+  m_stats.actorsMoved = 0;
+  m_stats.candidates = 0;
+
+  for (ActorId id : m_moved) {
+    Actor& a = m_actors[id];
+    a.moved = false;
+    if (!a.alive) continue;
+    refresh(id);
+    ++m_stats.actorsMoved;
+  }
+  m_moved.clear();
+
+  m_stats.events = (uint32_t)m_events.size();
+  m_stats.updateMs = msSince(t0);
+}
+
+void TriggerSystem::gather(const Aabb& box) {
+  if (++m_stamp == 0) {
+    std::fill(m_stamps.begin(), m_stamps.end(), 0u);
+    m_stamp = 1;
+  }
+  m_candidates.clear();
+
+  int32_t mn[3], mx[3];
+  cellRange(box, mn, mx);
+  for (int32_t z = mn[2]; z <= mx[2]; ++z)
+    for (int32_t y = mn[1]; y <= mx[1]; ++y)
+      for (int32_t x = mn[0]; x <= mx[0]; ++x) {
+        auto cell = m_cells.find(cellKey(x, y, z));
+        if (cell == m_cells.end()) continue;
+        for (TriggerId t : cell->second) {
+          if (m_stamps[t] == m_stamp) continue;
+          m_stamps[t] = m_stamp;
+          m_candidates.push_back(t);
+        }
+      }
+  for (TriggerId t : m_large) {
+    if (m_triggers[t].box.overlaps(box)) m_candidates.push_back(t);
+  }
+}
+
+void TriggerSystem::refresh(ActorId id) {
+  Actor& a = m_actors[id];
+  const Vec3 ext{ a.radius, a.radius, a.radius };
+  const Aabb now{ a.position - ext, a.position + ext };
+  const Aabb swept = merge(now, Aabb{ a.checked - ext, a.checked + ext });
+
+  // The cells along the move, unless it is a jump across the map.
+  int32_t mn[3], mx[3];
+  cellRange(swept, mn, mx);
+  const bool sweep = cellCount(mn, mx) <= kMaxSweepCells;
+  gather(sweep ? swept : now);
+  m_stats.candidates += (uint32_t)m_candidates.size();
+
+  m_inside.clear();
+  m_crossed.clear();
+  for (TriggerId t : m_candidates) {
+    const Aabb& box = m_triggers[t].box;
+    if (sphereOverlaps(a.position, a.radius, box)) {
+      m_inside.push_back(t);
+    } else if (sweep && !std::binary_search(a.inside.begin(), a.inside.end(), t) &&
+               sweepHits(a.checked, a.position, a.radius, box)) {
+      m_crossed.push_back(t); // passed through since the last update
+    }
+  }
+  std::sort(m_inside.begin(), m_inside.end());
+
+  // Exits before enters, so stepping from one volume into the next reads in order.
+  for (TriggerId t : a.inside) {
+    if (!std::binary_search(m_inside.begin(), m_inside.end(), t)) m_events.push_back({ t, id, false });
+  }
+  for (TriggerId t : m_crossed) {
+    m_events.push_back({ t, id, true });
+    m_events.push_back({ t, id, false });
+  }
+  for (TriggerId t : m_inside) {
+    if (!std::binary_search(a.inside.begin(), a.inside.end(), t)) m_events.push_back({ t, id, true });
+  }
+  a.inside.swap(m_inside);
+  a.checked = a.position;
+}
+
+} // namespace physics
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "PhysicsMath.h"
+
+namespace physics {
+
+using TriggerId = uint32_t;
+using ActorId = uint32_t;
+constexpr TriggerId kInvalidTrigger = UINT32_MAX;
+constexpr ActorId kInvalidActor = UINT32_MAX;
+
+/// An actor started or stopped overlapping a trigger.
+struct TriggerEvent {
+  TriggerId trigger = kInvalidTrigger;
+  ActorId actor = kInvalidActor;
+  bool entered = false;
+};
+
+/// Trigger and actor slots as saved in a snapshot (save/SaveFormat.h), dead
+/// ones included so ids survive a reload.
+struct TriggerState {
+  Aabb box;
+  uint32_t alive = 0;
+  uint32_t pad = 0;
+};
+static_assert(sizeof(TriggerState) == 32, "TriggerState is an on-disk layout");
+
+struct ActorState {
+  Vec3 position;
+  float radius = 0.0f;
+  uint32_t alive = 0;
+  uint32_t pad = 0;
+};
+static_assert(sizeof(ActorState) == 24, "ActorState is an on-disk layout");
+
+struct TriggerStats {
+  uint32_t triggers = 0;
+  uint32_t actors = 0;
+  uint32_t actorsMoved = 0; // rechecked by the last update()
+  uint32_t candidates = 0;  // trigger tests those made
+  uint32_t events = 0;
+  double updateMs = 0;
+};
+
+/// Box trigger volumes and the actors (spheres) that walk through them.
+///
+/// Triggers are entered into a uniform spatial hash, once per cell they
+/// cover; very large ones sit in a short list tested against every moving
+/// actor instead. Each actor keeps the sorted list of triggers it overlaps.
+///
+/// update() only looks at actors moved since the last one. For each, the
+/// cells around the segment it moved along give the candidate triggers;
+/// the new overlap list is diffed against the old one, so only transitions
+/// come out. A trigger crossed entirely between two updates reports an enter
+/// and an exit together. Actors that stand still cost nothing.
+///
+/// Adding or removing a trigger or an actor never rescans the world in
+/// update(): the affected actors are marked moved, or their exits queued.
+///
+/// events() lists what happened up to the last update(), until the next.
+///
+/// Not thread safe: call everything from the main thread.
+class TriggerSystem {
+public:
+  static constexpr float kDefaultCellSize = 4.0f;
+
+  void init(float cellSize = kDefaultCellSize);
+  void shutdown();
+
+  TriggerId addTrigger(const Aabb& box);
+  /// Overlapping actors get their exits.
+  void removeTrigger(TriggerId id);
+
+  ActorId addActor(Vec3 position, float radius);
+  /// Its overlaps get their exits.
+  void removeActor(ActorId id);
+  void moveActor(ActorId id, Vec3 position);
+
+  bool validTrigger(TriggerId id) const { return id < m_triggers.size() && m_triggers[id].alive; }
+  bool validActor(ActorId id) const { return id < m_actors.size() && m_actors[id].alive; }
+
+  /// Once per frame, after whatever moves actors.
+  void update();
+
+  const std::vector<TriggerEvent>& events() const { return m_events; }
+
+  void saveState(std::vector<TriggerState>& triggers, std::vector<ActorState>& actors) const;
+  /// Replaces everything with the saved slots. Overlaps are recomputed
+  /// without events: the snapshot's scripts already saw those enters.
+  void loadState(const TriggerState* triggers, uint32_t triggerCount, const ActorState* actors,
+                 uint32_t actorCount);
+  const TriggerStats& stats() const { return m_stats; }
+
+private:
+  struct Trigger {
+    Aabb box;
+    int32_t cellMin[3] = { 0, 0, 0 }, cellMax[3] = { 0, 0, 0 };
+    bool large = false; // in m_large instead of the grid
+    bool alive = false;
+  };
+
+  struct Actor {
+    Vec3 position;
+    Vec3 checked;                  // position at the last update()
+    float radius = 0.0f;
+    std::vector<TriggerId> inside; // sorted
+    bool alive = false;
+    bool moved = false;            // in m_moved
+  };
+
+  static uint64_t cellKey(int32_t x, int32_t y, int32_t z);
+  void cellRange(const Aabb& box, int32_t mn[3], int32_t mx[3]) const;
+  void insert(TriggerId id, const Aabb& box);
+  void markMoved(ActorId id);
+  void gather(const Aabb& box);
+  void refresh(ActorId id);
+
+  float m_cellSize = kDefaultCellSize;
+  float m_invCellSize = 1.0f / kDefaultCellSize;
+
+  memory::TrackedVector<Trigger, memory::MemTag::Physics> m_triggers;
+  std::vector<TriggerId> m_freeTriggers;
+  memory::TrackedMap<uint64_t, std::vector<TriggerId>, memory::MemTag::Physics> m_cells;
+  std::vector<TriggerId> m_large;
+
+  memory::TrackedVector<Actor, memory::MemTag::Physics> m_actors;
+  std::vector<ActorId> m_freeActors;
+  std::vector<ActorId> m_moved;
+
+  // Candidate gathering; a trigger is taken once per actor via its stamp.
+  memory::TrackedVector<uint32_t, memory::MemTag::Physics> m_stamps; // per trigger
+  uint32_t m_stamp = 0;
+  std::vector<TriggerId> m_candidates;
+  std::vector<TriggerId> m_inside;
+  std::vector<TriggerId> m_crossed;
+
+  std::vector<TriggerEvent> m_events;  // reported by the last update()
+  std::vector<TriggerEvent> m_pending; // for the next one
+  TriggerStats m_stats;
+};
+
+} // namespace physics
@@ -0,0 +1,92 @@
+#include "AtlasAllocator.h"
+
+#include <cstddef>
+
+namespace render {
+
+void AtlasAllocator::init(uint32_t width, uint32_t height) {
+  m_width = width;
+  m_height = height;
+  m_nextY = 0;
+  m_usedArea = 0;
+  m_shelves.clear();
+}
+
+bool AtlasAllocator::allocOnShelf(Shelf& shelf, uint32_t w, uint32_t h, AtlasRect& out) {
+  for (size_t i = 0; i < shelf.free.size(); ++i) {
+    Span& s = shelf.free[i];
+    if (s.w < w) continue;
+
+    out.x = s.x;
+    out.y = shelf.y;
+    out.w = (uint16_t)w;
+    out.h = (uint16_t)h;
+    s.x = (uint16_t)(s.x + w);
+    s.w = (uint16_t)(s.w - w);
+    if (s.w == 0) shelf.free.erase(shelf.free.begin() + (ptrdiff_t)i);
+    shelf.used++;
+    m_usedArea += (uint64_t)w * h;
+    return true;
+  }
+  return false;
+}
+
+bool AtlasAllocator::alloc(uint32_t w, uint32_t h, AtlasRect& out) {
+  if (w == 0 || h == 0 || w > m_width || h > m_height) return false;
+
+  // Existing shelves of a fitting height first, empty ones of any height last.
+  for (Shelf& shelf : m_shelves) {
+    if (shelf.h < h || shelf.h > h + h / 2 || shelf.used == 0) continue;
+    if (allocOnShelf(shelf, w, h, out)) return true;
+  }
+
+  if (m_nextY + h <= m_height) {
+    Shelf shelf;
+    shelf.y = (uint16_t)m_nextY;
+    shelf.h = (uint16_t)h;
+    shelf.free.push_back(Span{ 0, (uint16_t)m_width });
+    m_nextY += h;
+    m_shelves.push_back(std::move(shelf));
+    return allocOnShelf(m_shelves.back(), w, h, out);
+  }
+
+  for (Shelf& shelf : m_shelves) {
+    if (shelf.used == 0 && shelf.h >= h && allocOnShelf(shelf, w, h, out)) return true;
+  }
+  return false;
+}
+
+void AtlasAllocator::free(const AtlasRect& rect) {
+  if (rect.w == 0) return;
+
+  Shelf* shelf = nullptr;
+  for (Shelf& s : m_shelves) {
+    if (s.y == rect.y) { shelf = &s; break; }
+  }
+  if (!shelf || shelf->used == 0) return;
+
+  // Insert the span in x order, then merge with its neighbours.
+  auto& spans = shelf->free;
+  size_t i = 0;
+  while (i < spans.size() && spans[i].x < rect.x) ++i;
+  spans.insert(spans.begin() + (ptrdiff_t)i, Span{ rect.x, rect.w });
+  if (i + 1 < spans.size() && spans[i].x + spans[i].w == spans[i + 1].x) {
+    spans[i].w = (uint16_t)(spans[i].w + spans[i + 1].w);
+    spans.erase(spans.begin() + (ptrdiff_t)(i + 1));
+  }
+  if (i > 0 && spans[i - 1].x + spans[i - 1].w == spans[i].x) {
+    spans[i - 1].w = (uint16_t)(spans[i - 1].w + spans[i].w);
+    spans.erase(spans.begin() + (ptrdiff_t)i);
+  }
+
+  shelf->used--;
+  m_usedArea -= (uint64_t)rect.w * rect.h;
+
+  // Empty shelves at the bottom give their rows back to new shelves.
+  while (!m_shelves.empty() && m_shelves.back().used == 0) {
+    m_nextY = m_shelves.back().y;
+    m_shelves.pop_back();
+  }
+}
+
+} // namespace render
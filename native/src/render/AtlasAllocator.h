@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace render {
+
+struct AtlasRect {
+  uint16_t x = 0, y = 0, w = 0, h = 0;
+};
+
+/// Shelf packer for a fixed-size 2D atlas, with freeing.
+///
+/// The atlas is cut into horizontal shelves, stacked top-down. A request
+/// goes to the first shelf that is tall enough without wasting more than a
+/// third of its height and has a free span wide enough (first fit, spans
+/// split on allocation and merged again on free). Failing that a new shelf
+/// is opened below the last one; shelves that become empty are trimmed off
+/// the bottom or reused by any request that fits their height.
+class AtlasAllocator {
+public:
+  void init(uint32_t width, uint32_t height);
+
+  /// False when no space is left; out is untouched then.
+  bool alloc(uint32_t w, uint32_t h, AtlasRect& out);
+  void free(const AtlasRect& rect);
+
+  uint32_t width() const { return m_width; }
+  uint32_t height() const { return m_height; }
+  /// Allocated texels / atlas texels.
+  float occupancy() const { return (float)m_usedArea / ((float)m_width * (float)m_height); }
+
+private:
+  struct Span {
+    uint16_t x = 0, w = 0;
+  };
+  struct Shelf {
+    uint16_t y = 0, h = 0;
+    std::vector<Span> free; // sorted by x, never adjacent
+    uint32_t used = 0;      // allocations living on this shelf
+  };
+
+  bool allocOnShelf(Shelf& shelf, uint32_t w, uint32_t h, AtlasRect& out);
+
+  uint32_t m_width = 0, m_height = 0;
+  uint32_t m_nextY = 0;
+  uint64_t m_usedArea = 0;
+  std::vector<Shelf> m_shelves; // ordered by y
+};
+
+} // namespace render
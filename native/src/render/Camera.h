@@ -0,0 +1,25 @@
+#pragma once
+#include "RenderMath.h"
+
+namespace render {
+
+/// First-person camera. Yaw turns around +Y (0 looks down -Z), pitch tilts
+/// up; both in radians.
+struct Camera {
+  Vec3 position{ 0.0f, 0.0f, 0.0f };
+  float yaw = 0.0f;
+  float pitch = 0.0f;
+  float fovY = 1.2217305f; // 70 degrees
+  float zNear = 0.1f;
+  float zFar = 200.0f;
+
+  Vec3 forward() const {
+    float cp = std::cos(pitch);
+    return { -std::sin(yaw) * cp, std::sin(pitch), -std::cos(yaw) * cp };
+  }
+
+  Mat4 view() const { return lookAt(position, position + forward(), Vec3{ 0.0f, 1.0f, 0.0f }); }
+  Mat4 projection(float aspect) const { return perspective(fovY, aspect, zNear, zFar); }
+};
+
+} // namespace render
@@ -0,0 +1,321 @@
+#include "ClusteredLighting.h"
+#include "Camera.h"
+#include "Decals.h"
+#include "Lights.h"
+#include "ShadowAtlas.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace render {
+
+static constexpr uint32_t kBindingCount = 10;
+static constexpr uint32_t kAtlasBinding = 7;
+static constexpr uint32_t kShadowAtlasBinding = 8;
+static constexpr uint32_t kShadowBinding = 9;
+static_assert(ClusteredLighting::kMaxDecals == DecalSystem::kMaxVisibleDecals,
+              "decal buffer must hold every visible decal");
+
+bool ClusteredLighting::init(const GpuContext& gpu, uint32_t framesInFlight) {
+  m_gpu = &gpu;
+  VkDevice device = gpu.device;
+
+  // ---- layout: same set for the culling pass and every lit pipeline ----
+  VkDescriptorSetLayoutBinding bindings[kBindingCount]{};
+  for (uint32_t i = 0; i < kBindingCount; ++i) {
+    bindings[i].binding = i;
+    bindings[i].descriptorCount = 1;
+    bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  }
+  bindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT; // view/proj for lit vertex shaders
+  bindings[kAtlasBinding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bindings[kAtlasBinding].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  bindings[kShadowAtlasBinding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bindings[kShadowAtlasBinding].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  bindings[kShadowBinding].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+  VkDescriptorSetLayoutCreateInfo dslci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+  dslci.bindingCount = kBindingCount;
+  dslci.pBindings = bindings;
+  vkcheck(vkCreateDescriptorSetLayout(device, &dslci, nullptr, &m_setLayout),
+          "vkCreateDescriptorSetLayout(clusters)");
+
+  VkDescriptorPoolSize sizes[3]{};
+  sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  sizes[0].descriptorCount = framesInFlight;
+  sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  sizes[1].descriptorCount = framesInFlight * (kBindingCount - 3);
+  sizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  sizes[2].descriptorCount = framesInFlight * 2;
+
+  VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+  dpci.maxSets = framesInFlight;
+  dpci.poolSizeCount = 3;
+  dpci.pPoolSizes = sizes;
+  vkcheck(vkCreateDescriptorPool(device, &dpci, nullptr, &m_pool), "vkCreateDescriptorPool(clusters)");
+
+  // ---- per-frame buffers + sets ----
+  const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  const VkMemoryPropertyFlags local = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+  m_frames.resize(framesInFlight);
+  for (Frame& f : m_frames) {
+    f.params = createBuffer(gpu, sizeof(Params), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, host);
+    f.lights = createBuffer(gpu, sizeof(Light) * LightList::kMaxLights, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, host);
+    f.bounds = createBuffer(gpu, sizeof(float) * 8 * kClusterCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, host);
+    f.ranges = createBuffer(gpu, sizeof(uint32_t) * 4 * kClusterCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                            VK_BUFFER_USAGE_TRANSFER_DST_BIT, local);
+    f.indices = createBuffer(gpu, sizeof(uint32_t) * kClusterCount * (kAvgLightsPerCluster + kAvgDecalsPerCluster),
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, local);
+    f.counter = createBuffer(gpu, sizeof(uint32_t) * 4, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                             VK_BUFFER_USAGE_TRANSFER_DST_BIT, local);
+    f.decals = createBuffer(gpu, sizeof(GpuDecal) * kMaxDecals, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, host);
+
+    VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dsai.descriptorPool = m_pool;
+    dsai.descriptorSetCount = 1;
+    dsai.pSetLayouts = &m_setLayout;
+    vkcheck(vkAllocateDescriptorSets(device, &dsai, &f.set), "vkAllocateDescriptorSets(clusters)");
+
+    // The atlases and the shadow table (bindings 7..9) are written by
+    // setDecalAtlas() and setShadowAtlas().
+    const GpuBuffer* buffers[kAtlasBinding] = {
+      &f.params, &f.lights, &f.bounds, &f.ranges, &f.indices, &f.counter, &f.decals
+    };
+    VkDescriptorBufferInfo infos[kAtlasBinding]{};
+    VkWriteDescriptorSet writes[kAtlasBinding]{};
+    for (uint32_t i = 0; i < kAtlasBinding; ++i) {
+      infos[i].buffer = buffers[i]->buffer;
+      infos[i].offset = 0;
+      infos[i].range = VK_WHOLE_SIZE;
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].dstSet = f.set;
+      writes[i].dstBinding = i;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = bindings[i].descriptorType;
+      writes[i].pBufferInfo = &infos[i];
+    }
+    vkUpdateDescriptorSets(device, kAtlasBinding, writes, 0, nullptr);
+  }
+
+  // ---- culling pipeline ----
+  VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+  plci.setLayoutCount = 1;
+  plci.pSetLayouts = &m_setLayout;
+  vkcheck(vkCreatePipelineLayout(device, &plci, nullptr, &m_pipelineLayout),
+          "vkCreatePipelineLayout(light_cull)");
+
+  m_pipeline = createComputePipeline(gpu, m_pipelineLayout, "shaders/light_cull.comp.spv");
+  if (!m_pipeline) {
+    core::logError(core::LogCategory::Render, "Clustered lighting disabled: shaders/light_cull.comp.spv missing");
+    return false;
+  }
+
+  core::logInfo(core::LogCategory::Render, "Clustered lighting: %ux%ux%u clusters, %u lights max", kGridX, kGridY,
+                kGridZ, LightList::kMaxLights);
+  return true;
+}
+
+void ClusteredLighting::shutdown() {
+  if (!m_gpu) return;
+  VkDevice device = m_gpu->device;
+
+  for (Frame& f : m_frames) {
+    destroyBuffer(*m_gpu, f.params);
+    destroyBuffer(*m_gpu, f.lights);
+    destroyBuffer(*m_gpu, f.bounds);
+    destroyBuffer(*m_gpu, f.ranges);
+    destroyBuffer(*m_gpu, f.indices);
+    destroyBuffer(*m_gpu, f.counter);
+    destroyBuffer(*m_gpu, f.decals);
+  }
+  m_frames.clear();
+
+  if (m_pipeline) vkDestroyPipeline(device, m_pipeline, nullptr);
+  if (m_pipelineLayout) vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+  if (m_pool) vkDestroyDescriptorPool(device, m_pool, nullptr);
+  if (m_setLayout) vkDestroyDescriptorSetLayout(device, m_setLayout, nullptr);
+  m_pipeline = VK_NULL_HANDLE;
+  m_pipelineLayout = VK_NULL_HANDLE;
+  m_pool = VK_NULL_HANDLE;
+  m_setLayout = VK_NULL_HANDLE;
+  m_gpu = nullptr;
+}
+
+void ClusteredLighting::setViewport(uint32_t width, uint32_t height) {
+  m_width = std::max(width, 1u);
+  m_height = std::max(height, 1u);
+}
+
+void ClusteredLighting::setDecalAtlas(VkImageView view, VkSampler sampler) {
+  if (!m_gpu || !view) return;
+
+  VkDescriptorImageInfo info{};
+  info.sampler = sampler;
+  info.imageView = view;
+  info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  for (Frame& f : m_frames) {
+    VkWriteDescriptorSet w{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    w.dstSet = f.set;
+    w.dstBinding = kAtlasBinding;
+    w.descriptorCount = 1;
+    w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    w.pImageInfo = &info;
+    vkUpdateDescriptorSets(m_gpu->device, 1, &w, 0, nullptr);
+  }
+}
+
+void ClusteredLighting::setShadowAtlas(const ShadowAtlas& shadows) {
+  if (!m_gpu || !shadows.view()) return;
+
+  VkDescriptorImageInfo atlas{};
+  atlas.sampler = shadows.sampler();
+  atlas.imageView = shadows.view();
+  atlas.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+  for (uint32_t i = 0; i < (uint32_t)m_frames.size(); ++i) {
+    VkDescriptorBufferInfo table{ shadows.shadowBuffer(i).buffer, 0, VK_WHOLE_SIZE };
+    VkWriteDescriptorSet w[2]{};
+    w[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    w[0].dstSet = m_frames[i].set;
+    w[0].dstBinding = kShadowAtlasBinding;
+    w[0].descriptorCount = 1;
+    w[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    w[0].pImageInfo = &atlas;
+    w[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    w[1].dstSet = m_frames[i].set;
+    w[1].dstBinding = kShadowBinding;
+    w[1].descriptorCount = 1;
+    w[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    w[1].pBufferInfo = &table;
+    vkUpdateDescriptorSets(m_gpu->device, 2, w, 0, nullptr);
+  }
+}
+
+void ClusteredLighting::writeBounds(Frame& f, float fovY, float aspect, float zNear, float zFar) {
+  // View space looks down -Z. A pixel at NDC (x, y) and depth d maps to
+  // (x * d * tanX, -y * d * tanY, -d) with Vulkan's y-down clip space.
+  float tanY = std::tan(fovY * 0.5f);
+  float tanX = tanY * aspect;
+  float tileW = std::ceil((float)m_width / kGridX);
+  float tileH = std::ceil((float)m_height / kGridY);
+
+  auto* out = static_cast<float*>(f.bounds.mapped);
+  for (uint32_t z = 0; z < kGridZ; ++z) {
+    float d0 = zNear * std::pow(zFar / zNear, (float)z / kGridZ);
+    float d1 = zNear * std::pow(zFar / zNear, (float)(z + 1) / kGridZ);
+
+    for (uint32_t y = 0; y < kGridY; ++y) {
+      float ny0 = 2.0f * std::min(y * tileH, (float)m_height) / m_height - 1.0f;
+      float ny1 = 2.0f * std::min((y + 1) * tileH, (float)m_height) / m_height - 1.0f;
+
+      for (uint32_t x = 0; x < kGridX; ++x) {
+        float nx0 = 2.0f * std::min(x * tileW, (float)m_width) / m_width - 1.0f;
+        float nx1 = 2.0f * std::min((x + 1) * tileW, (float)m_width) / m_width - 1.0f;
+
+        float mn[3] = { 1e30f, 1e30f, -d1 };
+        float mx[3] = { -1e30f, -1e30f, -d0 };
+        for (float d : { d0, d1 }) {
+          for (float nx : { nx0, nx1 }) {
+            float vx = nx * d * tanX;
+            mn[0] = std::min(mn[0], vx);
+            mx[0] = std::max(mx[0], vx);
+          }
+          for (float ny : { ny0, ny1 }) {
+            float vy = -ny * d * tanY;
+            mn[1] = std::min(mn[1], vy);
+            mx[1] = std::max(mx[1], vy);
+          }
+        }
+
+        uint32_t c = x + kGridX * (y + kGridY * z);
+        float* o = out + c * 8;
+        o[0] = mn[0]; o[1] = mn[1]; o[2] = mn[2]; o[3] = 0.0f;
+        o[4] = mx[0]; o[5] = mx[1]; o[6] = mx[2]; o[7] = 0.0f;
+      }
+    }
+  }
+}
+
+void ClusteredLighting::update(uint32_t frameIndex, const Camera& camera, const LightList& lights,
+                               const std::vector<GpuDecal>& decals) {
+  if (m_frames.empty()) return;
+  Frame& f = m_frames[frameIndex];
+
+  float aspect = (float)m_width / (float)m_height;
+  // Tiles are whole pixels, so their NDC bounds move with the resolution.
+  float key[6] = { camera.fovY, aspect, camera.zNear, camera.zFar, (float)m_width, (float)m_height };
+  if (m_boundsVersion == 0 || std::memcmp(key, m_projKey, sizeof(key)) != 0) {
+    std::memcpy(m_projKey, key, sizeof(key));
+    m_boundsVersion++;
+  }
+  if (f.boundsVersion != m_boundsVersion) {
+    writeBounds(f, camera.fovY, aspect, camera.zNear, camera.zFar);
+    f.boundsVersion = m_boundsVersion;
+  }
+
+  uint32_t count = lights.pack(static_cast<Light*>(f.lights.mapped));
+  m_lastLightCount = count;
+  // Counted on the source: the upload is write-combined memory.
+  m_lastShadowCount = 0;
+  for (uint32_t i = 0; i < lights.slotCount(); ++i) {
+    if (lights.alive(i) && lights.slots()[i].shadow != kNoShadow) m_lastShadowCount++;
+  }
+
+  uint32_t decalCount = (uint32_t)std::min<size_t>(decals.size(), kMaxDecals);
+  if (decalCount) std::memcpy(f.decals.mapped, decals.data(), sizeof(GpuDecal) * decalCount);
+  m_lastDecalCount = decalCount;
+
+  Params p{};
+  p.view = camera.view();
+  p.proj = camera.projection(aspect);
+  p.grid[0] = kGridX;
+  p.grid[1] = kGridY;
+  p.grid[2] = kGridZ;
+  p.grid[3] = count;
+  p.tileSize[0] = std::ceil((float)m_width / kGridX);
+  p.tileSize[1] = std::ceil((float)m_height / kGridY);
+  p.tileSize[2] = (float)m_width;
+  p.tileSize[3] = (float)m_height;
+  float logRatio = std::log(camera.zFar / camera.zNear);
+  p.depthSlice[0] = camera.zNear;
+  p.depthSlice[1] = camera.zFar;
+  p.depthSlice[2] = kGridZ / logRatio;
+  p.depthSlice[3] = -(float)kGridZ * std::log(camera.zNear) / logRatio;
+  p.decalInfo[0] = decalCount;
+  std::memcpy(f.params.mapped, &p, sizeof(p));
+}
+
+void ClusteredLighting::cull(VkCommandBuffer cmd, uint32_t frameIndex) {
+  if (m_frames.empty()) return;
+  Frame& f = m_frames[frameIndex];
+
+  // With the pass disabled, leave every cluster empty instead of stale.
+  vkCmdFillBuffer(cmd, f.counter.buffer, 0, VK_WHOLE_SIZE, 0);
+  if (!m_pipeline) {
+    vkCmdFillBuffer(cmd, f.ranges.buffer, 0, VK_WHOLE_SIZE, 0);
+    bufferBarrier(cmd, f.ranges.buffer,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    return;
+  }
+  bufferBarrier(cmd, f.counter.buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &f.set, 0, nullptr);
+  vkCmdDispatch(cmd, (kClusterCount + 127) / 128, 1, 1);
+
+  VkMemoryBarrier mb{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0, 1, &mb, 0, nullptr, 0, nullptr);
+}
+
+} // namespace render
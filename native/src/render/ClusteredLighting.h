@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "VkUtil.h"
+#include "RenderMath.h"
+
+namespace render {
+
+struct Camera;
+struct GpuDecal;
+class LightList;
+class ShadowAtlas;
+
+/// Clustered forward+ light binning.
+///
+/// The view frustum is cut into a kGridX x kGridY screen-tile grid with
+/// kGridZ exponential depth slices. Every frame a compute pass tests all
+/// live lights against each cluster's view-space AABB and writes a compact
+/// per-cluster index list; lit fragment shaders include
+/// shaders/clustered_lighting.glsl and loop only over their cluster's lights.
+/// Visible decals are binned the same way (bounding sphere vs. cluster) into
+/// the tail of each cluster's list, see shaders/clustered_decals.glsl.
+/// Lights with a ShadowAtlas entry (Light::shadow) are shadowed through the
+/// atlas and table bound next to them.
+///
+/// All buffers are per frame in flight, so culling for frame N+1 never
+/// races shading of frame N. Cluster bounds are rebuilt on the CPU when the
+/// projection or viewport changes.
+class ClusteredLighting {
+public:
+  static constexpr uint32_t kGridX = 16;
+  static constexpr uint32_t kGridY = 9;
+  static constexpr uint32_t kGridZ = 24;
+  static constexpr uint32_t kClusterCount = kGridX * kGridY * kGridZ;
+  static constexpr uint32_t kMaxLightsPerCluster = 64; // MAX_LIGHTS_PER_CLUSTER
+  static constexpr uint32_t kAvgLightsPerCluster = 32; // sizes the index list
+  static constexpr uint32_t kMaxDecalsPerCluster = 32; // MAX_DECALS_PER_CLUSTER
+  static constexpr uint32_t kAvgDecalsPerCluster = 8;
+  static constexpr uint32_t kMaxDecals = 256;          // DecalSystem::kMaxVisibleDecals
+
+  /// False if the culling shader is missing; shading then sees zero lights.
+  bool init(const GpuContext& gpu, uint32_t framesInFlight);
+  void shutdown();
+
+  /// Size the scene renders at; may change every frame (dynamic resolution).
+  void setViewport(uint32_t width, uint32_t height);
+
+  /// CPU side for the frame: uploads lights, decals and params, refreshes
+  /// bounds. Call after the frame's fence wait; decals past kMaxDecals are
+  /// dropped.
+  void update(uint32_t frameIndex, const Camera& camera, const LightList& lights,
+              const std::vector<GpuDecal>& decals);
+
+  /// Decal atlas sampled by clustered_decals.glsl (binding 7), expected in
+  /// SHADER_READ_ONLY_OPTIMAL. Writes every frame's set: device idle only.
+  void setDecalAtlas(VkImageView view, VkSampler sampler);
+  /// Shadow atlas and per-frame shadow table (bindings 8, 9). Writes every
+  /// frame's set: device idle only.
+  void setShadowAtlas(const ShadowAtlas& shadows);
+
+  /// Records the culling dispatch. Must be outside a render pass; ends with
+  /// a barrier making the results visible to fragment shaders.
+  void cull(VkCommandBuffer cmd, uint32_t frameIndex);
+
+  VkDescriptorSetLayout setLayout() const { return m_setLayout; }
+  VkDescriptorSet descriptorSet(uint32_t frameIndex) const { return m_frames[frameIndex].set; }
+  bool enabled() const { return m_pipeline != VK_NULL_HANDLE; }
+
+  uint32_t lastLightCount() const { return m_lastLightCount; }
+  uint32_t lastDecalCount() const { return m_lastDecalCount; }
+  /// Lights with a shadow map in the last update().
+  uint32_t lastShadowCount() const { return m_lastShadowCount; }
+
+private:
+  struct Params {
+    Mat4 view;
+    Mat4 proj;
+    uint32_t grid[4];
+    float tileSize[4];
+    float depthSlice[4];
+    uint32_t decalInfo[4];
+  };
+
+  struct Frame {
+    GpuBuffer params;    // UBO, host visible
+    GpuBuffer lights;    // SSBO, host visible
+    GpuBuffer bounds;    // SSBO, host visible, rewritten when stale
+    GpuBuffer ranges;    // SSBO, device local
+    GpuBuffer indices;   // SSBO, device local
+    GpuBuffer counter;   // SSBO, device local
+    GpuBuffer decals;    // SSBO, host visible
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    uint64_t boundsVersion = 0;
+  };
+
+  void writeBounds(Frame& f, float fovY, float aspect, float zNear, float zFar);
+
+  const GpuContext* m_gpu = nullptr;
+  std::vector<Frame> m_frames;
+
+  VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+  VkDescriptorPool m_pool = VK_NULL_HANDLE;
+  VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+  VkPipeline m_pipeline = VK_NULL_HANDLE;
+
+  uint32_t m_width = 1, m_height = 1;
+  float m_projKey[6] = { 0, 0, 0, 0, 0, 0 }; // fovY, aspect, near, far, width, height of m_boundsVersion
+  uint64_t m_boundsVersion = 0;
+  uint32_t m_lastLightCount = 0;
+  uint32_t m_lastDecalCount = 0;
+  uint32_t m_lastShadowCount = 0;
+};
+
+} // namespace render
@@ -0,0 +1,382 @@
+#include "Decals.h"
+#include "Camera.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace render {
+
+static constexpr VkFormat kAtlasFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+static uint32_t nextRandom(uint32_t& state) {
+  // xorshift32: variety for splat choice and rotation, nothing more.
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static float smoothstep(float e0, float e1, float x) {
+  float t = std::clamp((x - e0) / (e1 - e0), 0.0f, 1.0f);
+  return t * t * (3.0f - 2.0f * t);
+}
+
+bool DecalSystem::init(const GpuContext& gpu, uint32_t framesInFlight) {
+  m_gpu = &gpu;
+  VkDevice device = gpu.device;
+
+  m_atlas = render::createImage(gpu, kAtlasSize, kAtlasSize, kAtlasFormat,
+                                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                VK_IMAGE_ASPECT_COLOR_BIT);
+  m_alloc.init(kAtlasSize, kAtlasSize);
+  m_atlasReady = false;
+
+  // Regions are inset by half a texel (see add()), so bilinear at lod 0
+  // never reads a neighbour and no padding is needed.
+  VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+  sci.magFilter = VK_FILTER_LINEAR;
+  sci.minFilter = VK_FILTER_LINEAR;
+  sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  vkcheck(vkCreateSampler(device, &sci, nullptr, &m_sampler), "vkCreateSampler(decals)");
+
+  const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  m_frames.resize(framesInFlight);
+  for (Frame& f : m_frames) {
+    f.staging = createBuffer(gpu, kStagingBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, host);
+    f.uploads.reserve(16);
+  }
+  m_frameIndex = 0;
+
+  m_decals.reserve(kMaxDecals);
+  m_visible.reserve(kMaxVisibleDecals);
+  m_candidates.reserve(kMaxDecals);
+
+  // Built-in splats go up with the first recorded frame (frame 0's staging)
+  // and stay resident.
+  std::vector<uint8_t> texels(kSplatSize * kSplatSize * 4);
+  for (uint32_t v = 0; v < kSplatVariants; ++v) {
+    writeSplat(texels.data(), kSplatSize, v);
+    m_splats[v] = createImage(kSplatSize, kSplatSize, texels.data());
+  }
+
+  core::logInfo(core::LogCategory::Render, "Decals: %ux%u atlas, %u live / %u visible max", kAtlasSize, kAtlasSize,
+                kMaxDecals, kMaxVisibleDecals);
+  return true;
+}
+
+void DecalSystem::shutdown() {
+  if (!m_gpu) return;
+  for (Frame& f : m_frames) destroyBuffer(*m_gpu, f.staging);
+  m_frames.clear();
+  destroyImage(*m_gpu, m_atlas);
+  if (m_sampler) vkDestroySampler(m_gpu->device, m_sampler, nullptr);
+  m_sampler = VK_NULL_HANDLE;
+
+  m_images.clear();
+  m_freeImages.clear();
+  m_decals.clear();
+  m_freeDecals.clear();
+  m_visible.clear();
+  m_count = 0;
+  m_atlasReady = false;
+  m_gpu = nullptr;
+}
+
+void DecalSystem::writeSplat(uint8_t* dst, uint32_t size, uint32_t variant) const {
+  // A lumpy disc plus a few satellite droplets; white, tinted per decal.
+  uint32_t rng = 0x9E3779B9u * (variant + 1);
+  float phase[3], amp[3];
+  for (int i = 0; i < 3; ++i) {
+    phase[i] = (float)(nextRandom(rng) & 0xFFFF) / 65535.0f * 6.2831853f;
+    amp[i] = 0.05f + (float)(nextRandom(rng) & 0xFF) / 255.0f * 0.1f;
+  }
+  float drops[6][3];
+  for (auto& d : drops) {
+    float a = (float)(nextRandom(rng) & 0xFFFF) / 65535.0f * 6.2831853f;
+    float r = 0.55f + (float)(nextRandom(rng) & 0xFF) / 255.0f * 0.35f;
+    d[0] = std::cos(a) * r;
+    d[1] = std::sin(a) * r;
+    d[2] = 0.04f + (float)(nextRandom(rng) & 0xFF) / 255.0f * 0.06f;
+  }
+
+  const float px = 2.0f / (float)size;
+  for (uint32_t y = 0; y < size; ++y) {
+    for (uint32_t x = 0; x < size; ++x) {
+      float u = ((float)x + 0.5f) * px - 1.0f;
+      float v = ((float)y + 0.5f) * px - 1.0f;
+      float r = std::sqrt(u * u + v * v);
+      float a = std::atan2(v, u);
+
+      float edge = 0.5f;
+      for (int i = 0; i < 3; ++i) edge += amp[i] * 0.5f * std::sin(a * (float)(3 + 2 * i) + phase[i]);
+      float cover = 1.0f - smoothstep(edge - px, edge + px, r);
+      for (const auto& d : drops) {
+        float dr = std::sqrt((u - d[0]) * (u - d[0]) + (v - d[1]) * (v - d[1]));
+        cover = std::max(cover, 1.0f - smoothstep(d[2] - px, d[2] + px, dr));
+      }
+
+      // Darker, denser centre; thinner rim.
+      float shade = 0.75f + 0.25f * smoothstep(0.0f, edge, r);
+      uint8_t* t = dst + (y * size + x) * 4;
+      t[0] = t[1] = t[2] = (uint8_t)(shade * 255.0f + 0.5f);
+      t[3] = (uint8_t)(cover * (0.8f + 0.2f * (1.0f - r)) * 255.0f + 0.5f);
+    }
+  }
+}
+
+void DecalSystem::beginFrame(uint32_t frameIndex) {
+  if (m_frames.empty()) return;
+  m_frameIndex = frameIndex;
+  Frame& f = m_frames[frameIndex];
+  // Staging behind recorded uploads is free once the fence was waited on;
+  // uploads that never got recorded (skipped frame) still own theirs.
+  if (f.recorded) f.used = 0;
+  f.recorded = false;
+}
+
+uint32_t DecalSystem::allocImage(uint32_t w, uint32_t h, bool evict) {
+  AtlasRect rect;
+  while (!m_alloc.alloc(w, h, rect)) {
+    // Only decals on released images can give atlas space back.
+    if (!evict || !evictOne(true)) return kInvalid;
+  }
+
+  uint32_t id;
+  if (!m_freeImages.empty()) {
+    id = m_freeImages.back();
+    m_freeImages.pop_back();
+  } else {
+    id = (uint32_t)m_images.size();
+    m_images.emplace_back();
+  }
+  Image& img = m_images[id];
+  img.rect = rect;
+  img.refs = 0;
+  img.live = true;
+  img.released = false;
+  return id;
+}
+
+uint32_t DecalSystem::createImage(uint32_t w, uint32_t h, const uint8_t* rgba) {
+  if (m_frames.empty() || !rgba || w == 0 || h == 0 || w > kMaxImageSize || h > kMaxImageSize) {
+    return kInvalid;
+  }
+  Frame& f = m_frames[m_frameIndex];
+  VkDeviceSize bytes = (VkDeviceSize)w * h * 4;
+  VkDeviceSize offset = (f.used + 15) & ~(VkDeviceSize)15;
+  if (offset + bytes > f.staging.size) {
+    core::logWarn(core::LogCategory::Render, "Decal image %ux%u dropped: upload budget for this frame used up", w, h);
+    return kInvalid;
+  }
+
+  uint32_t id = allocImage(w, h, true);
+  if (id == kInvalid) {
+    core::logWarn(core::LogCategory::Render, "Decal image %ux%u dropped: atlas full", w, h);
+    return kInvalid;
+  }
+
+  std::memcpy(static_cast<uint8_t*>(f.staging.mapped) + offset, rgba, (size_t)bytes);
+  f.used = offset + bytes;
+  f.uploads.push_back(Upload{ m_images[id].rect, offset });
+  return id;
+}
+
+void DecalSystem::unrefImage(uint32_t image) {
+  Image& img = m_images[image];
+  if (img.refs > 0) img.refs--;
+  if (img.refs == 0 && img.released) {
+    m_alloc.free(img.rect);
+    img.live = false;
+    m_freeImages.push_back(image);
+  }
+}
+
+void DecalSystem::releaseImage(uint32_t image) {
+  if (image >= m_images.size() || !m_images[image].live || m_images[image].released) return;
+  for (uint32_t splat : m_splats) {
+    if (splat == image) return; // built-ins stay
+  }
+  Image& img = m_images[image];
+  img.released = true;
+  if (img.refs == 0) {
+    m_alloc.free(img.rect);
+    img.live = false;
+    m_freeImages.push_back(image);
+  }
+}
+
+bool DecalSystem::evictOne(bool releasedImagesOnly) {
+  uint32_t victim = kInvalid;
+  for (uint32_t i = 0; i < (uint32_t)m_decals.size(); ++i) {
+    const Decal& d = m_decals[i];
+    if (!d.live || (releasedImagesOnly && !m_images[d.image].released)) continue;
+    if (victim == kInvalid) { victim = i; continue; }
+    const Decal& v = m_decals[victim];
+    if (d.lastSeen < v.lastSeen || (d.lastSeen == v.lastSeen && d.serial < v.serial)) victim = i;
+  }
+  if (victim == kInvalid) return false;
+  remove(victim);
+  return true;
+}
+
+uint32_t DecalSystem::add(const DecalDesc& desc) {
+  if (m_frames.empty()) return kInvalid;
+  uint32_t image = desc.image;
+  if (image == kInvalid) image = m_splats[nextRandom(m_rng) % kSplatVariants];
+  if (image >= m_images.size() || !m_images[image].live || m_images[image].released) return kInvalid;
+
+  if (m_count >= kMaxDecals) evictOne(false);
+
+  uint32_t id;
+  if (!m_freeDecals.empty()) {
+    id = m_freeDecals.back();
+    m_freeDecals.pop_back();
+  } else {
+    id = (uint32_t)m_decals.size();
+    m_decals.emplace_back();
+  }
+  m_images[image].refs++;
+  m_count++;
+
+  float size = std::max(desc.size, 1e-3f);
+  float depth = desc.depth > 0.0f ? desc.depth : size * 0.5f;
+  float angle = desc.angle >= 0.0f ? desc.angle
+                                   : (float)(nextRandom(m_rng) & 0xFFFF) / 65535.0f * 6.2831853f;
+
+  // Orthonormal basis around the normal, spun by `angle`.
+  Vec3 n = normalize(desc.normal);
+  if (length(n) < 0.5f) n = Vec3{ 0.0f, 1.0f, 0.0f };
+  Vec3 ref = std::fabs(n.y) < 0.99f ? Vec3{ 0.0f, 1.0f, 0.0f } : Vec3{ 1.0f, 0.0f, 0.0f };
+  Vec3 t0 = normalize(cross(ref, n));
+  Vec3 b0 = cross(n, t0);
+  float c = std::cos(angle), s = std::sin(angle);
+  Vec3 t = t0 * c + b0 * s;
+  Vec3 b = b0 * c - t0 * s;
+
+  // Rows scale the basis into the unit box, so the inverse is written out
+  // directly instead of inverting decalToWorld.
+  Decal& d = m_decals[id];
+  d.live = true;
+  d.image = image;
+  d.center = desc.position;
+  d.radius = std::sqrt(size * size * 0.5f + depth * depth * 0.25f);
+  d.lastSeen = m_frame;
+  d.serial = ++m_serial;
+
+  Mat4 m;
+  const Vec3 axes[3] = { t * (1.0f / size), b * (1.0f / size), n * (1.0f / depth) };
+  for (int r = 0; r < 3; ++r) {
+    m.at(r, 0) = axes[r].x;
+    m.at(r, 1) = axes[r].y;
+    m.at(r, 2) = axes[r].z;
+    m.at(r, 3) = -dot(axes[r], desc.position);
+  }
+  d.gpu.worldToDecal = m;
+
+  const AtlasRect& rect = m_images[image].rect;
+  const float texel = 1.0f / (float)kAtlasSize;
+  d.gpu.atlasRect[0] = ((float)rect.x + 0.5f) * texel;
+  d.gpu.atlasRect[1] = ((float)rect.y + 0.5f) * texel;
+  d.gpu.atlasRect[2] = ((float)rect.w - 1.0f) * texel;
+  d.gpu.atlasRect[3] = ((float)rect.h - 1.0f) * texel;
+  std::memcpy(d.gpu.color, desc.color, sizeof(d.gpu.color));
+  d.gpu.sphere[0] = d.center.x;
+  d.gpu.sphere[1] = d.center.y;
+  d.gpu.sphere[2] = d.center.z;
+  d.gpu.sphere[3] = d.radius;
+  return id;
+}
+
+void DecalSystem::remove(uint32_t id) {
+  if (id >= m_decals.size() || !m_decals[id].live) return;
+  Decal& d = m_decals[id];
+  d.live = false;
+  unrefImage(d.image);
+  d.image = kInvalid;
+  m_freeDecals.push_back(id);
+  m_count--;
+}
+
+void DecalSystem::update(const Camera& camera, float aspect) {
+  m_visible.clear();
+  m_candidates.clear();
+  if (m_frames.empty()) return;
+  m_frame++;
+
+  Frustum frustum = Frustum::fromViewProj(camera.projection(aspect) * camera.view());
+  for (uint32_t i = 0; i < (uint32_t)m_decals.size(); ++i) {
+    Decal& d = m_decals[i];
+    if (!d.live || !frustum.sphereVisible(d.center, d.radius)) continue;
+    d.lastSeen = m_frame;
+    Vec3 to = d.center - camera.position;
+    m_candidates.push_back({ dot(to, to), i });
+  }
+
+  // Over budget: shade the nearest ones.
+  if (m_candidates.size() > kMaxVisibleDecals) {
+    std::nth_element(m_candidates.begin(), m_candidates.begin() + kMaxVisibleDecals, m_candidates.end());
+    m_candidates.resize(kMaxVisibleDecals);
+  }
+  // Newest first, so overlapping decals stack in a stable, recent-on-top order.
+  std::sort(m_candidates.begin(), m_candidates.end(), [this](const auto& a, const auto& b) {
+    return m_decals[a.second].serial > m_decals[b.second].serial;
+  });
+  for (const auto& c : m_candidates) m_visible.push_back(m_decals[c.second].gpu);
+}
+
+void DecalSystem::recordUploads(VkCommandBuffer cmd, uint32_t frameIndex) {
+  if (m_frames.empty()) return;
+  Frame& f = m_frames[frameIndex];
+  const VkImageAspectFlags color = VK_IMAGE_ASPECT_COLOR_BIT;
+
+  if (!m_atlasReady) {
+    // Unused regions must read as transparent, not as garbage.
+    imageBarrier(cmd, m_atlas.image, color, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    VkClearColorValue clear{};
+    VkImageSubresourceRange range{ color, 0, 1, 0, 1 };
+    vkCmdClearColorImage(cmd, m_atlas.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &range);
+    imageBarrier(cmd, m_atlas.image, color, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+  } else if (!f.uploads.empty()) {
+    imageBarrier(cmd, m_atlas.image, color,
+                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+  } else {
+    return;
+  }
+
+  if (!f.uploads.empty()) {
+    std::vector<VkBufferImageCopy> copies;
+    copies.reserve(f.uploads.size());
+    for (const Upload& u : f.uploads) {
+      VkBufferImageCopy c{};
+      c.bufferOffset = u.offset;
+      c.imageSubresource = { color, 0, 0, 1 };
+      c.imageOffset = { (int32_t)u.rect.x, (int32_t)u.rect.y, 0 };
+      c.imageExtent = { u.rect.w, u.rect.h, 1 };
+      copies.push_back(c);
+    }
+    vkCmdCopyBufferToImage(cmd, f.staging.buffer, m_atlas.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           (uint32_t)copies.size(), copies.data());
+    f.uploads.clear();
+  }
+
+  imageBarrier(cmd, m_atlas.image, color,
+               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+  m_atlasReady = true;
+  f.recorded = true;
+}
+
+} // namespace render
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "AtlasAllocator.h"
+#include "RenderMath.h"
+#include "VkUtil.h"
+
+namespace render {
+
+struct Camera;
+
+/// GPU layout (std430, 112 bytes); mirrored by `Decal` in
+/// shaders/clustered_common.glsl.
+struct GpuDecal {
+  Mat4 worldToDecal;               // world -> unit box [-0.5, 0.5]^3, z = projection axis
+  float atlasRect[4] = { 0, 0, 0, 0 }; // uv offset, uv scale
+  float color[4] = { 1, 1, 1, 1 };     // tint rgb, opacity
+  float sphere[4] = { 0, 0, 0, 0 };    // world bounding sphere for binning
+};
+static_assert(sizeof(GpuDecal) == 112, "GpuDecal must match the shader struct");
+
+struct DecalDesc {
+  Vec3 position;
+  Vec3 normal{ 0.0f, 1.0f, 0.0f }; // surface normal; the decal projects along -normal
+  float size = 1.0f;               // edge length of the square footprint
+  float depth = 0.0f;              // projection depth, 0 = size / 2
+  float angle = -1.0f;             // rotation around the normal (radians), < 0 = random
+  float color[4] = { 0.45f, 0.02f, 0.02f, 1.0f };
+  uint32_t image = UINT32_MAX;     // from createImage(), UINT32_MAX = built-in splat
+};
+
+/// Persistent projected decals with a flat memory and shading budget.
+///
+/// Decal images live in one fixed RGBA8 atlas packed by AtlasAllocator;
+/// a handful of procedural blood splats are resident from the start, the
+/// rest comes from createImage(). At most kMaxDecals exist at once: adding
+/// past that evicts the decal that has been out of view the longest (ties:
+/// the oldest). Each frame only decals inside the view frustum are handed
+/// to ClusteredLighting, at most kMaxVisibleDecals (the nearest), which bins
+/// them into its cluster grid next to the lights, so a pixel only evaluates
+/// the decals that overlap its cluster.
+class DecalSystem {
+public:
+  static constexpr uint32_t kAtlasSize = 2048;
+  static constexpr uint32_t kMaxDecals = 1024;
+  static constexpr uint32_t kMaxVisibleDecals = 256;
+  static constexpr uint32_t kMaxImageSize = 512;
+  static constexpr uint32_t kSplatVariants = 8;
+  static constexpr uint32_t kSplatSize = 128;
+  static constexpr uint32_t kInvalid = UINT32_MAX;
+
+  bool init(const GpuContext& gpu, uint32_t framesInFlight);
+  void shutdown();
+
+  /// Call right after the frame's fence wait; recycles that frame's staging.
+  void beginFrame(uint32_t frameIndex);
+
+  /// Copies w x h RGBA8 texels into the atlas (uploaded with the next
+  /// recorded frame). Evicts decals if that frees enough space; kInvalid
+  /// if the image still does not fit.
+  uint32_t createImage(uint32_t w, uint32_t h, const uint8_t* rgba);
+  /// The atlas space is returned once no decal uses the image any more.
+  void releaseImage(uint32_t image);
+
+  /// kInvalid only if the image is unknown.
+  uint32_t add(const DecalDesc& desc);
+  void remove(uint32_t id);
+  uint32_t count() const { return m_count; }
+
+  /// Frustum test, LRU stamps, builds visible(). After beginFrame().
+  void update(const Camera& camera, float aspect);
+  const std::vector<GpuDecal>& visible() const { return m_visible; }
+
+  /// Records pending atlas uploads (and the first-use layout transition).
+  /// Outside a render pass, before any shader samples the atlas.
+  void recordUploads(VkCommandBuffer cmd, uint32_t frameIndex);
+
+  VkImageView atlasView() const { return m_atlas.view; }
+  VkSampler sampler() const { return m_sampler; }
+
+private:
+  struct Image {
+    AtlasRect rect;
+    uint32_t refs = 0;
+    bool live = false;
+    bool released = false; // owner let go; freed with the last decal
+  };
+
+  struct Decal {
+    GpuDecal gpu;
+    Vec3 center;
+    float radius = 0.0f;
+    uint32_t image = kInvalid;
+    uint64_t lastSeen = 0;
+    uint64_t serial = 0;
+    bool live = false;
+  };
+
+  struct Upload {
+    AtlasRect rect;
+    VkDeviceSize offset = 0;
+  };
+
+  struct Frame {
+    GpuBuffer staging;         // host visible
+    VkDeviceSize used = 0;
+    std::vector<Upload> uploads;
+    bool recorded = false;     // uploads submitted; staging busy until the fence
+  };
+
+  static constexpr VkDeviceSize kStagingBytes = 2 * 1024 * 1024;
+
+  uint32_t allocImage(uint32_t w, uint32_t h, bool evict);
+  void unrefImage(uint32_t image);
+  /// Least recently visible, then oldest. False if nothing qualified.
+  bool evictOne(bool releasedImagesOnly);
+  void writeSplat(uint8_t* dst, uint32_t size, uint32_t variant) const;
+
+  const GpuContext* m_gpu = nullptr;
+  std::vector<Frame> m_frames;
+  uint32_t m_frameIndex = 0;
+
+  GpuImage m_atlas{};
+  VkSampler m_sampler = VK_NULL_HANDLE;
+  bool m_atlasReady = false; // layout initialized
+  AtlasAllocator m_alloc;
+
+  memory::TrackedVector<Image, memory::MemTag::Render> m_images;
+  memory::TrackedVector<uint32_t, memory::MemTag::Render> m_freeImages;
+  uint32_t m_splats[kSplatVariants] = {};
+
+  memory::TrackedVector<Decal, memory::MemTag::Render> m_decals;
+  memory::TrackedVector<uint32_t, memory::MemTag::Render> m_freeDecals;
+  uint32_t m_count = 0;
+  uint64_t m_frame = 1;
+  uint64_t m_serial = 0;
+  uint32_t m_rng = 0x6D2B79F5u;
+
+  std::vector<GpuDecal> m_visible;
+  memory::TrackedVector<std::pair<float, uint32_t>, memory::MemTag::Render> m_candidates;
+};
+
+} // namespace render
@@ -0,0 +1,101 @@
+#include "DynamicResolution.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace render {
+
+void DynamicResolution::init(const GpuContext& gpu, uint32_t framesInFlight) {
+  m_gpu = &gpu;
+  m_queried.assign(framesInFlight, 0);
+  m_frameScale.assign(framesInFlight, 1.0f);
+  m_scale = 1.0f;
+  m_cost = 0.0f;
+  m_headroomFrames = 0;
+
+  if (!gpu.props.limits.timestampComputeAndGraphics) {
+    core::logWarn(core::LogCategory::Render, "Dynamic resolution off: no timestamp support");
+    return;
+  }
+  VkQueryPoolCreateInfo qpci{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+  qpci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  qpci.queryCount = 2 * framesInFlight;
+  vkcheck(vkCreateQueryPool(gpu.device, &qpci, nullptr, &m_queries), "vkCreateQueryPool(resolution)");
+  core::logInfo(core::LogCategory::Render, "Dynamic resolution: scene budget %.1f ms, scale %.2f..1", m_budgetMs,
+                kMinScale);
+}
+
+void DynamicResolution::shutdown() {
+  if (!m_gpu) return;
+  if (m_queries) vkDestroyQueryPool(m_gpu->device, m_queries, nullptr);
+  m_queries = VK_NULL_HANDLE;
+  m_queried.clear();
+  m_frameScale.clear();
+  m_gpu = nullptr;
+}
+
+void DynamicResolution::setBudget(float ms) {
+  m_budgetMs = std::max(ms, 0.0f);
+  m_headroomFrames = 0;
+  if (m_budgetMs == 0.0f) m_scale = 1.0f;
+}
+
+void DynamicResolution::update(uint32_t frameIndex) {
+  if (!m_queries || !m_queried[frameIndex]) return;
+  uint64_t ticks[2] = {};
+  VkResult r = vkGetQueryPoolResults(m_gpu->device, m_queries, frameIndex * 2, 2, sizeof(ticks), ticks,
+                                     sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+  if (r != VK_SUCCESS) return;
+  m_sceneMs = (float)((double)(ticks[1] - ticks[0]) * m_gpu->props.limits.timestampPeriod * 1e-6);
+  if (m_budgetMs == 0.0f) return;
+
+  // Scene cost scales with the pixel count; normalized, a sample taken at
+  // any scale predicts every other. Rises fast, settles slowly.
+  const float fs = m_frameScale[frameIndex];
+  const float cost = m_sceneMs / (fs * fs);
+  if (m_cost == 0.0f) m_cost = cost;
+  else m_cost += (cost - m_cost) * (cost > m_cost ? 0.5f : 0.1f);
+
+  // 5% headroom for the frame-to-frame noise.
+  float desired = m_cost > 0.0f ? std::sqrt(m_budgetMs * 0.95f / m_cost) : 1.0f;
+  desired = std::clamp(desired, kMinScale, 1.0f);
+  if (desired < m_scale) {
+    // Over budget: whole steps down, straight to a scale that fits.
+    m_scale = std::max(std::floor(desired / kStep) * kStep, kMinScale);
+    m_headroomFrames = 0;
+  } else if (desired >= m_scale + kStep) {
+    if (++m_headroomFrames >= kClimbFrames) {
+      m_scale = std::min(m_scale + kStep, 1.0f);
+      m_headroomFrames = 0;
+    }
+  } else {
+    m_headroomFrames = 0;
+  }
+}
+
+void DynamicResolution::beginScene(VkCommandBuffer cmd, uint32_t frameIndex) {
+  if (!m_queries) return;
+  m_frameScale[frameIndex] = m_scale;
+  vkCmdResetQueryPool(cmd, m_queries, frameIndex * 2, 2);
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queries, frameIndex * 2);
+}
+
+void DynamicResolution::endScene(VkCommandBuffer cmd, uint32_t frameIndex) {
+  if (!m_queries) return;
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queries, frameIndex * 2 + 1);
+  m_queried[frameIndex] = 1;
+}
+
+VkExtent2D DynamicResolution::renderExtent(VkExtent2D full) const {
+  if (m_scale >= 1.0f) return full;
+  // Even, so the rendered part ends on a whole texel of the half-resolution
+  // bloom chain.
+  auto scaled = [&](uint32_t n) {
+    uint32_t s = (uint32_t)((float)n * m_scale + 0.5f) & ~1u;
+    return std::clamp(s, std::min(2u, n), n);
+  };
+  return { scaled(full.width), scaled(full.height) };
+}
+
+} // namespace render
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "VkUtil.h"
+
+namespace render {
+
+/// Scales the scene's render resolution to hold a GPU frame budget.
+///
+/// The scene passes are bracketed by timestamps (beginScene/endScene); the
+/// post chain, which runs at native resolution whatever the scale, is left
+/// out. The controller tracks the scene's cost per pixel of the full
+/// extent (ms / scale^2) and picks the largest scale that fits the budget:
+/// it drops at once when a frame runs over, and climbs back one kStep at a
+/// time only after kClimbFrames frames of headroom, so a scale does not
+/// oscillate around the budget. The scene renders to the top-left
+/// renderExtent() of its full-size targets; PostProcess upscales it.
+///
+/// Without timestamp support the scale stays 1.
+class DynamicResolution {
+public:
+  static constexpr float kMinScale = 0.5f;
+  static constexpr float kStep = 0.05f;
+  static constexpr uint32_t kClimbFrames = 30;
+  static constexpr float kDefaultBudgetMs = 12.0f; // scene only
+
+  void init(const GpuContext& gpu, uint32_t framesInFlight);
+  void shutdown();
+
+  /// GPU milliseconds the scene may take; 0 renders at native resolution.
+  void setBudget(float ms);
+  float budget() const { return m_budgetMs; }
+
+  /// Call after the frame's fence wait: reads the scene time the frame's
+  /// last use recorded and picks this frame's scale.
+  void update(uint32_t frameIndex);
+  /// Around the scene passes, outside render passes.
+  void beginScene(VkCommandBuffer cmd, uint32_t frameIndex);
+  void endScene(VkCommandBuffer cmd, uint32_t frameIndex);
+
+  /// The part of `full` to render at this frame's scale; even, at least 2.
+  VkExtent2D renderExtent(VkExtent2D full) const;
+  float scale() const { return m_scale; }
+  /// Scene GPU time of the latest measured frame.
+  float sceneMs() const { return m_sceneMs; }
+
+private:
+  const GpuContext* m_gpu = nullptr;
+  VkQueryPool m_queries = VK_NULL_HANDLE; // 2 timestamps per frame in flight
+  std::vector<uint8_t> m_queried;         // frame's timestamps were written
+  std::vector<float> m_frameScale;        // scale the frame rendered at
+
+  float m_budgetMs = kDefaultBudgetMs;
+  float m_scale = 1.0f;
+  float m_sceneMs = 0.0f;
+  float m_cost = 0.0f; // ms at scale 1, smoothed
+  uint32_t m_headroomFrames = 0;
+};
+
+} // namespace render
@@ -0,0 +1,208 @@
+#include "HiZPyramid.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+
+namespace render {
+
+static constexpr uint32_t kGroupSize = 8; // HIZ_GROUP
+
+struct HiZPush {
+  uint32_t srcSize[2];
+  uint32_t dstSize[2];
+};
+
+static uint32_t previousPow2(uint32_t v) {
+  uint32_t p = 1;
+  while (p * 2 <= v) p *= 2;
+  return p;
+}
+
+bool HiZPyramid::init(const GpuContext& gpu) {
+  m_gpu = &gpu;
+  VkDevice device = gpu.device;
+
+  VkDescriptorSetLayoutBinding bindings[2]{};
+  bindings[0].binding = 0;
+  bindings[0].descriptorCount = 1;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  bindings[1].binding = 1;
+  bindings[1].descriptorCount = 1;
+  bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutCreateInfo dslci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+  dslci.bindingCount = 2;
+  dslci.pBindings = bindings;
+  vkcheck(vkCreateDescriptorSetLayout(device, &dslci, nullptr, &m_setLayout), "vkCreateDescriptorSetLayout(hiz)");
+
+  VkDescriptorPoolSize sizes[2]{};
+  sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  sizes[0].descriptorCount = kMaxLevels;
+  sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  sizes[1].descriptorCount = kMaxLevels;
+
+  VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+  dpci.maxSets = kMaxLevels;
+  dpci.poolSizeCount = 2;
+  dpci.pPoolSizes = sizes;
+  vkcheck(vkCreateDescriptorPool(device, &dpci, nullptr, &m_pool), "vkCreateDescriptorPool(hiz)");
+
+  // Nearest: a texel is a conservative bound only as a whole.
+  VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+  sci.magFilter = VK_FILTER_NEAREST;
+  sci.minFilter = VK_FILTER_NEAREST;
+  sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.maxLod = (float)kMaxLevels;
+  vkcheck(vkCreateSampler(device, &sci, nullptr, &m_sampler), "vkCreateSampler(hiz)");
+
+  VkPushConstantRange pcr{};
+  pcr.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pcr.offset = 0;
+  pcr.size = sizeof(HiZPush);
+
+  VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+  plci.setLayoutCount = 1;
+  plci.pSetLayouts = &m_setLayout;
+  plci.pushConstantRangeCount = 1;
+  plci.pPushConstantRanges = &pcr;
+  vkcheck(vkCreatePipelineLayout(device, &plci, nullptr, &m_pipelineLayout), "vkCreatePipelineLayout(hiz)");
+
+  m_pipeline = createComputePipeline(gpu, m_pipelineLayout, "shaders/hiz_build.comp.spv");
+  if (!m_pipeline) {
+    core::logError(core::LogCategory::Render, "Hi-Z occlusion disabled: shaders/hiz_build.comp.spv missing");
+    return false;
+  }
+  return true;
+}
+
+void HiZPyramid::destroyPyramid() {
+  if (!m_gpu) return;
+  for (VkImageView v : m_levelViews) vkDestroyImageView(m_gpu->device, v, nullptr);
+  m_levelViews.clear();
+  m_sets.clear();
+  if (m_pool) vkResetDescriptorPool(m_gpu->device, m_pool, 0);
+  destroyImage(*m_gpu, m_image);
+}
+
+void HiZPyramid::shutdown() {
+  if (!m_gpu) return;
+  VkDevice device = m_gpu->device;
+
+  destroyPyramid();
+  if (m_pipeline) vkDestroyPipeline(device, m_pipeline, nullptr);
+  if (m_pipelineLayout) vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+  if (m_pool) vkDestroyDescriptorPool(device, m_pool, nullptr);
+  if (m_setLayout) vkDestroyDescriptorSetLayout(device, m_setLayout, nullptr);
+  if (m_sampler) vkDestroySampler(device, m_sampler, nullptr);
+  m_pipeline = VK_NULL_HANDLE;
+  m_pipelineLayout = VK_NULL_HANDLE;
+  m_pool = VK_NULL_HANDLE;
+  m_setLayout = VK_NULL_HANDLE;
+  m_sampler = VK_NULL_HANDLE;
+  m_gpu = nullptr;
+}
+
+void HiZPyramid::resize(VkImageView depthView, uint32_t width, uint32_t height) {
+  if (!m_gpu) return;
+  destroyPyramid();
+  VkDevice device = m_gpu->device;
+
+  m_depthWidth = std::max(width, 1u);
+  m_depthHeight = std::max(height, 1u);
+  m_regionWidth = m_depthWidth;
+  m_regionHeight = m_depthHeight;
+  uint32_t w = previousPow2(m_depthWidth), h = previousPow2(m_depthHeight);
+  uint32_t levels = 1;
+  while ((std::max(w, h) >> levels) > 0 && levels < kMaxLevels) ++levels;
+
+  m_image = createImage(*m_gpu, w, h, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        VK_IMAGE_ASPECT_COLOR_BIT, levels);
+  m_fresh = true;
+
+  m_levelViews.resize(levels);
+  for (uint32_t i = 0; i < levels; ++i) {
+    VkImageViewCreateInfo ivci{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    ivci.image = m_image.image;
+    ivci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    ivci.format = VK_FORMAT_R32_SFLOAT;
+    ivci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    ivci.subresourceRange.baseMipLevel = i;
+    ivci.subresourceRange.levelCount = 1;
+    ivci.subresourceRange.layerCount = 1;
+    vkcheck(vkCreateImageView(device, &ivci, nullptr, &m_levelViews[i]), "vkCreateImageView(hiz level)");
+  }
+
+  m_sets.resize(levels);
+  std::vector<VkDescriptorSetLayout> layouts(levels, m_setLayout);
+  VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+  dsai.descriptorPool = m_pool;
+  dsai.descriptorSetCount = levels;
+  dsai.pSetLayouts = layouts.data();
+  vkcheck(vkAllocateDescriptorSets(device, &dsai, m_sets.data()), "vkAllocateDescriptorSets(hiz)");
+
+  for (uint32_t i = 0; i < levels; ++i) {
+    VkDescriptorImageInfo src{};
+    src.sampler = m_sampler;
+    src.imageView = i == 0 ? depthView : m_levelViews[i - 1];
+    src.imageLayout = i == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+    VkDescriptorImageInfo dst{};
+    dst.imageView = m_levelViews[i];
+    dst.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet writes[2]{};
+    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstSet = m_sets[i];
+    writes[0].dstBinding = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].pImageInfo = &src;
+    writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[1].dstSet = m_sets[i];
+    writes[1].dstBinding = 1;
+    writes[1].descriptorCount = 1;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].pImageInfo = &dst;
+    vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+  }
+}
+
+void HiZPyramid::setRegion(uint32_t width, uint32_t height) {
+  m_regionWidth = std::clamp(width, 1u, std::max(m_depthWidth, 1u));
+  m_regionHeight = std::clamp(height, 1u, std::max(m_depthHeight, 1u));
+}
+
+void HiZPyramid::build(VkCommandBuffer cmd) {
+  if (!m_image.image) return;
+
+  // Last frame's culling sampled the pyramid we are about to overwrite.
+  VkImageLayout from = m_fresh ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL;
+  imageBarrier(cmd, m_image.image, VK_IMAGE_ASPECT_COLOR_BIT, from, VK_IMAGE_LAYOUT_GENERAL,
+               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+  m_fresh = false;
+  if (!m_pipeline) return;
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+  uint32_t srcW = m_regionWidth, srcH = m_regionHeight;
+  for (uint32_t i = 0; i < m_image.mipLevels; ++i) {
+    uint32_t dstW = std::max(m_image.width >> i, 1u), dstH = std::max(m_image.height >> i, 1u);
+    HiZPush push{ { srcW, srcH }, { dstW, dstH } };
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_sets[i], 0, nullptr);
+    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    vkCmdDispatch(cmd, (dstW + kGroupSize - 1) / kGroupSize, (dstH + kGroupSize - 1) / kGroupSize, 1);
+
+    // Level i is the next level's input (and, after the last, the cull's).
+    imageBarrier(cmd, m_image.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    srcW = dstW;
+    srcH = dstH;
+  }
+}
+
+} // namespace render
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "VkUtil.h"
+
+namespace render {
+
+/// Hierarchical depth for GPU occlusion culling.
+///
+/// An R32F mip chain whose level 0 is the depth buffer reduced to the next
+/// lower power of two per axis; every texel holds the farthest depth of its
+/// footprint, so "nearest depth of a box > pyramid texel" means the box is
+/// hidden behind what was rasterized. Built in compute, one dispatch per
+/// level, from the depth of the early world pass (see StaticWorld). The
+/// pyramid stays in GENERAL layout: written as a storage image, sampled by
+/// the culling pass with nearest filtering.
+class HiZPyramid {
+public:
+  static constexpr uint32_t kMaxLevels = 16;
+
+  /// False if shaders/hiz_build.comp.spv is missing: the pyramid is still
+  /// created (so descriptors stay valid) but never built; enabled() is false.
+  bool init(const GpuContext& gpu);
+  void shutdown();
+
+  /// Recreates the pyramid for a new depth buffer (sampled in
+  /// DEPTH_STENCIL_READ_ONLY_OPTIMAL). Device idle only.
+  void resize(VkImageView depthView, uint32_t width, uint32_t height);
+  /// The top-left part of the depth buffer this frame renders to (dynamic
+  /// resolution); the pyramid covers just that. Defaults to all of it.
+  void setRegion(uint32_t width, uint32_t height);
+
+  /// Records the reduction. Outside a render pass, after the depth was
+  /// written; ends with a barrier making the pyramid visible to compute.
+  void build(VkCommandBuffer cmd);
+
+  bool enabled() const { return m_pipeline != VK_NULL_HANDLE; }
+  VkImageView view() const { return m_image.view; }
+  VkSampler sampler() const { return m_sampler; }
+  uint32_t width() const { return m_image.width; }
+  uint32_t height() const { return m_image.height; }
+  uint32_t levels() const { return m_image.mipLevels; }
+
+private:
+  void destroyPyramid();
+
+  const GpuContext* m_gpu = nullptr;
+  GpuImage m_image;
+  std::vector<VkImageView> m_levelViews;
+  std::vector<VkDescriptorSet> m_sets; // level i reads level i - 1 (depth for 0)
+  uint32_t m_depthWidth = 0, m_depthHeight = 0;
+  uint32_t m_regionWidth = 0, m_regionHeight = 0;
+  bool m_fresh = false; // still UNDEFINED
+
+  VkSampler m_sampler = VK_NULL_HANDLE;
+  VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+  VkDescriptorPool m_pool = VK_NULL_HANDLE;
+  VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+  VkPipeline m_pipeline = VK_NULL_HANDLE;
+};
+
+} // namespace render
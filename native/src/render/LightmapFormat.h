@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+namespace render {
+
+/// Baked lightmap for a static map, written by the LightmapBaker tool
+/// (native/tools/lightmap). Little endian, tightly packed, in this order:
+///
+///   LightmapHeader
+///   LightmapFace[faceCount]    one per map face, in map order
+///   float uv[uvCount][2]       per face vertex, normalized page coordinates
+///   float rgb[pageCount][pageHeight][pageWidth][3]
+///
+/// Texels hold linear HDR light arriving at the surface, in the same units
+/// as clustered_lighting() returns before the albedo multiply: a lit shader
+/// adds texel * albedo. Faces that got no chart have uvCount 0.
+struct LightmapHeader {
+  char magic[4] = { 'L', 'M', 'A', 'P' };
+  uint32_t version = 1;
+  uint32_t pageWidth = 0, pageHeight = 0, pageCount = 0;
+  uint32_t faceCount = 0, uvCount = 0;
+  uint32_t samplesPerLuxel = 0; // most any luxel received
+  float luxelSize = 0.0f;       // world units per luxel (before per-chart clamping)
+  uint32_t reserved[3] = { 0, 0, 0 };
+};
+static_assert(sizeof(LightmapHeader) == 48, "LightmapHeader is an on-disk layout");
+
+struct LightmapFace {
+  uint32_t page = 0;
+  uint32_t firstUv = 0;
+  uint32_t uvCount = 0;
+  uint32_t pad = 0;
+};
+static_assert(sizeof(LightmapFace) == 16, "LightmapFace is an on-disk layout");
+
+constexpr uint32_t kLightmapVersion = 1;
+
+} // namespace render
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+
+namespace render {
+
+enum class LightType : uint32_t { Point = 0, Spot = 1 };
+constexpr uint32_t kNoShadow = UINT32_MAX; // NO_SHADOW
+
+/// GPU layout (std430, 64 bytes); mirrored by `Light` in
+/// shaders/clustered_common.glsl.
+struct Light {
+  float position[3] = { 0, 0, 0 };
+  float radius = 1.0f;
+  float color[3] = { 1, 1, 1 };
+  float intensity = 1.0f;
+  float direction[3] = { 0, 0, -1 }; // spot only, normalized
+  float cosOuter = -1.0f;            // spot only
+  float cosInner = -1.0f;            // spot only
+  LightType type = LightType::Point;
+  uint32_t shadow = kNoShadow;  // this frame's ShadowAtlas entry, written by ShadowAtlas::update()
+  float shadowImportance = 0.0f; // > 0 asks for a shadow map; 1 = full resolution up close
+};
+static_assert(sizeof(Light) == 64, "Light must match the shader struct");
+
+/// Scene lights with stable ids. Removal frees the slot for reuse; the
+/// renderer uploads the live ones densely every frame.
+class LightList {
+public:
+  static constexpr uint32_t kMaxLights = 1024;
+  static constexpr uint32_t kInvalid = UINT32_MAX;
+
+  uint32_t add(const Light& light) {
+    uint32_t id = kInvalid;
+    if (!m_free.empty()) {
+      id = m_free.back();
+      m_free.pop_back();
+    } else if (m_lights.size() < kMaxLights) {
+      id = (uint32_t)m_lights.size();
+      m_lights.emplace_back();
+      m_alive.push_back(false);
+    } else {
+      return kInvalid;
+    }
+    m_lights[id] = light;
+    m_alive[id] = true;
+    m_count++;
+    return id;
+  }
+
+  void remove(uint32_t id) {
+    if (!valid(id)) return;
+    m_alive[id] = false;
+    m_free.push_back(id);
+    m_count--;
+  }
+
+  bool valid(uint32_t id) const { return id < m_lights.size() && m_alive[id]; }
+  Light* get(uint32_t id) { return valid(id) ? &m_lights[id] : nullptr; }
+
+  uint32_t count() const { return m_count; }
+
+  /// All slots, dead ones included, for snapshots; alive(i) tells them apart.
+  uint32_t slotCount() const { return (uint32_t)m_lights.size(); }
+  const Light* slots() const { return m_lights.data(); }
+  bool alive(uint32_t i) const { return m_alive[i]; }
+
+  /// Replaces every light with saved slots (at most kMaxLights).
+  void restore(const Light* slots, const uint8_t* alive, uint32_t count) {
+    if (count > kMaxLights) count = kMaxLights;
+    m_lights.assign(slots, slots + count);
+    m_alive.assign(count, false);
+    m_free.clear();
+    m_count = 0;
+    for (uint32_t i = count; i-- > 0;) { // lowest free id is reused first
+      m_alive[i] = alive[i] != 0;
+      if (m_alive[i]) m_count++;
+      else m_free.push_back(i);
+    }
+  }
+
+  /// Copies live lights into dst (capacity kMaxLights); returns how many.
+  uint32_t pack(Light* dst) const {
+    uint32_t n = 0;
+    for (size_t i = 0; i < m_lights.size(); ++i) {
+      if (m_alive[i]) dst[n++] = m_lights[i];
+    }
+    return n;
+  }
+
+private:
+  memory::TrackedVector<Light, memory::MemTag::Render> m_lights;
+  memory::TrackedVector<bool, memory::MemTag::Render> m_alive;
+  memory::TrackedVector<uint32_t, memory::MemTag::Render> m_free;
+  uint32_t m_count = 0;
+};
+
+} // namespace render
@@ -0,0 +1,436 @@
+#include "ParticleSystem.h"
+#include "Camera.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace render {
+
+static constexpr uint32_t kBindingCount = 11;
+static constexpr uint32_t kDepthBinding = 10;
+static constexpr uint32_t kGroupSize = 64; // PARTICLE_GROUP
+
+struct ParticlePush {
+  uint32_t current;
+};
+
+bool ParticleSystem::init(const GpuContext& gpu, uint32_t framesInFlight, VkRenderPass renderPass,
+                          uint32_t capacity) {
+  m_gpu = &gpu;
+  m_capacity = std::max(capacity, kGroupSize);
+  VkDevice device = gpu.device;
+
+  // ---- layout: one set for all compute passes and the draw ----
+  VkDescriptorSetLayoutBinding bindings[kBindingCount]{};
+  for (uint32_t i = 0; i < kBindingCount; ++i) {
+    bindings[i].binding = i;
+    bindings[i].descriptorCount = 1;
+    bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+  }
+  bindings[kDepthBinding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bindings[kDepthBinding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutCreateInfo dslci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+  dslci.bindingCount = kBindingCount;
+  dslci.pBindings = bindings;
+  vkcheck(vkCreateDescriptorSetLayout(device, &dslci, nullptr, &m_setLayout),
+          "vkCreateDescriptorSetLayout(particles)");
+
+  VkDescriptorPoolSize sizes[3]{};
+  sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  sizes[0].descriptorCount = framesInFlight;
+  sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  sizes[1].descriptorCount = framesInFlight * (kBindingCount - 2);
+  sizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  sizes[2].descriptorCount = framesInFlight;
+
+  VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+  dpci.maxSets = framesInFlight;
+  dpci.poolSizeCount = 3;
+  dpci.pPoolSizes = sizes;
+  vkcheck(vkCreateDescriptorPool(device, &dpci, nullptr, &m_pool), "vkCreateDescriptorPool(particles)");
+
+  VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+  sci.magFilter = VK_FILTER_NEAREST;
+  sci.minFilter = VK_FILTER_NEAREST;
+  sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  vkcheck(vkCreateSampler(device, &sci, nullptr, &m_depthSampler), "vkCreateSampler(particle depth)");
+
+  // ---- particle state: device local, never mapped ----
+  const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  const VkMemoryPropertyFlags local = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+  m_posAge = createBuffer(gpu, sizeof(float) * 4 * m_capacity, storage, local);
+  m_velLife = createBuffer(gpu, sizeof(float) * 4 * m_capacity, storage, local);
+  m_color = createBuffer(gpu, sizeof(uint32_t) * m_capacity, storage, local);
+  m_physics = createBuffer(gpu, sizeof(float) * 4 * m_capacity, storage, local);
+  m_alive = createBuffer(gpu, sizeof(uint32_t) * 2 * m_capacity, storage, local);
+  m_dead = createBuffer(gpu, sizeof(uint32_t) * m_capacity, storage, local);
+  m_counters = createBuffer(gpu, sizeof(uint32_t) * 4, storage, local);
+  m_args = createBuffer(gpu, sizeof(uint32_t) * 10, storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, local);
+
+  m_frames.resize(framesInFlight);
+  for (Frame& f : m_frames) {
+    f.params = createBuffer(gpu, sizeof(Params), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, host);
+    f.bursts = createBuffer(gpu, sizeof(ParticleBurst) * kMaxBursts, storage, host);
+
+    VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dsai.descriptorPool = m_pool;
+    dsai.descriptorSetCount = 1;
+    dsai.pSetLayouts = &m_setLayout;
+    vkcheck(vkAllocateDescriptorSets(device, &dsai, &f.set), "vkAllocateDescriptorSets(particles)");
+    writeStateDescriptors(f);
+  }
+
+  // ---- pipelines ----
+  VkPushConstantRange pcr{};
+  pcr.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+  pcr.offset = 0;
+  pcr.size = sizeof(ParticlePush);
+
+  VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+  plci.setLayoutCount = 1;
+  plci.pSetLayouts = &m_setLayout;
+  plci.pushConstantRangeCount = 1;
+  plci.pPushConstantRanges = &pcr;
+  vkcheck(vkCreatePipelineLayout(device, &plci, nullptr, &m_pipelineLayout),
+          "vkCreatePipelineLayout(particles)");
+
+  m_init = createComputePipeline(gpu, m_pipelineLayout, "shaders/particle_init.comp.spv");
+  m_kickoff = createComputePipeline(gpu, m_pipelineLayout, "shaders/particle_kickoff.comp.spv");
+  m_emit = createComputePipeline(gpu, m_pipelineLayout, "shaders/particle_emit.comp.spv");
+  m_simulate = createComputePipeline(gpu, m_pipelineLayout, "shaders/particle_simulate.comp.spv");
+  if (!m_init || !m_kickoff || !m_emit || !m_simulate) {
+    core::logError(core::LogCategory::Render, "GPU particles disabled: shaders/particle_*.comp.spv missing");
+    for (VkPipeline* p : { &m_init, &m_kickoff, &m_emit, &m_simulate }) {
+      if (*p) vkDestroyPipeline(device, *p, nullptr);
+      *p = VK_NULL_HANDLE;
+    }
+    return false;
+  }
+
+  createRenderPipeline(renderPass);
+  m_pending.reserve(kMaxBursts);
+
+  core::logInfo(core::LogCategory::Render, "GPU particles: %u capacity, %u bursts/frame", m_capacity, kMaxBursts);
+  return true;
+}
+
+void ParticleSystem::writeStateDescriptors(Frame& f) {
+  const GpuBuffer* buffers[kDepthBinding] = {
+    &f.params, &f.bursts, &m_posAge, &m_velLife, &m_color, &m_physics, &m_alive, &m_dead, &m_counters, &m_args
+  };
+  VkDescriptorBufferInfo infos[kDepthBinding]{};
+  VkWriteDescriptorSet writes[kDepthBinding]{};
+  for (uint32_t i = 0; i < kDepthBinding; ++i) {
+    infos[i].buffer = buffers[i]->buffer;
+    infos[i].offset = 0;
+    infos[i].range = VK_WHOLE_SIZE;
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].dstSet = f.set;
+    writes[i].dstBinding = i;
+    writes[i].descriptorCount = 1;
+    writes[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[i].pBufferInfo = &infos[i];
+  }
+  vkUpdateDescriptorSets(m_gpu->device, kDepthBinding, writes, 0, nullptr);
+}
+
+void ParticleSystem::createRenderPipeline(VkRenderPass renderPass) {
+  if (!m_gpu || !m_simulate || m_render) return;
+
+  std::vector<uint32_t> vertSpv = readSpv("shaders/particle.vert.spv", false);
+  std::vector<uint32_t> fragSpv = readSpv("shaders/particle.frag.spv", false);
+  if (vertSpv.empty() || fragSpv.empty()) {
+    core::logError(core::LogCategory::Render, "GPU particles simulate but do not draw: shaders/particle.*.spv missing");
+    return;
+  }
+  VkDevice device = m_gpu->device;
+  VkShaderModule vert = createShaderModule(device, vertSpv);
+  VkShaderModule frag = createShaderModule(device, fragSpv);
+
+  VkPipelineShaderStageCreateInfo stages[2]{};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = vert;
+  stages[0].pName = "main";
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = frag;
+  stages[1].pName = "main";
+
+  VkPipelineVertexInputStateCreateInfo vis{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+
+  VkPipelineInputAssemblyStateCreateInfo ias{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+  ias.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  VkPipelineViewportStateCreateInfo vps{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+  vps.viewportCount = 1;
+  vps.scissorCount = 1;
+
+  VkPipelineRasterizationStateCreateInfo rs{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+  rs.polygonMode = VK_POLYGON_MODE_FILL;
+  rs.lineWidth = 1.0f;
+  rs.cullMode = VK_CULL_MODE_NONE;
+  rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+  VkPipelineMultisampleStateCreateInfo ms{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  // Depth tested against the scene, never written: particles do not sort.
+  VkPipelineDepthStencilStateCreateInfo dss{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+  dss.depthTestEnable = VK_TRUE;
+  dss.depthWriteEnable = VK_FALSE;
+  dss.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+  // Premultiplied alpha: alpha 0 turns the same blend into additive.
+  VkPipelineColorBlendAttachmentState cba{};
+  cba.blendEnable = VK_TRUE;
+  cba.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+  cba.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  cba.colorBlendOp = VK_BLEND_OP_ADD;
+  cba.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+  cba.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  cba.alphaBlendOp = VK_BLEND_OP_ADD;
+  cba.colorWriteMask =
+    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+  VkPipelineColorBlendStateCreateInfo cbs{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+  cbs.attachmentCount = 1;
+  cbs.pAttachments = &cba;
+
+  VkDynamicState dynStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+  VkPipelineDynamicStateCreateInfo ds{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+  ds.dynamicStateCount = 2;
+  ds.pDynamicStates = dynStates;
+
+  VkGraphicsPipelineCreateInfo gpci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+  gpci.stageCount = 2;
+  gpci.pStages = stages;
+  gpci.pVertexInputState = &vis;
+  gpci.pInputAssemblyState = &ias;
+  gpci.pViewportState = &vps;
+  gpci.pRasterizationState = &rs;
+  gpci.pMultisampleState = &ms;
+  gpci.pDepthStencilState = &dss;
+  gpci.pColorBlendState = &cbs;
+  gpci.pDynamicState = &ds;
+  gpci.layout = m_pipelineLayout;
+  gpci.renderPass = renderPass;
+  gpci.subpass = 0;
+  vkcheck(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gpci, nullptr, &m_render),
+          "vkCreateGraphicsPipelines(particles)");
+
+  vkDestroyShaderModule(device, frag, nullptr);
+  vkDestroyShaderModule(device, vert, nullptr);
+}
+
+void ParticleSystem::destroyRenderPipeline() {
+  if (m_gpu && m_render) vkDestroyPipeline(m_gpu->device, m_render, nullptr);
+  m_render = VK_NULL_HANDLE;
+}
+
+void ParticleSystem::shutdown() {
+  if (!m_gpu) return;
+  VkDevice device = m_gpu->device;
+
+  destroyRenderPipeline();
+  for (Frame& f : m_frames) {
+    destroyBuffer(*m_gpu, f.params);
+    destroyBuffer(*m_gpu, f.bursts);
+  }
+  m_frames.clear();
+  for (GpuBuffer* b : { &m_posAge, &m_velLife, &m_color, &m_physics, &m_alive, &m_dead, &m_counters, &m_args }) {
+    destroyBuffer(*m_gpu, *b);
+  }
+
+  for (VkPipeline p : { m_init, m_kickoff, m_emit, m_simulate }) {
+    if (p) vkDestroyPipeline(device, p, nullptr);
+  }
+  if (m_pipelineLayout) vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+  if (m_pool) vkDestroyDescriptorPool(device, m_pool, nullptr);
+  if (m_setLayout) vkDestroyDescriptorSetLayout(device, m_setLayout, nullptr);
+  if (m_depthSampler) vkDestroySampler(device, m_depthSampler, nullptr);
+  m_init = m_kickoff = m_emit = m_simulate = VK_NULL_HANDLE;
+  m_pipelineLayout = VK_NULL_HANDLE;
+  m_pool = VK_NULL_HANDLE;
+  m_setLayout = VK_NULL_HANDLE;
+  m_depthSampler = VK_NULL_HANDLE;
+  m_depthView = VK_NULL_HANDLE;
+  m_pending.clear();
+  m_pendingCount = 0;
+  m_needsReset = true;
+  m_gpu = nullptr;
+}
+
+void ParticleSystem::setDepth(VkImageView depthView, uint32_t width, uint32_t height) {
+  m_depthView = depthView;
+  m_depthWidth = std::max(width, 1u);
+  m_depthHeight = std::max(height, 1u);
+  m_renderWidth = m_lastRenderWidth = m_depthWidth;
+  m_renderHeight = m_lastRenderHeight = m_depthHeight;
+  m_haveLastViewProj = false; // fresh depth is cleared, old matrix is meaningless
+  if (!m_gpu || !depthView) return;
+
+  VkDescriptorImageInfo info{};
+  info.sampler = m_depthSampler;
+  info.imageView = depthView;
+  info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+  for (Frame& f : m_frames) {
+    VkWriteDescriptorSet w{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    w.dstSet = f.set;
+    w.dstBinding = kDepthBinding;
+    w.descriptorCount = 1;
+    w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    w.pImageInfo = &info;
+    vkUpdateDescriptorSets(m_gpu->device, 1, &w, 0, nullptr);
+  }
+}
+
+void ParticleSystem::setRenderSize(uint32_t width, uint32_t height) {
+  m_renderWidth = std::clamp(width, 1u, m_depthWidth);
+  m_renderHeight = std::clamp(height, 1u, m_depthHeight);
+}
+
+uint32_t ParticleSystem::emit(const ParticleBurst& burst) {
+  if (!m_simulate || burst.count == 0 || m_pending.size() >= kMaxBursts) return 0;
+  uint32_t room = m_capacity - std::min(m_pendingCount, m_capacity);
+  uint32_t count = std::min(burst.count, room);
+  if (count == 0) return 0;
+
+  ParticleBurst b = burst;
+  b.count = count;
+  m_pending.push_back(b);
+  m_pendingCount += count;
+  return count;
+}
+
+void ParticleSystem::update(uint32_t frameIndex, const Camera& camera, float dt) {
+  if (m_frames.empty()) return;
+  Frame& f = m_frames[frameIndex];
+
+  // Bursts become a sorted prefix-sum table; emit threads binary-search it.
+  auto* out = static_cast<ParticleBurst*>(f.bursts.mapped);
+  uint32_t first = 0;
+  for (size_t i = 0; i < m_pending.size(); ++i) {
+    ParticleBurst b = m_pending[i];
+    b.first = first;
+    b.seed = (m_frameSeed + 1) * 0x85EBCA6Bu ^ (uint32_t)i * 0xC2B2AE35u;
+    out[i] = b;
+    first += b.count;
+  }
+
+  float aspect = (float)m_depthWidth / (float)m_depthHeight;
+  Mat4 view = camera.view();
+  Mat4 viewProj = camera.projection(aspect) * view;
+  if (!m_haveLastViewProj) {
+    m_lastViewProj = viewProj;
+    m_haveLastViewProj = true;
+  }
+
+  Params p{};
+  p.viewProj = viewProj;
+  p.depthViewProj = m_lastViewProj;
+  p.depthInvViewProj = inverse(m_lastViewProj);
+  // Rows of the view matrix are the camera axes in world space.
+  p.cameraRight[0] = view.at(0, 0); p.cameraRight[1] = view.at(0, 1); p.cameraRight[2] = view.at(0, 2);
+  p.cameraUp[0] = view.at(1, 0);    p.cameraUp[1] = view.at(1, 1);    p.cameraUp[2] = view.at(1, 2);
+  p.viewport[0] = (float)m_lastRenderWidth;
+  p.viewport[1] = (float)m_lastRenderHeight;
+  p.viewport[2] = 1.0f / (float)m_lastRenderWidth;
+  p.viewport[3] = 1.0f / (float)m_lastRenderHeight;
+  p.sim[0] = std::min(dt, 0.1f); // clamp hitches so particles do not tunnel
+  p.sim[1] = 0.25f;              // collision thickness, world units
+  p.sim[2] = (float)m_lastRenderWidth / (float)m_depthWidth;
+  p.sim[3] = (float)m_lastRenderHeight / (float)m_depthHeight;
+  p.counts[0] = m_capacity;
+  p.counts[1] = first;
+  p.counts[2] = (uint32_t)m_pending.size();
+  p.counts[3] = m_frameSeed++;
+  std::memcpy(f.params.mapped, &p, sizeof(p));
+
+  m_lastViewProj = viewProj;
+  m_lastRenderWidth = m_renderWidth;
+  m_lastRenderHeight = m_renderHeight;
+  m_pending.clear();
+  m_pendingCount = 0;
+}
+
+void ParticleSystem::simulate(VkCommandBuffer cmd, uint32_t frameIndex) {
+  if (m_frames.empty() || !m_simulate || !m_depthView) return;
+  Frame& f = m_frames[frameIndex];
+
+  ParticlePush push{ m_current };
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &f.set, 0, nullptr);
+  vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,
+                     0, sizeof(push), &push);
+
+  VkMemoryBarrier mb{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  const VkPipelineStageFlags compute = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+  if (m_needsReset) {
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_init);
+    vkCmdDispatch(cmd, (m_capacity + kGroupSize - 1) / kGroupSize, 1, 1);
+    vkCmdPipelineBarrier(cmd, compute, compute, 0, 1, &mb, 0, nullptr, 0, nullptr);
+    m_needsReset = false;
+  } else {
+    // Last frame's simulate wrote the state, its draw read it.
+    vkCmdPipelineBarrier(cmd,
+                         compute | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         compute, 0, 1, &mb, 0, nullptr, 0, nullptr);
+  }
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_kickoff);
+  vkCmdDispatch(cmd, 1, 1, 1);
+
+  VkMemoryBarrier argsBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+  argsBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  argsBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                              VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(cmd, compute, compute | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       0, 1, &argsBarrier, 0, nullptr, 0, nullptr);
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_emit);
+  vkCmdDispatchIndirect(cmd, m_args.buffer, kEmitArgsOffset);
+  vkCmdPipelineBarrier(cmd, compute, compute, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  // Depth of the previous frame's pass (same image, stored at its end).
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_simulate);
+  vkCmdDispatchIndirect(cmd, m_args.buffer, kSimArgsOffset);
+
+  VkMemoryBarrier drawBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+  drawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  drawBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(cmd, compute, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                       0, 1, &drawBarrier, 0, nullptr, 0, nullptr);
+
+  f.current = m_current;
+  f.simulated = true;
+  m_current ^= 1u;
+}
+
+void ParticleSystem::draw(VkCommandBuffer cmd, uint32_t frameIndex) {
+  if (m_frames.empty() || !m_render) return;
+  Frame& f = m_frames[frameIndex];
+  if (!f.simulated) return;
+  f.simulated = false;
+
+  ParticlePush push{ f.current };
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_render);
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &f.set, 0, nullptr);
+  vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,
+                     0, sizeof(push), &push);
+  vkCmdDrawIndirect(cmd, m_args.buffer, kDrawArgsOffset, 1, sizeof(VkDrawIndirectCommand));
+}
+
+} // namespace render
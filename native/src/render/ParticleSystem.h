@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "VkUtil.h"
+#include "RenderMath.h"
+
+namespace render {
+
+struct Camera;
+
+/// One emission request. GPU layout (std430, 96 bytes); mirrored by `Burst`
+/// in shaders/particle_common.glsl. `first`/`seed` are filled in by update().
+struct ParticleBurst {
+  float position[3] = { 0, 0, 0 };
+  uint32_t count = 0;
+  float direction[3] = { 0, 1, 0 }; // cone axis, normalized
+  float cosSpread = 0.0f;           // cos of the cone half angle
+  float color[4] = { 1, 1, 1, 1 };  // premultiplied; alpha 0 = additive
+  float speedMin = 1.0f, speedMax = 2.0f;
+  float lifeMin = 0.5f, lifeMax = 1.0f;
+  float size = 0.05f;               // half extent of the quad, world units
+  float gravity = 9.81f;            // downwards acceleration
+  float drag = 0.0f;                // velocity damping per second
+  float bounce = 0.3f;              // restitution; < 0 disables depth collision
+  uint32_t first = 0;
+  uint32_t seed = 0;
+  uint32_t pad[2] = { 0, 0 };
+};
+static_assert(sizeof(ParticleBurst) == 96, "ParticleBurst must match the shader struct");
+
+/// GPU-resident particle simulation.
+///
+/// Particle state lives in device-local SoA buffers (position/age,
+/// velocity/lifetime, colour, physics params) that the CPU never reads or
+/// writes. Free ids sit on a dead list; live ids in one of two alive lists
+/// that are ping-ponged every frame. Per frame, all on the GPU:
+///
+///   kickoff   1 thread: clamp the emit request to the dead count, write the
+///             indirect dispatch args, reset the draw's instance count
+///   emit      pop dead ids, spawn from this frame's bursts
+///   simulate  integrate, collide against last frame's depth buffer, push
+///             dead ids back, compact survivors into the other list
+///   draw      vkCmdDrawIndirect, instanceCount written by simulate
+///
+/// The CPU only uploads the (small) burst list and per-frame params.
+class ParticleSystem {
+public:
+  static constexpr uint32_t kDefaultCapacity = 1u << 17;
+  static constexpr uint32_t kMaxBursts = 256; // per frame
+
+  /// False if a compute shader is missing; emit() then drops everything.
+  bool init(const GpuContext& gpu, uint32_t framesInFlight, VkRenderPass renderPass,
+            uint32_t capacity = kDefaultCapacity);
+  void shutdown();
+
+  /// The draw pipeline depends on the render pass; rebuild it when that is
+  /// recreated.
+  void createRenderPipeline(VkRenderPass renderPass);
+  void destroyRenderPipeline();
+
+  /// Scene depth sampled for collisions, in DEPTH_STENCIL_READ_ONLY_OPTIMAL
+  /// layout when simulate() runs. Rewrites every frame's descriptor set, so
+  /// only call with the device idle (swapchain rebuild).
+  void setDepth(VkImageView depthView, uint32_t width, uint32_t height);
+  /// Size this frame's scene renders at, the top-left part of the depth
+  /// buffer (dynamic resolution). Collisions next frame read that part.
+  void setRenderSize(uint32_t width, uint32_t height);
+
+  /// Queues a burst for the next update(); returns how many particles were
+  /// accepted (0 when the per-frame burst list or capacity is exhausted).
+  uint32_t emit(const ParticleBurst& burst);
+
+  /// CPU side for the frame: uploads queued bursts and params. Call after the
+  /// frame's fence wait.
+  void update(uint32_t frameIndex, const Camera& camera, float dt);
+
+  /// Records kickoff/emit/simulate. Outside a render pass; ends with a
+  /// barrier making the results visible to the indirect draw.
+  void simulate(VkCommandBuffer cmd, uint32_t frameIndex);
+
+  /// Records the indirect draw. Inside the render pass, after opaque geometry.
+  void draw(VkCommandBuffer cmd, uint32_t frameIndex);
+
+  bool enabled() const { return m_simulate != VK_NULL_HANDLE; }
+  uint32_t capacity() const { return m_capacity; }
+
+private:
+  struct Params {
+    Mat4 viewProj;
+    Mat4 depthViewProj;
+    Mat4 depthInvViewProj;
+    float cameraRight[4];
+    float cameraUp[4];
+    float viewport[4];
+    float sim[4];
+    uint32_t counts[4];
+  };
+
+  struct Frame {
+    GpuBuffer params; // UBO, host visible
+    GpuBuffer bursts; // SSBO, host visible
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    uint32_t current = 0;   // alive list simulate() consumed for this frame
+    bool simulated = false; // draw() only follows a recorded simulate()
+  };
+
+  // Byte offsets inside m_args, see IndirectArgs in particle_common.glsl.
+  static constexpr VkDeviceSize kEmitArgsOffset = 0;
+  static constexpr VkDeviceSize kSimArgsOffset = 12;
+  static constexpr VkDeviceSize kDrawArgsOffset = 24;
+
+  void writeStateDescriptors(Frame& f);
+
+  const GpuContext* m_gpu = nullptr;
+  uint32_t m_capacity = 0;
+  std::vector<Frame> m_frames;
+
+  // Device-local, shared by all frames: the GPU serializes them.
+  GpuBuffer m_posAge, m_velLife, m_color, m_physics;
+  GpuBuffer m_alive, m_dead, m_counters, m_args;
+
+  VkSampler m_depthSampler = VK_NULL_HANDLE;
+  VkImageView m_depthView = VK_NULL_HANDLE;
+  uint32_t m_depthWidth = 1, m_depthHeight = 1;
+  uint32_t m_renderWidth = 1, m_renderHeight = 1;
+  uint32_t m_lastRenderWidth = 1, m_lastRenderHeight = 1; // what the depth buffer holds
+
+  VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+  VkDescriptorPool m_pool = VK_NULL_HANDLE;
+  VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+  VkPipeline m_init = VK_NULL_HANDLE;
+  VkPipeline m_kickoff = VK_NULL_HANDLE;
+  VkPipeline m_emit = VK_NULL_HANDLE;
+  VkPipeline m_simulate = VK_NULL_HANDLE;
+  VkPipeline m_render = VK_NULL_HANDLE;
+
+  std::vector<ParticleBurst> m_pending;
+  uint32_t m_pendingCount = 0;
+  uint32_t m_current = 0;       // alive list simulated next
+  uint32_t m_frameSeed = 0;
+  bool m_needsReset = true;
+  Mat4 m_lastViewProj;          // what the depth buffer was rendered with
+  bool m_haveLastViewProj = false;
+};
+
+} // namespace render
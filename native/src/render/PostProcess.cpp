@@ -0,0 +1,618 @@
+#include "PostProcess.h"
+#include "Camera.h"
+#include "../core/Log.h"
+
+#include "shaders/bloom_down.comp.h"
+#include "shaders/bloom_up.comp.h"
+#include "shaders/post_fullscreen.vert.h"
+#include "shaders/post_resolve.frag.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace render {
+
+static constexpr uint32_t kDownTile = 64; // level 0 texels per bloom_down group and axis
+static constexpr uint32_t kUpGroupSize = 8;
+static constexpr uint32_t kLutBytes = PostProcess::kLutSize * PostProcess::kLutSize * PostProcess::kLutSize * 4;
+
+static const ShaderReflection* const kBloomDown[] = { &shaders::kBloomDownComp };
+static const ShaderReflection* const kBloomUp[] = { &shaders::kBloomUpComp };
+static const ShaderReflection* const kResolveShaders[] = { &shaders::kPostFullscreenVert, &shaders::kPostResolveFrag };
+
+struct BloomDownPush {
+  float invSize[2];
+  float threshold;
+  float knee;
+  float region[4]; // uv scale to the rendered part of the HDR target, uv clamp
+};
+
+struct BloomUpPush {
+  float srcTexel[2];
+  float srcLevel;
+  float radius;
+};
+
+struct ResolvePush {
+  float fog[4];    // rgb, density
+  float params[4]; // exposure, bloom intensity, near, far
+  float region[4]; // uv scale to the rendered part of the HDR target, uv clamp
+  float misc[4];   // HDR texel size (uv), sharpness, LUT size
+};
+
+namespace {
+
+float srgbEncode(float c) {
+  return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// The LUT maps tonemapped linear color to graded linear color. It is
+// indexed by sqrt(color) and stored sRGB, so its 32 steps are spent where
+// the eye tells them apart.
+void bakeLut(const PostProcess::ColorGrade& grade, uint32_t* out) {
+  const uint32_t n = PostProcess::kLutSize;
+  const float pivot = std::sqrt(0.18f); // mid grey
+  for (uint32_t b = 0; b < n; ++b) {
+    for (uint32_t g = 0; g < n; ++g) {
+      for (uint32_t r = 0; r < n; ++r) {
+        const uint32_t idx[3] = { r, g, b };
+        float c[3];
+        for (int i = 0; i < 3; ++i) {
+          float s = (float)idx[i] / (float)(n - 1);
+          s = std::clamp((s - pivot) * grade.contrast + pivot, 0.0f, 1.0f);
+          c[i] = s * s;
+        }
+        const float luma = 0.2126f * c[0] + 0.7152f * c[1] + 0.0722f * c[2];
+        uint32_t texel = 0xffu << 24;
+        for (int i = 0; i < 3; ++i) {
+          float v = std::clamp((luma + (c[i] - luma) * grade.saturation) * grade.gain[i], 0.0f, 1.0f);
+          texel |= (uint32_t)std::lround(srgbEncode(v) * 255.0f) << (8 * i);
+        }
+        out[(b * n + g) * n + r] = texel;
+      }
+    }
+  }
+}
+
+GpuImage createLut(const GpuContext& gpu) {
+  const uint32_t n = PostProcess::kLutSize;
+  GpuImage img{};
+  img.format = VK_FORMAT_R8G8B8A8_SRGB;
+  img.width = n;
+  img.height = n;
+
+  VkImageCreateInfo ici{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+  ici.imageType = VK_IMAGE_TYPE_3D;
+  ici.format = img.format;
+  ici.extent = { n, n, n };
+  ici.mipLevels = 1;
+  ici.arrayLayers = 1;
+  ici.samples = VK_SAMPLE_COUNT_1_BIT;
+  ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+  ici.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  vkcheck(vkCreateImage(gpu.device, &ici, nullptr, &img.image), "vkCreateImage(post lut)");
+
+  VkMemoryRequirements req{};
+  vkGetImageMemoryRequirements(gpu.device, img.image, &req);
+  VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+  mai.allocationSize = req.size;
+  mai.memoryTypeIndex = findMemoryType(gpu, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  vkcheck(vkAllocateMemory(gpu.device, &mai, nullptr, &img.memory), "vkAllocateMemory(post lut)");
+  vkcheck(vkBindImageMemory(gpu.device, img.image, img.memory, 0), "vkBindImageMemory(post lut)");
+
+  VkImageViewCreateInfo ivci{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+  ivci.image = img.image;
+  ivci.viewType = VK_IMAGE_VIEW_TYPE_3D;
+  ivci.format = img.format;
+  ivci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  ivci.subresourceRange.levelCount = 1;
+  ivci.subresourceRange.layerCount = 1;
+  vkcheck(vkCreateImageView(gpu.device, &ivci, nullptr, &img.view), "vkCreateImageView(post lut)");
+  return img;
+}
+
+VkPipelineLayout createLayout(VkDevice device, VkDescriptorSetLayout setLayout, const ShaderReflection* const* shaders,
+                              uint32_t count, const char* what) {
+  VkPushConstantRange pcr = pushConstantRange(shaders, count);
+  VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+  plci.setLayoutCount = 1;
+  plci.pSetLayouts = &setLayout;
+  plci.pushConstantRangeCount = pcr.size ? 1 : 0;
+  plci.pPushConstantRanges = &pcr;
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+  vkcheck(vkCreatePipelineLayout(device, &plci, nullptr, &layout), what);
+  return layout;
+}
+
+void writeImages(VkDevice device, VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+                 const VkDescriptorImageInfo* infos, uint32_t count) {
+  VkWriteDescriptorSet w{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+  w.dstSet = set;
+  w.dstBinding = binding;
+  w.descriptorCount = count;
+  w.descriptorType = type;
+  w.pImageInfo = infos;
+  vkUpdateDescriptorSets(device, 1, &w, 0, nullptr);
+}
+
+} // namespace
+
+bool PostProcess::init(const GpuContext& gpu, uint32_t framesInFlight) {
+  m_gpu = &gpu;
+  VkDevice device = gpu.device;
+
+  VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+  sci.magFilter = VK_FILTER_LINEAR;
+  sci.minFilter = VK_FILTER_LINEAR;
+  sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST; // bloom reads whole levels
+  sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.maxLod = (float)kBloomLevels;
+  vkcheck(vkCreateSampler(device, &sci, nullptr, &m_linear), "vkCreateSampler(post linear)");
+  // Depth formats need not support linear filtering.
+  sci.magFilter = VK_FILTER_NEAREST;
+  sci.minFilter = VK_FILTER_NEAREST;
+  sci.maxLod = 0.0f;
+  vkcheck(vkCreateSampler(device, &sci, nullptr, &m_nearest), "vkCreateSampler(post nearest)");
+
+  m_lut = createLut(gpu);
+  m_lutStaging = createBuffer(gpu, (VkDeviceSize)kLutBytes * framesInFlight, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  m_lutTexels.resize(kLutSize * kLutSize * kLutSize);
+  setColorGrade(ColorGrade{});
+  m_lutFresh = true;
+
+  // ---- layouts, as the shaders declare them ----
+  m_downSetLayout = createSetLayout(device, 0, kBloomDown, 1, "vkCreateDescriptorSetLayout(bloom down)");
+  m_upSetLayout = createSetLayout(device, 0, kBloomUp, 1, "vkCreateDescriptorSetLayout(bloom up)");
+  m_resolveSetLayout = createSetLayout(device, 0, kResolveShaders, 2, "vkCreateDescriptorSetLayout(post resolve)");
+
+  std::vector<VkDescriptorPoolSize> sizes;
+  addPoolSizes(sizes, 0, kBloomDown, 1, 1);
+  addPoolSizes(sizes, 0, kBloomUp, 1, kBloomLevels - 1);
+  addPoolSizes(sizes, 0, kResolveShaders, 2, 1);
+  VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+  dpci.maxSets = kBloomLevels + 1;
+  dpci.poolSizeCount = (uint32_t)sizes.size();
+  dpci.pPoolSizes = sizes.data();
+  vkcheck(vkCreateDescriptorPool(device, &dpci, nullptr, &m_pool), "vkCreateDescriptorPool(post)");
+
+  m_downLayout = createLayout(device, m_downSetLayout, kBloomDown, 1, "vkCreatePipelineLayout(bloom down)");
+  m_upLayout = createLayout(device, m_upSetLayout, kBloomUp, 1, "vkCreatePipelineLayout(bloom up)");
+  m_resolveLayout = createLayout(device, m_resolveSetLayout, kResolveShaders, 2, "vkCreatePipelineLayout(post resolve)");
+
+  if (gpu.props.limits.timestampComputeAndGraphics) {
+    VkQueryPoolCreateInfo qpci{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    qpci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    qpci.queryCount = 2 * framesInFlight;
+    vkcheck(vkCreateQueryPool(device, &qpci, nullptr, &m_queries), "vkCreateQueryPool(post)");
+  }
+  m_queried.assign(framesInFlight, 0);
+
+  m_down = createComputePipeline(gpu, m_downLayout, shaders::kBloomDownComp.spvPath);
+  m_up = createComputePipeline(gpu, m_upLayout, shaders::kBloomUpComp.spvPath);
+  if (!m_down || !m_up) {
+    core::logError(core::LogCategory::Render, "Bloom disabled: %s missing",
+                   m_down ? shaders::kBloomUpComp.spvPath : shaders::kBloomDownComp.spvPath);
+    return false;
+  }
+  core::logInfo(core::LogCategory::Render, "Post: %s HDR, %u bloom levels at half resolution, %u^3 grading LUT",
+                "RGBA16F", kBloomLevels, kLutSize);
+  return true;
+}
+
+void PostProcess::destroyTargets() {
+  if (!m_gpu) return;
+  for (VkImageView& v : m_bloomLevels) {
+    if (v) vkDestroyImageView(m_gpu->device, v, nullptr);
+    v = VK_NULL_HANDLE;
+  }
+  m_downSet = VK_NULL_HANDLE;
+  for (VkDescriptorSet& s : m_upSets) s = VK_NULL_HANDLE;
+  m_resolveSet = VK_NULL_HANDLE;
+  if (m_pool) vkResetDescriptorPool(m_gpu->device, m_pool, 0);
+  destroyImage(*m_gpu, m_bloom);
+  destroyImage(*m_gpu, m_hdr);
+}
+
+void PostProcess::shutdown() {
+  if (!m_gpu) return;
+  VkDevice device = m_gpu->device;
+
+  destroyTargets();
+  destroyOutputPipeline();
+  m_resolve.shutdown();
+  destroyImage(*m_gpu, m_lut);
+  destroyBuffer(*m_gpu, m_lutStaging);
+  m_lutTexels.clear();
+
+  if (m_queries) vkDestroyQueryPool(device, m_queries, nullptr);
+  if (m_down) vkDestroyPipeline(device, m_down, nullptr);
+  if (m_up) vkDestroyPipeline(device, m_up, nullptr);
+  if (m_downLayout) vkDestroyPipelineLayout(device, m_downLayout, nullptr);
+  if (m_upLayout) vkDestroyPipelineLayout(device, m_upLayout, nullptr);
+  if (m_resolveLayout) vkDestroyPipelineLayout(device, m_resolveLayout, nullptr);
+  if (m_pool) vkDestroyDescriptorPool(device, m_pool, nullptr);
+  if (m_downSetLayout) vkDestroyDescriptorSetLayout(device, m_downSetLayout, nullptr);
+  if (m_upSetLayout) vkDestroyDescriptorSetLayout(device, m_upSetLayout, nullptr);
+  if (m_resolveSetLayout) vkDestroyDescriptorSetLayout(device, m_resolveSetLayout, nullptr);
+  if (m_linear) vkDestroySampler(device, m_linear, nullptr);
+  if (m_nearest) vkDestroySampler(device, m_nearest, nullptr);
+  m_queries = VK_NULL_HANDLE;
+  m_down = VK_NULL_HANDLE;
+  m_up = VK_NULL_HANDLE;
+  m_downLayout = VK_NULL_HANDLE;
+  m_upLayout = VK_NULL_HANDLE;
+  m_resolveLayout = VK_NULL_HANDLE;
+  m_pool = VK_NULL_HANDLE;
+  m_downSetLayout = VK_NULL_HANDLE;
+  m_upSetLayout = VK_NULL_HANDLE;
+  m_resolveSetLayout = VK_NULL_HANDLE;
+  m_linear = VK_NULL_HANDLE;
+  m_nearest = VK_NULL_HANDLE;
+  m_queried.clear();
+  m_gpu = nullptr;
+}
+
+void PostProcess::createOutputPipeline(VkFormat swapchainFormat) {
+  if (!m_gpu) return;
+  destroyOutputPipeline();
+
+  // Every pixel is overwritten: nothing to load.
+  VkAttachmentDescription color{};
+  color.format = swapchainFormat;
+  color.samples = VK_SAMPLE_COUNT_1_BIT;
+  color.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+  VkAttachmentReference colorRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+  VkSubpassDescription subpass{};
+  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.colorAttachmentCount = 1;
+  subpass.pColorAttachments = &colorRef;
+
+  // The image is acquired at COLOR_ATTACHMENT_OUTPUT (the submit's wait stage).
+  VkSubpassDependency dep{};
+  dep.srcSubpass = VK_SUBPASS_EXTERNAL;
+  dep.dstSubpass = 0;
+  dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+  VkRenderPassCreateInfo rpci{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+  rpci.attachmentCount = 1;
+  rpci.pAttachments = &color;
+  rpci.subpassCount = 1;
+  rpci.pSubpasses = &subpass;
+  rpci.dependencyCount = 1;
+  rpci.pDependencies = &dep;
+  vkcheck(vkCreateRenderPass(m_gpu->device, &rpci, nullptr, &m_outputPass), "vkCreateRenderPass(post)");
+
+  m_resolve.init(m_gpu->device, kResolveShaders, 2,
+                 [this](const VkSpecializationInfo& spec) { return buildResolvePipeline(spec); });
+  // Dynamic resolution switches to the sharpened variant in a heavy frame;
+  // that is no time for a pipeline compile.
+  m_resolve.warm(features() & ~kFeatureSharpen);
+  m_resolve.warm(features() | kFeatureSharpen);
+}
+
+void PostProcess::destroyOutputPipeline() {
+  m_resolve.clear();
+  if (m_outputPass) vkDestroyRenderPass(m_gpu->device, m_outputPass, nullptr);
+  m_outputPass = VK_NULL_HANDLE;
+}
+
+VkPipeline PostProcess::buildResolvePipeline(const VkSpecializationInfo& spec) {
+  VkDevice device = m_gpu->device;
+  VkShaderModule vert = createShaderModule(device, readSpv(shaders::kPostFullscreenVert.spvPath));
+  VkShaderModule frag = createShaderModule(device, readSpv(shaders::kPostResolveFrag.spvPath));
+
+  VkPipelineShaderStageCreateInfo stages[2]{};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = vert;
+  stages[0].pName = "main";
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = frag;
+  stages[1].pName = "main";
+  stages[1].pSpecializationInfo = &spec;
+
+  VkPipelineVertexInputStateCreateInfo vis{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+  VkPipelineInputAssemblyStateCreateInfo ias{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+  ias.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  VkPipelineViewportStateCreateInfo vps{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+  vps.viewportCount = 1;
+  vps.scissorCount = 1;
+
+  VkPipelineRasterizationStateCreateInfo rs{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+  rs.polygonMode = VK_POLYGON_MODE_FILL;
+  rs.lineWidth = 1.0f;
+  rs.cullMode = VK_CULL_MODE_NONE;
+
+  VkPipelineMultisampleStateCreateInfo ms{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineColorBlendAttachmentState cba{};
+  cba.colorWriteMask =
+    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+  VkPipelineColorBlendStateCreateInfo cbs{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+  cbs.attachmentCount = 1;
+  cbs.pAttachments = &cba;
+
+  VkDynamicState dynStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+  VkPipelineDynamicStateCreateInfo ds{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+  ds.dynamicStateCount = 2;
+  ds.pDynamicStates = dynStates;
+
+  VkGraphicsPipelineCreateInfo gpci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+  gpci.stageCount = 2;
+  gpci.pStages = stages;
+  gpci.pVertexInputState = &vis;
+  gpci.pInputAssemblyState = &ias;
+  gpci.pViewportState = &vps;
+  gpci.pRasterizationState = &rs;
+  gpci.pMultisampleState = &ms;
+  gpci.pColorBlendState = &cbs;
+  gpci.pDynamicState = &ds;
+  gpci.layout = m_resolveLayout;
+  gpci.renderPass = m_outputPass;
+  gpci.subpass = 0;
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  vkcheck(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gpci, nullptr, &pipeline),
+          "vkCreateGraphicsPipelines(post resolve)");
+
+  vkDestroyShaderModule(device, vert, nullptr);
+  vkDestroyShaderModule(device, frag, nullptr);
+  return pipeline;
+}
+
+void PostProcess::resize(VkImageView depthView, uint32_t width, uint32_t height) {
+  if (!m_gpu) return;
+  destroyTargets();
+  VkDevice device = m_gpu->device;
+
+  m_width = std::max(width, 1u);
+  m_height = std::max(height, 1u);
+  m_renderWidth = m_width;
+  m_renderHeight = m_height;
+  m_hdr = createImage(*m_gpu, m_width, m_height, kHdrFormat,
+                      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+  // Half resolution, but never so small that the last level would vanish.
+  const uint32_t minSize = 1u << (kBloomLevels - 1);
+  const uint32_t bw = std::max((m_width + 1) / 2, minSize), bh = std::max((m_height + 1) / 2, minSize);
+  m_bloom = createImage(*m_gpu, bw, bh, kHdrFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        VK_IMAGE_ASPECT_COLOR_BIT, kBloomLevels);
+  m_bloomFresh = true;
+  for (uint32_t i = 0; i < kBloomLevels; ++i) {
+    VkImageViewCreateInfo ivci{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    ivci.image = m_bloom.image;
+    ivci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    ivci.format = kHdrFormat;
+    ivci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    ivci.subresourceRange.baseMipLevel = i;
+    ivci.subresourceRange.levelCount = 1;
+    ivci.subresourceRange.layerCount = 1;
+    vkcheck(vkCreateImageView(device, &ivci, nullptr, &m_bloomLevels[i]), "vkCreateImageView(bloom level)");
+  }
+
+  VkDescriptorSetLayout layouts[kBloomLevels + 1];
+  layouts[0] = m_downSetLayout;
+  for (uint32_t i = 0; i < kBloomLevels - 1; ++i) layouts[1 + i] = m_upSetLayout;
+  layouts[kBloomLevels] = m_resolveSetLayout;
+  VkDescriptorSet sets[kBloomLevels + 1];
+  VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+  dsai.descriptorPool = m_pool;
+  dsai.descriptorSetCount = kBloomLevels + 1;
+  dsai.pSetLayouts = layouts;
+  vkcheck(vkAllocateDescriptorSets(device, &dsai, sets), "vkAllocateDescriptorSets(post)");
+  m_downSet = sets[0];
+  std::copy(sets + 1, sets + kBloomLevels, m_upSets);
+  m_resolveSet = sets[kBloomLevels];
+
+  const VkDescriptorType sampled = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  const VkDescriptorType storage = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  const VkDescriptorImageInfo hdr{ m_linear, m_hdr.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+  const VkDescriptorImageInfo bloom{ m_linear, m_bloom.view, VK_IMAGE_LAYOUT_GENERAL };
+
+  VkDescriptorImageInfo levels[kBloomLevels];
+  for (uint32_t i = 0; i < kBloomLevels; ++i) levels[i] = { VK_NULL_HANDLE, m_bloomLevels[i], VK_IMAGE_LAYOUT_GENERAL };
+  writeImages(device, m_downSet, 0, sampled, &hdr, 1);
+  writeImages(device, m_downSet, 1, storage, levels, kBloomLevels);
+
+  for (uint32_t i = 0; i < kBloomLevels - 1; ++i) {
+    writeImages(device, m_upSets[i], 0, sampled, &bloom, 1);
+    writeImages(device, m_upSets[i], 1, storage, &levels[i], 1);
+  }
+
+  const VkDescriptorImageInfo depth{ m_nearest, depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+  const VkDescriptorImageInfo lut{ m_linear, m_lut.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+  writeImages(device, m_resolveSet, 0, sampled, &hdr, 1);
+  writeImages(device, m_resolveSet, 1, sampled, &depth, 1);
+  writeImages(device, m_resolveSet, 2, sampled, &bloom, 1);
+  writeImages(device, m_resolveSet, 3, sampled, &lut, 1);
+}
+
+void PostProcess::setRenderSize(uint32_t width, uint32_t height) {
+  m_renderWidth = std::clamp(width, 1u, m_width);
+  m_renderHeight = std::clamp(height, 1u, m_height);
+}
+
+void PostProcess::setFog(float r, float g, float b, float density) {
+  m_fog[0] = r;
+  m_fog[1] = g;
+  m_fog[2] = b;
+  m_fog[3] = std::max(density, 0.0f);
+}
+
+void PostProcess::setBloom(float intensity, float threshold) {
+  m_bloomIntensity = std::max(intensity, 0.0f);
+  m_bloomThreshold = std::max(threshold, 0.0f);
+}
+
+void PostProcess::setExposure(float exposure) {
+  m_exposure = std::max(exposure, 0.0f);
+}
+
+void PostProcess::setSharpness(float sharpness) {
+  m_sharpness = std::clamp(sharpness, 0.0f, 1.0f);
+}
+
+void PostProcess::setColorGrade(const ColorGrade& grade) {
+  if (m_lutTexels.empty()) return;
+  bakeLut(grade, m_lutTexels.data());
+  m_lutDirty = true;
+  m_grading = grade.saturation != 1.0f || grade.contrast != 1.0f || grade.gain[0] != 1.0f || grade.gain[1] != 1.0f ||
+              grade.gain[2] != 1.0f;
+}
+
+uint32_t PostProcess::features() const {
+  uint32_t f = 0;
+  if (m_fog[3] > 0.0f) f |= kFeatureFog;
+  if (m_bloomIntensity > 0.0f && m_down && m_up) f |= kFeatureBloom;
+  if (m_grading) f |= kFeatureColorGrading;
+  if (m_sharpness > 0.0f && (m_renderWidth < m_width || m_renderHeight < m_height)) f |= kFeatureSharpen;
+  return f;
+}
+
+void PostProcess::update(uint32_t frameIndex, const Camera& camera) {
+  if (!m_gpu) return;
+  m_near = camera.zNear;
+  m_far = camera.zFar;
+
+  if (!m_queries || !m_queried[frameIndex]) return;
+  uint64_t ticks[2] = {};
+  VkResult r = vkGetQueryPoolResults(m_gpu->device, m_queries, frameIndex * 2, 2, sizeof(ticks), ticks,
+                                     sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+  if (r != VK_SUCCESS) return;
+  float ms = (float)((double)(ticks[1] - ticks[0]) * m_gpu->props.limits.timestampPeriod * 1e-6);
+  m_gpuMs = m_samples == 0 ? ms : m_gpuMs + (ms - m_gpuMs) * 0.05f;
+  ++m_samples;
+
+  // Once the average has settled.
+  if (!m_budgetWarned && m_samples >= 120 && m_gpuMs > kBudgetMs) {
+    core::logWarn(core::LogCategory::Render, "Post chain takes %.2f ms at %ux%u (budget %.1f ms)", m_gpuMs, m_width,
+                  m_height, kBudgetMs);
+    m_budgetWarned = true;
+  }
+}
+
+void PostProcess::record(VkCommandBuffer cmd, uint32_t frameIndex, VkFramebuffer framebuffer) {
+  if (!m_hdr.image || !m_outputPass) return;
+  const uint32_t f = features();
+  // uv over the output -> uv over the rendered part; clamped half a texel
+  // inside it, so filtering never reads what this frame did not render.
+  const float rendered[4] = { (float)m_renderWidth / (float)m_width, (float)m_renderHeight / (float)m_height,
+                            ((float)m_renderWidth - 0.5f) / (float)m_width,
+                            ((float)m_renderHeight - 0.5f) / (float)m_height };
+
+  // Everything before has finished when the first timestamp is taken, so
+  // the pair measures the chain alone.
+  if (m_queries) {
+    vkCmdResetQueryPool(cmd, m_queries, frameIndex * 2, 2);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queries, frameIndex * 2);
+  }
+
+  // A new grade goes up through this frame's staging slot, which the GPU
+  // is done with (the frame's fence was waited on).
+  if (m_lutDirty) {
+    const VkDeviceSize offset = (VkDeviceSize)kLutBytes * frameIndex;
+    std::memcpy(static_cast<uint8_t*>(m_lutStaging.mapped) + offset, m_lutTexels.data(), kLutBytes);
+    imageBarrier(cmd, m_lut.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                 m_lutFresh ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    VkBufferImageCopy region{};
+    region.bufferOffset = offset;
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { kLutSize, kLutSize, kLutSize };
+    vkCmdCopyBufferToImage(cmd, m_lutStaging.buffer, m_lut.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    imageBarrier(cmd, m_lut.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                 VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    m_lutDirty = false;
+    m_lutFresh = false;
+  }
+
+  if (f & kFeatureBloom) {
+    // Last frame's resolve sampled the chain we are about to overwrite.
+    imageBarrier(cmd, m_bloom.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                 m_bloomFresh ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    m_bloomFresh = false;
+
+    BloomDownPush down{ { 1.0f / (float)m_bloom.width, 1.0f / (float)m_bloom.height },
+                        m_bloomThreshold, std::max(m_bloomThreshold * 0.5f, 1e-3f),
+                        { rendered[0], rendered[1], rendered[2], rendered[3] } };
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_down);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_downLayout, 0, 1, &m_downSet, 0, nullptr);
+    vkCmdPushConstants(cmd, m_downLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(down), &down);
+    vkCmdDispatch(cmd, (m_bloom.width + kDownTile - 1) / kDownTile, (m_bloom.height + kDownTile - 1) / kDownTile, 1);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_up);
+    for (uint32_t level = kBloomLevels - 1; level-- > 0;) {
+      // Level + 1 is complete (downsampled, or already upsampled into).
+      imageBarrier(cmd, m_bloom.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+      const uint32_t w = std::max(m_bloom.width >> level, 1u), h = std::max(m_bloom.height >> level, 1u);
+      const uint32_t sw = std::max(w >> 1, 1u), sh = std::max(h >> 1, 1u);
+      BloomUpPush up{ { 1.0f / (float)sw, 1.0f / (float)sh }, (float)(level + 1), 1.0f };
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_upLayout, 0, 1, &m_upSets[level], 0, nullptr);
+      vkCmdPushConstants(cmd, m_upLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(up), &up);
+      vkCmdDispatch(cmd, (w + kUpGroupSize - 1) / kUpGroupSize, (h + kUpGroupSize - 1) / kUpGroupSize, 1);
+    }
+    imageBarrier(cmd, m_bloom.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+  }
+
+  VkRenderPassBeginInfo rpbi{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+  rpbi.renderPass = m_outputPass;
+  rpbi.framebuffer = framebuffer;
+  rpbi.renderArea.extent = { m_width, m_height };
+  vkCmdBeginRenderPass(cmd, &rpbi, VK_SUBPASS_CONTENTS_INLINE);
+  m_outputOpen = true;
+
+  VkViewport vp{ 0.0f, 0.0f, (float)m_width, (float)m_height, 0.0f, 1.0f };
+  VkRect2D sc{ { 0, 0 }, { m_width, m_height } };
+  vkCmdSetViewport(cmd, 0, 1, &vp);
+  vkCmdSetScissor(cmd, 0, 1, &sc);
+
+  VkPipeline pipeline = m_resolve.get(f);
+  if (!pipeline) return;
+  ResolvePush push{ { m_fog[0], m_fog[1], m_fog[2], m_fog[3] },
+                    { m_exposure, m_bloomIntensity, m_near, m_far },
+                    { rendered[0], rendered[1], rendered[2], rendered[3] },
+                    { 1.0f / (float)m_width, 1.0f / (float)m_height, m_sharpness, (float)kLutSize } };
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_resolveLayout, 0, 1, &m_resolveSet, 0, nullptr);
+  vkCmdPushConstants(cmd, m_resolveLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+  vkCmdDraw(cmd, 3, 1, 0, 0);
+}
+
+void PostProcess::endOutput(VkCommandBuffer cmd, uint32_t frameIndex) {
+  if (!m_outputOpen) return;
+  vkCmdEndRenderPass(cmd);
+  m_outputOpen = false;
+
+  if (m_queries) {
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queries, frameIndex * 2 + 1);
+    m_queried[frameIndex] = 1;
+  }
+}
+
+} // namespace render
@@ -0,0 +1,150 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ShaderPermutations.h"
+#include "VkUtil.h"
+
+namespace render {
+
+struct Camera;
+
+/// Everything between the lit scene and the swapchain.
+///
+/// The scene passes render into an R16G16B16A16F target (hdrView()) instead
+/// of the swapchain, to its top-left setRenderSize() part under dynamic
+/// resolution (the target keeps the swapchain's size, so a new scale
+/// reallocates nothing). record() then runs:
+///
+///   bloom down  one compute dispatch: bright-pass the HDR target into a
+///               half-resolution chain of kBloomLevels mips, every level
+///               reduced in the same dispatch (shaders/bloom_down.comp)
+///   bloom up    a tent-filtered upsample per level, coarsest first, adding
+///               each level into the next finer one
+///   resolve     one fullscreen pass into the swapchain image: upscale
+///               with contrast-adaptive sharpening, depth fog, bloom,
+///               exposure, filmic tonemap and color grading through a 3D
+///               LUT, all in the same fragment
+///
+/// Sharpening (only while upscaling), fog, bloom and grading are feature
+/// toggles (ShaderFeature) of the resolve pipeline, so a disabled effect
+/// costs nothing. With timestamp support the chain's GPU time is measured
+/// every frame (gpuMs()).
+class PostProcess {
+public:
+  static constexpr VkFormat kHdrFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+  static constexpr uint32_t kBloomLevels = 6; // BLOOM_LEVELS
+  static constexpr uint32_t kLutSize = 32;
+  static constexpr float kBudgetMs = 1.0f;
+
+  /// Applied on top of the tonemapped image; the default changes nothing.
+  struct ColorGrade {
+    float saturation = 1.0f;
+    float contrast = 1.0f; // around mid grey, perceptually
+    float gain[3] = { 1.0f, 1.0f, 1.0f };
+  };
+
+  /// False if the bloom shaders are missing (the resolve still runs,
+  /// without bloom). The resolve shaders are required.
+  bool init(const GpuContext& gpu, uint32_t framesInFlight);
+  void shutdown();
+
+  /// The resolve writes the swapchain; rebuild when its format changes.
+  void createOutputPipeline(VkFormat swapchainFormat);
+  void destroyOutputPipeline();
+  /// One color attachment (the swapchain image), left in PRESENT_SRC_KHR.
+  VkRenderPass outputPass() const { return m_outputPass; }
+
+  /// Recreates the HDR target and bloom chain for a new swapchain extent.
+  /// `depthView` is sampled for fog, in DEPTH_STENCIL_READ_ONLY_OPTIMAL.
+  /// Device idle only.
+  void resize(VkImageView depthView, uint32_t width, uint32_t height);
+  /// The scene's color attachment; it must end its last pass in
+  /// SHADER_READ_ONLY_OPTIMAL, visible to compute and fragment reads.
+  VkImageView hdrView() const { return m_hdr.view; }
+  /// Size the scene rendered at this frame, at most the swapchain's.
+  void setRenderSize(uint32_t width, uint32_t height);
+
+  /// Exponential fog towards (r, g, b): visibility halves every 1/density
+  /// units of view depth. density 0 = off.
+  void setFog(float r, float g, float b, float density);
+  /// Adds the bloom chain times `intensity`; texels brighter than
+  /// `threshold` feed it. intensity 0 = off.
+  void setBloom(float intensity, float threshold);
+  void setExposure(float exposure);
+  /// Sharpening of the upscale, 0..1. 0 = plain bilinear.
+  void setSharpness(float sharpness);
+  /// Bakes `grade` into the LUT; uploaded by the next record().
+  void setColorGrade(const ColorGrade& grade);
+
+  /// Call after the frame's fence wait: reads the timings the frame's last
+  /// use recorded and takes the camera's depth range for fog.
+  void update(uint32_t frameIndex, const Camera& camera);
+
+  /// Records the chain. Outside a render pass, after the scene passes;
+  /// `framebuffer` is the swapchain image's, on outputPass(). Returns
+  /// inside that pass, at native resolution: draw overlays (UI) there, then
+  /// endOutput().
+  void record(VkCommandBuffer cmd, uint32_t frameIndex, VkFramebuffer framebuffer);
+  void endOutput(VkCommandBuffer cmd, uint32_t frameIndex);
+
+  /// GPU time of the chain, averaged over recent frames; 0 without
+  /// timestamp support.
+  float gpuMs() const { return m_gpuMs; }
+
+private:
+  void destroyTargets();
+  VkPipeline buildResolvePipeline(const VkSpecializationInfo& spec);
+  uint32_t features() const;
+
+  const GpuContext* m_gpu = nullptr;
+  uint32_t m_width = 1, m_height = 1;
+  uint32_t m_renderWidth = 1, m_renderHeight = 1;
+  bool m_outputOpen = false; // record() began the output pass
+
+  GpuImage m_hdr;
+  GpuImage m_bloom; // half resolution, kBloomLevels mips, GENERAL
+  VkImageView m_bloomLevels[kBloomLevels] = {};
+  bool m_bloomFresh = false; // still UNDEFINED
+
+  GpuImage m_lut; // kLutSize^3, sRGB
+  GpuBuffer m_lutStaging; // one slot per frame in flight
+  std::vector<uint32_t> m_lutTexels;
+  bool m_lutDirty = false;
+  bool m_lutFresh = false; // still UNDEFINED
+  bool m_grading = false;
+
+  VkSampler m_linear = VK_NULL_HANDLE;
+  VkSampler m_nearest = VK_NULL_HANDLE;
+
+  VkDescriptorSetLayout m_downSetLayout = VK_NULL_HANDLE;
+  VkDescriptorSetLayout m_upSetLayout = VK_NULL_HANDLE;
+  VkDescriptorSetLayout m_resolveSetLayout = VK_NULL_HANDLE;
+  VkDescriptorPool m_pool = VK_NULL_HANDLE;
+  VkDescriptorSet m_downSet = VK_NULL_HANDLE;
+  VkDescriptorSet m_upSets[kBloomLevels - 1] = {}; // [i] writes level i
+  VkDescriptorSet m_resolveSet = VK_NULL_HANDLE;
+
+  VkPipelineLayout m_downLayout = VK_NULL_HANDLE;
+  VkPipelineLayout m_upLayout = VK_NULL_HANDLE;
+  VkPipelineLayout m_resolveLayout = VK_NULL_HANDLE;
+  VkPipeline m_down = VK_NULL_HANDLE;
+  VkPipeline m_up = VK_NULL_HANDLE;
+  VkRenderPass m_outputPass = VK_NULL_HANDLE;
+  PipelinePermutations m_resolve;
+
+  float m_fog[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  float m_bloomIntensity = 0.04f;
+  float m_bloomThreshold = 1.0f;
+  float m_exposure = 1.0f;
+  float m_sharpness = 0.5f;
+  float m_near = 0.1f, m_far = 200.0f;
+
+  VkQueryPool m_queries = VK_NULL_HANDLE; // 2 timestamps per frame in flight
+  std::vector<uint8_t> m_queried;         // frame's timestamps were written
+  float m_gpuMs = 0.0f;
+  uint32_t m_samples = 0;
+  bool m_budgetWarned = false;
+};
+
+} // namespace render
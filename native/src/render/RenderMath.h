@@ -0,0 +1,154 @@
+#pragma once
+#include <cmath>
+
+namespace render {
+
+struct Vec3 {
+  float x = 0, y = 0, z = 0;
+};
+
+inline Vec3 operator+(Vec3 a, Vec3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Vec3 operator-(Vec3 a, Vec3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Vec3 operator*(Vec3 a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+inline float dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3 cross(Vec3 a, Vec3 b) {
+  return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+inline float length(Vec3 a) { return std::sqrt(dot(a, a)); }
+inline Vec3 normalize(Vec3 a) {
+  float l = length(a);
+  return l > 0.0f ? a * (1.0f / l) : a;
+}
+
+/// Column-major 4x4, same memory layout as a GLSL mat4: m[col * 4 + row].
+struct Mat4 {
+  float m[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+
+  float& at(int row, int col) { return m[col * 4 + row]; }
+  float at(int row, int col) const { return m[col * 4 + row]; }
+};
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b) {
+  Mat4 r;
+  for (int c = 0; c < 4; ++c) {
+    for (int row = 0; row < 4; ++row) {
+      float s = 0.0f;
+      for (int k = 0; k < 4; ++k) s += a.at(row, k) * b.at(k, c);
+      r.at(row, c) = s;
+    }
+  }
+  return r;
+}
+
+inline Vec3 transformPoint(const Mat4& a, Vec3 p) {
+  return {
+    a.at(0, 0) * p.x + a.at(0, 1) * p.y + a.at(0, 2) * p.z + a.at(0, 3),
+    a.at(1, 0) * p.x + a.at(1, 1) * p.y + a.at(1, 2) * p.z + a.at(1, 3),
+    a.at(2, 0) * p.x + a.at(2, 1) * p.y + a.at(2, 2) * p.z + a.at(2, 3),
+  };
+}
+
+/// General 4x4 inverse (cofactor expansion); identity if singular.
+inline Mat4 inverse(const Mat4& a) {
+  const float* m = a.m;
+  float inv[16];
+  inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] +
+           m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+  inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] -
+           m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+  inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] +
+           m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+  inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] -
+            m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+  inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] -
+           m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+  inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] +
+           m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+  inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] -
+           m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+  inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] +
+            m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+  inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] +
+           m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+  inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] -
+           m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+  inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] +
+            m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+  inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] -
+            m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+  inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] -
+           m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+  inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] +
+           m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+  inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] -
+            m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+  inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] +
+            m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+  float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+  Mat4 r;
+  if (std::fabs(det) < 1e-20f) return r;
+  float invDet = 1.0f / det;
+  for (int i = 0; i < 16; ++i) r.m[i] = inv[i] * invDet;
+  return r;
+}
+
+/// Right-handed view space looking down -Z; Vulkan clip space (y down,
+/// depth 0..1).
+inline Mat4 perspective(float fovYRadians, float aspect, float zNear, float zFar) {
+  float f = 1.0f / std::tan(fovYRadians * 0.5f);
+  Mat4 r;
+  r.m[0] = f / aspect;
+  r.m[5] = -f;
+  r.m[10] = zFar / (zNear - zFar);
+  r.m[11] = -1.0f;
+  r.m[14] = (zNear * zFar) / (zNear - zFar);
+  r.m[15] = 0.0f;
+  return r;
+}
+
+inline Mat4 lookAt(Vec3 eye, Vec3 target, Vec3 up) {
+  Vec3 f = normalize(target - eye);
+  Vec3 s = normalize(cross(f, up));
+  Vec3 u = cross(s, f);
+  Mat4 r;
+  r.at(0, 0) = s.x;  r.at(0, 1) = s.y;  r.at(0, 2) = s.z;  r.at(0, 3) = -dot(s, eye);
+  r.at(1, 0) = u.x;  r.at(1, 1) = u.y;  r.at(1, 2) = u.z;  r.at(1, 3) = -dot(u, eye);
+  r.at(2, 0) = -f.x; r.at(2, 1) = -f.y; r.at(2, 2) = -f.z; r.at(2, 3) = dot(f, eye);
+  return r;
+}
+
+/// Six planes (xyz = inward normal, w = distance) of a Vulkan clip space
+/// (depth 0..1) view-projection, extracted Gribb/Hartmann style.
+struct Frustum {
+  float planes[6][4];
+
+  static Frustum fromViewProj(const Mat4& vp) {
+    Frustum f{};
+    auto row = [&](int r, int c) { return vp.at(r, c); };
+    for (int c = 0; c < 4; ++c) {
+      f.planes[0][c] = row(3, c) + row(0, c); // left
+      f.planes[1][c] = row(3, c) - row(0, c); // right
+      f.planes[2][c] = row(3, c) + row(1, c); // top/bottom (y flipped)
+      f.planes[3][c] = row(3, c) - row(1, c);
+      f.planes[4][c] = row(2, c);             // near (z >= 0)
+      f.planes[5][c] = row(3, c) - row(2, c); // far
+    }
+    for (auto& p : f.planes) {
+      float len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+      if (len > 0.0f) {
+        for (float& v : p) v /= len;
+      }
+    }
+    return f;
+  }
+
+  bool sphereVisible(Vec3 c, float radius) const {
+    for (const auto& p : planes) {
+      if (p[0] * c.x + p[1] * c.y + p[2] * c.z + p[3] < -radius) return false;
+    }
+    return true;
+  }
+};
+
+} // namespace render
@@ -0,0 +1,82 @@
+#include "ShaderPermutations.h"
+#include "../core/Log.h"
+
+namespace render {
+
+const char* const kShaderFeatureNames[kShaderFeatureCount] = {
+  "kClusteredLights",
+  "kDecals",
+  "kFog",
+  "kBloom",
+  "kColorGrading",
+  "kSharpen",
+  "kShadows",
+};
+
+void PipelinePermutations::init(VkDevice device, const ShaderReflection* const* shaders, uint32_t shaderCount,
+                                Builder builder) {
+  shutdown();
+  m_device = device;
+  m_builder = std::move(builder);
+
+  for (uint32_t f = 0; f < kShaderFeatureCount; ++f) {
+    for (uint32_t s = 0; s < shaderCount; ++s) {
+      uint32_t id = findSpecConstant(*shaders[s], kShaderFeatureNames[f]);
+      if (id == UINT32_MAX) continue;
+      if (m_mask & (1u << f)) {
+        if (id != m_ids[f]) {
+          core::logError(core::LogCategory::Render, "%s: %s has constant_id %u, expected %u", shaders[s]->spvPath,
+                         kShaderFeatureNames[f], id, m_ids[f]);
+        }
+        continue;
+      }
+      m_ids[f] = id;
+      m_mask |= 1u << f;
+    }
+  }
+}
+
+VkPipeline PipelinePermutations::get(uint32_t features) {
+  const uint32_t key = features & m_mask;
+  for (const auto& [k, pipeline] : m_variants) {
+    if (k == key) return pipeline;
+  }
+  if (!m_builder) return VK_NULL_HANDLE;
+
+  VkBool32 values[kShaderFeatureCount]{};
+  VkSpecializationMapEntry entries[kShaderFeatureCount]{};
+  uint32_t entryCount = 0;
+  for (uint32_t f = 0; f < kShaderFeatureCount; ++f) {
+    if (!(m_mask & (1u << f))) continue;
+    values[f] = (key & (1u << f)) ? VK_TRUE : VK_FALSE;
+    entries[entryCount++] = { m_ids[f], f * (uint32_t)sizeof(VkBool32), sizeof(VkBool32) };
+  }
+  VkSpecializationInfo spec{};
+  spec.mapEntryCount = entryCount;
+  spec.pMapEntries = entries;
+  spec.dataSize = sizeof(values);
+  spec.pData = values;
+
+  // Failures are remembered too, so a missing shader is not retried per draw.
+  VkPipeline pipeline = m_builder(spec);
+  m_variants.emplace_back(key, pipeline);
+  core::logInfo(core::LogCategory::Render, "Pipeline variant 0x%x created (%u for this set)", key,
+                (uint32_t)m_variants.size());
+  return pipeline;
+}
+
+void PipelinePermutations::clear() {
+  for (const auto& [k, pipeline] : m_variants) {
+    if (pipeline) vkDestroyPipeline(m_device, pipeline, nullptr);
+  }
+  m_variants.clear();
+}
+
+void PipelinePermutations::shutdown() {
+  clear();
+  m_builder = nullptr;
+  m_mask = 0;
+  m_device = VK_NULL_HANDLE;
+}
+
+} // namespace render
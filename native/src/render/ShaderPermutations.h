@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "ShaderReflection.h"
+
+namespace render {
+
+/// Feature toggles shaders declare as bool specialization constants (see
+/// shaders/features.glsl, which names them kShaderFeatureNames[bit]).
+enum ShaderFeature : uint32_t {
+  kFeatureClusteredLights = 1u << 0,
+  kFeatureDecals = 1u << 1,
+  kFeatureFog = 1u << 2,
+  kFeatureBloom = 1u << 3,
+  kFeatureColorGrading = 1u << 4,
+  kFeatureSharpen = 1u << 5,
+  kFeatureShadows = 1u << 6,
+};
+constexpr uint32_t kShaderFeatureCount = 7;
+extern const char* const kShaderFeatureNames[kShaderFeatureCount];
+
+/// Pipeline variants of one set of shaders, one per combination of feature
+/// toggles, instead of uniform flags tested per fragment. Each variant is
+/// created with the toggles as specialization constants, so the driver
+/// folds the branches of disabled features away.
+///
+/// Features none of the shaders declare are dropped from the key: setting
+/// kFeatureFog on a set without fog returns the same pipeline and never
+/// creates another. Variants are created on first use through the builder;
+/// that is a pipeline compile, so warm() the expected ones at load.
+class PipelinePermutations {
+public:
+  /// Creates the pipeline with `spec` on every stage (ids a stage does not
+  /// declare are ignored by Vulkan). VK_NULL_HANDLE if it can't.
+  using Builder = std::function<VkPipeline(const VkSpecializationInfo& spec)>;
+
+  void init(VkDevice device, const ShaderReflection* const* shaders, uint32_t shaderCount, Builder builder);
+
+  /// Variant for `features` (ShaderFeature bits).
+  VkPipeline get(uint32_t features);
+  void warm(uint32_t features) { get(features); }
+
+  /// Destroys every variant; get() creates them again.
+  void clear();
+  /// clear() and forget the builder.
+  void shutdown();
+
+  /// Features the shaders declare.
+  uint32_t mask() const { return m_mask; }
+  uint32_t variantCount() const { return (uint32_t)m_variants.size(); }
+
+private:
+  VkDevice m_device = VK_NULL_HANDLE;
+  Builder m_builder;
+  uint32_t m_ids[kShaderFeatureCount] = {};
+  uint32_t m_mask = 0;
+  std::vector<std::pair<uint32_t, VkPipeline>> m_variants; // key, pipeline; a handful at most
+};
+
+} // namespace render
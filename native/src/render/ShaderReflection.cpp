@@ -0,0 +1,91 @@
+#include "ShaderReflection.h"
+#include "VkUtil.h"
+#include "../core/Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace render {
+
+namespace {
+
+// Bindings of `set` across `shaders`, merged, sorted by binding.
+std::vector<VkDescriptorSetLayoutBinding> mergeBindings(uint32_t set, const ShaderReflection* const* shaders,
+                                                        uint32_t shaderCount, const char* what) {
+  std::vector<VkDescriptorSetLayoutBinding> out;
+  for (uint32_t s = 0; s < shaderCount; ++s) {
+    const ShaderReflection& sh = *shaders[s];
+    for (uint32_t i = 0; i < sh.bindingCount; ++i) {
+      const ReflectedBinding& rb = sh.bindings[i];
+      if (rb.set != set) continue;
+
+      auto it = std::find_if(out.begin(), out.end(),
+                             [&](const VkDescriptorSetLayoutBinding& b) { return b.binding == rb.binding; });
+      if (it == out.end()) {
+        VkDescriptorSetLayoutBinding b{};
+        b.binding = rb.binding;
+        b.descriptorType = rb.type;
+        b.descriptorCount = rb.count;
+        b.stageFlags = sh.stage;
+        out.push_back(b);
+        continue;
+      }
+      if (it->descriptorType != rb.type || it->descriptorCount != rb.count) {
+        core::logError(core::LogCategory::Render, "%s: set %u binding %u declared differently in %s", what, set,
+                       rb.binding, sh.spvPath);
+        continue;
+      }
+      it->stageFlags |= sh.stage;
+    }
+  }
+  std::sort(out.begin(), out.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+    return a.binding < b.binding;
+  });
+  return out;
+}
+
+} // namespace
+
+VkDescriptorSetLayout createSetLayout(VkDevice device, uint32_t set, const ShaderReflection* const* shaders,
+                                      uint32_t shaderCount, const char* what) {
+  std::vector<VkDescriptorSetLayoutBinding> bindings = mergeBindings(set, shaders, shaderCount, what);
+
+  VkDescriptorSetLayoutCreateInfo dslci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+  dslci.bindingCount = (uint32_t)bindings.size();
+  dslci.pBindings = bindings.data();
+  VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+  vkcheck(vkCreateDescriptorSetLayout(device, &dslci, nullptr, &layout), what);
+  return layout;
+}
+
+void addPoolSizes(std::vector<VkDescriptorPoolSize>& sizes, uint32_t set, const ShaderReflection* const* shaders,
+                  uint32_t shaderCount, uint32_t copies) {
+  for (const VkDescriptorSetLayoutBinding& b : mergeBindings(set, shaders, shaderCount, "pool sizes")) {
+    auto it = std::find_if(sizes.begin(), sizes.end(),
+                           [&](const VkDescriptorPoolSize& s) { return s.type == b.descriptorType; });
+    if (it == sizes.end()) {
+      sizes.push_back(VkDescriptorPoolSize{ b.descriptorType, 0 });
+      it = sizes.end() - 1;
+    }
+    it->descriptorCount += b.descriptorCount * copies;
+  }
+}
+
+VkPushConstantRange pushConstantRange(const ShaderReflection* const* shaders, uint32_t shaderCount) {
+  VkPushConstantRange range{};
+  for (uint32_t s = 0; s < shaderCount; ++s) {
+    if (shaders[s]->pushConstantSize == 0) continue;
+    range.stageFlags |= shaders[s]->stage;
+    range.size = std::max(range.size, shaders[s]->pushConstantSize);
+  }
+  return range;
+}
+
+uint32_t findSpecConstant(const ShaderReflection& shader, const char* name) {
+  for (uint32_t i = 0; i < shader.specConstantCount; ++i) {
+    if (std::strcmp(shader.specConstants[i].name, name) == 0) return shader.specConstants[i].id;
+  }
+  return UINT32_MAX;
+}
+
+} // namespace render
@@ -0,0 +1,55 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace render {
+
+/// Resource interface of one SPIR-V module, generated at build time by
+/// tools/shaders/ShaderReflect into generated/shaders/<file>.h as
+/// shaders::k<Name> (world.frag -> shaders::kWorldFrag). Layouts built from
+/// these always match what the shaders declare, so adding a binding to a
+/// shader no longer means editing a hand-written layout to match.
+struct ReflectedBinding {
+  uint32_t set;
+  uint32_t binding;
+  VkDescriptorType type;
+  uint32_t count; // array size, 0 = runtime sized
+};
+
+struct ReflectedSpecConstant {
+  uint32_t id;
+  const char* name;
+};
+
+struct ShaderReflection {
+  const char* spvPath; // as the engine loads it, "shaders/world.frag.spv"
+  VkShaderStageFlagBits stage;
+  const ReflectedBinding* bindings; // sorted by set, binding
+  uint32_t bindingCount;
+  uint32_t pushConstantSize; // 0 = no push constants
+  const ReflectedSpecConstant* specConstants; // sorted by id
+  uint32_t specConstantCount;
+};
+
+/// Layout of descriptor set `set` over every shader of a pipeline (or of
+/// several pipelines sharing the set): the union of their bindings with the
+/// stage flags of the shaders that use each. Bindings declared with
+/// different types or counts are an error; the first wins.
+VkDescriptorSetLayout createSetLayout(VkDevice device, uint32_t set, const ShaderReflection* const* shaders,
+                                      uint32_t shaderCount, const char* what);
+
+/// Adds what `copies` allocations of set `set` need to `sizes`, one entry
+/// per descriptor type.
+void addPoolSizes(std::vector<VkDescriptorPoolSize>& sizes, uint32_t set, const ShaderReflection* const* shaders,
+                  uint32_t shaderCount, uint32_t copies);
+
+/// One range at offset 0 over the stages that declare push constants, as
+/// large as the largest block; size 0 if none does.
+VkPushConstantRange pushConstantRange(const ShaderReflection* const* shaders, uint32_t shaderCount);
+
+/// Specialization constant id named `name`, UINT32_MAX if `shader` has none.
+uint32_t findSpecConstant(const ShaderReflection& shader, const char* name);
+
+} // namespace render
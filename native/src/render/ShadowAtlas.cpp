@@ -0,0 +1,676 @@
+#include "ShadowAtlas.h"
+#include "Camera.h"
+#include "StaticWorld.h"
+#include "../core/Log.h"
+
+#include "shaders/shadow_caster.vert.h"
+#include "shaders/shadow_depth.vert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace render {
+
+static const ShaderReflection* const kShadowShaders[] = { &shaders::kShadowDepthVert, &shaders::kShadowCasterVert };
+
+// A spot wider than this (half angle) is rendered as a cube; one frustum
+// would waste most of its tile on the cone's rim.
+static const float kMaxSpotCos = 0.1736f; // cos(80 degrees)
+
+struct CasterInstance {
+  float center[4];
+  float extent[4];
+};
+static_assert(sizeof(CasterInstance) == 32, "CasterInstance is a vertex buffer layout");
+
+// Depth only, so every use (attachment, copy, sampled view) covers the whole
+// texel. D16 is always there and is enough for a light's range.
+static VkFormat shadowFormat(VkPhysicalDevice physical) {
+  const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM };
+  const VkFormatFeatureFlags need = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                                    VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT |
+                                    VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+  for (VkFormat f : candidates) {
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties(physical, f, &props);
+    if ((props.optimalTilingFeatures & need) == need) return f;
+  }
+  return VK_FORMAT_D16_UNORM;
+}
+
+static Vec3 lightPosition(const Light& l) { return { l.position[0], l.position[1], l.position[2] }; }
+
+static bool isCube(const Light& l) { return l.type == LightType::Point || l.cosOuter < kMaxSpotCos; }
+
+// Everything the rendered depth depends on.
+static bool sameShape(const Light& a, const Light& b) {
+  if (a.type != b.type || a.radius != b.radius || std::memcmp(a.position, b.position, sizeof(a.position)) != 0)
+    return false;
+  if (a.type == LightType::Point) return true;
+  return a.cosOuter == b.cosOuter && std::memcmp(a.direction, b.direction, sizeof(a.direction)) == 0;
+}
+
+static bool boxTouchesSphere(const Vec3& center, const Vec3& half, const Vec3& sphere, float radius) {
+  const float c[3] = { center.x, center.y, center.z }, h[3] = { half.x, half.y, half.z };
+  const float s[3] = { sphere.x, sphere.y, sphere.z };
+  float d2 = 0.0f;
+  for (int a = 0; a < 3; ++a) {
+    float d = std::fabs(s[a] - c[a]) - h[a];
+    if (d > 0.0f) d2 += d * d;
+  }
+  return d2 <= radius * radius;
+}
+
+// World -> clip of one face: light space (dot(x, v), dot(y, v), dot(z, v))
+// with v = p - origin, depth n..f mapped to 0..1 like perspective().
+static Mat4 faceClip(Vec3 x, Vec3 y, Vec3 z, Vec3 origin, float zNear, float zFar) {
+  const float a = zFar / (zFar - zNear), b = zFar * zNear / (zFar - zNear);
+  const Vec3 rows[4] = { x, y, z * a, z };
+  const float w[4] = { -dot(x, origin), -dot(y, origin), -a * dot(z, origin) - b, -dot(z, origin) };
+  Mat4 m;
+  for (int r = 0; r < 4; ++r) {
+    m.at(r, 0) = rows[r].x;
+    m.at(r, 1) = rows[r].y;
+    m.at(r, 2) = rows[r].z;
+    m.at(r, 3) = w[r];
+  }
+  return m;
+}
+
+bool ShadowAtlas::init(const GpuContext& gpu, uint32_t framesInFlight, const StaticWorld& world) {
+  m_gpu = &gpu;
+  m_world = &world;
+  VkDevice device = gpu.device;
+
+  m_format = shadowFormat(gpu.physical);
+  const VkImageUsageFlags attachment = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  m_atlas = createImage(gpu, kAtlasSize, kAtlasSize, m_format,
+                        attachment | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                        VK_IMAGE_ASPECT_DEPTH_BIT);
+  m_cache = createImage(gpu, kAtlasSize, kAtlasSize, m_format, attachment | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                        VK_IMAGE_ASPECT_DEPTH_BIT);
+  m_fresh = true;
+  m_allocator.init(kAtlasSize, kAtlasSize);
+
+  VkFormatProperties props{};
+  vkGetPhysicalDeviceFormatProperties(gpu.physical, m_format, &props);
+  const bool linear = (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+  VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+  sci.magFilter = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST; // 2x2 PCF in hardware
+  sci.minFilter = sci.magFilter;
+  sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sci.compareEnable = VK_TRUE;
+  sci.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+  vkcheck(vkCreateSampler(device, &sci, nullptr, &m_sampler), "vkCreateSampler(shadows)");
+
+  m_frames.resize(framesInFlight);
+  for (Frame& f : m_frames) {
+    const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    f.shadows = createBuffer(gpu, sizeof(GpuShadow) * kMaxShadows, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, host);
+    f.casters = createBuffer(gpu, sizeof(CasterInstance) * kMaxCasterDraws, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, host);
+  }
+
+  m_clearPass = createPass(VK_ATTACHMENT_LOAD_OP_CLEAR);
+  m_loadPass = createPass(VK_ATTACHMENT_LOAD_OP_LOAD);
+  VkFramebufferCreateInfo fci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+  fci.renderPass = m_clearPass; // both passes are compatible
+  fci.attachmentCount = 1;
+  fci.width = kAtlasSize;
+  fci.height = kAtlasSize;
+  fci.layers = 1;
+  fci.pAttachments = &m_cache.view;
+  vkcheck(vkCreateFramebuffer(device, &fci, nullptr, &m_cacheFramebuffer), "vkCreateFramebuffer(shadow cache)");
+  fci.pAttachments = &m_atlas.view;
+  vkcheck(vkCreateFramebuffer(device, &fci, nullptr, &m_atlasFramebuffer), "vkCreateFramebuffer(shadow atlas)");
+
+  VkPushConstantRange pcr = pushConstantRange(kShadowShaders, 2);
+  VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+  plci.pushConstantRangeCount = 1;
+  plci.pPushConstantRanges = &pcr;
+  vkcheck(vkCreatePipelineLayout(device, &plci, nullptr, &m_layout), "vkCreatePipelineLayout(shadows)");
+
+  // Position only: the first attribute of both world vertex formats.
+  const uint32_t strides[kWorldFormatCount] = { sizeof(WorldVertex), sizeof(WorldVertexColored) };
+  for (uint32_t format = 0; format < kWorldFormatCount; ++format) {
+    VkVertexInputBindingDescription vib{ 0, strides[format], VK_VERTEX_INPUT_RATE_VERTEX };
+    VkVertexInputAttributeDescription attr{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(WorldVertex, position) };
+    VkPipelineVertexInputStateCreateInfo vis{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    vis.vertexBindingDescriptionCount = 1;
+    vis.pVertexBindingDescriptions = &vib;
+    vis.vertexAttributeDescriptionCount = 1;
+    vis.pVertexAttributeDescriptions = &attr;
+    m_worldPipelines[format] = buildPipeline(shaders::kShadowDepthVert.spvPath, vis);
+  }
+
+  VkVertexInputBindingDescription vib{ 0, sizeof(CasterInstance), VK_VERTEX_INPUT_RATE_INSTANCE };
+  VkVertexInputAttributeDescription attrs[2] = {
+    { 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(CasterInstance, center) },
+    { 1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(CasterInstance, extent) },
+  };
+  VkPipelineVertexInputStateCreateInfo vis{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+  vis.vertexBindingDescriptionCount = 1;
+  vis.pVertexBindingDescriptions = &vib;
+  vis.vertexAttributeDescriptionCount = 2;
+  vis.pVertexAttributeDescriptions = attrs;
+  VkPipeline caster = buildPipeline(shaders::kShadowCasterVert.spvPath, vis);
+
+  if (!m_worldPipelines[0] || !caster) {
+    core::logError(core::LogCategory::Render, "Shadows disabled: %s missing",
+                   caster ? shaders::kShadowDepthVert.spvPath : shaders::kShadowCasterVert.spvPath);
+    if (caster) vkDestroyPipeline(device, caster, nullptr);
+    return false;
+  }
+  m_casterPipeline = caster;
+  core::logInfo(core::LogCategory::Render, "Shadows: %u^2 %s atlas + static cache, %u..%u texel tiles, %s filtering",
+                kAtlasSize, m_format == VK_FORMAT_D32_SFLOAT ? "D32" : "D16", kMinTile, kMaxTile,
+                linear ? "linear" : "nearest");
+  return true;
+}
+
+void ShadowAtlas::shutdown() {
+  if (!m_gpu) return;
+  VkDevice device = m_gpu->device;
+
+  for (Frame& f : m_frames) {
+    destroyBuffer(*m_gpu, f.shadows);
+    destroyBuffer(*m_gpu, f.casters);
+  }
+  m_frames.clear();
+  for (VkPipeline& p : m_worldPipelines) {
+    if (p) vkDestroyPipeline(device, p, nullptr);
+    p = VK_NULL_HANDLE;
+  }
+  if (m_casterPipeline) vkDestroyPipeline(device, m_casterPipeline, nullptr);
+  if (m_layout) vkDestroyPipelineLayout(device, m_layout, nullptr);
+  if (m_cacheFramebuffer) vkDestroyFramebuffer(device, m_cacheFramebuffer, nullptr);
+  if (m_atlasFramebuffer) vkDestroyFramebuffer(device, m_atlasFramebuffer, nullptr);
+  if (m_clearPass) vkDestroyRenderPass(device, m_clearPass, nullptr);
+  if (m_loadPass) vkDestroyRenderPass(device, m_loadPass, nullptr);
+  if (m_sampler) vkDestroySampler(device, m_sampler, nullptr);
+  m_casterPipeline = VK_NULL_HANDLE;
+  m_layout = VK_NULL_HANDLE;
+  m_cacheFramebuffer = VK_NULL_HANDLE;
+  m_atlasFramebuffer = VK_NULL_HANDLE;
+  m_clearPass = VK_NULL_HANDLE;
+  m_loadPass = VK_NULL_HANDLE;
+  m_sampler = VK_NULL_HANDLE;
+  destroyImage(*m_gpu, m_atlas);
+  destroyImage(*m_gpu, m_cache);
+
+  m_slots.clear();
+  m_lightSlots.clear();
+  m_casters.clear();
+  m_freeCasters.clear();
+  m_casterCount = 0;
+  m_jobs.clear();
+  m_world = nullptr;
+  m_gpu = nullptr;
+}
+
+VkRenderPass ShadowAtlas::createPass(VkAttachmentLoadOp load) {
+  // Layout transitions are explicit barriers in record(): the cache and the
+  // atlas rest in transfer / read-only layouts between passes.
+  VkAttachmentDescription depth{};
+  depth.format = m_format;
+  depth.samples = VK_SAMPLE_COUNT_1_BIT;
+  depth.loadOp = load;
+  depth.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  depth.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  depth.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depth.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  depth.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  VkAttachmentReference depthRef{ 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+  VkSubpassDescription subpass{};
+  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.pDepthStencilAttachment = &depthRef;
+
+  VkRenderPassCreateInfo rpci{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+  rpci.attachmentCount = 1;
+  rpci.pAttachments = &depth;
+  rpci.subpassCount = 1;
+  rpci.pSubpasses = &subpass;
+  VkRenderPass pass = VK_NULL_HANDLE;
+  vkcheck(vkCreateRenderPass(m_gpu->device, &rpci, nullptr, &pass), "vkCreateRenderPass(shadows)");
+  return pass;
+}
+
+VkPipeline ShadowAtlas::buildPipeline(const char* vertSpv, const VkPipelineVertexInputStateCreateInfo& input) {
+  std::vector<uint32_t> code = readSpv(vertSpv, false);
+  if (code.empty()) return VK_NULL_HANDLE;
+  VkDevice device = m_gpu->device;
+  VkShaderModule vert = createShaderModule(device, code);
+
+  VkPipelineShaderStageCreateInfo stage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+  stage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stage.module = vert;
+  stage.pName = "main";
+
+  VkPipelineInputAssemblyStateCreateInfo ias{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+  ias.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  VkPipelineViewportStateCreateInfo vps{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+  vps.viewportCount = 1;
+  vps.scissorCount = 1;
+
+  // Both faces: single-sided walls still cast, and the cube faces' winding
+  // differs. Slope-scaled bias against acne on surfaces facing away.
+  VkPipelineRasterizationStateCreateInfo rs{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+  rs.polygonMode = VK_POLYGON_MODE_FILL;
+  rs.lineWidth = 1.0f;
+  rs.cullMode = VK_CULL_MODE_NONE;
+  rs.depthBiasEnable = VK_TRUE;
+  rs.depthBiasConstantFactor = 1.25f;
+  rs.depthBiasSlopeFactor = 1.75f;
+
+  VkPipelineMultisampleStateCreateInfo ms{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineDepthStencilStateCreateInfo dss{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+  dss.depthTestEnable = VK_TRUE;
+  dss.depthWriteEnable = VK_TRUE;
+  dss.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+  VkPipelineColorBlendStateCreateInfo cbs{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+
+  VkDynamicState dynStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+  VkPipelineDynamicStateCreateInfo ds{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+  ds.dynamicStateCount = 2;
+  ds.pDynamicStates = dynStates;
+
+  VkGraphicsPipelineCreateInfo gpci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+  gpci.stageCount = 1;
+  gpci.pStages = &stage;
+  gpci.pVertexInputState = &input;
+  gpci.pInputAssemblyState = &ias;
+  gpci.pViewportState = &vps;
+  gpci.pRasterizationState = &rs;
+  gpci.pMultisampleState = &ms;
+  gpci.pDepthStencilState = &dss;
+  gpci.pColorBlendState = &cbs;
+  gpci.pDynamicState = &ds;
+  gpci.layout = m_layout;
+  gpci.renderPass = m_clearPass;
+  gpci.subpass = 0;
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  vkcheck(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gpci, nullptr, &pipeline),
+          "vkCreateGraphicsPipelines(shadows)");
+
+  vkDestroyShaderModule(device, vert, nullptr);
+  return pipeline;
+}
+
+uint32_t ShadowAtlas::addCaster(const Vec3& center, const Vec3& halfExtent) {
+  uint32_t id = kInvalid;
+  if (!m_freeCasters.empty()) {
+    id = m_freeCasters.back();
+    m_freeCasters.pop_back();
+  } else if (m_casters.size() < kMaxCasters) {
+    id = (uint32_t)m_casters.size();
+    m_casters.emplace_back();
+  } else {
+    return kInvalid;
+  }
+  Caster& c = m_casters[id];
+  c.center = center;
+  c.halfExtent = { std::fabs(halfExtent.x), std::fabs(halfExtent.y), std::fabs(halfExtent.z) };
+  c.alive = true;
+  m_casterCount++;
+  markDirty(c.center, c.halfExtent);
+  return id;
+}
+
+void ShadowAtlas::moveCaster(uint32_t id, const Vec3& center) {
+  if (id >= m_casters.size() || !m_casters[id].alive) return;
+  Caster& c = m_casters[id];
+  if (c.center.x == center.x && c.center.y == center.y && c.center.z == center.z) return;
+  // Where it was and where it is: a light it left needs the hole filled.
+  markDirty(c.center, c.halfExtent);
+  c.center = center;
+  markDirty(c.center, c.halfExtent);
+}
+
+void ShadowAtlas::removeCaster(uint32_t id) {
+  if (id >= m_casters.size() || !m_casters[id].alive) return;
+  Caster& c = m_casters[id];
+  markDirty(c.center, c.halfExtent);
+  c.alive = false;
+  m_freeCasters.push_back(id);
+  m_casterCount--;
+}
+
+void ShadowAtlas::markDirty(const Vec3& center, const Vec3& halfExtent) {
+  for (Slot& s : m_slots) {
+    if (s.light == kInvalid || s.dirty) continue;
+    if (boxTouchesSphere(center, halfExtent, lightPosition(s.key), s.key.radius)) s.dirty = true;
+  }
+}
+
+void ShadowAtlas::freeSlot(uint32_t slotIndex) {
+  Slot& s = m_slots[slotIndex];
+  if (s.tile) m_allocator.free(s.rect);
+  if (s.light < m_lightSlots.size()) m_lightSlots[s.light] = kInvalid;
+  s = Slot{};
+}
+
+bool ShadowAtlas::place(uint32_t slotIndex, uint32_t tile, uint32_t faces) {
+  const uint32_t w = faces == 6 ? 3 * tile : tile, h = faces == 6 ? 2 * tile : tile;
+  AtlasRect rect;
+  while (!m_allocator.alloc(w, h, rect)) {
+    // Make room from the lights without a shadow this frame, least
+    // important first; the ones still to come this frame score lower.
+    uint32_t victim = kInvalid;
+    for (uint32_t i = 0; i < (uint32_t)m_slots.size(); ++i) {
+      const Slot& s = m_slots[i];
+      if (i == slotIndex || s.light == kInvalid || s.frame == m_frame) continue;
+      if (victim == kInvalid || s.score < m_slots[victim].score) victim = i;
+    }
+    if (victim == kInvalid) return false;
+    freeSlot(victim);
+  }
+  Slot& slot = m_slots[slotIndex];
+  if (slot.tile) m_allocator.free(slot.rect);
+  slot.rect = rect;
+  slot.tile = tile;
+  slot.faces = faces;
+  slot.cached = false;
+  return true;
+}
+
+void ShadowAtlas::setShape(Slot& slot) {
+  const Light& l = slot.key;
+  const Vec3 origin = lightPosition(l);
+  const float zNear = std::max(l.radius * 0.01f, 0.05f), zFar = std::max(l.radius, zNear * 2.0f);
+
+  float tanHalf = 1.0f; // cube faces are 90 degrees
+  if (slot.faces == 6) {
+    static const Vec3 kFaces[6][3] = {
+      { { 0, 0, 1 }, { 0, 1, 0 }, { 1, 0, 0 } },  { { 0, 0, 1 }, { 0, 1, 0 }, { -1, 0, 0 } },
+      { { 1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },  { { 1, 0, 0 }, { 0, 0, 1 }, { 0, -1, 0 } },
+      { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },  { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, -1 } },
+    };
+    for (uint32_t f = 0; f < 6; ++f)
+      slot.clip[f] = faceClip(kFaces[f][0], kFaces[f][1], kFaces[f][2], origin, zNear, zFar);
+    slot.shadow = GpuShadow{};
+  } else {
+    const Vec3 z = normalize(Vec3{ l.direction[0], l.direction[1], l.direction[2] });
+    const Vec3 up = std::fabs(z.y) > 0.99f ? Vec3{ 1, 0, 0 } : Vec3{ 0, 1, 0 };
+    const Vec3 x0 = normalize(cross(z, up));
+    const Vec3 y0 = cross(x0, z);
+    const float cosHalf = std::clamp(l.cosOuter, kMaxSpotCos, 0.9999f);
+    tanHalf = std::sqrt(1.0f - cosHalf * cosHalf) / cosHalf;
+    const Vec3 x = x0 * (1.0f / tanHalf), y = y0 * (1.0f / tanHalf);
+    slot.clip[0] = faceClip(x, y, z, origin, zNear, zFar);
+    slot.shadow = GpuShadow{ { x.x, x.y, x.z, 0 }, { y.x, y.y, y.z, 0 }, { z.x, z.y, z.z, 0 } };
+  }
+
+  GpuShadow& s = slot.shadow;
+  s.axisX[3] = origin.x;
+  s.axisY[3] = origin.y;
+  s.axisZ[3] = origin.z;
+  const float texel = 1.0f / (float)kAtlasSize;
+  s.rect[0] = (float)slot.rect.x * texel;
+  s.rect[1] = (float)slot.rect.y * texel;
+  s.rect[2] = (float)slot.tile * texel;
+  s.rect[3] = (float)slot.tile * texel;
+  s.depth[0] = zNear;
+  s.depth[1] = zFar;
+  s.depth[2] = 3.0f * tanHalf / (float)slot.tile; // 1.5 texels
+  s.depth[3] = (float)slot.faces;
+}
+
+void ShadowAtlas::update(uint32_t frameIndex, const Camera& camera, float aspect, LightList& lights) {
+  m_jobs.clear();
+  m_shadowCount = 0;
+  m_staticRenders = 0;
+  m_dynamicRenders = 0;
+  m_frame++;
+  for (uint32_t i = 0; i < lights.slotCount(); ++i) {
+    if (Light* l = lights.get(i)) l->shadow = kNoShadow;
+  }
+  if (!enabled()) return;
+
+  if (m_world->loadCount() != m_worldLoads) {
+    m_worldLoads = m_world->loadCount();
+    for (Slot& s : m_slots) s.cached = false;
+  }
+
+  // Lights gone or no longer shadowed give their tiles back.
+  m_lightSlots.resize(lights.slotCount(), kInvalid);
+  for (uint32_t i = 0; i < (uint32_t)m_slots.size(); ++i) {
+    Slot& s = m_slots[i];
+    if (s.light == kInvalid) continue;
+    const Light* l = lights.get(s.light);
+    if (!l || l->shadowImportance <= 0.0f) freeSlot(i);
+    else s.score = 0.0f;
+  }
+
+  // Importance times the light's size on screen: its bounding sphere over
+  // the half height of the view at its distance, 1 once the camera is inside.
+  m_candidates.clear();
+  const Frustum frustum = Frustum::fromViewProj(camera.projection(aspect) * camera.view());
+  const float tanHalfFov = std::tan(camera.fovY * 0.5f);
+  for (uint32_t i = 0; i < lights.slotCount(); ++i) {
+    const Light* l = lights.get(i);
+    if (!l || l->shadowImportance <= 0.0f) continue;
+    const Vec3 p = lightPosition(*l);
+    if (!frustum.sphereVisible(p, l->radius)) continue;
+    const float d = length(p - camera.position);
+    const float coverage = d <= l->radius ? 1.0f : std::min(1.0f, l->radius / (d * tanHalfFov));
+    m_candidates.push_back({ i, l->shadowImportance * coverage });
+  }
+  std::sort(m_candidates.begin(), m_candidates.end(),
+            [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+  if (m_candidates.size() > kMaxShadows) m_candidates.resize(kMaxShadows);
+
+  Frame& frame = m_frames[frameIndex];
+  GpuShadow* table = static_cast<GpuShadow*>(frame.shadows.mapped);
+  CasterInstance* instances = static_cast<CasterInstance*>(frame.casters.mapped);
+  uint32_t instanceCount = 0;
+
+  for (const Candidate& c : m_candidates) {
+    Light& light = *lights.get(c.light);
+    uint32_t slotIndex = m_lightSlots[c.light];
+    if (slotIndex == kInvalid) {
+      slotIndex = 0;
+      while (slotIndex < m_slots.size() && m_slots[slotIndex].light != kInvalid) slotIndex++;
+      if (slotIndex == m_slots.size()) m_slots.emplace_back();
+      m_slots[slotIndex].light = c.light;
+      m_lightSlots[c.light] = slotIndex;
+    }
+    m_slots[slotIndex].score = c.score;
+
+    // Tile size: the next power of two of the score's share, in steps a
+    // tile does not flip between every frame.
+    const uint32_t faces = isCube(light) ? 6 : 1;
+    const uint32_t maxTile = faces == 6 ? kMaxTile / 2 : kMaxTile;
+    uint32_t want = kMinTile;
+    while (want < maxTile && (float)want < c.score * (float)maxTile) want *= 2;
+
+    // A new tile starts uncached, so it waits for the static budget; until
+    // then the light keeps its old tile, if it has one.
+    const bool budget = m_staticRenders < kMaxStaticRenders;
+    {
+      Slot& slot = m_slots[slotIndex];
+      const bool fits = slot.tile && slot.faces == faces && (slot.tile == want || slot.tile == want * 2);
+      if (!fits && budget) {
+        // Smaller sizes only while they still beat the tile it has.
+        for (uint32_t t = want; t >= kMinTile; t /= 2) {
+          const Slot& s = m_slots[slotIndex];
+          if (t != want && s.tile && s.faces == faces && t <= s.tile) break;
+          if (place(slotIndex, t, faces)) break;
+        }
+      }
+    }
+    Slot& slot = m_slots[slotIndex];
+    if (!slot.tile) continue; // the atlas is full of more important lights
+
+    bool renderStatic = false;
+    if (!slot.cached || !sameShape(slot.key, light)) {
+      if (budget && isCube(light) == (slot.faces == 6)) {
+        slot.key = light;
+        setShape(slot);
+        slot.cached = true;
+        renderStatic = true;
+        m_staticRenders++;
+      } else if (!slot.cached) {
+        continue;
+      }
+    }
+
+    if (renderStatic || slot.dirty) {
+      Job job;
+      job.slot = slotIndex;
+      job.renderStatic = renderStatic;
+      job.firstCaster = instanceCount;
+      slot.dirty = false;
+      const Vec3 origin = lightPosition(slot.key);
+      for (const Caster& caster : m_casters) {
+        if (!caster.alive || !boxTouchesSphere(caster.center, caster.halfExtent, origin, slot.key.radius)) continue;
+        if (instanceCount == kMaxCasterDraws) {
+          if (!m_warnedCasters) {
+            core::logWarn(core::LogCategory::Render, "Shadows: over %u caster draws in a frame, deferring some",
+                          kMaxCasterDraws);
+            m_warnedCasters = true;
+          }
+          slot.dirty = true; // the rest next frame
+          break;
+        }
+        CasterInstance& inst = instances[instanceCount++];
+        inst = { { caster.center.x, caster.center.y, caster.center.z, 0.0f },
+                 { caster.halfExtent.x, caster.halfExtent.y, caster.halfExtent.z, 0.0f } };
+      }
+      job.casterCount = instanceCount - job.firstCaster;
+      m_jobs.push_back(job);
+      if (!renderStatic) m_dynamicRenders++;
+    }
+
+    slot.frame = m_frame;
+    table[m_shadowCount] = slot.shadow;
+    light.shadow = m_shadowCount++;
+  }
+}
+
+void ShadowAtlas::setFace(VkCommandBuffer cmd, const Slot& slot, uint32_t face) {
+  VkViewport vp{};
+  vp.x = (float)(slot.rect.x + (face % 3) * slot.tile);
+  vp.y = (float)(slot.rect.y + (face / 3) * slot.tile);
+  vp.width = (float)slot.tile;
+  vp.height = (float)slot.tile;
+  vp.minDepth = 0.0f;
+  vp.maxDepth = 1.0f;
+  VkRect2D sc{};
+  sc.offset = { (int32_t)vp.x, (int32_t)vp.y };
+  sc.extent = { slot.tile, slot.tile };
+  vkCmdSetViewport(cmd, 0, 1, &vp);
+  vkCmdSetScissor(cmd, 0, 1, &sc);
+  vkCmdPushConstants(cmd, m_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Mat4), slot.clip[face].m);
+}
+
+void ShadowAtlas::record(VkCommandBuffer cmd, uint32_t frameIndex) {
+  if (!m_gpu) return;
+  const VkImageAspectFlags depth = VK_IMAGE_ASPECT_DEPTH_BIT;
+  const VkPipelineStageFlags tests =
+    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  const VkAccessFlags depthAccess =
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  if (m_fresh) {
+    imageBarrier(cmd, m_cache.image, depth, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+    imageBarrier(cmd, m_atlas.image, depth, VK_IMAGE_LAYOUT_UNDEFINED,
+                 VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    m_fresh = false;
+  }
+  if (m_jobs.empty()) return;
+
+  VkRenderPassBeginInfo rpbi{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+  VkClearValue clear{};
+  clear.depthStencil = { 1.0f, 0 };
+
+  // Static depth into the cache, one pass per tile so the clear stays
+  // inside it.
+  const bool anyStatic =
+    std::any_of(m_jobs.begin(), m_jobs.end(), [](const Job& j) { return j.renderStatic; });
+  if (anyStatic) {
+    imageBarrier(cmd, m_cache.image, depth, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                 VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, tests,
+                 depthAccess);
+    rpbi.renderPass = m_clearPass;
+    rpbi.framebuffer = m_cacheFramebuffer;
+    rpbi.clearValueCount = 1;
+    rpbi.pClearValues = &clear;
+    for (const Job& job : m_jobs) {
+      if (!job.renderStatic) continue;
+      const Slot& slot = m_slots[job.slot];
+      rpbi.renderArea.offset = { slot.rect.x, slot.rect.y };
+      rpbi.renderArea.extent = { slot.rect.w, slot.rect.h };
+      const float sphere[4] = { slot.key.position[0], slot.key.position[1], slot.key.position[2], slot.key.radius };
+      vkCmdBeginRenderPass(cmd, &rpbi, VK_SUBPASS_CONTENTS_INLINE);
+      for (uint32_t f = 0; f < slot.faces; ++f) {
+        setFace(cmd, slot, f);
+        m_world->drawDepth(cmd, m_worldPipelines, sphere);
+      }
+      vkCmdEndRenderPass(cmd);
+    }
+    imageBarrier(cmd, m_cache.image, depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                 VK_ACCESS_TRANSFER_READ_BIT);
+  }
+
+  // Every refreshed tile restarts from its static depth. The barrier also
+  // waits for the previous frame's shading, which may still read the atlas.
+  imageBarrier(cmd, m_atlas.image, depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+  m_copies.clear();
+  for (const Job& job : m_jobs) {
+    const Slot& slot = m_slots[job.slot];
+    VkImageCopy copy{};
+    copy.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+    copy.dstSubresource = copy.srcSubresource;
+    copy.srcOffset = { slot.rect.x, slot.rect.y, 0 };
+    copy.dstOffset = copy.srcOffset;
+    copy.extent = { slot.rect.w, slot.rect.h, 1 };
+    m_copies.push_back(copy);
+  }
+  vkCmdCopyImage(cmd, m_cache.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_atlas.image,
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)m_copies.size(), m_copies.data());
+  imageBarrier(cmd, m_atlas.image, depth, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+               VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+               VK_ACCESS_TRANSFER_WRITE_BIT, tests, depthAccess);
+
+  // Dynamic casters over the copies.
+  rpbi.renderPass = m_loadPass;
+  rpbi.framebuffer = m_atlasFramebuffer;
+  rpbi.renderArea.offset = { 0, 0 };
+  rpbi.renderArea.extent = { kAtlasSize, kAtlasSize };
+  rpbi.clearValueCount = 0;
+  rpbi.pClearValues = nullptr;
+  vkCmdBeginRenderPass(cmd, &rpbi, VK_SUBPASS_CONTENTS_INLINE);
+  VkDeviceSize offset = 0;
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_casterPipeline);
+  vkCmdBindVertexBuffers(cmd, 0, 1, &m_frames[frameIndex].casters.buffer, &offset);
+  for (const Job& job : m_jobs) {
+    if (job.casterCount == 0) continue;
+    const Slot& slot = m_slots[job.slot];
+    for (uint32_t f = 0; f < slot.faces; ++f) {
+      setFace(cmd, slot, f);
+      vkCmdDraw(cmd, 36, job.casterCount, 0, job.firstCaster);
+    }
+  }
+  vkCmdEndRenderPass(cmd);
+
+  imageBarrier(cmd, m_atlas.image, depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+               VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+               VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+               VK_ACCESS_SHADER_READ_BIT);
+}
+
+} // namespace render
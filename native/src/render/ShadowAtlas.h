@@ -0,0 +1,183 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "AtlasAllocator.h"
+#include "Lights.h"
+#include "RenderMath.h"
+#include "VkUtil.h"
+
+namespace render {
+
+struct Camera;
+class StaticWorld;
+
+/// GPU layout (std430, 80 bytes); mirrored by `Shadow` in
+/// shaders/clustered_lighting.glsl.
+struct GpuShadow {
+  float axisX[4] = { 0, 0, 0, 0 }; // spot: light space x / tan(half cone); w = position.x
+  float axisY[4] = { 0, 0, 0, 0 }; // spot: light space y / tan(half cone); w = position.y
+  float axisZ[4] = { 0, 0, 0, 0 }; // spot: light direction; w = position.z
+  float rect[4] = { 0, 0, 0, 0 };  // atlas uv of face 0, uv size of a face
+  float depth[4] = { 0, 0, 0, 0 }; // near, far, normal offset per unit distance, faces
+};
+static_assert(sizeof(GpuShadow) == 80, "GpuShadow must match the shader struct");
+
+/// Cached shadow maps for the lights that ask for one
+/// (Light::shadowImportance > 0).
+///
+/// Every shadow map is a tile of one depth atlas packed by AtlasAllocator:
+/// a spot light takes a square, a point light (or a spot too wide for one
+/// frustum) a 3x2 block of cube faces. A second atlas with the same layout
+/// caches the static world's depth per light. It is rendered
+/// (StaticWorld::drawDepth) when the light gets its tile or changes -
+/// moves, turns, new radius or cone, world reloaded - for at most
+/// kMaxStaticRenders lights per frame; otherwise it is only copied.
+/// Dynamic casters, boxes registered with addCaster(), are drawn over the
+/// copy, and only for lights whose bounds a caster entered, left or moved
+/// in since the tile was written. A light nothing moved near keeps its
+/// tile as it is, so a quiet frame records no shadow work at all. A light
+/// that changed while the static budget is spent keeps showing its last
+/// tile (the table holds the position it was rendered from) until its
+/// turn comes.
+///
+/// update() ranks the lights by importance times their size on screen
+/// (bounding sphere over distance; 0 outside the view), gives the best
+/// kMaxShadows a tile sized by the same score, kMinTile..kMaxTile texels
+/// per face in powers of two, and writes every light's Light::shadow for
+/// ClusteredLighting. A tile only shrinks once it is two sizes too big.
+/// Lights that drop out keep their tile and cache until the space is
+/// needed, so looking back at them costs nothing.
+class ShadowAtlas {
+public:
+  static constexpr uint32_t kAtlasSize = 4096;
+  static constexpr uint32_t kMaxTile = 1024; // per face; cube faces get half
+  static constexpr uint32_t kMinTile = 64;
+  static constexpr uint32_t kMaxShadows = 64;
+  static constexpr uint32_t kMaxStaticRenders = 4; // per frame
+  static constexpr uint32_t kMaxCasters = 1024;
+  static constexpr uint32_t kMaxCasterDraws = 4096; // boxes per frame, all lights
+  static constexpr uint32_t kInvalid = UINT32_MAX;
+
+  /// False if the shadow shaders are missing: the atlas is still created
+  /// (so descriptors stay valid) but never rendered and no light gets a
+  /// shadow.
+  bool init(const GpuContext& gpu, uint32_t framesInFlight, const StaticWorld& world);
+  void shutdown();
+
+  /// An axis-aligned box that casts shadows (character, crate, debris);
+  /// kInvalid when kMaxCasters exist.
+  uint32_t addCaster(const Vec3& center, const Vec3& halfExtent);
+  void moveCaster(uint32_t id, const Vec3& center);
+  void removeCaster(uint32_t id);
+  uint32_t casterCount() const { return m_casterCount; }
+
+  /// Picks this frame's shadowed lights and their tiles, schedules the
+  /// renders and writes Light::shadow of every light. Call after the
+  /// frame's fence wait, before ClusteredLighting::update().
+  void update(uint32_t frameIndex, const Camera& camera, float aspect, LightList& lights);
+
+  /// Records what update() scheduled. Outside a render pass, before
+  /// anything samples the atlas; leaves it in
+  /// DEPTH_STENCIL_READ_ONLY_OPTIMAL, visible to fragment shaders.
+  void record(VkCommandBuffer cmd, uint32_t frameIndex);
+
+  bool enabled() const { return m_casterPipeline != VK_NULL_HANDLE; }
+  VkImageView view() const { return m_atlas.view; }
+  /// Depth compare (lit where the reference is <= the map), filtered when
+  /// the format allows.
+  VkSampler sampler() const { return m_sampler; }
+  /// The frame's GpuShadow table, indexed by Light::shadow.
+  const GpuBuffer& shadowBuffer(uint32_t frameIndex) const { return m_frames[frameIndex].shadows; }
+
+  /// Lights with a shadow in the last update().
+  uint32_t shadowCount() const { return m_shadowCount; }
+  /// Tiles the last update() re-rendered the static cache of / refreshed
+  /// from the cache for moved casters only; both 0 in a frame where
+  /// nothing moved.
+  uint32_t staticRenders() const { return m_staticRenders; }
+  uint32_t dynamicRenders() const { return m_dynamicRenders; }
+  float occupancy() const { return m_allocator.occupancy(); }
+
+private:
+  struct Slot {
+    uint32_t light = kInvalid; // LightList id; kInvalid = unused entry
+    AtlasRect rect;
+    uint32_t tile = 0;  // texels per face
+    uint32_t faces = 1; // 1 or 6
+    Light key;          // what the tile was rendered for
+    Mat4 clip[6];       // world -> clip per face
+    GpuShadow shadow;
+    float score = 0.0f;
+    uint32_t frame = 0;  // last update() that gave it a shadow
+    bool cached = false; // the cache holds the static depth for `key`
+    bool dirty = true;   // casters near it changed since the tile was written
+  };
+
+  struct Caster {
+    Vec3 center, halfExtent;
+    bool alive = false;
+  };
+
+  struct Job {
+    uint32_t slot = 0;
+    bool renderStatic = false;
+    uint32_t firstCaster = 0, casterCount = 0; // instances in the frame's caster buffer
+  };
+
+  struct Candidate {
+    uint32_t light;
+    float score;
+  };
+
+  struct Frame {
+    GpuBuffer shadows; // SSBO, host visible, kMaxShadows
+    GpuBuffer casters; // per-instance vertices, host visible, kMaxCasterDraws
+  };
+
+  VkPipeline buildPipeline(const char* vertSpv, const VkPipelineVertexInputStateCreateInfo& input);
+  VkRenderPass createPass(VkAttachmentLoadOp load);
+  void markDirty(const Vec3& center, const Vec3& halfExtent);
+  bool place(uint32_t slotIndex, uint32_t tile, uint32_t faces);
+  void freeSlot(uint32_t slotIndex);
+  void setShape(Slot& slot);
+  void setFace(VkCommandBuffer cmd, const Slot& slot, uint32_t face);
+
+  const GpuContext* m_gpu = nullptr;
+  const StaticWorld* m_world = nullptr;
+  std::vector<Frame> m_frames;
+  VkFormat m_format = VK_FORMAT_UNDEFINED;
+
+  GpuImage m_atlas; // sampled; DEPTH_STENCIL_READ_ONLY_OPTIMAL between frames
+  GpuImage m_cache; // static depth; TRANSFER_SRC_OPTIMAL between frames
+  bool m_fresh = false; // both still UNDEFINED
+  AtlasAllocator m_allocator;
+  VkSampler m_sampler = VK_NULL_HANDLE;
+
+  VkRenderPass m_clearPass = VK_NULL_HANDLE; // cache tiles
+  VkRenderPass m_loadPass = VK_NULL_HANDLE;  // casters over the copy
+  VkFramebuffer m_cacheFramebuffer = VK_NULL_HANDLE;
+  VkFramebuffer m_atlasFramebuffer = VK_NULL_HANDLE;
+  VkPipelineLayout m_layout = VK_NULL_HANDLE;
+  VkPipeline m_worldPipelines[2] = {}; // per WorldVertexFormat
+  VkPipeline m_casterPipeline = VK_NULL_HANDLE;
+
+  memory::TrackedVector<Slot, memory::MemTag::Render> m_slots;
+  memory::TrackedVector<uint32_t, memory::MemTag::Render> m_lightSlots; // LightList id -> slot, kInvalid if none
+  memory::TrackedVector<Caster, memory::MemTag::Render> m_casters;
+  memory::TrackedVector<uint32_t, memory::MemTag::Render> m_freeCasters;
+  uint32_t m_casterCount = 0;
+  uint32_t m_worldLoads = 0; // StaticWorld::loadCount() the caches are from
+
+  memory::TrackedVector<Job, memory::MemTag::Render> m_jobs; // this frame's, from update() to record()
+  memory::TrackedVector<Candidate, memory::MemTag::Render> m_candidates; // update() scratch
+  memory::TrackedVector<VkImageCopy, memory::MemTag::Render> m_copies;   // record() scratch
+  uint32_t m_frame = 0;
+  uint32_t m_shadowCount = 0;
+  uint32_t m_staticRenders = 0;
+  uint32_t m_dynamicRenders = 0;
+  bool m_warnedCasters = false;
+};
+
+} // namespace render
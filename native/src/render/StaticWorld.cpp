@@ -0,0 +1,589 @@
+#include "StaticWorld.h"
+#include "Camera.h"
+#include "ClusteredLighting.h"
+#include "../core/Log.h"
+
+#include "shaders/world.frag.h"
+#include "shaders/world.vert.h"
+#include "shaders/world_color.vert.h"
+#include "shaders/world_cull.comp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace render {
+
+static constexpr uint32_t kBufferBindingCount = 7;
+static constexpr uint32_t kHiZBinding = 7;
+static constexpr uint32_t kBindingCount = kBufferBindingCount + 1;
+static constexpr VkDeviceSize kDrawStride = sizeof(VkDrawIndexedIndirectCommand);
+
+struct WorldFormatInfo {
+  uint32_t stride;
+  bool color;
+  const ShaderReflection* vert;
+};
+
+static const WorldFormatInfo kFormats[kWorldFormatCount] = {
+  { sizeof(WorldVertex), false, &shaders::kWorldVert },
+  { sizeof(WorldVertexColored), true, &shaders::kWorldColorVert },
+};
+
+// Everything that binds set 0; its layout is the union of theirs.
+static const ShaderReflection* const kWorldShaders[] = {
+  &shaders::kWorldCullComp, &shaders::kWorldVert, &shaders::kWorldColorVert, &shaders::kWorldFrag,
+};
+static constexpr uint32_t kWorldShaderCount = sizeof(kWorldShaders) / sizeof(kWorldShaders[0]);
+
+namespace {
+
+struct Upload {
+  GpuBuffer* dst;
+  const void* data;
+  VkDeviceSize size;
+};
+
+// Load-time copies into device-local buffers through one staging buffer and
+// a one-shot command buffer; blocks until the queue is idle.
+void uploadBuffers(const GpuContext& gpu, const Upload* uploads, uint32_t count) {
+  VkDeviceSize total = 0;
+  for (uint32_t i = 0; i < count; ++i) total += (uploads[i].size + 15) & ~(VkDeviceSize)15;
+  if (total == 0) return;
+
+  GpuBuffer staging = createBuffer(gpu, total, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+  VkCommandPoolCreateInfo cpci{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+  cpci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  cpci.queueFamilyIndex = gpu.graphicsFamily;
+  VkCommandPool pool = VK_NULL_HANDLE;
+  vkcheck(vkCreateCommandPool(gpu.device, &cpci, nullptr, &pool), "vkCreateCommandPool(world upload)");
+
+  VkCommandBufferAllocateInfo cbai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+  cbai.commandPool = pool;
+  cbai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  cbai.commandBufferCount = 1;
+  VkCommandBuffer cmd = VK_NULL_HANDLE;
+  vkcheck(vkAllocateCommandBuffers(gpu.device, &cbai, &cmd), "vkAllocateCommandBuffers(world upload)");
+
+  VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+  bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkcheck(vkBeginCommandBuffer(cmd, &bi), "vkBeginCommandBuffer(world upload)");
+
+  VkDeviceSize offset = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    const Upload& u = uploads[i];
+    if (u.size == 0) continue;
+    std::memcpy(static_cast<uint8_t*>(staging.mapped) + offset, u.data, (size_t)u.size);
+    VkBufferCopy region{};
+    region.srcOffset = offset;
+    region.size = u.size;
+    vkCmdCopyBuffer(cmd, staging.buffer, u.dst->buffer, 1, &region);
+    offset += (u.size + 15) & ~(VkDeviceSize)15;
+  }
+  vkcheck(vkEndCommandBuffer(cmd), "vkEndCommandBuffer(world upload)");
+
+  VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+  si.commandBufferCount = 1;
+  si.pCommandBuffers = &cmd;
+  vkcheck(vkQueueSubmit(gpu.graphicsQueue, 1, &si, VK_NULL_HANDLE), "vkQueueSubmit(world upload)");
+  vkcheck(vkQueueWaitIdle(gpu.graphicsQueue), "vkQueueWaitIdle(world upload)");
+
+  vkDestroyCommandPool(gpu.device, pool, nullptr);
+  destroyBuffer(gpu, staging);
+}
+
+} // namespace
+
+bool StaticWorld::init(const GpuContext& gpu, uint32_t framesInFlight, VkRenderPass renderPass,
+                       const ClusteredLighting& lighting) {
+  m_gpu = &gpu;
+  m_lighting = &lighting;
+  VkDevice device = gpu.device;
+
+  if (!gpu.features.multiDrawIndirect || !gpu.features.drawIndirectFirstInstance) {
+    core::logError(core::LogCategory::Render,
+                   "Static world disabled: device lacks multiDrawIndirect/drawIndirectFirstInstance");
+    m_gpu = nullptr;
+    return false;
+  }
+  m_compact = gpu.drawIndirectCount;
+
+  // ---- layout: set 0 = world, set 1 = clustered lighting ----
+  // Set 0 as the shaders declare it; writeDescriptors() fills all
+  // kBindingCount bindings, so every one of them must be used by some shader.
+  m_setLayout = createSetLayout(device, 0, kWorldShaders, kWorldShaderCount, "vkCreateDescriptorSetLayout(world)");
+
+  std::vector<VkDescriptorPoolSize> sizes;
+  addPoolSizes(sizes, 0, kWorldShaders, kWorldShaderCount, framesInFlight);
+
+  VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+  dpci.maxSets = framesInFlight;
+  dpci.poolSizeCount = (uint32_t)sizes.size();
+  dpci.pPoolSizes = sizes.data();
+  vkcheck(vkCreateDescriptorPool(device, &dpci, nullptr, &m_pool), "vkCreateDescriptorPool(world)");
+
+  m_frames.resize(framesInFlight);
+  for (Frame& f : m_frames) {
+    f.params = createBuffer(gpu, sizeof(Params), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dsai.descriptorPool = m_pool;
+    dsai.descriptorSetCount = 1;
+    dsai.pSetLayouts = &m_setLayout;
+    vkcheck(vkAllocateDescriptorSets(device, &dsai, &f.set), "vkAllocateDescriptorSets(world)");
+  }
+
+  // ---- pipelines ----
+  // The cull reads its phase from a push constant.
+  VkPushConstantRange pcr = pushConstantRange(kWorldShaders, kWorldShaderCount);
+
+  VkDescriptorSetLayout setLayouts[2] = { m_setLayout, lighting.setLayout() };
+  VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+  plci.setLayoutCount = 2;
+  plci.pSetLayouts = setLayouts;
+  plci.pushConstantRangeCount = pcr.size ? 1 : 0;
+  plci.pPushConstantRanges = &pcr;
+  vkcheck(vkCreatePipelineLayout(device, &plci, nullptr, &m_pipelineLayout), "vkCreatePipelineLayout(world)");
+
+  m_cull = createComputePipeline(gpu, m_pipelineLayout, shaders::kWorldCullComp.spvPath);
+  if (!m_cull) {
+    core::logError(core::LogCategory::Render, "Static world disabled: %s missing", shaders::kWorldCullComp.spvPath);
+    return false;
+  }
+
+  createRenderPipeline(renderPass);
+
+  core::logInfo(core::LogCategory::Render, "Static world: GPU culling, %s",
+                m_compact ? "vkCmdDrawIndexedIndirectCount" : "multi-draw indirect (no drawIndirectCount)");
+  return true;
+}
+
+void StaticWorld::createRenderPipeline(VkRenderPass renderPass) {
+  if (!m_gpu || !m_cull) return;
+
+  for (uint32_t format = 0; format < kWorldFormatCount; ++format) {
+    const ShaderReflection* stages[2] = { kFormats[format].vert, &shaders::kWorldFrag };
+    m_render[format].init(m_gpu->device, stages, 2, [this, format, renderPass](const VkSpecializationInfo& spec) {
+      return buildRenderPipeline(format, renderPass, spec);
+    });
+    // Only formats the world uses draw; the rest are created on first load.
+    if (m_streams[format].surfaceCount > 0) m_render[format].warm(m_features);
+  }
+}
+
+VkPipeline StaticWorld::buildRenderPipeline(uint32_t format, VkRenderPass renderPass,
+                                            const VkSpecializationInfo& spec) {
+  const WorldFormatInfo& info = kFormats[format];
+  std::vector<uint32_t> fragSpv = readSpv(shaders::kWorldFrag.spvPath, false);
+  std::vector<uint32_t> vertSpv = readSpv(info.vert->spvPath, false);
+  if (fragSpv.empty() || vertSpv.empty()) {
+    core::logError(core::LogCategory::Render, "Static world format %u does not draw: %s missing", format,
+                   fragSpv.empty() ? shaders::kWorldFrag.spvPath : info.vert->spvPath);
+    return VK_NULL_HANDLE;
+  }
+  VkDevice device = m_gpu->device;
+  VkShaderModule vert = createShaderModule(device, vertSpv);
+  VkShaderModule frag = createShaderModule(device, fragSpv);
+
+  VkPipelineShaderStageCreateInfo stages[2]{};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = vert;
+  stages[0].pName = "main";
+  stages[0].pSpecializationInfo = &spec;
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = frag;
+  stages[1].pName = "main";
+  stages[1].pSpecializationInfo = &spec;
+
+  // uv is in the buffer but not read yet (no material textures).
+  VkVertexInputBindingDescription vib{};
+  vib.binding = 0;
+  vib.stride = info.stride;
+  vib.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  VkVertexInputAttributeDescription attrs[3]{};
+  attrs[0] = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(WorldVertex, position) };
+  attrs[1] = { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(WorldVertex, normal) };
+  attrs[2] = { 2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(WorldVertexColored, color) };
+
+  VkPipelineVertexInputStateCreateInfo vis{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+  vis.vertexBindingDescriptionCount = 1;
+  vis.pVertexBindingDescriptions = &vib;
+  vis.vertexAttributeDescriptionCount = info.color ? 3 : 2;
+  vis.pVertexAttributeDescriptions = attrs;
+
+  VkPipelineInputAssemblyStateCreateInfo ias{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+  ias.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  VkPipelineViewportStateCreateInfo vps{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+  vps.viewportCount = 1;
+  vps.scissorCount = 1;
+
+  // perspective() flips y, so counter-clockwise OBJ winding stays front facing.
+  VkPipelineRasterizationStateCreateInfo rs{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+  rs.polygonMode = VK_POLYGON_MODE_FILL;
+  rs.lineWidth = 1.0f;
+  rs.cullMode = VK_CULL_MODE_BACK_BIT;
+  rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+  VkPipelineMultisampleStateCreateInfo ms{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+  ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineDepthStencilStateCreateInfo dss{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+  dss.depthTestEnable = VK_TRUE;
+  dss.depthWriteEnable = VK_TRUE;
+  dss.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+  VkPipelineColorBlendAttachmentState cba{};
+  cba.colorWriteMask =
+    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+    VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+  VkPipelineColorBlendStateCreateInfo cbs{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+  cbs.attachmentCount = 1;
+  cbs.pAttachments = &cba;
+
+  VkDynamicState dynStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+  VkPipelineDynamicStateCreateInfo ds{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+  ds.dynamicStateCount = 2;
+  ds.pDynamicStates = dynStates;
+
+  VkGraphicsPipelineCreateInfo gpci{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+  gpci.stageCount = 2;
+  gpci.pStages = stages;
+  gpci.pVertexInputState = &vis;
+  gpci.pInputAssemblyState = &ias;
+  gpci.pViewportState = &vps;
+  gpci.pRasterizationState = &rs;
+  gpci.pMultisampleState = &ms;
+  gpci.pDepthStencilState = &dss;
+  gpci.pColorBlendState = &cbs;
+  gpci.pDynamicState = &ds;
+  gpci.layout = m_pipelineLayout;
+  gpci.renderPass = renderPass;
+  gpci.subpass = 0;
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  vkcheck(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gpci, nullptr, &pipeline),
+          "vkCreateGraphicsPipelines(world)");
+
+  vkDestroyShaderModule(device, vert, nullptr);
+  vkDestroyShaderModule(device, frag, nullptr);
+  return pipeline;
+}
+
+void StaticWorld::destroyRenderPipeline() {
+  for (PipelinePermutations& p : m_render) p.shutdown();
+}
+
+void StaticWorld::shutdown() {
+  if (!m_gpu) return;
+  VkDevice device = m_gpu->device;
+
+  unload();
+  destroyRenderPipeline();
+  for (Frame& f : m_frames) destroyBuffer(*m_gpu, f.params);
+  m_frames.clear();
+
+  if (m_cull) vkDestroyPipeline(device, m_cull, nullptr);
+  if (m_pipelineLayout) vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+  if (m_pool) vkDestroyDescriptorPool(device, m_pool, nullptr);
+  if (m_setLayout) vkDestroyDescriptorSetLayout(device, m_setLayout, nullptr);
+  m_cull = VK_NULL_HANDLE;
+  m_pipelineLayout = VK_NULL_HANDLE;
+  m_pool = VK_NULL_HANDLE;
+  m_setLayout = VK_NULL_HANDLE;
+  m_lighting = nullptr;
+  m_gpu = nullptr;
+}
+
+void StaticWorld::unload() {
+  if (!m_gpu) return;
+  if (m_surfaceCount > 0) vkDeviceWaitIdle(m_gpu->device);
+
+  for (Stream& s : m_streams) {
+    destroyBuffer(*m_gpu, s.vertices);
+    destroyBuffer(*m_gpu, s.indices);
+    s = Stream{};
+  }
+  destroyBuffer(*m_gpu, m_surfaces);
+  destroyBuffer(*m_gpu, m_materials);
+  destroyBuffer(*m_gpu, m_visibility);
+  for (Frame& f : m_frames) {
+    destroyBuffer(*m_gpu, f.leaves);
+    destroyBuffer(*m_gpu, f.draws);
+    destroyBuffer(*m_gpu, f.counts);
+    f.culled[0] = f.culled[1] = false;
+  }
+  m_cpuSurfaces.clear();
+  m_surfaceCount = 0;
+  m_leafCount = 0;
+  m_leafBits.clear();
+}
+
+bool StaticWorld::load(const WorldGeometry& geometry) {
+  if (!m_gpu || !m_cull) return false;
+  unload();
+
+  // Surfaces of all formats in one table, grouped by format: a format's
+  // draw slots are then the contiguous range [firstSurface, +surfaceCount).
+  std::vector<GpuWorldSurface> surfaces;
+  surfaces.reserve(geometry.surfaceCount());
+  for (uint32_t format = 0; format < kWorldFormatCount; ++format) {
+    const WorldGeometry::Stream& src = geometry.stream((WorldVertexFormat)format);
+    m_streams[format].firstSurface = (uint32_t)surfaces.size();
+    m_streams[format].surfaceCount = (uint32_t)src.surfaces.size();
+    surfaces.insert(surfaces.end(), src.surfaces.begin(), src.surfaces.end());
+  }
+  if (surfaces.empty()) return false;
+
+  const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  const VkMemoryPropertyFlags local = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  const VkBufferUsageFlags dst = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+  std::vector<Upload> uploads;
+  for (uint32_t format = 0; format < kWorldFormatCount; ++format) {
+    const WorldGeometry::Stream& src = geometry.stream((WorldVertexFormat)format);
+    if (src.surfaces.empty()) continue;
+    Stream& s = m_streams[format];
+    s.vertices = createBuffer(*m_gpu, src.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | dst, local);
+    s.indices = createBuffer(*m_gpu, src.indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | dst,
+                             local);
+    uploads.push_back({ &s.vertices, src.vertices.data(), s.vertices.size });
+    uploads.push_back({ &s.indices, src.indices.data(), s.indices.size });
+  }
+  const std::vector<GpuWorldMaterial>& materials = geometry.materials();
+  m_surfaces = createBuffer(*m_gpu, surfaces.size() * sizeof(GpuWorldSurface), storage | dst, local);
+  m_materials = createBuffer(*m_gpu, materials.size() * sizeof(GpuWorldMaterial), storage | dst, local);
+  // Nothing was drawn before the first frame: the late phase draws it all.
+  std::vector<uint32_t> visibility(surfaces.size(), 0u);
+  m_visibility = createBuffer(*m_gpu, visibility.size() * sizeof(uint32_t), storage | dst, local);
+  uploads.push_back({ &m_surfaces, surfaces.data(), m_surfaces.size });
+  uploads.push_back({ &m_materials, materials.data(), m_materials.size });
+  uploads.push_back({ &m_visibility, visibility.data(), m_visibility.size });
+  uploadBuffers(*m_gpu, uploads.data(), (uint32_t)uploads.size());
+
+  m_surfaceCount = (uint32_t)surfaces.size();
+  m_cpuSurfaces.assign(surfaces.begin(), surfaces.end());
+  m_loadCount++;
+  m_leafCount = std::max(geometry.leafCount(), 1u);
+  setAllLeavesVisible();
+
+  const uint32_t leafWords = (m_leafCount + 31) / 32;
+  for (Frame& f : m_frames) {
+    f.leaves = createBuffer(*m_gpu, leafWords * sizeof(uint32_t), storage, host);
+    f.draws = createBuffer(*m_gpu, kPhaseCount * m_surfaceCount * kDrawStride,
+                           storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, local);
+    f.counts = createBuffer(*m_gpu, kPhaseCount * kWorldFormatCount * sizeof(uint32_t),
+                            storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | dst, local);
+    writeDescriptors(f);
+  }
+  // Compile the variants the next frames most likely draw with now rather
+  // than in the middle of one (a shadowed light may appear any time).
+  for (uint32_t format = 0; format < kWorldFormatCount; ++format) {
+    if (m_streams[format].surfaceCount == 0) continue;
+    m_render[format].warm(m_features & ~kFeatureShadows);
+    m_render[format].warm(m_features | kFeatureShadows);
+  }
+
+  core::logInfo(core::LogCategory::Render, "Static world: %u surfaces, %u triangles, %u leaves, %zu materials",
+                m_surfaceCount, geometry.triangleCount(), m_leafCount, materials.size());
+  return true;
+}
+
+void StaticWorld::writeDescriptors(Frame& f) {
+  const GpuBuffer* buffers[kBufferBindingCount] = { &f.params, &m_surfaces, &m_materials, &f.leaves,
+                                                    &f.draws,  &f.counts,   &m_visibility };
+  VkDescriptorBufferInfo infos[kBufferBindingCount]{};
+  VkWriteDescriptorSet writes[kBindingCount]{};
+  for (uint32_t i = 0; i < kBufferBindingCount; ++i) {
+    infos[i].buffer = buffers[i]->buffer;
+    infos[i].offset = 0;
+    infos[i].range = VK_WHOLE_SIZE;
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].dstSet = f.set;
+    writes[i].dstBinding = i;
+    writes[i].descriptorCount = 1;
+    writes[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[i].pBufferInfo = &infos[i];
+  }
+  uint32_t writeCount = kBufferBindingCount;
+
+  VkDescriptorImageInfo hiz{};
+  if (m_hizView) {
+    hiz.sampler = m_hizSampler;
+    hiz.imageView = m_hizView;
+    hiz.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    VkWriteDescriptorSet& w = writes[writeCount++];
+    w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    w.dstSet = f.set;
+    w.dstBinding = kHiZBinding;
+    w.descriptorCount = 1;
+    w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    w.pImageInfo = &hiz;
+  }
+  vkUpdateDescriptorSets(m_gpu->device, writeCount, writes, 0, nullptr);
+}
+
+void StaticWorld::setHiZ(VkImageView view, VkSampler sampler, uint32_t width, uint32_t height, uint32_t levels,
+                         bool enabled) {
+  m_hizView = view;
+  m_hizSampler = sampler;
+  m_hiz[0] = (float)std::max(width, 1u);
+  m_hiz[1] = (float)std::max(height, 1u);
+  m_hiz[2] = (float)std::max(levels, 1u);
+  m_hiz[3] = enabled && view ? 1.0f : 0.0f;
+  if (m_surfaceCount == 0) return;
+  for (Frame& f : m_frames) writeDescriptors(f);
+}
+
+void StaticWorld::setVisibleLeaves(const uint32_t* bits, uint32_t wordCount) {
+  std::fill(m_leafBits.begin(), m_leafBits.end(), 0u);
+  std::copy(bits, bits + std::min<size_t>(wordCount, m_leafBits.size()), m_leafBits.begin());
+}
+
+void StaticWorld::setAllLeavesVisible() {
+  m_leafBits.assign((m_leafCount + 31) / 32, ~0u);
+}
+
+void StaticWorld::setViewport(uint32_t width, uint32_t height) {
+  m_width = std::max(width, 1u);
+  m_height = std::max(height, 1u);
+}
+
+void StaticWorld::setAmbient(float r, float g, float b) {
+  m_ambient[0] = r;
+  m_ambient[1] = g;
+  m_ambient[2] = b;
+}
+
+void StaticWorld::update(uint32_t frameIndex, const Camera& camera) {
+  if (m_frames.empty() || m_surfaceCount == 0) return;
+  Frame& f = m_frames[frameIndex];
+
+  Mat4 view = camera.view();
+  Mat4 viewProj = camera.projection((float)m_width / (float)m_height) * view;
+  Frustum frustum = Frustum::fromViewProj(viewProj);
+
+  // Features nothing would show for are switched off for the frame, so
+  // their shading is compiled out rather than skipped per fragment.
+  uint32_t features = 0;
+  if (m_lighting->enabled() && m_lighting->lastLightCount() > 0) features |= kFeatureClusteredLights;
+  if (m_lighting->enabled() && m_lighting->lastDecalCount() > 0) features |= kFeatureDecals;
+  if (m_lighting->enabled() && m_lighting->lastShadowCount() > 0) features |= kFeatureShadows;
+  f.features = features;
+  m_features = features;
+
+  Params p{};
+  p.viewProj = viewProj;
+  p.view = view;
+  std::memcpy(p.planes, frustum.planes, sizeof(p.planes));
+  p.ambient[0] = m_ambient[0];
+  p.ambient[1] = m_ambient[1];
+  p.ambient[2] = m_ambient[2];
+  p.counts[0] = m_surfaceCount;
+  p.counts[1] = m_compact ? 1u : 0u;
+  for (uint32_t format = 0; format < kWorldFormatCount; ++format) p.drawBase[format] = m_streams[format].firstSurface;
+  std::memcpy(p.hiz, m_hiz, sizeof(p.hiz));
+  std::memcpy(f.params.mapped, &p, sizeof(p));
+  std::memcpy(f.leaves.mapped, m_leafBits.data(), m_leafBits.size() * sizeof(uint32_t));
+}
+
+void StaticWorld::cull(VkCommandBuffer cmd, uint32_t frameIndex, Phase phase) {
+  if (m_frames.empty() || !m_cull || m_surfaceCount == 0 || !m_hizView) return;
+  Frame& f = m_frames[frameIndex];
+
+  if (phase == Phase::Early) {
+    // Both phases' counts at once; each phase only touches its own range.
+    if (m_compact) {
+      vkCmdFillBuffer(cmd, f.counts.buffer, 0, VK_WHOLE_SIZE, 0);
+      bufferBarrier(cmd, f.counts.buffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    }
+    // Last frame's late phase wrote the visibility this one reads.
+    bufferBarrier(cmd, m_visibility.buffer,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+  }
+
+  uint32_t phaseIndex = (uint32_t)phase;
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull);
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &f.set, 0, nullptr);
+  vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(phaseIndex), &phaseIndex);
+  vkCmdDispatch(cmd, (m_surfaceCount + kGroupSize - 1) / kGroupSize, 1, 1);
+
+  VkMemoryBarrier mb{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       0, 1, &mb, 0, nullptr, 0, nullptr);
+  f.culled[phaseIndex] = true;
+}
+
+void StaticWorld::draw(VkCommandBuffer cmd, uint32_t frameIndex, Phase phase) {
+  if (m_frames.empty() || m_surfaceCount == 0) return;
+  Frame& f = m_frames[frameIndex];
+  const uint32_t phaseIndex = (uint32_t)phase;
+  if (!f.culled[phaseIndex]) return;
+  f.culled[phaseIndex] = false;
+
+  VkDescriptorSet sets[2] = { f.set, m_lighting->descriptorSet(frameIndex) };
+  vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 2, sets, 0, nullptr);
+
+  const uint32_t maxDraws = m_gpu->props.limits.maxDrawIndirectCount;
+  for (uint32_t format = 0; format < kWorldFormatCount; ++format) {
+    const Stream& s = m_streams[format];
+    if (s.surfaceCount == 0) continue;
+    VkPipeline pipeline = m_render[format].get(f.features);
+    if (!pipeline) continue;
+
+    VkDeviceSize vertexOffset = 0;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindVertexBuffers(cmd, 0, 1, &s.vertices.buffer, &vertexOffset);
+    vkCmdBindIndexBuffer(cmd, s.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+    VkDeviceSize drawOffset = ((VkDeviceSize)phaseIndex * m_surfaceCount + s.firstSurface) * kDrawStride;
+    VkDeviceSize countOffset = (phaseIndex * kWorldFormatCount + format) * sizeof(uint32_t);
+    uint32_t drawCount = std::min(s.surfaceCount, maxDraws);
+    if (m_compact) {
+      vkCmdDrawIndexedIndirectCount(cmd, f.draws.buffer, drawOffset, f.counts.buffer,
+                                    countOffset, drawCount, (uint32_t)kDrawStride);
+    } else {
+      vkCmdDrawIndexedIndirect(cmd, f.draws.buffer, drawOffset, drawCount, (uint32_t)kDrawStride);
+    }
+  }
+}
+
+void StaticWorld::drawDepth(VkCommandBuffer cmd, const VkPipeline* pipelines, const float sphere[4]) const {
+  if (m_surfaceCount == 0) return;
+  const float r2 = sphere[3] * sphere[3];
+
+  for (uint32_t format = 0; format < kWorldFormatCount; ++format) {
+    const Stream& s = m_streams[format];
+    if (s.surfaceCount == 0 || !pipelines[format]) continue;
+
+    VkDeviceSize vertexOffset = 0;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[format]);
+    vkCmdBindVertexBuffers(cmd, 0, 1, &s.vertices.buffer, &vertexOffset);
+    vkCmdBindIndexBuffer(cmd, s.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+    for (uint32_t i = s.firstSurface; i < s.firstSurface + s.surfaceCount; ++i) {
+      const GpuWorldSurface& surface = m_cpuSurfaces[i];
+      // Squared distance from the sphere's center to the box.
+      float d2 = 0.0f;
+      for (int a = 0; a < 3; ++a) {
+        float d = std::fabs(sphere[a] - surface.sphere[a]) - surface.extent[a];
+        if (d > 0.0f) d2 += d * d;
+      }
+      if (d2 > r2) continue;
+      vkCmdDrawIndexed(cmd, surface.indexCount, 1, surface.firstIndex, surface.vertexOffset, 0);
+    }
+  }
+}
+
+} // namespace render
@@ -0,0 +1,176 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "VkUtil.h"
+#include "RenderMath.h"
+#include "ShaderPermutations.h"
+#include "WorldGeometry.h"
+
+namespace render {
+
+struct Camera;
+class ClusteredLighting;
+
+/// GPU-driven static world rendering.
+///
+/// load() merges every surface of a vertex format into one device-local
+/// vertex and index buffer and uploads the surface and material tables.
+/// Per frame, all on the GPU:
+///
+///   cull  one thread per surface: leaf visible and bounding sphere inside
+///         the frustum -> append a VkDrawIndexedIndirectCommand to its
+///         format's range of the draw list (firstInstance = surface index)
+///   draw  per format: bind pipeline + merged buffers, one
+///         vkCmdDrawIndexedIndirectCount; the vertex shader resolves the
+///         surface and material from gl_InstanceIndex
+///
+/// Both run twice for occlusion culling against a HiZPyramid. The early
+/// phase draws what survived the occlusion test last frame; the pyramid is
+/// built from that depth; the late phase tests every surface's box against
+/// it, remembers the result for the next frame and draws what became
+/// visible. Each phase has its own draw list and counts.
+///
+/// The CPU uploads params and the visible-leaf bitmask, so its cost does not
+/// depend on how many surfaces are drawn. Without the drawIndirectCount
+/// feature the cull writes one command per surface (culled ones with zero
+/// instances) and a plain multi-draw vkCmdDrawIndexedIndirect consumes them.
+///
+/// Set 0 and the push constants are laid out from the shaders' build-time
+/// reflection. Each format's draw pipeline has a variant per combination of
+/// clustered lights, decals and shadow maps (ShaderFeature); update() picks
+/// the one matching the frame, so a frame without lights or decals does not
+/// pay for their shading. Fog is applied later, by PostProcess.
+///
+/// drawDepth() is the other consumer of the geometry: ShadowAtlas renders
+/// the world into a light's cached shadow map with it, once per light.
+class StaticWorld {
+public:
+  static constexpr uint32_t kGroupSize = 64; // WORLD_CULL_GROUP
+
+  enum class Phase : uint32_t { Early = 0, Late = 1 };
+  static constexpr uint32_t kPhaseCount = 2;
+
+  /// The draw pipelines bind `lighting`'s set at LIGHTING_SET (1). False if
+  /// the device lacks multi-draw/first-instance or the culling shader is
+  /// missing; load() then keeps nothing.
+  bool init(const GpuContext& gpu, uint32_t framesInFlight, VkRenderPass renderPass,
+            const ClusteredLighting& lighting);
+  void shutdown();
+
+  /// Rebuilt with the render pass.
+  void createRenderPipeline(VkRenderPass renderPass);
+  void destroyRenderPipeline();
+
+  /// Replaces the world: waits for the device, uploads through a one-shot
+  /// command buffer. All leaves start visible.
+  bool load(const WorldGeometry& geometry);
+  void unload();
+
+  /// Leaf visibility (e.g. from the PVS of the camera's leaf), one bit per
+  /// leaf; bits past `wordCount` read as hidden. Used from the next update().
+  void setVisibleLeaves(const uint32_t* bits, uint32_t wordCount);
+  void setAllLeavesVisible();
+
+  /// Size the scene renders at; may change every frame (dynamic resolution).
+  void setViewport(uint32_t width, uint32_t height);
+  void setAmbient(float r, float g, float b);
+
+  /// The pyramid the late phase tests against (sampled in GENERAL); cull()
+  /// does nothing until it is set. With `enabled` false nothing is occluded
+  /// and the late phase only catches surfaces entering the frustum. Device
+  /// idle only.
+  void setHiZ(VkImageView view, VkSampler sampler, uint32_t width, uint32_t height, uint32_t levels, bool enabled);
+
+  /// CPU side for the frame: uploads params and leaf bits. Call after the
+  /// frame's fence wait.
+  void update(uint32_t frameIndex, const Camera& camera);
+
+  /// Records the culling dispatch of `phase`. Outside a render pass; ends
+  /// with a barrier making the draw list visible to the indirect draws.
+  /// Late must follow the pyramid build of the early phase's depth.
+  void cull(VkCommandBuffer cmd, uint32_t frameIndex, Phase phase);
+
+  /// Records the indirect draws of `phase`. Inside a render pass, opaque.
+  void draw(VkCommandBuffer cmd, uint32_t frameIndex, Phase phase);
+
+  /// Depth-only draws of every surface whose box touches the sphere (world
+  /// xyz, radius), e.g. a light's bounds: per format binds pipelines[format]
+  /// and its merged buffers (position is the first attribute of both
+  /// formats) and draws surface by surface. Culled on the CPU and meant for
+  /// rare use (shadow caches); the caller sets layout state and viewport.
+  void drawDepth(VkCommandBuffer cmd, const VkPipeline* pipelines, const float sphere[4]) const;
+
+  /// Incremented by every load(); tells caches built from the geometry
+  /// that it changed.
+  uint32_t loadCount() const { return m_loadCount; }
+
+  bool enabled() const { return m_cull != VK_NULL_HANDLE; }
+  /// ShaderFeature bits the last update() drew with.
+  uint32_t features() const { return m_features; }
+  uint32_t surfaceCount() const { return m_surfaceCount; }
+  uint32_t leafCount() const { return m_leafCount; }
+
+private:
+  struct Params {
+    Mat4 viewProj;
+    Mat4 view;
+    float planes[6][4];
+    float ambient[4];
+    uint32_t counts[4];   // surface count, compact, -, -
+    uint32_t drawBase[4]; // first draw slot per format
+    float hiz[4];         // pyramid width, height, levels, enabled
+  };
+
+  struct Frame {
+    GpuBuffer params;  // UBO, host visible
+    GpuBuffer leaves;  // SSBO, host visible
+    GpuBuffer draws;   // SSBO + indirect, device local, one list per phase
+    GpuBuffer counts;  // SSBO + indirect, device local, one uint per format and phase
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    uint32_t features = 0; // ShaderFeature bits of this frame's draws
+    bool culled[kPhaseCount] = {}; // draw() only follows a recorded cull()
+  };
+
+  struct Stream {
+    GpuBuffer vertices; // device local
+    GpuBuffer indices;  // device local, uint32
+    uint32_t firstSurface = 0;
+    uint32_t surfaceCount = 0;
+  };
+
+  void writeDescriptors(Frame& f);
+  VkPipeline buildRenderPipeline(uint32_t format, VkRenderPass renderPass, const VkSpecializationInfo& spec);
+
+  const GpuContext* m_gpu = nullptr;
+  const ClusteredLighting* m_lighting = nullptr;
+  std::vector<Frame> m_frames;
+  bool m_compact = false; // drawIndirectCount available
+
+  Stream m_streams[kWorldFormatCount];
+  GpuBuffer m_surfaces;  // SSBO, device local
+  GpuBuffer m_materials; // SSBO, device local
+  GpuBuffer m_visibility; // SSBO, device local, one uint per surface
+  memory::TrackedVector<GpuWorldSurface, memory::MemTag::Render> m_cpuSurfaces; // for drawDepth()
+  uint32_t m_surfaceCount = 0;
+  uint32_t m_loadCount = 0;
+  uint32_t m_leafCount = 0;
+  memory::TrackedVector<uint32_t, memory::MemTag::Render> m_leafBits;
+
+  VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+  VkDescriptorPool m_pool = VK_NULL_HANDLE;
+  VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+  VkPipeline m_cull = VK_NULL_HANDLE;
+  PipelinePermutations m_render[kWorldFormatCount];
+  uint32_t m_features = kFeatureClusteredLights | kFeatureDecals;
+
+  uint32_t m_width = 1, m_height = 1;
+  float m_ambient[3] = { 0.03f, 0.03f, 0.04f };
+
+  VkImageView m_hizView = VK_NULL_HANDLE;
+  VkSampler m_hizSampler = VK_NULL_HANDLE;
+  float m_hiz[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+};
+
+} // namespace render
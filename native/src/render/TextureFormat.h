@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+namespace render {
+
+/// Compiled texture, written by the AssetCompiler tool (native/tools/assets)
+/// and stored in assets.pak. Little endian:
+///
+///   TextureHeader
+///   level data, mip 0 first, each level at levels[i].offset (16-byte aligned)
+///
+/// Levels are raw BCn blocks in row-major block order, exactly what
+/// vkCmdCopyBufferToImage expects with bufferRowLength = 0, so a loader
+/// copies the blob into a staging buffer and issues one region per level.
+/// Mips down to 1x1; blocks of levels smaller than 4x4 replicate edge texels.
+struct TextureLevel {
+  uint32_t offset = 0; // from the start of the header
+  uint32_t size = 0;
+};
+
+constexpr uint32_t kMaxTextureMips = 16;
+
+enum TextureFlags : uint32_t {
+  kTextureSrgb = 1u << 0,      // colour data, sampled through an _SRGB format
+  kTextureNormalMap = 1u << 1, // BC5 XY, the shader rebuilds Z
+  kTextureAlpha = 1u << 2,     // source had non-opaque texels
+};
+
+struct TextureHeader {
+  char magic[4] = { 'B', 'T', 'E', 'X' };
+  uint32_t version = 1;
+  uint32_t vkFormat = 0;   // VkFormat value, e.g. VK_FORMAT_BC7_SRGB_BLOCK
+  uint32_t width = 0, height = 0;
+  uint32_t mipCount = 0;
+  uint32_t blockBytes = 0; // 8 (BC1) or 16 (BC5, BC7), per 4x4 block
+  uint32_t flags = 0;      // TextureFlags
+  TextureLevel levels[kMaxTextureMips];
+};
+static_assert(sizeof(TextureHeader) == 160, "TextureHeader is an on-disk layout");
+
+constexpr uint32_t kTextureVersion = 1;
+
+} // namespace render
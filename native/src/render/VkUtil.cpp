@@ -0,0 +1,229 @@
+#include "VkUtil.h"
+#include "../core/Log.h"
+
+#include <cstdlib>
+#include <fstream>
+
+namespace render {
+
+GpuContext makeGpuContext(VkPhysicalDevice physical, VkDevice device,
+                          VkQueue graphicsQueue, uint32_t graphicsFamily) {
+  GpuContext gpu{};
+  gpu.physical = physical;
+  gpu.device = device;
+  gpu.graphicsQueue = graphicsQueue;
+  gpu.graphicsFamily = graphicsFamily;
+  vkGetPhysicalDeviceProperties(physical, &gpu.props);
+  vkGetPhysicalDeviceMemoryProperties(physical, &gpu.memProps);
+  return gpu;
+}
+
+void vkcheck(VkResult r, const char* where) {
+  if (r != VK_SUCCESS) {
+    core::logError(core::LogCategory::Render, "Vulkan: %s failed (%d)", where, (int)r);
+    core::logFlush();
+    std::exit(1);
+  }
+}
+
+bool vkok(VkResult r, const char* where) {
+  if (r == VK_SUCCESS) return true;
+  core::logError(core::LogCategory::Render, "Vulkan: %s failed (%d)", where, (int)r);
+  return false;
+}
+
+std::vector<uint32_t> readSpv(const char* path, bool required) {
+  std::ifstream file(path, std::ios::ate | std::ios::binary);
+  if (!file.is_open()) {
+    core::logError(core::LogCategory::Render, "Failed to open %s", path);
+    if (required) {
+      core::logFlush();
+      std::exit(1);
+    }
+    return {};
+  }
+  size_t size = (size_t)file.tellg();
+  if (size % 4 != 0) {
+    core::logError(core::LogCategory::Render, "%s size not multiple of 4", path);
+    if (required) {
+      core::logFlush();
+      std::exit(1);
+    }
+    return {};
+  }
+  std::vector<uint32_t> data(size / 4);
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(data.data()), size);
+  file.close();
+  return data;
+}
+
+VkShaderModule createShaderModule(VkDevice device, const std::vector<uint32_t>& code) {
+  VkShaderModuleCreateInfo smci{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+  smci.codeSize = code.size() * sizeof(uint32_t);
+  smci.pCode = code.data();
+
+  VkShaderModule module = VK_NULL_HANDLE;
+  vkcheck(vkCreateShaderModule(device, &smci, nullptr, &module), "vkCreateShaderModule");
+  return module;
+}
+
+uint32_t findMemoryType(const GpuContext& gpu, uint32_t typeBits, VkMemoryPropertyFlags flags) {
+  for (uint32_t i = 0; i < gpu.memProps.memoryTypeCount; ++i) {
+    if ((typeBits & (1u << i)) && (gpu.memProps.memoryTypes[i].propertyFlags & flags) == flags) {
+      return i;
+    }
+  }
+  core::logError(core::LogCategory::Render, "Vulkan: no memory type for flags 0x%x", (unsigned)flags);
+  core::logFlush();
+  std::exit(1);
+}
+
+GpuBuffer createBuffer(const GpuContext& gpu, VkDeviceSize size, VkBufferUsageFlags usage,
+                       VkMemoryPropertyFlags flags) {
+  GpuBuffer b{};
+  b.size = size;
+
+  VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+  bci.size = size;
+  bci.usage = usage;
+  bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  vkcheck(vkCreateBuffer(gpu.device, &bci, nullptr, &b.buffer), "vkCreateBuffer");
+
+  VkMemoryRequirements req{};
+  vkGetBufferMemoryRequirements(gpu.device, b.buffer, &req);
+
+  VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+  mai.allocationSize = req.size;
+  mai.memoryTypeIndex = findMemoryType(gpu, req.memoryTypeBits, flags);
+  vkcheck(vkAllocateMemory(gpu.device, &mai, nullptr, &b.memory), "vkAllocateMemory");
+  vkcheck(vkBindBufferMemory(gpu.device, b.buffer, b.memory, 0), "vkBindBufferMemory");
+
+  if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    vkcheck(vkMapMemory(gpu.device, b.memory, 0, VK_WHOLE_SIZE, 0, &b.mapped), "vkMapMemory");
+  }
+  return b;
+}
+
+void destroyBuffer(const GpuContext& gpu, GpuBuffer& b) {
+  if (b.buffer != VK_NULL_HANDLE) vkDestroyBuffer(gpu.device, b.buffer, nullptr);
+  if (b.memory != VK_NULL_HANDLE) vkFreeMemory(gpu.device, b.memory, nullptr); // unmaps implicitly
+  b = GpuBuffer{};
+}
+
+GpuImage createImage(const GpuContext& gpu, uint32_t width, uint32_t height, VkFormat format,
+                     VkImageUsageFlags usage, VkImageAspectFlags aspect, uint32_t mipLevels) {
+  GpuImage img{};
+  img.format = format;
+  img.width = width;
+  img.height = height;
+  img.mipLevels = mipLevels;
+
+  VkImageCreateInfo ici{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+  ici.imageType = VK_IMAGE_TYPE_2D;
+  ici.format = format;
+  ici.extent = { width, height, 1 };
+  ici.mipLevels = mipLevels;
+  ici.arrayLayers = 1;
+  ici.samples = VK_SAMPLE_COUNT_1_BIT;
+  ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+  ici.usage = usage;
+  ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  vkcheck(vkCreateImage(gpu.device, &ici, nullptr, &img.image), "vkCreateImage");
+
+  VkMemoryRequirements req{};
+  vkGetImageMemoryRequirements(gpu.device, img.image, &req);
+
+  VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+  mai.allocationSize = req.size;
+  mai.memoryTypeIndex = findMemoryType(gpu, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  vkcheck(vkAllocateMemory(gpu.device, &mai, nullptr, &img.memory), "vkAllocateMemory(image)");
+  vkcheck(vkBindImageMemory(gpu.device, img.image, img.memory, 0), "vkBindImageMemory");
+
+  VkImageViewCreateInfo ivci{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+  ivci.image = img.image;
+  ivci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  ivci.format = format;
+  ivci.subresourceRange.aspectMask = aspect;
+  ivci.subresourceRange.levelCount = mipLevels;
+  ivci.subresourceRange.layerCount = 1;
+  vkcheck(vkCreateImageView(gpu.device, &ivci, nullptr, &img.view), "vkCreateImageView(image)");
+  return img;
+}
+
+void destroyImage(const GpuContext& gpu, GpuImage& img) {
+  if (img.view != VK_NULL_HANDLE) vkDestroyImageView(gpu.device, img.view, nullptr);
+  if (img.image != VK_NULL_HANDLE) vkDestroyImage(gpu.device, img.image, nullptr);
+  if (img.memory != VK_NULL_HANDLE) vkFreeMemory(gpu.device, img.memory, nullptr);
+  img = GpuImage{};
+}
+
+VkFormat findDepthFormat(VkPhysicalDevice physical) {
+  const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
+  const VkFormatFeatureFlags need =
+    VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+  for (VkFormat f : candidates) {
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties(physical, f, &props);
+    if ((props.optimalTilingFeatures & need) == need) return f;
+  }
+  core::logError(core::LogCategory::Render, "Vulkan: no sampleable depth format");
+  return VK_FORMAT_UNDEFINED;
+}
+
+VkPipeline createComputePipeline(const GpuContext& gpu, VkPipelineLayout layout, const char* spvPath,
+                                 const VkSpecializationInfo* spec) {
+  std::vector<uint32_t> code = readSpv(spvPath, false);
+  if (code.empty()) return VK_NULL_HANDLE;
+
+  VkShaderModule module = createShaderModule(gpu.device, code);
+
+  VkComputePipelineCreateInfo cpci{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+  cpci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  cpci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  cpci.stage.module = module;
+  cpci.stage.pName = "main";
+  cpci.stage.pSpecializationInfo = spec;
+  cpci.layout = layout;
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  vkcheck(vkCreateComputePipelines(gpu.device, VK_NULL_HANDLE, 1, &cpci, nullptr, &pipeline),
+          "vkCreateComputePipelines");
+  vkDestroyShaderModule(gpu.device, module, nullptr);
+  return pipeline;
+}
+
+void bufferBarrier(VkCommandBuffer cmd, VkBuffer buffer,
+                   VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                   VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+  VkBufferMemoryBarrier b{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+  b.srcAccessMask = srcAccess;
+  b.dstAccessMask = dstAccess;
+  b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  b.buffer = buffer;
+  b.offset = 0;
+  b.size = VK_WHOLE_SIZE;
+  vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 1, &b, 0, nullptr);
+}
+
+void imageBarrier(VkCommandBuffer cmd, VkImage image, VkImageAspectFlags aspect,
+                  VkImageLayout oldLayout, VkImageLayout newLayout,
+                  VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                  VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+  VkImageMemoryBarrier b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+  b.srcAccessMask = srcAccess;
+  b.dstAccessMask = dstAccess;
+  b.oldLayout = oldLayout;
+  b.newLayout = newLayout;
+  b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  b.image = image;
+  b.subresourceRange.aspectMask = aspect;
+  b.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+  b.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+  vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
+}
+
+} // namespace render
@@ -0,0 +1,84 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace render {
+
+/// Device-level handles every render subsystem needs. Filled once after
+/// device creation and passed by reference; subsystems never own these.
+struct GpuContext {
+  VkPhysicalDevice physical = VK_NULL_HANDLE;
+  VkDevice device = VK_NULL_HANDLE;
+  VkQueue graphicsQueue = VK_NULL_HANDLE;
+  uint32_t graphicsFamily = UINT32_MAX;
+  VkPhysicalDeviceProperties props{};
+  VkPhysicalDeviceMemoryProperties memProps{};
+  VkPhysicalDeviceFeatures features{}; // what the device was created with
+  bool drawIndirectCount = false;      // Vulkan 1.2 feature, enabled when supported
+};
+
+GpuContext makeGpuContext(VkPhysicalDevice physical, VkDevice device,
+                          VkQueue graphicsQueue, uint32_t graphicsFamily);
+
+/// Fatal: prints and exits on anything but VK_SUCCESS.
+void vkcheck(VkResult r, const char* where);
+/// Logs anything but VK_SUCCESS and returns false. For code that must not
+/// exit the process itself: startup tasks on job workers report failure
+/// to the thread that runs the graph instead.
+bool vkok(VkResult r, const char* where);
+
+/// Loads a SPIR-V binary. Missing/invalid files exit unless required is
+/// false, in which case an empty vector is returned.
+std::vector<uint32_t> readSpv(const char* path, bool required = true);
+VkShaderModule createShaderModule(VkDevice device, const std::vector<uint32_t>& code);
+
+uint32_t findMemoryType(const GpuContext& gpu, uint32_t typeBits, VkMemoryPropertyFlags flags);
+
+struct GpuBuffer {
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize size = 0;
+  void* mapped = nullptr; // persistently mapped when host visible
+};
+
+GpuBuffer createBuffer(const GpuContext& gpu, VkDeviceSize size, VkBufferUsageFlags usage,
+                       VkMemoryPropertyFlags flags);
+void destroyBuffer(const GpuContext& gpu, GpuBuffer& buffer);
+
+struct GpuImage {
+  VkImage image = VK_NULL_HANDLE;
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkImageView view = VK_NULL_HANDLE; // all mips/layers of `aspect`
+  VkFormat format = VK_FORMAT_UNDEFINED;
+  uint32_t width = 0, height = 0, mipLevels = 1;
+};
+
+/// Device-local 2D image plus a view over every mip level.
+GpuImage createImage(const GpuContext& gpu, uint32_t width, uint32_t height, VkFormat format,
+                     VkImageUsageFlags usage, VkImageAspectFlags aspect, uint32_t mipLevels = 1);
+void destroyImage(const GpuContext& gpu, GpuImage& image);
+
+/// First depth format that can be both a depth attachment and sampled;
+/// VK_FORMAT_UNDEFINED (logged) if there is none.
+VkFormat findDepthFormat(VkPhysicalDevice physical);
+
+/// Compute pipeline from a .spv file; VK_NULL_HANDLE if the file is missing
+/// so optional passes can switch themselves off. `spec` may be null.
+VkPipeline createComputePipeline(const GpuContext& gpu, VkPipelineLayout layout, const char* spvPath,
+                                 const VkSpecializationInfo* spec = nullptr);
+
+/// Whole-buffer memory barrier.
+void bufferBarrier(VkCommandBuffer cmd, VkBuffer buffer,
+                   VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                   VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+/// Layout transition (or plain memory barrier when the layouts match) over
+/// every mip/layer of `aspect`.
+void imageBarrier(VkCommandBuffer cmd, VkImage image, VkImageAspectFlags aspect,
+                  VkImageLayout oldLayout, VkImageLayout newLayout,
+                  VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                  VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+} // namespace render
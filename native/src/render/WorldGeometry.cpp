@@ -0,0 +1,341 @@
+#include "WorldGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+
+namespace render {
+
+WorldGeometry::WorldGeometry() {
+  m_materials.push_back(GpuWorldMaterial{});
+}
+
+uint32_t WorldGeometry::addMaterial(const GpuWorldMaterial& material) {
+  m_materials.push_back(material);
+  return (uint32_t)m_materials.size() - 1;
+}
+
+uint32_t WorldGeometry::addSurface(uint32_t leaf, uint32_t material, const WorldVertex* vertices,
+                                   uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+  return append(WorldVertexFormat::Lit, leaf, material, vertices, sizeof(WorldVertex), vertexCount, indices,
+                indexCount);
+}
+
+uint32_t WorldGeometry::addSurface(uint32_t leaf, uint32_t material, const WorldVertexColored* vertices,
+                                   uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+  return append(WorldVertexFormat::Colored, leaf, material, vertices, sizeof(WorldVertexColored), vertexCount,
+                indices, indexCount);
+}
+
+uint32_t WorldGeometry::append(WorldVertexFormat format, uint32_t leaf, uint32_t material, const void* vertices,
+                               uint32_t stride, uint32_t vertexCount, const uint32_t* indices,
+                               uint32_t indexCount) {
+  if (vertexCount == 0 || indexCount < 3 || indexCount % 3 != 0) return UINT32_MAX;
+  for (uint32_t i = 0; i < indexCount; ++i) {
+    if (indices[i] >= vertexCount) return UINT32_MAX;
+  }
+
+  // Every format starts with float position[3].
+  const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+  auto position = [&](uint32_t i) {
+    const float* p = reinterpret_cast<const float*>(bytes + (size_t)i * stride);
+    return p;
+  };
+  float mn[3] = { INFINITY, INFINITY, INFINITY };
+  float mx[3] = { -INFINITY, -INFINITY, -INFINITY };
+  for (uint32_t i = 0; i < vertexCount; ++i) {
+    const float* p = position(i);
+    for (int c = 0; c < 3; ++c) {
+      mn[c] = std::min(mn[c], p[c]);
+      mx[c] = std::max(mx[c], p[c]);
+    }
+  }
+  float center[3] = { (mn[0] + mx[0]) * 0.5f, (mn[1] + mx[1]) * 0.5f, (mn[2] + mx[2]) * 0.5f };
+  float radiusSq = 0.0f;
+  for (uint32_t i = 0; i < vertexCount; ++i) {
+    const float* p = position(i);
+    float dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+    radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+  }
+
+  Stream& s = m_streams[(uint32_t)format];
+  GpuWorldSurface surface;
+  surface.sphere[0] = center[0];
+  surface.sphere[1] = center[1];
+  surface.sphere[2] = center[2];
+  surface.sphere[3] = std::sqrt(radiusSq);
+  for (int c = 0; c < 3; ++c) surface.extent[c] = (mx[c] - mn[c]) * 0.5f;
+  surface.firstIndex = (uint32_t)s.indices.size();
+  surface.indexCount = indexCount;
+  surface.vertexOffset = (int32_t)s.vertexCount;
+  surface.material = material < m_materials.size() ? material : 0;
+  surface.leaf = leaf;
+  surface.format = (uint32_t)format;
+
+  s.vertices.insert(s.vertices.end(), bytes, bytes + (size_t)vertexCount * stride);
+  s.indices.insert(s.indices.end(), indices, indices + indexCount);
+  s.vertexCount += vertexCount;
+  s.surfaces.push_back(surface);
+  m_leafCount = std::max(m_leafCount, leaf + 1);
+  return (uint32_t)s.surfaces.size() - 1;
+}
+
+void WorldGeometry::clear() {
+  for (Stream& s : m_streams) s = Stream{};
+  m_materials.assign(1, GpuWorldMaterial{});
+  m_leafCount = 0;
+}
+
+uint32_t WorldGeometry::surfaceCount() const {
+  uint32_t n = 0;
+  for (const Stream& s : m_streams) n += (uint32_t)s.surfaces.size();
+  return n;
+}
+
+uint32_t WorldGeometry::triangleCount() const {
+  uint32_t n = 0;
+  for (const Stream& s : m_streams) n += (uint32_t)s.indices.size() / 3;
+  return n;
+}
+
+// ---------------------------------------------------------------------------
+// OBJ loading
+
+namespace {
+
+uint32_t packColor(const float rgb[3]) {
+  uint32_t c = 0xFF000000u;
+  for (int i = 0; i < 3; ++i) {
+    uint32_t v = (uint32_t)std::lround(std::clamp(rgb[i], 0.0f, 1.0f) * 255.0f);
+    c |= v << (8 * i);
+  }
+  return c;
+}
+
+std::string lineError(const char* path, uint32_t lineNo, const char* what) {
+  return std::string(path) + ":" + std::to_string(lineNo) + ": " + what;
+}
+
+bool loadMtl(const std::string& path, WorldGeometry& out, std::unordered_map<std::string, uint32_t>& names,
+             std::string& error) {
+  std::ifstream in(path);
+  if (!in) {
+    error = "cannot open " + path;
+    return false;
+  }
+  GpuWorldMaterial current;
+  std::string currentName;
+  auto flush = [&] {
+    if (!currentName.empty()) names[currentName] = out.addMaterial(current);
+  };
+
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream ls(line);
+    std::string tag;
+    if (!(ls >> tag) || tag[0] == '#') continue;
+    if (tag == "newmtl") {
+      flush();
+      current = GpuWorldMaterial{};
+      ls >> currentName;
+    } else if (tag == "Kd") {
+      ls >> current.albedo[0] >> current.albedo[1] >> current.albedo[2];
+    } else if (tag == "Ke") {
+      ls >> current.emissive[0] >> current.emissive[1] >> current.emissive[2];
+    }
+    // Textures, specular terms: not used by the world shader yet.
+  }
+  flush();
+  return true;
+}
+
+// One batch of faces sharing leaf/material/format, deduplicated by
+// (position, uv, normal) index triple.
+struct Run {
+  uint32_t leaf = 0, material = 0;
+  WorldVertexFormat format = WorldVertexFormat::Lit;
+  std::vector<WorldVertexColored> vertices;
+  std::vector<uint32_t> indices;
+  std::map<std::tuple<long, long, long>, uint32_t> lookup;
+};
+
+void flushRun(Run& run, WorldGeometry& out) {
+  if (run.indices.empty()) return;
+  if (run.format == WorldVertexFormat::Colored) {
+    out.addSurface(run.leaf, run.material, run.vertices.data(), (uint32_t)run.vertices.size(), run.indices.data(),
+                   (uint32_t)run.indices.size());
+  } else {
+    std::vector<WorldVertex> lit(run.vertices.size());
+    for (size_t i = 0; i < lit.size(); ++i) std::memcpy(&lit[i], &run.vertices[i], sizeof(WorldVertex));
+    out.addSurface(run.leaf, run.material, lit.data(), (uint32_t)lit.size(), run.indices.data(),
+                   (uint32_t)run.indices.size());
+  }
+  run.vertices.clear();
+  run.indices.clear();
+  run.lookup.clear();
+}
+
+} // namespace
+
+bool loadWorldObj(const char* path, WorldGeometry& out, std::string& error) {
+  std::ifstream in(path);
+  if (!in) {
+    error = std::string("cannot open ") + path;
+    return false;
+  }
+  std::string dir = path;
+  size_t slash = dir.find_last_of("/\\");
+  dir = slash == std::string::npos ? std::string() : dir.substr(0, slash + 1);
+
+  std::vector<float> positions, uvs, normals; // 3, 2, 3 floats per entry
+  std::vector<uint32_t> colors;               // per position, 0 = none
+  std::unordered_map<std::string, uint32_t> materialNames;
+  uint32_t leaf = 0, material = 0, faceCount = 0;
+  bool leafHasFaces = false;
+  Run run;
+
+  struct Corner { long p, t, n; };
+  std::vector<Corner> corners;
+
+  std::string line;
+  uint32_t lineNo = 0;
+  while (std::getline(in, line)) {
+    ++lineNo;
+    std::istringstream ls(line);
+    std::string tag;
+    if (!(ls >> tag) || tag[0] == '#') continue;
+
+    if (tag == "v") {
+      float v[6];
+      if (!(ls >> v[0] >> v[1] >> v[2])) {
+        error = lineError(path, lineNo, "bad vertex");
+        return false;
+      }
+      positions.insert(positions.end(), v, v + 3);
+      colors.push_back(ls >> v[3] >> v[4] >> v[5] ? packColor(v + 3) : 0u);
+    } else if (tag == "vt") {
+      float t[2] = { 0.0f, 0.0f };
+      ls >> t[0] >> t[1];
+      uvs.push_back(t[0]);
+      uvs.push_back(1.0f - t[1]); // OBJ v points up, Vulkan t down
+    } else if (tag == "vn") {
+      float n[3];
+      if (!(ls >> n[0] >> n[1] >> n[2])) {
+        error = lineError(path, lineNo, "bad normal");
+        return false;
+      }
+      normals.insert(normals.end(), n, n + 3);
+    } else if (tag == "o" || tag == "g") {
+      if (leafHasFaces) ++leaf;
+      leafHasFaces = false;
+    } else if (tag == "mtllib") {
+      std::string file;
+      ls >> file;
+      if (!loadMtl(dir + file, out, materialNames, error)) return false;
+    } else if (tag == "usemtl") {
+      std::string name;
+      ls >> name;
+      auto it = materialNames.find(name);
+      material = it != materialNames.end() ? it->second : 0;
+    } else if (tag == "f") {
+      // "a", "a/b", "a//c", "a/b/c"; negative indices count from the end.
+      corners.clear();
+      std::string token;
+      while (ls >> token) {
+        long idx[3] = { 0, 0, 0 };
+        long counts[3] = { (long)positions.size() / 3, (long)uvs.size() / 2, (long)normals.size() / 3 };
+        const char* s = token.c_str();
+        for (int k = 0; k < 3 && *s; ++k) {
+          if (*s != '/') {
+            char* end = nullptr;
+            idx[k] = std::strtol(s, &end, 10);
+            s = end;
+          }
+          if (idx[k] < 0) idx[k] = counts[k] + idx[k] + 1;
+          if (idx[k] > counts[k] || (k == 0 && idx[k] < 1)) {
+            error = lineError(path, lineNo, "index out of range");
+            return false;
+          }
+          if (*s == '/') ++s;
+        }
+        corners.push_back({ idx[0] - 1, idx[1] - 1, idx[2] - 1 });
+      }
+      if (corners.size() < 3) {
+        error = lineError(path, lineNo, "face with fewer than 3 corners");
+        return false;
+      }
+
+      // Newell normal for corners without one.
+      float faceNormal[3] = { 0.0f, 0.0f, 0.0f };
+      for (size_t i = 0; i < corners.size(); ++i) {
+        const float* a = &positions[corners[i].p * 3];
+        const float* b = &positions[corners[(i + 1) % corners.size()].p * 3];
+        faceNormal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+        faceNormal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+        faceNormal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+      }
+      float len = std::sqrt(faceNormal[0] * faceNormal[0] + faceNormal[1] * faceNormal[1] +
+                            faceNormal[2] * faceNormal[2]);
+      for (float& c : faceNormal) c = len > 0.0f ? c / len : 0.0f;
+
+      bool colored = false;
+      for (const Corner& c : corners) colored |= colors[c.p] != 0;
+      WorldVertexFormat format = colored ? WorldVertexFormat::Colored : WorldVertexFormat::Lit;
+
+      uint32_t triangles = (uint32_t)corners.size() - 2;
+      if (run.leaf != leaf || run.material != material || run.format != format ||
+          run.indices.size() / 3 + triangles > kMaxObjSurfaceTriangles) {
+        flushRun(run, out);
+        run.leaf = leaf;
+        run.material = material;
+        run.format = format;
+      }
+
+      uint32_t local[64];
+      size_t cornerCount = std::min<size_t>(corners.size(), 64);
+      for (size_t i = 0; i < cornerCount; ++i) {
+        const Corner& c = corners[i];
+        // Computed normals differ per face: key them by face.
+        long normalKey = c.n >= 0 ? c.n : -2 - (long)faceCount;
+        auto key = std::make_tuple(c.p, c.t, normalKey);
+        auto it = run.lookup.find(key);
+        if (it != run.lookup.end()) {
+          local[i] = it->second;
+          continue;
+        }
+        WorldVertexColored v{};
+        std::memcpy(v.position, &positions[c.p * 3], sizeof(v.position));
+        if (c.n >= 0) std::memcpy(v.normal, &normals[c.n * 3], sizeof(v.normal));
+        else std::memcpy(v.normal, faceNormal, sizeof(v.normal));
+        if (c.t >= 0) std::memcpy(v.uv, &uvs[c.t * 2], sizeof(v.uv));
+        v.color = colors[c.p] != 0 ? colors[c.p] : 0xFFFFFFFFu;
+        local[i] = (uint32_t)run.vertices.size();
+        run.vertices.push_back(v);
+        run.lookup.emplace(key, local[i]);
+      }
+      for (size_t i = 1; i + 1 < cornerCount; ++i) {
+        run.indices.push_back(local[0]);
+        run.indices.push_back(local[i]);
+        run.indices.push_back(local[i + 1]);
+      }
+      leafHasFaces = true;
+      ++faceCount;
+    }
+    // vp/s/l/p: not used.
+  }
+  flushRun(run, out);
+
+  if (faceCount == 0) {
+    error = std::string(path) + ": no faces";
+    return false;
+  }
+  return true;
+}
+
+} // namespace render
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace render {
+
+/// Vertex formats of static world geometry. Each gets its own merged
+/// vertex/index buffer and pipeline in StaticWorld.
+enum class WorldVertexFormat : uint32_t {
+  Lit = 0,     // WorldVertex
+  Colored = 1, // WorldVertexColored: per-vertex tint (baked AO, painted props)
+};
+constexpr uint32_t kWorldFormatCount = 2;
+
+/// Vertex layouts as uploaded; attribute offsets live in StaticWorld.cpp.
+/// uv is carried for material textures.
+struct WorldVertex {
+  float position[3];
+  float normal[3];
+  float uv[2];
+};
+static_assert(sizeof(WorldVertex) == 32, "WorldVertex is a vertex buffer layout");
+
+struct WorldVertexColored {
+  float position[3];
+  float normal[3];
+  float uv[2];
+  uint32_t color; // RGBA8, linear
+};
+static_assert(sizeof(WorldVertexColored) == 36, "WorldVertexColored is a vertex buffer layout");
+
+/// GPU layout (std430, 32 bytes); mirrored by `Material` in
+/// shaders/world_common.glsl. Surfaces reference it by index.
+struct GpuWorldMaterial {
+  float albedo[4] = { 0.7f, 0.7f, 0.7f, 1.0f };
+  float emissive[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+static_assert(sizeof(GpuWorldMaterial) == 32, "GpuWorldMaterial must match the shader struct");
+
+/// GPU layout (std430, 64 bytes); mirrored by `Surface` in
+/// shaders/world_common.glsl. firstIndex/vertexOffset point into the merged
+/// buffers of `format`. The sphere and the box share their center.
+struct GpuWorldSurface {
+  float sphere[4] = { 0, 0, 0, 0 }; // world bounding sphere (frustum test)
+  float extent[3] = { 0, 0, 0 };    // AABB half size (occlusion test)
+  uint32_t leaf = 0;
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+  int32_t vertexOffset = 0;
+  uint32_t material = 0;
+  uint32_t format = 0;
+  uint32_t pad[3] = { 0, 0, 0 };
+};
+static_assert(sizeof(GpuWorldSurface) == 64, "GpuWorldSurface must match the shader struct");
+
+/// CPU-side static world: surfaces merged into one vertex and one index
+/// array per vertex format, ready for StaticWorld::load().
+///
+/// A surface is a batch of triangles sharing leaf, material and format;
+/// its indices are local to its own vertices (the merged offset becomes the
+/// draw's vertexOffset). Leaves are the visibility units the culling pass
+/// tests, numbered 0..leafCount()-1.
+class WorldGeometry {
+public:
+  WorldGeometry();
+
+  /// Returns the material index; index 0 is a neutral default.
+  uint32_t addMaterial(const GpuWorldMaterial& material);
+
+  /// Return the surface index within its format, or UINT32_MAX when the
+  /// input is empty or indexes past `vertexCount`.
+  uint32_t addSurface(uint32_t leaf, uint32_t material, const WorldVertex* vertices, uint32_t vertexCount,
+                      const uint32_t* indices, uint32_t indexCount);
+  uint32_t addSurface(uint32_t leaf, uint32_t material, const WorldVertexColored* vertices, uint32_t vertexCount,
+                      const uint32_t* indices, uint32_t indexCount);
+
+  void clear();
+
+  struct Stream {
+    std::vector<uint8_t> vertices; // tightly packed, format stride
+    std::vector<uint32_t> indices;
+    std::vector<GpuWorldSurface> surfaces;
+    uint32_t vertexCount = 0;
+  };
+
+  const Stream& stream(WorldVertexFormat format) const { return m_streams[(uint32_t)format]; }
+  const std::vector<GpuWorldMaterial>& materials() const { return m_materials; }
+  uint32_t leafCount() const { return m_leafCount; }
+  uint32_t surfaceCount() const;
+  uint32_t triangleCount() const;
+
+private:
+  uint32_t append(WorldVertexFormat format, uint32_t leaf, uint32_t material, const void* vertices,
+                  uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+  Stream m_streams[kWorldFormatCount];
+  std::vector<GpuWorldMaterial> m_materials;
+  uint32_t m_leafCount = 0;
+};
+
+/// Wavefront OBJ as static world, the interchange format the map compiler
+/// emits (the lightmap baker reads the same files):
+///   o/g    starts a new leaf
+///   usemtl selects a material from the mtllib (Kd = albedo, Ke = emissive)
+///   v x y z [r g b]  vertex colours put the face in the Colored format
+/// Faces are fanned into triangles; faces without normals get the polygon
+/// normal. Consecutive faces of one leaf/material/format are batched into
+/// surfaces of at most kMaxObjSurfaceTriangles.
+/// False with a message in `error` on unreadable files or bad lines.
+constexpr uint32_t kMaxObjSurfaceTriangles = 256;
+bool loadWorldObj(const char* path, WorldGeometry& out, std::string& error);
+
+} // namespace render
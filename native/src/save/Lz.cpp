@@ -0,0 +1,105 @@
+#include "Lz.h"
+
+#include <cstring>
+
+namespace save {
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxOffset = 65535;
+constexpr uint32_t kHashBits = 14;
+
+uint32_t read32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+uint32_t hash4(uint32_t v) { return (v * 2654435761u) >> (32 - kHashBits); }
+
+void putLength(std::vector<uint8_t>& out, size_t extra) {
+  while (extra >= 255) {
+    out.push_back(255);
+    extra -= 255;
+  }
+  out.push_back((uint8_t)extra);
+}
+
+void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset,
+                 size_t matchLength) {
+  const size_t m = matchLength ? matchLength - kMinMatch : 0;
+  out.push_back((uint8_t)(((literalCount < 15 ? literalCount : 15) << 4) | (m < 15 ? m : 15)));
+  if (literalCount >= 15) putLength(out, literalCount - 15);
+  out.insert(out.end(), literals, literals + literalCount);
+  if (!matchLength) return;
+  out.push_back((uint8_t)(offset & 0xff));
+  out.push_back((uint8_t)(offset >> 8));
+  if (m >= 15) putLength(out, m - 15);
+}
+
+bool getLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+  uint8_t b;
+  do {
+    if (ip >= end) return false;
+    b = *ip++;
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+} // namespace
+
+void lzCompress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+  std::vector<uint32_t> table(size_t(1) << kHashBits, 0); // position + 1, 0 = empty
+  size_t anchor = 0, i = 0;
+  uint32_t misses = 0;
+  while (i + kMinMatch <= size) {
+    const uint32_t v = read32(src + i);
+    uint32_t& slot = table[hash4(v)];
+    const size_t candidate = slot;
+    slot = (uint32_t)(i + 1);
+    if (candidate && i - (candidate - 1) <= kMaxOffset && read32(src + candidate - 1) == v) {
+      const size_t from = candidate - 1;
+      size_t length = kMinMatch;
+      while (i + length < size && src[from + length] == src[i + length]) ++length;
+      putSequence(out, src + anchor, i - anchor, i - from, length);
+      i += length;
+      anchor = i;
+      misses = 0;
+      continue;
+    }
+    i += 1 + (++misses >> 6); // skip faster through data that does not compress
+  }
+  putSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+bool lzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t rawSize) {
+  const uint8_t* ip = src;
+  const uint8_t* end = src + size;
+  size_t op = 0;
+  while (ip < end) {
+    const uint8_t token = *ip++;
+    size_t literals = token >> 4;
+    if (literals == 15 && !getLength(ip, end, literals)) return false;
+    if (literals > (size_t)(end - ip) || literals > rawSize - op) return false;
+    std::memcpy(dst + op, ip, literals);
+    ip += literals;
+    op += literals;
+    if (ip == end) break; // last sequence
+
+    if (end - ip < 2) return false;
+    const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+    ip += 2;
+    size_t length = token & 15;
+    if (length == 15 && !getLength(ip, end, length)) return false;
+    length += kMinMatch;
+    if (offset == 0 || offset > op || length > rawSize - op) return false;
+    const uint8_t* from = dst + op - offset;
+    for (size_t k = 0; k < length; ++k) dst[op + k] = from[k]; // may overlap itself
+    op += length;
+  }
+  return op == rawSize;
+}
+
+} // namespace save
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace save {
+
+/// Byte-oriented LZ77 in the style of LZ4 blocks: each sequence is a token
+/// (literal count << 4 | match length - 4), extra length bytes when a field
+/// is 15, the literals, then a 16-bit back offset and extra match length
+/// bytes. The last sequence has literals only. Fast on both ends, and good
+/// on snapshot chunks, which are mostly zeros and repeated floats.
+
+/// Appends the compressed form of src to out.
+void lzCompress(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+/// False if src is not exactly one block that expands to rawSize bytes.
+bool lzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t rawSize);
+
+} // namespace save
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+namespace save {
+
+/// Snapshot file written by SaveSystem. Little endian:
+///
+///   SaveHeader
+///   for each chunk:
+///     SaveChunk
+///     storedSize bytes, then zero padding to kChunkAlignment
+///
+/// A chunk is an array of elementCount fixed-size records (elementSize
+/// bytes each) copied straight out of one system, so an uncompressed chunk
+/// restores from the mapped file without parsing. Compressed chunks are
+/// LZ blocks (Lz.h) of the same bytes. Readers skip chunk ids they do not
+/// know and chunks whose version or elementSize differ from theirs.
+struct SaveHeader {
+  char magic[4] = { 'B', 'S', 'A', 'V' };
+  uint32_t version = 1;
+  uint32_t chunkCount = 0;
+  uint32_t reserved = 0;
+};
+static_assert(sizeof(SaveHeader) == 16, "SaveHeader is an on-disk layout");
+
+constexpr uint32_t kChunkCompressed = 1u << 0;
+
+struct SaveChunk {
+  uint32_t id = 0;      // fourcc()
+  uint32_t version = 0; // of the record layout
+  uint32_t flags = 0;   // kChunkCompressed
+  uint32_t elementSize = 0;
+  uint32_t elementCount = 0;
+  uint32_t reserved = 0;
+  uint64_t storedSize = 0; // bytes that follow in the file, before padding
+};
+static_assert(sizeof(SaveChunk) == 32, "SaveChunk is an on-disk layout");
+
+constexpr uint32_t fourcc(char a, char b, char c, char d) {
+  return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) |
+         ((uint32_t)(uint8_t)d << 24);
+}
+
+// Chunk ids; each names the record type it holds.
+constexpr uint32_t kChunkCamera = fourcc('C', 'A', 'M', 'R');     // render::Camera, one
+constexpr uint32_t kChunkLights = fourcc('L', 'I', 'T', 'E');     // render::Light per slot
+constexpr uint32_t kChunkLightAlive = fourcc('L', 'I', 'T', 'A'); // uint8_t per light slot
+constexpr uint32_t kChunkBodies = fourcc('B', 'O', 'D', 'Y');     // physics::BodyState per slot
+constexpr uint32_t kChunkTriggers = fourcc('T', 'R', 'I', 'G');   // physics::TriggerState per slot
+constexpr uint32_t kChunkActors = fourcc('A', 'C', 'T', 'R');     // physics::ActorState per slot
+constexpr uint32_t kChunkScript = fourcc('S', 'C', 'R', 'P');     // bytes handed over by scripts
+
+constexpr uint32_t kSaveVersion = 1;
+constexpr uint32_t kChunkAlignment = 16;
+
+} // namespace save
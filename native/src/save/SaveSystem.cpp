@@ -0,0 +1,329 @@
+#include "SaveSystem.h"
+#include "Lz.h"
+#include "../core/MappedFile.h"
+#include "../physics/PhysicsWorld.h"
+#include "../physics/TriggerSystem.h"
+#include "../render/Camera.h"
+#include "../render/Lights.h"
+#include "../core/Log.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+
+namespace save {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Record layout version per chunk type. Bump only the chunk whose record
+// changed, so older saves keep every chunk that still reads the same.
+// Lights are at 2 since Light gained its shadow fields.
+constexpr uint32_t recordVersion(uint32_t chunkId) { return chunkId == kChunkLights ? 2 : 1; }
+
+constexpr size_t kMinCompressBytes = 256; // smaller chunks are stored as they are
+// An LZ block cannot expand further: one extra length byte (255 more match
+// bytes) is the densest encoding. Bounds a corrupt chunk before allocating.
+constexpr uint64_t kMaxLzExpansion = 255;
+constexpr uint64_t kMaxLzOverhead = 64; // a block's first token and offsets
+
+static_assert(std::is_trivially_copyable_v<render::Camera>, "Camera is saved as bytes");
+static_assert(std::is_trivially_copyable_v<render::Light>, "Light is saved as bytes");
+
+size_t padded(size_t n) { return (n + kChunkAlignment - 1) & ~size_t(kChunkAlignment - 1); }
+
+/// A chunk found in the file, its records ready to read: in the mapping
+/// (chunk data starts kChunkAlignment aligned) or in an unpacked buffer.
+struct Loaded {
+  const SaveChunk* header = nullptr;
+  const uint8_t* data = nullptr;
+  size_t rawSize = 0;
+};
+
+} // namespace
+
+void SaveSystem::init(const SaveTargets& targets, bool compress) {
+  m_targets = targets;
+  m_compress = compress;
+  m_stop = false;
+  m_writer = std::thread([this] { writerLoop(); });
+}
+
+void SaveSystem::shutdown() {
+  if (!m_writer.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_one();
+  m_writer.join();
+  m_queue.clear();
+  m_done.clear();
+  m_finished.clear();
+  m_targets = SaveTargets{};
+}
+
+void SaveSystem::addChunk(Job& job, uint32_t id, uint32_t elementSize, uint32_t elementCount, const void* data) {
+  Chunk& c = job.chunks.emplace_back();
+  c.header.id = id;
+  c.header.version = recordVersion(id);
+  c.header.elementSize = elementSize;
+  c.header.elementCount = elementCount;
+  const size_t size = (size_t)elementSize * elementCount;
+  c.bytes.resize(size);
+  if (size) std::memcpy(c.bytes.data(), data, size);
+}
+
+SaveId SaveSystem::save(const char* path, const void* scriptData, size_t scriptSize) {
+  if (!m_writer.joinable() || !path || !path[0]) return kInvalidSave;
+  const Clock::time_point t0 = Clock::now();
+
+  Job job;
+  job.id = m_nextId++;
+  job.path = path;
+  job.chunks.reserve(7);
+  if (const render::Camera* camera = m_targets.camera) {
+    addChunk(job, kChunkCamera, sizeof(render::Camera), 1, camera);
+  }
+  if (const render::LightList* lights = m_targets.lights) {
+    const uint32_t n = lights->slotCount();
+    addChunk(job, kChunkLights, sizeof(render::Light), n, lights->slots());
+    Chunk& alive = job.chunks.emplace_back();
+    alive.header = { kChunkLightAlive, recordVersion(kChunkLightAlive), 0, 1, n };
+    alive.bytes.resize(n);
+    for (uint32_t i = 0; i < n; ++i) alive.bytes[i] = lights->alive(i) ? 1 : 0;
+  }
+  if (const physics::PhysicsWorld* world = m_targets.physics) {
+    std::vector<physics::BodyState> bodies;
+    world->saveState(bodies);
+    addChunk(job, kChunkBodies, sizeof(physics::BodyState), (uint32_t)bodies.size(), bodies.data());
+  }
+  if (const physics::TriggerSystem* triggers = m_targets.triggers) {
+    std::vector<physics::TriggerState> volumes;
+    std::vector<physics::ActorState> actors;
+    triggers->saveState(volumes, actors);
+    addChunk(job, kChunkTriggers, sizeof(physics::TriggerState), (uint32_t)volumes.size(), volumes.data());
+    addChunk(job, kChunkActors, sizeof(physics::ActorState), (uint32_t)actors.size(), actors.data());
+  }
+  addChunk(job, kChunkScript, 1, (uint32_t)scriptSize, scriptData);
+  m_lastCaptureMs = msSince(t0);
+
+  const SaveId id = job.id;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.push_back(std::move(job));
+  }
+  m_wake.notify_one();
+  return id;
+}
+
+void SaveSystem::writerLoop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+    m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+    if (m_queue.empty()) break; // stopping, and everything queued is written
+    Job job = std::move(m_queue.front());
+    m_queue.pop_front();
+    m_writing = true;
+    lock.unlock();
+
+    SaveResult result;
+    result.id = job.id;
+    std::string error;
+    const Clock::time_point t0 = Clock::now();
+    result.ok = write(job, result, error);
+    result.writeMs = msSince(t0);
+    if (!result.ok) core::logError(core::LogCategory::Save, "Save: %s: %s", job.path.c_str(), error.c_str());
+
+    lock.lock();
+    m_writing = false;
+    m_done.push_back(result);
+    m_idle.notify_all();
+  }
+}
+
+bool SaveSystem::write(Job& job, SaveResult& result, std::string& error) const {
+  std::vector<uint8_t> packed;
+  for (Chunk& c : job.chunks) {
+    if (!m_compress || c.bytes.size() < kMinCompressBytes) continue;
+    packed.clear();
+    lzCompress(c.bytes.data(), c.bytes.size(), packed);
+    if (packed.size() >= c.bytes.size()) continue;
+    c.bytes.swap(packed);
+    c.header.flags |= kChunkCompressed;
+  }
+
+  const std::string tmp = job.path + ".tmp";
+  {
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f) {
+      error = "cannot create " + tmp;
+      return false;
+    }
+    SaveHeader header;
+    header.chunkCount = (uint32_t)job.chunks.size();
+    f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    result.bytes = sizeof(header);
+    static const char kZeros[kChunkAlignment] = {};
+    for (Chunk& c : job.chunks) {
+      c.header.storedSize = c.bytes.size();
+      f.write(reinterpret_cast<const char*>(&c.header), sizeof(c.header));
+      f.write(reinterpret_cast<const char*>(c.bytes.data()), (std::streamsize)c.bytes.size());
+      f.write(kZeros, (std::streamsize)(padded(c.bytes.size()) - c.bytes.size()));
+      result.bytes += sizeof(c.header) + padded(c.bytes.size());
+    }
+    if (!f.flush()) {
+      error = "write failed";
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp, job.path, ec);
+  if (ec) {
+    error = "cannot replace the file: " + ec.message();
+    return false;
+  }
+  return true;
+}
+
+void SaveSystem::waitIdle() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this] { return m_queue.empty() && !m_writing; });
+}
+
+void SaveSystem::update() {
+  m_finished.clear();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finished.swap(m_done);
+  }
+  for (const SaveResult& r : m_finished) {
+    if (r.ok) core::logInfo(core::LogCategory::Save, "Saved snapshot %u (%.1f KB, %.2f ms on the writer)", r.id,
+                            r.bytes / 1024.0, r.writeMs);
+  }
+}
+
+bool SaveSystem::load(const char* path, std::vector<uint8_t>& scriptData) {
+  if (m_writer.joinable()) waitIdle(); // the file may still be on its way
+
+  core::MappedFile file;
+  if (!file.open(path)) {
+    core::logError(core::LogCategory::Save, "Save: cannot open %s", path);
+    return false;
+  }
+  const Clock::time_point t0 = Clock::now();
+  const uint8_t* base = file.data();
+  const size_t size = file.size();
+  SaveHeader header;
+  if (size < sizeof(header)) {
+    core::logError(core::LogCategory::Save, "Save: %s is truncated", path);
+    return false;
+  }
+  std::memcpy(&header, base, sizeof(header));
+  if (std::memcmp(header.magic, "BSAV", 4) != 0 || header.version != kSaveVersion) {
+    core::logError(core::LogCategory::Save, "Save: %s is not a version %u snapshot", path, kSaveVersion);
+    return false;
+  }
+
+  // Parse and unpack everything before touching the world.
+  std::unordered_map<uint32_t, Loaded> chunks;
+  std::vector<std::vector<uint8_t>> unpacked;
+  if (header.chunkCount > (size - sizeof(header)) / sizeof(SaveChunk)) {
+    core::logError(core::LogCategory::Save, "Save: %s is truncated", path);
+    return false;
+  }
+  unpacked.reserve(header.chunkCount);
+  size_t offset = sizeof(header);
+  for (uint32_t i = 0; i < header.chunkCount; ++i) {
+    if (size - offset < sizeof(SaveChunk)) {
+      core::logError(core::LogCategory::Save, "Save: %s is truncated", path);
+      return false;
+    }
+    const SaveChunk* c = reinterpret_cast<const SaveChunk*>(base + offset);
+    offset += sizeof(SaveChunk);
+    if (c->storedSize > size - offset) {
+      core::logError(core::LogCategory::Save, "Save: %s is truncated", path);
+      return false;
+    }
+    Loaded l{ c, base + offset, (size_t)c->storedSize };
+    offset += (size_t)std::min<uint64_t>(padded((size_t)c->storedSize), size - offset);
+
+    const uint64_t rawSize64 = (uint64_t)c->elementSize * c->elementCount;
+    const uint64_t maxRawSize =
+        (c->flags & kChunkCompressed) ? c->storedSize * kMaxLzExpansion + kMaxLzOverhead : c->storedSize;
+    if (rawSize64 > maxRawSize || rawSize64 > SIZE_MAX) {
+      core::logError(core::LogCategory::Save, "Save: %s has a corrupt chunk", path);
+      return false;
+    }
+    const size_t rawSize = (size_t)rawSize64;
+    if (c->flags & kChunkCompressed) {
+      std::vector<uint8_t>& raw = unpacked.emplace_back(rawSize);
+      if (!lzDecompress(l.data, l.rawSize, raw.data(), rawSize)) {
+        core::logError(core::LogCategory::Save, "Save: %s has a corrupt chunk", path);
+        return false;
+      }
+      l.data = raw.data();
+      l.rawSize = rawSize;
+    } else if (l.rawSize != rawSize) {
+      core::logError(core::LogCategory::Save, "Save: %s has a corrupt chunk", path);
+      return false;
+    }
+    chunks[c->id] = l;
+  }
+
+  // A chunk counts only if its records still have the layout we read.
+  auto find = [&](uint32_t id, size_t elementSize) -> const Loaded* {
+    auto it = chunks.find(id);
+    if (it == chunks.end()) return nullptr;
+    const SaveChunk& c = *it->second.header;
+    if (c.version != recordVersion(id) || c.elementSize != elementSize) {
+      core::logWarn(core::LogCategory::Save, "Save: skipping an outdated chunk in %s", path);
+      return nullptr;
+    }
+    return &it->second;
+  };
+
+  if (const Loaded* camera = find(kChunkCamera, sizeof(render::Camera)); camera && m_targets.camera &&
+                                                                        camera->header->elementCount == 1) {
+    std::memcpy(m_targets.camera, camera->data, sizeof(render::Camera));
+  }
+  if (render::LightList* lights = m_targets.lights) {
+    const Loaded* slots = find(kChunkLights, sizeof(render::Light));
+    const Loaded* alive = find(kChunkLightAlive, 1);
+    if (slots && alive && slots->header->elementCount == alive->header->elementCount) {
+      lights->restore(reinterpret_cast<const render::Light*>(slots->data), alive->data, slots->header->elementCount);
+    }
+  }
+  if (physics::PhysicsWorld* world = m_targets.physics) {
+    if (const Loaded* bodies = find(kChunkBodies, sizeof(physics::BodyState))) {
+      world->loadState(reinterpret_cast<const physics::BodyState*>(bodies->data), bodies->header->elementCount);
+    }
+  }
+  if (physics::TriggerSystem* triggers = m_targets.triggers) {
+    const Loaded* volumes = find(kChunkTriggers, sizeof(physics::TriggerState));
+    const Loaded* actors = find(kChunkActors, sizeof(physics::ActorState));
+    if (volumes && actors) {
+      triggers->loadState(reinterpret_cast<const physics::TriggerState*>(volumes->data),
+                          volumes->header->elementCount,
+                          reinterpret_cast<const physics::ActorState*>(actors->data), actors->header->elementCount);
+    }
+  }
+  const Loaded* script = find(kChunkScript, 1);
+  scriptData.assign(script ? script->data : nullptr, script ? script->data + script->rawSize : nullptr);
+
+  core::logInfo(core::LogCategory::Save, "Loaded %s (%.2f ms)", path, msSince(t0));
+  return true;
+}
+
+} // namespace save
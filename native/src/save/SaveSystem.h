@@ -0,0 +1,102 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SaveFormat.h"
+
+namespace render { struct Camera; class LightList; }
+namespace physics { class PhysicsWorld; class TriggerSystem; }
+
+namespace save {
+
+/// The systems a snapshot covers; null ones are left out.
+struct SaveTargets {
+  render::Camera* camera = nullptr;
+  render::LightList* lights = nullptr;
+  physics::PhysicsWorld* physics = nullptr;
+  physics::TriggerSystem* triggers = nullptr;
+};
+
+using SaveId = uint32_t;
+constexpr SaveId kInvalidSave = UINT32_MAX;
+
+/// A save that finished during the last update().
+struct SaveResult {
+  SaveId id = kInvalidSave;
+  bool ok = false;
+  uint64_t bytes = 0; // file size
+  double writeMs = 0; // compression + I/O on the writer thread
+};
+
+/// Quicksave and quickload of the native world state (SaveFormat.h).
+///
+/// save() copies every target's slot arrays into chunk buffers on the
+/// calling thread and returns; that copy is the only work the frame pays
+/// for, and later changes to the world do not reach the snapshot. A writer
+/// thread then compresses the chunks, writes `path`.tmp and renames it over
+/// `path`, so an interrupted save leaves the previous file intact.
+///
+/// load() waits for queued writes, maps the file, checks every chunk and
+/// only then restores: uncompressed chunks straight from the mapping,
+/// compressed ones through one scratch buffer.
+///
+/// Not thread safe: call everything from the main thread.
+class SaveSystem {
+public:
+  void init(const SaveTargets& targets, bool compress = true);
+  /// Finishes queued saves.
+  void shutdown();
+
+  /// Queues a snapshot with `scriptData` (opaque to the engine) stored
+  /// alongside. kInvalidSave before init().
+  SaveId save(const char* path, const void* scriptData, size_t scriptSize);
+
+  /// Restores the targets; `scriptData` receives what save() was given.
+  /// False with a message logged, and nothing changed, if the file is
+  /// missing or malformed.
+  bool load(const char* path, std::vector<uint8_t>& scriptData);
+
+  /// Collects finished saves. Once per frame.
+  void update();
+
+  const std::vector<SaveResult>& finished() const { return m_finished; }
+  double lastCaptureMs() const { return m_lastCaptureMs; }
+
+private:
+  struct Chunk {
+    SaveChunk header;
+    std::vector<uint8_t> bytes; // raw records, compressed by the writer
+  };
+
+  struct Job {
+    SaveId id = kInvalidSave;
+    std::string path;
+    std::vector<Chunk> chunks;
+  };
+
+  void addChunk(Job& job, uint32_t id, uint32_t elementSize, uint32_t elementCount, const void* data);
+  void writerLoop();
+  bool write(Job& job, SaveResult& result, std::string& error) const;
+  void waitIdle();
+
+  SaveTargets m_targets;
+  bool m_compress = true;
+  SaveId m_nextId = 0;
+  double m_lastCaptureMs = 0.0;
+
+  std::thread m_writer;
+  std::mutex m_mutex;
+  std::condition_variable m_wake, m_idle;
+  std::deque<Job> m_queue;   // guarded by m_mutex
+  bool m_writing = false;    // guarded by m_mutex
+  bool m_stop = false;       // guarded by m_mutex
+  std::vector<SaveResult> m_done;     // guarded by m_mutex; for the next update()
+  std::vector<SaveResult> m_finished; // reported by the last update()
+};
+
+} // namespace save
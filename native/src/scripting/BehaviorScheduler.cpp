@@ -0,0 +1,311 @@
+#include "BehaviorScheduler.h"
+#include "ScriptProfiler.h"
+#include "../core/Log.h"
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace scripting {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+PyObject* asObj(void* p) { return reinterpret_cast<PyObject*>(p); }
+
+enum Buffer { kIds, kPositions, kState, kDt };
+
+constexpr double kGolden = 0.6180339887498949;
+
+// Phase of the n-th entity within its behavior's period, in [0, 1).
+double phaseOf(uint32_t n) {
+  double whole = 0.0;
+  return std::modf((double)n * kGolden, &whole);
+}
+
+// The first `count` items of a bytearray as a flat memoryview of `format`.
+PyObject* makeView(PyObject* bytes, const char* format, Py_ssize_t count) {
+  PyObject* raw = PyMemoryView_FromObject(bytes);
+  PyObject* typed = raw ? PyObject_CallMethod(raw, "cast", "s", format) : nullptr;
+  PyObject* view = typed ? PySequence_GetSlice(typed, 0, count) : nullptr;
+  Py_XDECREF(typed);
+  Py_XDECREF(raw);
+  return view;
+}
+
+} // namespace
+
+BehaviorId BehaviorScheduler::findBehavior(const std::string& name) const {
+  for (size_t i = 0; i < m_behaviors.size(); ++i) {
+    if (m_behaviors[i].name == name) return (BehaviorId)i;
+  }
+  return kInvalidBehavior;
+}
+
+BehaviorId BehaviorScheduler::registerBehavior(const std::string& name, void* fn, const BehaviorDesc& desc) {
+  BehaviorId id = findBehavior(name);
+  if (id == kInvalidBehavior) {
+    id = (BehaviorId)m_behaviors.size();
+    m_behaviors.emplace_back();
+    m_behaviors.back().name = name;
+  }
+  Behavior& b = m_behaviors[id];
+
+  Py_INCREF(asObj(fn));
+  Py_XDECREF(asObj(b.fn));
+  b.fn = fn;
+
+  const size_t n = b.ids.size();
+  if (desc.stateFloats != b.desc.stateFloats) {
+    decltype(b.state) state((size_t)desc.stateFloats * n, 0.0f);
+    const uint32_t keep = std::min(desc.stateFloats, b.desc.stateFloats);
+    for (size_t i = 0; i < n && keep > 0; ++i) {
+      std::memcpy(&state[i * desc.stateFloats], &b.state[i * b.desc.stateFloats], keep * sizeof(float));
+    }
+    b.state.swap(state);
+  }
+  if (desc.hz != b.desc.hz) {
+    // Spread again over the new period rather than wait out the old one.
+    const double period = desc.hz > 0.0f ? 1.0 / desc.hz : 0.0;
+    for (size_t i = 0; i < n; ++i) b.nextTick[i] = m_time + phaseOf((uint32_t)i) * period;
+  }
+  b.desc = desc;
+  return id;
+}
+
+EntityId BehaviorScheduler::spawn(BehaviorId behavior, render::Vec3 position) {
+  if (behavior >= m_behaviors.size()) return kInvalidEntity;
+
+  EntityId id;
+  if (!m_free.empty()) {
+    id = m_free.back();
+    m_free.pop_back();
+  } else {
+    id = (EntityId)m_slots.size();
+    m_slots.emplace_back();
+  }
+
+  Behavior& b = m_behaviors[behavior];
+  Slot& s = m_slots[id];
+  s.behavior = behavior;
+  s.index = (uint32_t)b.ids.size();
+  s.alive = true;
+
+  const double period = b.desc.hz > 0.0f ? 1.0 / b.desc.hz : 0.0;
+  b.ids.push_back(id);
+  b.positions.insert(b.positions.end(), { position.x, position.y, position.z });
+  b.state.resize(b.state.size() + b.desc.stateFloats, 0.0f);
+  b.lastTick.push_back(m_time);
+  b.nextTick.push_back(m_time + phaseOf(b.spawned++) * period);
+  b.dormant.push_back(0);
+  return id;
+}
+
+void BehaviorScheduler::removeAt(Behavior& b, uint32_t index) {
+  const uint32_t last = (uint32_t)b.ids.size() - 1;
+  const uint32_t k = b.desc.stateFloats;
+  if (index != last) {
+    b.ids[index] = b.ids[last];
+    std::memcpy(&b.positions[3 * (size_t)index], &b.positions[3 * (size_t)last], 3 * sizeof(float));
+    if (k > 0) std::memcpy(&b.state[(size_t)k * index], &b.state[(size_t)k * last], k * sizeof(float));
+    b.lastTick[index] = b.lastTick[last];
+    b.nextTick[index] = b.nextTick[last];
+    b.dormant[index] = b.dormant[last];
+    m_slots[b.ids[index]].index = index;
+  }
+  b.ids.pop_back();
+  b.positions.resize(b.positions.size() - 3);
+  b.state.resize(b.state.size() - k);
+  b.lastTick.pop_back();
+  b.nextTick.pop_back();
+  b.dormant.pop_back();
+}
+
+void BehaviorScheduler::despawn(EntityId id) {
+  if (!valid(id)) return;
+  Slot& s = m_slots[id];
+  s.alive = false;
+  if (m_ticking) {
+    m_despawned.push_back(id); // the running behavior may still index it
+    return;
+  }
+  removeAt(m_behaviors[s.behavior], s.index);
+  s.behavior = kInvalidBehavior;
+  m_free.push_back(id);
+}
+
+void BehaviorScheduler::setPosition(EntityId id, render::Vec3 position) {
+  if (!valid(id)) return;
+  const Slot& s = m_slots[id];
+  float* p = &m_behaviors[s.behavior].positions[3 * (size_t)s.index];
+  p[0] = position.x;
+  p[1] = position.y;
+  p[2] = position.z;
+}
+
+bool BehaviorScheduler::position(EntityId id, render::Vec3& out) const {
+  if (!valid(id)) return false;
+  const Slot& s = m_slots[id];
+  const float* p = &m_behaviors[s.behavior].positions[3 * (size_t)s.index];
+  out = { p[0], p[1], p[2] };
+  return true;
+}
+
+void BehaviorScheduler::setDormant(EntityId id, bool dormant) {
+  if (!valid(id)) return;
+  const Slot& s = m_slots[id];
+  m_behaviors[s.behavior].dormant[s.index] = dormant ? 1 : 0;
+}
+
+char* BehaviorScheduler::gatherBuffer(int which, size_t bytes) {
+  PyObject* b = asObj(m_buffers[which]);
+  if (b && (size_t)PyByteArray_GET_SIZE(b) >= bytes) return PyByteArray_AS_STRING(b);
+
+  const size_t size = std::max<size_t>({ bytes, b ? 2 * (size_t)PyByteArray_GET_SIZE(b) : 0, 256 });
+  if (b && PyByteArray_Resize(b, (Py_ssize_t)size) == 0) return PyByteArray_AS_STRING(b);
+
+  // A view the script kept pins the old one; leave it to that view.
+  PyErr_Clear();
+  Py_XDECREF(b);
+  b = PyByteArray_FromStringAndSize(nullptr, (Py_ssize_t)size);
+  m_buffers[which] = b;
+  return b ? PyByteArray_AS_STRING(b) : nullptr;
+}
+
+void BehaviorScheduler::runBehavior(BehaviorId id, render::Vec3 focus, ScriptProfiler* profiler) {
+  Behavior& b = m_behaviors[id];
+  if (!b.fn) return;
+
+  const double period = b.desc.hz > 0.0f ? 1.0 / b.desc.hz : 0.0;
+  const float r2 = b.desc.activeRadius * b.desc.activeRadius;
+  m_due.clear();
+  for (uint32_t i = 0; i < (uint32_t)b.ids.size(); ++i) {
+    if (!m_slots[b.ids[i]].alive) continue; // despawned earlier this tick
+    if (period > 0.0) {
+      if (b.nextTick[i] > m_time) continue;
+      // Next boundary on this entity's phase; a long frame skips ticks
+      // instead of running them back to back.
+      b.nextTick[i] += period * (std::floor((m_time - b.nextTick[i]) / period) + 1.0);
+    }
+    const float* p = &b.positions[3 * (size_t)i];
+    const float dx = p[0] - focus.x, dy = p[1] - focus.y, dz = p[2] - focus.z;
+    if (b.dormant[i] || (r2 > 0.0f && dx * dx + dy * dy + dz * dz > r2)) {
+      b.lastTick[i] = m_time;
+      m_stats.skipped++;
+      continue;
+    }
+    m_due.push_back(i);
+  }
+  if (m_due.empty()) return;
+
+  const uint32_t n = (uint32_t)m_due.size();
+  const uint32_t k = b.desc.stateFloats;
+  char* ids = gatherBuffer(kIds, (size_t)n * sizeof(uint32_t));
+  char* positions = gatherBuffer(kPositions, (size_t)n * 3 * sizeof(float));
+  char* state = gatherBuffer(kState, (size_t)n * k * sizeof(float));
+  char* dts = gatherBuffer(kDt, (size_t)n * sizeof(float));
+  if (!ids || !positions || !state || !dts) {
+    PyErr_Print();
+    return;
+  }
+  for (uint32_t j = 0; j < n; ++j) {
+    const uint32_t i = m_due[j];
+    const float dt = (float)(m_time - b.lastTick[i]);
+    b.lastTick[i] = m_time;
+    std::memcpy(ids + (size_t)j * sizeof(uint32_t), &b.ids[i], sizeof(uint32_t));
+    std::memcpy(positions + (size_t)j * 3 * sizeof(float), &b.positions[3 * (size_t)i], 3 * sizeof(float));
+    if (k > 0) std::memcpy(state + (size_t)j * k * sizeof(float), &b.state[(size_t)k * i], k * sizeof(float));
+    std::memcpy(dts + (size_t)j * sizeof(float), &dt, sizeof(float));
+  }
+
+  // The call may register behaviors or spawn entities (arrays grow, `b`
+  // dangles) or despawn them (deferred, indices hold).
+  PyObject* fn = asObj(b.fn);
+  Py_INCREF(fn);
+  if (profiler) profiler->beginScope("behavior", b.name.c_str());
+  PyObject* args[4] = {
+    makeView(asObj(m_buffers[kIds]), "I", n),
+    makeView(asObj(m_buffers[kPositions]), "f", (Py_ssize_t)n * 3),
+    makeView(asObj(m_buffers[kState]), "f", (Py_ssize_t)n * k),
+    makeView(asObj(m_buffers[kDt]), "f", n),
+  };
+  PyObject* res = (args[0] && args[1] && args[2] && args[3]) ? PyObject_Vectorcall(fn, args, 4, nullptr) : nullptr;
+  if (profiler) profiler->endScope();
+  if (!res) {
+    core::logError(core::LogCategory::Script, "Behavior '%s' failed:", m_behaviors[id].name);
+    PyErr_Print();
+  } else {
+    Py_DECREF(res);
+  }
+  for (PyObject* v : args) {
+    if (!v) continue;
+    PyObject* r = PyObject_CallMethod(v, "release", nullptr); // fails if the script re-exported it
+    if (!r) PyErr_Clear();
+    Py_XDECREF(r);
+    Py_DECREF(v);
+  }
+  Py_DECREF(fn);
+  m_stats.calls++;
+  m_stats.ticked += n;
+
+  // Copy back what the script wrote, also after an exception.
+  Behavior& after = m_behaviors[id];
+  const bool sameState = after.desc.stateFloats == k; // unless re-registered meanwhile
+  for (uint32_t j = 0; j < n; ++j) {
+    const uint32_t i = m_due[j];
+    std::memcpy(&after.positions[3 * (size_t)i], positions + (size_t)j * 3 * sizeof(float), 3 * sizeof(float));
+    if (k > 0 && sameState) {
+      std::memcpy(&after.state[(size_t)k * i], state + (size_t)j * k * sizeof(float), k * sizeof(float));
+    }
+  }
+}
+
+void BehaviorScheduler::tick(double dt, render::Vec3 focus, ScriptProfiler* profiler) {
+  const Clock::time_point t0 = Clock::now();
+  m_time += dt;
+  m_stats.calls = 0;
+  m_stats.ticked = 0;
+  m_stats.skipped = 0;
+
+  m_ticking = true;
+  for (BehaviorId id = 0; id < (BehaviorId)m_behaviors.size(); ++id) runBehavior(id, focus, profiler);
+  m_ticking = false;
+
+  for (EntityId e : m_despawned) {
+    Slot& s = m_slots[e];
+    removeAt(m_behaviors[s.behavior], s.index);
+    s.behavior = kInvalidBehavior;
+    m_free.push_back(e);
+  }
+  m_despawned.clear();
+
+  m_stats.behaviors = (uint32_t)m_behaviors.size();
+  m_stats.entities = (uint32_t)(m_slots.size() - m_free.size());
+  m_stats.tickMs = msSince(t0);
+}
+
+void BehaviorScheduler::clear() {
+  for (Behavior& b : m_behaviors) Py_XDECREF(asObj(b.fn));
+  for (void*& buffer : m_buffers) {
+    Py_XDECREF(asObj(buffer));
+    buffer = nullptr;
+  }
+  m_behaviors.clear();
+  m_slots.clear();
+  m_free.clear();
+  m_despawned.clear();
+  m_due.clear();
+  m_time = 0.0;
+  m_stats = {};
+}
+
+} // namespace scripting
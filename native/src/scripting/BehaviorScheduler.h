@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+#include "../render/RenderMath.h"
+
+namespace scripting {
+
+class ScriptProfiler;
+
+using BehaviorId = uint32_t;
+using EntityId = uint32_t;
+constexpr BehaviorId kInvalidBehavior = UINT32_MAX;
+constexpr EntityId kInvalidEntity = UINT32_MAX;
+
+struct BehaviorDesc {
+  float hz = 0.0f;           // ticks per second per entity; 0 = every frame
+  float activeRadius = 0.0f; // skip entities farther from the focus; 0 = no limit
+  uint32_t stateFloats = 0;  // per-entity floats owned by the script
+};
+
+struct BehaviorSchedulerStats {
+  uint32_t behaviors = 0;
+  uint32_t entities = 0;
+  uint32_t calls = 0;   // Python calls made by the last tick()
+  uint32_t ticked = 0;  // entities handed to them
+  uint32_t skipped = 0; // due but dormant or out of range
+  double tickMs = 0;    // whole tick(), script time included
+};
+
+/// Runs script behaviors over entities in batches.
+///
+/// A behavior is a Python callable registered under a name; every entity
+/// belongs to one behavior. tick() calls each behavior at most once, as
+///   fn(ids, positions, state, dt)
+/// with flat memoryviews over the entities due this frame: ids ('I', n),
+/// positions ('f', 3n, writable), state ('f', stateFloats * n, writable) and
+/// dt ('f', n, seconds since that entity's previous tick). What the script
+/// writes into positions and state is kept. The views are released when the
+/// call returns; they are backed by bytearrays, so one kept past that (say
+/// by numpy.frombuffer) sees stale data but never freed memory.
+///
+/// With hz > 0 each entity is due every 1/hz seconds, phases spread over the
+/// period (golden ratio sequence): 600 entities at 10 Hz on a 60 Hz frame
+/// hand about 100 to the script every frame instead of 600 every sixth.
+/// A due entity that is dormant or farther than activeRadius from the focus
+/// point is skipped; it keeps its phase and comes back with a normal dt.
+///
+/// Entities despawned during a tick leave their arrays after it; inside a
+/// behavior, move its own entities through the views (setPosition() on a
+/// due entity would be overwritten when the views are copied back).
+///
+/// Holds Python references: clear() before Py_Finalize(). Main thread only.
+class BehaviorScheduler {
+public:
+  /// Same name again replaces the callable and settings, entities stay (state
+  /// is kept up to the new size). Borrowed `fn` (PyObject*).
+  BehaviorId registerBehavior(const std::string& name, void* fn, const BehaviorDesc& desc);
+  BehaviorId findBehavior(const std::string& name) const;
+
+  EntityId spawn(BehaviorId behavior, render::Vec3 position);
+  void despawn(EntityId id);
+  bool valid(EntityId id) const { return id < m_slots.size() && m_slots[id].alive; }
+
+  void setPosition(EntityId id, render::Vec3 position);
+  bool position(EntityId id, render::Vec3& out) const;
+  void setDormant(EntityId id, bool dormant);
+
+  /// Once per frame. `focus` is where the player is (activeRadius centre).
+  void tick(double dt, render::Vec3 focus, ScriptProfiler* profiler);
+
+  /// Drops every behavior and entity.
+  void clear();
+
+  const BehaviorSchedulerStats& stats() const { return m_stats; }
+
+private:
+  struct Behavior {
+    std::string name;
+    void* fn = nullptr; // PyObject*, owned
+    BehaviorDesc desc;
+    uint32_t spawned = 0; // phase sequence
+
+    // Entities, structure of arrays; index = position in these.
+    memory::TrackedVector<EntityId, memory::MemTag::Scripting> ids;
+    memory::TrackedVector<float, memory::MemTag::Scripting> positions; // xyz
+    memory::TrackedVector<float, memory::MemTag::Scripting> state;     // desc.stateFloats each
+    memory::TrackedVector<double, memory::MemTag::Scripting> lastTick;
+    memory::TrackedVector<double, memory::MemTag::Scripting> nextTick;
+    memory::TrackedVector<uint8_t, memory::MemTag::Scripting> dormant;
+  };
+
+  struct Slot {
+    BehaviorId behavior = kInvalidBehavior;
+    uint32_t index = 0;
+    bool alive = false;
+  };
+
+  void removeAt(Behavior& b, uint32_t index);
+  void runBehavior(BehaviorId id, render::Vec3 focus, ScriptProfiler* profiler);
+  char* gatherBuffer(int which, size_t bytes);
+
+  memory::TrackedVector<Behavior, memory::MemTag::Scripting> m_behaviors;
+  memory::TrackedVector<Slot, memory::MemTag::Scripting> m_slots;
+  memory::TrackedVector<EntityId, memory::MemTag::Scripting> m_free;
+  memory::TrackedVector<EntityId, memory::MemTag::Scripting> m_despawned; // during a tick, removed after it
+  bool m_ticking = false;
+  double m_time = 0.0;
+
+  // Gathered due entities of the behavior being run, as bytearrays
+  // (PyObject*): ids, positions, state, dt.
+  static constexpr int kBufferCount = 4;
+  void* m_buffers[kBufferCount] = {};
+  memory::TrackedVector<uint32_t, memory::MemTag::Scripting> m_due; // their indices in the behavior arrays
+
+  BehaviorSchedulerStats m_stats;
+};
+
+} // namespace scripting
@@ -1,39 +1,177 @@
 #include "EngineModule.h"
 #include "../input/InputState.h"
+#include "../render/Camera.h"
+#include "../render/Lights.h"
+#include "../render/ParticleSystem.h"
+#include "../render/Decals.h"
+#include "../render/StaticWorld.h"
+#include "../render/PostProcess.h"
+#include "../render/DynamicResolution.h"
+#include "../render/ShadowAtlas.h"
+#include "../render/WorldGeometry.h"
+#include "../nav/NavSystem.h"
+#include "../physics/TriggerSystem.h"
+#include "../save/SaveSystem.h"
+#include "../audio/AudioSystem.h"
+#include "BehaviorScheduler.h"
+#include "../core/JobSystem.h"
+#include "../core/Log.h"
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
-#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
 #include <cstring>
+#include <string>
 
 namespace scripting {
 
-static EngineContext g_ctx{};
+// ------------------- module state -------------------
+// The engine pointers live in the module object (multi-phase init), not in
+// a process global, so every interpreter that imports "engine" gets its own
+// copy. SetEngineContext() runs before the interpreter exists; the exec slot
+// copies the context in.
+struct EngineState {
+  EngineContext ctx;
+};
+
+static EngineContext g_initialCtx{};
+
+void SetEngineContext(const EngineContext& ctx) { g_initialCtx = ctx; }
+
+#if defined(Py_GIL_DISABLED)
+// Free-threaded builds have no GIL serializing script threads, and the
+// engine objects behind the context are not thread-safe. PyMutex detaches
+// the thread state while it waits, so a blocked caller never holds up a
+// stop-the-world collection.
+static PyMutex g_engineLock{};
+#endif
+
+/// One engine.* call's access to the engine: the module's context, held
+/// under the engine lock on free-threaded builds. Take it after parsing the
+/// arguments (conversions may run Python code that calls engine.* again).
+class EngineCall {
+public:
+  explicit EngineCall(PyObject* module) : m_ctx(static_cast<EngineState*>(PyModule_GetState(module))->ctx) {
+#if defined(Py_GIL_DISABLED)
+    PyMutex_Lock(&g_engineLock);
+#endif
+  }
+  ~EngineCall() {
+#if defined(Py_GIL_DISABLED)
+    PyMutex_Unlock(&g_engineLock);
+#endif
+  }
+  EngineCall(const EngineCall&) = delete;
+  EngineCall& operator=(const EngineCall&) = delete;
+
+  const EngineContext* operator->() const { return &m_ctx; }
+  const EngineContext& operator*() const { return m_ctx; }
+
+private:
+  const EngineContext& m_ctx;
+};
+
+// ------------------- argument parsing -------------------
+// METH_FASTCALL passes positional arguments as a C array: no argument tuple
+// per call and no format string to interpret. The conversions follow the
+// PyArg_ParseTuple codes they replace: f, i, p, s and y*.
+static bool ParseArg(PyObject* o, float* out) {
+  const double v = PyFloat_CheckExact(o) ? PyFloat_AS_DOUBLE(o) : PyFloat_AsDouble(o);
+  if (v == -1.0 && PyErr_Occurred()) return false;
+  *out = (float)v;
+  return true;
+}
+
+static bool ParseArg(PyObject* o, int* out) {
+  const long v = PyLong_AsLong(o);
+  if (v == -1 && PyErr_Occurred()) return false;
+  if (v < INT_MIN || v > INT_MAX) {
+    PyErr_SetString(PyExc_OverflowError, "Python int too large to convert to C int");
+    return false;
+  }
+  *out = (int)v;
+  return true;
+}
+
+static bool ParseArg(PyObject* o, bool* out) {
+  const int v = PyObject_IsTrue(o);
+  if (v < 0) return false;
+  *out = v != 0;
+  return true;
+}
 
-void SetEngineContext(const EngineContext& ctx) { g_ctx = ctx; }
+static bool ParseArg(PyObject* o, const char** out) {
+  if (!PyUnicode_Check(o)) {
+    PyErr_Format(PyExc_TypeError, "expected str, not %.100s", Py_TYPE(o)->tp_name);
+    return false;
+  }
+  Py_ssize_t n = 0;
+  const char* s = PyUnicode_AsUTF8AndSize(o, &n);
+  if (!s) return false;
+  if ((size_t)n != std::strlen(s)) {
+    PyErr_SetString(PyExc_ValueError, "embedded null character");
+    return false;
+  }
+  *out = s;
+  return true;
+}
+
+// Any object, borrowed.
+static bool ParseArg(PyObject* o, PyObject** out) {
+  *out = o;
+  return true;
+}
+
+// Released by the caller once view->obj is set.
+static bool ParseArg(PyObject* o, Py_buffer* view) {
+  return PyObject_GetBuffer(o, view, PyBUF_SIMPLE) == 0;
+}
+
+/// Converts args[i] into *out for each given argument; the first `required`
+/// must be there, the rest keep their defaults.
+template <class... T>
+static bool ParseArgs(const char* fn, PyObject* const* args, Py_ssize_t nargs, Py_ssize_t required, T*... out) {
+  constexpr Py_ssize_t kMax = (Py_ssize_t)sizeof...(T);
+  if (nargs < required || nargs > kMax) {
+    if (required == kMax) {
+      PyErr_Format(PyExc_TypeError, "%s() takes exactly %zd argument%s (%zd given)", fn, kMax,
+                   kMax == 1 ? "" : "s", nargs);
+    } else {
+      PyErr_Format(PyExc_TypeError, "%s() takes from %zd to %zd arguments (%zd given)", fn, required, kMax, nargs);
+    }
+    return false;
+  }
+  Py_ssize_t i = 0;
+  return (... && (i >= nargs || ParseArg(args[i++], out)));
+}
 
 // ------------------- helpers -------------------
-static PyObject* py_log(PyObject*, PyObject* args) {
+static PyObject* py_log(PyObject*, PyObject* const* args, Py_ssize_t nargs) {
   const char* msg = nullptr;
-  if (!PyArg_ParseTuple(args, "s", &msg)) return nullptr;
-  std::printf("[PY] %s\n", msg ? msg : "");
+  if (!ParseArgs("log", args, nargs, 1, &msg)) return nullptr;
+  core::logInfo(core::LogCategory::Script, "%s", msg ? msg : "");
   Py_RETURN_NONE;
 }
 
-static PyObject* py_set_window_title(PyObject*, PyObject* args) {
+static PyObject* py_set_window_title(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
   const char* title = nullptr;
-  if (!PyArg_ParseTuple(args, "s", &title)) return nullptr;
-  if (g_ctx.hwnd && title) {
-    SetWindowTextA(g_ctx.hwnd, title);
+  if (!ParseArgs("set_window_title", args, nargs, 1, &title)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->hwnd && title) {
+    SetWindowTextA(ctx->hwnd, title);
   }
   Py_RETURN_NONE;
 }
 
-static PyObject* py_get_window_size(PyObject*, PyObject*) {
-  if (!g_ctx.hwnd) return Py_BuildValue("(ii)", 0, 0);
+static PyObject* py_get_window_size(PyObject* module, PyObject*) {
+  EngineCall ctx(module);
+  if (!ctx->hwnd) return Py_BuildValue("(ii)", 0, 0);
   RECT r{};
-  GetClientRect(g_ctx.hwnd, &r);
+  GetClientRect(ctx->hwnd, &r);
   int w = (r.right - r.left);
   int h = (r.bottom - r.top);
   return Py_BuildValue("(ii)", w, h);
@@ -48,64 +186,806 @@ static PyObject* py_time_seconds(PyObject*, PyObject*) {
   return PyFloat_FromDouble(sec);
 }
 
-static PyObject* py_request_quit(PyObject*, PyObject*) {
-  if (g_ctx.requestQuit) *g_ctx.requestQuit = true;
+static PyObject* py_request_quit(PyObject* module, PyObject*) {
+  EngineCall ctx(module);
+  if (ctx->requestQuit) *ctx->requestQuit = true;
   Py_RETURN_NONE;
 }
 
 // --------- input ----------
-static PyObject* py_is_key_down(PyObject*, PyObject* args) {
+static PyObject* py_is_key_down(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
   int vk = 0;
-  if (!PyArg_ParseTuple(args, "i", &vk)) return nullptr;
-  if (!g_ctx.input) Py_RETURN_FALSE;
-  bool down = g_ctx.input->isKeyDown(vk);
+  if (!ParseArgs("is_key_down", args, nargs, 1, &vk)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->input) Py_RETURN_FALSE;
+  bool down = ctx->input->isKeyDown(vk);
   if (down) Py_RETURN_TRUE;
   Py_RETURN_FALSE;
 }
 
-static PyObject* py_mouse_pos(PyObject*, PyObject*) {
-  if (!g_ctx.input) return Py_BuildValue("(ii)", 0, 0);
-  return Py_BuildValue("(ii)", g_ctx.input->mouseX, g_ctx.input->mouseY);
+static PyObject* py_mouse_pos(PyObject* module, PyObject*) {
+  EngineCall ctx(module);
+  if (!ctx->input) return Py_BuildValue("(ii)", 0, 0);
+  return Py_BuildValue("(ii)", ctx->input->mouseX, ctx->input->mouseY);
 }
 
-static PyObject* py_mouse_delta(PyObject*, PyObject*) {
-  if (!g_ctx.input) return Py_BuildValue("(ii)", 0, 0);
-  return Py_BuildValue("(ii)", g_ctx.input->mouseDX, g_ctx.input->mouseDY);
+static PyObject* py_mouse_delta(PyObject* module, PyObject*) {
+  EngineCall ctx(module);
+  if (!ctx->input) return Py_BuildValue("(ii)", 0, 0);
+  return Py_BuildValue("(ii)", ctx->input->mouseDX, ctx->input->mouseDY);
 }
 
-static PyObject* py_mouse_button_down(PyObject*, PyObject* args) {
+static PyObject* py_mouse_button_down(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
   int button = 0; // 0=L,1=R,2=M
-  if (!PyArg_ParseTuple(args, "i", &button)) return nullptr;
-  if (!g_ctx.input) Py_RETURN_FALSE;
-  bool down = g_ctx.input->isMouseDown(button);
+  if (!ParseArgs("mouse_button_down", args, nargs, 1, &button)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->input) Py_RETURN_FALSE;
+  bool down = ctx->input->isMouseDown(button);
   if (down) Py_RETURN_TRUE;
   Py_RETURN_FALSE;
 }
 
+// --------- camera + lights ----------
+static constexpr float kDegToRad = 3.14159265358979f / 180.0f;
+
+static PyObject* py_set_camera(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float x = 0, y = 0, z = 0, yaw = 0, pitch = 0, fov = 0;
+  if (!ParseArgs("set_camera", args, nargs, 5, &x, &y, &z, &yaw, &pitch, &fov)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->camera) {
+    ctx->camera->position = { x, y, z };
+    ctx->camera->yaw = yaw * kDegToRad;
+    ctx->camera->pitch = pitch * kDegToRad;
+    if (fov > 1.0f && fov < 179.0f) ctx->camera->fovY = fov * kDegToRad;
+  }
+  Py_RETURN_NONE;
+}
+
+static PyObject* AddLight(PyObject* module, const render::Light& light) {
+  EngineCall ctx(module);
+  if (!ctx->lights) return PyLong_FromLong(-1);
+  uint32_t id = ctx->lights->add(light);
+  return PyLong_FromLong(id == render::LightList::kInvalid ? -1 : (long)id);
+}
+
+static PyObject* py_add_light(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  render::Light l{};
+  if (!ParseArgs("add_light", args, nargs, 7,
+                 &l.position[0], &l.position[1], &l.position[2], &l.radius,
+                 &l.color[0], &l.color[1], &l.color[2], &l.intensity)) {
+    return nullptr;
+  }
+  l.type = render::LightType::Point;
+  return AddLight(module, l);
+}
+
+static PyObject* py_add_spot_light(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  render::Light l{};
+  float dx = 0, dy = 0, dz = -1, inner = 20, outer = 30;
+  if (!ParseArgs("add_spot_light", args, nargs, 12,
+                 &l.position[0], &l.position[1], &l.position[2], &dx, &dy, &dz,
+                 &l.radius, &inner, &outer,
+                 &l.color[0], &l.color[1], &l.color[2], &l.intensity)) {
+    return nullptr;
+  }
+  float len = std::sqrt(dx * dx + dy * dy + dz * dz);
+  if (len <= 0.0f) { dx = 0; dy = 0; dz = -1; len = 1; }
+  l.direction[0] = dx / len;
+  l.direction[1] = dy / len;
+  l.direction[2] = dz / len;
+  if (inner > outer) inner = outer;
+  l.cosInner = std::cos(inner * kDegToRad);
+  l.cosOuter = std::cos(outer * kDegToRad);
+  l.type = render::LightType::Spot;
+  return AddLight(module, l);
+}
+
+static render::Light* LightArg(const EngineContext& ctx, int id) {
+  return (ctx.lights && id >= 0) ? ctx.lights->get((uint32_t)id) : nullptr;
+}
+
+static PyObject* py_move_light(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float x = 0, y = 0, z = 0;
+  if (!ParseArgs("move_light", args, nargs, 4, &id, &x, &y, &z)) return nullptr;
+  EngineCall ctx(module);
+  if (render::Light* l = LightArg(*ctx, id)) {
+    l->position[0] = x; l->position[1] = y; l->position[2] = z;
+  }
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_set_light_color(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float r = 0, g = 0, b = 0;
+  if (!ParseArgs("set_light_color", args, nargs, 4, &id, &r, &g, &b)) return nullptr;
+  EngineCall ctx(module);
+  if (render::Light* l = LightArg(*ctx, id)) {
+    l->color[0] = r; l->color[1] = g; l->color[2] = b;
+  }
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_set_light_intensity(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float v = 0;
+  if (!ParseArgs("set_light_intensity", args, nargs, 2, &id, &v)) return nullptr;
+  EngineCall ctx(module);
+  if (render::Light* l = LightArg(*ctx, id)) l->intensity = v;
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_remove_light(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("remove_light", args, nargs, 1, &id)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->lights && id >= 0) ctx->lights->remove((uint32_t)id);
+  Py_RETURN_NONE;
+}
+
+// --------- particles ----------
+static PyObject* py_emit_particles(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  render::ParticleBurst b{};
+  int count = 0;
+  float dx = 0, dy = 1, dz = 0, speed = 2, spread = 30, life = 1;
+  float a = 1, gravity = 9.81f, drag = 0, bounce = 0.3f;
+  if (!ParseArgs("emit_particles", args, nargs, 14,
+                 &b.position[0], &b.position[1], &b.position[2], &count,
+                 &dx, &dy, &dz, &speed, &spread, &life, &b.size,
+                 &b.color[0], &b.color[1], &b.color[2], &a, &gravity, &drag, &bounce)) {
+    return nullptr;
+  }
+  EngineCall ctx(module);
+  if (!ctx->particles || count <= 0) return PyLong_FromLong(0);
+
+  float len = std::sqrt(dx * dx + dy * dy + dz * dz);
+  if (len <= 0.0f) { dx = 0; dy = 1; dz = 0; len = 1; }
+  b.direction[0] = dx / len;
+  b.direction[1] = dy / len;
+  b.direction[2] = dz / len;
+  b.cosSpread = std::cos(std::fmin(std::fmax(spread, 0.0f), 180.0f) * kDegToRad);
+  b.count = (uint32_t)count;
+  // +-25% jitter keeps bursts from looking like expanding shells.
+  b.speedMin = speed * 0.75f;
+  b.speedMax = speed * 1.25f;
+  b.lifeMin = life * 0.75f;
+  b.lifeMax = life * 1.25f;
+  b.color[3] = a;
+  b.gravity = gravity;
+  b.drag = drag;
+  b.bounce = bounce;
+  return PyLong_FromLong((long)ctx->particles->emit(b));
+}
+
+// --------- decals ----------
+static PyObject* py_add_decal(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  render::DecalDesc d{};
+  int image = -1;
+  if (!ParseArgs("add_decal", args, nargs, 10,
+                 &d.position.x, &d.position.y, &d.position.z,
+                 &d.normal.x, &d.normal.y, &d.normal.z, &d.size,
+                 &d.color[0], &d.color[1], &d.color[2], &d.color[3], &image)) {
+    return nullptr;
+  }
+  EngineCall ctx(module);
+  if (!ctx->decals) return PyLong_FromLong(-1);
+  d.image = image < 0 ? render::DecalSystem::kInvalid : (uint32_t)image;
+  uint32_t id = ctx->decals->add(d);
+  return PyLong_FromLong(id == render::DecalSystem::kInvalid ? -1 : (long)id);
+}
+
+static PyObject* py_remove_decal(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("remove_decal", args, nargs, 1, &id)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->decals && id >= 0) ctx->decals->remove((uint32_t)id);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_create_decal_image(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int w = 0, h = 0;
+  Py_buffer texels{};
+  if (!ParseArgs("create_decal_image", args, nargs, 3, &w, &h, &texels)) return nullptr;
+
+  long id = -1;
+  if (w <= 0 || h <= 0 || texels.len != (Py_ssize_t)w * h * 4) {
+    PyErr_SetString(PyExc_ValueError, "create_decal_image: expected w*h*4 bytes of RGBA8");
+  } else {
+    EngineCall ctx(module);
+    if (ctx->decals) {
+      uint32_t image = ctx->decals->createImage((uint32_t)w, (uint32_t)h, static_cast<const uint8_t*>(texels.buf));
+      if (image != render::DecalSystem::kInvalid) id = (long)image;
+    }
+  }
+  PyBuffer_Release(&texels);
+  if (PyErr_Occurred()) return nullptr;
+  return PyLong_FromLong(id);
+}
+
+static PyObject* py_release_decal_image(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("release_decal_image", args, nargs, 1, &id)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->decals && id >= 0) ctx->decals->releaseImage((uint32_t)id);
+  Py_RETURN_NONE;
+}
+
+// --------- static world ----------
+static PyObject* py_load_world(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  const char* path = nullptr;
+  if (!ParseArgs("load_world", args, nargs, 1, &path)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->world || !ctx->world->enabled()) return PyLong_FromLong(-1);
+
+  render::WorldGeometry geometry;
+  std::string error;
+  if (!render::loadWorldObj(path, geometry, error)) {
+    core::logError(core::LogCategory::Render, "load_world: %s", error.c_str());
+    return PyLong_FromLong(-1);
+  }
+  if (!ctx->world->load(geometry)) return PyLong_FromLong(-1);
+  return PyLong_FromLong((long)ctx->world->surfaceCount());
+}
+
+static PyObject* py_set_world_ambient(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float r = 0.0f, g = 0.0f, b = 0.0f;
+  if (!ParseArgs("set_world_ambient", args, nargs, 3, &r, &g, &b)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->world) ctx->world->setAmbient(r, g, b);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_set_world_fog(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float r = 0.0f, g = 0.0f, b = 0.0f, density = 0.0f;
+  if (!ParseArgs("set_world_fog", args, nargs, 4, &r, &g, &b, &density)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->post) ctx->post->setFog(r, g, b, density);
+  Py_RETURN_NONE;
+}
+
+// --------- post-processing ----------
+static PyObject* py_set_post_bloom(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float intensity = 0.0f, threshold = 1.0f;
+  if (!ParseArgs("set_post_bloom", args, nargs, 1, &intensity, &threshold)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->post) ctx->post->setBloom(intensity, threshold);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_set_post_exposure(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float exposure = 1.0f;
+  if (!ParseArgs("set_post_exposure", args, nargs, 1, &exposure)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->post) ctx->post->setExposure(exposure);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_set_color_grade(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  render::PostProcess::ColorGrade grade;
+  if (!ParseArgs("set_color_grade", args, nargs, 5, &grade.saturation, &grade.contrast, &grade.gain[0],
+                 &grade.gain[1], &grade.gain[2])) {
+    return nullptr;
+  }
+  EngineCall ctx(module);
+  if (ctx->post) ctx->post->setColorGrade(grade);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_post_gpu_ms(PyObject* module, PyObject*) {
+  EngineCall ctx(module);
+  return PyFloat_FromDouble(ctx->post ? ctx->post->gpuMs() : 0.0);
+}
+
+static PyObject* py_set_post_sharpness(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float sharpness = 0.5f;
+  if (!ParseArgs("set_post_sharpness", args, nargs, 1, &sharpness)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->post) ctx->post->setSharpness(sharpness);
+  Py_RETURN_NONE;
+}
+
+// --------- dynamic resolution ----------
+static PyObject* py_set_gpu_budget(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float ms = 0.0f;
+  if (!ParseArgs("set_gpu_budget", args, nargs, 1, &ms)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->resolution) ctx->resolution->setBudget(ms);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_render_scale(PyObject* module, PyObject*) {
+  EngineCall ctx(module);
+  if (!ctx->resolution) return Py_BuildValue("(dd)", 1.0, 0.0);
+  return Py_BuildValue("(dd)", (double)ctx->resolution->scale(), (double)ctx->resolution->sceneMs());
+}
+
+// --------- shadows ----------
+static PyObject* py_set_light_shadow(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float importance = 0.0f;
+  if (!ParseArgs("set_light_shadow", args, nargs, 2, &id, &importance)) return nullptr;
+  EngineCall ctx(module);
+  if (render::Light* l = LightArg(*ctx, id)) l->shadowImportance = std::max(importance, 0.0f);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_add_shadow_caster(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float x = 0, y = 0, z = 0, hx = 0.5f, hy = 0.5f, hz = 0.5f;
+  if (!ParseArgs("add_shadow_caster", args, nargs, 6, &x, &y, &z, &hx, &hy, &hz)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->shadows) return PyLong_FromLong(-1);
+  uint32_t id = ctx->shadows->addCaster({ x, y, z }, { hx, hy, hz });
+  return PyLong_FromLong(id == render::ShadowAtlas::kInvalid ? -1 : (long)id);
+}
+
+static PyObject* py_move_shadow_caster(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float x = 0, y = 0, z = 0;
+  if (!ParseArgs("move_shadow_caster", args, nargs, 4, &id, &x, &y, &z)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->shadows && id >= 0) ctx->shadows->moveCaster((uint32_t)id, { x, y, z });
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_remove_shadow_caster(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("remove_shadow_caster", args, nargs, 1, &id)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->shadows && id >= 0) ctx->shadows->removeCaster((uint32_t)id);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_shadow_stats(PyObject* module, PyObject*) {
+  EngineCall ctx(module);
+  if (!ctx->shadows) return Py_BuildValue("(III)", 0u, 0u, 0u);
+  const render::ShadowAtlas& s = *ctx->shadows;
+  return Py_BuildValue("(III)", s.shadowCount(), s.staticRenders(), s.dynamicRenders());
+}
+
+// --------- navigation ----------
+static PyObject* py_load_navmesh(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  const char* path = nullptr;
+  if (!ParseArgs("load_navmesh", args, nargs, 1, &path)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->nav || !ctx->nav->load(path)) return PyLong_FromLong(-1);
+  return PyLong_FromLong((long)ctx->nav->polyCount());
+}
+
+static PyObject* py_find_path(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float x0 = 0.0f, y0 = 0.0f, z0 = 0.0f, x1 = 0.0f, y1 = 0.0f, z1 = 0.0f;
+  if (!ParseArgs("find_path", args, nargs, 6, &x0, &y0, &z0, &x1, &y1, &z1)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->nav) return PyLong_FromLong(-1);
+  nav::PathId id = ctx->nav->requestPath({ x0, y0, z0 }, { x1, y1, z1 });
+  return PyLong_FromLong(id == nav::kInvalidPath ? -1 : (long)id);
+}
+
+static PyObject* py_get_path(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("get_path", args, nargs, 1, &id)) return nullptr;
+  EngineCall ctx(module);
+  const std::vector<nav::Vec3>* points = (ctx->nav && id >= 0) ? ctx->nav->path((nav::PathId)id) : nullptr;
+  PyObject* list = PyList_New(points ? (Py_ssize_t)points->size() : 0);
+  if (!list) return nullptr;
+  for (Py_ssize_t i = 0; points && i < (Py_ssize_t)points->size(); ++i) {
+    const nav::Vec3& p = (*points)[i];
+    PyObject* t = Py_BuildValue("(fff)", p.x, p.y, p.z);
+    if (!t) {
+      Py_DECREF(list);
+      return nullptr;
+    }
+    PyList_SET_ITEM(list, i, t);
+  }
+  if (points) ctx->nav->release((nav::PathId)id);
+  return list;
+}
+
+// --------- triggers ----------
+static PyObject* py_add_trigger(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float x0 = 0.0f, y0 = 0.0f, z0 = 0.0f, x1 = 0.0f, y1 = 0.0f, z1 = 0.0f;
+  if (!ParseArgs("add_trigger", args, nargs, 6, &x0, &y0, &z0, &x1, &y1, &z1)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->triggers) return PyLong_FromLong(-1);
+  return PyLong_FromLong((long)ctx->triggers->addTrigger({ { x0, y0, z0 }, { x1, y1, z1 } }));
+}
+
+static PyObject* py_remove_trigger(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("remove_trigger", args, nargs, 1, &id)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->triggers && id >= 0) ctx->triggers->removeTrigger((physics::TriggerId)id);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_add_actor(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float x = 0.0f, y = 0.0f, z = 0.0f, radius = 0.0f;
+  if (!ParseArgs("add_actor", args, nargs, 4, &x, &y, &z, &radius)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->triggers) return PyLong_FromLong(-1);
+  return PyLong_FromLong((long)ctx->triggers->addActor({ x, y, z }, radius));
+}
+
+static PyObject* py_move_actor(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float x = 0.0f, y = 0.0f, z = 0.0f;
+  if (!ParseArgs("move_actor", args, nargs, 4, &id, &x, &y, &z)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->triggers && id >= 0) ctx->triggers->moveActor((physics::ActorId)id, { x, y, z });
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_remove_actor(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("remove_actor", args, nargs, 1, &id)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->triggers && id >= 0) ctx->triggers->removeActor((physics::ActorId)id);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_trigger_events(PyObject* module, PyObject*) {
+  EngineCall ctx(module);
+  const std::vector<physics::TriggerEvent>* events = ctx->triggers ? &ctx->triggers->events() : nullptr;
+  PyObject* list = PyList_New(events ? (Py_ssize_t)events->size() : 0);
+  if (!list) return nullptr;
+  for (Py_ssize_t i = 0; events && i < (Py_ssize_t)events->size(); ++i) {
+    const physics::TriggerEvent& e = (*events)[i];
+    PyObject* t = Py_BuildValue("(IIO)", e.trigger, e.actor, e.entered ? Py_True : Py_False);
+    if (!t) {
+      Py_DECREF(list);
+      return nullptr;
+    }
+    PyList_SET_ITEM(list, i, t);
+  }
+  return list;
+}
+
+// --------- save / load ----------
+static PyObject* py_save_game(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  const char* path = nullptr;
+  Py_buffer data{};
+  if (!ParseArgs("save_game", args, nargs, 1, &path, &data)) return nullptr;
+  save::SaveId id = save::kInvalidSave;
+  {
+    EngineCall ctx(module);
+    if (ctx->save) id = ctx->save->save(path, data.buf, data.buf ? (size_t)data.len : 0);
+  }
+  if (data.obj) PyBuffer_Release(&data);
+  return PyLong_FromLong(id == save::kInvalidSave ? -1 : (long)id);
+}
+
+static PyObject* py_load_game(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  const char* path = nullptr;
+  if (!ParseArgs("load_game", args, nargs, 1, &path)) return nullptr;
+  std::vector<uint8_t> data;
+  {
+    EngineCall ctx(module);
+    if (!ctx->save || !ctx->save->load(path, data)) Py_RETURN_NONE;
+  }
+  return PyBytes_FromStringAndSize(reinterpret_cast<const char*>(data.data()), (Py_ssize_t)data.size());
+}
+
+// --------- audio ----------
+static PyObject* py_play_sound(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  const char* name = nullptr;
+  audio::VoiceParams p;
+  if (!ParseArgs("play_sound", args, nargs, 1, &name, &p.volume, &p.pan, &p.pitch, &p.loop)) return nullptr;
+  audio::VoiceId id = audio::kInvalidVoice;
+  EngineCall ctx(module);
+  if (ctx->audio) {
+    const audio::SoundId sound = ctx->audio->findSound(name);
+    if (sound != audio::kInvalidSound) id = ctx->audio->play(sound, p);
+  }
+  return PyLong_FromLong(id == audio::kInvalidVoice ? -1 : (long)id);
+}
+
+static PyObject* py_stop_sound(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float fade = 0.0f;
+  if (!ParseArgs("stop_sound", args, nargs, 1, &id, &fade)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->audio && id >= 0) ctx->audio->stop((audio::VoiceId)id, fade);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_set_sound(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float volume = 1.0f, pan = 0.0f, pitch = 1.0f;
+  if (!ParseArgs("set_sound", args, nargs, 4, &id, &volume, &pan, &pitch)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->audio && id >= 0) ctx->audio->set((audio::VoiceId)id, volume, pan, pitch);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_set_master_volume(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  float volume = 1.0f;
+  if (!ParseArgs("set_master_volume", args, nargs, 1, &volume)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->audio) ctx->audio->setMasterVolume(volume);
+  Py_RETURN_NONE;
+}
+
+// --------- behaviors ----------
+static PyObject* py_register_behavior(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  const char* name = nullptr;
+  PyObject* fn = nullptr;
+  BehaviorDesc desc;
+  int stateFloats = 0;
+  if (!ParseArgs("register_behavior", args, nargs, 2, &name, &fn, &desc.hz, &desc.activeRadius, &stateFloats)) {
+    return nullptr;
+  }
+  if (!PyCallable_Check(fn)) {
+    PyErr_Format(PyExc_TypeError, "register_behavior() expected a callable, not %.100s", Py_TYPE(fn)->tp_name);
+    return nullptr;
+  }
+  desc.hz = std::fmax(desc.hz, 0.0f);
+  desc.activeRadius = std::fmax(desc.activeRadius, 0.0f);
+  desc.stateFloats = (uint32_t)std::max(stateFloats, 0);
+  EngineCall ctx(module);
+  if (!ctx->behaviors) return PyLong_FromLong(-1);
+  return PyLong_FromLong((long)ctx->behaviors->registerBehavior(name, fn, desc));
+}
+
+static PyObject* py_spawn_entity(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int behavior = -1;
+  float x = 0.0f, y = 0.0f, z = 0.0f;
+  if (!ParseArgs("spawn_entity", args, nargs, 4, &behavior, &x, &y, &z)) return nullptr;
+  EngineCall ctx(module);
+  if (!ctx->behaviors || behavior < 0) return PyLong_FromLong(-1);
+  EntityId id = ctx->behaviors->spawn((BehaviorId)behavior, { x, y, z });
+  return PyLong_FromLong(id == kInvalidEntity ? -1 : (long)id);
+}
+
+static PyObject* py_despawn_entity(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("despawn_entity", args, nargs, 1, &id)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->behaviors && id >= 0) ctx->behaviors->despawn((EntityId)id);
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_set_entity_position(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  float x = 0.0f, y = 0.0f, z = 0.0f;
+  if (!ParseArgs("set_entity_position", args, nargs, 4, &id, &x, &y, &z)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->behaviors && id >= 0) ctx->behaviors->setPosition((EntityId)id, { x, y, z });
+  Py_RETURN_NONE;
+}
+
+static PyObject* py_entity_position(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  if (!ParseArgs("entity_position", args, nargs, 1, &id)) return nullptr;
+  render::Vec3 p;
+  {
+    EngineCall ctx(module);
+    if (!ctx->behaviors || id < 0 || !ctx->behaviors->position((EntityId)id, p)) Py_RETURN_NONE;
+  }
+  return Py_BuildValue("(fff)", p.x, p.y, p.z);
+}
+
+static PyObject* py_set_entity_dormant(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  int id = -1;
+  bool dormant = true;
+  if (!ParseArgs("set_entity_dormant", args, nargs, 2, &id, &dormant)) return nullptr;
+  EngineCall ctx(module);
+  if (ctx->behaviors && id >= 0) ctx->behaviors->setDormant((EntityId)id, dormant);
+  Py_RETURN_NONE;
+}
+
+// --------- script threads ----------
+#if defined(Py_GIL_DISABLED)
+// Each job attaches a thread state for its range; the calling thread detaches
+// while it waits (it runs ranges itself meanwhile, re-attaching its own
+// state). The first exception stops the remaining calls and is re-raised.
+static PyObject* ParallelCalls(core::JobSystem& jobs, PyObject* fn, int count) {
+  std::atomic<PyObject*> error{nullptr};
+  Py_BEGIN_ALLOW_THREADS
+  jobs.parallelFor((uint32_t)count, 1, [&](uint32_t begin, uint32_t end) {
+    PyGILState_STATE gil = PyGILState_Ensure();
+    for (uint32_t i = begin; i < end && !error.load(std::memory_order_relaxed); ++i) {
+      PyObject* index = PyLong_FromUnsignedLong(i);
+      PyObject* res = index ? PyObject_CallOneArg(fn, index) : nullptr;
+      Py_XDECREF(index);
+      if (!res) {
+        PyObject* exc = PyErr_GetRaisedException();
+        PyObject* none = nullptr;
+        if (!error.compare_exchange_strong(none, exc)) Py_DECREF(exc);
+        break;
+      }
+      Py_DECREF(res);
+    }
+    PyGILState_Release(gil);
+  });
+  Py_END_ALLOW_THREADS
+  if (PyObject* exc = error.load()) {
+    PyErr_SetRaisedException(exc);
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+#endif
+
+static PyObject* py_parallel_for(PyObject* module, PyObject* const* args, Py_ssize_t nargs) {
+  if (nargs != 2) {
+    PyErr_Format(PyExc_TypeError, "parallel_for() takes exactly 2 arguments (%zd given)", nargs);
+    return nullptr;
+  }
+  PyObject* fn = args[0];
+  int count = 0;
+  if (!ParseArg(args[1], &count)) return nullptr;
+  if (!PyCallable_Check(fn)) {
+    PyErr_Format(PyExc_TypeError, "parallel_for() expected a callable, not %.100s", Py_TYPE(fn)->tp_name);
+    return nullptr;
+  }
+
+#if defined(Py_GIL_DISABLED)
+  core::JobSystem* jobs = static_cast<EngineState*>(PyModule_GetState(module))->ctx.jobs;
+  if (jobs && count > 1 && jobs->threadCount() > 1) return ParallelCalls(*jobs, fn, count);
+#else
+  (void)module;
+#endif
+
+  // With a GIL the calls could only take turns; run them here in order.
+  for (int i = 0; i < count; ++i) {
+    PyObject* index = PyLong_FromLong(i);
+    PyObject* res = index ? PyObject_CallOneArg(fn, index) : nullptr;
+    Py_XDECREF(index);
+    if (!res) return nullptr;
+    Py_DECREF(res);
+  }
+  Py_RETURN_NONE;
+}
+
+// PyMethodDef stores every calling convention as a PyCFunction.
+template <class F>
+static PyCFunction Fast(F fn) {
+  return reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(fn));
+}
+
 static PyMethodDef kMethods[] = {
-  {"log", py_log, METH_VARARGS, "engine.log(str) -> None"},
-  {"set_window_title", py_set_window_title, METH_VARARGS, "engine.set_window_title(str) -> None"},
+  {"log", Fast(py_log), METH_FASTCALL, "engine.log(str) -> None"},
+  {"set_window_title", Fast(py_set_window_title), METH_FASTCALL, "engine.set_window_title(str) -> None"},
   {"get_window_size", py_get_window_size, METH_NOARGS, "engine.get_window_size() -> (w,h)"},
   {"time_seconds", py_time_seconds, METH_NOARGS, "engine.time_seconds() -> float"},
   {"request_quit", py_request_quit, METH_NOARGS, "engine.request_quit() -> None"},
 
-  {"is_key_down", py_is_key_down, METH_VARARGS, "engine.is_key_down(vk:int) -> bool"},
+  {"is_key_down", Fast(py_is_key_down), METH_FASTCALL, "engine.is_key_down(vk:int) -> bool"},
   {"mouse_pos", py_mouse_pos, METH_NOARGS, "engine.mouse_pos() -> (x,y)"},
   {"mouse_delta", py_mouse_delta, METH_NOARGS, "engine.mouse_delta() -> (dx,dy)"},
-  {"mouse_button_down", py_mouse_button_down, METH_VARARGS, "engine.mouse_button_down(btn:int) -> bool"},
+  {"mouse_button_down", Fast(py_mouse_button_down), METH_FASTCALL, "engine.mouse_button_down(btn:int) -> bool"},
+
+  {"set_camera", Fast(py_set_camera), METH_FASTCALL, "engine.set_camera(x,y,z,yaw_deg,pitch_deg[,fov_deg]) -> None"},
+  {"add_light", Fast(py_add_light), METH_FASTCALL, "engine.add_light(x,y,z,radius,r,g,b[,intensity]) -> id (-1 if full)"},
+  {"add_spot_light", Fast(py_add_spot_light), METH_FASTCALL,
+   "engine.add_spot_light(x,y,z,dx,dy,dz,radius,inner_deg,outer_deg,r,g,b[,intensity]) -> id (-1 if full)"},
+  {"move_light", Fast(py_move_light), METH_FASTCALL, "engine.move_light(id,x,y,z) -> None"},
+  {"set_light_color", Fast(py_set_light_color), METH_FASTCALL, "engine.set_light_color(id,r,g,b) -> None"},
+  {"set_light_intensity", Fast(py_set_light_intensity), METH_FASTCALL, "engine.set_light_intensity(id,v) -> None"},
+  {"remove_light", Fast(py_remove_light), METH_FASTCALL, "engine.remove_light(id) -> None"},
+
+  {"emit_particles", Fast(py_emit_particles), METH_FASTCALL,
+   "engine.emit_particles(x,y,z,count,dx,dy,dz,speed,spread_deg,lifetime,size,r,g,b"
+   "[,alpha,gravity,drag,bounce]) -> accepted count (rgb premultiplied, alpha 0 = additive, "
+   "bounce < 0 = no collision)"},
+
+  {"add_decal", Fast(py_add_decal), METH_FASTCALL,
+   "engine.add_decal(x,y,z,nx,ny,nz,size,r,g,b[,alpha,image]) -> id (-1 on failure; "
+   "image -1 = random blood splat, oldest unseen decal evicted when full)"},
+  {"remove_decal", Fast(py_remove_decal), METH_FASTCALL, "engine.remove_decal(id) -> None"},
+  {"create_decal_image", Fast(py_create_decal_image), METH_FASTCALL,
+   "engine.create_decal_image(w,h,rgba:bytes) -> image id (-1 if the atlas is full, max 512x512)"},
+  {"release_decal_image", Fast(py_release_decal_image), METH_FASTCALL,
+   "engine.release_decal_image(id) -> None (space returns once no decal uses it)"},
+
+  {"load_world", Fast(py_load_world), METH_FASTCALL,
+   "engine.load_world(obj_path) -> surface count (-1 on failure; waits for the GPU, load time only)"},
+  {"set_world_ambient", Fast(py_set_world_ambient), METH_FASTCALL, "engine.set_world_ambient(r,g,b) -> None"},
+  {"set_world_fog", Fast(py_set_world_fog), METH_FASTCALL, "engine.set_world_fog(r,g,b,density) -> None  (density 0 = off)"},
+  {"set_post_bloom", Fast(py_set_post_bloom), METH_FASTCALL,
+   "engine.set_post_bloom(intensity,threshold=1) -> None  (intensity 0 = off)"},
+  {"set_post_exposure", Fast(py_set_post_exposure), METH_FASTCALL, "engine.set_post_exposure(exposure) -> None"},
+  {"set_color_grade", Fast(py_set_color_grade), METH_FASTCALL,
+   "engine.set_color_grade(saturation,contrast,r,g,b) -> None  (1,1,1,1,1 = off)"},
+  {"post_gpu_ms", py_post_gpu_ms, METH_NOARGS, "engine.post_gpu_ms() -> float (0 without GPU timestamps)"},
+  {"set_post_sharpness", Fast(py_set_post_sharpness), METH_FASTCALL,
+   "engine.set_post_sharpness(sharpness) -> None  (0..1, applied while upscaling)"},
+  {"set_gpu_budget", Fast(py_set_gpu_budget), METH_FASTCALL,
+   "engine.set_gpu_budget(ms) -> None  (scene GPU time dynamic resolution holds; 0 = native)"},
+  {"render_scale", py_render_scale, METH_NOARGS, "engine.render_scale() -> (scale, scene_ms)"},
+  {"set_light_shadow", Fast(py_set_light_shadow), METH_FASTCALL,
+   "engine.set_light_shadow(id,importance) -> None  (0 = no shadow; 1 = full resolution up close)"},
+  {"add_shadow_caster", Fast(py_add_shadow_caster), METH_FASTCALL,
+   "engine.add_shadow_caster(x,y,z,hx,hy,hz) -> id (-1 if full; box center and half size)"},
+  {"move_shadow_caster", Fast(py_move_shadow_caster), METH_FASTCALL, "engine.move_shadow_caster(id,x,y,z) -> None"},
+  {"remove_shadow_caster", Fast(py_remove_shadow_caster), METH_FASTCALL, "engine.remove_shadow_caster(id) -> None"},
+  {"shadow_stats", py_shadow_stats, METH_NOARGS,
+   "engine.shadow_stats() -> (shadowed lights, static re-renders, caster-only refreshes) of the last frame"},
+
+  {"load_navmesh", Fast(py_load_navmesh), METH_FASTCALL,
+   "engine.load_navmesh(nav_path) -> polygon count (-1 on failure; pending paths fail)"},
+  {"find_path", Fast(py_find_path), METH_FASTCALL,
+   "engine.find_path(x0,y0,z0,x1,y1,z1) -> request id (-1 without navmesh); answered later by "
+   "on_event('path_ready', id, status, point_count), status 0 found / 1 partial / 2 no path"},
+  {"get_path", Fast(py_get_path), METH_FASTCALL,
+   "engine.get_path(id) -> [(x,y,z), ...] corner points of a ready path, then frees it ([] if unknown)"},
+
+  {"add_trigger", Fast(py_add_trigger), METH_FASTCALL, "engine.add_trigger(x0,y0,z0,x1,y1,z1) -> id (box corners)"},
+  {"remove_trigger", Fast(py_remove_trigger), METH_FASTCALL, "engine.remove_trigger(id) -> None (actors inside exit)"},
+  {"add_actor", Fast(py_add_actor), METH_FASTCALL, "engine.add_actor(x,y,z,radius) -> id (a sphere triggers react to)"},
+  {"move_actor", Fast(py_move_actor), METH_FASTCALL, "engine.move_actor(id,x,y,z) -> None"},
+  {"remove_actor", Fast(py_remove_actor), METH_FASTCALL, "engine.remove_actor(id) -> None (exits the triggers it was in)"},
+  {"trigger_events", py_trigger_events, METH_NOARGS,
+   "engine.trigger_events() -> [(trigger, actor, entered), ...] since the previous batch; announced by "
+   "on_event('triggers', count, 0, 0)"},
+
+  {"save_game", Fast(py_save_game), METH_FASTCALL,
+   "engine.save_game(path[,data:bytes]) -> save id (-1 on failure); the world is captured now and written in "
+   "the background, then on_event('game_saved', id, ok, 0)"},
+  {"load_game", Fast(py_load_game), METH_FASTCALL,
+   "engine.load_game(path) -> the data given to save_game (None on failure, nothing restored)"},
+
+  {"play_sound", Fast(py_play_sound), METH_FASTCALL,
+   "engine.play_sound(name[,volume,pan,pitch,loop]) -> voice id (-1 if unknown or busy); "
+   "on_event('sound_done', id, 0, 0) once it ends"},
+  {"stop_sound", Fast(py_stop_sound), METH_FASTCALL, "engine.stop_sound(id[,fade_seconds]) -> None"},
+  {"set_sound", Fast(py_set_sound), METH_FASTCALL, "engine.set_sound(id,volume,pan,pitch) -> None (glides over a few ms)"},
+  {"set_master_volume", Fast(py_set_master_volume), METH_FASTCALL, "engine.set_master_volume(v) -> None"},
+
+  {"register_behavior", Fast(py_register_behavior), METH_FASTCALL,
+   "engine.register_behavior(name, fn[, hz, active_radius, state_floats]) -> behavior id; once per frame "
+   "fn(ids, positions, state, dt) gets flat memoryviews over its due entities (positions xyz and state "
+   "writable, kept). hz 0 = every frame, else each entity at hz, staggered; entities dormant or farther than "
+   "active_radius (0 = any) from the camera are skipped. Same name again replaces fn and settings"},
+  {"spawn_entity", Fast(py_spawn_entity), METH_FASTCALL,
+   "engine.spawn_entity(behavior,x,y,z) -> entity id (-1 if the behavior is unknown); state starts zeroed"},
+  {"despawn_entity", Fast(py_despawn_entity), METH_FASTCALL, "engine.despawn_entity(id) -> None"},
+  {"set_entity_position", Fast(py_set_entity_position), METH_FASTCALL,
+   "engine.set_entity_position(id,x,y,z) -> None (inside a behavior, write its positions view instead)"},
+  {"entity_position", Fast(py_entity_position), METH_FASTCALL,
+   "engine.entity_position(id) -> (x,y,z) (None if unknown)"},
+  {"set_entity_dormant", Fast(py_set_entity_dormant), METH_FASTCALL,
+   "engine.set_entity_dormant(id, dormant) -> None (dormant entities are not ticked)"},
+
+  {"parallel_for", Fast(py_parallel_for), METH_FASTCALL,
+   "engine.parallel_for(fn, n) -> None; calls fn(i) for i in range(n), spread over the job threads on a "
+   "free-threaded build (in order here otherwise). The calls must not share mutable Python objects; engine.* "
+   "calls from them are serialized. The first exception is re-raised"},
   {nullptr, nullptr, 0, nullptr}
 };
 
+static int EngineExec(PyObject* module) {
+  static_cast<EngineState*>(PyModule_GetState(module))->ctx = g_initialCtx;
+  return 0;
+}
+
+static PyModuleDef_Slot kSlots[] = {
+  {Py_mod_exec, reinterpret_cast<void*>(&EngineExec)},
+#if PY_VERSION_HEX >= 0x030C0000
+  // The engine objects are process-wide and only the free-threaded lock
+  // guards them, so interpreters must share one GIL.
+  {Py_mod_multiple_interpreters, Py_MOD_MULTIPLE_INTERPRETERS_SUPPORTED},
+#endif
+#if PY_VERSION_HEX >= 0x030D0000
+  // Importing a module without this re-enables the GIL on free-threaded builds.
+  {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+  {0, nullptr}
+};
+
 static struct PyModuleDef kModule = {
   PyModuleDef_HEAD_INIT,
   "engine",
   "Minimal built-in engine API (embedded).",
-  -1,
-  kMethods
+  sizeof(EngineState),
+  kMethods,
+  kSlots,
+  nullptr,
+  nullptr,
+  nullptr
 };
 
 extern "C" PyMODINIT_FUNC PyInit_engine(void) {
-  return PyModule_Create(&kModule);
+  return PyModuleDef_Init(&kModule);
 }
 
 bool RegisterEngineModule() {
@@ -4,20 +4,44 @@
 #include <windows.h>
 
 namespace input { struct InputState; }
+namespace render { struct Camera; class LightList; class ParticleSystem; class DecalSystem; class StaticWorld; class PostProcess; class DynamicResolution; class ShadowAtlas; }
+namespace nav { class NavSystem; }
+namespace physics { class TriggerSystem; }
+namespace save { class SaveSystem; }
+namespace audio { class AudioSystem; }
+namespace core { class JobSystem; }
 
 namespace scripting {
 
+class BehaviorScheduler;
+
 struct EngineContext {
   HWND hwnd = nullptr;
   input::InputState* input = nullptr;
   bool* requestQuit = nullptr;
+  render::Camera* camera = nullptr;
+  render::LightList* lights = nullptr;
+  render::ParticleSystem* particles = nullptr;
+  render::DecalSystem* decals = nullptr;
+  render::StaticWorld* world = nullptr;
+  render::PostProcess* post = nullptr;
+  render::DynamicResolution* resolution = nullptr;
+  render::ShadowAtlas* shadows = nullptr;
+  nav::NavSystem* nav = nullptr;
+  physics::TriggerSystem* triggers = nullptr;
+  save::SaveSystem* save = nullptr;
+  audio::AudioSystem* audio = nullptr;
+  core::JobSystem* jobs = nullptr; // engine.parallel_for on free-threaded builds
+  BehaviorScheduler* behaviors = nullptr;
 };
 
-/// Registers the built-in Python module named "engine".
+/// Registers the built-in Python module named "engine" (multi-phase init,
+/// METH_FASTCALL functions, declares it runs without the GIL).
 /// Must be called BEFORE Py_Initialize(), via PyImport_AppendInittab.
 bool RegisterEngineModule();
 
-/// Provide runtime context (HWND, input, quit flag) used by engine.* functions.
+/// Provide runtime context (HWND, input, quit flag, camera, lights, particles, decals, world, post, resolution, shadows, navigation, triggers, saves, audio, jobs, behaviors) used by engine.* functions.
+/// Each import of the module copies it into the module's state, so call this before PythonHost::init().
 void SetEngineContext(const EngineContext& ctx);
 
 } // namespace scripting
@@ -1,10 +1,14 @@
 #include "PythonHost.h"
 #include "EngineModule.h"
+#include "../core/Log.h"
+#include "../memory/MemoryTracker.h"
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -71,6 +75,115 @@ static void AddProjectPythonCandidatesToSysPath() {
 
 namespace scripting {
 
+// scripts.pak is copied next to Game.exe by the build; CWD is the fallback.
+// BSP_SCRIPTS_LOOSE=1 skips it so edits in python/ apply without a rebuild.
+static std::string FindScriptBundle() {
+  if (const char* v = std::getenv("BSP_SCRIPTS_LOOSE")) {
+    if (v[0] && v[0] != '0') return {};
+  }
+
+  std::vector<std::string> candidates;
+#if defined(_WIN32)
+  char exePath[MAX_PATH]{};
+  DWORD n = GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+  if (n > 0 && n < MAX_PATH) candidates.push_back(DirName(std::string(exePath)) + "\\scripts.pak");
+#endif
+  candidates.push_back("scripts.pak");
+
+  for (const auto& c : candidates) {
+    std::ifstream f(c, std::ios::binary);
+    if (f.is_open()) return c;
+  }
+  return {};
+}
+
+// pymalloc's arenas, where every small object lives, are charged to the
+// scripting tag. Objects over 512 bytes, which Python takes from malloc
+// directly, are not counted.
+static PyObjectArenaAllocator g_pythonArenas;
+
+static void* TrackedArenaAlloc(void*, size_t size) {
+  void* p = g_pythonArenas.alloc(g_pythonArenas.ctx, size);
+  if (p) memory::track(memory::MemTag::Scripting, size);
+  return p;
+}
+
+static void TrackedArenaFree(void*, void* ptr, size_t size) {
+  g_pythonArenas.free(g_pythonArenas.ctx, ptr, size);
+  memory::untrack(memory::MemTag::Scripting, size);
+}
+
+// Before Py_Initialize(), so no arena predates the hook.
+static void TrackPythonArenas() {
+  PyObject_GetArenaAllocator(&g_pythonArenas);
+  PyObjectArenaAllocator tracked{ nullptr, TrackedArenaAlloc, TrackedArenaFree };
+  PyObject_SetArenaAllocator(&tracked);
+}
+
+// Isolated interpreter for the bundled build: no environment variables, no
+// site.py/.pth scanning, no user site, no bytecode writes.
+static bool InitializeIsolated(const std::string& bundlePath) {
+  PyConfig config;
+  PyConfig_InitIsolatedConfig(&config);
+  config.site_import = 0;
+  config.write_bytecode = 0;
+
+  // The pak is the only search path during bootstrap: zipimport serves
+  // encodings from it before our finder is installed.
+  config.module_search_paths_set = 1;
+  PyStatus status = PyStatus_Ok();
+  wchar_t* wpath = Py_DecodeLocale(bundlePath.c_str(), nullptr);
+  if (!wpath) status = PyStatus_NoMemory();
+  if (!PyStatus_Exception(status)) status = PyWideStringList_Append(&config.module_search_paths, wpath);
+  PyMem_RawFree(wpath);
+  if (!PyStatus_Exception(status)) status = Py_InitializeFromConfig(&config);
+  PyConfig_Clear(&config);
+
+  if (PyStatus_Exception(status)) {
+    core::logError(core::LogCategory::Script, "Isolated init failed: %s",
+                   status.err_msg ? status.err_msg : "<unknown>");
+    return false;
+  }
+
+  // Loose stdlib behind the pak, for modules imported lazily that the pack
+  // step did not see. Same layout getpath would have produced.
+  PyObject* prefix = PySys_GetObject("base_prefix");     // borrowed
+  PyObject* platlib = PySys_GetObject("platlibdir");     // borrowed
+  const char* pre = (prefix && PyUnicode_Check(prefix)) ? PyUnicode_AsUTF8(prefix) : nullptr;
+  const char* lib = (platlib && PyUnicode_Check(platlib)) ? PyUnicode_AsUTF8(platlib) : "lib";
+  if (pre && pre[0]) {
+    std::string base(pre);
+    char ver[32];
+#if defined(_WIN32)
+    std::snprintf(ver, sizeof(ver), "python%d%d.zip", PY_MAJOR_VERSION, PY_MINOR_VERSION);
+    const std::string fallback[] = { base + "\\" + ver, base + "\\Lib", base + "\\DLLs" };
+#else
+    std::snprintf(ver, sizeof(ver), "python%d.%d", PY_MAJOR_VERSION, PY_MINOR_VERSION);
+    std::string stdlib = base + "/" + (lib ? lib : "lib") + "/" + ver;
+    const std::string fallback[] = { stdlib, stdlib + "/lib-dynload" };
+#endif
+    PyObject* sysPath = PySys_GetObject("path"); // borrowed
+    for (const auto& p : fallback) {
+      PyObject* item = PyUnicode_FromString(p.c_str());
+      if (item && sysPath && PyList_Check(sysPath)) PyList_Append(sysPath, item);
+      Py_XDECREF(item);
+    }
+  }
+  PyErr_Clear();
+  return true;
+}
+
+// BSP_SCRIPT_PROFILE=1 enables sampling, BSP_SCRIPT_BUDGET_MS overrides the per-frame
+// budget, BSP_SCRIPT_PROFILE_OUT names the folded-stack dump.
+static ScriptProfiler::Config ProfilerConfigFromEnv() {
+  ScriptProfiler::Config cfg{};
+  if (const char* v = std::getenv("BSP_SCRIPT_PROFILE")) cfg.sampling = (v[0] && v[0] != '0');
+  if (const char* v = std::getenv("BSP_SCRIPT_BUDGET_MS")) cfg.frameBudgetMs = std::atof(v);
+  if (const char* v = std::getenv("BSP_SCRIPT_SAMPLE_MS")) cfg.sampleIntervalMs = std::atof(v);
+  if (const char* v = std::getenv("BSP_SCRIPT_PROFILE_OUT")) cfg.foldedPath = v;
+  return cfg;
+}
+
 static PyObject* asObj(void* p) { return reinterpret_cast<PyObject*>(p); }
 
 void PythonHost::clearCached() {
@@ -80,31 +193,59 @@ void PythonHost::clearCached() {
   m_fnUpdate = nullptr;
   m_fnOnEvent = nullptr;
   m_gameModule = nullptr;
+
+  for (auto& kv : m_eventNames) Py_XDECREF(asObj(kv.second));
+  m_eventNames.clear();
+}
+
+void* PythonHost::eventName(const char* name) {
+  std::string key = name ? name : ""; // event names fit the small-string buffer
+  auto it = m_eventNames.find(key);
+  if (it != m_eventNames.end()) return it->second;
+
+  PyObject* s = PyUnicode_InternFromString(key.c_str());
+  if (!s) return nullptr;
+  m_eventNames.emplace(std::move(key), s);
+  return s;
 }
 
 bool PythonHost::init(const std::string& gameModuleName) {
 
   if (m_initialized) return true;
 
-  if (!RegisterEngineModule()) {
-    std::printf("[PY] RegisterEngineModule failed\n");
-    return false;
-  }
-
-  Py_Initialize();
-  if (!Py_IsInitialized()) {
-    std::printf("[PY] Py_Initialize failed\n");
+  if (!RegisterEngineModule() || !RegisterBundleModule()) {
+    core::logError(core::LogCategory::Script, "Registering built-in modules failed");
     return false;
   }
+  TrackPythonArenas();
+
+  std::string bundlePath = FindScriptBundle();
+  if (!bundlePath.empty() && m_bundle.open(bundlePath)) {
+    if (!InitializeIsolated(bundlePath)) return false;
+    if (InstallBundleFinder(&m_bundle)) {
+      core::logInfo(core::LogCategory::Script, "Scripts from %s (%zu modules)", bundlePath.c_str(),
+                    m_bundle.moduleCount());
+    }
+  } else {
+    Py_Initialize();
+    if (!Py_IsInitialized()) {
+      core::logError(core::LogCategory::Script, "Py_Initialize failed");
+      return false;
+    }
 
 #if defined(_WIN32)
-  AddProjectPythonCandidatesToSysPath();
+    AddProjectPythonCandidatesToSysPath();
 #endif
+  }
 
   m_moduleName = gameModuleName;
+  m_profiler.start(ProfilerConfigFromEnv());
 
   PyObject* name = PyUnicode_FromString(m_moduleName.c_str());
+  m_profiler.beginScope("import", m_moduleName.c_str());
   PyObject* module = PyImport_Import(name);
+  m_profiler.endScope();
+  m_profiler.discardFrame(); // startup work is not a game frame
   Py_DECREF(name);
 
   if (!module) {
@@ -113,15 +254,30 @@ bool PythonHost::init(const std::string& gameModuleName) {
     if (sysPath) {
       PyObject* r = PyObject_Repr(sysPath);
       const char* s = r ? PyUnicode_AsUTF8(r) : nullptr;
-      std::printf("[PY] sys.path=%s\n", s ? s : "<unavailable>");
+      core::logError(core::LogCategory::Script, "sys.path=%s", s ? s : "<unavailable>");
       Py_XDECREF(r);
     }
-    std::printf("[PY] Failed to import module '%s'\n", m_moduleName.c_str());
+    core::logError(core::LogCategory::Script, "Failed to import module '%s'", m_moduleName.c_str());
+    m_profiler.stop();
     return false;
   }
 
   m_gameModule = module;
 
+#if defined(Py_GIL_DISABLED)
+  // Any extension imported so far without Py_mod_gil turned the GIL back on;
+  // engine.parallel_for then still works, but its calls take turns.
+  PyObject* gilEnabled = PySys_GetObject("_is_gil_enabled"); // borrowed
+  PyObject* enabled = gilEnabled ? PyObject_CallNoArgs(gilEnabled) : nullptr;
+  if (enabled && PyObject_IsTrue(enabled) == 1) {
+    core::logWarn(core::LogCategory::Script, "Free-threaded build, but an imported module re-enabled the GIL");
+  } else if (enabled) {
+    core::logInfo(core::LogCategory::Script, "Free-threaded build, GIL disabled");
+  }
+  Py_XDECREF(enabled);
+  PyErr_Clear();
+#endif
+
   // cache optional callables
   PyObject* fnUpdate = PyObject_GetAttrString(module, "update");
   if (fnUpdate && PyCallable_Check(fnUpdate)) {
@@ -129,7 +285,7 @@ bool PythonHost::init(const std::string& gameModuleName) {
   } else {
     Py_XDECREF(fnUpdate);
     m_fnUpdate = nullptr;
-    std::printf("[PY] Note: no callable update(dt) in %s\n", m_moduleName.c_str());
+    core::logInfo(core::LogCategory::Script, "Note: no callable update(dt) in %s", m_moduleName.c_str());
   }
 
   PyObject* fnOnEvent = PyObject_GetAttrString(module, "on_event");
@@ -147,8 +303,12 @@ bool PythonHost::init(const std::string& gameModuleName) {
 void PythonHost::shutdown() {
   if (!m_initialized) return;
 
+  m_profiler.stop();
+  m_behaviors.clear();
   clearCached();
+  m_events.clear();
 
+  UninstallBundleFinder();
   Py_Finalize();
   m_initialized = false;
 }
@@ -156,9 +316,13 @@ void PythonHost::shutdown() {
 void PythonHost::callUpdate(double dtSeconds) {
   if (!m_initialized || !m_fnUpdate) return;
 
-  PyObject* args = Py_BuildValue("(d)", dtSeconds);
-  PyObject* res = PyObject_CallObject(asObj(m_fnUpdate), args);
-  Py_DECREF(args);
+  m_profiler.beginScope("update");
+  // Vectorcall: no argument tuple per frame; the float comes from the
+  // interpreter's free list.
+  PyObject* dt = PyFloat_FromDouble(dtSeconds);
+  PyObject* res = dt ? PyObject_CallOneArg(asObj(m_fnUpdate), dt) : nullptr;
+  Py_XDECREF(dt);
+  m_profiler.endScope();
 
   if (!res) {
     PyErr_Print();
@@ -170,9 +334,16 @@ void PythonHost::callUpdate(double dtSeconds) {
 void PythonHost::callEvent(const char* name, int a, int b, int c) {
   if (!m_initialized || !m_fnOnEvent) return;
 
-  PyObject* args = Py_BuildValue("(siii)", name ? name : "", a, b, c);
-  PyObject* res = PyObject_CallObject(asObj(m_fnOnEvent), args);
-  Py_DECREF(args);
+  m_profiler.beginScope("on_event", name);
+  PyObject* argv[4] = {
+    asObj(eventName(name)), PyLong_FromLong(a), PyLong_FromLong(b), PyLong_FromLong(c)
+  };
+  PyObject* res = nullptr;
+  if (argv[0] && argv[1] && argv[2] && argv[3]) {
+    res = PyObject_Vectorcall(asObj(m_fnOnEvent), argv, 4, nullptr);
+  }
+  for (int i = 1; i < 4; ++i) Py_XDECREF(argv[i]);
+  m_profiler.endScope();
 
   if (!res) {
     PyErr_Print();
@@ -181,4 +352,25 @@ void PythonHost::callEvent(const char* name, int a, int b, int c) {
   }
 }
 
+void PythonHost::queueEvent(const char* name, int a, int b, int c) {
+  m_events.push_back({ name, a, b, c });
+}
+
+void PythonHost::dispatchEvents() {
+  // Handlers may queue more; those wait for the next frame.
+  m_dispatching.swap(m_events);
+  for (const QueuedEvent& e : m_dispatching) callEvent(e.name, e.a, e.b, e.c);
+  m_dispatching.clear();
+}
+
+void PythonHost::tickBehaviors(double dtSeconds, render::Vec3 focus) {
+  if (!m_initialized) return;
+  m_behaviors.tick(dtSeconds, focus, &m_profiler);
+}
+
+void PythonHost::endFrame() {
+  if (!m_initialized) return;
+  m_profiler.endFrame();
+}
+
 } // namespace scripting
@@ -1,5 +1,11 @@
 #pragma once
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BehaviorScheduler.h"
+#include "ScriptBundle.h"
+#include "ScriptProfiler.h"
 
 namespace scripting {
 
@@ -11,6 +17,23 @@ public:
   void callUpdate(double dtSeconds);
   void callEvent(const char* name, int a=0, int b=0, int c=0);
 
+  /// Defers an event to the next dispatchEvents(), for results that arrive
+  /// outside script time (job completions). `name` must outlive the call,
+  /// e.g. a string literal.
+  void queueEvent(const char* name, int a=0, int b=0, int c=0);
+  /// Delivers queued events in order. Once per frame, before callUpdate().
+  void dispatchEvents();
+
+  /// Runs the registered behaviors (BehaviorScheduler), once per frame after
+  /// callUpdate(). `focus` is the player position.
+  void tickBehaviors(double dtSeconds, render::Vec3 focus);
+
+  /// Marks the end of a game frame for script budget accounting.
+  void endFrame();
+
+  ScriptProfiler& profiler() { return m_profiler; }
+  BehaviorScheduler& behaviors() { return m_behaviors; }
+
 private:
   bool m_initialized = false;
   std::string m_moduleName;
@@ -20,7 +43,23 @@ private:
   void* m_fnUpdate = nullptr;    // PyObject*
   void* m_fnOnEvent = nullptr;   // PyObject*
 
+  // Interned event-name strings, so callEvent allocates nothing per call
+  // beyond ints outside the small-int cache.
+  std::unordered_map<std::string, void*> m_eventNames; // PyObject*
+
+  struct QueuedEvent {
+    const char* name;
+    int a, b, c;
+  };
+  std::vector<QueuedEvent> m_events;
+  std::vector<QueuedEvent> m_dispatching; // swapped with m_events, keeps capacity
+
+  ScriptBundle m_bundle;        // precompiled scripts.pak, if present
+  ScriptProfiler m_profiler;
+  BehaviorScheduler m_behaviors;
+
   void clearCached();
+  void* eventName(const char* name); // borrowed PyObject*
 };
 
 } // namespace scripting
@@ -0,0 +1,269 @@
+#include "ScriptBundle.h"
+#include "../core/Log.h"
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <marshal.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace scripting {
+
+// ------------------- zip index -------------------
+static uint16_t ReadU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t ReadU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const uint32_t kEocdSig    = 0x06054b50;
+static const uint32_t kCentralSig = 0x02014b50;
+static const uint32_t kLocalSig   = 0x04034b50;
+static const size_t   kPycHeader  = 16; // magic, flags, hash/mtime, hash/size
+
+bool ScriptBundle::open(const std::string& path) {
+  m_blob.clear();
+  m_index.clear();
+
+  std::ifstream file(path, std::ios::ate | std::ios::binary);
+  if (!file.is_open()) return false;
+  size_t size = (size_t)file.tellg();
+  if (size < 22) return false;
+
+  m_blob.resize(size);
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(m_blob.data()), size);
+  file.close();
+
+  const uint8_t* base = m_blob.data();
+
+  // End-of-central-directory record sits in the last 22 + 64K bytes.
+  size_t eocd = SIZE_MAX;
+  size_t stop = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+  for (size_t i = size - 22 + 1; i-- > stop;) {
+    if (ReadU32(base + i) == kEocdSig) { eocd = i; break; }
+  }
+  if (eocd == SIZE_MAX) {
+    core::logError(core::LogCategory::Script, "%s: not a zip archive", path.c_str());
+    m_blob.clear();
+    return false;
+  }
+
+  uint16_t count = ReadU16(base + eocd + 10);
+  uint32_t cdOffset = ReadU32(base + eocd + 16);
+  uint16_t commentLen = ReadU16(base + eocd + 20);
+
+  // Bytecode is only valid for the interpreter minor version it was built with.
+  std::string comment(reinterpret_cast<const char*>(base + eocd + 22),
+                      std::min<size_t>(commentLen, size - eocd - 22));
+  char expected[32];
+  std::snprintf(expected, sizeof(expected), "bspscripts %d.%d", PY_MAJOR_VERSION, PY_MINOR_VERSION);
+  if (comment != expected) {
+    core::logError(core::LogCategory::Script, "%s: built for '%s', engine expects '%s'", path.c_str(), comment.c_str(),
+                   expected);
+    m_blob.clear();
+    return false;
+  }
+
+  size_t p = cdOffset;
+  for (uint16_t i = 0; i < count; ++i) {
+    if (p + 46 > size || ReadU32(base + p) != kCentralSig) break;
+    uint16_t method   = ReadU16(base + p + 10);
+    uint32_t compSize = ReadU32(base + p + 20);
+    uint16_t nameLen  = ReadU16(base + p + 28);
+    uint16_t extraLen = ReadU16(base + p + 30);
+    uint16_t cmtLen   = ReadU16(base + p + 32);
+    uint32_t local    = ReadU32(base + p + 42);
+    const size_t next = p + 46 + (size_t)nameLen + extraLen + cmtLen;
+    if (next > size) {
+      core::logError(core::LogCategory::Script, "%s: truncated central directory", path.c_str());
+      m_blob.clear();
+      m_index.clear();
+      return false;
+    }
+    std::string name(reinterpret_cast<const char*>(base + p + 46), nameLen);
+    p = next;
+
+    if (method != 0) continue; // stored only; we serve bytes in place
+    if ((size_t)local + 30 > size || ReadU32(base + local) != kLocalSig) continue;
+    uint32_t dataOff = local + 30 + ReadU16(base + local + 26) + ReadU16(base + local + 28);
+    if ((size_t)dataOff + compSize > size || compSize < kPycHeader) continue;
+
+    // "a/b/__init__.pyc" -> package "a.b", "a/b.pyc" -> module "a.b"
+    const char* kExt = ".pyc";
+    if (name.size() <= 4 || name.compare(name.size() - 4, 4, kExt) != 0) continue;
+    name.resize(name.size() - 4);
+
+    Entry e{};
+    e.offset = dataOff;
+    e.size = compSize;
+    const std::string kInit = "/__init__";
+    if (name.size() > kInit.size() && name.compare(name.size() - kInit.size(), kInit.size(), kInit) == 0) {
+      name.resize(name.size() - kInit.size());
+      e.isPackage = true;
+    }
+    for (char& c : name) if (c == '/') c = '.';
+    m_index[name] = e;
+  }
+
+  m_path = path;
+  return true;
+}
+
+const ScriptBundle::Entry* ScriptBundle::find(const std::string& moduleName) const {
+  auto it = m_index.find(moduleName);
+  return it != m_index.end() ? &it->second : nullptr;
+}
+
+// ------------------- _bundle module (finder + loader) -------------------
+static const ScriptBundle* g_bundle = nullptr;
+static PyObject* g_moduleSpecType = nullptr; // importlib.machinery.ModuleSpec
+
+static PyObject* bundle_find_spec(PyObject* self, PyObject* args) {
+  const char* name = nullptr;
+  PyObject* path = nullptr;
+  PyObject* target = nullptr;
+  if (!PyArg_ParseTuple(args, "s|OO", &name, &path, &target)) return nullptr;
+
+  const ScriptBundle::Entry* e = g_bundle ? g_bundle->find(name) : nullptr;
+  if (!e || !g_moduleSpecType) Py_RETURN_NONE;
+
+  // Mirrors the archive path so __file__ and tracebacks point into the pak.
+  std::string origin = g_bundle->path() + "/" + name;
+  for (size_t i = g_bundle->path().size() + 1; i < origin.size(); ++i) {
+    if (origin[i] == '.') origin[i] = '/';
+  }
+  origin += e->isPackage ? "/__init__.pyc" : ".pyc";
+
+  PyObject* posArgs = Py_BuildValue("(sO)", name, self);
+  PyObject* kwArgs = Py_BuildValue("{s:s,s:O}", "origin", origin.c_str(),
+                                   "is_package", e->isPackage ? Py_True : Py_False);
+  PyObject* spec = (posArgs && kwArgs) ? PyObject_Call(g_moduleSpecType, posArgs, kwArgs) : nullptr;
+  Py_XDECREF(posArgs);
+  Py_XDECREF(kwArgs);
+  if (spec && PyObject_SetAttrString(spec, "has_location", Py_True) != 0) PyErr_Clear();
+  return spec;
+}
+
+static PyObject* bundle_create_module(PyObject*, PyObject*) {
+  Py_RETURN_NONE; // default module creation
+}
+
+static PyObject* bundle_exec_module(PyObject*, PyObject* module) {
+  PyObject* nameObj = PyObject_GetAttrString(module, "__name__");
+  const char* name = nameObj ? PyUnicode_AsUTF8(nameObj) : nullptr;
+  if (!name) {
+    Py_XDECREF(nameObj);
+    return nullptr;
+  }
+
+  const ScriptBundle::Entry* e = g_bundle ? g_bundle->find(name) : nullptr;
+  if (!e) {
+    PyErr_Format(PyExc_ImportError, "'%s' is not in the script bundle", name);
+    Py_DECREF(nameObj);
+    return nullptr;
+  }
+
+  const uint8_t* pyc = g_bundle->data(*e);
+  long magic = PyImport_GetMagicNumber();
+  uint32_t fileMagic = (uint32_t)pyc[0] | ((uint32_t)pyc[1] << 8) | ((uint32_t)pyc[2] << 16) | ((uint32_t)pyc[3] << 24);
+  if (magic == -1 || fileMagic != (uint32_t)magic) {
+    PyErr_Format(PyExc_ImportError, "bad bytecode magic for '%s' in script bundle", name);
+    Py_DECREF(nameObj);
+    return nullptr;
+  }
+  Py_DECREF(nameObj);
+
+  PyObject* code = PyMarshal_ReadObjectFromString(reinterpret_cast<const char*>(pyc + kPycHeader),
+                                                  (Py_ssize_t)(e->size - kPycHeader));
+  if (!code) return nullptr;
+
+  PyObject* dict = PyModule_GetDict(module); // borrowed
+  PyObject* res = PyEval_EvalCode(code, dict, dict);
+  Py_DECREF(code);
+  if (!res) return nullptr;
+  Py_DECREF(res);
+  Py_RETURN_NONE;
+}
+
+static PyMethodDef kBundleMethods[] = {
+  {"find_spec", bundle_find_spec, METH_VARARGS, "find_spec(name, path=None, target=None) -> ModuleSpec|None"},
+  {"create_module", bundle_create_module, METH_O, "create_module(spec) -> None"},
+  {"exec_module", bundle_exec_module, METH_O, "exec_module(module) -> None"},
+  {nullptr, nullptr, 0, nullptr}
+};
+
+// Stateless (g_bundle is set once before the import), so nothing stops it
+// from running without the GIL; single-phase init would turn it back on.
+static PyModuleDef_Slot kBundleSlots[] = {
+#if PY_VERSION_HEX >= 0x030C0000
+  {Py_mod_multiple_interpreters, Py_MOD_MULTIPLE_INTERPRETERS_SUPPORTED},
+#endif
+#if PY_VERSION_HEX >= 0x030D0000
+  {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+  {0, nullptr}
+};
+
+static struct PyModuleDef kBundleModule = {
+  PyModuleDef_HEAD_INIT,
+  "_bundle",
+  "Meta-path finder serving precompiled modules from scripts.pak (embedded).",
+  0,
+  kBundleMethods,
+  kBundleSlots,
+  nullptr,
+  nullptr,
+  nullptr
+};
+
+extern "C" PyMODINIT_FUNC PyInit__bundle(void) {
+  return PyModuleDef_Init(&kBundleModule);
+}
+
+bool RegisterBundleModule() {
+  // Must happen before Py_Initialize()
+  return PyImport_AppendInittab("_bundle", &PyInit__bundle) == 0;
+}
+
+bool InstallBundleFinder(const ScriptBundle* bundle) {
+  if (!bundle || !bundle->isOpen()) return false;
+  g_bundle = bundle;
+
+  if (!g_moduleSpecType) {
+    PyObject* bootstrap = PyImport_ImportModule("_frozen_importlib");
+    g_moduleSpecType = bootstrap ? PyObject_GetAttrString(bootstrap, "ModuleSpec") : nullptr;
+    Py_XDECREF(bootstrap);
+  }
+  PyObject* finder = PyImport_ImportModule("_bundle");
+  PyObject* metaPath = PySys_GetObject("meta_path"); // borrowed
+  if (!g_moduleSpecType || !finder || !metaPath || !PyList_Check(metaPath)) {
+    PyErr_Print();
+    Py_XDECREF(finder);
+    return false;
+  }
+
+  // Builtin and frozen importers stay first; we go right before PathFinder.
+  Py_ssize_t insertAt = PyList_Size(metaPath);
+  for (Py_ssize_t i = 0; i < PyList_Size(metaPath); ++i) {
+    PyObject* nameObj = PyObject_GetAttrString(PyList_GetItem(metaPath, i), "__name__");
+    const char* n = nameObj ? PyUnicode_AsUTF8(nameObj) : nullptr;
+    bool isPathFinder = n && std::strcmp(n, "PathFinder") == 0;
+    Py_XDECREF(nameObj);
+    PyErr_Clear();
+    if (isPathFinder) { insertAt = i; break; }
+  }
+  int rc = PyList_Insert(metaPath, insertAt, finder);
+  Py_DECREF(finder);
+  return rc == 0;
+}
+
+void UninstallBundleFinder() {
+  // Called right before Py_Finalize; the finder goes away with sys.meta_path.
+  Py_CLEAR(g_moduleSpecType);
+  g_bundle = nullptr;
+}
+
+} // namespace scripting
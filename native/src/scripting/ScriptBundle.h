@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../memory/MemoryTracker.h"
+
+namespace scripting {
+
+/// Precompiled script archive (scripts.pak, built by tools/pack_scripts.py).
+///
+/// The pak is a zip of STORED unchecked-hash .pyc files. It is read into memory
+/// once and indexed by dotted module name, so imports served from it never
+/// touch the filesystem.
+class ScriptBundle {
+public:
+  struct Entry {
+    uint32_t offset = 0; // of the .pyc bytes inside the blob
+    uint32_t size = 0;
+    bool isPackage = false;
+  };
+
+  bool open(const std::string& path);
+  bool isOpen() const { return !m_blob.empty(); }
+
+  const std::string& path() const { return m_path; }
+  size_t moduleCount() const { return m_index.size(); }
+
+  const Entry* find(const std::string& moduleName) const;
+  const uint8_t* data(const Entry& e) const { return m_blob.data() + e.offset; }
+
+private:
+  std::string m_path;
+  memory::TrackedVector<uint8_t, memory::MemTag::Scripting> m_blob;
+  memory::TrackedMap<std::string, Entry, memory::MemTag::Scripting> m_index;
+};
+
+/// Registers the built-in "_bundle" module (meta-path finder + loader).
+/// Must be called BEFORE Py_Initialize(), via PyImport_AppendInittab.
+bool RegisterBundleModule();
+
+/// Serves imports from `bundle` by inserting "_bundle" into sys.meta_path ahead
+/// of the path-based finder. Call after Py_Initialize(); bundle must outlive Python.
+bool InstallBundleFinder(const ScriptBundle* bundle);
+
+/// Drops cached interpreter objects. Call right before Py_Finalize().
+void UninstallBundleFinder();
+
+} // namespace scripting
@@ -0,0 +1,271 @@
+#include "ScriptProfiler.h"
+#include "../core/Log.h"
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace scripting {
+
+static double MsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static std::string AttrString(PyObject* obj, const char* attr) {
+  std::string out;
+  PyObject* v = PyObject_GetAttrString(obj, attr);
+  if (v && PyUnicode_Check(v)) {
+    const char* s = PyUnicode_AsUTF8(v);
+    if (s) out = s;
+  }
+  Py_XDECREF(v);
+  if (PyErr_Occurred()) PyErr_Clear();
+  return out;
+}
+
+ScriptProfiler::~ScriptProfiler() {
+  // Normally stop() ran before Py_Finalize; just make sure the thread is gone.
+  m_stop = true;
+  m_wake.notify_all();
+  if (m_watchdog.joinable()) m_watchdog.join();
+}
+
+void ScriptProfiler::start(const Config& cfg) {
+  if (m_running) return;
+  m_cfg = cfg;
+  m_running = true;
+  m_stop = false;
+
+#if defined(Py_GIL_DISABLED)
+  // Sampling walks the script thread's frames while holding the GIL, which
+  // parks that thread; free-threaded builds have nothing that stops it.
+  if (m_cfg.sampling) {
+    core::logWarn(core::LogCategory::Script, "Script sampling needs the GIL; budgets only");
+    m_cfg.sampling = false;
+  }
+#endif
+  if (m_cfg.sampling) {
+    if (m_cfg.sampleIntervalMs < 0.1) m_cfg.sampleIntervalMs = 0.1;
+    m_scriptThread = PyThreadState_Get();
+
+    // The script thread only hands over the GIL at the switch interval, which
+    // bounds how often the watchdog can get in. Match it to the sample period.
+    PyObject* sys = PyImport_ImportModule("sys");
+    PyObject* r = sys ? PyObject_CallMethod(sys, "setswitchinterval", "d", m_cfg.sampleIntervalMs / 1000.0) : nullptr;
+    Py_XDECREF(r);
+    Py_XDECREF(sys);
+    if (PyErr_Occurred()) PyErr_Clear();
+
+    m_watchdog = std::thread([this] { watchdogMain(); });
+    core::logInfo(core::LogCategory::Script, "Script sampling on (%.2f ms interval)", m_cfg.sampleIntervalMs);
+  }
+}
+
+void ScriptProfiler::stop() {
+  if (!m_running) return;
+
+  m_stop = true;
+  m_wake.notify_all();
+  if (m_watchdog.joinable()) {
+    // The watchdog may be parked in PyGILState_Ensure; let it through.
+    Py_BEGIN_ALLOW_THREADS
+    m_watchdog.join();
+    Py_END_ALLOW_THREADS
+  }
+
+  if (m_cfg.sampling && m_totalSamples > 0) {
+    if (dumpFolded(m_cfg.foldedPath.c_str())) {
+      core::logInfo(core::LogCategory::Script, "Folded stacks written to %s", m_cfg.foldedPath.c_str());
+    }
+  }
+  printReport();
+
+  for (auto& kv : m_codeNames) Py_DECREF(reinterpret_cast<PyObject*>(kv.first));
+  m_codeNames.clear();
+  m_scriptThread = nullptr;
+  m_running = false;
+}
+
+void ScriptProfiler::beginScope(const char* behavior, const char* detail) {
+  if (!m_running) return;
+  if (m_depth++ > 0) return;
+
+  m_behavior.assign(behavior ? behavior : "?");
+  if (detail && detail[0]) {
+    m_behavior += '/';
+    m_behavior += detail;
+  }
+  m_scopeStart = Clock::now();
+  m_inScope.store(true, std::memory_order_release);
+}
+
+void ScriptProfiler::endScope() {
+  if (!m_running || m_depth == 0) return;
+  if (--m_depth > 0) return;
+
+  m_inScope.store(false, std::memory_order_release);
+  double ms = MsSince(m_scopeStart);
+  m_frameMs += ms;
+
+  BehaviorStats& b = m_behaviors[m_behavior];
+  b.calls++;
+  b.totalMs += ms;
+  b.maxMs = std::max(b.maxMs, ms);
+}
+
+void ScriptProfiler::endFrame() {
+  if (!m_running) return;
+
+  if (m_cfg.frameBudgetMs > 0.0 && m_frameMs > m_cfg.frameBudgetMs) {
+    m_framesOverBudget++;
+
+    const std::string* hottest = nullptr;
+    uint64_t best = 0;
+    for (const auto& kv : m_frameLeafSamples) {
+      if (kv.second > best) { best = kv.second; hottest = &kv.first; }
+    }
+    if (hottest) {
+      core::logWarn(core::LogCategory::Script,
+                    "Frame %llu: scripts took %.2f ms (budget %.2f ms), hottest %s (%llu samples)",
+                    (unsigned long long)m_frameNo, m_frameMs, m_cfg.frameBudgetMs, hottest->c_str(),
+                    (unsigned long long)best);
+    } else {
+      core::logWarn(core::LogCategory::Script, "Frame %llu: scripts took %.2f ms (budget %.2f ms)",
+                    (unsigned long long)m_frameNo, m_frameMs, m_cfg.frameBudgetMs);
+    }
+  }
+
+  m_frameMs = 0.0;
+  m_frameLeafSamples.clear();
+  m_frameNo++;
+}
+
+void ScriptProfiler::discardFrame() {
+  m_frameMs = 0.0;
+  m_frameLeafSamples.clear();
+}
+
+// ------------------- sampling -------------------
+void ScriptProfiler::watchdogMain() {
+  const auto period = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double, std::milli>(m_cfg.sampleIntervalMs));
+
+  while (!m_stop.load()) {
+    {
+      std::unique_lock<std::mutex> lock(m_wakeMutex);
+      m_wake.wait_for(lock, period, [this] { return m_stop.load(); });
+    }
+    if (m_stop.load()) break;
+    if (!m_inScope.load(std::memory_order_acquire)) continue;
+
+    // Taking the GIL parks the script thread at a bytecode boundary, so its
+    // frame chain is stable while we walk it. Aggregates are only touched
+    // with the GIL held, on either thread.
+    PyGILState_STATE gil = PyGILState_Ensure();
+    if (!m_stop.load() && m_depth > 0) takeSample();
+    PyGILState_Release(gil);
+  }
+}
+
+const std::string& ScriptProfiler::describeCode(void* code) {
+  auto it = m_codeNames.find(code);
+  if (it != m_codeNames.end()) return it->second;
+
+  PyObject* co = reinterpret_cast<PyObject*>(code);
+  std::string file = AttrString(co, "co_filename");
+  size_t slash = file.find_last_of("\\/");
+  if (slash != std::string::npos) file.erase(0, slash + 1);
+
+  std::string fn = AttrString(co, "co_qualname");
+  if (fn.empty()) fn = AttrString(co, "co_name");
+
+  Py_INCREF(co); // keep the key alive so the pointer can't be recycled
+  return m_codeNames.emplace(code, file + ":" + fn).first->second;
+}
+
+void ScriptProfiler::takeSample() {
+  PyThreadState* ts = reinterpret_cast<PyThreadState*>(m_scriptThread);
+  PyFrameObject* frame = ts ? PyThreadState_GetFrame(ts) : nullptr; // new ref
+  if (!frame) return;
+
+  m_stack.clear();
+  while (frame) {
+    PyCodeObject* code = PyFrame_GetCode(frame); // new ref
+    m_stack.push_back(&describeCode(code));
+    Py_DECREF(code);
+
+    PyFrameObject* back = PyFrame_GetBack(frame); // new ref
+    Py_DECREF(frame);
+    frame = back;
+  }
+  if (m_stack.empty()) return;
+
+  m_totalSamples++;
+  m_behaviors[m_behavior].samples++;
+  m_frameLeafSamples[*m_stack.front()]++;
+
+  // m_stack is leaf-first; folded format wants root-first.
+  m_key.assign(m_behavior);
+  for (size_t i = m_stack.size(); i > 0; --i) {
+    const std::string* name = m_stack[i - 1];
+    m_key += ';';
+    m_key += *name;
+
+    // inclusive count, once per sample even under recursion
+    bool seenAbove = false;
+    for (size_t j = m_stack.size(); j > i; --j) {
+      if (m_stack[j - 1] == name) { seenAbove = true; break; }
+    }
+    if (!seenAbove) m_functions[*name].totalSamples++;
+  }
+  m_folded[m_key]++;
+  m_functions[*m_stack.front()].selfSamples++;
+}
+
+// ------------------- output -------------------
+bool ScriptProfiler::dumpFolded(const char* path) const {
+  if (!path || !path[0]) return false;
+  std::FILE* f = std::fopen(path, "wb");
+  if (!f) {
+    core::logError(core::LogCategory::Script, "Could not open %s for writing", path);
+    return false;
+  }
+  for (const auto& kv : m_folded) {
+    std::fprintf(f, "%s %llu\n", kv.first.c_str(), (unsigned long long)kv.second);
+  }
+  std::fclose(f);
+  return true;
+}
+
+void ScriptProfiler::printReport(size_t topN) const {
+  if (m_behaviors.empty()) return;
+
+  core::logInfo(core::LogCategory::Script, "Script profile: %llu frames, %llu over budget, %llu samples",
+                (unsigned long long)m_frameNo, (unsigned long long)m_framesOverBudget,
+                (unsigned long long)m_totalSamples);
+
+  std::vector<std::pair<std::string, BehaviorStats>> behaviors(m_behaviors.begin(), m_behaviors.end());
+  std::sort(behaviors.begin(), behaviors.end(),
+            [](const auto& a, const auto& b) { return a.second.totalMs > b.second.totalMs; });
+  for (const auto& [name, b] : behaviors) {
+    double avg = b.calls ? b.totalMs / (double)b.calls : 0.0;
+    core::logInfo(core::LogCategory::Script, "  %-24s calls=%-8llu total=%9.2f ms avg=%7.3f ms max=%7.3f ms",
+                  name.c_str(), (unsigned long long)b.calls, b.totalMs, avg, b.maxMs);
+  }
+
+  if (m_functions.empty()) return;
+  std::vector<std::pair<std::string, FunctionStats>> fns(m_functions.begin(), m_functions.end());
+  std::sort(fns.begin(), fns.end(),
+            [](const auto& a, const auto& b) { return a.second.selfSamples > b.second.selfSamples; });
+  if (fns.size() > topN) fns.resize(topN);
+
+  core::logInfo(core::LogCategory::Script, "  top functions (self / total samples):");
+  for (const auto& [name, s] : fns) {
+    core::logInfo(core::LogCategory::Script, "    %6llu / %-6llu %s", (unsigned long long)s.selfSamples,
+                  (unsigned long long)s.totalSamples, name.c_str());
+  }
+}
+
+} // namespace scripting
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace scripting {
+
+/// Native profiler for embedded Python scripts.
+///
+/// Two layers:
+/// - Scope timing (always on, cheap): PythonHost brackets every call into Python
+///   with beginScope()/endScope(). Time is aggregated per behavior (entry point)
+///   and summed per frame; frames over budget get flagged in the log.
+/// - Sampling (opt-in): a watchdog thread wakes every sampleIntervalMs and, while
+///   a scope is active, takes the GIL and walks the script thread's frame chain
+///   via PyThreadState_GetFrame/PyFrame_GetBack. The script thread is parked at a
+///   bytecode boundary meanwhile, so the stack it reports is consistent.
+class ScriptProfiler {
+public:
+  struct Config {
+    bool sampling = false;          // enable watchdog sampling
+    double sampleIntervalMs = 1.0;  // watchdog period
+    double frameBudgetMs = 4.0;     // script time per frame before we warn (<= 0 disables)
+    std::string foldedPath = "script_profile.folded";
+  };
+
+  ~ScriptProfiler();
+
+  /// Call after Py_Initialize, on the thread that runs scripts.
+  void start(const Config& cfg);
+  /// Call before Py_Finalize; releases cached code objects.
+  void stop();
+
+  // Script thread only (GIL held). Scopes may nest; only the outermost is timed.
+  void beginScope(const char* behavior, const char* detail = nullptr);
+  void endScope();
+
+  /// Closes the current frame: checks the budget and resets per-frame stats.
+  void endFrame();
+  /// Drops time accumulated since the last endFrame() (e.g. module import).
+  void discardFrame();
+
+  /// Writes "behavior;file:func;...;leaf count" lines (flamegraph.pl / speedscope).
+  bool dumpFolded(const char* path) const;
+  void printReport(size_t topN = 10) const;
+
+  const Config& config() const { return m_cfg; }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct BehaviorStats {
+    uint64_t calls = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    uint64_t samples = 0;
+  };
+
+  struct FunctionStats {
+    uint64_t selfSamples = 0;
+    uint64_t totalSamples = 0;
+  };
+
+  void watchdogMain();
+  void takeSample();
+  const std::string& describeCode(void* code); // PyCodeObject*
+
+  Config m_cfg{};
+  bool m_running = false;
+
+  // scope state (script thread)
+  int m_depth = 0;
+  std::string m_behavior;
+  Clock::time_point m_scopeStart{};
+  double m_frameMs = 0.0;
+  uint64_t m_frameNo = 0;
+  uint64_t m_framesOverBudget = 0;
+
+  // sampling state
+  std::thread m_watchdog;
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_inScope{false};
+  void* m_scriptThread = nullptr; // PyThreadState* of the thread running scripts
+  uint64_t m_totalSamples = 0;
+
+  // aggregates (only touched with the GIL held)
+  std::unordered_map<std::string, BehaviorStats> m_behaviors;
+  std::unordered_map<std::string, FunctionStats> m_functions;
+  std::unordered_map<std::string, uint64_t> m_folded;
+  std::unordered_map<std::string, uint64_t> m_frameLeafSamples;
+  std::unordered_map<void*, std::string> m_codeNames; // holds a ref on each key
+
+  // scratch reused per sample to avoid churn
+  std::vector<const std::string*> m_stack;
+  std::string m_key;
+};
+
+} // namespace scripting
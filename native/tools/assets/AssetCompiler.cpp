@@ -0,0 +1,277 @@
+// Offline asset compiler: builds assets.pak from the asset source folder.
+//
+//   AssetCompiler --assets <dir> --out <assets.pak> [options]
+//
+//   --cache <dir>       compiled-texture cache (default <out>.cache)
+//   --threads <n>       worker threads (all cores)
+//   --opaque-bc1        opaque colour/data textures as BC1 instead of BC7
+//
+// PNGs become block-compressed textures with full mip chains (see
+// Texture.h for the naming rules), WAVs 16-bit PCM sounds (Wav.h); every
+// other file is stored as is. Each compiled texture is cached under the
+// hash of its source bytes and the settings that affect it, so a rebuild
+// only re-encodes changed textures.
+
+#include "Png.h"
+#include "Texture.h"
+#include "Wav.h"
+#include "core/JobSystem.h"
+#include "core/PakFormat.h"
+#include "render/TextureFormat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+  std::string assets, out, cache;
+  unsigned threads = 0;
+  assets::TextureSettings texture;
+};
+
+void usage() {
+  std::printf("usage: AssetCompiler --assets <dir> --out <assets.pak> [--cache <dir>] [--threads n] [--opaque-bc1]\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (std::strcmp(a, "--opaque-bc1") == 0) {
+      o.texture.opaqueBc1 = true;
+      continue;
+    }
+    if (i + 1 >= argc) return false;
+    const char* v = argv[++i];
+    if (std::strcmp(a, "--assets") == 0) o.assets = v;
+    else if (std::strcmp(a, "--out") == 0) o.out = v;
+    else if (std::strcmp(a, "--cache") == 0) o.cache = v;
+    else if (std::strcmp(a, "--threads") == 0) o.threads = (unsigned)std::atoi(v);
+    else return false;
+  }
+  if (o.assets.empty() || o.out.empty()) return false;
+  if (o.cache.empty()) o.cache = o.out + ".cache";
+  return true;
+}
+
+bool readFile(const fs::path& path, std::vector<uint8_t>& out) {
+  std::FILE* f = std::fopen(path.string().c_str(), "rb");
+  if (!f) return false;
+  std::fseek(f, 0, SEEK_END);
+  long size = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  out.resize(size > 0 ? (size_t)size : 0);
+  bool ok = size >= 0 && (out.empty() || std::fread(out.data(), 1, out.size(), f) == out.size());
+  std::fclose(f);
+  return ok;
+}
+
+bool writeFile(const fs::path& path, const std::vector<uint8_t>& data) {
+  std::FILE* f = std::fopen(path.string().c_str(), "wb");
+  if (!f) return false;
+  bool ok = data.empty() || std::fwrite(data.data(), 1, data.size(), f) == data.size();
+  ok = std::fclose(f) == 0 && ok;
+  return ok;
+}
+
+// FNV-1a, 64-bit.
+uint64_t hashBytes(const void* data, size_t size, uint64_t h = 0xCBF29CE484222325ull) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    h ^= p[i];
+    h *= 0x100000001B3ull;
+  }
+  return h;
+}
+
+struct Entry {
+  std::string name; // '/' separated, relative to the asset root
+  core::PakEntryType type = core::PakEntryType::Raw;
+  uint64_t hash = 0;
+  std::vector<uint8_t> data;
+};
+
+bool cachedBlobValid(const std::vector<uint8_t>& blob) {
+  if (blob.size() < sizeof(render::TextureHeader)) return false;
+  render::TextureHeader h;
+  std::memcpy(&h, blob.data(), sizeof(h));
+  if (std::memcmp(h.magic, "BTEX", 4) != 0 || h.version != render::kTextureVersion || h.mipCount == 0 ||
+      h.mipCount > render::kMaxTextureMips) {
+    return false;
+  }
+  const render::TextureLevel& last = h.levels[h.mipCount - 1];
+  return (size_t)last.offset + last.size <= blob.size();
+}
+
+bool writePak(const std::string& path, std::vector<Entry>& entries) {
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.name < b.name; });
+
+  core::PakHeader header;
+  header.version = core::kPakVersion;
+  header.entryCount = (uint32_t)entries.size();
+  std::vector<core::PakEntry> table(entries.size());
+  std::string names;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    table[i].nameOffset = (uint32_t)names.size();
+    table[i].nameLength = (uint32_t)entries[i].name.size();
+    table[i].type = entries[i].type;
+    table[i].sourceHash = entries[i].hash;
+    table[i].size = entries[i].data.size();
+    names += entries[i].name;
+  }
+  header.nameBytes = (uint32_t)names.size();
+
+  auto align = [](uint64_t v) { return (v + core::kPakAlignment - 1) & ~(uint64_t)(core::kPakAlignment - 1); };
+  uint64_t offset = align(sizeof(header) + table.size() * sizeof(core::PakEntry) + names.size());
+  header.dataOffset = offset;
+  for (core::PakEntry& e : table) {
+    e.offset = offset;
+    offset = align(offset + e.size);
+  }
+
+  std::vector<uint8_t> file(offset, 0);
+  std::memcpy(file.data(), &header, sizeof(header));
+  if (!table.empty()) std::memcpy(file.data() + sizeof(header), table.data(), table.size() * sizeof(core::PakEntry));
+  std::memcpy(file.data() + sizeof(header) + table.size() * sizeof(core::PakEntry), names.data(), names.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (!entries[i].data.empty()) std::memcpy(file.data() + table[i].offset, entries[i].data.data(), entries[i].data.size());
+  }
+
+  // Write next to the target and swap, so a failed build never leaves a torn pak.
+  std::string tmp = path + ".tmp";
+  if (!writeFile(tmp, file)) return false;
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  return !ec;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) {
+    usage();
+    return 2;
+  }
+  auto start = std::chrono::steady_clock::now();
+
+  std::error_code ec;
+  if (!fs::is_directory(o.assets, ec)) {
+    std::printf("[ERR ] Asset folder not found: %s\n", o.assets.c_str());
+    return 1;
+  }
+  fs::create_directories(o.cache, ec);
+  if (fs::path(o.out).has_parent_path()) fs::create_directories(fs::path(o.out).parent_path(), ec);
+
+  std::vector<fs::path> files;
+  for (const fs::directory_entry& de : fs::recursive_directory_iterator(o.assets, ec)) {
+    if (de.is_regular_file()) files.push_back(de.path());
+  }
+  std::sort(files.begin(), files.end());
+
+  core::JobSystem jobs;
+  jobs.init(o.threads);
+
+  // Everything that changes encoder output goes into the cache key.
+  const uint32_t settingsKey[2] = { assets::kEncoderVersion, o.texture.opaqueBc1 ? 1u : 0u };
+
+  std::vector<Entry> entries;
+  uint32_t compiled = 0, cached = 0, failed = 0;
+  uint64_t sourceBytes = 0, outputBytes = 0;
+  std::vector<uint8_t> bytes;
+  for (const fs::path& file : files) {
+    Entry e;
+    e.name = fs::relative(file, o.assets, ec).generic_string();
+    if (!readFile(file, bytes)) {
+      std::printf("[ERR ] Cannot read %s\n", file.string().c_str());
+      ++failed;
+      continue;
+    }
+    sourceBytes += bytes.size();
+
+    std::string ext = file.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    if (ext == ".wav") {
+      // Cheap to decode, so not cached.
+      std::string error;
+      e.type = core::PakEntryType::Sound;
+      e.name.replace(e.name.size() - 4, 4, ".bsnd");
+      e.hash = hashBytes(bytes.data(), bytes.size());
+      if (!assets::compileSound(bytes.data(), bytes.size(), e.data, error)) {
+        std::printf("[ERR ] %s: %s\n", file.string().c_str(), error.c_str());
+        ++failed;
+        continue;
+      }
+      outputBytes += e.data.size();
+      entries.push_back(std::move(e));
+      continue;
+    }
+    if (ext != ".png") {
+      e.hash = hashBytes(bytes.data(), bytes.size());
+      e.data = std::move(bytes);
+      outputBytes += e.data.size();
+      entries.push_back(std::move(e));
+      continue;
+    }
+
+    assets::TextureKind kind = assets::textureKindFor(e.name.c_str());
+    e.type = core::PakEntryType::Texture;
+    e.name.replace(e.name.size() - 4, 4, ".btex");
+    e.hash = hashBytes(bytes.data(), bytes.size());
+    e.hash = hashBytes(settingsKey, sizeof(settingsKey), e.hash);
+    e.hash = hashBytes(&kind, sizeof(kind), e.hash);
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", (unsigned long long)e.hash);
+    fs::path cacheFile = fs::path(o.cache) / (std::string(key) + ".btex");
+    if (readFile(cacheFile, e.data) && cachedBlobValid(e.data)) {
+      ++cached;
+    } else {
+      assets::Image image;
+      std::string error;
+      if (!assets::decodePng(bytes.data(), bytes.size(), image, error)) {
+        std::printf("[ERR ] %s: %s\n", file.string().c_str(), error.c_str());
+        ++failed;
+        continue;
+      }
+      auto t0 = std::chrono::steady_clock::now();
+      e.data = assets::compileTexture(image, kind, o.texture, jobs);
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+      if (!writeFile(cacheFile, e.data)) {
+        std::printf("[WARN] Cannot write cache entry %s\n", cacheFile.string().c_str());
+      }
+
+      render::TextureHeader h;
+      std::memcpy(&h, e.data.data(), sizeof(h));
+      std::printf("[INFO] %s: %ux%u, %u mips, format %u, %.1f KiB (%.0f ms)\n", e.name.c_str(), h.width, h.height,
+                  h.mipCount, h.vkFormat, (double)e.data.size() / 1024.0, ms);
+      ++compiled;
+    }
+    outputBytes += e.data.size();
+    entries.push_back(std::move(e));
+  }
+  jobs.shutdown();
+
+  if (failed > 0) {
+    std::printf("[ERR ] %u asset(s) failed, %s not written\n", failed, o.out.c_str());
+    return 1;
+  }
+  if (!writePak(o.out, entries)) {
+    std::printf("[ERR ] Cannot write %s\n", o.out.c_str());
+    return 1;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("[INFO] %s: %zu entries (%u textures compiled, %u cached), %.1f MiB from %.1f MiB source, %.2f s\n",
+              o.out.c_str(), entries.size(), compiled, cached, (double)outputBytes / (1024.0 * 1024.0),
+              (double)sourceBytes / (1024.0 * 1024.0), seconds);
+  return 0;
+}
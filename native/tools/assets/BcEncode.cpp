@@ -0,0 +1,324 @@
+#include "BcEncode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace assets {
+
+namespace {
+
+// Principal axis of `n` points with `dims` channels (power iteration on the
+// covariance). Returns false for a flat block.
+template <int Dims>
+bool principalAxis(const float (*p)[Dims], int n, float mean[Dims], float axis[Dims]) {
+  for (int c = 0; c < Dims; ++c) {
+    mean[c] = 0.0f;
+    for (int i = 0; i < n; ++i) mean[c] += p[i][c];
+    mean[c] /= (float)n;
+  }
+  float cov[Dims][Dims] = {};
+  for (int i = 0; i < n; ++i) {
+    for (int a = 0; a < Dims; ++a) {
+      for (int b = a; b < Dims; ++b) cov[a][b] += (p[i][a] - mean[a]) * (p[i][b] - mean[b]);
+    }
+  }
+  for (int a = 0; a < Dims; ++a) {
+    for (int b = 0; b < a; ++b) cov[a][b] = cov[b][a];
+  }
+
+  // Seed with the channel of largest variance.
+  int best = 0;
+  for (int c = 1; c < Dims; ++c) {
+    if (cov[c][c] > cov[best][best]) best = c;
+  }
+  if (cov[best][best] <= 1e-6f) return false;
+  for (int c = 0; c < Dims; ++c) axis[c] = cov[best][c];
+  for (int iter = 0; iter < 8; ++iter) {
+    float next[Dims] = {};
+    for (int a = 0; a < Dims; ++a) {
+      for (int b = 0; b < Dims; ++b) next[a] += cov[a][b] * axis[b];
+    }
+    float len = 0.0f;
+    for (int c = 0; c < Dims; ++c) len += next[c] * next[c];
+    if (len <= 1e-20f) return false;
+    len = 1.0f / std::sqrt(len);
+    for (int c = 0; c < Dims; ++c) axis[c] = next[c] * len;
+  }
+  return true;
+}
+
+// Endpoints at the extremes of the points' projections onto the axis.
+template <int Dims>
+void axisEndpoints(const float (*p)[Dims], int n, const float mean[Dims], const float axis[Dims], float e0[Dims],
+                   float e1[Dims]) {
+  float tMin = 1e30f, tMax = -1e30f;
+  for (int i = 0; i < n; ++i) {
+    float t = 0.0f;
+    for (int c = 0; c < Dims; ++c) t += (p[i][c] - mean[c]) * axis[c];
+    tMin = std::min(tMin, t);
+    tMax = std::max(tMax, t);
+  }
+  for (int c = 0; c < Dims; ++c) {
+    e0[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+    e1[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+  }
+}
+
+// Least-squares endpoints for fixed interpolation weights w[i] in [0, 1]
+// (palette = e0 * (1 - w) + e1 * w). False when the system is singular,
+// e.g. every texel picked the same index.
+template <int Dims>
+bool refineEndpoints(const float (*p)[Dims], int n, const float* w, float e0[Dims], float e1[Dims]) {
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+  float ax[Dims] = {}, bx[Dims] = {};
+  for (int i = 0; i < n; ++i) {
+    float b = w[i], a = 1.0f - b;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int c = 0; c < Dims; ++c) {
+      ax[c] += a * p[i][c];
+      bx[c] += b * p[i][c];
+    }
+  }
+  float det = aa * bb - ab * ab;
+  if (std::fabs(det) < 1e-6f) return false;
+  float inv = 1.0f / det;
+  for (int c = 0; c < Dims; ++c) {
+    e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) * inv, 0.0f, 255.0f);
+    e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) * inv, 0.0f, 255.0f);
+  }
+  return true;
+}
+
+// Little-endian bit writer for 64/128-bit blocks.
+struct BitWriter {
+  uint8_t* out;
+  uint32_t pos = 0;
+
+  void put(uint32_t value, uint32_t bits) {
+    for (uint32_t i = 0; i < bits; ++i, ++pos) {
+      if (value & (1u << i)) out[pos >> 3] |= (uint8_t)(1u << (pos & 7));
+    }
+  }
+};
+
+// --------- BC1 ----------
+
+uint16_t pack565(const float c[3]) {
+  uint32_t r = (uint32_t)std::lround(c[0] * 31.0f / 255.0f);
+  uint32_t g = (uint32_t)std::lround(c[1] * 63.0f / 255.0f);
+  uint32_t b = (uint32_t)std::lround(c[2] * 31.0f / 255.0f);
+  return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+void unpack565(uint16_t v, float c[3]) {
+  uint32_t r = v >> 11, g = (v >> 5) & 63, b = v & 31;
+  c[0] = (float)(r << 3 | r >> 2);
+  c[1] = (float)(g << 2 | g >> 4);
+  c[2] = (float)(b << 3 | b >> 2);
+}
+
+// Index order 0, 2, 3, 1 runs from endpoint 0 to endpoint 1.
+constexpr float kBc1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+float bc1Assign(const float (*p)[3], uint16_t c0, uint16_t c1, uint8_t idx[16]) {
+  float e0[3], e1[3], pal[4][3];
+  unpack565(c0, e0);
+  unpack565(c1, e1);
+  for (int k = 0; k < 4; ++k) {
+    for (int c = 0; c < 3; ++c) pal[k][c] = e0[c] + (e1[c] - e0[c]) * kBc1Weights[k];
+  }
+  float total = 0.0f;
+  for (int i = 0; i < 16; ++i) {
+    float best = 1e30f;
+    for (int k = 0; k < 4; ++k) {
+      float d = 0.0f;
+      for (int c = 0; c < 3; ++c) d += (p[i][c] - pal[k][c]) * (p[i][c] - pal[k][c]);
+      if (d < best) { best = d; idx[i] = (uint8_t)k; }
+    }
+    total += best;
+  }
+  return total;
+}
+
+void bc4Block(const uint8_t* rgba, int channel, uint8_t out[8]) {
+  uint8_t lo = 255, hi = 0;
+  for (int i = 0; i < 16; ++i) {
+    lo = std::min(lo, rgba[i * 4 + channel]);
+    hi = std::max(hi, rgba[i * 4 + channel]);
+  }
+  std::memset(out, 0, 8);
+  out[0] = hi;
+  out[1] = lo;
+  if (hi == lo) return; // all indices 0
+
+  // 8-value mode (e0 > e1): index 0 = e0, 1 = e1, 2..7 step from e0 to e1.
+  BitWriter bw{ out + 2 };
+  for (int i = 0; i < 16; ++i) {
+    float t = (float)(hi - rgba[i * 4 + channel]) / (float)(hi - lo) * 7.0f; // 0 at hi, 7 at lo
+    int step = (int)std::lround(t);
+    uint32_t idx = step == 0 ? 0u : step == 7 ? 1u : (uint32_t)step + 1u;
+    bw.put(idx, 3);
+  }
+}
+
+// --------- BC7 ----------
+
+constexpr int kBc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct Bc7Endpoint {
+  uint8_t q[4]; // 7-bit
+  uint8_t p;    // p-bit
+  float value(int c) const { return (float)(q[c] << 1 | p); }
+};
+
+// Best 7-bit + shared p-bit quantisation of one RGBA endpoint.
+Bc7Endpoint quantizeBc7(const float e[4]) {
+  Bc7Endpoint best{};
+  float bestErr = 1e30f;
+  for (uint8_t p = 0; p < 2; ++p) {
+    Bc7Endpoint cand{};
+    cand.p = p;
+    float err = 0.0f;
+    for (int c = 0; c < 4; ++c) {
+      int q = std::clamp((int)std::lround((e[c] - (float)p) * 0.5f), 0, 127);
+      cand.q[c] = (uint8_t)q;
+      float d = cand.value(c) - e[c];
+      err += d * d;
+    }
+    if (err < bestErr) {
+      bestErr = err;
+      best = cand;
+    }
+  }
+  return best;
+}
+
+float bc7Assign(const float (*p)[4], const Bc7Endpoint& a, const Bc7Endpoint& b, uint8_t idx[16]) {
+  float pal[16][4];
+  for (int k = 0; k < 16; ++k) {
+    for (int c = 0; c < 4; ++c) {
+      int v = ((64 - kBc7Weights4[k]) * (int)a.value(c) + kBc7Weights4[k] * (int)b.value(c) + 32) >> 6;
+      pal[k][c] = (float)v;
+    }
+  }
+  float total = 0.0f;
+  for (int i = 0; i < 16; ++i) {
+    float best = 1e30f;
+    for (int k = 0; k < 16; ++k) {
+      float d = 0.0f;
+      for (int c = 0; c < 4; ++c) d += (p[i][c] - pal[k][c]) * (p[i][c] - pal[k][c]);
+      if (d < best) { best = d; idx[i] = (uint8_t)k; }
+    }
+    total += best;
+  }
+  return total;
+}
+
+} // namespace
+
+void encodeBC1(const uint8_t rgba[64], uint8_t out[8]) {
+  float p[16][3];
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 3; ++c) p[i][c] = (float)rgba[i * 4 + c];
+  }
+
+  float mean[3], axis[3], e0[3], e1[3];
+  if (!principalAxis<3>(p, 16, mean, axis)) {
+    std::copy(mean, mean + 3, e0);
+    std::copy(mean, mean + 3, e1);
+  } else {
+    axisEndpoints<3>(p, 16, mean, axis, e0, e1);
+  }
+
+  uint16_t bestC0 = pack565(e0), bestC1 = pack565(e1);
+  uint8_t bestIdx[16];
+  float bestErr = bc1Assign(p, bestC0, bestC1, bestIdx);
+  for (int iter = 0; iter < 2; ++iter) {
+    float w[16];
+    for (int i = 0; i < 16; ++i) w[i] = kBc1Weights[bestIdx[i]];
+    if (!refineEndpoints<3>(p, 16, w, e0, e1)) break;
+    uint16_t c0 = pack565(e0), c1 = pack565(e1);
+    uint8_t idx[16];
+    float err = bc1Assign(p, c0, c1, idx);
+    if (err >= bestErr) break;
+    bestErr = err;
+    bestC0 = c0;
+    bestC1 = c1;
+    std::copy(idx, idx + 16, bestIdx);
+  }
+
+  // 4-colour mode needs c0 > c1; equal endpoints decode as 3-colour mode,
+  // where only index 0 is safe.
+  if (bestC0 < bestC1) {
+    std::swap(bestC0, bestC1);
+    for (uint8_t& i : bestIdx) i = (uint8_t)(i ^ 1); // 0<->1, 2<->3
+  }
+  if (bestC0 == bestC1) std::fill(bestIdx, bestIdx + 16, (uint8_t)0);
+
+  std::memset(out, 0, 8);
+  out[0] = (uint8_t)bestC0;
+  out[1] = (uint8_t)(bestC0 >> 8);
+  out[2] = (uint8_t)bestC1;
+  out[3] = (uint8_t)(bestC1 >> 8);
+  BitWriter bw{ out + 4 };
+  for (int i = 0; i < 16; ++i) bw.put(bestIdx[i], 2);
+}
+
+void encodeBC5(const uint8_t rgba[64], uint8_t out[16]) {
+  bc4Block(rgba, 0, out);
+  bc4Block(rgba, 1, out + 8);
+}
+
+void encodeBC7(const uint8_t rgba[64], uint8_t out[16]) {
+  float p[16][4];
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 4; ++c) p[i][c] = (float)rgba[i * 4 + c];
+  }
+
+  float mean[4], axis[4], e0[4], e1[4];
+  if (!principalAxis<4>(p, 16, mean, axis)) {
+    std::copy(mean, mean + 4, e0);
+    std::copy(mean, mean + 4, e1);
+  } else {
+    axisEndpoints<4>(p, 16, mean, axis, e0, e1);
+  }
+
+  Bc7Endpoint bestA = quantizeBc7(e0), bestB = quantizeBc7(e1);
+  uint8_t bestIdx[16];
+  float bestErr = bc7Assign(p, bestA, bestB, bestIdx);
+  for (int iter = 0; iter < 3 && bestErr > 0.0f; ++iter) {
+    float w[16];
+    for (int i = 0; i < 16; ++i) w[i] = (float)kBc7Weights4[bestIdx[i]] / 64.0f;
+    if (!refineEndpoints<4>(p, 16, w, e0, e1)) break;
+    Bc7Endpoint a = quantizeBc7(e0), b = quantizeBc7(e1);
+    uint8_t idx[16];
+    float err = bc7Assign(p, a, b, idx);
+    if (err >= bestErr) break;
+    bestErr = err;
+    bestA = a;
+    bestB = b;
+    std::copy(idx, idx + 16, bestIdx);
+  }
+
+  // Texel 0 is the anchor: its index drops the top bit, so it must be < 8.
+  if (bestIdx[0] >= 8) {
+    std::swap(bestA, bestB);
+    for (uint8_t& i : bestIdx) i = (uint8_t)(15 - i);
+  }
+
+  std::memset(out, 0, 16);
+  BitWriter bw{ out };
+  bw.put(1u << 6, 7); // mode 6
+  for (int c = 0; c < 4; ++c) {
+    bw.put(bestA.q[c], 7);
+    bw.put(bestB.q[c], 7);
+  }
+  bw.put(bestA.p, 1);
+  bw.put(bestB.p, 1);
+  for (int i = 0; i < 16; ++i) bw.put(bestIdx[i], i == 0 ? 3 : 4);
+}
+
+} // namespace assets
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+namespace assets {
+
+/// Block encoders. Input is one 4x4 block of RGBA8 texels, row major
+/// (64 bytes); output is the block exactly as the GPU reads it.
+///
+/// All three fit endpoints along the block's principal axis and then refine
+/// them by least squares against the chosen indices, keeping whichever
+/// candidate had the lowest squared error. Values are encoded as given:
+/// sRGB data stays in sRGB space, matching what the _SRGB formats decode.
+
+/// BC1 opaque (4-colour mode), 8 bytes. Alpha is ignored.
+void encodeBC1(const uint8_t rgba[64], uint8_t out[8]);
+
+/// BC5: red and green as two BC4 blocks, 16 bytes. Blue/alpha are ignored.
+void encodeBC5(const uint8_t rgba[64], uint8_t out[16]);
+
+/// BC7 mode 6 (one subset, RGBA 7.7.7.7 + p-bit endpoints, 4-bit indices),
+/// 16 bytes. Handles alpha and opaque blocks alike.
+void encodeBC7(const uint8_t rgba[64], uint8_t out[16]);
+
+} // namespace assets
@@ -0,0 +1,112 @@
+#include "Mips.h"
+#include "core/JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace assets {
+
+namespace {
+
+float srgbToLinear(float c) {
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+uint8_t linearToSrgb8(float c) {
+  c = std::clamp(c, 0.0f, 1.0f);
+  float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+  return (uint8_t)std::lround(s * 255.0f);
+}
+
+uint8_t unorm8(float c) { return (uint8_t)std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f); }
+
+struct SrgbTable {
+  float toLinear[256];
+  SrgbTable() {
+    for (int i = 0; i < 256; ++i) toLinear[i] = srgbToLinear((float)i / 255.0f);
+  }
+};
+
+Image downsample(const Image& src, TextureKind kind, core::JobSystem& jobs) {
+  static const SrgbTable kSrgb;
+  Image dst;
+  dst.width = std::max(1u, src.width / 2);
+  dst.height = std::max(1u, src.height / 2);
+  dst.rgba.resize((size_t)dst.width * dst.height * 4);
+
+  jobs.parallelFor(dst.height, 8, [&](uint32_t rowBegin, uint32_t rowEnd) {
+    for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+      // Source footprint [y0, y1): two rows, three where an odd size is halved.
+      uint32_t y0 = y * src.height / dst.height;
+      uint32_t y1 = std::max(y0 + 1, ((y + 1) * src.height + dst.height - 1) / dst.height);
+      for (uint32_t x = 0; x < dst.width; ++x) {
+        uint32_t x0 = x * src.width / dst.width;
+        uint32_t x1 = std::max(x0 + 1, ((x + 1) * src.width + dst.width - 1) / dst.width);
+
+        float sum[4] = { 0, 0, 0, 0 };
+        uint32_t n = 0;
+        for (uint32_t sy = y0; sy < y1; ++sy) {
+          for (uint32_t sx = x0; sx < x1; ++sx, ++n) {
+            const uint8_t* p = src.at(sx, sy);
+            if (kind == TextureKind::Color) {
+              float a = (float)p[3] / 255.0f;
+              for (int c = 0; c < 3; ++c) sum[c] += kSrgb.toLinear[p[c]] * a;
+              sum[3] += a;
+            } else if (kind == TextureKind::Normal) {
+              float v[3];
+              for (int c = 0; c < 3; ++c) v[c] = (float)p[c] / 127.5f - 1.0f;
+              float len = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+              float inv = len > 1e-6f ? 1.0f / len : 0.0f;
+              for (int c = 0; c < 3; ++c) sum[c] += v[c] * inv;
+              sum[3] += (float)p[3];
+            } else {
+              for (int c = 0; c < 4; ++c) sum[c] += (float)p[c];
+            }
+          }
+        }
+
+        uint8_t* o = dst.at(x, y);
+        if (kind == TextureKind::Color) {
+          if (sum[3] > 1e-6f) {
+            for (int c = 0; c < 3; ++c) o[c] = linearToSrgb8(sum[c] / sum[3]);
+          } else {
+            // Fully transparent: plain average keeps the colour continuous.
+            float plain[3] = { 0, 0, 0 };
+            for (uint32_t sy = y0; sy < y1; ++sy) {
+              for (uint32_t sx = x0; sx < x1; ++sx) {
+                for (int c = 0; c < 3; ++c) plain[c] += kSrgb.toLinear[src.at(sx, sy)[c]];
+              }
+            }
+            for (int c = 0; c < 3; ++c) o[c] = linearToSrgb8(plain[c] / (float)n);
+          }
+          o[3] = unorm8(sum[3] / (float)n);
+        } else if (kind == TextureKind::Normal) {
+          float len = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+          float v[3] = { 0.0f, 0.0f, 1.0f };
+          if (len > 1e-6f) {
+            for (int c = 0; c < 3; ++c) v[c] = sum[c] / len;
+          }
+          for (int c = 0; c < 3; ++c) o[c] = unorm8(v[c] * 0.5f + 0.5f);
+          o[3] = (uint8_t)std::lround(sum[3] / (float)n);
+        } else {
+          for (int c = 0; c < 4; ++c) o[c] = (uint8_t)std::lround(sum[c] / (float)n);
+        }
+      }
+    }
+  });
+  return dst;
+}
+
+} // namespace
+
+std::vector<Image> buildMips(const Image& base, TextureKind kind, core::JobSystem& jobs) {
+  std::vector<Image> mips;
+  mips.push_back(base);
+  while (mips.back().width > 1 || mips.back().height > 1) {
+    Image next = downsample(mips.back(), kind, jobs);
+    mips.push_back(std::move(next));
+  }
+  return mips;
+}
+
+} // namespace assets
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+
+#include "Png.h"
+
+namespace core { class JobSystem; }
+
+namespace assets {
+
+enum class TextureKind {
+  Color,  // sRGB colour (+ alpha)
+  Normal, // tangent-space normal map, XY in RG
+  Data,   // linear channels (masks, roughness, ...)
+};
+
+/// Full mip chain down to 1x1; [0] is `base`. Each level box-filters the
+/// previous one (2x2, or 2x3/3x3 footprints for odd sizes) in the right
+/// space: colour is averaged as linear light with alpha weighting, so
+/// transparent texels do not bleed dark fringes; normals are averaged as
+/// vectors and renormalised; data channels are averaged as stored.
+std::vector<Image> buildMips(const Image& base, TextureKind kind, core::JobSystem& jobs);
+
+} // namespace assets
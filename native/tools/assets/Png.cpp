@@ -0,0 +1,373 @@
+#include "Png.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace assets {
+
+// --------- inflate ----------
+
+namespace {
+
+struct BitReader {
+  const uint8_t* data;
+  size_t size;
+  size_t pos = 0;
+  uint32_t bitBuf = 0;
+  uint32_t bitCount = 0;
+  bool overrun = false;
+
+  uint32_t bits(uint32_t n) {
+    while (bitCount < n) {
+      uint32_t byte = 0;
+      if (pos < size) byte = data[pos++];
+      else overrun = true;
+      bitBuf |= byte << bitCount;
+      bitCount += 8;
+    }
+    uint32_t v = bitBuf & ((1u << n) - 1u);
+    bitBuf >>= n;
+    bitCount -= n;
+    return v;
+  }
+};
+
+constexpr int kMaxBits = 15;
+
+// Canonical Huffman code as counts per length + symbols in code order.
+struct Huffman {
+  uint16_t count[kMaxBits + 1];
+  uint16_t symbol[288];
+
+  bool build(const uint8_t* lengths, int n) {
+    std::memset(count, 0, sizeof(count));
+    for (int i = 0; i < n; ++i) count[lengths[i]]++;
+    if (count[0] == n) return true; // no codes: fine until a symbol is read
+    int left = 1;
+    for (int len = 1; len <= kMaxBits; ++len) {
+      left = (left << 1) - count[len];
+      if (left < 0) return false; // over-subscribed
+    }
+    uint16_t offs[kMaxBits + 1];
+    offs[1] = 0;
+    for (int len = 1; len < kMaxBits; ++len) offs[len + 1] = offs[len] + count[len];
+    for (int i = 0; i < n; ++i) {
+      if (lengths[i] != 0) symbol[offs[lengths[i]]++] = (uint16_t)i;
+    }
+    return true;
+  }
+
+  // Bit by bit (codes are stored MSB first); -1 on an invalid code.
+  int decode(BitReader& br) const {
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= kMaxBits; ++len) {
+      code |= (int)br.bits(1);
+      int c = count[len];
+      if (code - c < first) return symbol[index + (code - first)];
+      index += c;
+      first = (first + c) << 1;
+      code <<= 1;
+    }
+    return -1;
+  }
+};
+
+constexpr uint16_t kLenBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+constexpr uint8_t kLenExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+constexpr uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                     193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                     6145, 8193, 12289, 16385, 24577 };
+constexpr uint8_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                     6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+bool inflateBlock(BitReader& br, const Huffman& lit, const Huffman& dist, std::vector<uint8_t>& out,
+                  std::string& error) {
+  for (;;) {
+    int sym = lit.decode(br);
+    if (sym < 0 || br.overrun) {
+      error = "corrupt deflate stream";
+      return false;
+    }
+    if (sym < 256) {
+      out.push_back((uint8_t)sym);
+    } else if (sym == 256) {
+      return true;
+    } else {
+      sym -= 257;
+      if (sym >= 29) {
+        error = "corrupt deflate length";
+        return false;
+      }
+      uint32_t len = kLenBase[sym] + br.bits(kLenExtra[sym]);
+      int ds = dist.decode(br);
+      if (ds < 0 || ds >= 30) {
+        error = "corrupt deflate distance";
+        return false;
+      }
+      size_t d = kDistBase[ds] + br.bits(kDistExtra[ds]);
+      if (d > out.size()) {
+        error = "deflate distance before start of data";
+        return false;
+      }
+      size_t from = out.size() - d;
+      for (uint32_t i = 0; i < len; ++i) out.push_back(out[from + i]); // may overlap
+    }
+  }
+}
+
+} // namespace
+
+bool inflateZlib(const uint8_t* data, size_t size, size_t expected, std::vector<uint8_t>& out, std::string& error) {
+  if (size < 2 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20)) {
+    error = "not a zlib stream";
+    return false;
+  }
+  out.clear();
+  out.reserve(expected);
+  BitReader br{ data + 2, size - 2 };
+
+  uint32_t last = 0;
+  while (!last) {
+    last = br.bits(1);
+    uint32_t type = br.bits(2);
+    if (type == 0) {
+      // Stored: byte aligned LEN / NLEN, then raw bytes.
+      br.bitBuf = 0;
+      br.bitCount = 0;
+      if (br.pos + 4 > br.size) {
+        error = "truncated stored block";
+        return false;
+      }
+      uint32_t len = br.data[br.pos] | (br.data[br.pos + 1] << 8);
+      uint32_t nlen = br.data[br.pos + 2] | (br.data[br.pos + 3] << 8);
+      br.pos += 4;
+      if ((len ^ 0xFFFFu) != nlen || br.pos + len > br.size) {
+        error = "corrupt stored block";
+        return false;
+      }
+      out.insert(out.end(), br.data + br.pos, br.data + br.pos + len);
+      br.pos += len;
+    } else if (type == 1) {
+      // Built once; function-local statics initialise thread-safely.
+      static const struct Fixed {
+        Huffman lit, dist;
+        Fixed() {
+          uint8_t l[288];
+          for (int i = 0; i < 144; ++i) l[i] = 8;
+          for (int i = 144; i < 256; ++i) l[i] = 9;
+          for (int i = 256; i < 280; ++i) l[i] = 7;
+          for (int i = 280; i < 288; ++i) l[i] = 8;
+          lit.build(l, 288);
+          for (int i = 0; i < 30; ++i) l[i] = 5;
+          dist.build(l, 30);
+        }
+      } fixed;
+      if (!inflateBlock(br, fixed.lit, fixed.dist, out, error)) return false;
+    } else if (type == 2) {
+      uint32_t hlit = br.bits(5) + 257, hdist = br.bits(5) + 1, hclen = br.bits(4) + 4;
+      static constexpr uint8_t kOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+      uint8_t lengths[320] = {};
+      for (uint32_t i = 0; i < hclen; ++i) lengths[kOrder[i]] = (uint8_t)br.bits(3);
+      Huffman code;
+      if (!code.build(lengths, 19)) {
+        error = "corrupt code length code";
+        return false;
+      }
+      std::memset(lengths, 0, sizeof(lengths));
+      uint32_t n = 0;
+      while (n < hlit + hdist) {
+        int sym = code.decode(br);
+        if (sym < 0) {
+          error = "corrupt code lengths";
+          return false;
+        }
+        if (sym < 16) {
+          lengths[n++] = (uint8_t)sym;
+          continue;
+        }
+        uint8_t value = 0;
+        uint32_t repeat;
+        if (sym == 16) {
+          if (n == 0) {
+            error = "repeat with no previous length";
+            return false;
+          }
+          value = lengths[n - 1];
+          repeat = 3 + br.bits(2);
+        } else if (sym == 17) {
+          repeat = 3 + br.bits(3);
+        } else {
+          repeat = 11 + br.bits(7);
+        }
+        if (n + repeat > hlit + hdist) {
+          error = "too many code lengths";
+          return false;
+        }
+        while (repeat--) lengths[n++] = value;
+      }
+      Huffman lit, dist;
+      if (!lit.build(lengths, (int)hlit) || !dist.build(lengths + hlit, (int)hdist)) {
+        error = "corrupt dynamic Huffman table";
+        return false;
+      }
+      if (!inflateBlock(br, lit, dist, out, error)) return false;
+    } else {
+      error = "invalid deflate block type";
+      return false;
+    }
+    if (br.overrun) {
+      error = "truncated deflate stream";
+      return false;
+    }
+  }
+  return true;
+}
+
+// --------- PNG ----------
+
+namespace {
+
+uint32_t be32(const uint8_t* p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+
+uint8_t paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) return (uint8_t)a;
+  return (uint8_t)(pb <= pc ? b : c);
+}
+
+} // namespace
+
+bool decodePng(const uint8_t* data, size_t size, Image& out, std::string& error) {
+  static constexpr uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  if (size < 8 || std::memcmp(data, kSignature, 8) != 0) {
+    error = "not a PNG file";
+    return false;
+  }
+
+  uint32_t width = 0, height = 0, depth = 0, colorType = 0;
+  uint8_t palette[256][4];
+  uint32_t paletteSize = 0;
+  std::vector<uint8_t> idat;
+  bool haveHeader = false;
+  std::memset(palette, 255, sizeof(palette));
+
+  for (size_t pos = 8; pos + 12 <= size;) {
+    uint32_t len = be32(data + pos);
+    const uint8_t* type = data + pos + 4;
+    const uint8_t* body = data + pos + 8;
+    if (len > size - pos - 12) {
+      error = "truncated chunk";
+      return false;
+    }
+    if (std::memcmp(type, "IHDR", 4) == 0 && len >= 13) {
+      width = be32(body);
+      height = be32(body + 4);
+      depth = body[8];
+      colorType = body[9];
+      if (body[12] != 0) {
+        error = "interlaced PNGs are not supported, re-save without Adam7";
+        return false;
+      }
+      haveHeader = true;
+    } else if (std::memcmp(type, "PLTE", 4) == 0) {
+      paletteSize = std::min<uint32_t>(len / 3, 256);
+      for (uint32_t i = 0; i < paletteSize; ++i) {
+        palette[i][0] = body[i * 3];
+        palette[i][1] = body[i * 3 + 1];
+        palette[i][2] = body[i * 3 + 2];
+      }
+    } else if (std::memcmp(type, "tRNS", 4) == 0 && colorType == 3) {
+      for (uint32_t i = 0; i < len && i < 256; ++i) palette[i][3] = body[i];
+    } else if (std::memcmp(type, "IDAT", 4) == 0) {
+      idat.insert(idat.end(), body, body + len);
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      break;
+    }
+    pos += 12 + (size_t)len;
+  }
+
+  if (!haveHeader || width == 0 || height == 0 || width > 16384 || height > 16384) {
+    error = "missing or invalid IHDR";
+    return false;
+  }
+  uint32_t channels;
+  switch (colorType) {
+  case 0: channels = 1; break;
+  case 2: channels = 3; break;
+  case 3: channels = 1; break;
+  case 4: channels = 2; break;
+  case 6: channels = 4; break;
+  default: error = "unknown PNG colour type"; return false;
+  }
+  bool depthOk = colorType == 3 ? (depth == 1 || depth == 2 || depth == 4 || depth == 8) : (depth == 8 || depth == 16);
+  if (!depthOk) {
+    error = "unsupported PNG bit depth " + std::to_string(depth);
+    return false;
+  }
+  if (colorType == 3 && paletteSize == 0) {
+    error = "palette PNG without PLTE";
+    return false;
+  }
+
+  const size_t bitsPerPixel = (size_t)channels * depth;
+  const size_t stride = (width * bitsPerPixel + 7) / 8;
+  const size_t bpp = std::max<size_t>(1, bitsPerPixel / 8); // filter distance in bytes
+  std::vector<uint8_t> raw;
+  if (!inflateZlib(idat.data(), idat.size(), (stride + 1) * height, raw, error)) return false;
+  if (raw.size() < (stride + 1) * height) {
+    error = "image data too short";
+    return false;
+  }
+
+  // Undo the per-row filters in place.
+  std::vector<uint8_t> zero(stride, 0);
+  for (uint32_t y = 0; y < height; ++y) {
+    uint8_t* row = &raw[y * (stride + 1) + 1];
+    const uint8_t* prev = y > 0 ? &raw[(y - 1) * (stride + 1) + 1] : zero.data();
+    uint8_t filter = row[-1];
+    for (size_t i = 0; i < stride; ++i) {
+      int a = i >= bpp ? row[i - bpp] : 0;
+      int b = prev[i];
+      int c = i >= bpp ? prev[i - bpp] : 0;
+      switch (filter) {
+      case 0: break;
+      case 1: row[i] = (uint8_t)(row[i] + a); break;
+      case 2: row[i] = (uint8_t)(row[i] + b); break;
+      case 3: row[i] = (uint8_t)(row[i] + ((a + b) >> 1)); break;
+      case 4: row[i] = (uint8_t)(row[i] + paeth(a, b, c)); break;
+      default: error = "invalid PNG row filter"; return false;
+      }
+    }
+  }
+
+  out.width = width;
+  out.height = height;
+  out.rgba.resize((size_t)width * height * 4);
+  const uint32_t step = depth == 16 ? 2 : 1; // keep the high byte
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint8_t* row = &raw[y * (stride + 1) + 1];
+    for (uint32_t x = 0; x < width; ++x) {
+      uint8_t* o = out.at(x, y);
+      if (colorType == 3) {
+        uint32_t bit = x * depth;
+        uint32_t idx = (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1u);
+        std::memcpy(o, palette[idx < paletteSize ? idx : 0], 4);
+        continue;
+      }
+      const uint8_t* p = row + (size_t)x * channels * step;
+      switch (colorType) {
+      case 0: o[0] = o[1] = o[2] = p[0]; o[3] = 255; break;
+      case 2: o[0] = p[0]; o[1] = p[step]; o[2] = p[2 * step]; o[3] = 255; break;
+      case 4: o[0] = o[1] = o[2] = p[0]; o[3] = p[step]; break;
+      case 6: o[0] = p[0]; o[1] = p[step]; o[2] = p[2 * step]; o[3] = p[3 * step]; break;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace assets
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace assets {
+
+/// 8-bit RGBA, rows top to bottom.
+struct Image {
+  uint32_t width = 0, height = 0;
+  std::vector<uint8_t> rgba;
+
+  uint8_t* at(uint32_t x, uint32_t y) { return &rgba[((size_t)y * width + x) * 4]; }
+  const uint8_t* at(uint32_t x, uint32_t y) const { return &rgba[((size_t)y * width + x) * 4]; }
+};
+
+/// Decodes a non-interlaced PNG of any colour type: 8/16-bit grey, grey+alpha,
+/// RGB and RGBA, and 1/2/4/8-bit palette (with tRNS). 16-bit channels keep
+/// their high byte. Gamma/colour-space chunks are ignored: sources are sRGB.
+bool decodePng(const uint8_t* data, size_t size, Image& out, std::string& error);
+
+/// zlib stream (RFC 1950/1951) -> bytes. `expected` sizes the output up front.
+bool inflateZlib(const uint8_t* data, size_t size, size_t expected, std::vector<uint8_t>& out, std::string& error);
+
+} // namespace assets
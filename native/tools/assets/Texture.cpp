@@ -0,0 +1,114 @@
+#include "Texture.h"
+#include "BcEncode.h"
+#include "core/JobSystem.h"
+#include "render/TextureFormat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+
+namespace assets {
+
+namespace {
+
+// VkFormat values; the tool does not depend on the Vulkan headers.
+constexpr uint32_t kFormatBc1RgbUnorm = 131;  // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+constexpr uint32_t kFormatBc1RgbSrgb = 132;   // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+constexpr uint32_t kFormatBc5Unorm = 141;     // VK_FORMAT_BC5_UNORM_BLOCK
+constexpr uint32_t kFormatBc7Unorm = 145;     // VK_FORMAT_BC7_UNORM_BLOCK
+constexpr uint32_t kFormatBc7Srgb = 146;      // VK_FORMAT_BC7_SRGB_BLOCK
+
+enum class Codec { Bc1, Bc5, Bc7 };
+
+bool endsWith(const std::string& s, const char* suffix) {
+  size_t n = std::strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+void encodeLevel(const Image& level, Codec codec, uint32_t blockBytes, uint8_t* out, core::JobSystem& jobs) {
+  const uint32_t bw = (level.width + 3) / 4, bh = (level.height + 3) / 4;
+  jobs.parallelFor(bw * bh, 64, [&](uint32_t begin, uint32_t end) {
+    uint8_t block[64];
+    for (uint32_t b = begin; b < end; ++b) {
+      uint32_t bx = b % bw, by = b / bw;
+      // Edge blocks replicate the last row/column.
+      for (uint32_t y = 0; y < 4; ++y) {
+        uint32_t sy = std::min(by * 4 + y, level.height - 1);
+        for (uint32_t x = 0; x < 4; ++x) {
+          uint32_t sx = std::min(bx * 4 + x, level.width - 1);
+          std::memcpy(block + (y * 4 + x) * 4, level.at(sx, sy), 4);
+        }
+      }
+      uint8_t* dst = out + (size_t)b * blockBytes;
+      switch (codec) {
+      case Codec::Bc1: encodeBC1(block, dst); break;
+      case Codec::Bc5: encodeBC5(block, dst); break;
+      case Codec::Bc7: encodeBC7(block, dst); break;
+      }
+    }
+  });
+}
+
+} // namespace
+
+TextureKind textureKindFor(const char* fileName) {
+  std::string stem = fileName;
+  size_t slash = stem.find_last_of("/\\");
+  if (slash != std::string::npos) stem.erase(0, slash + 1);
+  size_t dot = stem.find_last_of('.');
+  if (dot != std::string::npos) stem.resize(dot);
+  std::transform(stem.begin(), stem.end(), stem.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+  if (endsWith(stem, "_n") || endsWith(stem, "_normal")) return TextureKind::Normal;
+  if (endsWith(stem, "_mask") || endsWith(stem, "_rough") || endsWith(stem, "_orm") || endsWith(stem, "_data")) {
+    return TextureKind::Data;
+  }
+  return TextureKind::Color;
+}
+
+std::vector<uint8_t> compileTexture(const Image& image, TextureKind kind, const TextureSettings& settings,
+                                    core::JobSystem& jobs) {
+  bool hasAlpha = false;
+  for (size_t i = 3; i < image.rgba.size() && !hasAlpha; i += 4) hasAlpha = image.rgba[i] != 255;
+
+  render::TextureHeader header;
+  header.version = render::kTextureVersion;
+  header.width = image.width;
+  header.height = image.height;
+  Codec codec;
+  if (kind == TextureKind::Normal) {
+    codec = Codec::Bc5;
+    header.vkFormat = kFormatBc5Unorm;
+    header.flags |= render::kTextureNormalMap;
+  } else {
+    bool srgb = kind == TextureKind::Color;
+    codec = settings.opaqueBc1 && !hasAlpha ? Codec::Bc1 : Codec::Bc7;
+    if (codec == Codec::Bc1) header.vkFormat = srgb ? kFormatBc1RgbSrgb : kFormatBc1RgbUnorm;
+    else header.vkFormat = srgb ? kFormatBc7Srgb : kFormatBc7Unorm;
+    if (srgb) header.flags |= render::kTextureSrgb;
+  }
+  if (hasAlpha) header.flags |= render::kTextureAlpha;
+  header.blockBytes = codec == Codec::Bc1 ? 8 : 16;
+
+  std::vector<Image> mips = buildMips(image, kind, jobs);
+  header.mipCount = (uint32_t)std::min<size_t>(mips.size(), render::kMaxTextureMips);
+
+  size_t offset = sizeof(render::TextureHeader);
+  for (uint32_t m = 0; m < header.mipCount; ++m) {
+    uint32_t blocks = ((mips[m].width + 3) / 4) * ((mips[m].height + 3) / 4);
+    offset = (offset + 15) & ~(size_t)15;
+    header.levels[m].offset = (uint32_t)offset;
+    header.levels[m].size = blocks * header.blockBytes;
+    offset += header.levels[m].size;
+  }
+
+  std::vector<uint8_t> blob(offset, 0);
+  std::memcpy(blob.data(), &header, sizeof(header));
+  for (uint32_t m = 0; m < header.mipCount; ++m) {
+    encodeLevel(mips[m], codec, header.blockBytes, blob.data() + header.levels[m].offset, jobs);
+  }
+  return blob;
+}
+
+} // namespace assets
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Mips.h"
+#include "Png.h"
+
+namespace core { class JobSystem; }
+
+namespace assets {
+
+/// Bump whenever encoder output changes, so cached blobs are rebuilt.
+constexpr uint32_t kEncoderVersion = 1;
+
+struct TextureSettings {
+  bool opaqueBc1 = false; // opaque colour/data textures as BC1 (half the size of BC7)
+};
+
+/// Picks the kind from the file name: "*_n.png" / "*_normal.png" are normal
+/// maps, "*_mask", "*_rough", "*_orm", "*_data" linear data, the rest colour.
+TextureKind textureKindFor(const char* fileName);
+
+/// Mips + block compression into a render::TextureHeader blob:
+///   colour -> BC7 sRGB (BC1 sRGB if opaque and settings.opaqueBc1)
+///   normal -> BC5
+///   data   -> BC7 (BC1 if opaque and settings.opaqueBc1)
+/// Blocks are encoded in parallel across the job system.
+std::vector<uint8_t> compileTexture(const Image& image, TextureKind kind, const TextureSettings& settings,
+                                    core::JobSystem& jobs);
+
+} // namespace assets
@@ -0,0 +1,88 @@
+#include "Wav.h"
+#include "audio/SoundFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace assets {
+
+namespace {
+
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+uint16_t read16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+uint32_t read32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+int16_t toPcm16(const uint8_t* p, uint16_t format, uint16_t bits) {
+  if (format == kFormatFloat) {
+    float f;
+    std::memcpy(&f, p, 4);
+    return (int16_t)std::lrint(std::clamp(f, -1.0f, 1.0f) * 32767.0f);
+  }
+  switch (bits) {
+    case 8: return (int16_t)((p[0] - 128) << 8); // unsigned
+    case 16: return (int16_t)read16(p);
+    case 24: return (int16_t)(p[1] | (p[2] << 8)); // top 16 bits
+    default: return (int16_t)read16(p + 2);        // 32
+  }
+}
+
+} // namespace
+
+bool compileSound(const uint8_t* data, size_t size, std::vector<uint8_t>& out, std::string& error) {
+  if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+    error = "not a RIFF/WAVE file";
+    return false;
+  }
+
+  uint16_t format = 0, channels = 0, bits = 0;
+  uint32_t rate = 0;
+  const uint8_t* samples = nullptr;
+  size_t sampleBytes = 0;
+  for (size_t pos = 12; pos + 8 <= size;) {
+    const uint8_t* chunk = data + pos;
+    const size_t chunkSize = std::min<size_t>(read32(chunk + 4), size - pos - 8);
+    if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+      format = read16(chunk + 8);
+      channels = read16(chunk + 10);
+      rate = read32(chunk + 12);
+      bits = read16(chunk + 22);
+      if (format == kFormatExtensible && chunkSize >= 26) format = read16(chunk + 32); // sub-format GUID
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      samples = chunk + 8;
+      sampleBytes = chunkSize;
+    }
+    pos += 8 + chunkSize + (chunkSize & 1); // chunks are word aligned
+  }
+
+  if (!samples || !rate) {
+    error = "missing fmt or data chunk";
+    return false;
+  }
+  const bool pcm = format == kFormatPcm && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+  if (!pcm && !(format == kFormatFloat && bits == 32)) {
+    error = "unsupported sample format " + std::to_string(format) + "/" + std::to_string(bits) + " bit";
+    return false;
+  }
+  if (channels != 1 && channels != 2) {
+    error = std::to_string(channels) + " channels (mono or stereo only)";
+    return false;
+  }
+
+  const size_t frameBytes = (size_t)channels * (bits / 8);
+  audio::SoundHeader h;
+  h.version = audio::kSoundVersion;
+  h.sampleRate = rate;
+  h.channels = channels;
+  h.frameCount = (uint32_t)(sampleBytes / frameBytes);
+  out.assign(sizeof(h) + (size_t)h.frameCount * channels * sizeof(int16_t), 0);
+  std::memcpy(out.data(), &h, sizeof(h));
+  int16_t* dst = reinterpret_cast<int16_t*>(out.data() + sizeof(h));
+  for (size_t i = 0, n = (size_t)h.frameCount * channels; i < n; ++i) dst[i] = toPcm16(samples + i * (bits / 8), format, bits);
+  return true;
+}
+
+} // namespace assets
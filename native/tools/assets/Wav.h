@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace assets {
+
+/// Decodes a RIFF/WAVE file into an audio::SoundHeader blob (.bsnd): 8, 16,
+/// 24 or 32-bit integer PCM or 32-bit float, mono or stereo (also in the
+/// WAVE_FORMAT_EXTENSIBLE wrapper), converted to 16-bit at the source rate.
+bool compileSound(const uint8_t* data, size_t size, std::vector<uint8_t>& out, std::string& error);
+
+} // namespace assets
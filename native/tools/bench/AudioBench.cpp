@@ -0,0 +1,210 @@
+// Audio mixer benchmark: synthetic sounds, no device or pak needed.
+//
+//   AudioBench [options]
+//
+//   --seconds <n>       length of the threaded run (10)
+//   --voices <n>        most voices the gunfight keeps going (96)
+//   --wav <path>        write the threaded run's output instead of pacing silently
+//   --seed <n>          sound shapes and command pattern (1)
+//
+// First mixes blocks back to back on the main thread at 16 to 128 voices,
+// resampling from mono and stereo sources at several rates, and prints the
+// cost per block against the block's length. Then runs the audio thread in
+// real time while the main thread issues play/set/stop commands at 60 Hz,
+// and prints how long issuing them took, the mix thread's worst block and
+// any underruns. Exits with 2 if the output underran.
+
+#include "audio/AudioBackend.h"
+#include "audio/AudioSystem.h"
+#include "audio/Mixer.h"
+#include "audio/SoundFormat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+  uint32_t seconds = 10;
+  uint32_t voices = 96;
+  uint32_t seed = 1;
+  const char* wav = nullptr;
+};
+
+void usage() { std::printf("usage: AudioBench [--seconds n] [--voices n] [--wav path] [--seed n]\n"); }
+
+bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (i + 1 >= argc) return false;
+    const char* v = argv[++i];
+    if (std::strcmp(a, "--seconds") == 0) o.seconds = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--voices") == 0) o.voices = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--wav") == 0) o.wav = v;
+    else if (std::strcmp(a, "--seed") == 0) o.seed = (uint32_t)std::atoi(v);
+    else return false;
+  }
+  return o.seconds > 0 && o.voices > 0;
+}
+
+// xorshift32, so runs are repeatable across platforms.
+float random01(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return (float)(state >> 8) * (1.0f / 16777216.0f);
+}
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+/// A .bsnd blob as the asset compiler writes it: a decaying tone with noise.
+std::vector<uint8_t> makeSound(uint32_t rate, uint32_t channels, float seconds, uint32_t& seed) {
+  const uint32_t frames = (uint32_t)(rate * seconds);
+  audio::SoundHeader h{};
+  std::memcpy(h.magic, "BSND", 4);
+  h.version = audio::kSoundVersion;
+  h.sampleRate = rate;
+  h.channels = channels;
+  h.frameCount = frames;
+
+  std::vector<uint8_t> blob(sizeof(h) + (size_t)frames * channels * sizeof(int16_t));
+  std::memcpy(blob.data(), &h, sizeof(h));
+  int16_t* s = reinterpret_cast<int16_t*>(blob.data() + sizeof(h));
+  const float freq = 80.0f + random01(seed) * 900.0f, noise = random01(seed) * 0.5f;
+  for (uint32_t f = 0; f < frames; ++f) {
+    const float t = (float)f / rate, env = std::exp(-t * 3.0f);
+    for (uint32_t c = 0; c < channels; ++c) {
+      const float v = env * (std::sin(6.2831853f * freq * t + c) * (1.0f - noise) + (random01(seed) * 2 - 1) * noise);
+      s[f * channels + c] = (int16_t)std::clamp(v * 32767.0f, -32768.0f, 32767.0f);
+    }
+  }
+  return blob;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) {
+    usage();
+    return 1;
+  }
+
+  constexpr uint32_t kRate = audio::AudioSystem::kSampleRate, kBlock = audio::AudioSystem::kBlockFrames;
+  const uint32_t rates[] = { 22050, 44100, 48000 };
+  uint32_t seed = o.seed ? o.seed : 1;
+  std::vector<std::vector<uint8_t>> blobs;
+  for (uint32_t i = 0; i < 12; ++i) blobs.push_back(makeSound(rates[i % 3], 1 + (i / 3) % 2, 0.5f + i * 0.25f, seed));
+
+  auto soundOf = [](const std::vector<uint8_t>& blob) {
+    audio::SoundHeader h;
+    std::memcpy(&h, blob.data(), sizeof(h));
+    return audio::Sound{ reinterpret_cast<const int16_t*>(blob.data() + sizeof(h)), h.frameCount, h.channels,
+                         h.sampleRate };
+  };
+
+  // Single-threaded cost per block.
+  const double blockMs = 1000.0 * kBlock / kRate;
+  std::printf("AudioBench: %zu sounds, %u Hz, %u-frame blocks (%.2f ms)\n", blobs.size(), kRate, kBlock, blockMs);
+  std::printf("  voices  block (us)  worst (us)  of block\n");
+  std::vector<float> out((size_t)kBlock * 2);
+  std::vector<audio::VoiceId> ended;
+  for (uint32_t voices : { 16u, 32u, 64u, 128u }) {
+    audio::Mixer mixer;
+    mixer.init(kRate);
+    for (uint32_t v = 0; v < voices; ++v) {
+      audio::VoiceParams p;
+      p.volume = 0.2f + random01(seed) * 0.5f;
+      p.pan = random01(seed) * 2 - 1;
+      p.pitch = v % 4 == 0 ? 1.0f : 0.7f + random01(seed) * 0.6f; // some voices take the unit-step path
+      p.loop = true;
+      mixer.play(v, soundOf(blobs[v % blobs.size()]), p);
+    }
+    const uint32_t blocks = 2000;
+    double total = 0, worst = 0;
+    for (uint32_t b = 0; b < blocks; ++b) {
+      const Clock::time_point t0 = Clock::now();
+      mixer.mix(out.data(), kBlock, ended);
+      const double ms = msSince(t0);
+      total += ms;
+      worst = std::max(worst, ms);
+    }
+    std::printf("  %6u  %10.1f  %10.1f  %7.1f%%\n", voices, total / blocks * 1000.0, worst * 1000.0,
+                100.0 * total / blocks / blockMs);
+  }
+
+  // Threaded, in real time, with gameplay commands arriving every frame.
+  audio::AudioSystem system;
+  system.init(nullptr, o.wav ? audio::createWavBackend(o.wav, true) : audio::createNullBackend(true));
+  std::vector<audio::SoundId> sounds;
+  for (size_t i = 0; i < blobs.size(); ++i) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "bench/%zu.bsnd", i);
+    sounds.push_back(system.addSound(name, blobs[i].data(), blobs[i].size()));
+  }
+
+  std::vector<audio::VoiceId> live;
+  uint32_t played = 0, finished = 0, commands = 0;
+  double issueWorst = 0, issueTotal = 0, mixWorst = 0;
+  const uint32_t frames = o.seconds * 60;
+  const Clock::time_point start = Clock::now();
+  for (uint32_t f = 0; f < frames; ++f) {
+    const Clock::time_point t0 = Clock::now();
+    system.update();
+    for (audio::VoiceId id : system.finished()) {
+      auto it = std::find(live.begin(), live.end(), id);
+      if (it != live.end()) live.erase(it);
+      ++finished;
+    }
+
+    // A burst of shots, a few pitch bends, and the odd fade-out.
+    const uint32_t shots = (uint32_t)(random01(seed) * 6);
+    for (uint32_t s = 0; s < shots && live.size() < o.voices; ++s) {
+      audio::VoiceParams p;
+      p.volume = 0.1f + random01(seed) * 0.3f;
+      p.pan = random01(seed) * 2 - 1;
+      p.pitch = 0.8f + random01(seed) * 0.4f;
+      const audio::VoiceId id = system.play(sounds[(size_t)(random01(seed) * sounds.size()) % sounds.size()], p);
+      if (id != audio::kInvalidVoice) live.push_back(id);
+      ++played;
+      ++commands;
+    }
+    for (uint32_t s = 0; s < 4 && !live.empty(); ++s, ++commands) {
+      system.set(live[(size_t)(random01(seed) * live.size()) % live.size()], 0.3f, random01(seed) * 2 - 1,
+                 0.9f + random01(seed) * 0.2f);
+    }
+    if (f % 20 == 0 && !live.empty()) {
+      system.stop(live.front(), 0.05f);
+      ++commands;
+    }
+    const double ms = msSince(t0);
+    issueTotal += ms;
+    issueWorst = std::max(issueWorst, ms);
+    if (f % 60 == 59) mixWorst = std::max(mixWorst, system.stats().worstMixMs);
+
+    std::this_thread::sleep_until(start + std::chrono::microseconds((uint64_t)(f + 1) * 1000000 / 60));
+  }
+  const double wall = msSince(start) / 1000.0;
+  const audio::AudioStats st = system.stats();
+  mixWorst = std::max(mixWorst, st.worstMixMs);
+  std::printf("threaded %s output: %.1f s of game in %.2f s wall, %u plays, %u finished, %u commands "
+              "(%u dropped), %u plays refused\n",
+              system.backendName(), (double)o.seconds, wall, played, finished, commands, st.droppedCommands,
+              st.droppedVoices);
+  std::printf("command issue per frame %.3f ms average, %.3f ms worst; mix worst %.3f ms of %.2f ms; "
+              "%u underruns\n",
+              issueTotal / frames, issueWorst, mixWorst, st.blockMs, st.underruns);
+
+  system.shutdown();
+  return st.underruns == 0 ? 0 : 2;
+}
@@ -0,0 +1,189 @@
+// Physics stress benchmark: thousands of stacked and scattered rigid bodies.
+//
+//   PhysicsBench [options]
+//
+//   --stacks <n>        box towers on a grid (64)
+//   --height <n>        boxes per tower (10)
+//   --debris <n>        boxes and spheres dropped from above (2000)
+//   --steps <n>         simulation steps at 60 Hz (600)
+//   --threads <n>       worker threads (all cores; 1 = main thread only)
+//   --seed <n>          debris placement (1)
+//
+// Prints the average and worst step cost per stage every second of
+// simulated time, then how many towers still stand and how much of the
+// scene went to sleep. Exits with 2 if a tower collapsed.
+
+#include "core/JobSystem.h"
+#include "physics/PhysicsWorld.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Options {
+  uint32_t stacks = 64;
+  uint32_t height = 10;
+  uint32_t debris = 2000;
+  uint32_t steps = 600;
+  uint32_t seed = 1;
+  unsigned threads = 0;
+};
+
+void usage() {
+  std::printf("usage: PhysicsBench [--stacks n] [--height n] [--debris n] [--steps n] [--threads n] [--seed n]\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (i + 1 >= argc) return false;
+    const char* v = argv[++i];
+    if (std::strcmp(a, "--stacks") == 0) o.stacks = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--height") == 0) o.height = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--debris") == 0) o.debris = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--steps") == 0) o.steps = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--threads") == 0) o.threads = (unsigned)std::atoi(v);
+    else if (std::strcmp(a, "--seed") == 0) o.seed = (uint32_t)std::atoi(v);
+    else return false;
+  }
+  return o.steps > 0;
+}
+
+// xorshift32, so runs are repeatable across platforms.
+float random01(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return (float)(state >> 8) * (1.0f / 16777216.0f);
+}
+
+struct StageTimes {
+  double broadphase = 0, narrowphase = 0, islands = 0, solve = 0, total = 0, worst = 0;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) {
+    usage();
+    return 1;
+  }
+
+  // Without init() every parallelFor runs inline on the main thread.
+  core::JobSystem jobs;
+  if (o.threads != 1) jobs.init(o.threads > 1 ? o.threads - 1 : 0);
+
+  physics::PhysicsWorld world;
+  world.init(jobs);
+
+  // Ground.
+  physics::BodyDesc ground;
+  ground.shape.type = physics::ShapeType::Box;
+  const float gridSpacing = 4.0f;
+  const uint32_t side = std::max(1u, (uint32_t)std::ceil(std::sqrt((float)o.stacks)));
+  const float extent = side * gridSpacing * 0.5f + 20.0f;
+  ground.shape.halfExtents = { extent, 1.0f, extent };
+  ground.position = { 0.0f, -1.0f, 0.0f };
+  ground.mass = 0.0f;
+  world.createBody(ground);
+
+  // Towers of unit boxes, slightly offset so they are not perfectly aligned.
+  uint32_t seed = o.seed ? o.seed : 1;
+  std::vector<physics::BodyId> towerTops;
+  physics::BodyDesc box;
+  box.shape.type = physics::ShapeType::Box;
+  box.shape.halfExtents = { 0.5f, 0.5f, 0.5f };
+  for (uint32_t s = 0; s < o.stacks; ++s) {
+    float x = ((float)(s % side) - side * 0.5f) * gridSpacing;
+    float z = ((float)(s / side) - side * 0.5f) * gridSpacing;
+    physics::BodyId top = physics::kInvalidBody;
+    for (uint32_t level = 0; level < o.height; ++level) {
+      box.position = { x + (random01(seed) - 0.5f) * 0.02f, 0.5f + (float)level * 1.0f,
+                       z + (random01(seed) - 0.5f) * 0.02f };
+      top = world.createBody(box);
+    }
+    if (top != physics::kInvalidBody) towerTops.push_back(top);
+  }
+
+  // Debris rains onto the free ring around the towers.
+  physics::BodyDesc piece;
+  for (uint32_t i = 0; i < o.debris; ++i) {
+    float angle = random01(seed) * 6.2831853f;
+    float radius = side * gridSpacing * 0.5f + 8.0f + random01(seed) * 15.0f;
+    piece.position = { std::cos(angle) * radius, 2.0f + random01(seed) * 30.0f, std::sin(angle) * radius };
+    piece.orientation = physics::axisAngle({ random01(seed), random01(seed), random01(seed) + 0.1f },
+                                           random01(seed) * 3.14159f);
+    if (i % 3 == 0) {
+      piece.shape.type = physics::ShapeType::Sphere;
+      piece.shape.radius = 0.2f + random01(seed) * 0.3f;
+    } else {
+      piece.shape.type = physics::ShapeType::Box;
+      piece.shape.halfExtents = { 0.15f + random01(seed) * 0.35f, 0.15f + random01(seed) * 0.35f,
+                                  0.15f + random01(seed) * 0.35f };
+    }
+    world.createBody(piece);
+  }
+
+  std::vector<physics::Vec3> topStart;
+  for (physics::BodyId id : towerTops) topStart.push_back(world.position(id));
+
+  std::printf("PhysicsBench: %u towers x %u + %u debris = %u bodies, %u threads\n", o.stacks, o.height, o.debris,
+              o.stacks * o.height + o.debris + 1, jobs.threadCount() > 0 ? jobs.threadCount() : 1u);
+  std::printf("  time  awake islands largest contacts  broad  narrow islands  solve   step  worst (ms)\n");
+
+  const float dt = 1.0f / 60.0f;
+  StageTimes window, all;
+  uint32_t windowSteps = 0;
+  using Clock = std::chrono::steady_clock;
+  for (uint32_t step = 1; step <= o.steps; ++step) {
+    Clock::time_point t0 = Clock::now();
+    world.step(dt);
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+    const physics::PhysicsStats& st = world.stats();
+    for (StageTimes* t : { &window, &all }) {
+      t->broadphase += st.broadphaseMs;
+      t->narrowphase += st.narrowphaseMs;
+      t->islands += st.islandMs;
+      t->solve += st.solveMs;
+      t->total += ms;
+      t->worst = std::max(t->worst, ms);
+    }
+    ++windowSteps;
+
+    if (step % 60 == 0 || step == o.steps) {
+      double n = (double)windowSteps;
+      std::printf("%5.1fs %6u %7u %7u %8u %6.2f %7.2f %7.2f %6.2f %6.2f %6.2f\n", step * dt, st.awakeBodies,
+                  st.islands, st.largestIsland, st.touchingContacts, window.broadphase / n, window.narrowphase / n,
+                  window.islands / n, window.solve / n, window.total / n, window.worst);
+      window = StageTimes{};
+      windowSteps = 0;
+    }
+  }
+
+  // A tower stands while its top box is less than half a box lower than it
+  // started; debris rolling in may still have pushed it over by some amount.
+  uint32_t standing = 0, shifted = 0;
+  for (size_t i = 0; i < towerTops.size(); ++i) {
+    physics::Vec3 p = world.position(towerTops[i]), p0 = topStart[i];
+    float drift = std::sqrt((p.x - p0.x) * (p.x - p0.x) + (p.z - p0.z) * (p.z - p0.z));
+    if (p0.y - p.y < 0.5f) ++standing;
+    if (drift > 0.1f) ++shifted;
+  }
+  const physics::PhysicsStats& st = world.stats();
+  std::printf("average step %.2f ms, worst %.2f ms; %zu/%zu towers standing (%u shifted > 10 cm), %u/%u bodies asleep, "
+              "tree height %d\n",
+              all.total / o.steps, all.worst, (size_t)standing, towerTops.size(), shifted,
+              st.bodies - 1 - st.awakeBodies, st.bodies - 1, st.treeHeight);
+
+  world.shutdown();
+  jobs.shutdown();
+  return standing == towerTops.size() ? 0 : 2;
+}
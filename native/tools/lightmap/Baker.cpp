@@ -0,0 +1,421 @@
+#include "Baker.h"
+#include "core/JobSystem.h"
+#include "render/LightmapFormat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace lightmap {
+
+static constexpr float kPi = 3.14159265358979f;
+static constexpr uint32_t kMaxGridDim = 64;
+
+namespace {
+
+// PCG32, seeded per (luxel, sample).
+struct Rng {
+  uint64_t state;
+
+  Rng(uint32_t luxel, uint32_t sample) {
+    state = ((uint64_t)luxel << 32 | sample) * 0x9E3779B97F4A7C15ull + 0x853C49E6748FEA9Bull;
+    next();
+  }
+  uint32_t next() {
+    uint64_t old = state;
+    state = old * 6364136223846793005ull + 1442695040888963407ull;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+  }
+  float uniform() { return (float)(next() >> 8) * (1.0f / 16777216.0f); }
+};
+
+Vec3 mul(Vec3 a, Vec3 b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+float luminance(Vec3 c) { return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z; }
+
+Vec3 cosineSample(Vec3 n, float u1, float u2) {
+  Vec3 ref = std::fabs(n.x) < 0.9f ? Vec3{ 1.0f, 0.0f, 0.0f } : Vec3{ 0.0f, 1.0f, 0.0f };
+  Vec3 t = normalize(cross(ref, n));
+  Vec3 b = cross(n, t);
+  float r = std::sqrt(u1);
+  float phi = 2.0f * kPi * u2;
+  float z = std::sqrt(std::max(0.0f, 1.0f - u1));
+  return normalize(t * (r * std::cos(phi)) + b * (r * std::sin(phi)) + n * z);
+}
+
+// Same falloff as clustered_lighting.glsl, so baked and dynamic lights match.
+float attenuation(float dist, float radius) {
+  float r = dist / radius;
+  float w = std::clamp(1.0f - r * r * r * r, 0.0f, 1.0f);
+  return (w * w) / (dist * dist + 1.0f);
+}
+
+float smoothstep(float e0, float e1, float x) {
+  float t = std::clamp((x - e0) / (e1 - e0), 0.0f, 1.0f);
+  return t * t * (3.0f - 2.0f * t);
+}
+
+} // namespace
+
+Baker::Baker(const Scene& scene, const Bvh& bvh, std::vector<Chart>& charts, uint32_t pageCount,
+             const BakeSettings& settings)
+  : m_scene(scene), m_bvh(bvh), m_charts(charts), m_pageCount(pageCount), m_settings(settings) {
+  Vec3 mn{ 1e30f, 1e30f, 1e30f }, mx{ -1e30f, -1e30f, -1e30f };
+  for (const Vec3& p : scene.positions) {
+    mn = { std::min(mn.x, p.x), std::min(mn.y, p.y), std::min(mn.z, p.z) };
+    mx = { std::max(mx.x, p.x), std::max(mx.y, p.y), std::max(mx.z, p.z) };
+  }
+  m_epsilon = std::max(length(mx - mn) * 1e-5f, 1e-4f);
+  m_gridMin = mn;
+  float extent = std::max({ mx.x - mn.x, mx.y - mn.y, mx.z - mn.z, 1e-3f });
+  m_cellSize = extent / (float)kMaxGridDim;
+  m_gridDim[0] = std::max(1u, (uint32_t)std::ceil((mx.x - mn.x) / m_cellSize));
+  m_gridDim[1] = std::max(1u, (uint32_t)std::ceil((mx.y - mn.y) / m_cellSize));
+  m_gridDim[2] = std::max(1u, (uint32_t)std::ceil((mx.z - mn.z) / m_cellSize));
+  buildLightGrid();
+
+  m_faceChart.assign(scene.faces.size(), UINT32_MAX);
+  for (uint32_t ci = 0; ci < (uint32_t)m_charts.size(); ++ci) m_faceChart[m_charts[ci].face] = ci;
+
+  // Luxels whose centre is within ~half a diagonal of the face get sampled;
+  // the rest of the chart rectangle is filled by dilation.
+  const uint32_t page = m_settings.pageSize;
+  for (uint32_t ci = 0; ci < (uint32_t)m_charts.size(); ++ci) {
+    const Chart& c = m_charts[ci];
+    for (uint32_t y = 0; y < c.h; ++y) {
+      for (uint32_t x = 0; x < c.w; ++x) {
+        float s = c.sMin + ((float)x - 0.5f) * c.luxel;
+        float t = c.tMin + ((float)y - 0.5f) * c.luxel;
+        float cs = s, ct = t;
+        clampToPolygon(c, cs, ct, 0.0f);
+        float d2 = (cs - s) * (cs - s) + (ct - t) * (ct - t);
+        if (d2 > 0.5625f * c.luxel * c.luxel) continue; // 0.75 luxel
+
+        Luxel l;
+        l.chart = ci;
+        l.x = (uint16_t)x;
+        l.y = (uint16_t)y;
+        l.texel = c.page * page * page + (c.rect.y + y) * page + c.rect.x + x;
+        m_luxels.push_back(l);
+      }
+    }
+  }
+  m_accum.resize(m_luxels.size());
+}
+
+void Baker::buildLightGrid() {
+  const uint32_t cells = m_gridDim[0] * m_gridDim[1] * m_gridDim[2];
+  std::vector<std::vector<uint32_t>> lists(cells);
+
+  for (uint32_t li = 0; li < (uint32_t)m_scene.lights.size(); ++li) {
+    const render::Light& l = m_scene.lights[li];
+    uint32_t lo[3], hi[3];
+    const float c[3] = { l.position[0], l.position[1], l.position[2] };
+    const float gmin[3] = { m_gridMin.x, m_gridMin.y, m_gridMin.z };
+    bool outside = false;
+    for (int a = 0; a < 3; ++a) {
+      float fl = std::floor((c[a] - l.radius - gmin[a]) / m_cellSize);
+      float fh = std::floor((c[a] + l.radius - gmin[a]) / m_cellSize);
+      if (fh < 0.0f || fl >= (float)m_gridDim[a]) { outside = true; break; }
+      lo[a] = (uint32_t)std::max(fl, 0.0f);
+      hi[a] = std::min((uint32_t)fh, m_gridDim[a] - 1);
+    }
+    if (outside) continue;
+    for (uint32_t z = lo[2]; z <= hi[2]; ++z)
+      for (uint32_t y = lo[1]; y <= hi[1]; ++y)
+        for (uint32_t x = lo[0]; x <= hi[0]; ++x)
+          lists[x + m_gridDim[0] * (y + m_gridDim[1] * z)].push_back(li);
+  }
+
+  m_cellStart.assign(cells + 1, 0);
+  m_cellLights.clear();
+  for (uint32_t i = 0; i < cells; ++i) {
+    m_cellStart[i] = (uint32_t)m_cellLights.size();
+    m_cellLights.insert(m_cellLights.end(), lists[i].begin(), lists[i].end());
+  }
+  m_cellStart[cells] = (uint32_t)m_cellLights.size();
+}
+
+Vec3 Baker::directLight(const Vec3& p, const Vec3& n) const {
+  Vec3 sum{};
+  const Vec3 origin = p + n * m_epsilon;
+
+  if (!m_cellStart.empty()) {
+    uint32_t cell[3];
+    const float rel[3] = { p.x - m_gridMin.x, p.y - m_gridMin.y, p.z - m_gridMin.z };
+    for (int a = 0; a < 3; ++a) {
+      cell[a] = (uint32_t)std::clamp(rel[a] / m_cellSize, 0.0f, (float)(m_gridDim[a] - 1));
+    }
+    uint32_t ci = cell[0] + m_gridDim[0] * (cell[1] + m_gridDim[1] * cell[2]);
+
+    for (uint32_t k = m_cellStart[ci]; k < m_cellStart[ci + 1]; ++k) {
+      const render::Light& L = m_scene.lights[m_cellLights[k]];
+      Vec3 toLight = Vec3{ L.position[0], L.position[1], L.position[2] } - p;
+      float dist = length(toLight);
+      if (dist >= L.radius || dist <= 1e-4f) continue;
+      Vec3 l = toLight * (1.0f / dist);
+      float ndl = dot(n, l);
+      if (ndl <= 0.0f) continue;
+
+      float att = attenuation(dist, L.radius);
+      if (L.type == render::LightType::Spot) {
+        Vec3 dir{ L.direction[0], L.direction[1], L.direction[2] };
+        att *= smoothstep(L.cosOuter, L.cosInner, -dot(l, dir));
+      }
+      float scale = L.intensity * att * ndl;
+      if (scale <= 1e-6f) continue;
+      if (m_bvh.occluded(origin, l, dist - m_epsilon)) continue;
+      sum = sum + Vec3{ L.color[0], L.color[1], L.color[2] } * scale;
+    }
+  }
+
+  if (m_scene.sunColor.x + m_scene.sunColor.y + m_scene.sunColor.z > 0.0f) {
+    Vec3 l = m_scene.sunDirection * -1.0f;
+    float ndl = dot(n, l);
+    if (ndl > 0.0f && !m_bvh.occluded(origin, l, 1e30f)) sum = sum + m_scene.sunColor * ndl;
+  }
+  return sum;
+}
+
+Vec3 Baker::samplePath(uint32_t luxelIndex, uint32_t sample, bool& backface) const {
+  const Luxel& lx = m_luxels[luxelIndex];
+  const Chart& c = m_charts[lx.chart];
+  Rng rng(luxelIndex, sample);
+
+  // Jitter over the luxel's footprint (anti-aliased shadow edges), kept on
+  // the face.
+  float s = c.sMin + ((float)lx.x - 1.0f + rng.uniform()) * c.luxel;
+  float t = c.tMin + ((float)lx.y - 1.0f + rng.uniform()) * c.luxel;
+  clampToPolygon(c, s, t, std::max(c.luxel * 0.05f, m_epsilon * 4.0f));
+  Vec3 p = c.point(s, t);
+  Vec3 n = c.normal;
+
+  Vec3 radiance = directLight(p, n);
+  Vec3 throughput{ 1.0f, 1.0f, 1.0f };
+  const Vec3 albedo{ m_settings.albedo, m_settings.albedo, m_settings.albedo };
+  backface = false;
+
+  for (uint32_t bounce = 0; bounce <= m_settings.bounces; ++bounce) {
+    Vec3 dir = cosineSample(n, rng.uniform(), rng.uniform());
+    Vec3 origin = p + n * m_epsilon;
+    Hit hit;
+    if (!m_bvh.intersect(origin, dir, 1e30f, hit)) {
+      radiance = radiance + mul(throughput, m_scene.sky);
+      break;
+    }
+    if (hit.backface) {
+      if (bounce == 0) backface = true;
+      break;
+    }
+
+    // Diffuse: cosine sampling cancels the cosine / pi of the estimator.
+    p = origin + dir * hit.t;
+    n = m_charts[m_faceChart[hit.face]].normal;
+    throughput = mul(throughput, albedo);
+    radiance = radiance + mul(throughput, directLight(p, n));
+
+    if (bounce >= 1) {
+      float survive = std::min(std::max({ throughput.x, throughput.y, throughput.z }), 0.95f);
+      if (rng.uniform() >= survive) break;
+      throughput = throughput * (1.0f / survive);
+    }
+  }
+  return radiance;
+}
+
+void Baker::bake(core::JobSystem& jobs, void (*onPass)(Baker&, uint32_t, void*), void* user) {
+  m_active.resize(m_luxels.size());
+  for (uint32_t i = 0; i < (uint32_t)m_luxels.size(); ++i) m_active[i] = i;
+
+  auto start = std::chrono::steady_clock::now();
+  uint32_t pass = 0;
+  uint32_t taken = 0;
+  while (!m_active.empty() && taken < m_settings.maxSamples) {
+    ++pass;
+    uint32_t n = std::min(m_settings.passSamples, m_settings.maxSamples - taken);
+
+    jobs.parallelFor((uint32_t)m_active.size(), 16, [&](uint32_t begin, uint32_t end) {
+      for (uint32_t i = begin; i < end; ++i) {
+        uint32_t li = m_active[i];
+        Accum& a = m_accum[li];
+        for (uint32_t k = 0; k < n; ++k) {
+          bool back = false;
+          Vec3 v = samplePath(li, a.samples + k, back);
+          a.sum[0] += v.x;
+          a.sum[1] += v.y;
+          a.sum[2] += v.z;
+          float lum = luminance(v);
+          a.lumSq += lum * lum;
+          a.backfaces += back ? 1u : 0u;
+        }
+        a.samples += n;
+      }
+    });
+    taken += n;
+    m_maxTaken = taken;
+
+    // Drop luxels inside geometry after the first pass, converged ones
+    // once the estimate has a few passes behind it.
+    size_t keep = 0;
+    for (uint32_t li : m_active) {
+      Accum& a = m_accum[li];
+      if (pass == 1 && a.backfaces * 2 > a.samples) {
+        a = Accum{}; // 0 samples = filled by dilation
+        continue;
+      }
+      if (a.samples >= 2 * m_settings.passSamples) {
+        float inv = 1.0f / (float)a.samples;
+        float mean = luminance(Vec3{ a.sum[0], a.sum[1], a.sum[2] }) * inv;
+        float var = std::max(a.lumSq * inv - mean * mean, 0.0f);
+        float stderrMean = std::sqrt(var * inv);
+        if (stderrMean <= m_settings.noiseThreshold * std::max(mean, 1e-3f)) continue;
+      }
+      m_active[keep++] = li;
+    }
+    m_active.resize(keep);
+
+    float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    std::printf("[INFO] Pass %u: %u spp, %zu/%zu luxels still noisy, %.1f s\n",
+                pass, taken, m_active.size(), m_luxels.size(), elapsed);
+    if (onPass) onPass(*this, pass, user);
+    if (m_settings.timeLimit > 0.0f && elapsed >= m_settings.timeLimit) {
+      std::printf("[WARN] Time limit reached, stopping at %u spp\n", taken);
+      break;
+    }
+  }
+}
+
+void Baker::resolve(std::vector<float>& rgb) {
+  const uint32_t page = m_settings.pageSize;
+  rgb.assign((size_t)m_pageCount * page * page * 3, 0.0f);
+  std::vector<uint8_t> valid((size_t)m_pageCount * page * page, 0);
+
+  for (uint32_t i = 0; i < (uint32_t)m_luxels.size(); ++i) {
+    const Accum& a = m_accum[i];
+    if (a.samples == 0) continue;
+    float inv = 1.0f / (float)a.samples;
+    float* o = &rgb[(size_t)m_luxels[i].texel * 3];
+    o[0] = a.sum[0] * inv;
+    o[1] = a.sum[1] * inv;
+    o[2] = a.sum[2] * inv;
+    valid[m_luxels[i].texel] = 1;
+  }
+
+  // Grow valid luxels into the rest of their chart (never across charts),
+  // so bilinear taps at face edges and luxels behind walls get neighbours'
+  // light instead of black.
+  struct Fill { size_t texel; float rgb[3]; };
+  std::vector<Fill> fills;
+  for (uint32_t iter = 0; iter < m_settings.dilate; ++iter) {
+    fills.clear();
+    for (const Chart& c : m_charts) {
+      size_t base = (size_t)c.page * page * page;
+      for (uint32_t y = 0; y < c.h; ++y) {
+        for (uint32_t x = 0; x < c.w; ++x) {
+          size_t texel = base + (size_t)(c.rect.y + y) * page + c.rect.x + x;
+          if (valid[texel]) continue;
+          Fill f{ texel, { 0, 0, 0 } };
+          uint32_t count = 0;
+          for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+              int nx = (int)x + dx, ny = (int)y + dy;
+              if (nx < 0 || ny < 0 || nx >= (int)c.w || ny >= (int)c.h) continue;
+              size_t nt = base + (size_t)(c.rect.y + ny) * page + c.rect.x + nx;
+              if (!valid[nt]) continue;
+              f.rgb[0] += rgb[nt * 3];
+              f.rgb[1] += rgb[nt * 3 + 1];
+              f.rgb[2] += rgb[nt * 3 + 2];
+              ++count;
+            }
+          }
+          if (count == 0) continue;
+          for (float& v : f.rgb) v /= (float)count;
+          fills.push_back(f);
+        }
+      }
+    }
+    for (const Fill& f : fills) {
+      std::copy(f.rgb, f.rgb + 3, &rgb[f.texel * 3]);
+      valid[f.texel] = 1;
+    }
+  }
+}
+
+bool Baker::writeLightmap(const char* path, std::string& error) {
+  std::vector<float> rgb;
+  resolve(rgb);
+
+  const uint32_t page = m_settings.pageSize;
+  std::vector<render::LightmapFace> faces(m_scene.faces.size());
+  std::vector<float> uvs;
+  for (uint32_t f = 0; f < (uint32_t)m_scene.faces.size(); ++f) {
+    if (m_faceChart[f] == UINT32_MAX) continue;
+    const Chart& c = m_charts[m_faceChart[f]];
+    const Face& face = m_scene.faces[f];
+    faces[f].page = c.page;
+    faces[f].firstUv = (uint32_t)(uvs.size() / 2);
+    faces[f].uvCount = face.indexCount;
+    for (uint32_t i = 0; i < face.indexCount; ++i) {
+      const Vec3& p = m_scene.positions[m_scene.indices[face.firstIndex + i]];
+      float x = (float)c.rect.x + 1.0f + (dot(p, c.axisS) - c.sMin) / c.luxel;
+      float y = (float)c.rect.y + 1.0f + (dot(p, c.axisT) - c.tMin) / c.luxel;
+      uvs.push_back(x / (float)page);
+      uvs.push_back(y / (float)page);
+    }
+  }
+
+  render::LightmapHeader header;
+  header.version = render::kLightmapVersion;
+  header.pageWidth = page;
+  header.pageHeight = page;
+  header.pageCount = m_pageCount;
+  header.faceCount = (uint32_t)faces.size();
+  header.uvCount = (uint32_t)(uvs.size() / 2);
+  header.samplesPerLuxel = m_maxTaken;
+  header.luxelSize = m_settings.luxelSize;
+
+  std::FILE* f = std::fopen(path, "wb");
+  if (!f) {
+    error = std::string("cannot write ") + path;
+    return false;
+  }
+  bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1;
+  ok = ok && (faces.empty() || std::fwrite(faces.data(), sizeof(faces[0]), faces.size(), f) == faces.size());
+  ok = ok && (uvs.empty() || std::fwrite(uvs.data(), sizeof(float), uvs.size(), f) == uvs.size());
+  ok = ok && (rgb.empty() || std::fwrite(rgb.data(), sizeof(float), rgb.size(), f) == rgb.size());
+  ok = std::fclose(f) == 0 && ok;
+  if (!ok) error = std::string("short write to ") + path;
+  return ok;
+}
+
+bool Baker::writePfm(const std::string& prefix, std::string& error) {
+  std::vector<float> rgb;
+  resolve(rgb);
+
+  const uint32_t page = m_settings.pageSize;
+  for (uint32_t p = 0; p < m_pageCount; ++p) {
+    std::string path = prefix + std::to_string(p) + ".pfm";
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+      error = "cannot write " + path;
+      return false;
+    }
+    // PFM: negative scale = little endian, rows stored bottom to top.
+    std::fprintf(f, "PF\n%u %u\n-1.0\n", page, page);
+    bool ok = true;
+    for (uint32_t y = page; y-- > 0 && ok;) {
+      const float* row = &rgb[(((size_t)p * page + y) * page) * 3];
+      ok = std::fwrite(row, sizeof(float) * 3, page, f) == page;
+    }
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) {
+      error = "short write to " + path;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace lightmap
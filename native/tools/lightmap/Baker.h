@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Bvh.h"
+#include "Charts.h"
+#include "Scene.h"
+
+namespace core { class JobSystem; }
+
+namespace lightmap {
+
+struct BakeSettings {
+  float luxelSize = 0.25f;       // world units per luxel
+  uint32_t pageSize = 1024;
+  uint32_t maxSamples = 256;     // per luxel
+  uint32_t passSamples = 16;     // per luxel and pass
+  uint32_t bounces = 3;          // indirect bounces after the first hit
+  float albedo = 0.5f;           // diffuse reflectance of every surface
+  float noiseThreshold = 0.01f;  // relative standard error that counts as converged
+  float timeLimit = 0.0f;        // seconds, 0 = none; checked between passes
+  uint32_t dilate = 2;           // fill passes for luxels off the surface
+};
+
+/// Progressive CPU path tracer for the lightmap charts.
+///
+/// Every pass adds `passSamples` paths to each luxel that is still noisy:
+/// a jittered point in the luxel's footprint, direct light from all lights
+/// (shadow rays), then a cosine-weighted path with next-event estimation at
+/// each bounce and Russian roulette after the second. Luxels are spread over
+/// the job system; every sample's random stream depends only on (luxel,
+/// sample index), so a bake is reproducible for any thread count.
+///
+/// Luxels whose first bounce mostly hits back faces sit inside geometry;
+/// they are dropped after the first pass and filled by dilation, like luxels
+/// that miss their face entirely, so nothing leaks dark or light through
+/// walls.
+class Baker {
+public:
+  Baker(const Scene& scene, const Bvh& bvh, std::vector<Chart>& charts, uint32_t pageCount,
+        const BakeSettings& settings);
+
+  /// Runs passes until every luxel converged, maxSamples is reached or the
+  /// time limit is over. `onPass` (optional) runs on the calling thread
+  /// after each pass, e.g. for previews.
+  void bake(core::JobSystem& jobs, void (*onPass)(Baker& baker, uint32_t pass, void* user) = nullptr,
+            void* user = nullptr);
+
+  /// .lmap (render/LightmapFormat.h) with the current estimate.
+  bool writeLightmap(const char* path, std::string& error);
+  /// One HDR Portable Float Map per page (<prefix><page>.pfm), the input
+  /// format of offline denoisers.
+  bool writePfm(const std::string& prefix, std::string& error);
+
+  uint32_t luxelCount() const { return (uint32_t)m_luxels.size(); }
+  uint32_t maxSamplesTaken() const { return m_maxTaken; }
+
+private:
+  struct Luxel {
+    uint32_t chart = 0;
+    uint32_t texel = 0;    // page * pageSize^2 + y * pageSize + x
+    uint16_t x = 0, y = 0; // inside the chart
+  };
+
+  struct Accum {
+    float sum[3] = { 0, 0, 0 };
+    float lumSq = 0.0f;    // sum of squared sample luminance, for the noise estimate
+    uint32_t samples = 0;
+    uint32_t backfaces = 0;
+  };
+
+  void buildLightGrid();
+  Vec3 directLight(const Vec3& p, const Vec3& n) const;
+  Vec3 samplePath(uint32_t luxelIndex, uint32_t sample, bool& backface) const;
+  void resolve(std::vector<float>& rgb); // averages + dilation into page texels
+
+  const Scene& m_scene;
+  const Bvh& m_bvh;
+  std::vector<Chart>& m_charts;
+  std::vector<uint32_t> m_faceChart; // UINT32_MAX for faces without a chart
+  uint32_t m_pageCount = 0;
+  BakeSettings m_settings;
+
+  std::vector<Luxel> m_luxels;
+  std::vector<Accum> m_accum;    // parallel to m_luxels
+  std::vector<uint32_t> m_active; // luxels still sampled
+  uint32_t m_maxTaken = 0;
+
+  // Uniform grid over the scene bounds; each cell lists lights whose radius
+  // reaches into it (CSR: m_cellStart[c] .. m_cellStart[c + 1]).
+  Vec3 m_gridMin;
+  float m_cellSize = 1.0f;
+  uint32_t m_gridDim[3] = { 1, 1, 1 };
+  std::vector<uint32_t> m_cellStart;
+  std::vector<uint32_t> m_cellLights;
+  float m_epsilon = 1e-3f; // ray offset, scaled to the scene
+};
+
+} // namespace lightmap
@@ -0,0 +1,377 @@
+#include "Bvh.h"
+
+#include <xmmintrin.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace lightmap {
+
+static constexpr uint32_t kBins = 16;
+static constexpr uint32_t kMaxLeafTris = 4;
+static constexpr uint32_t kStackSize = 64 * 3; // 4-wide: depth * 3 pending siblings
+// Unused slots of a node. Their inverted bounds alone do not fail the slab
+// test (min/max are swapped per axis), so traversal checks this too.
+static constexpr uint32_t kEmptySlot = UINT32_MAX;
+
+static Vec3 vmin(Vec3 a, Vec3 b) { return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) }; }
+static Vec3 vmax(Vec3 a, Vec3 b) { return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+static float axisOf(Vec3 v, int axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; }
+
+static float halfArea(Vec3 mn, Vec3 mx) {
+  Vec3 d = mx - mn;
+  if (d.x < 0.0f) return 0.0f;
+  return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+void Bvh::build(const Scene& scene) {
+  m_nodes.clear();
+  m_tris.clear();
+  m_build.clear();
+  m_sourceTris.clear();
+
+  // Fan-triangulate the (convex) faces; degenerate triangles never hit.
+  std::vector<Prim> prims;
+  for (uint32_t f = 0; f < (uint32_t)scene.faces.size(); ++f) {
+    const Face& face = scene.faces[f];
+    const Vec3& a = scene.positions[scene.indices[face.firstIndex]];
+    for (uint32_t i = 1; i + 1 < face.indexCount; ++i) {
+      const Vec3& b = scene.positions[scene.indices[face.firstIndex + i]];
+      const Vec3& c = scene.positions[scene.indices[face.firstIndex + i + 1]];
+      if (length(cross(b - a, c - a)) <= 1e-12f) continue;
+
+      Tri t;
+      t.v0 = a;
+      t.e1 = b - a;
+      t.e2 = c - a;
+      t.face = f;
+      Prim p;
+      p.min = vmin(a, vmin(b, c));
+      p.max = vmax(a, vmax(b, c));
+      p.centroid = (p.min + p.max) * 0.5f;
+      p.tri = (uint32_t)m_sourceTris.size();
+      m_sourceTris.push_back(t);
+      prims.push_back(p);
+    }
+  }
+  if (prims.empty()) return;
+
+  m_tris.reserve(m_sourceTris.size());
+  m_build.reserve(prims.size() * 2);
+  uint32_t root = buildRecursive(prims, 0, (uint32_t)prims.size());
+
+  m_nodes.reserve(prims.size() / 2 + 1);
+  m_nodes.emplace_back(); // root slot, filled by collapse()
+  if (m_build[root].count > 0) {
+    // Tiny scene: a single leaf still needs a four-wide root around it.
+    Node& n = m_nodes[0];
+    for (int i = 0; i < 4; ++i) {
+      n.minX[i] = n.minY[i] = n.minZ[i] = FLT_MAX;
+      n.maxX[i] = n.maxY[i] = n.maxZ[i] = -FLT_MAX;
+      n.child[i] = kEmptySlot;
+      n.count[i] = 0;
+    }
+    const BuildNode& b = m_build[root];
+    n.minX[0] = b.min.x; n.minY[0] = b.min.y; n.minZ[0] = b.min.z;
+    n.maxX[0] = b.max.x; n.maxY[0] = b.max.y; n.maxZ[0] = b.max.z;
+    n.child[0] = b.first;
+    n.count[0] = b.count;
+  } else {
+    m_nodes.pop_back();
+    collapse(root);
+  }
+
+  m_build.clear();
+  m_build.shrink_to_fit();
+  m_sourceTris.clear();
+  m_sourceTris.shrink_to_fit();
+}
+
+uint32_t Bvh::buildRecursive(std::vector<Prim>& prims, uint32_t begin, uint32_t end) {
+  BuildNode node;
+  node.min = prims[begin].min;
+  node.max = prims[begin].max;
+  Vec3 cmin = prims[begin].centroid, cmax = prims[begin].centroid;
+  for (uint32_t i = begin + 1; i < end; ++i) {
+    node.min = vmin(node.min, prims[i].min);
+    node.max = vmax(node.max, prims[i].max);
+    cmin = vmin(cmin, prims[i].centroid);
+    cmax = vmax(cmax, prims[i].centroid);
+  }
+
+  uint32_t count = end - begin;
+  uint32_t index = (uint32_t)m_build.size();
+  m_build.push_back(node);
+
+  auto makeLeaf = [&]() {
+    m_build[index].first = (uint32_t)m_tris.size();
+    m_build[index].count = count;
+    for (uint32_t i = begin; i < end; ++i) m_tris.push_back(m_sourceTris[prims[i].tri]);
+    return index;
+  };
+  if (count <= kMaxLeafTris) return makeLeaf();
+
+  // Binned SAH over the widest centroid axis.
+  Vec3 extent = cmax - cmin;
+  int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+  float lo = axisOf(cmin, axis), span = axisOf(extent, axis);
+  if (span <= 0.0f) {
+    // All centroids coincide: split by count so leaves stay small.
+    uint32_t mid = begin + count / 2;
+    uint32_t left = buildRecursive(prims, begin, mid);
+    uint32_t right = buildRecursive(prims, mid, end);
+    m_build[index].left = left;
+    m_build[index].right = right;
+    return index;
+  }
+
+  struct Bin {
+    Vec3 min{ FLT_MAX, FLT_MAX, FLT_MAX }, max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    uint32_t count = 0;
+  };
+  Bin bins[kBins];
+  float scale = (float)kBins / span;
+  auto binOf = [&](const Prim& p) {
+    return std::min((uint32_t)((axisOf(p.centroid, axis) - lo) * scale), kBins - 1);
+  };
+  for (uint32_t i = begin; i < end; ++i) {
+    Bin& b = bins[binOf(prims[i])];
+    b.min = vmin(b.min, prims[i].min);
+    b.max = vmax(b.max, prims[i].max);
+    b.count++;
+  }
+
+  // Sweep from the right, then from the left, to cost every split plane.
+  float rightArea[kBins];
+  uint32_t rightCount[kBins];
+  Bin acc;
+  for (uint32_t i = kBins - 1; i > 0; --i) {
+    acc.min = vmin(acc.min, bins[i].min);
+    acc.max = vmax(acc.max, bins[i].max);
+    acc.count += bins[i].count;
+    rightArea[i] = halfArea(acc.min, acc.max);
+    rightCount[i] = acc.count;
+  }
+  float bestCost = FLT_MAX;
+  uint32_t bestSplit = 0;
+  acc = Bin{};
+  for (uint32_t i = 0; i + 1 < kBins; ++i) {
+    acc.min = vmin(acc.min, bins[i].min);
+    acc.max = vmax(acc.max, bins[i].max);
+    acc.count += bins[i].count;
+    if (acc.count == 0 || rightCount[i + 1] == 0) continue;
+    float cost = halfArea(acc.min, acc.max) * (float)acc.count + rightArea[i + 1] * (float)rightCount[i + 1];
+    if (cost < bestCost) {
+      bestCost = cost;
+      bestSplit = i;
+    }
+  }
+
+  uint32_t mid;
+  if (bestCost == FLT_MAX) {
+    // Every centroid landed in one bin: median split along the axis.
+    mid = begin + count / 2;
+    std::nth_element(prims.begin() + begin, prims.begin() + mid, prims.begin() + end,
+                     [&](const Prim& x, const Prim& y) { return axisOf(x.centroid, axis) < axisOf(y.centroid, axis); });
+  } else {
+    Prim* split = std::partition(prims.data() + begin, prims.data() + end,
+                                 [&](const Prim& p) { return binOf(p) <= bestSplit; });
+    mid = (uint32_t)(split - prims.data());
+  }
+
+  uint32_t left = buildRecursive(prims, begin, mid);
+  uint32_t right = buildRecursive(prims, mid, end);
+  m_build[index].left = left;
+  m_build[index].right = right;
+  return index;
+}
+
+uint32_t Bvh::collapse(uint32_t buildNode) {
+  // Pull grandchildren up until four slots are used: always open the
+  // largest inner child, it is the one most rays would descend into.
+  uint32_t slots[4] = { m_build[buildNode].left, m_build[buildNode].right, 0, 0 };
+  uint32_t used = 2;
+  while (used < 4) {
+    int best = -1;
+    float bestArea = -1.0f;
+    for (uint32_t i = 0; i < used; ++i) {
+      const BuildNode& b = m_build[slots[i]];
+      if (b.count > 0) continue;
+      float a = halfArea(b.min, b.max);
+      if (a > bestArea) { bestArea = a; best = (int)i; }
+    }
+    if (best < 0) break;
+    uint32_t opened = slots[best];
+    slots[best] = m_build[opened].left;
+    slots[used++] = m_build[opened].right;
+  }
+
+  uint32_t index = (uint32_t)m_nodes.size();
+  m_nodes.emplace_back();
+  for (uint32_t i = 0; i < 4; ++i) {
+    Node& n = m_nodes[index];
+    if (i >= used) {
+      n.minX[i] = n.minY[i] = n.minZ[i] = FLT_MAX;
+      n.maxX[i] = n.maxY[i] = n.maxZ[i] = -FLT_MAX;
+      n.child[i] = kEmptySlot;
+      n.count[i] = 0;
+      continue;
+    }
+    const BuildNode b = m_build[slots[i]];
+    n.minX[i] = b.min.x; n.minY[i] = b.min.y; n.minZ[i] = b.min.z;
+    n.maxX[i] = b.max.x; n.maxY[i] = b.max.y; n.maxZ[i] = b.max.z;
+    if (b.count > 0) {
+      n.child[i] = b.first;
+      n.count[i] = b.count;
+    } else {
+      uint32_t child = collapse(slots[i]); // may reallocate m_nodes
+      m_nodes[index].child[i] = child;
+      m_nodes[index].count[i] = 0;
+    }
+  }
+  return index;
+}
+
+namespace {
+
+struct RaySimd {
+  __m128 ox, oy, oz;
+  __m128 idx, idy, idz;
+};
+
+RaySimd makeRay(const Vec3& o, const Vec3& d) {
+  // Axis-parallel rays: a huge finite reciprocal keeps the slabs NaN free.
+  auto inv = [](float v) { return std::fabs(v) > 1e-12f ? 1.0f / v : (v < 0.0f ? -1e30f : 1e30f); };
+  RaySimd r;
+  r.ox = _mm_set1_ps(o.x); r.oy = _mm_set1_ps(o.y); r.oz = _mm_set1_ps(o.z);
+  r.idx = _mm_set1_ps(inv(d.x)); r.idy = _mm_set1_ps(inv(d.y)); r.idz = _mm_set1_ps(inv(d.z));
+  return r;
+}
+
+// Slab test against the node's four boxes; returns a 4-bit hit mask and
+// the entry distances.
+inline int slabs(const RaySimd& r, const float* minX, const float* minY, const float* minZ,
+                 const float* maxX, const float* maxY, const float* maxZ, float tMax, __m128& tNear) {
+  __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(minX), r.ox), r.idx);
+  __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maxX), r.ox), r.idx);
+  __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(minY), r.oy), r.idy);
+  __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maxY), r.oy), r.idy);
+  __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(minZ), r.oz), r.idz);
+  __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maxZ), r.oz), r.idz);
+
+  __m128 tn = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+                         _mm_max_ps(_mm_min_ps(z0, z1), _mm_setzero_ps()));
+  __m128 tf = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+                         _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(tMax)));
+  tNear = tn;
+  return _mm_movemask_ps(_mm_cmple_ps(tn, tf));
+}
+
+} // namespace
+
+// Moller-Trumbore; t in (tMin, tMax) with a small tMin against self hits.
+static inline bool hitTri(const Vec3& o, const Vec3& d, const Vec3& v0, const Vec3& e1, const Vec3& e2,
+                          float tMax, float& t, bool& backface) {
+  Vec3 p = cross(d, e2);
+  float det = dot(e1, p);
+  if (std::fabs(det) < 1e-12f) return false;
+  float inv = 1.0f / det;
+  Vec3 s = o - v0;
+  float u = dot(s, p) * inv;
+  if (u < 0.0f || u > 1.0f) return false;
+  Vec3 q = cross(s, e1);
+  float v = dot(d, q) * inv;
+  if (v < 0.0f || u + v > 1.0f) return false;
+  float tt = dot(e2, q) * inv;
+  if (tt <= 1e-5f || tt >= tMax) return false;
+  t = tt;
+  backface = det < 0.0f;
+  return true;
+}
+
+bool Bvh::intersect(const Vec3& origin, const Vec3& dir, float tMax, Hit& hit) const {
+  if (m_nodes.empty()) return false;
+  RaySimd r = makeRay(origin, dir);
+
+  struct Entry { uint32_t node; float t; };
+  Entry stack[kStackSize];
+  uint32_t sp = 0;
+  stack[sp++] = { 0, 0.0f };
+  bool found = false;
+  float closest = tMax;
+
+  while (sp > 0) {
+    Entry e = stack[--sp];
+    if (e.t > closest) continue;
+    const Node& n = m_nodes[e.node];
+
+    alignas(16) float tn[4];
+    __m128 tNear;
+    int mask = slabs(r, n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, closest, tNear);
+    _mm_store_ps(tn, tNear);
+
+    // Leaves right away; inner children pushed far-to-near so the nearest
+    // pops first and shrinks `closest` for the rest.
+    Entry inner[4];
+    uint32_t innerCount = 0;
+    for (int i = 0; i < 4; ++i) {
+      if (!(mask & (1 << i)) || n.child[i] == kEmptySlot) continue;
+      if (n.count[i] > 0) {
+        for (uint32_t k = n.child[i], end = n.child[i] + n.count[i]; k < end; ++k) {
+          const Tri& tri = m_tris[k];
+          float t;
+          bool back;
+          if (hitTri(origin, dir, tri.v0, tri.e1, tri.e2, closest, t, back)) {
+            closest = t;
+            hit.t = t;
+            hit.face = tri.face;
+            hit.backface = back;
+            found = true;
+          }
+        }
+      } else {
+        inner[innerCount++] = { n.child[i], tn[i] };
+      }
+    }
+    for (uint32_t i = 1; i < innerCount; ++i) { // at most 4: insertion sort
+      Entry e2 = inner[i];
+      uint32_t j = i;
+      for (; j > 0 && inner[j - 1].t < e2.t; --j) inner[j] = inner[j - 1];
+      inner[j] = e2;
+    }
+    for (uint32_t i = 0; i < innerCount && sp < kStackSize; ++i) stack[sp++] = inner[i];
+  }
+  return found;
+}
+
+bool Bvh::occluded(const Vec3& origin, const Vec3& dir, float tMax) const {
+  if (m_nodes.empty()) return false;
+  RaySimd r = makeRay(origin, dir);
+
+  uint32_t stack[kStackSize];
+  uint32_t sp = 0;
+  stack[sp++] = 0;
+
+  while (sp > 0) {
+    const Node& n = m_nodes[stack[--sp]];
+    __m128 tNear;
+    int mask = slabs(r, n.minX, n.minY, n.minZ, n.maxX, n.maxY, n.maxZ, tMax, tNear);
+    for (int i = 0; i < 4; ++i) {
+      if (!(mask & (1 << i)) || n.child[i] == kEmptySlot) continue;
+      if (n.count[i] > 0) {
+        for (uint32_t k = n.child[i], end = n.child[i] + n.count[i]; k < end; ++k) {
+          const Tri& tri = m_tris[k];
+          float t;
+          bool back;
+          if (hitTri(origin, dir, tri.v0, tri.e1, tri.e2, tMax, t, back)) return true;
+        }
+      } else if (sp < kStackSize) {
+        stack[sp++] = n.child[i];
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace lightmap
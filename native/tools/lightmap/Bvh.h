@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Scene.h"
+
+namespace lightmap {
+
+struct Hit {
+  float t = 0.0f;
+  uint32_t face = 0;
+  bool backface = false; // ray came from behind the face (winding order)
+};
+
+/// Four-wide bounding volume hierarchy over the scene's triangles.
+///
+/// Built as a binary SAH tree (binned, 16 bins per split) and then collapsed
+/// so every node holds up to four children whose boxes sit side by side in
+/// SoA form: one SSE slab test checks all four at once. Leaves keep up to
+/// four triangles, stored in traversal order as (v0, edge1, edge2).
+///
+/// Read-only after build(), so any number of threads can trace at once.
+class Bvh {
+public:
+  void build(const Scene& scene);
+
+  /// Closest hit in (0, tMax]. `dir` must be normalized.
+  bool intersect(const Vec3& origin, const Vec3& dir, float tMax, Hit& hit) const;
+  /// Any hit in (0, tMax); cheaper than intersect() for shadow rays.
+  bool occluded(const Vec3& origin, const Vec3& dir, float tMax) const;
+
+  uint32_t nodeCount() const { return (uint32_t)m_nodes.size(); }
+  uint32_t triangleCount() const { return (uint32_t)m_tris.size(); }
+
+private:
+  struct alignas(16) Node {
+    float minX[4], minY[4], minZ[4];
+    float maxX[4], maxY[4], maxZ[4];
+    uint32_t child[4]; // inner: node index; leaf: first triangle; UINT32_MAX: empty
+    uint32_t count[4]; // leaf: triangle count; 0 = inner node or empty slot
+  };
+
+  struct Tri {
+    Vec3 v0, e1, e2;
+    uint32_t face = 0;
+  };
+
+  struct BuildNode {
+    Vec3 min, max;
+    uint32_t left = 0, right = 0; // inner
+    uint32_t first = 0, count = 0; // leaf when count > 0
+  };
+
+  struct Prim {
+    Vec3 min, max, centroid;
+    uint32_t tri = 0;
+  };
+
+  uint32_t buildRecursive(std::vector<Prim>& prims, uint32_t begin, uint32_t end);
+  uint32_t collapse(uint32_t buildNode);
+
+  std::vector<Node> m_nodes; // m_nodes[0] is the root
+  std::vector<Tri> m_tris;
+  std::vector<BuildNode> m_build; // scratch, cleared after build()
+  std::vector<Tri> m_sourceTris;  // scratch, unordered
+};
+
+} // namespace lightmap
@@ -0,0 +1,133 @@
+#include "Charts.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace lightmap {
+
+std::vector<Chart> buildCharts(const Scene& scene, float luxelSize, uint32_t pageSize) {
+  std::vector<Chart> charts;
+  charts.reserve(scene.faces.size());
+  const uint32_t maxLuxels = pageSize - 2; // room for the border
+
+  for (uint32_t f = 0; f < (uint32_t)scene.faces.size(); ++f) {
+    const Face& face = scene.faces[f];
+
+    // Newell normal: robust for slightly non-planar polygons.
+    Vec3 n{};
+    for (uint32_t i = 0; i < face.indexCount; ++i) {
+      const Vec3& a = scene.positions[scene.indices[face.firstIndex + i]];
+      const Vec3& b = scene.positions[scene.indices[face.firstIndex + (i + 1) % face.indexCount]];
+      n.x += (a.y - b.y) * (a.z + b.z);
+      n.y += (a.z - b.z) * (a.x + b.x);
+      n.z += (a.x - b.x) * (a.y + b.y);
+    }
+    if (length(n) <= 1e-12f) continue;
+
+    Chart c;
+    c.face = f;
+    c.normal = normalize(n);
+    Vec3 ref = std::fabs(c.normal.y) < 0.9f ? Vec3{ 0.0f, 1.0f, 0.0f } : Vec3{ 1.0f, 0.0f, 0.0f };
+    c.axisS = normalize(cross(ref, c.normal));
+    c.axisT = cross(c.normal, c.axisS);
+    c.planeD = dot(c.normal, scene.positions[scene.indices[face.firstIndex]]);
+
+    float sMax = -1e30f, tMax = -1e30f;
+    c.sMin = c.tMin = 1e30f;
+    for (uint32_t i = 0; i < face.indexCount; ++i) {
+      const Vec3& p = scene.positions[scene.indices[face.firstIndex + i]];
+      float s = dot(p, c.axisS), t = dot(p, c.axisT);
+      c.polygon.push_back(s);
+      c.polygon.push_back(t);
+      c.sMin = std::min(c.sMin, s); sMax = std::max(sMax, s);
+      c.tMin = std::min(c.tMin, t); tMax = std::max(tMax, t);
+    }
+
+    float extent = std::max(sMax - c.sMin, tMax - c.tMin);
+    c.luxel = std::max(luxelSize, extent / (float)maxLuxels);
+    c.w = std::min((uint32_t)std::ceil((sMax - c.sMin) / c.luxel), maxLuxels) + 2;
+    c.h = std::min((uint32_t)std::ceil((tMax - c.tMin) / c.luxel), maxLuxels) + 2;
+    c.w = std::max(c.w, 3u);
+    c.h = std::max(c.h, 3u);
+    charts.push_back(std::move(c));
+  }
+  return charts;
+}
+
+uint32_t packCharts(std::vector<Chart>& charts, uint32_t pageSize) {
+  std::vector<uint32_t> order(charts.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    if (charts[a].h != charts[b].h) return charts[a].h > charts[b].h;
+    return charts[a].w > charts[b].w;
+  });
+
+  // Tallest first keeps shelves dense; a chart that fits no open page
+  // starts a new one.
+  std::vector<render::AtlasAllocator> pages;
+  for (uint32_t i : order) {
+    Chart& c = charts[i];
+    bool placed = false;
+    for (uint32_t p = 0; p < (uint32_t)pages.size() && !placed; ++p) {
+      if (pages[p].alloc(c.w, c.h, c.rect)) {
+        c.page = p;
+        placed = true;
+      }
+    }
+    if (!placed) {
+      pages.emplace_back();
+      pages.back().init(pageSize, pageSize);
+      pages.back().alloc(c.w, c.h, c.rect);
+      c.page = (uint32_t)pages.size() - 1;
+    }
+  }
+  return (uint32_t)pages.size();
+}
+
+void clampToPolygon(const Chart& chart, float& s, float& t, float inset) {
+  const std::vector<float>& poly = chart.polygon;
+  size_t n = poly.size() / 2;
+
+  // Inside when on the same side of every edge (either winding).
+  int sign = 0;
+  bool inside = true;
+  for (size_t i = 0; i < n && inside; ++i) {
+    float ax = poly[i * 2], ay = poly[i * 2 + 1];
+    float bx = poly[(i + 1) % n * 2], by = poly[(i + 1) % n * 2 + 1];
+    float c = (bx - ax) * (t - ay) - (by - ay) * (s - ax);
+    if (c == 0.0f) continue;
+    int sc = c > 0.0f ? 1 : -1;
+    if (sign == 0) sign = sc;
+    else if (sc != sign) inside = false;
+  }
+  if (inside) return;
+
+  float bestD = 1e30f, bestS = s, bestT = t;
+  for (size_t i = 0; i < n; ++i) {
+    float ax = poly[i * 2], ay = poly[i * 2 + 1];
+    float bx = poly[(i + 1) % n * 2], by = poly[(i + 1) % n * 2 + 1];
+    float ex = bx - ax, ey = by - ay;
+    float len2 = ex * ex + ey * ey;
+    float u = len2 > 0.0f ? std::clamp(((s - ax) * ex + (t - ay) * ey) / len2, 0.0f, 1.0f) : 0.0f;
+    float px = ax + ex * u, py = ay + ey * u;
+    float d = (px - s) * (px - s) + (py - t) * (py - t);
+    if (d < bestD) {
+      bestD = d;
+      bestS = px;
+      bestT = py;
+    }
+  }
+  // Pull off the edge so rays do not start inside the neighbouring wall.
+  float cx = 0.0f, cy = 0.0f;
+  for (size_t i = 0; i < n; ++i) { cx += poly[i * 2]; cy += poly[i * 2 + 1]; }
+  cx /= (float)n;
+  cy /= (float)n;
+  float dx = cx - bestS, dy = cy - bestT;
+  float len = std::sqrt(dx * dx + dy * dy);
+  float step = len > 0.0f ? std::min(inset, len) / len : 0.0f;
+  s = bestS + dx * step;
+  t = bestT + dy * step;
+}
+
+} // namespace lightmap
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Scene.h"
+#include "render/AtlasAllocator.h"
+
+namespace lightmap {
+
+/// One face's rectangle of luxels. The face is planar, so it is unwrapped
+/// by projecting onto its own plane: (s, t) are world-unit coordinates along
+/// axisS/axisT, luxel (x, y) is centred on
+///   s = sMin + (x - 0.5) * luxel,  t = tMin + (y - 0.5) * luxel
+/// which leaves a one-luxel border around the face for bilinear filtering.
+struct Chart {
+  uint32_t face = 0;
+  Vec3 normal, axisS, axisT;
+  float planeD = 0.0f;   // dot(normal, any point on the face)
+  float sMin = 0.0f, tMin = 0.0f;
+  float luxel = 0.0f;    // world units per luxel, >= the requested size
+  uint32_t w = 0, h = 0; // luxels including the border
+  std::vector<float> polygon; // face corners as (s, t) pairs
+
+  uint32_t page = 0;
+  render::AtlasRect rect;
+
+  Vec3 point(float s, float t) const { return axisS * s + axisT * t + normal * planeD; }
+};
+
+/// One chart per face. Charts larger than a page are scaled down (coarser
+/// luxels) to fit; degenerate faces get none.
+std::vector<Chart> buildCharts(const Scene& scene, float luxelSize, uint32_t pageSize);
+
+/// Packs charts tallest first into as many pageSize^2 pages as needed.
+/// Returns the page count.
+uint32_t packCharts(std::vector<Chart>& charts, uint32_t pageSize);
+
+/// Leaves (s, t) alone when inside the chart's polygon, otherwise moves it
+/// to the closest edge point and then `inset` towards the centre. Convex
+/// polygons only.
+void clampToPolygon(const Chart& chart, float& s, float& t, float inset);
+
+} // namespace lightmap
@@ -0,0 +1,147 @@
+// Offline lightmap baker for the static world.
+//
+//   LightmapBaker map.obj [options]
+//
+//   --lights <file>     light list (see Scene.h); default <map>.lights if present
+//   --out <file>        default <map>.lmap
+//   --luxel <size>      world units per luxel (0.25)
+//   --page <size>       page width/height in luxels (1024)
+//   --samples <n>       max paths per luxel (256)
+//   --pass <n>          paths per luxel and pass (16)
+//   --bounces <n>       indirect bounces (3)
+//   --albedo <a>        surface reflectance (0.5)
+//   --noise <e>         relative error at which a luxel stops (0.01)
+//   --time <seconds>    stop after the pass that crosses this
+//   --threads <n>       worker threads (all cores)
+//   --pfm <prefix>      also write <prefix><page>.pfm for a denoiser
+//   --preview           rewrite the outputs after every pass
+//
+// Runs on the CPU only, so it works on build machines without a GPU.
+
+#include "Baker.h"
+#include "Bvh.h"
+#include "Charts.h"
+#include "Scene.h"
+#include "core/JobSystem.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace {
+
+struct Options {
+  std::string map, lights, out, pfm;
+  bool preview = false;
+  unsigned threads = 0;
+  lightmap::BakeSettings bake;
+};
+
+void usage() {
+  std::printf("usage: LightmapBaker map.obj [--lights f] [--out f.lmap] [--luxel s] [--page n]\n"
+              "       [--samples n] [--pass n] [--bounces n] [--albedo a] [--noise e] [--time s]\n"
+              "       [--threads n] [--pfm prefix] [--preview]\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+    const char* v = nullptr;
+
+    if (a[0] != '-') {
+      if (!o.map.empty()) return false;
+      o.map = a;
+      continue;
+    }
+    if (std::strcmp(a, "--preview") == 0) { o.preview = true; continue; }
+    if (!(v = value())) return false;
+
+    if (std::strcmp(a, "--lights") == 0) o.lights = v;
+    else if (std::strcmp(a, "--out") == 0) o.out = v;
+    else if (std::strcmp(a, "--pfm") == 0) o.pfm = v;
+    else if (std::strcmp(a, "--luxel") == 0) o.bake.luxelSize = (float)std::atof(v);
+    else if (std::strcmp(a, "--page") == 0) o.bake.pageSize = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--samples") == 0) o.bake.maxSamples = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--pass") == 0) o.bake.passSamples = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--bounces") == 0) o.bake.bounces = (uint32_t)std::atoi(v);
+    else if (std::strcmp(a, "--albedo") == 0) o.bake.albedo = (float)std::atof(v);
+    else if (std::strcmp(a, "--noise") == 0) o.bake.noiseThreshold = (float)std::atof(v);
+    else if (std::strcmp(a, "--time") == 0) o.bake.timeLimit = (float)std::atof(v);
+    else if (std::strcmp(a, "--threads") == 0) o.threads = (unsigned)std::atoi(v);
+    else return false;
+  }
+  if (o.map.empty()) return false;
+  if (o.bake.luxelSize <= 0.0f || o.bake.pageSize < 16 || o.bake.pageSize > 16384 ||
+      o.bake.maxSamples == 0 || o.bake.passSamples == 0) {
+    return false;
+  }
+
+  std::string stem = o.map;
+  size_t dot = stem.find_last_of('.');
+  size_t slash = stem.find_last_of("/\\");
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) stem.resize(dot);
+  if (o.out.empty()) o.out = stem + ".lmap";
+  if (o.lights.empty() && std::ifstream(stem + ".lights")) o.lights = stem + ".lights";
+  return true;
+}
+
+bool writeOutputs(lightmap::Baker& baker, const Options& o) {
+  std::string error;
+  if (!baker.writeLightmap(o.out.c_str(), error) || (!o.pfm.empty() && !baker.writePfm(o.pfm, error))) {
+    std::printf("[ERR ] %s\n", error.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) {
+    usage();
+    return 2;
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto seconds = [&]() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  lightmap::Scene scene;
+  std::string error;
+  if (!lightmap::loadObj(o.map.c_str(), scene, error) ||
+      (!o.lights.empty() && !lightmap::loadLights(o.lights.c_str(), scene, error))) {
+    std::printf("[ERR ] %s\n", error.c_str());
+    return 1;
+  }
+  std::printf("[INFO] %s: %zu faces, %zu lights%s\n", o.map.c_str(), scene.faces.size(), scene.lights.size(),
+              scene.sunColor.x + scene.sunColor.y + scene.sunColor.z > 0.0f ? " + sun" : "");
+
+  lightmap::Bvh bvh;
+  bvh.build(scene);
+  std::printf("[INFO] BVH: %u triangles, %u nodes (%.2f s)\n", bvh.triangleCount(), bvh.nodeCount(), seconds());
+
+  std::vector<lightmap::Chart> charts = lightmap::buildCharts(scene, o.bake.luxelSize, o.bake.pageSize);
+  uint32_t pages = lightmap::packCharts(charts, o.bake.pageSize);
+  std::printf("[INFO] Charts: %zu in %u page(s) of %u^2\n", charts.size(), pages, o.bake.pageSize);
+
+  core::JobSystem jobs;
+  jobs.init(o.threads);
+
+  lightmap::Baker baker(scene, bvh, charts, pages, o.bake);
+  std::printf("[INFO] Baking %u luxels on %u threads\n", baker.luxelCount(), jobs.threadCount());
+
+  auto preview = [](lightmap::Baker& b, uint32_t, void* user) {
+    writeOutputs(b, *static_cast<const Options*>(user));
+  };
+  baker.bake(jobs, o.preview ? +preview : nullptr, &o);
+  jobs.shutdown();
+
+  if (!writeOutputs(baker, o)) return 1;
+  std::printf("[INFO] Wrote %s (%u spp max) in %.1f s\n", o.out.c_str(), baker.maxSamplesTaken(), seconds());
+  return 0;
+}
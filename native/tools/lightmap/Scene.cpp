@@ -0,0 +1,124 @@
+#include "Scene.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace lightmap {
+
+static constexpr float kDegToRad = 3.14159265358979f / 180.0f;
+
+bool loadObj(const char* path, Scene& scene, std::string& error) {
+  std::ifstream in(path);
+  if (!in) {
+    error = std::string("cannot open ") + path;
+    return false;
+  }
+
+  std::string line;
+  uint32_t lineNo = 0;
+  while (std::getline(in, line)) {
+    ++lineNo;
+    std::istringstream ls(line);
+    std::string tag;
+    if (!(ls >> tag) || tag[0] == '#') continue;
+
+    if (tag == "v") {
+      Vec3 p;
+      if (!(ls >> p.x >> p.y >> p.z)) {
+        error = std::string(path) + ":" + std::to_string(lineNo) + ": bad vertex";
+        return false;
+      }
+      scene.positions.push_back(p);
+    } else if (tag == "f") {
+      // "a", "a/b", "a//c", "a/b/c"; negative indices count from the end.
+      Face face;
+      face.firstIndex = (uint32_t)scene.indices.size();
+      std::string corner;
+      while (ls >> corner) {
+        long idx = std::strtol(corner.c_str(), nullptr, 10);
+        long count = (long)scene.positions.size();
+        if (idx < 0) idx = count + idx + 1;
+        if (idx < 1 || idx > count) {
+          error = std::string(path) + ":" + std::to_string(lineNo) + ": vertex index out of range";
+          return false;
+        }
+        scene.indices.push_back((uint32_t)(idx - 1));
+      }
+      face.indexCount = (uint32_t)scene.indices.size() - face.firstIndex;
+      if (face.indexCount < 3) {
+        error = std::string(path) + ":" + std::to_string(lineNo) + ": face with fewer than 3 corners";
+        return false;
+      }
+      scene.faces.push_back(face);
+    }
+    // vt/vn/o/g/s/usemtl/mtllib: not needed for baking.
+  }
+
+  if (scene.faces.empty()) {
+    error = std::string(path) + ": no faces";
+    return false;
+  }
+  return true;
+}
+
+bool loadLights(const char* path, Scene& scene, std::string& error) {
+  std::ifstream in(path);
+  if (!in) {
+    error = std::string("cannot open ") + path;
+    return false;
+  }
+
+  std::string line;
+  uint32_t lineNo = 0;
+  while (std::getline(in, line)) {
+    ++lineNo;
+    std::istringstream ls(line);
+    std::string tag;
+    if (!(ls >> tag) || tag[0] == '#') continue;
+
+    bool ok = true;
+    if (tag == "point" || tag == "spot") {
+      render::Light l;
+      ok = (bool)(ls >> l.position[0] >> l.position[1] >> l.position[2]);
+      if (ok && tag == "spot") {
+        Vec3 d;
+        ok = (bool)(ls >> d.x >> d.y >> d.z);
+        d = normalize(d);
+        l.direction[0] = d.x; l.direction[1] = d.y; l.direction[2] = d.z;
+      }
+      ok = ok && (ls >> l.color[0] >> l.color[1] >> l.color[2] >> l.intensity >> l.radius);
+      if (ok && tag == "spot") {
+        float inner = 0, outer = 0;
+        ok = (bool)(ls >> inner >> outer);
+        l.type = render::LightType::Spot;
+        l.cosInner = std::cos(inner * kDegToRad);
+        l.cosOuter = std::cos(outer * kDegToRad);
+      }
+      ok = ok && l.radius > 0.0f;
+      if (ok) scene.lights.push_back(l);
+    } else if (tag == "sun") {
+      Vec3 d, c;
+      float intensity = 1.0f;
+      ok = (bool)(ls >> d.x >> d.y >> d.z >> c.x >> c.y >> c.z >> intensity);
+      if (ok) {
+        scene.sunDirection = normalize(d);
+        scene.sunColor = c * intensity;
+      }
+    } else if (tag == "sky") {
+      ok = (bool)(ls >> scene.sky.x >> scene.sky.y >> scene.sky.z);
+    } else {
+      error = std::string(path) + ":" + std::to_string(lineNo) + ": unknown light type '" + tag + "'";
+      return false;
+    }
+
+    if (!ok) {
+      error = std::string(path) + ":" + std::to_string(lineNo) + ": bad " + tag;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace lightmap
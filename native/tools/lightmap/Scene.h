@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "render/Lights.h"
+#include "render/RenderMath.h"
+
+namespace lightmap {
+
+using render::Vec3;
+
+/// One planar map surface (a BSP face): a convex polygon over `indices`.
+struct Face {
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+};
+
+/// Static world geometry plus the lights baked into it.
+///
+/// Geometry comes from a Wavefront OBJ (v/f only, the interchange format the
+/// map compiler is going to emit); lights from a small text file:
+///
+///   point  x y z  r g b  intensity radius
+///   spot   x y z  dx dy dz  r g b  intensity radius inner_deg outer_deg
+///   sun    dx dy dz  r g b  intensity        (direction the light travels)
+///   sky    r g b                             (radiance of escaping rays)
+///
+/// Point/spot lights use the runtime's falloff (clustered_lighting.glsl), so
+/// a baked light and a dynamic one with the same values match.
+struct Scene {
+  std::vector<Vec3> positions;
+  std::vector<uint32_t> indices;
+  std::vector<Face> faces;
+
+  std::vector<render::Light> lights;
+  Vec3 sunDirection{ 0.0f, -1.0f, 0.0f };
+  Vec3 sunColor{ 0.0f, 0.0f, 0.0f }; // color * intensity, 0 = no sun
+  Vec3 sky{ 0.0f, 0.0f, 0.0f };
+};
+
+/// False with a message in `error` on unreadable files or bad lines.
+bool loadObj(const char* path, Scene& scene, std::string& error);
+bool loadLights(const char* path, Scene& scene, std::string& error);
+
+} // namespace lightmap
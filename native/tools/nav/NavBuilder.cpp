@@ -0,0 +1,100 @@
+// Offline navmesh builder for the static world.
+//
+//   NavBuilder map.obj [options]
+//
+//   --out <file>        default <map>.nav
+//   --slope <deg>       steepest walkable face (45)
+//   --climb <h>         highest step between walkable edges (0.45)
+//   --height <h>        headroom a face needs to be walkable (1.8)
+//   --weld <d>          corners closer than this are merged (0.001)
+//   --cluster <n>       polygons per cluster of the coarse graph (32)
+//
+// Reads the same OBJ the game loads as its world; writes src/nav/NavFormat.h.
+
+#include "NavGen.h"
+#include "../lightmap/Bvh.h"
+#include "../lightmap/Scene.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct Options {
+  std::string map, out;
+  nav::NavSettings nav;
+};
+
+void usage() {
+  std::printf("usage: NavBuilder map.obj [--out f.nav] [--slope deg] [--climb h] [--height h]\n"
+              "       [--weld d] [--cluster n]\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (a[0] != '-') {
+      if (!o.map.empty()) return false;
+      o.map = a;
+      continue;
+    }
+    if (i + 1 >= argc) return false;
+    const char* v = argv[++i];
+
+    if (std::strcmp(a, "--out") == 0) o.out = v;
+    else if (std::strcmp(a, "--slope") == 0) o.nav.maxSlopeDeg = (float)std::atof(v);
+    else if (std::strcmp(a, "--climb") == 0) o.nav.maxClimb = (float)std::atof(v);
+    else if (std::strcmp(a, "--height") == 0) o.nav.agentHeight = (float)std::atof(v);
+    else if (std::strcmp(a, "--weld") == 0) o.nav.weldTolerance = (float)std::atof(v);
+    else if (std::strcmp(a, "--cluster") == 0) o.nav.clusterSize = (uint32_t)std::atoi(v);
+    else return false;
+  }
+  if (o.map.empty()) return false;
+  if (o.nav.maxSlopeDeg <= 0.0f || o.nav.maxSlopeDeg >= 90.0f || o.nav.maxClimb < 0.0f ||
+      o.nav.agentHeight <= 0.0f || o.nav.weldTolerance <= 0.0f || o.nav.clusterSize == 0) {
+    return false;
+  }
+
+  if (o.out.empty()) {
+    std::string stem = o.map;
+    size_t dot = stem.find_last_of('.');
+    size_t slash = stem.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) stem.resize(dot);
+    o.out = stem + ".nav";
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) {
+    usage();
+    return 2;
+  }
+  auto start = std::chrono::steady_clock::now();
+
+  lightmap::Scene scene;
+  std::string error;
+  if (!lightmap::loadObj(o.map.c_str(), scene, error)) {
+    std::printf("[ERR ] %s\n", error.c_str());
+    return 1;
+  }
+  std::printf("[INFO] %s: %zu faces\n", o.map.c_str(), scene.faces.size());
+
+  lightmap::Bvh bvh;
+  bvh.build(scene);
+
+  nav::NavData data;
+  if (!nav::buildNavMesh(scene, bvh, o.nav, data, error) || !nav::writeNavMesh(o.out.c_str(), data, error)) {
+    std::printf("[ERR ] %s\n", error.c_str());
+    return 1;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("[INFO] Wrote %s in %.2f s\n", o.out.c_str(), seconds);
+  return 0;
+}
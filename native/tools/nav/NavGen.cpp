@@ -0,0 +1,497 @@
+#include "NavGen.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+
+namespace nav {
+
+namespace {
+
+using render::Vec3;
+
+constexpr float kDegToRad = 3.14159265358979f / 180.0f;
+
+// Twice the signed area of abc seen from above; positive when
+// counter-clockwise (the winding of an upward-facing face).
+float area2(const Vec3& a, const Vec3& b, const Vec3& c) {
+  return (b.z - a.z) * (c.x - a.x) - (b.x - a.x) * (c.z - a.z);
+}
+
+uint64_t cellKey(int32_t x, int32_t y, int32_t z) {
+  return ((uint64_t)(uint32_t)(x & 0x1FFFFF) << 42) | ((uint64_t)(uint32_t)(y & 0x1FFFFF) << 21) |
+         (uint64_t)(uint32_t)(z & 0x1FFFFF);
+}
+
+// Merges points closer than `tolerance`: a hash grid of tolerance-sized
+// cells, searched 3x3x3 around each new point.
+class Welder {
+public:
+  explicit Welder(float tolerance) : m_tolerance(tolerance), m_invCell(1.0f / tolerance) {}
+
+  uint32_t add(const Vec3& p) {
+    const int32_t cx = (int32_t)std::floor(p.x * m_invCell);
+    const int32_t cy = (int32_t)std::floor(p.y * m_invCell);
+    const int32_t cz = (int32_t)std::floor(p.z * m_invCell);
+    const float tol2 = m_tolerance * m_tolerance;
+    for (int32_t dx = -1; dx <= 1; ++dx) {
+      for (int32_t dy = -1; dy <= 1; ++dy) {
+        for (int32_t dz = -1; dz <= 1; ++dz) {
+          auto it = m_grid.find(cellKey(cx + dx, cy + dy, cz + dz));
+          if (it == m_grid.end()) continue;
+          for (uint32_t v : it->second) {
+            Vec3 d = vertices[v] - p;
+            if (dot(d, d) <= tol2) return v;
+          }
+        }
+      }
+    }
+    uint32_t v = (uint32_t)vertices.size();
+    vertices.push_back(p);
+    m_grid[cellKey(cx, cy, cz)].push_back(v);
+    return v;
+  }
+
+  std::vector<Vec3> vertices;
+
+private:
+  float m_tolerance, m_invCell;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> m_grid;
+};
+
+// Items bucketed by the cells of a 2D grid (x, z) that their box touches.
+class FlatGrid {
+public:
+  FlatGrid(float cell) : m_invCell(1.0f / cell) {}
+
+  void insert(uint32_t item, float minX, float minZ, float maxX, float maxZ) {
+    forCells(minX, minZ, maxX, maxZ, [&](uint64_t key) { m_cells[key].push_back(item); });
+  }
+
+  /// Every item sharing a cell with the box, possibly more than once.
+  void query(float minX, float minZ, float maxX, float maxZ, std::vector<uint32_t>& out) const {
+    forCells(minX, minZ, maxX, maxZ, [&](uint64_t key) {
+      auto it = m_cells.find(key);
+      if (it != m_cells.end()) out.insert(out.end(), it->second.begin(), it->second.end());
+    });
+  }
+
+private:
+  template <class Fn> void forCells(float minX, float minZ, float maxX, float maxZ, Fn&& fn) const {
+    const int32_t x0 = (int32_t)std::floor(minX * m_invCell), x1 = (int32_t)std::floor(maxX * m_invCell);
+    const int32_t z0 = (int32_t)std::floor(minZ * m_invCell), z1 = (int32_t)std::floor(maxZ * m_invCell);
+    for (int32_t z = z0; z <= z1; ++z)
+      for (int32_t x = x0; x <= x1; ++x) fn(cellKey(x, 0, z));
+  }
+
+  float m_invCell;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+};
+
+// Grid cell size for `count` items spread over the bounds: about one item
+// per cell, never finer than 0.25 units.
+float cellSizeFor(const Vec3& min, const Vec3& max, size_t count) {
+  float extent = std::max(max.x - min.x, max.z - min.z);
+  return std::max(0.25f, extent / std::max(1.0f, std::sqrt((float)count)));
+}
+
+// Inserts the corners of other faces that lie on an edge of `face` seen
+// from above (within `tolerance`, strictly between its endpoints), in order
+// along the edge. A corner at the edge's height goes in as is; one up to
+// `climb` above or below adds a vertex on the edge under it, so the two
+// sides of a step get edges of matching extent.
+void insertTJunctions(std::vector<std::vector<uint32_t>>& faces, Welder& welder, float tolerance, float climb) {
+  const uint32_t count = (uint32_t)welder.vertices.size();
+  Vec3 min = welder.vertices[0], max = min;
+  for (uint32_t i = 0; i < count; ++i) {
+    const Vec3& p = welder.vertices[i];
+    min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+    max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+  }
+  FlatGrid grid(cellSizeFor(min, max, count));
+  for (uint32_t i = 0; i < count; ++i) {
+    const Vec3& p = welder.vertices[i];
+    grid.insert(i, p.x, p.z, p.x, p.z);
+  }
+
+  std::vector<uint32_t> candidates;
+  std::vector<std::pair<float, uint32_t>> onEdge;
+  for (std::vector<uint32_t>& face : faces) {
+    std::vector<uint32_t> out;
+    const uint32_t n = (uint32_t)face.size();
+    for (uint32_t e = 0; e < n; ++e) {
+      const uint32_t a = face[e], b = face[(e + 1) % n];
+      out.push_back(a);
+      const Vec3 pa = welder.vertices[a], pb = welder.vertices[b];
+      const float dx = pb.x - pa.x, dz = pb.z - pa.z;
+      const float len2 = dx * dx + dz * dz;
+      if (len2 <= tolerance * tolerance) continue;
+
+      candidates.clear();
+      grid.query(std::min(pa.x, pb.x) - tolerance, std::min(pa.z, pb.z) - tolerance,
+                 std::max(pa.x, pb.x) + tolerance, std::max(pa.z, pb.z) + tolerance, candidates);
+      std::sort(candidates.begin(), candidates.end());
+      candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+      onEdge.clear();
+      const float margin = tolerance / std::sqrt(len2);
+      for (uint32_t c : candidates) {
+        if (c == a || c == b) continue;
+        const Vec3 pc = welder.vertices[c];
+        const float t = ((pc.x - pa.x) * dx + (pc.z - pa.z) * dz) / len2;
+        if (t <= margin || t >= 1.0f - margin) continue;
+        const Vec3 q = pa + (pb - pa) * t;
+        if ((pc.x - q.x) * (pc.x - q.x) + (pc.z - q.z) * (pc.z - q.z) > tolerance * tolerance) continue;
+        const float dy = std::fabs(pc.y - q.y);
+        if (dy <= tolerance) onEdge.push_back({ t, c });
+        else if (dy <= climb) onEdge.push_back({ t, welder.add(q) });
+      }
+      std::sort(onEdge.begin(), onEdge.end());
+      for (size_t k = 0; k < onEdge.size(); ++k) {
+        if (onEdge[k].second != out.back()) out.push_back(onEdge[k].second);
+      }
+      if (out.size() > 1 && out.back() == b) out.pop_back();
+    }
+    while (out.size() > 1 && out.back() == out.front()) out.pop_back();
+    face.swap(out);
+  }
+}
+
+struct BoundaryEdge {
+  uint32_t poly = 0, edge = 0;
+  Vec3 a, b;
+};
+
+} // namespace
+
+bool buildNavMesh(const lightmap::Scene& scene, const lightmap::Bvh& bvh, const NavSettings& settings,
+                  NavData& out, std::string& error) {
+  out = NavData{};
+  const float cosSlope = std::cos(settings.maxSlopeDeg * kDegToRad);
+
+  // ---- walkable faces, welded ----
+  Welder welder(settings.weldTolerance);
+  std::vector<std::vector<uint32_t>> faces;
+  uint32_t steep = 0, covered = 0;
+  for (const lightmap::Face& face : scene.faces) {
+    if (face.indexCount < 3) continue;
+    Vec3 normal{}, centroid{};
+    for (uint32_t i = 0; i < face.indexCount; ++i) {
+      const Vec3& p = scene.positions[scene.indices[face.firstIndex + i]];
+      const Vec3& q = scene.positions[scene.indices[face.firstIndex + (i + 1) % face.indexCount]];
+      normal = normal + cross(p, q);
+      centroid = centroid + p;
+    }
+    const float len = length(normal);
+    if (len <= 1e-12f) continue;
+    if (normal.y / len < cosSlope) {
+      ++steep;
+      continue;
+    }
+    centroid = centroid * (1.0f / (float)face.indexCount);
+    if (bvh.occluded(centroid + Vec3{ 0.0f, 0.05f, 0.0f }, Vec3{ 0.0f, 1.0f, 0.0f }, settings.agentHeight)) {
+      ++covered;
+      continue;
+    }
+
+    std::vector<uint32_t> loop;
+    for (uint32_t i = 0; i < face.indexCount; ++i) {
+      uint32_t v = welder.add(scene.positions[scene.indices[face.firstIndex + i]]);
+      if (loop.empty() || loop.back() != v) loop.push_back(v);
+    }
+    while (loop.size() > 1 && loop.back() == loop.front()) loop.pop_back();
+    if (loop.size() >= 3) faces.push_back(std::move(loop));
+  }
+  if (faces.empty()) {
+    error = "no walkable faces";
+    return false;
+  }
+  // Steps first (adds vertices), then plain T-junctions including those.
+  insertTJunctions(faces, welder, settings.weldTolerance * 2.0f, settings.maxClimb);
+  insertTJunctions(faces, welder, settings.weldTolerance * 2.0f, 0.0f);
+  const std::vector<Vec3>& verts = welder.vertices;
+
+  // ---- convex polygons of at most kMaxPolyVerts ----
+  std::vector<NavPoly> polys;
+  auto emit = [&](const uint32_t* idx, uint32_t count) {
+    float area = 0.0f;
+    for (uint32_t i = 1; i + 1 < count; ++i) area += area2(verts[idx[0]], verts[idx[i]], verts[idx[i + 1]]);
+    if (area <= 1e-6f) return;
+    NavPoly p;
+    p.vertCount = count;
+    Vec3 c{};
+    for (uint32_t i = 0; i < count; ++i) {
+      p.verts[i] = idx[i];
+      c = c + verts[idx[i]];
+    }
+    c = c * (1.0f / (float)count);
+    p.center[0] = c.x;
+    p.center[1] = c.y;
+    p.center[2] = c.z;
+    polys.push_back(p);
+  };
+  for (std::vector<uint32_t>& face : faces) {
+    const uint32_t n = (uint32_t)face.size();
+    if (n <= kMaxPolyVerts) {
+      emit(face.data(), n);
+      continue;
+    }
+    // Fan from the sharpest corner so no piece is a sliver of collinear
+    // points inserted along one edge.
+    uint32_t apex = 0;
+    float best = -1.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+      float a = area2(verts[face[(i + n - 1) % n]], verts[face[i]], verts[face[(i + 1) % n]]);
+      if (a > best) {
+        best = a;
+        apex = i;
+      }
+    }
+    std::rotate(face.begin(), face.begin() + apex, face.end());
+    uint32_t piece[kMaxPolyVerts];
+    for (uint32_t i = 1; i < n - 1;) {
+      uint32_t end = std::min(i + kMaxPolyVerts - 2, n - 1);
+      uint32_t count = 0;
+      piece[count++] = face[0];
+      for (uint32_t k = i; k <= end; ++k) piece[count++] = face[k];
+      emit(piece, count);
+      i = end;
+    }
+  }
+
+  // ---- shared edges ----
+  std::unordered_map<uint64_t, uint64_t> edges; // directed (a, b) -> (poly, edge)
+  for (uint32_t p = 0; p < (uint32_t)polys.size(); ++p) {
+    const NavPoly& poly = polys[p];
+    for (uint32_t e = 0; e < poly.vertCount; ++e) {
+      uint64_t key = ((uint64_t)poly.verts[e] << 32) | poly.verts[(e + 1) % poly.vertCount];
+      edges.emplace(key, ((uint64_t)p << 32) | e);
+    }
+  }
+  for (uint32_t p = 0; p < (uint32_t)polys.size(); ++p) {
+    NavPoly& poly = polys[p];
+    for (uint32_t e = 0; e < poly.vertCount; ++e) {
+      if (poly.neighbors[e] != kNoNeighbor) continue;
+      uint64_t reverse = ((uint64_t)poly.verts[(e + 1) % poly.vertCount] << 32) | poly.verts[e];
+      auto it = edges.find(reverse);
+      if (it == edges.end()) continue;
+      const uint32_t q = (uint32_t)(it->second >> 32), qe = (uint32_t)it->second;
+      if (q == p || polys[q].neighbors[qe] != kNoNeighbor) continue;
+      poly.neighbors[e] = q;
+      polys[q].neighbors[qe] = p;
+    }
+  }
+
+  // ---- steps: open edges on one line seen from above ----
+  std::vector<BoundaryEdge> open;
+  Vec3 min = verts[polys[0].verts[0]], max = min;
+  for (uint32_t p = 0; p < (uint32_t)polys.size(); ++p) {
+    const NavPoly& poly = polys[p];
+    for (uint32_t e = 0; e < poly.vertCount; ++e) {
+      const Vec3& a = verts[poly.verts[e]];
+      min = { std::min(min.x, a.x), std::min(min.y, a.y), std::min(min.z, a.z) };
+      max = { std::max(max.x, a.x), std::max(max.y, a.y), std::max(max.z, a.z) };
+      if (poly.neighbors[e] == kNoNeighbor) open.push_back({ p, e, a, verts[poly.verts[(e + 1) % poly.vertCount]] });
+    }
+  }
+  const float lineTolerance = std::max(0.01f, settings.weldTolerance * 4.0f);
+  const float minOverlap = 0.05f;
+  FlatGrid edgeGrid(cellSizeFor(min, max, open.size()));
+  for (uint32_t i = 0; i < (uint32_t)open.size(); ++i) {
+    const BoundaryEdge& e = open[i];
+    edgeGrid.insert(i, std::min(e.a.x, e.b.x), std::min(e.a.z, e.b.z), std::max(e.a.x, e.b.x),
+                    std::max(e.a.z, e.b.z));
+  }
+  struct Candidate {
+    float overlap;
+    uint32_t i, j;
+  };
+  std::vector<Candidate> steps;
+  std::vector<uint32_t> near;
+  for (uint32_t i = 0; i < (uint32_t)open.size(); ++i) {
+    const BoundaryEdge& ei = open[i];
+    const float dx = ei.b.x - ei.a.x, dz = ei.b.z - ei.a.z;
+    const float len = std::sqrt(dx * dx + dz * dz);
+    if (len < minOverlap) continue;
+    const float ux = dx / len, uz = dz / len;
+
+    near.clear();
+    edgeGrid.query(std::min(ei.a.x, ei.b.x), std::min(ei.a.z, ei.b.z), std::max(ei.a.x, ei.b.x),
+                   std::max(ei.a.z, ei.b.z), near);
+    std::sort(near.begin(), near.end());
+    near.erase(std::unique(near.begin(), near.end()), near.end());
+    for (uint32_t j : near) {
+      const BoundaryEdge& ej = open[j];
+      if (j <= i || ej.poly == ei.poly) continue;
+      // Opposite direction, both endpoints on ei's line.
+      if ((ej.b.x - ej.a.x) * ux + (ej.b.z - ej.a.z) * uz >= 0.0f) continue;
+      const float ca = (ej.a.x - ei.a.x) * uz - (ej.a.z - ei.a.z) * ux;
+      const float cb = (ej.b.x - ei.a.x) * uz - (ej.b.z - ei.a.z) * ux;
+      if (std::fabs(ca) > lineTolerance || std::fabs(cb) > lineTolerance) continue;
+      const float ta = (ej.a.x - ei.a.x) * ux + (ej.a.z - ei.a.z) * uz;
+      const float tb = (ej.b.x - ei.a.x) * ux + (ej.b.z - ei.a.z) * uz;
+      const float lo = std::max(0.0f, std::min(ta, tb)), hi = std::min(len, std::max(ta, tb));
+      if (hi - lo < minOverlap) continue;
+      // Height difference in the middle of the overlap.
+      const float mid = 0.5f * (lo + hi);
+      const float yi = ei.a.y + (ei.b.y - ei.a.y) * (mid / len);
+      const float yj = ej.a.y + (ej.b.y - ej.a.y) * ((mid - ta) / (tb - ta));
+      if (std::fabs(yi - yj) > settings.maxClimb) continue;
+      steps.push_back({ hi - lo, i, j });
+    }
+  }
+  std::sort(steps.begin(), steps.end(), [](const Candidate& a, const Candidate& b) { return a.overlap > b.overlap; });
+  uint32_t stepLinks = 0;
+  for (const Candidate& c : steps) {
+    const BoundaryEdge& a = open[c.i];
+    const BoundaryEdge& b = open[c.j];
+    if (polys[a.poly].neighbors[a.edge] != kNoNeighbor || polys[b.poly].neighbors[b.edge] != kNoNeighbor) continue;
+    polys[a.poly].neighbors[a.edge] = b.poly;
+    polys[b.poly].neighbors[b.edge] = a.poly;
+    ++stepLinks;
+  }
+
+  // ---- clusters: breadth-first growth, then renumber ----
+  const uint32_t polyCount = (uint32_t)polys.size();
+  std::vector<uint32_t> cluster(polyCount, UINT32_MAX);
+  std::vector<uint32_t> order; // new index -> old index
+  order.reserve(polyCount);
+  uint32_t clusterCount = 0;
+  for (uint32_t seed = 0; seed < polyCount; ++seed) {
+    if (cluster[seed] != UINT32_MAX) continue;
+    const size_t first = order.size();
+    cluster[seed] = clusterCount;
+    order.push_back(seed);
+    for (size_t head = first; head < order.size() && order.size() - first < settings.clusterSize; ++head) {
+      const NavPoly& poly = polys[order[head]];
+      for (uint32_t e = 0; e < poly.vertCount && order.size() - first < settings.clusterSize; ++e) {
+        const uint32_t n = poly.neighbors[e];
+        if (n == kNoNeighbor || cluster[n] != UINT32_MAX) continue;
+        cluster[n] = clusterCount;
+        order.push_back(n);
+      }
+    }
+    ++clusterCount;
+  }
+  std::vector<uint32_t> remap(polyCount);
+  for (uint32_t i = 0; i < polyCount; ++i) remap[order[i]] = i;
+
+  out.polys.resize(polyCount);
+  for (uint32_t i = 0; i < polyCount; ++i) {
+    NavPoly p = polys[order[i]];
+    for (uint32_t e = 0; e < p.vertCount; ++e)
+      if (p.neighbors[e] != kNoNeighbor) p.neighbors[e] = remap[p.neighbors[e]];
+    p.cluster = cluster[order[i]];
+    out.polys[i] = p;
+  }
+
+  out.clusters.resize(clusterCount);
+  for (uint32_t i = 0; i < polyCount; ++i) {
+    NavCluster& c = out.clusters[out.polys[i].cluster];
+    if (c.polyCount == 0) c.firstPoly = i;
+    ++c.polyCount;
+    for (int k = 0; k < 3; ++k) c.center[k] += out.polys[i].center[k];
+  }
+  for (NavCluster& c : out.clusters)
+    for (int k = 0; k < 3; ++k) c.center[k] /= (float)c.polyCount;
+
+  std::vector<uint32_t> targets;
+  for (uint32_t ci = 0; ci < clusterCount; ++ci) {
+    NavCluster& c = out.clusters[ci];
+    targets.clear();
+    for (uint32_t i = c.firstPoly; i < c.firstPoly + c.polyCount; ++i) {
+      const NavPoly& p = out.polys[i];
+      for (uint32_t e = 0; e < p.vertCount; ++e) {
+        if (p.neighbors[e] != kNoNeighbor && out.polys[p.neighbors[e]].cluster != ci)
+          targets.push_back(out.polys[p.neighbors[e]].cluster);
+      }
+    }
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    c.firstLink = (uint32_t)out.links.size();
+    c.linkCount = (uint32_t)targets.size();
+    for (uint32_t t : targets) {
+      const NavCluster& o = out.clusters[t];
+      Vec3 d{ o.center[0] - c.center[0], o.center[1] - c.center[1], o.center[2] - c.center[2] };
+      out.links.push_back({ t, length(d) });
+    }
+  }
+
+  // Connected components of the cluster graph.
+  std::vector<uint32_t> stack;
+  uint32_t components = 0;
+  for (NavCluster& c : out.clusters) c.component = UINT32_MAX;
+  for (uint32_t seed = 0; seed < clusterCount; ++seed) {
+    if (out.clusters[seed].component != UINT32_MAX) continue;
+    out.clusters[seed].component = components;
+    stack.assign(1, seed);
+    while (!stack.empty()) {
+      const NavCluster& c = out.clusters[stack.back()];
+      stack.pop_back();
+      for (uint32_t l = c.firstLink; l < c.firstLink + c.linkCount; ++l) {
+        NavCluster& n = out.clusters[out.links[l].cluster];
+        if (n.component != UINT32_MAX) continue;
+        n.component = components;
+        stack.push_back(out.links[l].cluster);
+      }
+    }
+    ++components;
+  }
+
+  // ---- vertices actually used, compacted ----
+  std::vector<uint32_t> vertexRemap(verts.size(), UINT32_MAX);
+  for (NavPoly& p : out.polys) {
+    for (uint32_t e = 0; e < p.vertCount; ++e) {
+      uint32_t& v = p.verts[e];
+      if (vertexRemap[v] == UINT32_MAX) {
+        vertexRemap[v] = (uint32_t)(out.vertices.size() / 3);
+        out.vertices.insert(out.vertices.end(), { verts[v].x, verts[v].y, verts[v].z });
+      }
+      v = vertexRemap[v];
+    }
+  }
+
+  NavHeader& h = out.header;
+  h.version = kNavVersion;
+  h.vertexCount = (uint32_t)(out.vertices.size() / 3);
+  h.polyCount = polyCount;
+  h.clusterCount = clusterCount;
+  h.linkCount = (uint32_t)out.links.size();
+  h.agentHeight = settings.agentHeight;
+  h.maxClimb = settings.maxClimb;
+  h.maxSlopeDeg = settings.maxSlopeDeg;
+  h.boundsMin[0] = min.x;
+  h.boundsMin[1] = min.y;
+  h.boundsMin[2] = min.z;
+  h.boundsMax[0] = max.x;
+  h.boundsMax[1] = max.y;
+  h.boundsMax[2] = max.z;
+
+  std::printf("[INFO] Walkable: %zu faces (%u too steep, %u without headroom) -> %u polygons, %u step links\n",
+              faces.size(), steep, covered, polyCount, stepLinks);
+  std::printf("[INFO] Clusters: %u, %u links, %u connected areas\n", clusterCount, h.linkCount, components);
+  return true;
+}
+
+bool writeNavMesh(const char* path, const NavData& data, std::string& error) {
+  std::FILE* f = std::fopen(path, "wb");
+  if (!f) {
+    error = std::string("cannot write ") + path;
+    return false;
+  }
+  bool ok = std::fwrite(&data.header, sizeof(data.header), 1, f) == 1;
+  ok = ok && (data.vertices.empty() ||
+              std::fwrite(data.vertices.data(), sizeof(float), data.vertices.size(), f) == data.vertices.size());
+  ok = ok && (data.polys.empty() ||
+              std::fwrite(data.polys.data(), sizeof(NavPoly), data.polys.size(), f) == data.polys.size());
+  ok = ok && (data.clusters.empty() ||
+              std::fwrite(data.clusters.data(), sizeof(NavCluster), data.clusters.size(), f) == data.clusters.size());
+  ok = ok && (data.links.empty() ||
+              std::fwrite(data.links.data(), sizeof(NavClusterLink), data.links.size(), f) == data.links.size());
+  ok = std::fclose(f) == 0 && ok;
+  if (!ok) error = std::string("short write to ") + path;
+  return ok;
+}
+
+} // namespace nav
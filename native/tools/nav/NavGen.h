@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../lightmap/Bvh.h"
+#include "../lightmap/Scene.h"
+#include "nav/NavFormat.h"
+
+namespace nav {
+
+struct NavSettings {
+  float maxSlopeDeg = 45.0f;  // steeper faces are walls
+  float maxClimb = 0.45f;     // step height linked across boundary edges
+  float agentHeight = 1.8f;   // faces with less headroom are dropped
+  float weldTolerance = 0.001f;
+  uint32_t clusterSize = 32;  // target polygons per cluster
+};
+
+/// Everything NavFormat.h stores, in file order.
+struct NavData {
+  NavHeader header;
+  std::vector<float> vertices; // xyz
+  std::vector<NavPoly> polys;
+  std::vector<NavCluster> clusters;
+  std::vector<NavClusterLink> links;
+};
+
+/// Builds the navmesh from the map's walkable faces:
+///
+///   walkable   faces facing up within maxSlopeDeg whose centre has
+///              agentHeight of free space above it (ray against `bvh`)
+///   weld       corners closer than weldTolerance become one vertex, and
+///              corners lying on another face's edge are inserted into it,
+///              so the T-junctions a BSP split leaves still share edges;
+///              edges below or above a corner within maxClimb are split
+///              under it, so steps line up edge for edge
+///   polygons   faces with more than kMaxPolyVerts corners are fanned into
+///              convex pieces
+///   link       shared edges, then boundary edges on the same line (seen
+///              from above) within maxClimb of each other (steps)
+///   cluster    breadth-first growth to ~clusterSize connected polygons,
+///              polygons renumbered cluster by cluster
+///
+/// False with a message in `error` if nothing is walkable.
+bool buildNavMesh(const lightmap::Scene& scene, const lightmap::Bvh& bvh, const NavSettings& settings,
+                  NavData& out, std::string& error);
+
+bool writeNavMesh(const char* path, const NavData& data, std::string& error);
+
+} // namespace nav
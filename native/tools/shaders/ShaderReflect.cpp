@@ -0,0 +1,207 @@
+// Writes a shader's resource layout as a C++ header.
+//
+//   ShaderReflect in.spv out.h [--path shaders/in.spv]
+//
+//   --path <p>   runtime path the engine loads the module from
+//                (default shaders/<file name of in.spv>)
+//
+// The header defines shaders::k<Name> (render/ShaderReflection.h), e.g.
+// world.frag.spv -> shaders::kWorldFrag, which the renderer builds its
+// descriptor set and pipeline layouts and specialization data from.
+
+#include "SpirvReflect.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+  std::string in, out, path;
+};
+
+void usage() {
+  std::printf("usage: ShaderReflect in.spv out.h [--path shaders/in.spv]\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (a[0] != '-') {
+      if (o.in.empty()) o.in = a;
+      else if (o.out.empty()) o.out = a;
+      else return false;
+      continue;
+    }
+    if (i + 1 >= argc) return false;
+    const char* v = argv[++i];
+
+    if (std::strcmp(a, "--path") == 0) o.path = v;
+    else return false;
+  }
+  return !o.in.empty() && !o.out.empty();
+}
+
+bool readWords(const std::string& path, std::vector<uint32_t>& words) {
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return false;
+  std::fseek(f, 0, SEEK_END);
+  long size = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  if (size <= 0 || size % 4 != 0) {
+    std::fclose(f);
+    return false;
+  }
+  words.resize((size_t)size / 4);
+  bool ok = std::fread(words.data(), 4, words.size(), f) == words.size();
+  std::fclose(f);
+  return ok;
+}
+
+std::string fileName(const std::string& path) {
+  size_t slash = path.find_last_of("\\/");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// "world_color.vert.spv" -> "WorldColorVert"
+std::string identifier(const std::string& file) {
+  std::string base = file;
+  if (base.size() > 4 && base.compare(base.size() - 4, 4, ".spv") == 0) base.resize(base.size() - 4);
+  std::string id;
+  bool upper = true;
+  for (char c : base) {
+    if (!std::isalnum((unsigned char)c)) {
+      upper = true;
+      continue;
+    }
+    id += upper ? (char)std::toupper((unsigned char)c) : c;
+    upper = false;
+  }
+  if (id.empty() || std::isdigit((unsigned char)id[0])) id.insert(0, "Shader");
+  return id;
+}
+
+const char* stageName(spirv::Stage s) {
+  switch (s) {
+    case spirv::Stage::Vertex: return "VK_SHADER_STAGE_VERTEX_BIT";
+    case spirv::Stage::TessControl: return "VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT";
+    case spirv::Stage::TessEvaluation: return "VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT";
+    case spirv::Stage::Geometry: return "VK_SHADER_STAGE_GEOMETRY_BIT";
+    case spirv::Stage::Fragment: return "VK_SHADER_STAGE_FRAGMENT_BIT";
+    case spirv::Stage::Compute: return "VK_SHADER_STAGE_COMPUTE_BIT";
+  }
+  return "VK_SHADER_STAGE_ALL";
+}
+
+const char* descriptorName(spirv::DescriptorKind k) {
+  switch (k) {
+    case spirv::DescriptorKind::Sampler: return "VK_DESCRIPTOR_TYPE_SAMPLER";
+    case spirv::DescriptorKind::CombinedImageSampler: return "VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER";
+    case spirv::DescriptorKind::SampledImage: return "VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE";
+    case spirv::DescriptorKind::StorageImage: return "VK_DESCRIPTOR_TYPE_STORAGE_IMAGE";
+    case spirv::DescriptorKind::UniformTexelBuffer: return "VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER";
+    case spirv::DescriptorKind::StorageTexelBuffer: return "VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER";
+    case spirv::DescriptorKind::UniformBuffer: return "VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER";
+    case spirv::DescriptorKind::StorageBuffer: return "VK_DESCRIPTOR_TYPE_STORAGE_BUFFER";
+    case spirv::DescriptorKind::InputAttachment: return "VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT";
+  }
+  return "VK_DESCRIPTOR_TYPE_MAX_ENUM";
+}
+
+const char* specTypeName(spirv::SpecConstant::Type t) {
+  switch (t) {
+    case spirv::SpecConstant::Type::Bool: return "bool";
+    case spirv::SpecConstant::Type::Int: return "int";
+    case spirv::SpecConstant::Type::UInt: return "uint";
+    case spirv::SpecConstant::Type::Float: return "float";
+  }
+  return "?";
+}
+
+std::string writeHeader(const spirv::Reflection& r, const std::string& source, const std::string& path,
+                        const std::string& id) {
+  std::string s;
+  char line[512];
+  auto add = [&](const char* fmt, auto... args) {
+    std::snprintf(line, sizeof(line), fmt, args...);
+    s += line;
+  };
+
+  add("// Generated by ShaderReflect from %s; do not edit.\n", source.c_str());
+  s += "#pragma once\n#include \"render/ShaderReflection.h\"\n\nnamespace shaders {\n\n";
+
+  const char* bindings = "nullptr";
+  std::string bindingsName = "k" + id + "Bindings";
+  if (!r.bindings.empty()) {
+    add("inline constexpr render::ReflectedBinding %s[] = {\n", bindingsName.c_str());
+    for (const spirv::Binding& b : r.bindings) {
+      add("  { %u, %u, %s, %u }, // %s\n", b.set, b.binding, descriptorName(b.kind), b.count,
+          b.name.empty() ? "?" : b.name.c_str());
+    }
+    s += "};\n\n";
+    bindings = bindingsName.c_str();
+  }
+
+  const char* specs = "nullptr";
+  std::string specsName = "k" + id + "SpecConstants";
+  if (!r.specConstants.empty()) {
+    add("inline constexpr render::ReflectedSpecConstant %s[] = {\n", specsName.c_str());
+    for (const spirv::SpecConstant& sc : r.specConstants) {
+      add("  { %u, \"%s\" }, // %s, default 0x%x\n", sc.id, sc.name.c_str(), specTypeName(sc.type), sc.defaultBits);
+    }
+    s += "};\n\n";
+    specs = specsName.c_str();
+  }
+
+  add("inline constexpr render::ShaderReflection k%s = {\n", id.c_str());
+  add("  \"%s\", %s,\n", path.c_str(), stageName(r.stage));
+  add("  %s, %u,\n", bindings, (unsigned)r.bindings.size());
+  add("  %u, // push constant bytes\n", r.pushConstantSize);
+  add("  %s, %u,\n", specs, (unsigned)r.specConstants.size());
+  s += "};\n\n} // namespace shaders\n";
+  return s;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parseArgs(argc, argv, o)) {
+    usage();
+    return 2;
+  }
+  const std::string file = fileName(o.in);
+  if (o.path.empty()) o.path = "shaders/" + file;
+
+  std::vector<uint32_t> words;
+  if (!readWords(o.in, words)) {
+    std::printf("[ERR ] Could not read %s\n", o.in.c_str());
+    return 1;
+  }
+  spirv::Reflection r;
+  std::string error;
+  if (!spirv::reflect(words.data(), words.size(), r, error)) {
+    std::printf("[ERR ] %s: %s\n", o.in.c_str(), error.c_str());
+    return 1;
+  }
+  for (const spirv::SpecConstant& sc : r.specConstants) {
+    // The engine finds feature toggles by name; an unnamed one can't be set.
+    if (sc.name.empty()) {
+      std::printf("[ERR ] %s: specialization constant %u has no name (debug info stripped?)\n", o.in.c_str(), sc.id);
+      return 1;
+    }
+  }
+
+  std::string header = writeHeader(r, file, o.path, identifier(file));
+  std::FILE* f = std::fopen(o.out.c_str(), "wb");
+  if (!f) {
+    std::printf("[ERR ] Could not open %s for writing\n", o.out.c_str());
+    return 1;
+  }
+  std::fwrite(header.data(), 1, header.size(), f);
+  std::fclose(f);
+  return 0;
+}
@@ -0,0 +1,348 @@
+#include "SpirvReflect.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace spirv {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x07230203;
+
+// Opcodes
+constexpr uint32_t OpName = 5;
+constexpr uint32_t OpEntryPoint = 15;
+constexpr uint32_t OpExecutionMode = 16;
+constexpr uint32_t OpTypeBool = 20;
+constexpr uint32_t OpTypeInt = 21;
+constexpr uint32_t OpTypeFloat = 22;
+constexpr uint32_t OpTypeVector = 23;
+constexpr uint32_t OpTypeMatrix = 24;
+constexpr uint32_t OpTypeImage = 25;
+constexpr uint32_t OpTypeSampler = 26;
+constexpr uint32_t OpTypeSampledImage = 27;
+constexpr uint32_t OpTypeArray = 28;
+constexpr uint32_t OpTypeRuntimeArray = 29;
+constexpr uint32_t OpTypeStruct = 30;
+constexpr uint32_t OpTypePointer = 32;
+constexpr uint32_t OpConstant = 43;
+constexpr uint32_t OpSpecConstantTrue = 48;
+constexpr uint32_t OpSpecConstantFalse = 49;
+constexpr uint32_t OpSpecConstant = 50;
+constexpr uint32_t OpVariable = 59;
+constexpr uint32_t OpDecorate = 71;
+constexpr uint32_t OpMemberDecorate = 72;
+
+// Decorations
+constexpr uint32_t DecSpecId = 1;
+constexpr uint32_t DecBufferBlock = 3;
+constexpr uint32_t DecArrayStride = 6;
+constexpr uint32_t DecMatrixStride = 7;
+constexpr uint32_t DecBinding = 33;
+constexpr uint32_t DecDescriptorSet = 34;
+constexpr uint32_t DecOffset = 35;
+
+// Storage classes
+constexpr uint32_t ScUniformConstant = 0;
+constexpr uint32_t ScUniform = 2;
+constexpr uint32_t ScPushConstant = 9;
+constexpr uint32_t ScStorageBuffer = 12;
+
+constexpr uint32_t DimBuffer = 5;
+constexpr uint32_t DimSubpassData = 6;
+constexpr uint32_t ModeLocalSize = 17;
+
+struct Type {
+  uint32_t op = 0;
+  uint32_t words[8] = {}; // operands after the result id
+  std::vector<uint32_t> members; // OpTypeStruct
+};
+
+struct Member {
+  uint32_t offset = 0;
+  uint32_t matrixStride = 0;
+};
+
+struct Decorations {
+  uint32_t set = UINT32_MAX;
+  uint32_t binding = UINT32_MAX;
+  uint32_t specId = UINT32_MAX;
+  uint32_t arrayStride = 0;
+  bool bufferBlock = false;
+  std::vector<Member> members;
+};
+
+struct Variable {
+  uint32_t id;
+  uint32_t pointerType;
+  uint32_t storage;
+};
+
+struct Module {
+  std::unordered_map<uint32_t, std::string> names;
+  std::unordered_map<uint32_t, Type> types;
+  std::unordered_map<uint32_t, Decorations> decorations;
+  std::unordered_map<uint32_t, uint32_t> constants; // first value word
+  std::vector<Variable> variables;
+  std::vector<std::pair<uint32_t, SpecConstant>> specs; // result id, constant
+
+  const Type* type(uint32_t id) const {
+    auto it = types.find(id);
+    return it != types.end() ? &it->second : nullptr;
+  }
+  const Decorations* decor(uint32_t id) const {
+    auto it = decorations.find(id);
+    return it != decorations.end() ? &it->second : nullptr;
+  }
+  std::string name(uint32_t id) const {
+    auto it = names.find(id);
+    return it != names.end() ? it->second : std::string();
+  }
+};
+
+std::string literalString(const uint32_t* words, uint32_t count) {
+  std::string s;
+  for (uint32_t i = 0; i < count; ++i) {
+    for (int b = 0; b < 4; ++b) {
+      char c = (char)((words[i] >> (8 * b)) & 0xFF);
+      if (c == '\0') return s;
+      s += c;
+    }
+  }
+  return s;
+}
+
+// Byte size of a type as laid out by its Offset/ArrayStride/MatrixStride
+// decorations (push constants are always explicitly laid out).
+uint32_t typeSize(const Module& m, uint32_t id, uint32_t matrixStride, int depth = 0) {
+  const Type* t = m.type(id);
+  if (!t || depth > 32) return 0;
+  switch (t->op) {
+    case OpTypeBool: return 4;
+    case OpTypeInt:
+    case OpTypeFloat: return t->words[0] / 8;
+    case OpTypeVector: return t->words[1] * typeSize(m, t->words[0], 0, depth + 1);
+    case OpTypeMatrix: {
+      uint32_t column = matrixStride ? matrixStride : typeSize(m, t->words[0], 0, depth + 1);
+      return t->words[1] * column;
+    }
+    case OpTypeArray: {
+      auto len = m.constants.find(t->words[1]);
+      uint32_t count = len != m.constants.end() ? len->second : 0;
+      const Decorations* d = m.decor(id);
+      uint32_t stride = d && d->arrayStride ? d->arrayStride : typeSize(m, t->words[0], matrixStride, depth + 1);
+      return count * stride;
+    }
+    case OpTypeStruct: {
+      const Decorations* d = m.decor(id);
+      uint32_t size = 0;
+      for (size_t i = 0; i < t->members.size(); ++i) {
+        Member mem = d && i < d->members.size() ? d->members[i] : Member{};
+        size = std::max(size, mem.offset + typeSize(m, t->members[i], mem.matrixStride, depth + 1));
+      }
+      return size;
+    }
+    default: return 0; // runtime arrays and opaque types take no fixed space
+  }
+}
+
+bool descriptorKind(const Module& m, uint32_t typeId, uint32_t storage, DescriptorKind& kind) {
+  const Type* t = m.type(typeId);
+  if (!t) return false;
+  if (storage == ScStorageBuffer) {
+    kind = DescriptorKind::StorageBuffer;
+    return true;
+  }
+  if (storage == ScUniform) {
+    const Decorations* d = m.decor(typeId);
+    kind = d && d->bufferBlock ? DescriptorKind::StorageBuffer : DescriptorKind::UniformBuffer;
+    return true;
+  }
+  switch (t->op) {
+    case OpTypeSampler: kind = DescriptorKind::Sampler; return true;
+    case OpTypeSampledImage: kind = DescriptorKind::CombinedImageSampler; return true;
+    case OpTypeImage: {
+      uint32_t dim = t->words[1], sampled = t->words[5];
+      if (dim == DimSubpassData) kind = DescriptorKind::InputAttachment;
+      else if (dim == DimBuffer) kind = sampled == 2 ? DescriptorKind::StorageTexelBuffer : DescriptorKind::UniformTexelBuffer;
+      else kind = sampled == 2 ? DescriptorKind::StorageImage : DescriptorKind::SampledImage;
+      return true;
+    }
+    default: return false; // acceleration structures etc.
+  }
+}
+
+} // namespace
+
+bool reflect(const uint32_t* words, size_t wordCount, Reflection& out, std::string& error) {
+  out = Reflection{};
+  if (wordCount < 5 || words[0] != kMagic) {
+    error = "not a SPIR-V module";
+    return false;
+  }
+
+  Module m;
+  bool haveEntry = false;
+  uint32_t entryId = 0;
+
+  for (size_t pos = 5; pos < wordCount;) {
+    uint32_t count = words[pos] >> 16, op = words[pos] & 0xFFFF;
+    if (count == 0 || pos + count > wordCount) {
+      error = "truncated instruction at word " + std::to_string(pos);
+      return false;
+    }
+    const uint32_t* w = words + pos + 1; // operands
+    uint32_t n = count - 1;
+
+    switch (op) {
+      case OpName:
+        if (n >= 2) m.names[w[0]] = literalString(w + 1, n - 1);
+        break;
+      case OpEntryPoint:
+        if (!haveEntry && n >= 2) {
+          static const Stage kStages[] = { Stage::Vertex, Stage::TessControl, Stage::TessEvaluation,
+                                           Stage::Geometry, Stage::Fragment, Stage::Compute };
+          if (w[0] > 5) {
+            error = "unsupported execution model " + std::to_string(w[0]);
+            return false;
+          }
+          out.stage = kStages[w[0]];
+          entryId = w[1];
+          haveEntry = true;
+        }
+        break;
+      case OpExecutionMode:
+        if (n >= 5 && w[0] == entryId && w[1] == ModeLocalSize) {
+          out.localSize[0] = w[2];
+          out.localSize[1] = w[3];
+          out.localSize[2] = w[4];
+        }
+        break;
+      case OpTypeBool: case OpTypeInt: case OpTypeFloat: case OpTypeVector: case OpTypeMatrix:
+      case OpTypeImage: case OpTypeSampler: case OpTypeSampledImage: case OpTypeArray:
+      case OpTypeRuntimeArray: case OpTypePointer: {
+        if (n < 1) break;
+        Type& t = m.types[w[0]];
+        t.op = op;
+        for (uint32_t i = 1; i < n && i <= 8; ++i) t.words[i - 1] = w[i];
+        break;
+      }
+      case OpTypeStruct: {
+        if (n < 1) break;
+        Type& t = m.types[w[0]];
+        t.op = op;
+        t.members.assign(w + 1, w + n);
+        break;
+      }
+      case OpConstant:
+        if (n >= 3) m.constants[w[1]] = w[2];
+        break;
+      case OpSpecConstantTrue:
+      case OpSpecConstantFalse:
+      case OpSpecConstant: {
+        if (n < 2) break;
+        SpecConstant sc;
+        sc.type = SpecConstant::Type::Bool;
+        if (op == OpSpecConstant) {
+          const Type* t = m.type(w[0]);
+          if (t && t->op == OpTypeFloat) sc.type = SpecConstant::Type::Float;
+          else if (t && t->op == OpTypeInt) sc.type = t->words[1] ? SpecConstant::Type::Int : SpecConstant::Type::UInt;
+          sc.defaultBits = n >= 3 ? w[2] : 0;
+          m.constants[w[1]] = sc.defaultBits; // array lengths may use it
+        } else {
+          sc.defaultBits = op == OpSpecConstantTrue ? 1u : 0u;
+        }
+        m.specs.emplace_back(w[1], sc);
+        break;
+      }
+      case OpVariable:
+        if (n >= 3) m.variables.push_back(Variable{ w[1], w[0], w[2] });
+        break;
+      case OpDecorate: {
+        if (n < 2) break;
+        Decorations& d = m.decorations[w[0]];
+        uint32_t value = n >= 3 ? w[2] : 0;
+        switch (w[1]) {
+          case DecSpecId: d.specId = value; break;
+          case DecBufferBlock: d.bufferBlock = true; break;
+          case DecArrayStride: d.arrayStride = value; break;
+          case DecBinding: d.binding = value; break;
+          case DecDescriptorSet: d.set = value; break;
+          default: break;
+        }
+        break;
+      }
+      case OpMemberDecorate: {
+        if (n < 4) break;
+        Decorations& d = m.decorations[w[0]];
+        if (w[2] != DecOffset && w[2] != DecMatrixStride) break;
+        if (d.members.size() <= w[1]) d.members.resize(w[1] + 1);
+        if (w[2] == DecOffset) d.members[w[1]].offset = w[3];
+        else d.members[w[1]].matrixStride = w[3];
+        break;
+      }
+      default: break;
+    }
+    pos += count;
+  }
+
+  if (!haveEntry) {
+    error = "no entry point";
+    return false;
+  }
+
+  for (const Variable& v : m.variables) {
+    if (v.storage != ScUniformConstant && v.storage != ScUniform && v.storage != ScStorageBuffer &&
+        v.storage != ScPushConstant) {
+      continue;
+    }
+    const Type* ptr = m.type(v.pointerType);
+    if (!ptr || ptr->op != OpTypePointer) continue;
+    uint32_t typeId = ptr->words[1];
+
+    if (v.storage == ScPushConstant) {
+      out.pushConstantSize = std::max(out.pushConstantSize, typeSize(m, typeId, 0));
+      continue;
+    }
+
+    const Decorations* d = m.decor(v.id);
+    if (!d || d->set == UINT32_MAX || d->binding == UINT32_MAX) continue;
+
+    Binding b;
+    b.set = d->set;
+    b.binding = d->binding;
+    const Type* t = m.type(typeId);
+    if (t && t->op == OpTypeArray) {
+      auto len = m.constants.find(t->words[1]);
+      b.count = len != m.constants.end() ? len->second : 1;
+      typeId = t->words[0];
+    } else if (t && t->op == OpTypeRuntimeArray) {
+      b.count = 0;
+      typeId = t->words[0];
+    }
+    if (!descriptorKind(m, typeId, v.storage, b.kind)) continue;
+
+    // Blocks are more recognisable by their type name ("WorldParams") than
+    // by the usually empty instance name.
+    b.name = m.name(v.id);
+    if (b.name.empty()) b.name = m.name(typeId);
+    out.bindings.push_back(std::move(b));
+  }
+
+  for (auto& [id, sc] : m.specs) {
+    const Decorations* d = m.decor(id);
+    if (!d || d->specId == UINT32_MAX) continue; // derived from other spec constants
+    sc.id = d->specId;
+    sc.name = m.name(id);
+    out.specConstants.push_back(std::move(sc));
+  }
+
+  std::sort(out.bindings.begin(), out.bindings.end(), [](const Binding& a, const Binding& b) {
+    return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+  });
+  std::sort(out.specConstants.begin(), out.specConstants.end(),
+            [](const SpecConstant& a, const SpecConstant& b) { return a.id < b.id; });
+  return true;
+}
+
+} // namespace spirv
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace spirv {
+
+enum class Stage { Vertex, TessControl, TessEvaluation, Geometry, Fragment, Compute };
+
+enum class DescriptorKind {
+  Sampler,
+  CombinedImageSampler,
+  SampledImage,
+  StorageImage,
+  UniformTexelBuffer,
+  StorageTexelBuffer,
+  UniformBuffer,
+  StorageBuffer,
+  InputAttachment,
+};
+
+struct Binding {
+  uint32_t set = 0;
+  uint32_t binding = 0;
+  DescriptorKind kind = DescriptorKind::UniformBuffer;
+  uint32_t count = 1; // array size; 0 = runtime sized
+  std::string name;   // block or variable name, may be empty
+};
+
+struct SpecConstant {
+  enum class Type { Bool, Int, UInt, Float };
+  uint32_t id = 0;
+  Type type = Type::Bool;
+  uint32_t defaultBits = 0; // default value as 32 bits (bool: 0/1)
+  std::string name;         // empty if stripped
+};
+
+struct Reflection {
+  Stage stage = Stage::Vertex;
+  std::vector<Binding> bindings;          // sorted by set, binding
+  uint32_t pushConstantSize = 0;          // bytes, 0 = no block
+  std::vector<SpecConstant> specConstants; // sorted by id
+  uint32_t localSize[3] = { 0, 0, 0 };    // compute only, literal sizes
+};
+
+/// Reads the resource interface of the first entry point of a SPIR-V module:
+/// descriptor bindings of every resource variable in the module (dead ones
+/// only disappear if spirv-opt removed them), the push-constant block size
+/// and the specialization constants.
+bool reflect(const uint32_t* words, size_t wordCount, Reflection& out, std::string& error);
+
+} // namespace spirv
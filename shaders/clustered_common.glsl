@@ -0,0 +1,82 @@
+// Clustered forward+ data shared by light_cull.comp and every lit shader.
+// Layouts must match render/Lights.h, render/Decals.h and
+// render/ClusteredLighting.cpp.
+#ifndef CLUSTERED_COMMON_GLSL
+#define CLUSTERED_COMMON_GLSL
+
+#ifndef LIGHTING_SET
+#define LIGHTING_SET 0
+#endif
+
+// Only the culling pass writes cluster data; everyone else binds it
+// read-only (fragment stores need an extra device feature).
+#ifdef CLUSTER_CULL_PASS
+#define CLUSTER_RW
+#else
+#define CLUSTER_RW readonly
+#endif
+
+#define MAX_LIGHTS_PER_CLUSTER 64u
+#define MAX_DECALS_PER_CLUSTER 32u
+#define LIGHT_POINT 0u
+#define LIGHT_SPOT  1u
+#define NO_SHADOW   0xffffffffu
+
+struct Light {
+  vec3 position;  float radius;
+  vec3 color;     float intensity;
+  vec3 direction; float cosOuter;
+  float cosInner; uint type; uint shadow; float shadowImportance;
+};
+
+struct Decal {
+  mat4 worldToDecal; // into the unit box [-0.5, 0.5]^3, z = projection axis
+  vec4 atlasRect;    // uv offset, uv scale
+  vec4 color;        // tint rgb, opacity
+  vec4 sphere;       // world bounding sphere
+};
+
+layout(set = LIGHTING_SET, binding = 0) uniform ClusterParams {
+  mat4 view;
+  mat4 proj;
+  uvec4 grid;       // clusters x, y, z; live light count
+  vec4 tileSize;    // pixels per tile x, y; viewport width, height
+  vec4 depthSlice;  // near, far, slice scale, slice bias
+  uvec4 decalInfo;  // visible decal count, -, -, -
+} uCluster;
+
+layout(std430, set = LIGHTING_SET, binding = 1) readonly buffer LightBuffer {
+  Light lights[];
+};
+
+// View-space AABB per cluster: bounds[2i] = min, bounds[2i + 1] = max.
+layout(std430, set = LIGHTING_SET, binding = 2) readonly buffer ClusterBounds {
+  vec4 clusterBounds[];
+};
+
+// Per cluster: light offset into lightIndices, light count, decal offset,
+// decal count. Decal indices follow the cluster's light indices.
+layout(std430, set = LIGHTING_SET, binding = 3) CLUSTER_RW buffer ClusterGrid {
+  uvec4 clusterRanges[];
+};
+
+layout(std430, set = LIGHTING_SET, binding = 4) CLUSTER_RW buffer LightIndexList {
+  uint lightIndices[];
+};
+
+layout(std430, set = LIGHTING_SET, binding = 5) CLUSTER_RW buffer LightIndexCounter {
+  uint lightIndexNext;
+};
+
+layout(std430, set = LIGHTING_SET, binding = 6) readonly buffer DecalBuffer {
+  Decal decals[];
+};
+
+uint cluster_index(vec2 fragCoord, float viewDepth) {
+  uvec2 tile = min(uvec2(fragCoord / uCluster.tileSize.xy), uCluster.grid.xy - 1u);
+  float s = log(max(viewDepth, uCluster.depthSlice.x)) * uCluster.depthSlice.z + uCluster.depthSlice.w;
+  uint slice = uint(clamp(s, 0.0, float(uCluster.grid.z - 1u)));
+  return tile.x + uCluster.grid.x * (tile.y + uCluster.grid.y * slice);
+}
+
+#endif
@@ -0,0 +1,34 @@
+// Fragment-side projected decals. Include from world fragment shaders next
+// to clustered_lighting.glsl and apply before lighting; same set and
+// LIGHTING_SET as the lights.
+#ifndef CLUSTERED_DECALS_GLSL
+#define CLUSTERED_DECALS_GLSL
+
+#include "clustered_common.glsl"
+
+layout(set = LIGHTING_SET, binding = 7) uniform sampler2D uDecalAtlas;
+
+// Blends every decal binned into this fragment's cluster over `albedo`.
+// Newest decals come first in the buffer, so they are applied last.
+vec3 clustered_decals(vec3 worldPos, float viewDepth, vec3 albedo) {
+  uvec4 range = clusterRanges[cluster_index(gl_FragCoord.xy, viewDepth)];
+
+  for (uint i = range.w; i > 0u; --i) {
+    Decal D = decals[lightIndices[range.z + i - 1u]];
+
+    vec3 p = (D.worldToDecal * vec4(worldPos, 1.0)).xyz;
+    if (any(greaterThan(abs(p), vec3(0.5)))) continue;
+
+    // Lod 0: the box projection has no useful derivatives at its edges.
+    vec2 uv = D.atlasRect.xy + (p.xy + 0.5) * D.atlasRect.zw;
+    vec4 texel = textureLod(uDecalAtlas, uv, 0.0);
+
+    // Fade out towards the front/back of the projection volume.
+    float fade = 1.0 - smoothstep(0.35, 0.5, abs(p.z));
+    float a = texel.a * D.color.a * fade;
+    albedo = mix(albedo, texel.rgb * D.color.rgb, a);
+  }
+  return albedo;
+}
+
+#endif
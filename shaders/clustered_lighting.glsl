@@ -0,0 +1,97 @@
+// Fragment-side clustered shading. Include from world/sprite fragment
+// shaders; the pipeline layout must bind ClusteredLighting's set at
+// LIGHTING_SET.
+#ifndef CLUSTERED_LIGHTING_GLSL
+#define CLUSTERED_LIGHTING_GLSL
+
+#include "features.glsl"
+#include "clustered_common.glsl"
+
+// Shadow maps of the lights that have one this frame (render/ShadowAtlas.h),
+// all in one depth atlas; Light.shadow indexes shadows[].
+layout(set = LIGHTING_SET, binding = 8) uniform sampler2DShadow uShadowAtlas;
+
+struct Shadow {
+  vec4 axisX; // spot: light space x / tan(half cone); w = light position x
+  vec4 axisY; // spot: light space y / tan(half cone); w = y
+  vec4 axisZ; // spot: light direction; w = z
+  vec4 rect;  // atlas uv of face 0, uv size of a face; point faces are 3x2
+  vec4 depth; // near, far, normal offset per unit distance, faces (1 or 6)
+};
+
+layout(std430, set = LIGHTING_SET, binding = 9) readonly buffer ShadowBuffer {
+  Shadow shadows[];
+};
+
+// 1 = lit. Mirrors how ShadowAtlas renders a face: light space (x, y, z)
+// projects to ndc (x, y) / z with z the distance along the face's axis.
+float shadow_visibility(Light L, vec3 worldPos, vec3 normal) {
+  Shadow s = shadows[L.shadow];
+  // From where the tile was rendered, which lags a moving light while
+  // the atlas catches up.
+  vec3 v = worldPos - vec3(s.axisX.w, s.axisY.w, s.axisZ.w);
+  // Normal offset of about a texel, which grows with the distance.
+  v += normal * (length(v) * s.depth.z);
+
+  vec3 p;
+  uint face = 0u;
+  if (s.depth.w > 1.5) {
+    vec3 a = abs(v);
+    if (a.x >= a.y && a.x >= a.z) {
+      face = v.x > 0.0 ? 0u : 1u;
+      p = vec3(v.z, v.y, a.x);
+    } else if (a.y >= a.z) {
+      face = v.y > 0.0 ? 2u : 3u;
+      p = vec3(v.x, v.z, a.y);
+    } else {
+      face = v.z > 0.0 ? 4u : 5u;
+      p = vec3(v.x, v.y, a.z);
+    }
+  } else {
+    p = vec3(dot(v, s.axisX.xyz), dot(v, s.axisY.xyz), dot(v, s.axisZ.xyz));
+  }
+  float zNear = s.depth.x, zFar = s.depth.y;
+  if (p.z <= zNear) return 1.0;
+
+  float ref = zFar / (zFar - zNear) - zFar * zNear / ((zFar - zNear) * p.z);
+  vec2 origin = s.rect.xy + vec2(float(face % 3u), float(face / 3u)) * s.rect.zw;
+  vec2 halfTexel = 0.5 / vec2(textureSize(uShadowAtlas, 0));
+  // Clamped inside the face so filtering never reads a neighbouring tile.
+  vec2 uv = origin + (p.xy / p.z * 0.5 + 0.5) * s.rect.zw;
+  uv = clamp(uv, origin + halfTexel, origin + s.rect.zw - halfTexel);
+  return texture(uShadowAtlas, vec3(uv, ref));
+}
+
+// Windowed inverse-square falloff: reaches exactly 0 at the radius so the
+// culling bounds are tight.
+float light_attenuation(float dist, float radius) {
+  float r = dist / radius;
+  float w = clamp(1.0 - r * r * r * r, 0.0, 1.0);
+  return (w * w) / (dist * dist + 1.0);
+}
+
+// Diffuse contribution of every light binned into this fragment's cluster.
+// worldPos/normal in world space, viewDepth = positive distance along -Z.
+vec3 clustered_lighting(vec3 worldPos, vec3 normal, float viewDepth, vec3 albedo) {
+  uvec4 range = clusterRanges[cluster_index(gl_FragCoord.xy, viewDepth)];
+
+  vec3 sum = vec3(0.0);
+  for (uint i = 0u; i < range.y; ++i) {
+    Light L = lights[lightIndices[range.x + i]];
+
+    vec3 toLight = L.position - worldPos;
+    float dist = length(toLight);
+    if (dist >= L.radius) continue;
+
+    vec3 l = toLight / max(dist, 1e-4);
+    float att = light_attenuation(dist, L.radius);
+    if (L.type == LIGHT_SPOT) {
+      att *= smoothstep(L.cosOuter, L.cosInner, dot(-l, L.direction));
+    }
+    if (kShadows && L.shadow != NO_SHADOW && att > 0.0) att *= shadow_visibility(L, worldPos, normal);
+    sum += L.color * (L.intensity * att * max(dot(normal, l), 0.0));
+  }
+  return sum * albedo;
+}
+
+#endif
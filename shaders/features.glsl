@@ -0,0 +1,16 @@
+// Feature toggles as specialization constants. Each pipeline variant is
+// created with them fixed (render/ShaderPermutations.h), so the branches of
+// a disabled feature are folded away instead of tested per fragment.
+// Names must match kShaderFeatureNames; ids only need to be unique.
+#ifndef FEATURES_GLSL
+#define FEATURES_GLSL
+
+layout(constant_id = 0) const bool kClusteredLights = true;
+layout(constant_id = 1) const bool kDecals = true;
+layout(constant_id = 2) const bool kFog = false;
+layout(constant_id = 3) const bool kBloom = false;
+layout(constant_id = 4) const bool kColorGrading = false;
+layout(constant_id = 5) const bool kSharpen = false;
+layout(constant_id = 6) const bool kShadows = false;
+
+#endif
@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) in vec2 vUv;
+layout(location = 1) in vec4 vColor;
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  // Soft round sprite; colour is premultiplied (ONE, ONE_MINUS_SRC_ALPHA).
+  float r = length(vUv);
+  if (r >= 1.0) discard;
+  outColor = vColor * (1.0 - smoothstep(0.5, 1.0, r));
+}
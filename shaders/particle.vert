@@ -0,0 +1,32 @@
+#version 450
+// Camera-facing quads for the compacted alive list; instance count comes
+// from the simulate pass via vkCmdDrawIndirect.
+#extension GL_GOOGLE_include_directive : require
+
+#include "particle_common.glsl"
+
+layout(location = 0) out vec2 vUv;
+layout(location = 1) out vec4 vColor;
+
+const vec2 kCorners[6] = vec2[](
+  vec2(-1.0, -1.0), vec2( 1.0, -1.0), vec2( 1.0,  1.0),
+  vec2(-1.0, -1.0), vec2( 1.0,  1.0), vec2(-1.0,  1.0)
+);
+
+void main() {
+  // The draw reads the list simulate just wrote.
+  uint id = aliveList[alive_base(1u - uPush.current) + uint(gl_InstanceIndex)];
+  vec4 posAge = pPosAge[id];
+  float life = pVelLife[id].w;
+  float size = pPhysics[id].x;
+
+  float t = clamp(posAge.w / life, 0.0, 1.0);
+  float fade = 1.0 - t * t;
+
+  vec2 c = kCorners[gl_VertexIndex];
+  vec3 world = posAge.xyz + (uParticles.cameraRight.xyz * c.x + uParticles.cameraUp.xyz * c.y) * size;
+  gl_Position = uParticles.viewProj * vec4(world, 1.0);
+
+  vUv = c;
+  vColor = unpackUnorm4x8(pColor[id]) * fade;
+}
@@ -0,0 +1,89 @@
+// GPU particle state shared by the particle compute passes and the particle
+// vertex shader. Layouts must match render/ParticleSystem.h/.cpp.
+#ifndef PARTICLE_COMMON_GLSL
+#define PARTICLE_COMMON_GLSL
+
+// Only compute passes write particle state; the vertex shader binds it
+// read-only (vertex stores need an extra device feature).
+#ifdef PARTICLE_COMPUTE_PASS
+#define PARTICLE_RW
+#else
+#define PARTICLE_RW readonly
+#endif
+
+struct Burst {
+  vec3 position;  uint count;
+  vec3 direction; float cosSpread;
+  vec4 color;     // premultiplied; alpha 0 = additive
+  float speedMin, speedMax, lifeMin, lifeMax;
+  float size, gravity, drag, bounce;
+  uint first, seed, pad0, pad1;
+};
+
+layout(set = 0, binding = 0) uniform ParticleParams {
+  mat4 viewProj;
+  mat4 depthViewProj;     // camera the depth buffer was rendered with (last frame)
+  mat4 depthInvViewProj;
+  vec4 cameraRight;
+  vec4 cameraUp;
+  vec4 viewport;          // size last frame rendered at, 1 / that
+  vec4 sim;               // dt, collision thickness, depth uv scale (rendered part of the depth buffer)
+  uvec4 counts;           // capacity, requested this frame, burst count, frame seed
+} uParticles;
+
+layout(std430, set = 0, binding = 1) readonly buffer BurstBuffer {
+  Burst bursts[];
+};
+
+// ---- SoA particle state, indexed by particle id ----
+layout(std430, set = 0, binding = 2) PARTICLE_RW buffer PosAge   { vec4 pPosAge[]; };   // xyz, age
+layout(std430, set = 0, binding = 3) PARTICLE_RW buffer VelLife  { vec4 pVelLife[]; };  // xyz, lifetime
+layout(std430, set = 0, binding = 4) PARTICLE_RW buffer Color    { uint pColor[]; };    // packUnorm4x8
+layout(std430, set = 0, binding = 5) PARTICLE_RW buffer Physics  { vec4 pPhysics[]; };  // size, gravity, drag, bounce
+
+// Two alive lists of `capacity` ids each, ping-ponged every frame.
+layout(std430, set = 0, binding = 6) PARTICLE_RW buffer AliveList { uint aliveList[]; };
+layout(std430, set = 0, binding = 7) PARTICLE_RW buffer DeadList  { uint deadList[]; };
+
+layout(std430, set = 0, binding = 8) PARTICLE_RW buffer Counters {
+  uint deadCount;
+  uint aliveCount;   // survivors of last frame, at the front of the current list
+  uint emitCount;    // emitted this frame, appended after them
+  uint counterPad;
+};
+
+// Indirect arguments written on the GPU: emit dispatch, simulate dispatch,
+// then a VkDrawIndirectCommand whose instanceCount simulate accumulates.
+// Plain uints: uvec3 would pad to 16 bytes and break the tight layout.
+layout(std430, set = 0, binding = 9) PARTICLE_RW buffer IndirectArgs {
+  uint emitGroupsX, emitGroupsY, emitGroupsZ;
+  uint simGroupsX, simGroupsY, simGroupsZ;
+  uint drawVertexCount;
+  uint drawInstanceCount;
+  uint drawFirstVertex;
+  uint drawFirstInstance;
+};
+
+layout(set = 0, binding = 10) uniform sampler2D uSceneDepth;
+
+layout(push_constant) uniform ParticlePush {
+  uint current;  // alive list simulated this frame; survivors go to 1 - current
+} uPush;
+
+#define PARTICLE_GROUP 64u
+
+uint alive_base(uint list) { return list * uParticles.counts.x; }
+
+// PCG-style hash; good enough for spawn jitter.
+uint hash_u32(uint v) {
+  uint state = v * 747796405u + 2891336453u;
+  uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+float rand01(inout uint s) {
+  s = hash_u32(s);
+  return float(s >> 8u) * (1.0 / 16777216.0);
+}
+
+#endif
@@ -0,0 +1,9 @@
+#version 450
+// One triangle covering the screen; uv 0..1 over the viewport.
+
+layout(location = 0) out vec2 vUv;
+
+void main() {
+  vUv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+  gl_Position = vec4(vUv * 2.0 - 1.0, 0.0, 1.0);
+}
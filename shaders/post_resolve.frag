@@ -0,0 +1,75 @@
+#version 450
+// The whole post stack after bloom, in one pass from the HDR target to the
+// swapchain: upscale (dynamic resolution), depth fog, bloom, exposure,
+// tonemap, LUT grading. Sharpening, fog, bloom and grading are feature
+// toggles (features.glsl). Layout must match render/PostProcess.cpp.
+#extension GL_GOOGLE_include_directive : require
+
+#include "features.glsl"
+
+layout(set = 0, binding = 0) uniform sampler2D uHdr;   // the scene renders to its top-left part
+layout(set = 0, binding = 1) uniform sampler2D uDepth; // same size, nearest
+layout(set = 0, binding = 2) uniform sampler2D uBloom; // half output resolution, level 0 = result
+layout(set = 0, binding = 3) uniform sampler3D uLut;   // indexed by sqrt(color)
+
+layout(push_constant) uniform PostPush {
+  vec4 fog;    // rgb, density (visibility halves every 1/density units)
+  vec4 params; // exposure, bloom intensity, near, far
+  vec4 region; // uv scale to the rendered part of uHdr/uDepth, uv clamp
+  vec4 misc;   // uHdr texel size (uv), sharpness, LUT size
+} uPush;
+
+layout(location = 0) in vec2 vUv;
+layout(location = 0) out vec4 outColor;
+
+vec3 scene(vec2 uv) {
+  return textureLod(uHdr, min(uv, uPush.region.zw), 0.0).rgb;
+}
+
+// Bilinear upscale plus contrast-adaptive sharpening: the neighbours are
+// one rendered texel away, and their weight shrinks where local contrast
+// is already high, so edges get crisper without ringing. Weights come from
+// a compressed copy (HDR is unbounded) and apply to the HDR color.
+vec3 upscale_sharpen(vec2 uv) {
+  vec2 t = uPush.misc.xy;
+  vec3 c = scene(uv);
+  vec3 n = scene(uv - vec2(0.0, t.y));
+  vec3 s = scene(uv + vec2(0.0, t.y));
+  vec3 w = scene(uv - vec2(t.x, 0.0));
+  vec3 e = scene(uv + vec2(t.x, 0.0));
+
+  vec3 cc = c / (1.0 + c), nc = n / (1.0 + n), sc = s / (1.0 + s), wc = w / (1.0 + w), ec = e / (1.0 + e);
+  vec3 mn = min(cc, min(min(nc, sc), min(wc, ec)));
+  vec3 mx = max(cc, max(max(nc, sc), max(wc, ec)));
+  vec3 amp = sqrt(clamp(min(mn, 1.0 - mx) / max(mx, vec3(1e-4)), 0.0, 1.0));
+  vec3 k = amp * (-1.0 / mix(8.0, 5.0, uPush.misc.z)); // in [-1/5, 0]
+  return max((c + (n + s + w + e) * k) / (1.0 + 4.0 * k), vec3(0.0));
+}
+
+// Narkowicz's fit of the ACES filmic curve.
+vec3 tonemap(vec3 x) {
+  return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main() {
+  vec2 uv = vUv * uPush.region.xy;
+  vec3 c = kSharpen ? upscale_sharpen(uv) : scene(uv);
+
+  if (kFog) {
+    // [0, 1] depth back to view distance (render/RenderMath.h perspective).
+    float near = uPush.params.z, far = uPush.params.w;
+    float d = textureLod(uDepth, min(uv, uPush.region.zw), 0.0).r;
+    float viewDepth = near * far / (far - d * (far - near));
+    c = mix(uPush.fog.rgb, c, exp2(-uPush.fog.w * viewDepth));
+  }
+  if (kBloom) c += textureLod(uBloom, vUv, 0.0).rgb * uPush.params.y;
+
+  c = tonemap(c * uPush.params.x);
+
+  if (kColorGrading) {
+    float n = uPush.misc.w;
+    c = textureLod(uLut, sqrt(c) * ((n - 1.0) / n) + 0.5 / n, 0.0).rgb;
+  }
+  // The swapchain is sRGB: stores linear.
+  outColor = vec4(c, 1.0);
+}
@@ -0,0 +1,26 @@
+#version 450
+// Dynamic shadow casters: one box per instance, drawn over the static depth
+// copied into the light's tile. 36 vertices, no vertex buffer.
+#extension GL_GOOGLE_include_directive : require
+
+#include "shadow_common.glsl"
+
+layout(location = 0) in vec4 inCenter; // xyz, -
+layout(location = 1) in vec4 inExtent; // half size xyz, -
+
+// Corner bits: x = 1, y = 2, z = 4. Winding does not matter, the shadow
+// pipelines draw both faces.
+const uint kCubeIndices[36] = uint[](
+  0u, 2u, 6u,  0u, 6u, 4u,  // -x
+  1u, 5u, 7u,  1u, 7u, 3u,  // +x
+  0u, 4u, 5u,  0u, 5u, 1u,  // -y
+  2u, 3u, 7u,  2u, 7u, 6u,  // +y
+  0u, 1u, 3u,  0u, 3u, 2u,  // -z
+  4u, 6u, 7u,  4u, 7u, 5u   // +z
+);
+
+void main() {
+  uint c = kCubeIndices[gl_VertexIndex];
+  vec3 corner = vec3(float(c & 1u), float((c >> 1u) & 1u), float((c >> 2u) & 1u)) * 2.0 - 1.0;
+  gl_Position = uShadow.lightClip * vec4(inCenter.xyz + corner * inExtent.xyz, 1.0);
+}
@@ -0,0 +1,13 @@
+// Shadow map rendering, shared by shadow_depth.vert and shadow_caster.vert.
+// Must match the push constants in render/ShadowAtlas.cpp.
+#ifndef SHADOW_COMMON_GLSL
+#define SHADOW_COMMON_GLSL
+
+// One cube face or spot frustum of a light: world -> its clip space, laid
+// out so that shadow_visibility() (clustered_lighting.glsl) finds the same
+// texel without the matrix.
+layout(push_constant) uniform ShadowPush {
+  mat4 lightClip;
+} uShadow;
+
+#endif
@@ -0,0 +1,12 @@
+#version 450
+// Static world depth into a light's cached shadow tile. Position only, from
+// either world vertex format (it is the first attribute of both).
+#extension GL_GOOGLE_include_directive : require
+
+#include "shadow_common.glsl"
+
+layout(location = 0) in vec3 inPosition;
+
+void main() {
+  gl_Position = uShadow.lightClip * vec4(inPosition, 1.0);
+}
@@ -0,0 +1,30 @@
+#version 450
+// Static world surfaces: material albedo times vertex tint, projected
+// decals, clustered lights, ambient and emissive. Decals, lights and their
+// shadow maps are feature toggles (features.glsl); fog is applied in post
+// (post_resolve.frag).
+#extension GL_GOOGLE_include_directive : require
+
+#define LIGHTING_SET 1
+#include "features.glsl"
+#include "world_common.glsl"
+#include "clustered_lighting.glsl"
+#include "clustered_decals.glsl"
+
+layout(location = 0) in vec3 vWorldPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec4 vColor;
+layout(location = 3) in float vViewDepth;
+layout(location = 4) flat in uint vMaterial;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  Material m = materials[vMaterial];
+  vec3 albedo = m.albedo.rgb * vColor.rgb;
+  if (kDecals) albedo = clustered_decals(vWorldPos, vViewDepth, albedo);
+
+  vec3 color = albedo * uWorld.ambient.rgb + m.emissive.rgb;
+  if (kClusteredLights) color += clustered_lighting(vWorldPos, normalize(vNormal), vViewDepth, albedo);
+  outColor = vec4(color, 1.0);
+}
@@ -0,0 +1,5 @@
+#version 450
+// Static world, WorldVertex format (position, normal, uv).
+#extension GL_GOOGLE_include_directive : require
+
+#include "world_vertex.glsl"
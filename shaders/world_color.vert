@@ -0,0 +1,6 @@
+#version 450
+// Static world, WorldVertexColored format (WorldVertex + RGBA8 tint).
+#extension GL_GOOGLE_include_directive : require
+
+#define WORLD_VERTEX_COLOR
+#include "world_vertex.glsl"
@@ -0,0 +1,84 @@
+// Static world data shared by world_cull.comp and the world shaders.
+// Layouts must match render/WorldGeometry.h and render/StaticWorld.h/.cpp.
+#ifndef WORLD_COMMON_GLSL
+#define WORLD_COMMON_GLSL
+
+// Only the culling pass writes the draw list; everyone else binds it
+// read-only (vertex/fragment stores need an extra device feature).
+#ifdef WORLD_CULL_PASS
+#define WORLD_RW
+#else
+#define WORLD_RW readonly
+#endif
+
+#define WORLD_CULL_GROUP 64u
+
+#define WORLD_FORMAT_COUNT 2u
+
+struct Surface {
+  vec4 sphere;        // world bounding sphere
+  vec3 extent;        // AABB half size around sphere.xyz
+  uint leaf;
+  uint firstIndex;    // into the format's merged index buffer
+  uint indexCount;
+  int vertexOffset;   // into the format's merged vertex buffer
+  uint material;
+  uint format;
+  uint pad0, pad1, pad2;
+};
+
+struct Material {
+  vec4 albedo;
+  vec4 emissive;
+};
+
+// VkDrawIndexedIndirectCommand; firstInstance carries the surface index.
+struct DrawCommand {
+  uint indexCount;
+  uint instanceCount;
+  uint firstIndex;
+  int vertexOffset;
+  uint firstInstance;
+};
+
+layout(set = 0, binding = 0) uniform WorldParams {
+  mat4 viewProj;
+  mat4 view;
+  vec4 planes[6];   // frustum, xyz = inward normal, w = distance
+  vec4 ambient;
+  uvec4 counts;     // surface count, compact draw list, -, -
+  uvec4 drawBase;   // first draw slot per vertex format
+  vec4 hiz;         // pyramid width, height, levels, enabled
+} uWorld;
+
+layout(std430, set = 0, binding = 1) readonly buffer SurfaceBuffer {
+  Surface surfaces[];
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer MaterialBuffer {
+  Material materials[];
+};
+
+// One bit per leaf, set = potentially visible this frame.
+layout(std430, set = 0, binding = 3) readonly buffer LeafBits {
+  uint leafBits[];
+};
+
+// Two draw lists back to back, [surface count) each: early, late phase.
+layout(std430, set = 0, binding = 4) WORLD_RW buffer DrawList {
+  DrawCommand draws[];
+};
+
+// Draw count per vertex format and phase, consumed by
+// vkCmdDrawIndexedIndirectCount.
+layout(std430, set = 0, binding = 5) WORLD_RW buffer DrawCounts {
+  uint drawCounts[];
+};
+
+// One uint per surface: drawn last frame (survived the occlusion test).
+// Shared by all frames in flight; only the late cull writes it.
+layout(std430, set = 0, binding = 6) WORLD_RW buffer SurfaceVisibility {
+  uint surfaceVisible[];
+};
+
+#endif
@@ -0,0 +1,32 @@
+// Vertex stage of the static world, shared by world.vert and
+// world_color.vert (WORLD_VERTEX_COLOR). Attributes must match
+// render/WorldGeometry.h and the vertex input state in StaticWorld.cpp.
+#include "world_common.glsl"
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+#ifdef WORLD_VERTEX_COLOR
+layout(location = 2) in vec4 inColor;
+#endif
+
+layout(location = 0) out vec3 vWorldPos;
+layout(location = 1) out vec3 vNormal;
+layout(location = 2) out vec4 vColor;
+layout(location = 3) out float vViewDepth;
+layout(location = 4) flat out uint vMaterial;
+
+void main() {
+  // The culling pass put the surface index in firstInstance.
+  Surface s = surfaces[uint(gl_InstanceIndex)];
+
+  vWorldPos = inPosition;
+  vNormal = inNormal;
+#ifdef WORLD_VERTEX_COLOR
+  vColor = inColor;
+#else
+  vColor = vec4(1.0);
+#endif
+  vViewDepth = -(uWorld.view * vec4(inPosition, 1.0)).z;
+  vMaterial = s.material;
+  gl_Position = uWorld.viewProj * vec4(inPosition, 1.0);
+}
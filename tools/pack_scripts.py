@@ -0,0 +1,192 @@
+"""Pack game scripts plus the stdlib modules they need into scripts.pak.
+
+The archive is a plain zip with STORED (uncompressed) entries so the engine
+can serve module bytecode straight out of one in-memory blob. Every entry is
+an unchecked-hash .pyc, so nothing is stat'ed or validated at import time.
+
+Layout mirrors package structure, e.g. "game.pyc", "encodings/__init__.pyc".
+The zip comment records the Python version the bytecode was compiled for;
+the engine refuses a pak built for a different interpreter.
+
+Usage: python tools/pack_scripts.py --scripts python --out build/scripts.pak
+"""
+
+import argparse
+import ast
+import importlib.util
+import os
+import py_compile
+import subprocess
+import sys
+import sysconfig
+import tempfile
+import zipfile
+
+# Needed by the interpreter itself during Py_Initialize, before any
+# meta-path hook is installed (resolved through zipimport on sys.path).
+# Other codecs still load from the fallback stdlib path if ever requested.
+BOOTSTRAP_MODULES = [
+    "encodings", "encodings.aliases", "encodings.utf_8", "encodings.utf_8_sig",
+    "encodings.latin_1", "encodings.ascii", "encodings.cp1252", "encodings.mbcs",
+    "encodings.cp437", "encodings.utf_16", "encodings.utf_16_le",
+]
+
+# Provided by the host executable, never packed.
+BUILTIN_ENGINE_MODULES = {"engine", "_bundle"}
+
+
+def stdlib_dir():
+    return os.path.normcase(os.path.realpath(sysconfig.get_paths()["stdlib"]))
+
+
+def is_stdlib_source(path):
+    if not path or not path.endswith(".py"):
+        return False
+    real = os.path.normcase(os.path.realpath(path))
+    lib = stdlib_dir()
+    if not real.startswith(lib + os.sep):
+        return False
+    rel = real[len(lib) + 1:]
+    return not rel.startswith("site-packages") and not rel.startswith("dist-packages")
+
+
+def arcname_for(modname, is_package):
+    parts = modname.split(".")
+    if is_package:
+        return "/".join(parts) + "/__init__.pyc"
+    return "/".join(parts) + ".pyc"
+
+
+def collect_game_scripts(scripts_dir):
+    """Yields (modname, source_path, is_package) for everything under scripts_dir."""
+    for root, dirs, files in os.walk(scripts_dir):
+        dirs[:] = [d for d in dirs if d != "__pycache__" and not d.startswith(".")]
+        rel = os.path.relpath(root, scripts_dir)
+        prefix = [] if rel == "." else rel.replace(os.sep, "/").split("/")
+        if prefix and "__init__.py" not in files:
+            continue  # not a package, not importable
+        for f in sorted(files):
+            if not f.endswith(".py"):
+                continue
+            if f == "__init__.py":
+                yield ".".join(prefix), os.path.join(root, f), True
+            else:
+                yield ".".join(prefix + [f[:-3]]), os.path.join(root, f), False
+
+
+# Runs in an isolated child interpreter (-I -S, like the engine): stubs the
+# native modules, imports every game module and reports what got loaded.
+TRACE_SNIPPET = r"""
+import sys, types
+class _Stub(types.ModuleType):
+    def __getattr__(self, name):
+        return lambda *a, **k: None
+for _n in %(builtins)r:
+    sys.modules[_n] = _Stub(_n)
+sys.path.insert(0, %(scripts)r)
+for _m in %(modules)r:
+    try:
+        __import__(_m)
+    except Exception as e:
+        print("[pack_scripts] warning: importing %%s failed: %%r" %% (_m, e), file=sys.stderr)
+for _m in %(extra)r:
+    __import__(_m)
+out = {}
+for name, mod in list(sys.modules.items()):
+    if isinstance(mod, _Stub) or getattr(mod, "__name__", None) != name:
+        continue  # native stubs and aliases such as os.path
+    loader = getattr(mod, "__loader__", None)
+    if getattr(loader, "__name__", type(loader).__name__) == "FrozenImporter" or name.startswith("_frozen_"):
+        continue  # already compiled into the interpreter
+    f = getattr(mod, "__file__", None)
+    if isinstance(f, str):
+        out[name] = (f, hasattr(mod, "__path__"))
+print(repr(out))
+"""
+
+
+def collect_stdlib(scripts_dir, game_modules, extra_modules):
+    """Stdlib modules the game actually loads at import time, plus bootstrap packages.
+
+    Anything imported lazily later and not listed here still resolves through
+    the loose stdlib the engine keeps as a fallback search path.
+    """
+    snippet = TRACE_SNIPPET % {
+        "builtins": sorted(BUILTIN_ENGINE_MODULES),
+        "scripts": scripts_dir,
+        "modules": game_modules,
+        "extra": extra_modules,
+    }
+    res = subprocess.run([sys.executable, "-I", "-S", "-c", snippet],
+                         check=True, capture_output=True, text=True)
+    if res.stderr:
+        sys.stderr.write(res.stderr)
+    loaded = ast.literal_eval(res.stdout.strip().splitlines()[-1])
+
+    found = {}
+    for name, (path, is_pkg) in loaded.items():
+        if is_stdlib_source(path):
+            found[name] = (path, is_pkg)
+
+    for name in BOOTSTRAP_MODULES:
+        spec = importlib.util.find_spec(name)
+        if spec and is_stdlib_source(spec.origin):  # e.g. mbcs only exists on Windows
+            found[name] = (spec.origin, spec.submodule_search_locations is not None)
+    return found
+
+
+def compile_pyc(source, display_name, tmp_dir):
+    out = os.path.join(tmp_dir, "module.pyc")
+    py_compile.compile(
+        source,
+        cfile=out,
+        dfile=display_name,
+        doraise=True,
+        optimize=1,
+        invalidation_mode=py_compile.PycInvalidationMode.UNCHECKED_HASH,
+    )
+    with open(out, "rb") as f:
+        return f.read()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--scripts", required=True, help="game script root (the repo's python/ folder)")
+    ap.add_argument("--out", required=True, help="output .pak path")
+    ap.add_argument("--extra", action="append", default=[],
+                    help="stdlib module to pack even if not imported at load time (repeatable)")
+    args = ap.parse_args()
+
+    scripts_dir = os.path.abspath(args.scripts)
+    game = list(collect_game_scripts(scripts_dir))
+    stdlib = collect_stdlib(scripts_dir, [name for name, _, _ in game if name], args.extra)
+
+    entries = {}
+    for name, src, is_pkg in game:
+        entries[arcname_for(name, is_pkg)] = (src, os.path.relpath(src, scripts_dir))
+    for name, (src, is_pkg) in stdlib.items():
+        arc = arcname_for(name, is_pkg)
+        if arc not in entries:  # game scripts shadow stdlib, same as on sys.path
+            entries[arc] = (src, "<stdlib>/" + arc[:-1])
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.out)), exist_ok=True)
+    tmp_out = args.out + ".tmp"
+    total = 0
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        with zipfile.ZipFile(tmp_out, "w", compression=zipfile.ZIP_STORED) as zf:
+            zf.comment = ("bspscripts %d.%d" % sys.version_info[:2]).encode("ascii")
+            for arc in sorted(entries):
+                src, display = entries[arc]
+                data = compile_pyc(src, display, tmp_dir)
+                info = zipfile.ZipInfo(arc, date_time=(1980, 1, 1, 0, 0, 0))  # reproducible
+                info.compress_type = zipfile.ZIP_STORED
+                zf.writestr(info, data)
+                total += len(data)
+    os.replace(tmp_out, args.out)
+
+    print("[pack_scripts] %s: %d modules (%d game, %d stdlib), %.1f KiB"
+          % (args.out, len(entries), len(game), len(entries) - len(game), total / 1024.0))
+
+
+if __name__ == "__main__":
+    main()